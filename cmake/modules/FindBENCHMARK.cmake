@@ -0,0 +1,47 @@
+#
+# This module detects if Google Benchmark is installed and determines where the
+# include files and libraries are.
+#
+# This code sets the following variables:
+#
+# BENCHMARK_LIBRARIES       = full path to the Google Benchmark library
+# BENCHMARK_INCLUDE_DIR     = include dir to be used when using the Google Benchmark library
+# BENCHMARK_FOUND           = set to true if Google Benchmark was found successfully
+#
+# BENCHMARK_LOCATION
+#   setting this enables search for Google Benchmark libraries / headers in this location
+
+
+
+
+# -----------------------------------------------------
+# BENCHMARK Libraries
+# -----------------------------------------------------
+find_library(BENCHMARK_LIBRARIES
+    NAMES benchmark
+    HINTS ${BENCHMARK_LOCATION}/lib ${BENCHMARK_LOCATION}/lib64
+          ${BENCHMARK_LOCATION}/lib32
+    DOC "The main Google Benchmark library"
+)
+
+# -----------------------------------------------------
+# BENCHMARK Include Directories
+# -----------------------------------------------------
+find_path(BENCHMARK_INCLUDE_DIR
+    NAMES benchmark/benchmark.h
+    HINTS ${BENCHMARK_LOCATION} ${BENCHMARK_LOCATION}/include
+    DOC "The Google Benchmark include directory"
+)
+
+SET(BENCHMARK_DEFINITIONS "")
+
+
+
+# -----------------------------------------------------
+# handle the QUIETLY and REQUIRED arguments and set BENCHMARK_FOUND to TRUE if
+# all listed variables are TRUE
+# -----------------------------------------------------
+include(FindPackageHandleStandardArgs)
+find_package_handle_standard_args(BENCHMARK DEFAULT_MSG BENCHMARK_LIBRARIES
+    BENCHMARK_INCLUDE_DIR)
+mark_as_advanced(BENCHMARK_INCLUDE_DIR BENCHMARK_LIBRARIES )
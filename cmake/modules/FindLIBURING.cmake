@@ -0,0 +1,54 @@
+#
+# This module detects if liburing is installed and determines where the
+# include files and libraries are.
+#
+# This code sets the following variables:
+#
+# LIBURING_LIBRARIES       = full path to the liburing libraries
+# LIBURING_INCLUDE_DIRS    = include dir to be used when using the liburing library
+# LIBURING_FOUND           = set to true if liburing was found successfully
+#
+# LIBURING_LOCATION
+#   setting this enables search for liburing libraries / headers in this location
+
+find_package (PkgConfig)
+pkg_check_modules(LIBURING_PKG liburing)
+
+if (LIBURING_PKG_FOUND)
+    set (LIBURING_LIBRARIES ${LIBURING_PKG_LIBRARIES})
+    set (LIBURING_INCLUDE_DIRS ${LIBURING_PKG_INCLUDE_DIRS})
+    if (NOT LIBURING_INCLUDE_DIRS)
+        set (LIBURING_INCLUDE_DIRS "/usr/include")
+    endif (NOT LIBURING_INCLUDE_DIRS)
+else (LIBURING_PKG_FOUND)
+
+    find_library(LIBURING_LIBRARIES
+        NAMES uring
+        HINTS ${LIBURING_LOCATION}/lib ${LIBURING_LOCATION}/lib64
+        DOC "The liburing library"
+    )
+
+    find_path(LIBURING_INCLUDE_DIRS
+        NAMES liburing.h
+        HINTS ${LIBURING_LOCATION}/include
+        DOC "The liburing include directory"
+    )
+
+endif (LIBURING_PKG_FOUND)
+
+if (LIBURING_LIBRARIES)
+    message (STATUS "liburing libraries: ${LIBURING_LIBRARIES}")
+endif (LIBURING_LIBRARIES)
+if (LIBURING_INCLUDE_DIRS)
+    message (STATUS "liburing include dir: ${LIBURING_INCLUDE_DIRS}")
+endif (LIBURING_INCLUDE_DIRS)
+
+# -----------------------------------------------------
+# handle the QUIETLY and REQUIRED arguments and set LIBURING_FOUND to TRUE if
+# all listed variables are TRUE
+# -----------------------------------------------------
+include(FindPackageHandleStandardArgs)
+find_package_handle_standard_args (LIBURING DEFAULT_MSG
+    LIBURING_LIBRARIES  LIBURING_INCLUDE_DIRS
+)
+mark_as_advanced(LIBURING_INCLUDE_DIRS LIBURING_LIBRARIES)
@@ -30,6 +30,9 @@ BuildRequires:      pugixml-devel
 BuildRequires:      libuuid-devel
 #file plugin dependencies
 BuildRequires:      zlib-devel
+%if 0%{?rhel} >= 8 || 0%{?fedora}
+BuildRequires:      liburing-devel
+%endif
 %if 0%{?rhel} == 7
 #lfc plugin dependencies
 BuildRequires:      lfc-devel
@@ -284,52 +287,63 @@ fi
 
 %files plugin-file
 %{_libdir}/%{name}-plugins/libgfal_plugin_file.so*
+%{_libdir}/%{name}-plugins/libgfal_plugin_file.manifest
+%config(noreplace) %{_sysconfdir}/%{name}.d/file_plugin.conf
 %{_pkgdocdir}/README_PLUGIN_FILE
 
 %if 0%{?rhel} == 7
 %files plugin-lfc
 %{_libdir}/%{name}-plugins/libgfal_plugin_lfc.so*
+%{_libdir}/%{name}-plugins/libgfal_plugin_lfc.manifest
 %{_pkgdocdir}/README_PLUGIN_LFC
 %config(noreplace) %{_sysconfdir}/%{name}.d/lfc_plugin.conf
 
 %files plugin-rfio
 %{_libdir}/%{name}-plugins/libgfal_plugin_rfio.so*
+%{_libdir}/%{name}-plugins/libgfal_plugin_rfio.manifest
 %{_pkgdocdir}/README_PLUGIN_RFIO
 %config(noreplace) %{_sysconfdir}/%{name}.d/rfio_plugin.conf
 %endif
 
 %files plugin-dcap
 %{_libdir}/%{name}-plugins/libgfal_plugin_dcap.so*
+%{_libdir}/%{name}-plugins/libgfal_plugin_dcap.manifest
 %{_pkgdocdir}/README_PLUGIN_DCAP
 %config(noreplace) %{_sysconfdir}/%{name}.d/dcap_plugin.conf
 
 %files plugin-srm
 %{_libdir}/%{name}-plugins/libgfal_plugin_srm.so*
+%{_libdir}/%{name}-plugins/libgfal_plugin_srm.manifest
 %{_pkgdocdir}/README_PLUGIN_SRM
 %config(noreplace) %{_sysconfdir}/%{name}.d/srm_plugin.conf
 
 %files plugin-gridftp
 %{_libdir}/%{name}-plugins/libgfal_plugin_gridftp.so*
+%{_libdir}/%{name}-plugins/libgfal_plugin_gridftp.manifest
 %{_pkgdocdir}/README_PLUGIN_GRIDFTP
 %config(noreplace) %{_sysconfdir}/%{name}.d/gsiftp_plugin.conf
 
 %files plugin-http
 %{_libdir}/%{name}-plugins/libgfal_plugin_http.so*
+%{_libdir}/%{name}-plugins/libgfal_plugin_http.manifest
 %{_pkgdocdir}/README_PLUGIN_HTTP
 %config(noreplace) %{_sysconfdir}/%{name}.d/http_plugin.conf
 
 %files plugin-xrootd
 %{_libdir}/%{name}-plugins/libgfal_plugin_xrootd.so*
+%{_libdir}/%{name}-plugins/libgfal_plugin_xrootd.manifest
 %{_pkgdocdir}/README_PLUGIN_XROOTD
 %config(noreplace) %{_sysconfdir}/%{name}.d/xrootd_plugin.conf
 
 %files plugin-sftp
 %{_libdir}/%{name}-plugins/libgfal_plugin_sftp.so*
+%{_libdir}/%{name}-plugins/libgfal_plugin_sftp.manifest
 %{_pkgdocdir}/README_PLUGIN_SFTP
 %config(noreplace) %{_sysconfdir}/%{name}.d/sftp_plugin.conf
 
 %files plugin-mock
 %{_libdir}/%{name}-plugins/libgfal_plugin_mock.so*
+%{_libdir}/%{name}-plugins/libgfal_plugin_mock.manifest
 %{_pkgdocdir}/README_PLUGIN_MOCK
 %config(noreplace) %{_sysconfdir}/%{name}.d/mock_plugin.conf
 
@@ -0,0 +1,462 @@
+/*
+ * Copyright (c) CERN 2013-2017
+ *
+ * Copyright (c) Members of the EMI Collaboration. 2010-2013
+ *  See  http://www.eu-emi.eu/partners for details on the copyright
+ *  holders.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <errno.h>
+#include <string.h>
+#include <gfal_api.h>
+#include "gfal_handle.h"
+#include "gfal_config_internal.h"
+#include "gfal_admission.h"
+
+#define GFAL_ADMISSION_GROUP "ENDPOINT"
+#define GFAL_ADMISSION_MAX_HOST 256
+#define GFAL_ADMISSION_MAX_GROUP (GFAL_ADMISSION_MAX_HOST + sizeof(GFAL_ADMISSION_GROUP) + 1)
+
+
+typedef struct {
+    guint max_concurrency;
+    guint rate;
+    guint burst;
+} gfal_admission_limits;
+
+typedef struct {
+    // of the context of the caller, when it asked
+    gfal_admission_limits limits;
+    gboolean granted;
+    gboolean canceled;
+} gfal_admission_waiter;
+
+typedef struct {
+    gfal2_context_t context;
+    // gfal_admission_waiter*, in arrival order
+    GQueue waiters;
+} gfal_admission_caller;
+
+struct gfal_admission_endpoint {
+    // host[:port], upper case, followed by the class of calls if any
+    char* key;
+    char* name;
+    guint in_flight;
+    // token bucket, with the rate and burst of the last caller with a rate
+    guint rate;
+    guint burst;
+    gdouble tokens;
+    gint64 last_refill;
+    // gfal_admission_caller* with pending waiters, served round robin
+    GQueue callers;
+};
+
+
+// Endpoints are never released, there is only a handful of them
+// They only keep the calls in flight and the bucket, the limits are those of each caller
+static GHashTable* admission_endpoints = NULL;
+static GMutex* admission_lock = NULL;
+static GCond* admission_changed = NULL;
+
+// Endpoints the current thread has been admitted to
+static __thread GSList* admission_held = NULL;
+
+
+__attribute__((constructor))
+static void gfal_admission_init()
+{
+#if  (!GLIB_CHECK_VERSION (2, 32, 0))
+    if (!g_thread_supported())
+        g_thread_init(NULL);
+#endif
+    admission_endpoints = g_hash_table_new(g_str_hash, g_str_equal);
+    admission_lock = g_mutex_new();
+    admission_changed = g_cond_new();
+}
+
+
+static gboolean gfal_admission_lookup_opt(GKeyFile* config, char groups[][GFAL_ADMISSION_MAX_GROUP], int ngroups,
+        const char* key, gint* value)
+{
+    int i;
+    for (i = 0; i < ngroups; ++i) {
+        if (g_key_file_has_key(config, groups[i], key, NULL)) {
+            *value = g_key_file_get_integer(config, groups[i], key, NULL);
+            if (*value < 0)
+                *value = 0;
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
+
+
+static gint gfal_admission_get_opt(GKeyFile* config, char groups[][GFAL_ADMISSION_MAX_GROUP], int ngroups,
+        const char* key)
+{
+    gint value = 0;
+    gfal_admission_lookup_opt(config, groups, ngroups, key, &value);
+    return value;
+}
+
+// Get the name of the endpoint of url, or of a bare host[:port], and the groups of its options
+// Returns the number of groups, 0 if url has no host
+static int gfal_admission_get_groups(const char* url, char* name, size_t name_size,
+        char groups[3][GFAL_ADMISSION_MAX_GROUP])
+{
+    char host[GFAL_ADMISSION_MAX_HOST];
+    int ngroups = 0;
+    char *p, *port;
+
+    if (url == NULL)
+        return 0;
+    if (strstr(url, "://"))
+        gfal_metrics_url_host(url, host, sizeof(host));
+    else
+        g_strlcpy(host, url, sizeof(host));
+    if (host[0] == '\0')
+        return 0;
+    for (p = host; *p; ++p)
+        *p = g_ascii_toupper(*p);
+    g_strlcpy(name, host, name_size);
+
+    g_snprintf(groups[ngroups++], GFAL_ADMISSION_MAX_GROUP, GFAL_ADMISSION_GROUP ":%s", host);
+    port = strrchr(host, ':');
+    if (port && !strchr(port, ']')) {
+        *port = '\0';
+        g_snprintf(groups[ngroups++], GFAL_ADMISSION_MAX_GROUP, GFAL_ADMISSION_GROUP ":%s", host);
+    }
+    g_strlcpy(groups[ngroups++], GFAL_ADMISSION_GROUP, GFAL_ADMISSION_MAX_GROUP);
+    return ngroups;
+}
+
+// Get the name of the endpoint of url, and its limits
+// Returns FALSE if the calls to the endpoint are not limited
+static gboolean gfal_admission_get_limits(gfal2_context_t context, const char* url,
+        char* name, size_t name_size, gfal_admission_limits* limits)
+{
+    char groups[3][GFAL_ADMISSION_MAX_GROUP];
+    int ngroups = gfal_admission_get_groups(url, name, name_size, groups);
+    if (ngroups == 0)
+        return FALSE;
+
+    limits->max_concurrency = gfal_admission_get_opt(gfal_config_get(context), groups, ngroups, "MAX_CONCURRENCY");
+    limits->rate = gfal_admission_get_opt(gfal_config_get(context), groups, ngroups, "RATE");
+    limits->burst = gfal_admission_get_opt(gfal_config_get(context), groups, ngroups, "BURST");
+    if (limits->burst == 0)
+        limits->burst = MAX(limits->rate, 1);
+
+    return limits->max_concurrency > 0 || limits->rate > 0;
+}
+
+// Get the name of the endpoint of url, and the limit of a class of calls to it
+// Returns FALSE if the class is not limited
+static gboolean gfal_admission_get_class_limits(gfal2_context_t context, const char* url, const char* klass,
+        gint default_limit, char* name, size_t name_size, gfal_admission_limits* limits)
+{
+    char groups[3][GFAL_ADMISSION_MAX_GROUP];
+    int ngroups = gfal_admission_get_groups(url, name, name_size, groups);
+    if (ngroups == 0)
+        return FALSE;
+
+    gint limit = default_limit;
+    gfal_admission_lookup_opt(gfal_config_get(context), groups, ngroups, klass, &limit);
+    limits->max_concurrency = limit > 0 ? limit : 0;
+    limits->rate = 0;
+    limits->burst = 1;
+    return limits->max_concurrency > 0;
+}
+
+
+// Must be called with the lock held
+static void gfal_admission_refill(struct gfal_admission_endpoint* ep, gint64 now)
+{
+    if (ep->rate == 0)
+        return;
+    ep->tokens += (gdouble)(now - ep->last_refill) * ep->rate / G_USEC_PER_SEC;
+    if (ep->tokens > ep->burst)
+        ep->tokens = ep->burst;
+    ep->last_refill = now;
+}
+
+// Must be called with the lock held
+static struct gfal_admission_endpoint* gfal_admission_get_endpoint(const char* name, const char* klass,
+        const gfal_admission_limits* limits, gint64 now)
+{
+    char* key = klass ? g_strconcat(name, " ", klass, NULL) : g_strdup(name);
+    struct gfal_admission_endpoint* ep = g_hash_table_lookup(admission_endpoints, key);
+    if (ep == NULL) {
+        ep = g_new0(struct gfal_admission_endpoint, 1);
+        ep->key = key;
+        ep->name = klass ? g_strdup_printf("%s (%s)", name, klass) : g_strdup(name);
+        ep->last_refill = now;
+        g_queue_init(&ep->callers);
+        g_hash_table_insert(admission_endpoints, ep->key, ep);
+    }
+    else {
+        g_free(key);
+    }
+
+    // The limits come from the configuration of each caller, as it is now
+    // The bucket is shared, so it follows the last caller with a rate
+    gfal_admission_refill(ep, now);
+    if (limits->rate > 0) {
+        if (ep->rate == 0)
+            ep->tokens = limits->burst;
+        ep->rate = limits->rate;
+        ep->burst = limits->burst;
+        if (ep->tokens > ep->burst)
+            ep->tokens = ep->burst;
+        ep->last_refill = now;
+    }
+    return ep;
+}
+
+// Must be called with the lock held
+static gboolean gfal_admission_available(const struct gfal_admission_endpoint* ep,
+        const gfal_admission_limits* limits)
+{
+    return (limits->max_concurrency == 0 || ep->in_flight < limits->max_concurrency) &&
+           (limits->rate == 0 || ep->tokens >= 1);
+}
+
+// Must be called with the lock held
+static void gfal_admission_take(struct gfal_admission_endpoint* ep, const gfal_admission_limits* limits)
+{
+    ep->in_flight++;
+    if (limits->rate > 0)
+        ep->tokens -= 1;
+}
+
+// Hand the available slots to the waiting callers, one call per caller at a time
+// Each waiter is checked against the limits of its own caller, so a stricter caller
+// does not hold back the others
+// Must be called with the lock held
+static void gfal_admission_dispatch(struct gfal_admission_endpoint* ep, gint64 now)
+{
+    gboolean granted = FALSE;
+    guint remaining = g_queue_get_length(&ep->callers);
+
+    gfal_admission_refill(ep, now);
+    while (remaining-- > 0) {
+        gfal_admission_caller* caller = g_queue_pop_head(&ep->callers);
+        gfal_admission_waiter* waiter = g_queue_peek_head(&caller->waiters);
+        if (gfal_admission_available(ep, &waiter->limits)) {
+            g_queue_pop_head(&caller->waiters);
+            waiter->granted = TRUE;
+            gfal_admission_take(ep, &waiter->limits);
+            granted = TRUE;
+        }
+
+        if (g_queue_is_empty(&caller->waiters))
+            g_free(caller);
+        else
+            g_queue_push_tail(&ep->callers, caller);
+    }
+    if (granted)
+        g_cond_broadcast(admission_changed);
+}
+
+// Must be called with the lock held
+static gfal_admission_caller* gfal_admission_find_caller(struct gfal_admission_endpoint* ep,
+        gfal2_context_t context)
+{
+    GList* item;
+    for (item = ep->callers.head; item != NULL; item = item->next) {
+        gfal_admission_caller* caller = item->data;
+        if (caller->context == context)
+            return caller;
+    }
+    return NULL;
+}
+
+// Must be called with the lock held
+static void gfal_admission_enqueue(struct gfal_admission_endpoint* ep, gfal2_context_t context,
+        gfal_admission_waiter* waiter)
+{
+    gfal_admission_caller* caller = gfal_admission_find_caller(ep, context);
+    if (caller == NULL) {
+        caller = g_new0(gfal_admission_caller, 1);
+        caller->context = context;
+        g_queue_init(&caller->waiters);
+        g_queue_push_tail(&ep->callers, caller);
+    }
+    g_queue_push_tail(&caller->waiters, waiter);
+}
+
+// Must be called with the lock held
+static void gfal_admission_dequeue(struct gfal_admission_endpoint* ep, gfal2_context_t context,
+        gfal_admission_waiter* waiter)
+{
+    gfal_admission_caller* caller = gfal_admission_find_caller(ep, context);
+    g_queue_remove(&caller->waiters, waiter);
+    if (g_queue_is_empty(&caller->waiters)) {
+        g_queue_remove(&ep->callers, caller);
+        g_free(caller);
+    }
+}
+
+// Time until the next token of the bucket, capped to one second to honor cancellation
+// Must be called with the lock held
+static gint64 gfal_admission_wait_time(const struct gfal_admission_endpoint* ep)
+{
+    if (ep->rate > 0 && ep->tokens < 1) {
+        gint64 usec = (gint64)((1 - ep->tokens) * G_USEC_PER_SEC / ep->rate) + 1;
+        if (usec < G_USEC_PER_SEC)
+            return usec;
+    }
+    return G_USEC_PER_SEC;
+}
+
+// The cancel flag of the context is only raised while gfal2_cancel runs
+static void gfal_admission_cancel(gfal2_context_t context, void* userdata)
+{
+    gfal_admission_waiter* waiter = (gfal_admission_waiter*) userdata;
+    g_mutex_lock(admission_lock);
+    waiter->canceled = TRUE;
+    g_cond_broadcast(admission_changed);
+    g_mutex_unlock(admission_lock);
+}
+
+// Must be called with the lock held
+// deadline is a monotonic time, negative to wait until cancelled
+static int gfal_admission_wait(gfal2_context_t context, struct gfal_admission_endpoint* ep,
+        gfal_admission_waiter* waiter, gint64 deadline, GError** err)
+{
+    gint64 now = g_get_monotonic_time();
+
+    gfal_admission_refill(ep, now);
+    if (g_queue_is_empty(&ep->callers) && gfal_admission_available(ep, &waiter->limits)) {
+        gfal_admission_take(ep, &waiter->limits);
+        return 0;
+    }
+
+    gfal_admission_enqueue(ep, context, waiter);
+    while (TRUE) {
+        gfal_admission_dispatch(ep, now);
+        if (waiter->granted)
+            return 0;
+        if (waiter->canceled || gfal2_is_canceled(context)) {
+            gfal_admission_dequeue(ep, context, waiter);
+            gfal2_set_error(err, gfal2_get_core_quark(), ECANCELED, __func__,
+                "Operation cancelled while waiting for a call slot to %s", ep->name);
+            return -1;
+        }
+        if (deadline >= 0 && now >= deadline) {
+            gfal_admission_dequeue(ep, context, waiter);
+            gfal2_set_error(err, gfal2_get_core_quark(), EBUSY, __func__,
+                "Timeout while waiting for a call slot to %s", ep->name);
+            return -1;
+        }
+        gint64 wait = gfal_admission_wait_time(ep);
+        if (deadline >= 0 && deadline - now < wait)
+            wait = deadline - now;
+        GTimeVal wakeup;
+        g_get_current_time(&wakeup);
+        g_time_val_add(&wakeup, wait);
+        g_cond_timed_wait(admission_changed, admission_lock, &wakeup);
+        now = g_get_monotonic_time();
+    }
+}
+
+
+static int gfal_admission_acquire(gfal2_context_t context, const char* plugin, const char* url,
+        const char* name, const char* klass, const gfal_admission_limits* limits, int timeout,
+        gfal_admission_t* slot, GError** err)
+{
+    int ret = 0;
+
+    gint64 wait_start = gfal_metrics_start();
+    gfal_admission_waiter waiter = {*limits, FALSE, FALSE};
+    gfal_cancel_token_t cancel_token = gfal2_register_cancel_callback(context, gfal_admission_cancel, &waiter);
+
+    g_mutex_lock(admission_lock);
+    gint64 now = g_get_monotonic_time();
+    struct gfal_admission_endpoint* ep = gfal_admission_get_endpoint(name, klass, limits, now);
+    // The classes of calls hold resources (sessions...) that can outlive the call and change
+    // of thread, so only the calls dispatched by gfal2 are re-entrant
+    if (klass != NULL || g_slist_find(admission_held, ep) == NULL) {
+        gint64 deadline = timeout < 0 ? -1 : now + (gint64)timeout * G_USEC_PER_SEC;
+        ret = gfal_admission_wait(context, ep, &waiter, deadline, err);
+        if (ret == 0) {
+            if (klass == NULL)
+                admission_held = g_slist_prepend(admission_held, ep);
+            *slot = ep;
+        }
+    }
+    g_mutex_unlock(admission_lock);
+
+    gfal2_remove_cancel_callback(context, cancel_token);
+
+    if (wait_start && *slot)
+        gfal_metrics_record(plugin, "queue_wait", url, wait_start, FALSE);
+    else if (wait_start && ret < 0)
+        gfal_metrics_record(plugin, "queue_wait", url, wait_start, TRUE);
+    return ret;
+}
+
+
+int gfal_admission_enter(gfal2_context_t context, const char* plugin, const char* url,
+        gfal_admission_t* slot, GError** err)
+{
+    char name[GFAL_ADMISSION_MAX_HOST];
+    gfal_admission_limits limits;
+
+    *slot = NULL;
+    if (context == NULL || !gfal_admission_get_limits(context, url, name, sizeof(name), &limits))
+        return 0;
+    return gfal_admission_acquire(context, plugin, url, name, NULL, &limits, -1, slot, err);
+}
+
+
+int gfal2_endpoint_slot_acquire(gfal2_context_t context, const char* plugin, const char* url,
+        const char* klass, int limit, int timeout, gfal2_endpoint_slot_t* slot, GError** err)
+{
+    g_return_val_err_if_fail(context && plugin && klass && slot, -1, err,
+        "[gfal2_endpoint_slot_acquire] invalid parameters");
+    char name[GFAL_ADMISSION_MAX_HOST];
+    gfal_admission_limits limits;
+
+    *slot = NULL;
+    if (!gfal_admission_get_class_limits(context, url, klass, limit, name, sizeof(name), &limits))
+        return 0;
+    return gfal_admission_acquire(context, plugin, url, name, klass, &limits, timeout, slot, err);
+}
+
+
+void gfal2_endpoint_slot_release(gfal2_endpoint_slot_t slot)
+{
+    gfal_admission_exit(slot);
+}
+
+
+void gfal_admission_exit(gfal_admission_t slot)
+{
+    if (slot == NULL)
+        return;
+
+    g_mutex_lock(admission_lock);
+    admission_held = g_slist_remove(admission_held, slot);
+    slot->in_flight--;
+    gfal_admission_dispatch(slot, g_get_monotonic_time());
+    g_mutex_unlock(admission_lock);
+}
+
+
+void gfal_admission_detach(gfal_admission_t slot)
+{
+    // Only the current thread uses its list
+    admission_held = g_slist_remove(admission_held, slot);
+}
@@ -0,0 +1,89 @@
+/*
+ * Copyright (c) CERN 2013-2017
+ *
+ * Copyright (c) Members of the EMI Collaboration. 2010-2013
+ *  See  http://www.eu-emi.eu/partners for details on the copyright
+ *  holders.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+#ifndef GFAL_ADMISSION_H_
+#define GFAL_ADMISSION_H_
+
+#include <glib.h>
+#include "gfal_common.h"
+#include "gfal_plugin_interface.h"
+#include "gfal_metrics_internal.h"
+
+// Admission of the calls dispatched to the plugins, for the whole process
+//
+// The calls to a remote endpoint (host[:port]) can be limited in concurrency and in rate
+// (token bucket), with the options MAX_CONCURRENCY, RATE and BURST. They are looked up in the
+// groups ENDPOINT:HOST:PORT, ENDPOINT:HOST and ENDPOINT, in this order, upper case.
+// Calls waiting for an endpoint are served round robin between callers (contexts),
+// and in order for the same caller. The time spent waiting is recorded in the metrics
+// as the "queue_wait" operation.
+//
+// A thread already admitted to an endpoint is not queued again for it,
+// so the plugins can call back into gfal2 while they hold a slot.
+// Copies are not admitted as a whole, since the plugins may run part of them in other
+// threads: only the calls they make through gfal2 (stat, mkdir, checksum...) are.
+// The same applies to the files open: only opening them is admitted, not their reads and writes.
+//
+// The limits are read from the configuration of the calling context on each call, so each
+// context is held to its own limits, counting the calls in flight of the whole process.
+// The plugins and the poll scheduler limit their own classes of calls (sessions, polls...)
+// with gfal2_endpoint_slot_acquire, which shares the queues and the options of the admission.
+
+typedef gfal2_endpoint_slot_t gfal_admission_t;
+
+// Wait for a slot to the endpoint of url. plugin is only used for the metrics
+// slot is set to NULL if there is nothing to release
+// Returns 0 on success, -1 if the wait has been cancelled
+int gfal_admission_enter(gfal2_context_t context, const char* plugin, const char* url,
+        gfal_admission_t* slot, GError** err);
+
+// Release a slot
+void gfal_admission_exit(gfal_admission_t slot);
+
+// For calls that complete in another thread: the slot is no longer held by the current one,
+// which is queued again if it calls the same endpoint before the slot is released
+void gfal_admission_detach(gfal_admission_t slot);
+
+// Time and record the plugin call, as GFAL_METRICS_CALL, once admitted to the endpoint of url
+// If the admission fails, call is not run and err is set
+#define GFAL_ADMITTED_CALL(context, err, plugin, operation, url, call, error, arg) \
+    do { \
+        gfal_admission_t admission_slot; \
+        if (gfal_admission_enter((context), (plugin)->getName(), (url), &admission_slot, (err)) == 0) { \
+            GFAL_METRICS_CALL(plugin, operation, url, call, error, arg); \
+            gfal_admission_exit(admission_slot); \
+        } \
+    } while (0)
+
+// Same as GFAL_ADMITTED_CALL, for bulk calls. If the admission fails, the error is set for every file
+#define GFAL_ADMITTED_LIST_CALL(context, nbfiles, errors, plugin, operation, url, call, error, arg) \
+    do { \
+        GError* admission_err = NULL; \
+        GFAL_ADMITTED_CALL(context, &admission_err, plugin, operation, url, call, error, arg); \
+        if (admission_err) { \
+            int admission_i; \
+            for (admission_i = 0; admission_i < (nbfiles); ++admission_i) \
+                (errors)[admission_i] = g_error_copy(admission_err); \
+            g_error_free(admission_err); \
+        } \
+    } while (0)
+
+#endif /* GFAL_ADMISSION_H_ */
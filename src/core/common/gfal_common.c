@@ -25,7 +25,10 @@
 #include <string.h>
 #include <common/gfal_plugin.h>
 #include <gfal_api.h>
+#include <file/gfal_async_internal.h>
+#include <network/gfal2_network.h>
 #include "gfal_file_handler_container.h"
+#include "gfal_md_cache.h"
 
 // initialization
 __attribute__((constructor))
@@ -135,30 +138,100 @@ gfal2_context_t gfal2_context_new(GError **err)
         return NULL;
     }
     context->initiated = TRUE;
-    context->config = gfal2_init_config(&tmp_err);
-    if (!context->config) {
+    GKeyFile *config = gfal2_init_config(&tmp_err);
+    if (!config) {
         gfal2_propagate_prefixed_error(err, tmp_err, __func__);
         g_free(context);
         return NULL;
     }
+    gfal_config_own(context, config);
     gfal_initCredentialLocation(context);
+    if (gfal2_get_opt_boolean_with_default(context, "CORE", "LOG_ASYNC", FALSE)) {
+        gfal2_log_set_async(TRUE);
+    }
+    if (!gfal2_trace_is_enabled()) {
+        gchar *trace_file = gfal2_get_opt_string_with_default(context, "CORE", "TRACE_FILE", NULL);
+        if (trace_file && trace_file[0]) {
+            GError *trace_err = NULL;
+            if (gfal2_trace_start(trace_file, &trace_err) < 0) {
+                gfal2_log(G_LOG_LEVEL_WARNING, "%s", trace_err->message);
+                g_error_free(trace_err);
+            }
+        }
+        g_free(trace_file);
+    }
+    // The DNS cache is process-wide: configured by the first context only
+    static gsize dns_configured = 0;
+    if (g_once_init_enter(&dns_configured)) {
+        gfal2_dns_cache_set_ttl(
+            gfal2_get_opt_integer_with_default(context, "CORE", "DNS_CACHE_TTL", 60),
+            gfal2_get_opt_integer_with_default(context, "CORE", "DNS_NEGATIVE_TTL", 10));
+        g_once_init_leave(&dns_configured, 1);
+    }
     context->plugin_opt.plugin_number = 0;
+    g_static_rec_mutex_init(&context->plugin_opt.mux_load);
     int ret = gfal_plugins_instance(context, &tmp_err);
     if (ret <= 0 && tmp_err) {
         gfal2_propagate_prefixed_error(err, tmp_err, __func__);
-        g_key_file_free(context->config);
+        g_static_rec_mutex_free(&context->plugin_opt.mux_load);
+        gfal_config_release(context);
         g_free(context);
         return NULL;
     }
     context->client_info = g_ptr_array_new();
     context->mux_cancel = g_mutex_new();
     g_hook_list_init(&context->cancel_hooks, sizeof(GHook));
+    gfal2_async_init(context);
     context->fdescs = gfal_file_descriptor_handle_create(NULL);
+    context->md_cache = gfal_md_cache_new();
 
     G_RETURN_ERR(context, tmp_err, err);
 }
 
 
+gfal2_context_t gfal2_context_clone(gfal2_context_t base, GError **err)
+{
+    GError *tmp_err = NULL;
+    if (base == NULL) {
+        gfal2_set_error(err, gfal2_get_core_quark(), EFAULT, __func__, "Invalid context to clone");
+        return NULL;
+    }
+
+    gfal2_context_t context = g_new0(struct gfal_handle_, 1);
+    context->initiated = TRUE;
+    gfal_config_share(context, base);
+    g_static_rec_mutex_init(&context->plugin_opt.mux_load);
+    if (gfal_plugins_clone(context, base, &tmp_err) < 0) {
+        gfal2_propagate_prefixed_error(err, tmp_err, __func__);
+        gfal_plugins_delete(context, NULL);
+        g_list_free(context->plugin_opt.sorted_plugin);
+        g_static_rec_mutex_free(&context->plugin_opt.mux_load);
+        gfal_config_release(context);
+        g_free(context);
+        return NULL;
+    }
+
+    context->agent_name = g_strdup(base->agent_name);
+    context->agent_version = g_strdup(base->agent_version);
+    context->client_info = g_ptr_array_new();
+    int i;
+    for (i = 0; i < gfal2_get_client_info_count(base, NULL); ++i) {
+        const char *key, *value;
+        gfal2_get_client_info_pair(base, i, &key, &value, NULL);
+        gfal2_add_client_info(context, key, value, NULL);
+    }
+    gfal2_cred_copy(context, base, NULL);
+
+    context->mux_cancel = g_mutex_new();
+    g_hook_list_init(&context->cancel_hooks, sizeof(GHook));
+    gfal2_async_init(context);
+    context->fdescs = gfal_file_descriptor_handle_create(NULL);
+    context->md_cache = gfal_md_cache_new();
+
+    return context;
+}
+
+
 void gfal2_context_free(gfal2_context_t context)
 {
     if (context == NULL) {
@@ -166,10 +239,13 @@ void gfal2_context_free(gfal2_context_t context)
         return;
     }
 
+    gfal2_async_release(context);
     gfal_plugins_delete(context, NULL);
     gfal_file_descriptor_handle_destroy(context->fdescs);
-    g_key_file_free(context->config);
+    gfal_md_cache_free(context->md_cache);
+    gfal_config_release(context);
     g_list_free(context->plugin_opt.sorted_plugin);
+    g_static_rec_mutex_free(&context->plugin_opt.mux_load);
     g_mutex_free(context->mux_cancel);
     g_hook_list_clear(&context->cancel_hooks);
     g_free(context->agent_name);
@@ -183,6 +259,7 @@ void gfal2_context_free(gfal2_context_t context)
 
 gchar **gfal2_get_plugin_names(gfal2_context_t context)
 {
+    gfal_plugins_load_all(context, NULL);
     gchar **array = g_new0(gchar*, context->plugin_opt.plugin_number + 1);
     int i;
 
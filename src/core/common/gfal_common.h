@@ -53,6 +53,24 @@ typedef struct gfal_handle_* gfal2_context_t;
  */
 gfal2_context_t gfal2_context_new(GError ** err);
 
+/**
+ * @brief Create a gfal2 context from an existing one
+ *
+ * Much cheaper than \ref gfal2_context_new: the configuration files are not parsed,
+ * the credentials are not looked up, and the plugin directory is not scanned again.
+ * The clone starts with the configuration, credentials, user agent and client information of base.
+ * The configuration is shared until either context changes it.
+ * Plugins loaded in base from their manifest are only initialized in the clone on first use.
+ * Plugins registered with \ref gfal2_register_plugin are not inherited.
+ *
+ * The clone has its own cancellation scope and file descriptors, and can outlive base.
+ *
+ * @param base : context to clone
+ * @param err : GError error report system
+ * @return a context if success, NULL if error
+ */
+gfal2_context_t gfal2_context_clone(gfal2_context_t base, GError ** err);
+
 /**
  *  Free a gfal2 context
  *  It is safe to delete a NULL context
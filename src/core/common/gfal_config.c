@@ -19,6 +19,7 @@
  */
 
 #include "gfal_handle.h"
+#include "gfal_config_internal.h"
 #include <gfal_api.h>
 #include <string.h>
 
@@ -170,11 +171,113 @@ GKeyFile* gfal2_init_config(GError **err)
 }
 
 
+// The configuration of a context can be shared with its clones (see gfal2_context_clone)
+// A shared configuration is never modified: the first change of any of them is done on a private copy
+struct _gfal_shared_config {
+    GKeyFile *config;
+    // Protected by lock
+    gint refcount;
+    GMutex *lock;
+};
+
+
+static gfal_shared_config *gfal_config_share_new(GKeyFile *config)
+{
+    gfal_shared_config *share = g_new(gfal_shared_config, 1);
+    share->config = config;
+    share->refcount = 1;
+    share->lock = g_mutex_new();
+    return share;
+}
+
+
+GKeyFile *gfal_config_get(gfal2_context_t context)
+{
+    return context->config_share->config;
+}
+
+
+void gfal_config_own(gfal2_context_t context, GKeyFile *config)
+{
+    context->mux_config = g_mutex_new();
+    context->config_share = gfal_config_share_new(config);
+}
+
+
+void gfal_config_share(gfal2_context_t dest, gfal2_context_t src)
+{
+    // src can not switch to a private copy meanwhile, so its share stays referenced
+    g_mutex_lock(src->mux_config);
+    gfal_shared_config *share = src->config_share;
+    g_mutex_lock(share->lock);
+    share->refcount += 1;
+    g_mutex_unlock(share->lock);
+    g_mutex_unlock(src->mux_config);
+
+    dest->mux_config = g_mutex_new();
+    dest->config_share = share;
+}
+
+
+void gfal_config_release(gfal2_context_t context)
+{
+    gfal_shared_config *share = context->config_share;
+    if (share == NULL) {
+        return;
+    }
+
+    g_mutex_lock(share->lock);
+    gboolean last = (--share->refcount == 0);
+    g_mutex_unlock(share->lock);
+
+    if (last) {
+        g_key_file_free(share->config);
+        g_mutex_free(share->lock);
+        g_free(share);
+    }
+    g_mutex_free(context->mux_config);
+    context->mux_config = NULL;
+    context->config_share = NULL;
+}
+
+
+// Return the configuration of the context, ready to be changed, with the lock of the context held
+// If it is shared, the context gets its own copy first
+static GKeyFile *gfal_config_lock_writable(gfal2_context_t context)
+{
+    g_mutex_lock(context->mux_config);
+
+    // Only this context could share its private configuration, and it is locked
+    gfal_shared_config *share = context->config_share;
+    g_mutex_lock(share->lock);
+    if (share->refcount > 1) {
+        gsize length = 0;
+        gchar *data = g_key_file_to_data(share->config, &length, NULL);
+        GKeyFile *copy = g_key_file_new();
+        g_key_file_load_from_data(copy, data, length, G_KEY_FILE_KEEP_COMMENTS, NULL);
+        g_free(data);
+
+        share->refcount -= 1;
+        context->config_share = gfal_config_share_new(copy);
+    }
+    g_mutex_unlock(share->lock);
+    return context->config_share->config;
+}
+
+
+// Publish the change, so values derived from the configuration are refreshed, and release the lock
+static void gfal_config_unlock(gfal2_context_t context)
+{
+    g_atomic_int_inc(&context->config_version);
+    g_mutex_unlock(context->mux_config);
+}
+
+
 gchar *gfal2_get_opt_string(gfal2_context_t context, const gchar *group_name,
     const gchar *key, GError **error)
 {
     g_assert(context != NULL);
-    return g_key_file_get_string(context->config, group_name, key, error);
+    return g_key_file_get_string(gfal_config_get(context), group_name, key, error);
 }
 
 
@@ -200,7 +303,8 @@ gint gfal2_set_opt_string(gfal2_context_t context, const gchar *group_name,
     const gchar *key, const gchar *value, GError **error)
 {
     g_assert(context != NULL);
-    g_key_file_set_string(context->config, group_name, key, value);
+    g_key_file_set_string(gfal_config_lock_writable(context), group_name, key, value);
+    gfal_config_unlock(context);
     return 0;
 }
 
@@ -209,7 +313,7 @@ gint gfal2_get_opt_integer(gfal2_context_t context, const gchar *group_name,
     const gchar *key, GError **error)
 {
     g_assert(context != NULL);
-    return g_key_file_get_integer(context->config, group_name, key, error);
+    return g_key_file_get_integer(gfal_config_get(context), group_name, key, error);
 }
 
 
@@ -234,7 +338,8 @@ gint gfal2_set_opt_integer(gfal2_context_t context, const gchar *group_name,
     const gchar *key, gint value, GError **error)
 {
     g_assert(context != NULL);
-    g_key_file_set_integer(context->config, group_name, key, value);
+    g_key_file_set_integer(gfal_config_lock_writable(context), group_name, key, value);
+    gfal_config_unlock(context);
     return 0;
 }
 
@@ -243,7 +348,7 @@ gboolean gfal2_get_opt_boolean(gfal2_context_t context, const gchar *group_name,
     const gchar *key, GError **error)
 {
     g_assert(context != NULL);
-    return g_key_file_get_boolean(context->config, group_name, key, error);
+    return g_key_file_get_boolean(gfal_config_get(context), group_name, key, error);
 }
 
 
@@ -269,7 +374,8 @@ gint gfal2_set_opt_boolean(gfal2_context_t context, const gchar *group_name,
     const gchar *key, gboolean value, GError **error)
 {
     g_assert(context != NULL);
-    g_key_file_set_boolean(context->config, group_name, key, value);
+    g_key_file_set_boolean(gfal_config_lock_writable(context), group_name, key, value);
+    gfal_config_unlock(context);
     return 0;
 }
 
@@ -279,7 +385,7 @@ gchar **gfal2_get_opt_string_list(gfal2_context_t context,
     GError **error)
 {
     g_assert(context != NULL);
-    return g_key_file_get_string_list(context->config, group_name, key, length, error);
+    return g_key_file_get_string_list(gfal_config_get(context), group_name, key, length, error);
 }
 
 
@@ -288,7 +394,8 @@ gint gfal2_set_opt_string_list(gfal2_context_t context, const gchar *group_name,
     GError **error)
 {
     g_assert(context != NULL);
-    g_key_file_set_string_list(context->config, group_name, key, list, length);
+    g_key_file_set_string_list(gfal_config_lock_writable(context), group_name, key, list, length);
+    gfal_config_unlock(context);
     return 0;
 }
 
@@ -319,20 +426,24 @@ gchar **gfal2_get_opt_string_list_with_default(gfal2_context_t context,
 gint gfal2_load_opts_from_file(gfal2_context_t context, const char *path,
     GError **error)
 {
-    return gfal_load_configuration_to_conf_manager(context->config, path, error);
+    gint res = gfal_load_configuration_to_conf_manager(gfal_config_lock_writable(context), path, error);
+    gfal_config_unlock(context);
+    return res;
 }
 
 
 gchar **gfal2_get_opt_keys(gfal2_context_t context, const gchar *group_name, gsize *length, GError **error)
 {
-    return g_key_file_get_keys(context->config, group_name, length, error);
+    return g_key_file_get_keys(gfal_config_get(context), group_name, length, error);
 }
 
 
 gboolean gfal2_remove_opt(gfal2_context_t context, const gchar *group_name,
     const gchar *key, GError **error)
 {
-    return g_key_file_remove_key(context->config, group_name, key, error);
+    gboolean res = g_key_file_remove_key(gfal_config_lock_writable(context), group_name, key, error);
+    gfal_config_unlock(context);
+    return res;
 }
 
 
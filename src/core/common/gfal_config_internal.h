@@ -23,10 +23,23 @@
 #define GFAL_CONFIG_INTERNAL_H_
 
 #include <glib.h>
+#include "gfal_handle.h"
 
 // create or delete configuration manager for gfal2, internal
 GKeyFile* gfal2_init_config(GError **err);
 
 void gfal_free_keyvalue(gpointer data, gpointer user_data);
 
+// give the ownership of config to the context
+void gfal_config_own(gfal2_context_t context, GKeyFile *config);
+
+// return the configuration of the context, for reading
+GKeyFile *gfal_config_get(gfal2_context_t context);
+
+// share the configuration of src with dest, until one of them changes it
+void gfal_config_share(gfal2_context_t dest, gfal2_context_t src);
+
+// release the configuration of the context
+void gfal_config_release(gfal2_context_t context);
+
 #endif /* GFAL_CONFIG_INTERNAL_H_ */
@@ -52,6 +52,10 @@ extern "C"
 #define GFAL_PLUGIN_DIR_SUFFIX "gfal2-plugins"
 /** plugin entry point */
 #define GFAL_PLUGIN_INIT_SYM "gfal_plugin_init"
+/** suffix of the manifest installed next to a plugin library, replacing the library suffix */
+#define GFAL_PLUGIN_MANIFEST_SUFFIX ".manifest"
+/** group of the plugin manifest */
+#define GFAL_PLUGIN_MANIFEST_GROUP "PLUGIN"
 
 /**  environment variable for personalized configuration directory */
 #define GFAL_CONFIG_DIR_ENV "GFAL_CONFIG_DIR"
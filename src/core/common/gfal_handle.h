@@ -39,9 +39,20 @@ struct _gfal_plugin_opts {
     gfal_plugin_interface plugin_list[MAX_PLUGIN_LIST];
     GList* sorted_plugin;
     int plugin_number;
+    // plugins known from their manifest, loaded on first use
+    GList* lazy_plugins;
+    // manifests of the plugins already loaded, inherited by the clones
+    GList* loaded_manifests;
+    // previous versions of sorted_plugin, may still be walked by other threads
+    GList* retired_sorted;
+    GStaticRecMutex mux_load;
 };
 typedef struct _gfal_plugin_opts gfal_plugin_opts;
 
+typedef struct _gfal_md_cache gfal_md_cache;
+
+typedef struct _gfal_shared_config gfal_shared_config;
+
 
 struct gfal_handle_ {
 	gboolean initiated;
@@ -49,7 +60,12 @@ struct gfal_handle_ {
     gfal_plugin_opts plugin_opt;
 	//struct for the file descriptors
 	gfal_file_handle_container fdescs;
-	GKeyFile *config;
+    // configuration, with its reference count, shared with the clones of the context
+    gfal_shared_config *config_share;
+    // serializes the changes of the configuration of this context with its sharing
+    GMutex *mux_config;
+    // incremented on each change of the configuration, so derived values can be cached
+    volatile gint config_version;
     // cancel logic
     volatile gint running_ops;
     gboolean cancel;
@@ -63,6 +79,18 @@ struct gfal_handle_ {
     char* agent_name;
     char* agent_version;
     GPtrArray* client_info;
+
+    // asynchronous operations executor
+    GMutex* mux_async;
+    GThreadPool* async_pool;
+    GAsyncQueue* async_completed;
+    int async_fd[2];
+    // operations started by the plugins, and not completed yet
+    gint async_running;
+    GCond* async_idle;
+
+    // stat, access and getxattr results
+    gfal_md_cache* md_cache;
 };
 
 
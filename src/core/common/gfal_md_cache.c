@@ -0,0 +1,500 @@
+/*
+ * Copyright (c) CERN 2013-2017
+ *
+ * Copyright (c) Members of the EMI Collaboration. 2010-2013
+ *  See  http://www.eu-emi.eu/partners for details on the copyright
+ *  holders.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <string.h>
+#include <logger/gfal_logger.h>
+#include <gfal_api.h>
+#include "gfal_md_cache.h"
+
+
+typedef struct {
+    gint64 expires;
+    size_t size;
+    gchar* value;
+} gfal_md_cache_xattr;
+
+typedef struct {
+    // latest expiration time of the values below, monotonic time in usec
+    gint64 expires;
+    gint64 stat_expires;
+    struct stat st;
+    gint64 lstat_expires;
+    struct stat lst;
+    // indexed by the access mode
+    gint64 access_expires[8];
+    // name -> gfal_md_cache_xattr, created on demand
+    GHashTable* xattrs;
+} gfal_md_cache_entry;
+
+struct _gfal_md_cache {
+    GMutex* lock;
+    // incremented on each invalidation
+    volatile gint generation;
+    // CORE:METADATA_CACHE_TTL, read again when the configuration version changes
+    volatile gint ttl;
+    volatile gint ttl_config_version;
+    // normalized url -> gfal_md_cache_entry
+    GHashTable* entries;
+    // normalized url -> number of writers
+    GHashTable* writing;
+    // gfal_file_handle -> normalized url
+    GHashTable* write_handles;
+};
+
+
+static void gfal_md_cache_xattr_free(gpointer data)
+{
+    gfal_md_cache_xattr* xattr = (gfal_md_cache_xattr*) data;
+    g_free(xattr->value);
+    g_free(xattr);
+}
+
+
+static void gfal_md_cache_entry_free(gpointer data)
+{
+    gfal_md_cache_entry* entry = (gfal_md_cache_entry*) data;
+    if (entry->xattrs)
+        g_hash_table_destroy(entry->xattrs);
+    g_free(entry);
+}
+
+
+gfal_md_cache* gfal_md_cache_new(void)
+{
+    gfal_md_cache* cache = g_new0(gfal_md_cache, 1);
+    cache->lock = g_mutex_new();
+    cache->ttl_config_version = -1;
+    cache->entries = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, gfal_md_cache_entry_free);
+    cache->writing = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+    cache->write_handles = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, g_free);
+    return cache;
+}
+
+
+void gfal_md_cache_free(gfal_md_cache* cache)
+{
+    if (cache == NULL)
+        return;
+    g_hash_table_destroy(cache->entries);
+    g_hash_table_destroy(cache->writing);
+    g_hash_table_destroy(cache->write_handles);
+    g_mutex_free(cache->lock);
+    g_free(cache);
+}
+
+// Cache lifetime, in usec. 0 if disabled
+// The configuration is only looked up again after it changed, so a disabled cache costs nothing
+static gint64 gfal_md_cache_ttl(gfal2_context_t handle)
+{
+    gfal_md_cache* cache = handle->md_cache;
+    if (cache == NULL)
+        return 0;
+
+    gint version = g_atomic_int_get(&handle->config_version);
+    if (g_atomic_int_get(&cache->ttl_config_version) != version) {
+        // Concurrent refreshes store the same value
+        g_atomic_int_set(&cache->ttl, gfal2_get_opt_integer_with_default(handle, "CORE", "METADATA_CACHE_TTL", 0));
+        g_atomic_int_set(&cache->ttl_config_version, version);
+    }
+
+    gint ttl = g_atomic_int_get(&cache->ttl);
+    if (ttl <= 0)
+        return 0;
+    return ttl * G_GINT64_CONSTANT(1000000);
+}
+
+
+gint gfal_md_cache_generation(gfal2_context_t handle)
+{
+    if (handle->md_cache == NULL)
+        return 0;
+    return g_atomic_int_get(&handle->md_cache->generation);
+}
+
+// Attributes that change without gfal2 knowing, as the locality of a file on tape
+static gboolean gfal_md_cache_xattr_is_live(const char* name)
+{
+    return strncmp(name, GFAL_XATTR_STATUS, sizeof(GFAL_XATTR_STATUS) - 1) == 0 ||
+           strncmp(name, GFAL_XATTR_SPACETOKEN, sizeof(GFAL_XATTR_SPACETOKEN) - 1) == 0;
+}
+
+// Remove the trailing slashes, so the directories are found with or without them
+static gchar* gfal_md_cache_key(const char* url)
+{
+    size_t len = strlen(url);
+    while (len > 1 && url[len - 1] == '/' && !(len >= 3 && strncmp(url + len - 3, "://", 3) == 0))
+        --len;
+    return g_strndup(url, len);
+}
+
+// Key of the parent directory, NULL for the root
+static gchar* gfal_md_cache_parent_key(const char* key)
+{
+    const char* last_slash = strrchr(key, '/');
+    if (last_slash == NULL)
+        return NULL;
+
+    const char* scheme_sep = strstr(key, "://");
+    if (scheme_sep && last_slash <= scheme_sep + 2)
+        return NULL;
+
+    if (last_slash == key) {
+        if (key[1] == '\0')
+            return NULL;
+        return g_strdup("/");
+    }
+    return g_strndup(key, last_slash - key);
+}
+
+// Entry to store values for key, NULL if key is being written, or if something was
+// invalidated since generation was taken. Called with the lock held
+static gfal_md_cache_entry* gfal_md_cache_entry_for_put(gfal2_context_t handle, gint generation,
+        const gchar* key)
+{
+    gfal_md_cache* cache = handle->md_cache;
+
+    if (cache->generation != generation || g_hash_table_lookup(cache->writing, key))
+        return NULL;
+
+    gfal_md_cache_entry* entry = g_hash_table_lookup(cache->entries, key);
+    if (entry)
+        return entry;
+
+    guint max_size = gfal2_get_opt_integer_with_default(handle, "CORE", "METADATA_CACHE_SIZE", 10000);
+    if (g_hash_table_size(cache->entries) >= max_size) {
+        GHashTableIter iter;
+        gpointer value;
+        gint64 now = g_get_monotonic_time();
+
+        g_hash_table_iter_init(&iter, cache->entries);
+        while (g_hash_table_iter_next(&iter, NULL, &value)) {
+            if (((gfal_md_cache_entry*) value)->expires <= now)
+                g_hash_table_iter_remove(&iter);
+        }
+        if (g_hash_table_size(cache->entries) >= max_size)
+            g_hash_table_remove_all(cache->entries);
+    }
+
+    entry = g_new0(gfal_md_cache_entry, 1);
+    g_hash_table_insert(cache->entries, g_strdup(key), entry);
+    return entry;
+}
+
+
+gboolean gfal_md_cache_get_stat(gfal2_context_t handle, const char* url, gboolean follow,
+        struct stat* st)
+{
+    if (gfal_md_cache_ttl(handle) == 0)
+        return FALSE;
+
+    gfal_md_cache* cache = handle->md_cache;
+    gchar* key = gfal_md_cache_key(url);
+    gboolean found = FALSE;
+
+    g_mutex_lock(cache->lock);
+    gfal_md_cache_entry* entry = g_hash_table_lookup(cache->entries, key);
+    if (entry) {
+        gint64 now = g_get_monotonic_time();
+        if (follow && entry->stat_expires > now) {
+            memcpy(st, &entry->st, sizeof(struct stat));
+            found = TRUE;
+        }
+        else if (!follow && entry->lstat_expires > now) {
+            memcpy(st, &entry->lst, sizeof(struct stat));
+            found = TRUE;
+        }
+    }
+    g_mutex_unlock(cache->lock);
+
+    if (found)
+        gfal2_log(G_LOG_LEVEL_DEBUG, "Metadata cache hit for %s %s", follow ? "stat" : "lstat", key);
+    g_free(key);
+    return found;
+}
+
+
+void gfal_md_cache_put_stat(gfal2_context_t handle, gint generation, const char* url, gboolean follow,
+        const struct stat* st)
+{
+    gint64 ttl = gfal_md_cache_ttl(handle);
+    if (ttl == 0)
+        return;
+
+    gfal_md_cache* cache = handle->md_cache;
+    gchar* key = gfal_md_cache_key(url);
+    gint64 expires = g_get_monotonic_time() + ttl;
+
+    g_mutex_lock(cache->lock);
+    gfal_md_cache_entry* entry = gfal_md_cache_entry_for_put(handle, generation, key);
+    if (entry) {
+        if (follow) {
+            memcpy(&entry->st, st, sizeof(struct stat));
+            entry->stat_expires = expires;
+        }
+        else {
+            memcpy(&entry->lst, st, sizeof(struct stat));
+            entry->lstat_expires = expires;
+        }
+        entry->expires = expires;
+    }
+    g_mutex_unlock(cache->lock);
+    g_free(key);
+}
+
+
+gboolean gfal_md_cache_get_access(gfal2_context_t handle, const char* url, int mode)
+{
+    if (gfal_md_cache_ttl(handle) == 0)
+        return FALSE;
+
+    gfal_md_cache* cache = handle->md_cache;
+    gchar* key = gfal_md_cache_key(url);
+    gboolean found = FALSE;
+
+    g_mutex_lock(cache->lock);
+    gfal_md_cache_entry* entry = g_hash_table_lookup(cache->entries, key);
+    if (entry)
+        found = entry->access_expires[mode & 7] > g_get_monotonic_time();
+    g_mutex_unlock(cache->lock);
+
+    if (found)
+        gfal2_log(G_LOG_LEVEL_DEBUG, "Metadata cache hit for access %s", key);
+    g_free(key);
+    return found;
+}
+
+
+void gfal_md_cache_put_access(gfal2_context_t handle, gint generation, const char* url, int mode)
+{
+    gint64 ttl = gfal_md_cache_ttl(handle);
+    if (ttl == 0)
+        return;
+
+    gfal_md_cache* cache = handle->md_cache;
+    gchar* key = gfal_md_cache_key(url);
+    gint64 expires = g_get_monotonic_time() + ttl;
+
+    g_mutex_lock(cache->lock);
+    gfal_md_cache_entry* entry = gfal_md_cache_entry_for_put(handle, generation, key);
+    if (entry) {
+        entry->access_expires[mode & 7] = expires;
+        entry->expires = expires;
+    }
+    g_mutex_unlock(cache->lock);
+    g_free(key);
+}
+
+
+ssize_t gfal_md_cache_get_xattr(gfal2_context_t handle, const char* url, const char* name,
+        void* buff, size_t s_buff)
+{
+    if (gfal_md_cache_ttl(handle) == 0 || gfal_md_cache_xattr_is_live(name))
+        return -1;
+
+    gfal_md_cache* cache = handle->md_cache;
+    gchar* key = gfal_md_cache_key(url);
+    ssize_t size = -1;
+
+    g_mutex_lock(cache->lock);
+    gfal_md_cache_entry* entry = g_hash_table_lookup(cache->entries, key);
+    if (entry && entry->xattrs) {
+        gfal_md_cache_xattr* xattr = g_hash_table_lookup(entry->xattrs, name);
+        if (xattr && xattr->expires > g_get_monotonic_time()) {
+            if (s_buff == 0) {
+                size = xattr->size;
+            }
+            else if (xattr->size <= s_buff) {
+                memcpy(buff, xattr->value, xattr->size);
+                // Most plugins return string values, and leave them null terminated
+                if (xattr->size < s_buff)
+                    ((char*) buff)[xattr->size] = '\0';
+                size = xattr->size;
+            }
+        }
+    }
+    g_mutex_unlock(cache->lock);
+
+    if (size >= 0)
+        gfal2_log(G_LOG_LEVEL_DEBUG, "Metadata cache hit for getxattr %s %s", name, key);
+    g_free(key);
+    return size;
+}
+
+
+void gfal_md_cache_put_xattr(gfal2_context_t handle, gint generation, const char* url, const char* name,
+        const void* value, size_t size)
+{
+    gint64 ttl = gfal_md_cache_ttl(handle);
+    if (ttl == 0 || gfal_md_cache_xattr_is_live(name))
+        return;
+
+    gfal_md_cache* cache = handle->md_cache;
+    gchar* key = gfal_md_cache_key(url);
+    gint64 expires = g_get_monotonic_time() + ttl;
+
+    g_mutex_lock(cache->lock);
+    gfal_md_cache_entry* entry = gfal_md_cache_entry_for_put(handle, generation, key);
+    if (entry) {
+        if (entry->xattrs == NULL)
+            entry->xattrs = g_hash_table_new_full(g_str_hash, g_str_equal, g_free,
+                    gfal_md_cache_xattr_free);
+        gfal_md_cache_xattr* xattr = g_new0(gfal_md_cache_xattr, 1);
+        xattr->expires = expires;
+        xattr->size = size;
+        xattr->value = g_memdup(value, size);
+        g_hash_table_replace(entry->xattrs, g_strdup(name), xattr);
+        entry->expires = expires;
+    }
+    g_mutex_unlock(cache->lock);
+    g_free(key);
+}
+
+// Remove key and its parent. Called with the lock held
+static void gfal_md_cache_remove(gfal_md_cache* cache, const gchar* key)
+{
+    g_atomic_int_inc(&cache->generation);
+    g_hash_table_remove(cache->entries, key);
+    gchar* parent = gfal_md_cache_parent_key(key);
+    if (parent) {
+        g_hash_table_remove(cache->entries, parent);
+        g_free(parent);
+    }
+}
+
+
+void gfal_md_cache_invalidate(gfal2_context_t handle, const char* url)
+{
+    gfal_md_cache* cache = handle->md_cache;
+    if (cache == NULL || url == NULL)
+        return;
+
+    gchar* key = gfal_md_cache_key(url);
+    g_mutex_lock(cache->lock);
+    gfal_md_cache_remove(cache, key);
+    g_mutex_unlock(cache->lock);
+    g_free(key);
+}
+
+
+void gfal_md_cache_invalidate_list(gfal2_context_t handle, int nbfiles, const char* const* urls)
+{
+    int i;
+    for (i = 0; i < nbfiles; ++i)
+        gfal_md_cache_invalidate(handle, urls[i]);
+}
+
+
+void gfal_md_cache_invalidate_tree(gfal2_context_t handle, const char* url)
+{
+    gfal_md_cache* cache = handle->md_cache;
+    if (cache == NULL || url == NULL)
+        return;
+
+    gchar* key = gfal_md_cache_key(url);
+    size_t key_len = strlen(key);
+    GHashTableIter iter;
+    gpointer entry_key;
+
+    g_mutex_lock(cache->lock);
+    gfal_md_cache_remove(cache, key);
+    g_hash_table_iter_init(&iter, cache->entries);
+    while (g_hash_table_iter_next(&iter, &entry_key, NULL)) {
+        const char* entry_url = (const char*) entry_key;
+        if (strncmp(entry_url, key, key_len) == 0 && entry_url[key_len] == '/')
+            g_hash_table_iter_remove(&iter);
+    }
+    g_mutex_unlock(cache->lock);
+    g_free(key);
+}
+
+// Called with the lock held
+static void gfal_md_cache_writer_add(gfal_md_cache* cache, gchar* key)
+{
+    gint writers = GPOINTER_TO_INT(g_hash_table_lookup(cache->writing, key));
+    g_hash_table_replace(cache->writing, key, GINT_TO_POINTER(writers + 1));
+    gfal_md_cache_remove(cache, key);
+}
+
+// Called with the lock held
+static void gfal_md_cache_writer_remove(gfal_md_cache* cache, const gchar* key)
+{
+    gint writers = GPOINTER_TO_INT(g_hash_table_lookup(cache->writing, key));
+    if (writers > 1)
+        g_hash_table_replace(cache->writing, g_strdup(key), GINT_TO_POINTER(writers - 1));
+    else
+        g_hash_table_remove(cache->writing, key);
+    // The values read during the write may be stale
+    gfal_md_cache_remove(cache, key);
+}
+
+
+void gfal_md_cache_write_begin(gfal2_context_t handle, const char* url)
+{
+    gfal_md_cache* cache = handle->md_cache;
+    if (cache == NULL || url == NULL)
+        return;
+
+    g_mutex_lock(cache->lock);
+    gfal_md_cache_writer_add(cache, gfal_md_cache_key(url));
+    g_mutex_unlock(cache->lock);
+}
+
+
+void gfal_md_cache_write_end(gfal2_context_t handle, const char* url)
+{
+    gfal_md_cache* cache = handle->md_cache;
+    if (cache == NULL || url == NULL)
+        return;
+
+    gchar* key = gfal_md_cache_key(url);
+    g_mutex_lock(cache->lock);
+    gfal_md_cache_writer_remove(cache, key);
+    g_mutex_unlock(cache->lock);
+    g_free(key);
+}
+
+
+void gfal_md_cache_open_for_write(gfal2_context_t handle, gfal_file_handle fh, const char* url)
+{
+    gfal_md_cache* cache = handle->md_cache;
+    if (cache == NULL || url == NULL)
+        return;
+
+    g_mutex_lock(cache->lock);
+    gfal_md_cache_writer_add(cache, gfal_md_cache_key(url));
+    g_hash_table_insert(cache->write_handles, fh, gfal_md_cache_key(url));
+    g_mutex_unlock(cache->lock);
+}
+
+
+void gfal_md_cache_close(gfal2_context_t handle, gfal_file_handle fh)
+{
+    gfal_md_cache* cache = handle->md_cache;
+    if (cache == NULL)
+        return;
+
+    g_mutex_lock(cache->lock);
+    const gchar* key = g_hash_table_lookup(cache->write_handles, fh);
+    if (key) {
+        gfal_md_cache_writer_remove(cache, key);
+        g_hash_table_remove(cache->write_handles, fh);
+    }
+    g_mutex_unlock(cache->lock);
+}
@@ -0,0 +1,81 @@
+/*
+ * Copyright (c) CERN 2013-2017
+ *
+ * Copyright (c) Members of the EMI Collaboration. 2010-2013
+ *  See  http://www.eu-emi.eu/partners for details on the copyright
+ *  holders.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+#ifndef GFAL_MD_CACHE_H_
+#define GFAL_MD_CACHE_H_
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <glib.h>
+#include "gfal_handle.h"
+
+// Per context cache of stat, lstat, access and getxattr results, internal
+// Enabled by CORE:METADATA_CACHE_TTL. Only successful results are cached, and
+// nothing is cached for an url while it is open for writing or the destination of a copy
+gfal_md_cache* gfal_md_cache_new(void);
+
+void gfal_md_cache_free(gfal_md_cache* cache);
+
+// Generation of the cache, to be taken before a request whose result is stored with a put
+// The put is ignored if anything was invalidated in between, as the result may predate it
+gint gfal_md_cache_generation(gfal2_context_t handle);
+
+// Return TRUE and fill st if a valid entry exists. follow is FALSE for lstat
+gboolean gfal_md_cache_get_stat(gfal2_context_t handle, const char* url, gboolean follow,
+        struct stat* st);
+
+void gfal_md_cache_put_stat(gfal2_context_t handle, gint generation, const char* url, gboolean follow,
+        const struct stat* st);
+
+// Return TRUE if access with this mode succeeded recently
+gboolean gfal_md_cache_get_access(gfal2_context_t handle, const char* url, int mode);
+
+void gfal_md_cache_put_access(gfal2_context_t handle, gint generation, const char* url, int mode);
+
+// Return the size of the cached value, or -1 if not cached or if it does not fit in s_buff
+// Attributes reflecting a live state, as user.status or spacetoken, are never cached
+// With s_buff 0 only the size is returned, as getxattr does
+ssize_t gfal_md_cache_get_xattr(gfal2_context_t handle, const char* url, const char* name,
+        void* buff, size_t s_buff);
+
+void gfal_md_cache_put_xattr(gfal2_context_t handle, gint generation, const char* url, const char* name,
+        const void* value, size_t size);
+
+// Forget url and its parent directory
+void gfal_md_cache_invalidate(gfal2_context_t handle, const char* url);
+
+// Forget each url and its parent directory
+void gfal_md_cache_invalidate_list(gfal2_context_t handle, int nbfiles, const char* const* urls);
+
+// Forget url, its parent directory and everything below url
+void gfal_md_cache_invalidate_tree(gfal2_context_t handle, const char* url);
+
+// Mark url as being written: invalidate it, and do not cache it until the matching end
+void gfal_md_cache_write_begin(gfal2_context_t handle, const char* url);
+
+void gfal_md_cache_write_end(gfal2_context_t handle, const char* url);
+
+// Same as write_begin/write_end, for an url open for writing with fh
+void gfal_md_cache_open_for_write(gfal2_context_t handle, gfal_file_handle fh, const char* url);
+
+void gfal_md_cache_close(gfal2_context_t handle, gfal_file_handle fh);
+
+#endif /* GFAL_MD_CACHE_H_ */
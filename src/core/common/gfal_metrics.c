@@ -0,0 +1,474 @@
+/*
+ * Copyright (c) CERN 2013-2017
+ *
+ * Copyright (c) Members of the EMI Collaboration. 2010-2013
+ *  See  http://www.eu-emi.eu/partners for details on the copyright
+ *  holders.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <string.h>
+#include "gfal_metrics_internal.h"
+
+// Log-linear histogram: each power of two is split in 4 sub-buckets,
+// values below 4 have their own bucket
+#define GFAL_METRICS_SUB_BITS 2
+#define GFAL_METRICS_SUB_COUNT (1 << GFAL_METRICS_SUB_BITS)
+#define GFAL_METRICS_BUCKETS (64 * GFAL_METRICS_SUB_COUNT)
+
+#define GFAL_METRICS_MAX_HOST 256
+
+
+typedef struct _gfal_metric_series gfal_metric_series;
+
+// Part of a series owned by one thread: only that thread writes into it,
+// so recording an operation needs no atomic operation nor shared cache line
+typedef struct {
+    gfal_metric_series *series;
+    // Shards of a previous reset epoch are zeroed by their owner before being used
+    volatile gint epoch;
+    volatile guint64 errors;
+    volatile guint64 sum_usec;
+    volatile guint64 max_usec;
+    volatile guint64 buckets[GFAL_METRICS_BUCKETS];
+} gfal_metric_shard;
+
+
+struct _gfal_metric_series {
+    char *plugin;
+    char *operation;
+    char *host;
+    // All the shards, merged at snapshot time
+    GSList *shards;
+    // Shards left by threads that exited, with their counters, ready to be reused
+    GSList *free_shards;
+};
+
+
+// The plugin and operation names are the static strings given by the callers,
+// so the threads identify a series by their pointers. The registry compares
+// the interned strings instead, as the same name may come from different places
+typedef struct {
+    const char *plugin;
+    const char *operation;
+    const char *host;
+} gfal_metric_key;
+
+
+struct _gfal2_metrics_snapshot {
+    GPtrArray *metrics;
+};
+
+
+// Series and shards are never released, so pointers cached by the threads remain valid
+// Only the creation of a new shard takes the registry lock
+static GHashTable *metrics_registry = NULL;
+static GMutex *metrics_lock = NULL;
+static GPrivate *metrics_thread_cache = NULL;
+static volatile gint metrics_enabled = FALSE;
+static volatile gint metrics_epoch = 0;
+
+
+static guint gfal_metrics_key_hash(gconstpointer ptr)
+{
+    const gfal_metric_key *key = (const gfal_metric_key*)ptr;
+    return (g_direct_hash(key->plugin) * 31 + g_direct_hash(key->operation)) * 31 + g_str_hash(key->host);
+}
+
+
+static gboolean gfal_metrics_key_equal(gconstpointer a, gconstpointer b)
+{
+    const gfal_metric_key *ka = (const gfal_metric_key*)a;
+    const gfal_metric_key *kb = (const gfal_metric_key*)b;
+    return ka->plugin == kb->plugin && ka->operation == kb->operation && strcmp(ka->host, kb->host) == 0;
+}
+
+
+static gfal_metric_key *gfal_metrics_key_dup(const char *plugin, const char *operation, const char *host)
+{
+    gfal_metric_key *key = g_malloc(sizeof(gfal_metric_key) + strlen(host) + 1);
+    char *host_copy = (char*)(key + 1);
+    strcpy(host_copy, host);
+    key->plugin = plugin;
+    key->operation = operation;
+    key->host = host_copy;
+    return key;
+}
+
+
+// The thread exits: its shards keep their counters, and are handed to the next thread
+static void gfal_metrics_release_shard(gpointer key, gpointer value, gpointer user_data)
+{
+    gfal_metric_shard *shard = (gfal_metric_shard*)value;
+    shard->series->free_shards = g_slist_prepend(shard->series->free_shards, shard);
+}
+
+
+static void gfal_metrics_free_thread_cache(gpointer ptr)
+{
+    GHashTable *cache = (GHashTable*)ptr;
+    g_mutex_lock(metrics_lock);
+    g_hash_table_foreach(cache, gfal_metrics_release_shard, NULL);
+    g_mutex_unlock(metrics_lock);
+    g_hash_table_destroy(cache);
+}
+
+
+__attribute__((constructor))
+static void gfal_metrics_init()
+{
+#if  (!GLIB_CHECK_VERSION (2, 32, 0))
+    if (!g_thread_supported())
+        g_thread_init(NULL);
+#endif
+    metrics_registry = g_hash_table_new(gfal_metrics_key_hash, gfal_metrics_key_equal);
+    metrics_lock = g_mutex_new();
+    metrics_thread_cache = g_private_new(gfal_metrics_free_thread_cache);
+}
+
+
+static guint gfal_metrics_bucket_index(guint64 value)
+{
+    if (value < GFAL_METRICS_SUB_COUNT)
+        return (guint)value;
+    guint msb = 63 - __builtin_clzll(value);
+    guint sub = (guint)(value >> (msb - GFAL_METRICS_SUB_BITS)) & (GFAL_METRICS_SUB_COUNT - 1);
+    return (msb - GFAL_METRICS_SUB_BITS + 1) * GFAL_METRICS_SUB_COUNT + sub;
+}
+
+
+// Highest value that falls into the bucket
+static guint64 gfal_metrics_bucket_upper(guint index)
+{
+    if (index < GFAL_METRICS_SUB_COUNT)
+        return index;
+    guint msb = index / GFAL_METRICS_SUB_COUNT + GFAL_METRICS_SUB_BITS - 1;
+    guint64 sub = index % GFAL_METRICS_SUB_COUNT;
+    guint64 lower = (GFAL_METRICS_SUB_COUNT | sub) << (msb - GFAL_METRICS_SUB_BITS);
+    return lower + (G_GUINT64_CONSTANT(1) << (msb - GFAL_METRICS_SUB_BITS)) - 1;
+}
+
+
+void gfal_metrics_url_host(const char *url, char *host, size_t host_size)
+{
+    host[0] = '\0';
+    if (url == NULL)
+        return;
+
+    const char *begin = strstr(url, "://");
+    if (begin == NULL)
+        return;
+    begin += 3;
+
+    size_t len = strcspn(begin, "/?#");
+    const char *at = memchr(begin, '@', len);
+    if (at) {
+        len -= (at - begin) + 1;
+        begin = at + 1;
+    }
+    if (len >= host_size)
+        len = host_size - 1;
+    memcpy(host, begin, len);
+    host[len] = '\0';
+}
+
+
+// Must be called with metrics_lock held
+static gfal_metric_shard *gfal_metrics_new_shard(const char *plugin, const char *operation, const char *host)
+{
+    gfal_metric_key key = {g_intern_string(plugin), g_intern_string(operation), host};
+
+    gfal_metric_series *series = g_hash_table_lookup(metrics_registry, &key);
+    if (series == NULL) {
+        series = g_new0(gfal_metric_series, 1);
+        series->plugin = g_strdup(plugin);
+        series->operation = g_strdup(operation);
+        series->host = g_strdup(host);
+        g_hash_table_insert(metrics_registry, gfal_metrics_key_dup(key.plugin, key.operation, host), series);
+    }
+
+    gfal_metric_shard *shard;
+    if (series->free_shards) {
+        shard = series->free_shards->data;
+        series->free_shards = g_slist_delete_link(series->free_shards, series->free_shards);
+    }
+    else {
+        shard = g_new0(gfal_metric_shard, 1);
+        shard->series = series;
+        shard->epoch = g_atomic_int_get(&metrics_epoch);
+        series->shards = g_slist_prepend(series->shards, shard);
+    }
+    return shard;
+}
+
+
+static gfal_metric_shard *gfal_metrics_get_shard(const char *plugin, const char *operation, const char *url)
+{
+    char host[GFAL_METRICS_MAX_HOST];
+    gfal_metrics_url_host(url, host, sizeof(host));
+
+    GHashTable *cache = g_private_get(metrics_thread_cache);
+    if (cache == NULL) {
+        cache = g_hash_table_new_full(gfal_metrics_key_hash, gfal_metrics_key_equal, g_free, NULL);
+        g_private_set(metrics_thread_cache, cache);
+    }
+
+    gfal_metric_key key = {plugin, operation, host};
+    gfal_metric_shard *shard = g_hash_table_lookup(cache, &key);
+    if (shard)
+        return shard;
+
+    g_mutex_lock(metrics_lock);
+    shard = gfal_metrics_new_shard(plugin, operation, host);
+    g_mutex_unlock(metrics_lock);
+
+    g_hash_table_insert(cache, gfal_metrics_key_dup(plugin, operation, host), shard);
+    return shard;
+}
+
+
+gint64 gfal_metrics_start(void)
+{
+    if (!g_atomic_int_get(&metrics_enabled))
+        return 0;
+    return g_get_monotonic_time();
+}
+
+
+void gfal_metrics_record(const char *plugin, const char *operation, const char *url,
+    gint64 start, gboolean failed)
+{
+    guint64 elapsed = (guint64)(g_get_monotonic_time() - start);
+    gfal_metric_shard *shard = gfal_metrics_get_shard(plugin ? plugin : "", operation, url);
+
+    const gint epoch = g_atomic_int_get(&metrics_epoch);
+    if (shard->epoch != epoch) {
+        guint i;
+        shard->errors = shard->sum_usec = shard->max_usec = 0;
+        for (i = 0; i < GFAL_METRICS_BUCKETS; ++i)
+            shard->buckets[i] = 0;
+        // The snapshots must not see the new epoch before the counters are cleared
+        __sync_synchronize();
+        shard->epoch = epoch;
+    }
+
+    if (failed)
+        shard->errors += 1;
+    shard->sum_usec += elapsed;
+    shard->buckets[gfal_metrics_bucket_index(elapsed)] += 1;
+    if (elapsed > shard->max_usec)
+        shard->max_usec = elapsed;
+}
+
+
+static guint64 gfal_metrics_percentile(const guint64 *buckets, guint64 count, guint64 max, double percentile)
+{
+    if (count == 0)
+        return 0;
+
+    guint64 rank = (guint64)(count * percentile);
+    if (rank >= count)
+        rank = count - 1;
+
+    guint64 seen = 0;
+    guint i;
+    for (i = 0; i < GFAL_METRICS_BUCKETS; ++i) {
+        seen += buckets[i];
+        if (seen > rank) {
+            guint64 upper = gfal_metrics_bucket_upper(i);
+            return upper < max ? upper : max;
+        }
+    }
+    return max;
+}
+
+
+static void gfal_metrics_snapshot_series(gpointer key, gpointer value, gpointer user_data)
+{
+    gfal_metric_series *series = (gfal_metric_series*)value;
+    GPtrArray *metrics = (GPtrArray*)user_data;
+    guint64 buckets[GFAL_METRICS_BUCKETS] = {0};
+    guint64 count = 0;
+    const gint epoch = g_atomic_int_get(&metrics_epoch);
+    GSList *item;
+    guint i;
+
+    gfal2_metric_t *metric = g_new0(gfal2_metric_t, 1);
+    metric->plugin = series->plugin;
+    metric->operation = series->operation;
+    metric->host = series->host;
+
+    // Shards not used since the last reset are only cleared by their owner
+    for (item = series->shards; item != NULL; item = g_slist_next(item)) {
+        gfal_metric_shard *shard = (gfal_metric_shard*)item->data;
+        if (shard->epoch != epoch)
+            continue;
+        __sync_synchronize();
+        for (i = 0; i < GFAL_METRICS_BUCKETS; ++i)
+            buckets[i] += shard->buckets[i];
+        metric->errors += shard->errors;
+        metric->sum_usec += shard->sum_usec;
+        metric->max_usec = MAX(metric->max_usec, shard->max_usec);
+    }
+
+    // Compute the count from the histogram itself, so percentiles are consistent
+    // even if the series is being updated concurrently
+    for (i = 0; i < GFAL_METRICS_BUCKETS; ++i)
+        count += buckets[i];
+
+    metric->count = count;
+    metric->p50_usec = gfal_metrics_percentile(buckets, count, metric->max_usec, 0.50);
+    metric->p90_usec = gfal_metrics_percentile(buckets, count, metric->max_usec, 0.90);
+    metric->p99_usec = gfal_metrics_percentile(buckets, count, metric->max_usec, 0.99);
+
+    g_ptr_array_add(metrics, metric);
+}
+
+
+gfal2_metrics_snapshot_t gfal2_metrics_snapshot(void)
+{
+    gfal2_metrics_snapshot_t snapshot = g_new0(struct _gfal2_metrics_snapshot, 1);
+    snapshot->metrics = g_ptr_array_new_with_free_func(g_free);
+
+    g_mutex_lock(metrics_lock);
+    g_hash_table_foreach(metrics_registry, gfal_metrics_snapshot_series, snapshot->metrics);
+    g_mutex_unlock(metrics_lock);
+
+    return snapshot;
+}
+
+
+guint gfal2_metrics_snapshot_length(gfal2_metrics_snapshot_t snapshot)
+{
+    g_return_val_if_fail(snapshot != NULL, 0);
+    return snapshot->metrics->len;
+}
+
+
+const gfal2_metric_t *gfal2_metrics_snapshot_get(gfal2_metrics_snapshot_t snapshot, guint index)
+{
+    g_return_val_if_fail(snapshot != NULL, NULL);
+    if (index >= snapshot->metrics->len)
+        return NULL;
+    return g_ptr_array_index(snapshot->metrics, index);
+}
+
+
+void gfal2_metrics_snapshot_free(gfal2_metrics_snapshot_t snapshot)
+{
+    if (snapshot == NULL)
+        return;
+    g_ptr_array_free(snapshot->metrics, TRUE);
+    g_free(snapshot);
+}
+
+
+// Escape a label value as required by the text exposition format
+static void gfal_metrics_append_label(GString *out, const char *name, const char *value)
+{
+    g_string_append_printf(out, "%s=\"", name);
+    for (; *value; ++value) {
+        switch (*value) {
+            case '\\':
+                g_string_append(out, "\\\\");
+                break;
+            case '"':
+                g_string_append(out, "\\\"");
+                break;
+            case '\n':
+                g_string_append(out, "\\n");
+                break;
+            default:
+                g_string_append_c(out, *value);
+        }
+    }
+    g_string_append_c(out, '"');
+}
+
+
+static void gfal_metrics_append_labels(GString *out, const gfal2_metric_t *metric, const char *quantile)
+{
+    g_string_append_c(out, '{');
+    gfal_metrics_append_label(out, "plugin", metric->plugin);
+    g_string_append_c(out, ',');
+    gfal_metrics_append_label(out, "operation", metric->operation);
+    g_string_append_c(out, ',');
+    gfal_metrics_append_label(out, "host", metric->host);
+    if (quantile) {
+        g_string_append_c(out, ',');
+        gfal_metrics_append_label(out, "quantile", quantile);
+    }
+    g_string_append_c(out, '}');
+}
+
+
+char *gfal2_metrics_to_prometheus(gfal2_metrics_snapshot_t snapshot)
+{
+    g_return_val_if_fail(snapshot != NULL, NULL);
+
+    GString *out = g_string_new(NULL);
+    guint i;
+
+    g_string_append(out,
+        "# HELP gfal2_operation_duration_seconds Latency of the operations dispatched to the plugins\n"
+        "# TYPE gfal2_operation_duration_seconds summary\n");
+    for (i = 0; i < snapshot->metrics->len; ++i) {
+        const gfal2_metric_t *metric = g_ptr_array_index(snapshot->metrics, i);
+        const struct {
+            const char *label;
+            guint64 value;
+        } quantiles[] = {
+            {"0.5", metric->p50_usec},
+            {"0.9", metric->p90_usec},
+            {"0.99", metric->p99_usec}
+        };
+        size_t q;
+        for (q = 0; q < G_N_ELEMENTS(quantiles); ++q) {
+            g_string_append(out, "gfal2_operation_duration_seconds");
+            gfal_metrics_append_labels(out, metric, quantiles[q].label);
+            g_string_append_printf(out, " %.6f\n", quantiles[q].value / 1e6);
+        }
+        g_string_append(out, "gfal2_operation_duration_seconds_sum");
+        gfal_metrics_append_labels(out, metric, NULL);
+        g_string_append_printf(out, " %.6f\n", metric->sum_usec / 1e6);
+        g_string_append(out, "gfal2_operation_duration_seconds_count");
+        gfal_metrics_append_labels(out, metric, NULL);
+        g_string_append_printf(out, " %" G_GUINT64_FORMAT "\n", metric->count);
+    }
+
+    g_string_append(out,
+        "# HELP gfal2_operation_errors_total Number of operations that failed\n"
+        "# TYPE gfal2_operation_errors_total counter\n");
+    for (i = 0; i < snapshot->metrics->len; ++i) {
+        const gfal2_metric_t *metric = g_ptr_array_index(snapshot->metrics, i);
+        g_string_append(out, "gfal2_operation_errors_total");
+        gfal_metrics_append_labels(out, metric, NULL);
+        g_string_append_printf(out, " %" G_GUINT64_FORMAT "\n", metric->errors);
+    }
+
+    return g_string_free(out, FALSE);
+}
+
+
+void gfal2_metrics_reset(void)
+{
+    // The shards are cleared lazily by their owner, which is the only one writing into them
+    g_atomic_int_inc(&metrics_epoch);
+}
+
+
+void gfal2_metrics_set_enabled(gboolean enabled)
+{
+    g_atomic_int_set(&metrics_enabled, enabled ? TRUE : FALSE);
+}
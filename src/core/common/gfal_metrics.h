@@ -0,0 +1,120 @@
+/*
+ * Copyright (c) CERN 2013-2017
+ *
+ * Copyright (c) Members of the EMI Collaboration. 2010-2013
+ *  See  http://www.eu-emi.eu/partners for details on the copyright
+ *  holders.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+#ifndef GFAL_METRICS_H_
+#define GFAL_METRICS_H_
+
+#if !defined(__GFAL2_H_INSIDE__) && !defined(__GFAL2_BUILD__)
+#   warning "Direct inclusion of gfal2 headers is deprecated. Please, include only gfal_api.h or gfal_plugins_api.h"
+#endif
+
+#include <glib.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*!
+    \defgroup metrics_group Operation metrics
+
+    Once enabled with \ref gfal2_metrics_set_enabled, gfal2 keeps, for the whole process,
+    a count and a latency histogram of every operation dispatched to a plugin, keyed by
+    plugin name, operation and remote host.
+    The registry can be inspected at any time with \ref gfal2_metrics_snapshot.
+*/
+
+/*!
+    \addtogroup metrics_group
+    @{
+*/
+
+/**
+ * Metrics of one (plugin, operation, host) series
+ * Latencies are in microseconds. Percentiles are estimated from the histogram,
+ * with a relative error below 25%
+ */
+typedef struct {
+    const char* plugin;
+    const char* operation;
+    const char* host;
+    guint64 count;
+    guint64 errors;
+    guint64 sum_usec;
+    guint64 max_usec;
+    guint64 p50_usec;
+    guint64 p90_usec;
+    guint64 p99_usec;
+} gfal2_metric_t;
+
+/**
+ * Immutable copy of the metrics registry
+ */
+typedef struct _gfal2_metrics_snapshot* gfal2_metrics_snapshot_t;
+
+/**
+ * @brief take a snapshot of the metrics registry
+ * @return a snapshot, to be released with \ref gfal2_metrics_snapshot_free
+ */
+gfal2_metrics_snapshot_t gfal2_metrics_snapshot(void);
+
+/**
+ * @brief number of series in the snapshot
+ */
+guint gfal2_metrics_snapshot_length(gfal2_metrics_snapshot_t snapshot);
+
+/**
+ * @brief get a series from the snapshot
+ * @return the series, or NULL if index is out of range. Owned by the snapshot.
+ */
+const gfal2_metric_t* gfal2_metrics_snapshot_get(gfal2_metrics_snapshot_t snapshot, guint index);
+
+/**
+ * @brief release a snapshot
+ */
+void gfal2_metrics_snapshot_free(gfal2_metrics_snapshot_t snapshot);
+
+/**
+ * @brief format a snapshot using the Prometheus text exposition format
+ * @return a newly allocated string, to be released with g_free
+ */
+char* gfal2_metrics_to_prometheus(gfal2_metrics_snapshot_t snapshot);
+
+/**
+ * @brief reset all counters and histograms to zero
+ */
+void gfal2_metrics_reset(void);
+
+/**
+ * @brief enable or disable the metrics collection (disabled by default)
+ */
+void gfal2_metrics_set_enabled(gboolean enabled);
+
+/**
+    @}
+    End of the METRICS group
+*/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* GFAL_METRICS_H_ */
@@ -0,0 +1,83 @@
+/*
+ * Copyright (c) CERN 2013-2017
+ *
+ * Copyright (c) Members of the EMI Collaboration. 2010-2013
+ *  See  http://www.eu-emi.eu/partners for details on the copyright
+ *  holders.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+#ifndef GFAL_METRICS_INTERNAL_H_
+#define GFAL_METRICS_INTERNAL_H_
+
+#include <errno.h>
+#include <glib.h>
+#include "gfal_metrics.h"
+#include "gfal_trace_internal.h"
+
+// Start time of an operation, 0 if metrics are disabled
+gint64 gfal_metrics_start(void);
+
+// Record an operation in the registry, internal
+void gfal_metrics_record(const char* plugin, const char* operation, const char* url,
+        gint64 start, gboolean failed);
+
+// Extract the host[:port] part of the url, empty for local paths
+void gfal_metrics_url_host(const char *url, char *host, size_t host_size);
+
+// Error code of a failed call, 0 if it succeeded
+static inline int gfal_metrics_errcode(const GError* error)
+{
+    if (error == NULL)
+        return 0;
+    return error->code ? error->code : EIO;
+}
+
+// Error code of a failed bulk call: the one of the first error reported, 0 if it succeeded
+static inline int gfal_metrics_errcode_list(int ret, GError** errors, int nbfiles)
+{
+    int i;
+    if (ret >= 0)
+        return 0;
+    for (i = 0; errors && i < nbfiles; ++i) {
+        if (errors[i])
+            return gfal_metrics_errcode(errors[i]);
+    }
+    return EIO;
+}
+
+// Time the plugin call, and record it in the metrics registry and, if enabled, in the trace
+// error is the error code of the call, 0 on success
+// arg is the size for I/O calls, the flags for open, or the number of files for bulk calls
+#define GFAL_METRICS_CALL(plugin, operation, url, call, error, arg) \
+    GFAL_METRICS_CALL_AT(plugin, operation, url, call, error, arg, 0)
+
+// Same as GFAL_METRICS_CALL, for the calls done at a given offset of the file
+#define GFAL_METRICS_CALL_AT(plugin, operation, url, call, error, arg, offset) \
+    do { \
+        gint64 metrics_start = gfal_metrics_start(); \
+        gint64 trace_start = gfal_trace_begin(); \
+        call; \
+        if (metrics_start || trace_start) { \
+            int metrics_errcode = (error); \
+            if (metrics_start) \
+                gfal_metrics_record((plugin)->getName(), (operation), (url), metrics_start, metrics_errcode != 0); \
+            if (trace_start) \
+                gfal_trace_record((operation), (url), trace_start, metrics_errcode, \
+                    (guint64)(arg), (guint64)(offset)); \
+        } \
+    } while (0)
+
+#endif /* GFAL_METRICS_INTERNAL_H_ */
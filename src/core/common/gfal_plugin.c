@@ -31,7 +31,11 @@
 #include "gfal_constants.h"
 #include "gfal_error.h"
 #include "gfal_file_handler_container.h"
+#include "gfal_admission.h"
+#include "gfal_metrics_internal.h"
+#include "gfal_md_cache.h"
 #include <future/glib.h>
+#include <uri/gfal2_uri.h>
 
 #ifndef GFAL_PLUGIN_DIR_DEFAULT
 #error "GFAL_PLUGIN_DIR_DEFAULT should be define at compile time"
@@ -79,6 +83,53 @@ gboolean gfal_plugin_checker_safe(gfal_plugin_interface* cata_list,
         return FALSE;
 }
 
+//
+// Plugin registered from the manifest installed next to its library.
+// The library is only loaded the first time an url with one of its schemes is used
+//
+typedef struct _gfal_lazy_plugin {
+    char* name;
+    char* library;
+    char** schemes;
+    int priority;
+    void* dlhandle; // set once loaded
+} gfal_lazy_plugin;
+
+
+static void gfal_lazy_plugin_free(gpointer data)
+{
+    gfal_lazy_plugin* lazy = (gfal_lazy_plugin*) data;
+    g_free(lazy->name);
+    g_free(lazy->library);
+    g_strfreev(lazy->schemes);
+    g_free(lazy);
+}
+
+
+static void gfal_retired_list_free(gpointer data, gpointer user_data)
+{
+    g_list_free((GList*) data);
+}
+
+
+static gfal_lazy_plugin* gfal_lazy_plugin_dup(const gfal_lazy_plugin* lazy)
+{
+    gfal_lazy_plugin* copy = g_new0(gfal_lazy_plugin, 1);
+    copy->name = g_strdup(lazy->name);
+    copy->library = g_strdup(lazy->library);
+    copy->schemes = g_strdupv(lazy->schemes);
+    copy->priority = lazy->priority;
+    return copy;
+}
+
+
+static gint gfal_lazy_plugin_compare(gconstpointer a, gconstpointer b)
+{
+    const gfal_lazy_plugin* pa = (const gfal_lazy_plugin*) a;
+    const gfal_lazy_plugin* pb = (const gfal_lazy_plugin*) b;
+    return (pa->priority > pb->priority) ? (-1) : (((pa->priority == pb->priority) ? 0 : 1));
+}
+
 //
 // Resolve entry point in a plugin and add it to the current plugin list
 //
@@ -86,7 +137,7 @@ static int gfal_module_init(gfal2_context_t handle, void* dlhandle,
         const char* module_name, GError** err)
 {
     GError* tmp_err = NULL;
-    static gfal_plugin_interface (*constructor)(gfal2_context_t, GError**);
+    gfal_plugin_interface (*constructor)(gfal2_context_t, GError**);
     int* n = &handle->plugin_opt.plugin_number;
     int res = -1;
     constructor = (gfal_plugin_interface (*)(gfal2_context_t, GError**)) dlsym(dlhandle, GFAL_PLUGIN_INIT_SYM);
@@ -94,14 +145,12 @@ static int gfal_module_init(gfal2_context_t handle, void* dlhandle,
         g_set_error(&tmp_err, gfal2_get_plugins_quark(), EINVAL,
                 "No symbol %s found in the plugin %s, failure",
                 GFAL_PLUGIN_INIT_SYM, module_name);
-        *n = 0;
     }
     else {
         handle->plugin_opt.plugin_list[*n] = constructor(handle, &tmp_err);
         handle->plugin_opt.plugin_list[*n].gfal_data = dlhandle;
         if (tmp_err) {
             g_prefix_error(&tmp_err, "Unable to load plugin %s : ", module_name);
-            *n = 0;
         }
         else {
             *n += 1;
@@ -127,6 +176,13 @@ int gfal_plugins_delete(gfal2_context_t handle, GError** err)
 
         handle->plugin_opt.plugin_number = 0;
     }
+    g_list_free_full(handle->plugin_opt.lazy_plugins, gfal_lazy_plugin_free);
+    handle->plugin_opt.lazy_plugins = NULL;
+    g_list_free_full(handle->plugin_opt.loaded_manifests, gfal_lazy_plugin_free);
+    handle->plugin_opt.loaded_manifests = NULL;
+    g_list_foreach(handle->plugin_opt.retired_sorted, gfal_retired_list_free, NULL);
+    g_list_free(handle->plugin_opt.retired_sorted);
+    handle->plugin_opt.retired_sorted = NULL;
     return 0;
 }
 
@@ -140,7 +196,7 @@ gfal_plugin_interface* gfal_plugin_map_file_handle(gfal2_context_t handle, gfal_
     int n = gfal_plugins_instance(handle, &tmp_err);
     if (n > 0) {
         cata_list = handle->plugin_opt.plugin_list;
-        for (i = 0; i < n; ++i) {
+        for (i = 0; i < handle->plugin_opt.plugin_number; ++i) {
             if (strncmp(cata_list[i].getName(), fh->module_name, GFAL_MODULE_NAME_SIZE) == 0)
                 return &(cata_list[i]);
         }
@@ -160,7 +216,8 @@ char** gfal_plugins_get_list(gfal2_context_t handle, GError** err)
     GError* tmp_err = NULL;
     char** resu = NULL;
     int n = gfal_plugins_instance(handle, &tmp_err);
-    if (n > 0) {
+    if (n > 0 && gfal_plugins_load_all(handle, &tmp_err) >= 0) {
+        n = handle->plugin_opt.plugin_number;
         resu = g_new0(char*, n + 1);
         int i;
         gfal_plugin_interface* cata_list = handle->plugin_opt.plugin_list;
@@ -173,6 +230,18 @@ char** gfal_plugins_get_list(gfal2_context_t handle, GError** err)
     return resu;
 }
 
+static gfal_plugin_interface* gfal_search_loaded_plugin(gfal2_context_t handle, const char* name)
+{
+    int i;
+    gfal_plugin_interface* cata_list = handle->plugin_opt.plugin_list;
+    for (i = 0; i < handle->plugin_opt.plugin_number; ++i, ++cata_list) {
+        const char* plugin_name = cata_list->getName();
+        if (plugin_name != NULL && strcmp(plugin_name, name) == 0)
+            return cata_list;
+    }
+    return NULL;
+}
+
 // external function to return a gfal_plugin_interface from a given plugin name
 gfal_plugin_interface* gfal_search_plugin_with_name(gfal2_context_t handle,
         const char* name, GError** err)
@@ -182,16 +251,11 @@ gfal_plugin_interface* gfal_search_plugin_with_name(gfal2_context_t handle,
     gfal_plugin_interface* resu = NULL;
     int n = gfal_plugins_instance(handle, &tmp_err);
     if (n > 0) {
-        int i;
-        gfal_plugin_interface* cata_list = handle->plugin_opt.plugin_list;
-        for (i = 0; i < n; ++i, ++cata_list) {
-            const char* plugin_name = cata_list->getName();
-            if (plugin_name != NULL && strcmp(plugin_name, name) == 0) {
-                resu = cata_list;
-                break;
-            }
-        }
-        if (resu == NULL)
+        resu = gfal_search_loaded_plugin(handle, name);
+        // the manifests do not carry the full plugin name
+        if (resu == NULL && gfal_plugins_load_all(handle, &tmp_err) > 0)
+            resu = gfal_search_loaded_plugin(handle, name);
+        if (resu == NULL && tmp_err == NULL)
             g_set_error(&tmp_err, gfal2_get_plugins_quark(), ENOENT,
                     " No plugin loaded with this name %s", name);
     }
@@ -235,7 +299,7 @@ char ** gfal_list_directory_plugins(const char * dir, GError ** err)
     if (d) {
         gchar * d_name = NULL;
         while ((d_name = (char*) g_dir_read_name(d)) != NULL) {
-            if (strstr(d_name, G_MODULE_SUFFIX) != NULL) {
+            if (strstr(d_name, G_MODULE_SUFFIX) != NULL && !g_str_has_suffix(d_name, GFAL_PLUGIN_MANIFEST_SUFFIX)) {
                 GString * strbuff = g_string_new(dir);
                 n++;
                 if (n == 1) {
@@ -297,17 +361,74 @@ char ** gfal_localize_plugins(GError** err)
 }
 
 
+//
+// Read the manifest installed next to the plugin library, if any
+// Return NULL if there is none or it is not usable, so the plugin is loaded right away
+//
+static gfal_lazy_plugin* gfal_plugin_manifest_load(const char* library)
+{
+    GError* tmp_err = NULL;
+    gfal_lazy_plugin* lazy = NULL;
+    gchar* base = g_strdup(library);
+    if (g_str_has_suffix(base, "." G_MODULE_SUFFIX))
+        base[strlen(base) - strlen("." G_MODULE_SUFFIX)] = '\0';
+    gchar* manifest = g_strconcat(base, GFAL_PLUGIN_MANIFEST_SUFFIX, NULL);
+    g_free(base);
+
+    GKeyFile* keyfile = g_key_file_new();
+    if (!g_key_file_load_from_file(keyfile, manifest, G_KEY_FILE_NONE, &tmp_err)) {
+        if (!g_error_matches(tmp_err, G_FILE_ERROR, G_FILE_ERROR_NOENT))
+            gfal2_log(G_LOG_LEVEL_WARNING, "Ignoring the plugin manifest %s: %s", manifest, tmp_err->message);
+        g_error_free(tmp_err);
+        g_key_file_free(keyfile);
+        g_free(manifest);
+        return NULL;
+    }
+
+    gchar* name = g_key_file_get_string(keyfile, GFAL_PLUGIN_MANIFEST_GROUP, "NAME", NULL);
+    gchar** schemes = g_key_file_get_string_list(keyfile, GFAL_PLUGIN_MANIFEST_GROUP, "SCHEMES", NULL, NULL);
+    if (name && schemes && schemes[0]) {
+        lazy = g_new0(gfal_lazy_plugin, 1);
+        lazy->name = name;
+        lazy->library = g_strdup(library);
+        lazy->schemes = schemes;
+        lazy->priority = g_key_file_get_integer(keyfile, GFAL_PLUGIN_MANIFEST_GROUP, "PRIORITY", NULL);
+    }
+    else {
+        gfal2_log(G_LOG_LEVEL_WARNING, "Ignoring the plugin manifest %s: NAME and SCHEMES are mandatory", manifest);
+        g_free(name);
+        g_strfreev(schemes);
+    }
+
+    g_key_file_free(keyfile);
+    g_free(manifest);
+    return lazy;
+}
+
+
 int gfal_modules_resolve(gfal2_context_t handle, GError** err)
 {
     GError* tmp_err = NULL;
     int res = -1;
     char** tab_args;
+    gboolean lazy_loading = gfal2_get_opt_boolean_with_default(handle, CORE_CONFIG_GROUP,
+            "PLUGIN_LAZY_LOADING", TRUE);
 
     if ((tab_args = gfal_localize_plugins(&tmp_err)) != NULL) {
         char** p = tab_args;
         while (*p != NULL) {
             if (**p == '\0')
                 break;
+            gfal_lazy_plugin* lazy = lazy_loading ? gfal_plugin_manifest_load(*p) : NULL;
+            if (lazy != NULL) {
+                gfal2_log(G_LOG_LEVEL_DEBUG, " gfal_plugin %s registered from its manifest, not loaded yet : %s",
+                        lazy->name, *p);
+                handle->plugin_opt.lazy_plugins = g_list_insert_sorted(handle->plugin_opt.lazy_plugins,
+                        lazy, gfal_lazy_plugin_compare);
+                res = 0;
+                p++;
+                continue;
+            }
             if (gfal_module_load(handle, *p, &tmp_err) != 0) {
                 res = -1;
                 break;
@@ -339,19 +460,20 @@ gint gfal_plugin_compare(gconstpointer a, gconstpointer b)
 //
 int gfal_plugins_sort(gfal2_context_t handle, GError ** err)
 {
-    if (handle->plugin_opt.sorted_plugin) {
-        g_list_free(handle->plugin_opt.sorted_plugin);
-        handle->plugin_opt.sorted_plugin = NULL;
-    }
-
+    GList* sorted = NULL;
     int i;
     for (i = 0; i < handle->plugin_opt.plugin_number; ++i) {
-        handle->plugin_opt.sorted_plugin = g_list_append(
-                handle->plugin_opt.sorted_plugin,
-                &(handle->plugin_opt.plugin_list[i]));
+        sorted = g_list_append(sorted, &(handle->plugin_opt.plugin_list[i]));
     }
-    handle->plugin_opt.sorted_plugin = g_list_sort(
-            handle->plugin_opt.sorted_plugin, &gfal_plugin_compare);
+    sorted = g_list_sort(sorted, &gfal_plugin_compare);
+
+    // Plugins may be loaded while other threads are walking the previous list,
+    // so it is only released with the context
+    if (handle->plugin_opt.sorted_plugin) {
+        handle->plugin_opt.retired_sorted = g_list_prepend(handle->plugin_opt.retired_sorted,
+                handle->plugin_opt.sorted_plugin);
+    }
+    g_atomic_pointer_set(&handle->plugin_opt.sorted_plugin, sorted);
 
     if (gfal2_log_get_level() >= G_LOG_LEVEL_DEBUG) { // print plugin order
         GString* strbuff = g_string_new(" plugin priority order: ");
@@ -378,12 +500,13 @@ int gfal_plugins_instance(gfal2_context_t handle, GError** err)
     g_return_val_err_if_fail(handle, -1, err,
             "[gfal_plugins_instance]  invalid value of handle");
     const int plugin_number = handle->plugin_opt.plugin_number;
-    if (plugin_number <= 0) {
+    if (plugin_number <= 0 && handle->plugin_opt.lazy_plugins == NULL) {
         GError* tmp_err = NULL;
         gfal_modules_resolve(handle, &tmp_err);
         if (tmp_err) {
             gfal2_propagate_prefixed_error(err, tmp_err, __func__);
             handle->plugin_opt.plugin_number = -1;
+            return -1;
         }
         else if (handle->plugin_opt.plugin_number > 0) {
             gfal_plugins_sort(handle, &tmp_err);
@@ -392,9 +515,176 @@ int gfal_plugins_instance(gfal2_context_t handle, GError** err)
                 return -1;
             }
         }
-        return handle->plugin_opt.plugin_number;
     }
-    return plugin_number;
+    return handle->plugin_opt.plugin_number + g_list_length(handle->plugin_opt.lazy_plugins);
+}
+
+
+// Load the given plugins, already removed from the lazy list
+// Must be called with mux_load held
+static int gfal_plugins_load_lazy(gfal2_context_t handle, GList* to_load, GError** err)
+{
+    GError* tmp_err = NULL;
+    int loaded = 0;
+    GList* item;
+
+    for (item = to_load; item != NULL; item = g_list_next(item)) {
+        gfal_lazy_plugin* lazy = (gfal_lazy_plugin*) item->data;
+        const int before = handle->plugin_opt.plugin_number;
+        GError* load_err = NULL;
+        gfal2_log(G_LOG_LEVEL_DEBUG, " loading plugin %s on first use: %s", lazy->name, lazy->library);
+        // A broken plugin must not prevent the others from being used
+        if (gfal_module_load(handle, lazy->library, &load_err) != 0 && load_err != NULL) {
+            gfal2_log(G_LOG_LEVEL_WARNING, "Could not load the plugin %s: %s", lazy->name, load_err->message);
+            if (tmp_err == NULL)
+                tmp_err = load_err;
+            else
+                g_error_free(load_err);
+        }
+        if (handle->plugin_opt.plugin_number > before) {
+            lazy->dlhandle = handle->plugin_opt.plugin_list[before].gfal_data;
+            handle->plugin_opt.loaded_manifests = g_list_prepend(handle->plugin_opt.loaded_manifests, lazy);
+            loaded += 1;
+        }
+        else {
+            gfal_lazy_plugin_free(lazy);
+        }
+    }
+    g_list_free(to_load);
+
+    if (loaded > 0)
+        gfal_plugins_sort(handle, NULL);
+
+    // Only fail if nothing could be loaded, the error has been logged otherwise
+    if (tmp_err && loaded == 0) {
+        gfal2_propagate_prefixed_error(err, tmp_err, __func__);
+        return -1;
+    }
+    g_clear_error(&tmp_err);
+    return loaded;
+}
+
+
+// Scheme of the url, NULL if there is none
+static gchar* gfal_plugin_url_scheme(const char* url)
+{
+    const char* p = url;
+    if (!g_ascii_isalpha(*p))
+        return NULL;
+    while (g_ascii_isalnum(*p) || *p == '+' || *p == '-' || *p == '.')
+        ++p;
+    if (*p != ':')
+        return NULL;
+    return g_ascii_strdown(url, p - url);
+}
+
+
+int gfal_plugins_load_for_url(gfal2_context_t handle, const char* url, GError** err)
+{
+    if (g_atomic_pointer_get(&handle->plugin_opt.lazy_plugins) == NULL)
+        return 0;
+
+    // No plugin claims urls without a scheme, so there is nothing to load
+    gchar* scheme = gfal_plugin_url_scheme(url);
+    if (scheme == NULL)
+        return 0;
+
+    GList* to_load = NULL;
+    g_static_rec_mutex_lock(&handle->plugin_opt.mux_load);
+    GList* item = handle->plugin_opt.lazy_plugins;
+    while (item != NULL) {
+        GList* next = g_list_next(item);
+        gfal_lazy_plugin* lazy = (gfal_lazy_plugin*) item->data;
+        char** s;
+        for (s = lazy->schemes; *s != NULL; ++s) {
+            if (g_ascii_strcasecmp(*s, scheme) == 0) {
+                handle->plugin_opt.lazy_plugins = g_list_remove_link(handle->plugin_opt.lazy_plugins, item);
+                to_load = g_list_concat(to_load, item);
+                break;
+            }
+        }
+        item = next;
+    }
+    int res = gfal_plugins_load_lazy(handle, to_load, err);
+    g_static_rec_mutex_unlock(&handle->plugin_opt.mux_load);
+
+    g_free(scheme);
+    return res;
+}
+
+
+int gfal_plugins_load_all(gfal2_context_t handle, GError** err)
+{
+    if (g_atomic_pointer_get(&handle->plugin_opt.lazy_plugins) == NULL)
+        return 0;
+
+    g_static_rec_mutex_lock(&handle->plugin_opt.mux_load);
+    GList* to_load = handle->plugin_opt.lazy_plugins;
+    handle->plugin_opt.lazy_plugins = NULL;
+    int res = gfal_plugins_load_lazy(handle, to_load, err);
+    g_static_rec_mutex_unlock(&handle->plugin_opt.mux_load);
+    return res;
+}
+
+
+int gfal_plugins_clone(gfal2_context_t dest, gfal2_context_t src, GError** err)
+{
+    GError* tmp_err = NULL;
+    GList* item;
+    int i;
+
+    g_static_rec_mutex_lock(&src->plugin_opt.mux_load);
+
+    // Plugins known from their manifest stay lazy in the clone, loaded or not
+    for (item = src->plugin_opt.lazy_plugins; item != NULL; item = g_list_next(item)) {
+        dest->plugin_opt.lazy_plugins = g_list_insert_sorted(dest->plugin_opt.lazy_plugins,
+                gfal_lazy_plugin_dup(item->data), gfal_lazy_plugin_compare);
+    }
+    for (item = src->plugin_opt.loaded_manifests; item != NULL; item = g_list_next(item)) {
+        dest->plugin_opt.lazy_plugins = g_list_insert_sorted(dest->plugin_opt.lazy_plugins,
+                gfal_lazy_plugin_dup(item->data), gfal_lazy_plugin_compare);
+    }
+
+    // The others are initialized right away from the library already opened,
+    // except for those registered with gfal2_register_plugin, which belong to their caller
+    for (i = 0; i < src->plugin_opt.plugin_number && tmp_err == NULL; ++i) {
+        void* dlhandle = src->plugin_opt.plugin_list[i].gfal_data;
+        gboolean from_manifest = FALSE;
+        if (dlhandle == NULL)
+            continue;
+        for (item = src->plugin_opt.loaded_manifests; item != NULL && !from_manifest; item = g_list_next(item)) {
+            from_manifest = (((gfal_lazy_plugin*) item->data)->dlhandle == dlhandle);
+        }
+        if (!from_manifest)
+            gfal_module_init(dest, dlhandle, src->plugin_opt.plugin_list[i].getName(), &tmp_err);
+    }
+
+    g_static_rec_mutex_unlock(&src->plugin_opt.mux_load);
+
+    if (tmp_err == NULL && dest->plugin_opt.plugin_number > 0)
+        gfal_plugins_sort(dest, &tmp_err);
+
+    if (tmp_err) {
+        gfal2_propagate_prefixed_error(err, tmp_err, __func__);
+        return -1;
+    }
+    return 0;
+}
+
+
+static gfal_plugin_interface* gfal_find_loaded_plugin(gfal2_context_t handle, const char * url,
+        plugin_mode acc_mode, GError** err)
+{
+    GList * plugin_list = g_list_first(g_atomic_pointer_get(&handle->plugin_opt.sorted_plugin));
+    while (plugin_list != NULL) {
+        gfal_plugin_interface* plugin_ifce = plugin_list->data;
+        if (gfal_plugin_checker_safe(plugin_ifce, url, acc_mode, err))
+            return plugin_ifce;
+        if (*err)
+            break;
+        plugin_list = g_list_next(plugin_list);
+    }
+    return NULL;
 }
 
 
@@ -402,19 +692,18 @@ gfal_plugin_interface* gfal_find_plugin(gfal2_context_t handle, const char * url
         plugin_mode acc_mode, GError** err)
 {
     GError* tmp_err = NULL;
-    gboolean compatible = FALSE;
+    gfal_plugin_interface* plugin_ifce = NULL;
     const int n_plugins = gfal_plugins_instance(handle, &tmp_err);
-    if (n_plugins > 0) {
-        GList * plugin_list = g_list_first(handle->plugin_opt.sorted_plugin);
-        while (plugin_list != NULL) {
-            gfal_plugin_interface* plugin_ifce = plugin_list->data;
-            compatible = gfal_plugin_checker_safe(plugin_ifce, url, acc_mode, &tmp_err);
-            if (tmp_err)
-                break;
-            if (compatible)
-                return plugin_ifce;
-            plugin_list = g_list_next(plugin_list);
-        }
+    if (n_plugins > 0 && gfal_plugins_load_for_url(handle, url, &tmp_err) >= 0) {
+        plugin_ifce = gfal_find_loaded_plugin(handle, url, acc_mode, &tmp_err);
+        // Nothing claimed the url: the schemes of the manifests are authoritative,
+        // unless configured to try with every plugin, which loads all of them
+        if (plugin_ifce == NULL && tmp_err == NULL &&
+            gfal2_get_opt_boolean_with_default(handle, CORE_CONFIG_GROUP, "PLUGIN_LAZY_FALLBACK", FALSE) &&
+            gfal_plugins_load_all(handle, &tmp_err) > 0)
+            plugin_ifce = gfal_find_loaded_plugin(handle, url, acc_mode, &tmp_err);
+        if (plugin_ifce)
+            return plugin_ifce;
     }
     if (tmp_err) {
         gfal2_propagate_prefixed_error(err, tmp_err, __func__);
@@ -454,11 +743,20 @@ int gfal_plugins_accessG(gfal2_context_t handle, const char* path, int mode,
     g_return_val_err_if_fail(handle && path, EINVAL, err, "[gfal_plugins_accessG] Invalid arguments");
     int res = -1;
     GError * tmp_err = NULL;
+
+    if (gfal_md_cache_get_access(handle, path, mode))
+        return 0;
+    gint md_generation = gfal_md_cache_generation(handle);
+
     gfal_plugin_interface* p = gfal_find_plugin(handle, path,
             GFAL_PLUGIN_ACCESS, &tmp_err);
 
     if (p)
-        res = p->accessG(gfal_get_plugin_handle(p), path, mode, &tmp_err);
+        GFAL_ADMITTED_CALL(handle, &tmp_err, p, "access", path,
+            res = p->accessG(gfal_get_plugin_handle(p), path, mode, &tmp_err),
+            gfal_metrics_errcode(tmp_err), 0);
+    if (res == 0)
+        gfal_md_cache_put_access(handle, md_generation, path, mode);
 
     G_RETURN_ERR(res, tmp_err, err);
 }
@@ -470,11 +768,19 @@ int gfal_plugin_statG(gfal2_context_t handle, const char* path, struct stat* st,
     int res = -1;
     GError* tmp_err = NULL;
 
+    if (gfal_md_cache_get_stat(handle, path, TRUE, st))
+        return 0;
+    gint md_generation = gfal_md_cache_generation(handle);
+
     gfal_plugin_interface* p = gfal_find_plugin(handle, path, GFAL_PLUGIN_STAT,
             &tmp_err);
 
     if (p)
-        res = p->statG(gfal_get_plugin_handle(p), path, st, &tmp_err);
+        GFAL_ADMITTED_CALL(handle, &tmp_err, p, "stat", path,
+            res = p->statG(gfal_get_plugin_handle(p), path, st, &tmp_err),
+            gfal_metrics_errcode(tmp_err), 0);
+    if (res == 0)
+        gfal_md_cache_put_stat(handle, md_generation, path, TRUE, st);
 
     G_RETURN_ERR(res, tmp_err, err);
 }
@@ -487,16 +793,116 @@ int gfal_plugin_lstatG(gfal2_context_t handle, const char* path, struct stat* st
     int res = -1;
     GError* tmp_err = NULL;
 
+    if (gfal_md_cache_get_stat(handle, path, FALSE, st))
+        return 0;
+    gint md_generation = gfal_md_cache_generation(handle);
+
     gfal_plugin_interface* p = gfal_find_plugin(handle, path, GFAL_PLUGIN_LSTAT,
             &tmp_err);
 
     if (p)
-        res = p->lstatG(gfal_get_plugin_handle(p), path, st, &tmp_err);
+        GFAL_ADMITTED_CALL(handle, &tmp_err, p, "lstat", path,
+            res = p->lstatG(gfal_get_plugin_handle(p), path, st, &tmp_err),
+            gfal_metrics_errcode(tmp_err), 0);
+    if (res == 0)
+        gfal_md_cache_put_stat(handle, md_generation, path, FALSE, st);
 
     G_RETURN_ERR(res, tmp_err, err);
 }
 
 
+// Stat started by a plugin, completed from the thread of the plugin
+typedef struct {
+    gfal2_context_t handle;
+    gfal_plugin_interface* plugin;
+    char* path;
+    struct stat* st;
+    gint md_generation;
+    gfal_admission_t admission_slot;
+    gint64 metrics_start;
+    gint64 trace_start;
+    gfal_plugin_async_notify_t notify;
+    gpointer notify_data;
+} gfal_plugin_async_stat;
+
+
+static void gfal_plugin_async_stat_record(gfal_plugin_async_stat* call, const GError* error)
+{
+    gfal_admission_exit(call->admission_slot);
+    if (call->metrics_start)
+        gfal_metrics_record(call->plugin->getName(), "stat", call->path, call->metrics_start, error != NULL);
+    if (call->trace_start)
+        gfal_trace_record("stat", call->path, call->trace_start, gfal_metrics_errcode(error), 0, 0);
+}
+
+
+static void gfal_plugin_async_stat_done(gpointer data, int result, GError* error)
+{
+    gfal_plugin_async_stat* call = (gfal_plugin_async_stat*) data;
+
+    gfal_plugin_async_stat_record(call, error);
+    if (result == 0)
+        gfal_md_cache_put_stat(call->handle, call->md_generation, call->path, TRUE, call->st);
+    call->notify(call->notify_data, result, error);
+
+    g_free(call->path);
+    g_free(call);
+}
+
+
+//  Start a stat on the appropriate plugin, notify is called once it is done
+//  Fails with ENOSYS if the plugin can only stat with statG
+int gfal_plugin_stat_asyncG(gfal2_context_t handle, const char* path, struct stat* st,
+        gfal_plugin_async_notify_t notify, gpointer notify_data, GError** err)
+{
+    g_return_val_err_if_fail(handle && path && notify, -1, err, "[gfal_plugin_stat_asyncG] Invalid arguments");
+    GError* tmp_err = NULL;
+
+    if (gfal_md_cache_get_stat(handle, path, TRUE, st)) {
+        notify(notify_data, 0, NULL);
+        return 0;
+    }
+
+    gfal_plugin_interface* p = gfal_find_plugin(handle, path, GFAL_PLUGIN_STAT, &tmp_err);
+    if (p && p->stat_asyncG == NULL) {
+        gfal2_set_error(&tmp_err, gfal2_get_plugins_quark(), ENOSYS, __func__,
+                "No asynchronous stat for %s", path);
+    }
+    if (tmp_err) {
+        gfal2_propagate_prefixed_error(err, tmp_err, __func__);
+        return -1;
+    }
+
+    gfal_plugin_async_stat* call = g_new0(gfal_plugin_async_stat, 1);
+    call->handle = handle;
+    call->plugin = p;
+    call->path = g_strdup(path);
+    call->st = st;
+    call->md_generation = gfal_md_cache_generation(handle);
+    call->notify = notify;
+    call->notify_data = notify_data;
+
+    if (gfal_admission_enter(handle, p->getName(), path, &call->admission_slot, &tmp_err) == 0) {
+        // The slot is released by the thread completing the stat
+        gfal_admission_detach(call->admission_slot);
+        call->metrics_start = gfal_metrics_start();
+        call->trace_start = gfal_trace_begin();
+        if (p->stat_asyncG(gfal_get_plugin_handle(p), path, st, gfal_plugin_async_stat_done, call, &tmp_err) == 0)
+            return 0;
+        // Not recorded in the metrics if the stat is left to statG
+        if (tmp_err && tmp_err->code == ENOSYS)
+            gfal_admission_exit(call->admission_slot);
+        else
+            gfal_plugin_async_stat_record(call, tmp_err);
+    }
+
+    g_free(call->path);
+    g_free(call);
+    gfal2_propagate_prefixed_error(err, tmp_err, __func__);
+    return -1;
+}
+
+
 //  Execute a readlink function on the appropriate plugin
 ssize_t gfal_plugin_readlinkG(gfal2_context_t handle, const char* path, char* buff, size_t buffsiz, GError** err)
 {
@@ -509,8 +915,10 @@ ssize_t gfal_plugin_readlinkG(gfal2_context_t handle, const char* path, char* bu
             GFAL_PLUGIN_READLINK, &tmp_err);
 
     if (p)
-        resu = p->readlinkG(gfal_get_plugin_handle(p), path, buff, buffsiz,
-                &tmp_err);
+        GFAL_ADMITTED_CALL(handle, &tmp_err, p, "readlink", path,
+            resu = p->readlinkG(gfal_get_plugin_handle(p), path, buff, buffsiz,
+                    &tmp_err),
+            gfal_metrics_errcode(tmp_err), 0);
 
     G_RETURN_ERR(resu, tmp_err, err);
 }
@@ -527,7 +935,10 @@ int gfal_plugin_chmodG(gfal2_context_t handle, const char* path, mode_t mode, GE
     gfal_plugin_interface* p = gfal_find_plugin(handle, path, GFAL_PLUGIN_CHMOD, &tmp_err);
 
     if (p)
-        res = p->chmodG(gfal_get_plugin_handle(p), path, mode, &tmp_err);
+        GFAL_ADMITTED_CALL(handle, &tmp_err, p, "chmod", path,
+            res = p->chmodG(gfal_get_plugin_handle(p), path, mode, &tmp_err),
+            gfal_metrics_errcode(tmp_err), 0);
+    gfal_md_cache_invalidate(handle, path);
 
     G_RETURN_ERR(res, tmp_err, err);
 }
@@ -545,7 +956,11 @@ int gfal_plugin_renameG(gfal2_context_t handle, const char* oldpath, const char*
     if (src_p) {
         dst_p = gfal_find_plugin(handle, newpath, GFAL_PLUGIN_RENAME, &tmp_err);
         if (src_p == dst_p)
-            res = dst_p->renameG(gfal_get_plugin_handle(dst_p), oldpath, newpath, &tmp_err);
+            GFAL_ADMITTED_CALL(handle, &tmp_err, dst_p, "rename", oldpath,
+                res = dst_p->renameG(gfal_get_plugin_handle(dst_p), oldpath, newpath, &tmp_err),
+                gfal_metrics_errcode(tmp_err), 0);
+        gfal_md_cache_invalidate_tree(handle, oldpath);
+        gfal_md_cache_invalidate_tree(handle, newpath);
     }
 
     G_RETURN_ERR(res, tmp_err, err);
@@ -563,7 +978,10 @@ int gfal_plugin_symlinkG(gfal2_context_t handle, const char* oldpath, const char
     if (src_p) {
         dst_p = gfal_find_plugin(handle, newpath, GFAL_PLUGIN_SYMLINK, &tmp_err);
         if (src_p == dst_p)
-            res = dst_p->symlinkG(gfal_get_plugin_handle(dst_p), oldpath, newpath, &tmp_err);
+            GFAL_ADMITTED_CALL(handle, &tmp_err, dst_p, "symlink", oldpath,
+                res = dst_p->symlinkG(gfal_get_plugin_handle(dst_p), oldpath, newpath, &tmp_err),
+                gfal_metrics_errcode(tmp_err), 0);
+        gfal_md_cache_invalidate(handle, newpath);
     }
 
     G_RETURN_ERR(res, tmp_err, err);
@@ -579,7 +997,10 @@ int gfal_plugin_mkdirp(gfal2_context_t handle, const char* path, mode_t mode, gb
     gfal_plugin_interface* p = gfal_find_plugin(handle, path, GFAL_PLUGIN_MKDIR, &tmp_err);
 
     if (p)
-        res = p->mkdirpG(gfal_get_plugin_handle(p), path, mode, pflag, &tmp_err);
+        GFAL_ADMITTED_CALL(handle, &tmp_err, p, "mkdir", path,
+            res = p->mkdirpG(gfal_get_plugin_handle(p), path, mode, pflag, &tmp_err),
+            gfal_metrics_errcode(tmp_err), 0);
+    gfal_md_cache_invalidate(handle, path);
 
     if (pflag && res < 0 && tmp_err->code == EEXIST) {
         g_error_free(tmp_err);
@@ -599,7 +1020,10 @@ int gfal_plugin_rmdirG(gfal2_context_t handle, const char* path, GError** err)
     gfal_plugin_interface* p = gfal_find_plugin(handle, path, GFAL_PLUGIN_RMDIR, &tmp_err);
 
     if (p)
-        res = p->rmdirG(gfal_get_plugin_handle(p), path, &tmp_err);
+        GFAL_ADMITTED_CALL(handle, &tmp_err, p, "rmdir", path,
+            res = p->rmdirG(gfal_get_plugin_handle(p), path, &tmp_err),
+            gfal_metrics_errcode(tmp_err), 0);
+    gfal_md_cache_invalidate_tree(handle, path);
 
     G_RETURN_ERR(res, tmp_err, err);
 }
@@ -614,7 +1038,9 @@ gfal_file_handle gfal_plugin_opendirG(gfal2_context_t handle, const char* name,
     gfal_plugin_interface* p = gfal_find_plugin(handle, name, GFAL_PLUGIN_OPENDIR, &tmp_err);
 
     if (p)
-        resu = p->opendirG(gfal_get_plugin_handle(p), name, &tmp_err);
+        GFAL_ADMITTED_CALL(handle, &tmp_err, p, "opendir", name,
+            resu = p->opendirG(gfal_get_plugin_handle(p), name, &tmp_err),
+            gfal_metrics_errcode(tmp_err), 0);
 
     G_RETURN_ERR(resu, tmp_err, err);
 }
@@ -627,7 +1053,9 @@ int gfal_plugin_closedirG(gfal2_context_t handle, gfal_file_handle fh, GError**
     int res = -1;
     gfal_plugin_interface* if_cata = gfal_plugin_map_file_handle(handle, fh, &tmp_err);
     if (!tmp_err)
-        res = if_cata->closedirG(if_cata->plugin_data, fh, &tmp_err);
+        GFAL_METRICS_CALL(if_cata, "closedir", fh->path,
+            res = if_cata->closedirG(if_cata->plugin_data, fh, &tmp_err),
+            gfal_metrics_errcode(tmp_err), 0);
     G_RETURN_ERR(res, tmp_err, err);
 }
 
@@ -641,7 +1069,11 @@ gfal_file_handle gfal_plugin_openG(gfal2_context_t handle, const char * path, in
     gfal_plugin_interface* p = gfal_find_plugin(handle, path, GFAL_PLUGIN_OPEN, &tmp_err);
 
     if (p)
-        resu = p->openG(gfal_get_plugin_handle(p), path, flag, mode, &tmp_err);
+        GFAL_ADMITTED_CALL(handle, &tmp_err, p, "open", path,
+            resu = p->openG(gfal_get_plugin_handle(p), path, flag, mode, &tmp_err),
+            gfal_metrics_errcode(tmp_err), flag);
+    if (resu && (flag & (O_WRONLY | O_RDWR | O_CREAT | O_TRUNC | O_APPEND)))
+        gfal_md_cache_open_for_write(handle, resu, path);
 
     G_RETURN_ERR(resu, tmp_err, err);
 }
@@ -657,7 +1089,10 @@ int gfal_plugin_closeG(gfal2_context_t handle, gfal_file_handle fh, GError** err
 
     gfal_plugin_interface* if_cata = gfal_plugin_map_file_handle(handle, fh, &tmp_err);
     if (!tmp_err)
-        res = if_cata->closeG(if_cata->plugin_data, fh, &tmp_err);
+        GFAL_METRICS_CALL(if_cata, "close", fh->path,
+            res = if_cata->closeG(if_cata->plugin_data, fh, &tmp_err),
+            gfal_metrics_errcode(tmp_err), 0);
+    gfal_md_cache_close(handle, fh);
 
     G_RETURN_ERR(res, tmp_err, err);
 }
@@ -670,12 +1105,53 @@ struct dirent* gfal_plugin_readdirG(gfal2_context_t handle, gfal_file_handle fh,
     struct dirent* res = NULL;
     gfal_plugin_interface* if_cata = gfal_plugin_map_file_handle(handle, fh, &tmp_err);
     if (!tmp_err)
-        res = if_cata->readdirG(if_cata->plugin_data, fh, &tmp_err);
+        GFAL_METRICS_CALL(if_cata, "readdir", fh->path,
+            res = if_cata->readdirG(if_cata->plugin_data, fh, &tmp_err),
+            gfal_metrics_errcode(tmp_err), 0);
 
     G_RETURN_ERR(res, tmp_err, err);
 }
 
 
+// Url of the entry name of the directory dir
+static gchar* gfal_plugin_child_url(const char* dir, const char* name)
+{
+    // The name goes into the path, before the query and the fragment of the directory, if any
+    if (strpbrk(dir, "?#") != NULL) {
+        gfal2_uri* parsed = gfal2_parse_uri(dir, NULL);
+        if (parsed && parsed->path) {
+            size_t path_len = strlen(parsed->path);
+            const char* sep = (path_len > 0 && parsed->path[path_len - 1] == '/') ? "" : "/";
+            gchar* path = g_strconcat(parsed->path, sep, name, NULL);
+            g_free(parsed->path);
+            parsed->path = path;
+            gchar* url = gfal2_join_uri(parsed);
+            gfal2_free_uri(parsed);
+            return url;
+        }
+        gfal2_free_uri(parsed);
+        return NULL;
+    }
+
+    size_t dir_len = strlen(dir);
+    const char* sep = (dir_len > 0 && dir[dir_len - 1] == '/') ? "" : "/";
+    return g_strconcat(dir, sep, name, NULL);
+}
+
+// Keep the stat of a listed entry, so a listing followed by a stat of each entry costs one request
+static void gfal_plugin_readdirpp_cache(gfal2_context_t handle, gint generation, gfal_file_handle fh,
+        const struct dirent* entry, const struct stat* st)
+{
+    if (fh->path == NULL || strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0)
+        return;
+
+    gchar* url = gfal_plugin_child_url(fh->path, entry->d_name);
+    if (url)
+        gfal_md_cache_put_stat(handle, generation, url, TRUE, st);
+    g_free(url);
+}
+
+
 // Execute a readdir function on the appropriate plugin
 struct dirent* gfal_plugin_readdirppG(gfal2_context_t handle, gfal_file_handle fh, struct stat* st, GError** err)
 {
@@ -685,9 +1161,38 @@ struct dirent* gfal_plugin_readdirppG(gfal2_context_t handle, gfal_file_handle f
     gfal_plugin_interface* if_cata = gfal_plugin_map_file_handle(handle, fh, &tmp_err);
 
     if (!tmp_err) {
+        gint md_generation = gfal_md_cache_generation(handle);
         if (gfal_feature_is_supported(if_cata->readdirppG, g_quark_from_string(GFAL2_PLUGIN_SCOPE), __func__,
             fh->path, &tmp_err))
-            res = if_cata->readdirppG(if_cata->plugin_data, fh, st, &tmp_err);
+            GFAL_METRICS_CALL(if_cata, "readdirpp", fh->path,
+                res = if_cata->readdirppG(if_cata->plugin_data, fh, st, &tmp_err),
+                gfal_metrics_errcode(tmp_err), 0);
+        if (res && st)
+            gfal_plugin_readdirpp_cache(handle, md_generation, fh, res, st);
+    }
+
+    G_RETURN_ERR(res, tmp_err, err);
+}
+
+// Execute a readdir_batch function on the appropriate plugin
+ssize_t gfal_plugin_readdir_batchG(gfal2_context_t handle, gfal_file_handle fh,
+        gfal2_dir_entry_t* entries, size_t nentries, GError** err)
+{
+    g_return_val_err_if_fail(handle && fh && entries, -1, err, "[gfal_plugin_readdir_batchG] Invalid args ");
+    GError* tmp_err = NULL;
+    ssize_t res = -1;
+    ssize_t i;
+    gfal_plugin_interface* if_cata = gfal_plugin_map_file_handle(handle, fh, &tmp_err);
+
+    if (!tmp_err) {
+        gint md_generation = gfal_md_cache_generation(handle);
+        if (gfal_feature_is_supported(if_cata->readdir_batchG, g_quark_from_string(GFAL2_PLUGIN_SCOPE), __func__,
+            fh->path, &tmp_err))
+            GFAL_METRICS_CALL(if_cata, "readdir_batch", fh->path,
+                res = if_cata->readdir_batchG(if_cata->plugin_data, fh, entries, nentries, &tmp_err),
+                gfal_metrics_errcode(tmp_err), nentries);
+        for (i = 0; i < res; ++i)
+            gfal_plugin_readdirpp_cache(handle, md_generation, fh, &entries[i].dirent, &entries[i].st);
     }
 
     G_RETURN_ERR(res, tmp_err, err);
@@ -697,12 +1202,18 @@ struct dirent* gfal_plugin_readdirppG(gfal2_context_t handle, gfal_file_handle f
 ssize_t gfal_plugin_getxattrG(gfal2_context_t handle, const char* path, const char*name, void* buff, size_t s_buff, GError** err)
 {
     GError* tmp_err = NULL;
-    ssize_t resu = -1;
+    ssize_t resu = gfal_md_cache_get_xattr(handle, path, name, buff, s_buff);
+
+    if (resu >= 0)
+        return resu;
+    gint md_generation = gfal_md_cache_generation(handle);
 
     gfal_plugin_interface* p = gfal_find_plugin(handle, path, GFAL_PLUGIN_GETXATTR, &tmp_err);
 
     if (p)
-        resu = p->getxattrG(gfal_get_plugin_handle(p), path, name, buff, s_buff, &tmp_err);
+        GFAL_ADMITTED_CALL(handle, &tmp_err, p, "getxattr", path,
+            resu = p->getxattrG(gfal_get_plugin_handle(p), path, name, buff, s_buff, &tmp_err),
+            gfal_metrics_errcode(tmp_err), 0);
 
     // If asking for checksum, and got an error, try ourselves
     if (resu < 0 && tmp_err) {
@@ -718,6 +1229,8 @@ ssize_t gfal_plugin_getxattrG(gfal2_context_t handle, const char* path, const ch
             resu = gfal2_checksum(handle, path, chk_type, 0, 0, buff, s_buff, &tmp_err);
         }
     }
+    if (resu >= 0 && s_buff > 0 && (size_t)resu <= s_buff)
+        gfal_md_cache_put_xattr(handle, md_generation, path, name, buff, resu);
 
     G_RETURN_ERR(resu, tmp_err, err);
 }
@@ -731,7 +1244,9 @@ ssize_t gfal_plugin_listxattrG(gfal2_context_t handle, const char* path, char* l
     gfal_plugin_interface* p = gfal_find_plugin(handle, path, GFAL_PLUGIN_LISTXATTR, &tmp_err);
 
     if (p)
-        resu = p->listxattrG(gfal_get_plugin_handle(p), path, list, s_list, &tmp_err);
+        GFAL_ADMITTED_CALL(handle, &tmp_err, p, "listxattr", path,
+            resu = p->listxattrG(gfal_get_plugin_handle(p), path, list, s_list, &tmp_err),
+            gfal_metrics_errcode(tmp_err), 0);
 
     G_RETURN_ERR(resu, tmp_err, err);
 }
@@ -745,7 +1260,10 @@ int gfal_plugin_setxattrG(gfal2_context_t handle, const char* path, const char*
     gfal_plugin_interface* p = gfal_find_plugin(handle, path, GFAL_PLUGIN_SETXATTR, &tmp_err);
 
     if (p)
-        resu = p->setxattrG(gfal_get_plugin_handle(p), path, name, value, size, flags, &tmp_err);
+        GFAL_ADMITTED_CALL(handle, &tmp_err, p, "setxattr", path,
+            resu = p->setxattrG(gfal_get_plugin_handle(p), path, name, value, size, flags, &tmp_err),
+            gfal_metrics_errcode(tmp_err), 0);
+    gfal_md_cache_invalidate(handle, path);
     G_RETURN_ERR(resu, tmp_err, err);
 }
 
@@ -757,7 +1275,9 @@ int gfal_plugin_readG(gfal2_context_t handle, gfal_file_handle fh, void* buff, s
     int res = -1;
     gfal_plugin_interface* if_cata = gfal_plugin_map_file_handle(handle, fh, &tmp_err);
     if (!tmp_err)
-        res = if_cata->readG(if_cata->plugin_data, fh, buff, s_buff, &tmp_err);
+        GFAL_METRICS_CALL(if_cata, "read", fh->path,
+            res = if_cata->readG(if_cata->plugin_data, fh, buff, s_buff, &tmp_err),
+            gfal_metrics_errcode(tmp_err), s_buff);
     G_RETURN_ERR(res, tmp_err, err);
 }
 
@@ -792,7 +1312,9 @@ ssize_t gfal_plugin_preadG(gfal2_context_t handle, gfal_file_handle fh, void* bu
     gfal_plugin_interface* if_cata = gfal_plugin_map_file_handle(handle, fh, &tmp_err);
     if (!tmp_err) {
         if (if_cata->preadG)
-            res = if_cata->preadG(if_cata->plugin_data, fh, buff, s_buff, offset, &tmp_err);
+            GFAL_METRICS_CALL_AT(if_cata, "pread", fh->path,
+                res = if_cata->preadG(if_cata->plugin_data, fh, buff, s_buff, offset, &tmp_err),
+                gfal_metrics_errcode(tmp_err), s_buff, offset);
         else {
             res = gfal_plugin_simulate_preadG(handle, if_cata, fh, buff, s_buff, offset, &tmp_err);
         }
@@ -831,7 +1353,9 @@ ssize_t gfal_plugin_pwriteG(gfal2_context_t handle, gfal_file_handle fh, void* b
     gfal_plugin_interface* if_cata = gfal_plugin_map_file_handle(handle, fh, &tmp_err);
     if (!tmp_err) {
         if (if_cata->pwriteG)
-            res = if_cata->pwriteG(if_cata->plugin_data, fh, buff, s_buff, offset, &tmp_err);
+            GFAL_METRICS_CALL_AT(if_cata, "pwrite", fh->path,
+                res = if_cata->pwriteG(if_cata->plugin_data, fh, buff, s_buff, offset, &tmp_err),
+                gfal_metrics_errcode(tmp_err), s_buff, offset);
         else {
             res = gfal_plugin_simulate_pwriteG(handle, if_cata, fh, buff, s_buff, offset, &tmp_err);
         }
@@ -860,7 +1384,9 @@ int gfal_plugin_writeG(gfal2_context_t handle, gfal_file_handle fh, void* buff,
     int res = -1;
     gfal_plugin_interface* if_cata = gfal_plugin_map_file_handle(handle, fh, &tmp_err);
     if (!tmp_err)
-        res = if_cata->writeG(if_cata->plugin_data, fh, buff, s_buff, &tmp_err);
+        GFAL_METRICS_CALL(if_cata, "write", fh->path,
+            res = if_cata->writeG(if_cata->plugin_data, fh, buff, s_buff, &tmp_err),
+            gfal_metrics_errcode(tmp_err), s_buff);
     G_RETURN_ERR(res, tmp_err, err);
 }
 
@@ -872,7 +1398,10 @@ int gfal_plugin_unlinkG(gfal2_context_t handle, const char* path, GError** err)
     gfal_plugin_interface* p = gfal_find_plugin(handle, path, GFAL_PLUGIN_UNLINK, &tmp_err);
 
     if (p)
-        resu = p->unlinkG(gfal_get_plugin_handle(p), path, &tmp_err);
+        GFAL_ADMITTED_CALL(handle, &tmp_err, p, "unlink", path,
+            resu = p->unlinkG(gfal_get_plugin_handle(p), path, &tmp_err),
+            gfal_metrics_errcode(tmp_err), 0);
+    gfal_md_cache_invalidate(handle, path);
     G_RETURN_ERR(resu, tmp_err, err);
 
 }
@@ -886,8 +1415,11 @@ int gfal_plugin_bring_onlineG(gfal2_context_t handle, const char* uri, time_t pi
     gfal_plugin_interface* p = gfal_find_plugin(handle, uri, GFAL_PLUGIN_BRING_ONLINE, &tmp_err);
 
     if (p)
-        resu = p->bring_online(gfal_get_plugin_handle(p), uri, pintime, timeout, token, tsize,
-                async, &tmp_err);
+        GFAL_ADMITTED_CALL(handle, &tmp_err, p, "bring_online", uri,
+            resu = p->bring_online(gfal_get_plugin_handle(p), uri, pintime, timeout, token, tsize,
+                    async, &tmp_err),
+            gfal_metrics_errcode(tmp_err), 0);
+    gfal_md_cache_invalidate(handle, uri);
     G_RETURN_ERR(resu, tmp_err, err);
 }
 
@@ -900,8 +1432,11 @@ int gfal_plugin_bring_online_v2G(gfal2_context_t handle, const char* uri, const
     gfal_plugin_interface* p = gfal_find_plugin(handle, uri, GFAL_PLUGIN_BRING_ONLINE, &tmp_err);
 
     if (p)
-        resu = p->bring_online_v2(gfal_get_plugin_handle(p), uri, metadata, pintime, timeout, token, tsize,
-                async, &tmp_err);
+        GFAL_ADMITTED_CALL(handle, &tmp_err, p, "bring_online", uri,
+            resu = p->bring_online_v2(gfal_get_plugin_handle(p), uri, metadata, pintime, timeout, token, tsize,
+                    async, &tmp_err),
+            gfal_metrics_errcode(tmp_err), 0);
+    gfal_md_cache_invalidate(handle, uri);
     G_RETURN_ERR(resu, tmp_err, err);
 }
 
@@ -914,7 +1449,9 @@ ssize_t gfal_plugin_qos_check_classes(gfal2_context_t handle, const char* url, c
     ssize_t res = -1;
     gfal_plugin_interface* p = gfal_find_plugin(handle, url, GFAL_PLUGIN_QOS_CHECK_CLASSES, &tmp_err);
     if (p)
-      res = p->check_qos_classes(gfal_get_plugin_handle(p), url, type, buff, s_buff, &tmp_err);
+      GFAL_ADMITTED_CALL(handle, &tmp_err, p, "check_qos_classes", url,
+          res = p->check_qos_classes(gfal_get_plugin_handle(p), url, type, buff, s_buff, &tmp_err),
+          gfal_metrics_errcode(tmp_err), 0);
     G_RETURN_ERR(res, tmp_err, err);
 }
 
@@ -925,7 +1462,9 @@ ssize_t gfal_plugin_check_file_qos(gfal2_context_t handle, const char* url, char
     ssize_t res = -1;
     gfal_plugin_interface* p = gfal_find_plugin(handle, url, GFAL_PLUGIN_CHECK_FILE_QOS, &tmp_err);
     if (p)
-      res = p->check_file_qos(gfal_get_plugin_handle(p), url, buff, s_buff, &tmp_err);
+      GFAL_ADMITTED_CALL(handle, &tmp_err, p, "check_file_qos", url,
+          res = p->check_file_qos(gfal_get_plugin_handle(p), url, buff, s_buff, &tmp_err),
+          gfal_metrics_errcode(tmp_err), 0);
     G_RETURN_ERR(res, tmp_err, err);
 }
 
@@ -937,7 +1476,9 @@ ssize_t gfal_plugin_check_qos_available_transitions(gfal2_context_t handle, cons
     ssize_t res = -1;
     gfal_plugin_interface* p = gfal_find_plugin(handle, qos_class_url, GFAL_PLUGIN_CHECK_QOS_AVAILABLE_TRANSITIONS, &tmp_err);
     if (p)
-      res = p->check_qos_available_transitions(gfal_get_plugin_handle(p), qos_class_url, buff, s_buff, &tmp_err);
+      GFAL_ADMITTED_CALL(handle, &tmp_err, p, "check_qos_available_transitions", qos_class_url,
+          res = p->check_qos_available_transitions(gfal_get_plugin_handle(p), qos_class_url, buff, s_buff, &tmp_err),
+          gfal_metrics_errcode(tmp_err), 0);
     G_RETURN_ERR(res, tmp_err, err);
 }
 
@@ -948,7 +1489,9 @@ ssize_t gfal_plugin_check_target_qos(gfal2_context_t handle, const char* url, ch
     ssize_t res = -1;
     gfal_plugin_interface* p = gfal_find_plugin(handle, url, GFAL_PLUGIN_CHECK_TARGET_QOS, &tmp_err);
     if (p)
-      res = p->check_target_qos(gfal_get_plugin_handle(p), url, buff, s_buff, &tmp_err);
+      GFAL_ADMITTED_CALL(handle, &tmp_err, p, "check_target_qos", url,
+          res = p->check_target_qos(gfal_get_plugin_handle(p), url, buff, s_buff, &tmp_err),
+          gfal_metrics_errcode(tmp_err), 0);
     G_RETURN_ERR(res, tmp_err, err);
 }
 
@@ -959,7 +1502,10 @@ int gfal_plugin_change_object_qos(gfal2_context_t handle, const char* url, const
     int res = -1;
     gfal_plugin_interface* p = gfal_find_plugin(handle, url, GFAL_PLUGIN_CHANGE_OBJECT_QOS, &tmp_err);
     if (p)
-      res = p->change_object_qos(gfal_get_plugin_handle(p), url, target_qos, &tmp_err);
+      GFAL_ADMITTED_CALL(handle, &tmp_err, p, "change_object_qos", url,
+          res = p->change_object_qos(gfal_get_plugin_handle(p), url, target_qos, &tmp_err),
+          gfal_metrics_errcode(tmp_err), 0);
+    gfal_md_cache_invalidate(handle, url);
     G_RETURN_ERR(res, tmp_err, err);
 }
 
@@ -971,7 +1517,10 @@ int gfal_plugin_bring_online_pollG(gfal2_context_t handle, const char* uri, cons
     gfal_plugin_interface* p = gfal_find_plugin(handle, uri, GFAL_PLUGIN_BRING_ONLINE, &tmp_err);
 
     if (p)
-        resu = p->bring_online_poll(gfal_get_plugin_handle(p), uri, token, &tmp_err);
+        GFAL_ADMITTED_CALL(handle, &tmp_err, p, "bring_online_poll", uri,
+            resu = p->bring_online_poll(gfal_get_plugin_handle(p), uri, token, &tmp_err),
+            gfal_metrics_errcode(tmp_err), 0);
+    gfal_md_cache_invalidate(handle, uri);
     G_RETURN_ERR(resu, tmp_err, err);
 }
 
@@ -984,7 +1533,10 @@ int gfal_plugin_release_fileG(gfal2_context_t handle, const char* uri, const cha
     gfal_plugin_interface* p = gfal_find_plugin(handle, uri, GFAL_PLUGIN_BRING_ONLINE, &tmp_err);
 
     if (p)
-        resu = p->release_file(gfal_get_plugin_handle(p), uri, token, &tmp_err);
+        GFAL_ADMITTED_CALL(handle, &tmp_err, p, "release_file", uri,
+            resu = p->release_file(gfal_get_plugin_handle(p), uri, token, &tmp_err),
+            gfal_metrics_errcode(tmp_err), 0);
+    gfal_md_cache_invalidate(handle, uri);
     G_RETURN_ERR(resu, tmp_err, err);
 }
 
@@ -997,8 +1549,10 @@ int gfal_plugin_bring_online_listG(gfal2_context_t handle, int nbfiles, const ch
     gfal_plugin_interface* p = gfal_find_plugin(handle, *uris, GFAL_PLUGIN_BRING_ONLINE, &tmp_err);
 
     if (p && p->bring_online_list) {
-        resu = p->bring_online_list(gfal_get_plugin_handle(p), nbfiles, uris, pintime, timeout,
-                token, tsize, async, errors);
+        GFAL_ADMITTED_LIST_CALL(handle, nbfiles, errors, p, "bring_online_list", *uris,
+            resu = p->bring_online_list(gfal_get_plugin_handle(p), nbfiles, uris, pintime, timeout,
+                    token, tsize, async, errors),
+            gfal_metrics_errcode_list(resu, errors, nbfiles), nbfiles);
     }
     else {
         if (p && !p->bring_online_list) {
@@ -1011,6 +1565,7 @@ int gfal_plugin_bring_online_listG(gfal2_context_t handle, int nbfiles, const ch
         }
         g_error_free(tmp_err);
     }
+    gfal_md_cache_invalidate_list(handle, nbfiles, uris);
     return resu;
 }
 
@@ -1023,8 +1578,10 @@ int gfal_plugin_bring_online_list_v2G(gfal2_context_t handle, int nbfiles, const
     gfal_plugin_interface* p = gfal_find_plugin(handle, *uris, GFAL_PLUGIN_BRING_ONLINE, &tmp_err);
 
     if (p && p->bring_online_list_v2) {
-        resu = p->bring_online_list_v2(gfal_get_plugin_handle(p), nbfiles, uris, metadata, pintime, timeout,
-                token, tsize, async, errors);
+        GFAL_ADMITTED_LIST_CALL(handle, nbfiles, errors, p, "bring_online_list", *uris,
+            resu = p->bring_online_list_v2(gfal_get_plugin_handle(p), nbfiles, uris, metadata, pintime, timeout,
+                    token, tsize, async, errors),
+            gfal_metrics_errcode_list(resu, errors, nbfiles), nbfiles);
     }
     else {
         if (p && !p->bring_online_list) {
@@ -1037,6 +1594,7 @@ int gfal_plugin_bring_online_list_v2G(gfal2_context_t handle, int nbfiles, const
         }
         g_error_free(tmp_err);
     }
+    gfal_md_cache_invalidate_list(handle, nbfiles, uris);
     return resu;
 }
 
@@ -1049,7 +1607,9 @@ int gfal_plugin_bring_online_poll_listG(gfal2_context_t handle, int nbfiles, con
     gfal_plugin_interface* p = gfal_find_plugin(handle, *uris, GFAL_PLUGIN_BRING_ONLINE, &tmp_err);
 
     if (p && p->bring_online_poll_list) {
-        resu = p->bring_online_poll_list(gfal_get_plugin_handle(p), nbfiles, uris, token, errors);
+        GFAL_ADMITTED_LIST_CALL(handle, nbfiles, errors, p, "bring_online_poll_list", *uris,
+            resu = p->bring_online_poll_list(gfal_get_plugin_handle(p), nbfiles, uris, token, errors),
+            gfal_metrics_errcode_list(resu, errors, nbfiles), nbfiles);
     }
     else {
         if (p && !p->bring_online_poll_list) {
@@ -1062,6 +1622,7 @@ int gfal_plugin_bring_online_poll_listG(gfal2_context_t handle, int nbfiles, con
         }
         g_error_free(tmp_err);
     }
+    gfal_md_cache_invalidate_list(handle, nbfiles, uris);
     return resu;
 }
 
@@ -1074,7 +1635,9 @@ int gfal_plugin_release_file_listG(gfal2_context_t handle, int nbfiles, const ch
     gfal_plugin_interface* p = gfal_find_plugin(handle, *uris, GFAL_PLUGIN_BRING_ONLINE, &tmp_err);
 
     if (p && p->release_file_list) {
-        resu = p->release_file_list(gfal_get_plugin_handle(p), nbfiles, uris, token, errors);
+        GFAL_ADMITTED_LIST_CALL(handle, nbfiles, errors, p, "release_file_list", *uris,
+            resu = p->release_file_list(gfal_get_plugin_handle(p), nbfiles, uris, token, errors),
+            gfal_metrics_errcode_list(resu, errors, nbfiles), nbfiles);
     }
     else {
         if (p && !p->release_file_list) {
@@ -1087,6 +1650,7 @@ int gfal_plugin_release_file_listG(gfal2_context_t handle, int nbfiles, const ch
         }
         g_error_free(tmp_err);
     }
+    gfal_md_cache_invalidate_list(handle, nbfiles, uris);
     return resu;
 }
 
@@ -1098,16 +1662,22 @@ int gfal_plugin_unlink_listG(gfal2_context_t handle, int nbfiles, const char* co
     gfal_plugin_interface* p = gfal_find_plugin(handle, *uris, GFAL_PLUGIN_UNLINK, &tmp_err);
 
     if (p) {
-        plugin_handle handle = gfal_get_plugin_handle(p);
+        plugin_handle plugin_data = gfal_get_plugin_handle(p);
         if (p->unlink_listG) {
-            resu = p->unlink_listG(handle, nbfiles, uris, errors);
+            GFAL_ADMITTED_LIST_CALL(handle, nbfiles, errors, p, "unlink_list", *uris,
+                resu = p->unlink_listG(plugin_data, nbfiles, uris, errors),
+                gfal_metrics_errcode_list(resu, errors, nbfiles), nbfiles);
         }
-        // Fallback
+        // Fallback, each call is admitted on its own
         else {
             int i;
             resu = 0;
             for (i = 0; i < nbfiles; ++i) {
-                resu += p->unlinkG(handle, uris[i], &(errors[i]));
+                int file_resu = -1;
+                GFAL_ADMITTED_CALL(handle, &(errors[i]), p, "unlink", uris[i],
+                    file_resu = p->unlinkG(plugin_data, uris[i], &(errors[i])),
+                    gfal_metrics_errcode(errors[i]), 0);
+                resu += file_resu;
             }
         }
     }
@@ -1119,6 +1689,7 @@ int gfal_plugin_unlink_listG(gfal2_context_t handle, int nbfiles, const char* co
         g_error_free(tmp_err);
     }
 
+    gfal_md_cache_invalidate_list(handle, nbfiles, uris);
     return resu;
 }
 
@@ -1131,8 +1702,10 @@ int gfal_plugin_abort_filesG(gfal2_context_t handle, int nbfiles,
     gfal_plugin_interface* p = gfal_find_plugin(handle, *uris, GFAL_PLUGIN_BRING_ONLINE, &tmp_err);
 
     if (p) {
-        plugin_handle handle = gfal_get_plugin_handle(p);
-        resu = p->abort_files(handle, nbfiles, uris, token, errors);
+        plugin_handle plugin_data = gfal_get_plugin_handle(p);
+        GFAL_ADMITTED_LIST_CALL(handle, nbfiles, errors, p, "abort_files", *uris,
+            resu = p->abort_files(plugin_data, nbfiles, uris, token, errors),
+            gfal_metrics_errcode_list(resu, errors, nbfiles), nbfiles);
     }
     else {
         int i;
@@ -1141,6 +1714,7 @@ int gfal_plugin_abort_filesG(gfal2_context_t handle, int nbfiles,
         }
         g_error_free(tmp_err);
     }
+    gfal_md_cache_invalidate_list(handle, nbfiles, uris);
     return resu;
 }
 
@@ -1152,7 +1726,9 @@ int gfal_plugin_archive_pollG(gfal2_context_t handle, const char* uri, GError **
     gfal_plugin_interface* p = gfal_find_plugin(handle, uri, GFAL_PLUGIN_ARCHIVE, &tmp_err);
 
     if (p)
-        resu = p->archive_poll(gfal_get_plugin_handle(p), uri, &tmp_err);
+        GFAL_ADMITTED_CALL(handle, &tmp_err, p, "archive_poll", uri,
+            resu = p->archive_poll(gfal_get_plugin_handle(p), uri, &tmp_err),
+            gfal_metrics_errcode(tmp_err), 0);
     G_RETURN_ERR(resu, tmp_err, err);
 }
 
@@ -1164,7 +1740,9 @@ int gfal_plugin_archive_poll_listG(gfal2_context_t handle, int nbfiles, const ch
     gfal_plugin_interface* p = gfal_find_plugin(handle, *uris, GFAL_PLUGIN_ARCHIVE, &tmp_err);
 
     if (p && p->archive_poll_list) {
-        resu = p->archive_poll_list(gfal_get_plugin_handle(p), nbfiles, uris, errors);
+        GFAL_ADMITTED_LIST_CALL(handle, nbfiles, errors, p, "archive_poll_list", *uris,
+            resu = p->archive_poll_list(gfal_get_plugin_handle(p), nbfiles, uris, errors),
+            gfal_metrics_errcode_list(resu, errors, nbfiles), nbfiles);
     }
     else {
         if (p && !p->archive_poll_list) {
@@ -1189,7 +1767,9 @@ ssize_t gfal_plugin_token_retrieveG(gfal2_context_t handle, const char* url, con
     gfal_plugin_interface* p = gfal_find_plugin(handle, url, GFAL_PLUGIN_TOKEN, &tmp_err);
 
     if (p)
-        resu = p->token_retrieve(gfal_get_plugin_handle(p), url, issuer,
-                                 write_access, validity, activities, buff, s_buff, err);
+        GFAL_ADMITTED_CALL(handle, &tmp_err, p, "token_retrieve", url,
+            resu = p->token_retrieve(gfal_get_plugin_handle(p), url, issuer,
+                                     write_access, validity, activities, buff, s_buff, err),
+            gfal_metrics_errcode_list(resu, err, err ? 1 : 0), 0);
     G_RETURN_ERR(resu, tmp_err, err);
 }
@@ -68,6 +68,26 @@ char** gfal_plugins_get_list(gfal2_context_t, GError** err);
 
 int gfal_plugins_delete(gfal2_context_t, GError** err);
 
+/**
+ * Load the plugins registered from their manifest that handle the scheme of the url,
+ * or all of them if the url has no scheme
+ * Return the number of plugins loaded, or -1 and err is set
+ */
+int gfal_plugins_load_for_url(gfal2_context_t handle, const char* url, GError** err);
+
+/**
+ * Load all the plugins registered from their manifest and not loaded yet
+ * Return the number of plugins loaded, or -1 and err is set
+ */
+int gfal_plugins_load_all(gfal2_context_t handle, GError** err);
+
+/**
+ * Give to dest the plugins of src, without scanning the plugin directory again
+ * Plugins registered with gfal2_register_plugin are not inherited
+ * Return 0, or -1 and err is set
+ */
+int gfal_plugins_clone(gfal2_context_t dest, gfal2_context_t src, GError** err);
+
 gboolean gfal_feature_is_supported(void *ptr, GQuark scope, const char *func_name, const char *surl, GError **err);
 
 /**
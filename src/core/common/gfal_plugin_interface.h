@@ -29,6 +29,7 @@
 #include "gfal_common.h"
 #include "gfal_constants.h"
 #include "gfal_file_handle.h"
+#include <file/gfal_file_api.h>
 #include <transfer/gfal_transfer_plugins.h>
 
 #include <glib.h>
@@ -97,6 +98,22 @@ typedef enum _gfal_url2_check {
     GFAL_BULK_COPY
 } gfal_url2_check;
 
+/**
+ * Progress callback given to \ref _gfal_plugin_interface::stream_copyG
+ * Called each time bytes have been written to the destination
+ * @return 0 to continue, or -1 with err set to abort the copy (cancellation, timeout...)
+ */
+typedef int (*gfal_stream_copy_progress_t)(size_t bytes, void* user_data, GError** err);
+
+/**
+ * Completion callback given to the asynchronous entry points, as \ref _gfal_plugin_interface::stat_asyncG
+ * Called once, from any thread, when the operation is done
+ * @param notify_data : the pointer given with the callback
+ * @param result : what the blocking entry point would have returned
+ * @param error : error of the operation, owned by the callee. NULL on success
+ */
+typedef void (*gfal_plugin_async_notify_t)(gpointer notify_data, int result, GError* error);
+
 /**
  * Prototype of the plugins entry point
  *
@@ -742,9 +759,56 @@ struct _gfal_plugin_interface {
                             gboolean write_access, unsigned validity, const char* const* activities,
                             char* buff, size_t s_buff, GError** err);
 
+  /**
+   * OPTIONAL: copy the content of a file into another, both opened by this plugin,
+   *           from their current offsets up to the end of the source.
+   *           Used by the streamed copy of the core in place of its read/write loop.
+   *
+   * @param plugin_data: internal plugin data
+   * @param src: source file handle, opened for reading
+   * @param dst: destination file handle, opened for writing
+   * @param buffer_size: buffer size configured for the streamed copy
+   * @param progress: to be called as data is written
+   * @param user_data: passed to progress
+   * @param err: error handle. ENOSYS makes the core fall back to its own loop
+   * @return the number of bytes copied, or -1 if error occurs
+   */
+  ssize_t (*stream_copyG)(plugin_handle plugin_data, gfal_file_handle src, gfal_file_handle dst,
+                          size_t buffer_size, gfal_stream_copy_progress_t progress, void* user_data,
+                          GError** err);
+
+  /**
+   * OPTIONAL: read several directory entries, with their meta-data, in one call
+   *           If not implemented, the core falls back to readdirppG
+   *
+   * @param plugin_data: internal plugin data
+   * @param dir_desc: directory descriptor to use
+   * @param entries: array to fill
+   * @param nentries: size of entries, greater than 0
+   * @param err: error handle
+   * @return the number of entries stored, 0 at the end of the listing, or -1 if error occurs
+   */
+  ssize_t (*readdir_batchG)(plugin_handle plugin_data, gfal_file_handle dir_desc,
+                            gfal2_dir_entry_t* entries, size_t nentries, GError** err);
+
+  /**
+   * OPTIONAL: start a stat without waiting for its result, used by \ref gfal2_async_stat
+   *           If not implemented, the operation holds a thread of the executor while statG runs
+   *
+   * @param plugin_data: internal plugin data
+   * @param url: url to stat
+   * @param buf: to be filled before notify is called
+   * @param notify: to be called once the stat is done, not called if this returns -1
+   * @param notify_data: passed to notify
+   * @param err: error handle. ENOSYS makes the core fall back to statG
+   * @return 0 if the stat has been started, or -1 if error occurs
+   */
+  int (*stat_asyncG)(plugin_handle plugin_data, const char* url, struct stat* buf,
+                     gfal_plugin_async_notify_t notify, gpointer notify_data, GError** err);
+
       // reserved for future usage
 	 //! @cond
-     void* future[4];
+     void* future[1];
 	 //! @endcond
 };
 
@@ -755,6 +819,35 @@ struct _gfal_plugin_interface {
 int gfal2_register_plugin(gfal2_context_t handle, const gfal_plugin_interface* ifce,
         GError** error);
 
+/**
+ * Slot of a class of calls to an endpoint, see \ref gfal2_endpoint_slot_acquire
+ */
+typedef struct gfal_admission_endpoint* gfal2_endpoint_slot_t;
+
+/**
+ * Wait for a slot of a class of calls (i.e. sessions, polls) to the endpoint of url,
+ * for the whole process. url can also be a bare host[:port].
+ *
+ * At most limit slots of the class are held at the same time, unless the option named
+ * after the class is set in the group [ENDPOINT:HOST:PORT], [ENDPOINT:HOST] or [ENDPOINT].
+ * The callers are served as the calls admitted by gfal2 itself (see MAX_CONCURRENCY).
+ * Unlike those, a thread holding a slot of the class waits as any other for a second one,
+ * and the slot can be released from another thread.
+ * @param plugin  : name used to record the time spent waiting in the metrics
+ * @param klass   : name of the class, and of the option overriding its limit
+ * @param limit   : default limit, 0 for no limit
+ * @param timeout : maximum time to wait, in seconds. 0 to fail right away, negative to wait until cancelled
+ * @param slot    : set to the slot to release with \ref gfal2_endpoint_slot_release, NULL if the class is not limited
+ * @return 0 on success, -1 and error is set on failure: ECANCELED if cancelled, EBUSY on timeout
+ */
+int gfal2_endpoint_slot_acquire(gfal2_context_t handle, const char* plugin, const char* url,
+        const char* klass, int limit, int timeout, gfal2_endpoint_slot_t* slot, GError** error);
+
+/**
+ * Release a slot taken with \ref gfal2_endpoint_slot_acquire. NULL is ignored
+ */
+void gfal2_endpoint_slot_release(gfal2_endpoint_slot_t slot);
+
 
 // internal API for inter plugin communication
 //! @cond
@@ -768,6 +861,8 @@ int gfal_plugin_statG(gfal2_context_t handle,const char* path, struct stat* st,
 int gfal_plugin_renameG(gfal2_context_t handle, const char* oldpath, const char* newpath, GError** err);
 int gfal_plugin_symlinkG(gfal2_context_t handle, const char* oldpath, const char* newpath, GError** err);
 int gfal_plugin_lstatG(gfal2_context_t handle,const char* path, struct stat* st, GError** err);
+int gfal_plugin_stat_asyncG(gfal2_context_t handle, const char* path, struct stat* st,
+        gfal_plugin_async_notify_t notify, gpointer notify_data, GError** err);
 int gfal_plugin_mkdirp(gfal2_context_t handle, const char* path, mode_t mode, gboolean pflag,  GError** err);
 
 
@@ -775,6 +870,8 @@ gfal_file_handle gfal_plugin_opendirG(gfal2_context_t handle, const char* name,
 struct dirent* gfal_plugin_readdirppG(gfal2_context_t handle, gfal_file_handle fh, struct stat* st, GError** err);
 int gfal_plugin_closedirG(gfal2_context_t handle, gfal_file_handle fh, GError** err);
 struct dirent* gfal_plugin_readdirG(gfal2_context_t handle, gfal_file_handle fh, GError** err);
+ssize_t gfal_plugin_readdir_batchG(gfal2_context_t handle, gfal_file_handle fh,
+        gfal2_dir_entry_t* entries, size_t nentries, GError** err);
 
 
 gfal_file_handle gfal_plugin_openG(gfal2_context_t handle, const char * path, int flag, mode_t mode, GError ** err);
@@ -0,0 +1,373 @@
+/*
+ * Copyright (c) CERN 2013-2017
+ *
+ * Copyright (c) Members of the EMI Collaboration. 2010-2013
+ *  See  http://www.eu-emi.eu/partners for details on the copyright
+ *  holders.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <errno.h>
+#include <string.h>
+#include <gfal_api.h>
+#include <common/gfal_plugin_interface.h>
+#include <logger/gfal_logger.h>
+#include "gfal_poll_scheduler.h"
+
+// Keep untouched requests at most this long, in usec
+#define GFAL_POLL_REQUEST_TTL (G_GINT64_CONSTANT(6) * 3600 * G_USEC_PER_SEC)
+
+
+typedef struct {
+    gboolean known;
+    // NULL if ready
+    GError* status;
+} gfal_poll_file;
+
+typedef struct {
+    // monotonic time in usec, 0 if the request was not submitted by this process
+    gint64 submitted;
+    gint64 next_poll;
+    gint64 last_access;
+    gint64 interval;
+    gint64 interval_min;
+    gint64 interval_max;
+    gboolean in_flight;
+    // Slot in the budget of the endpoint, while in flight
+    gfal2_endpoint_slot_t budget;
+    // key -> gfal_poll_file
+    GHashTable* files;
+} gfal_poll_request;
+
+typedef struct {
+    // Average time taken by the files of the endpoint to be ready, in usec. 0 if unknown
+    gint64 ready_time;
+    // token -> gfal_poll_request
+    GHashTable* requests;
+} gfal_poll_endpoint;
+
+
+// Endpoints are never released, there is only a handful of them
+static GHashTable* poll_endpoints = NULL;
+static GMutex* poll_lock = NULL;
+static GCond* poll_changed = NULL;
+
+
+static void gfal_poll_file_free(gpointer data)
+{
+    gfal_poll_file* file = (gfal_poll_file*) data;
+    if (file->status)
+        g_error_free(file->status);
+    g_free(file);
+}
+
+
+static void gfal_poll_request_free(gpointer data)
+{
+    gfal_poll_request* request = (gfal_poll_request*) data;
+    g_hash_table_destroy(request->files);
+    g_free(request);
+}
+
+
+__attribute__((constructor))
+static void gfal_poll_scheduler_init()
+{
+#if  (!GLIB_CHECK_VERSION (2, 32, 0))
+    if (!g_thread_supported())
+        g_thread_init(NULL);
+#endif
+    poll_endpoints = g_hash_table_new(g_str_hash, g_str_equal);
+    poll_lock = g_mutex_new();
+    poll_changed = g_cond_new();
+}
+
+// Must be called with the lock held
+static gfal_poll_endpoint* gfal_poll_get_endpoint(const char* endpoint)
+{
+    gfal_poll_endpoint* ep = g_hash_table_lookup(poll_endpoints, endpoint);
+    if (ep == NULL) {
+        ep = g_new0(gfal_poll_endpoint, 1);
+        ep->requests = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, gfal_poll_request_free);
+        g_hash_table_insert(poll_endpoints, g_strdup(endpoint), ep);
+    }
+    return ep;
+}
+
+
+static gboolean gfal_poll_request_expired(gpointer key, gpointer value, gpointer user_data)
+{
+    gfal_poll_request* request = (gfal_poll_request*) value;
+    gint64 now = *((gint64*) user_data);
+    return !request->in_flight && now - request->last_access > GFAL_POLL_REQUEST_TTL;
+}
+
+// Must be called with the lock held
+static gfal_poll_request* gfal_poll_get_request(gfal_poll_endpoint* ep, const char* token, gint64 now)
+{
+    gfal_poll_request* request = g_hash_table_lookup(ep->requests, token);
+    if (request == NULL) {
+        g_hash_table_foreach_remove(ep->requests, gfal_poll_request_expired, &now);
+        request = g_new0(gfal_poll_request, 1);
+        request->files = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, gfal_poll_file_free);
+        g_hash_table_insert(ep->requests, g_strdup(token), request);
+    }
+    request->last_access = now;
+    return request;
+}
+
+// Must be called with the lock held
+static gfal_poll_file* gfal_poll_get_file(gfal_poll_request* request, const char* key, gboolean* added)
+{
+    gfal_poll_file* file = g_hash_table_lookup(request->files, key);
+    if (file == NULL) {
+        file = g_new0(gfal_poll_file, 1);
+        g_hash_table_insert(request->files, g_strdup(key), file);
+        if (added)
+            *added = TRUE;
+    }
+    return file;
+}
+
+
+static gboolean gfal_poll_file_pending(const gfal_poll_file* file)
+{
+    return !file->known || (file->status != NULL && file->status->code == EAGAIN);
+}
+
+// The budget is a class of calls of the admission of the endpoint, so it shares its queues
+// and can be set per endpoint in the ENDPOINT groups
+static int gfal_poll_budget_wait(gfal2_context_t context, const char* endpoint, gfal2_endpoint_slot_t* slot,
+        GError** err)
+{
+    gint budget = gfal2_get_opt_integer_with_default(context, CORE_CONFIG_GROUP, "POLL_ENDPOINT_BUDGET", 16);
+    return gfal2_endpoint_slot_acquire(context, "poll", endpoint, "POLL_ENDPOINT_BUDGET", budget, -1, slot, err);
+}
+
+
+void gfal2_poll_register(const char* endpoint, const char* token, int nbfiles, const char* const* keys)
+{
+    int i;
+    if (endpoint == NULL || token == NULL || token[0] == '\0')
+        return;
+
+    g_mutex_lock(poll_lock);
+    gint64 now = g_get_monotonic_time();
+    gfal_poll_request* request = gfal_poll_get_request(gfal_poll_get_endpoint(endpoint), token, now);
+    request->submitted = now;
+    for (i = 0; i < nbfiles; ++i) {
+        gfal_poll_get_file(request, keys[i], NULL);
+    }
+    g_mutex_unlock(poll_lock);
+}
+
+
+int gfal2_poll_begin(gfal2_context_t context, const char* endpoint, const char* token,
+        time_t interval_min, time_t interval_max,
+        int nbfiles, const char* const* keys, char*** poll_keys, GError** err)
+{
+    g_return_val_err_if_fail(context && endpoint && token, -1, err, "[gfal2_poll_begin] invalid parameters");
+    int i;
+    gboolean coalesced = FALSE;
+
+    if (poll_keys)
+        *poll_keys = NULL;
+
+    g_mutex_lock(poll_lock);
+    gfal_poll_endpoint* ep = gfal_poll_get_endpoint(endpoint);
+    gfal_poll_request* request = gfal_poll_get_request(ep, token, g_get_monotonic_time());
+
+    // Someone else is polling this request: its result will do
+    // Wake up regularly, to honor cancellation
+    while (request->in_flight) {
+        if (gfal2_is_canceled(context)) {
+            g_mutex_unlock(poll_lock);
+            gfal2_set_error(err, gfal2_get_core_quark(), ECANCELED, __func__,
+                "Operation cancelled while waiting for the poll of %s on %s", token, endpoint);
+            return -1;
+        }
+        GTimeVal deadline;
+        g_get_current_time(&deadline);
+        g_time_val_add(&deadline, G_USEC_PER_SEC);
+        g_cond_timed_wait(poll_changed, poll_lock, &deadline);
+        coalesced = TRUE;
+        // The request may have been forgotten meanwhile
+        request = gfal_poll_get_request(ep, token, g_get_monotonic_time());
+    }
+
+    // Files never seen before are polled right away, the others when the interval expires
+    gboolean any_pending = FALSE, any_added = FALSE;
+    for (i = 0; i < nbfiles; ++i) {
+        gfal_poll_file* file = gfal_poll_get_file(request, keys[i], &any_added);
+        any_pending |= gfal_poll_file_pending(file);
+    }
+
+    gint64 now = g_get_monotonic_time();
+    gboolean due = any_added || (any_pending && !coalesced && now >= request->next_poll);
+    if (!due) {
+        g_mutex_unlock(poll_lock);
+        return 0;
+    }
+
+    // The other pollers of the request wait for this one while it waits for the budget
+    request->in_flight = TRUE;
+    g_mutex_unlock(poll_lock);
+    gfal2_endpoint_slot_t budget = NULL;
+    int budget_ret = gfal_poll_budget_wait(context, endpoint, &budget, err);
+    g_mutex_lock(poll_lock);
+    request = gfal_poll_get_request(ep, token, g_get_monotonic_time());
+    if (budget_ret < 0) {
+        request->in_flight = FALSE;
+        g_cond_broadcast(poll_changed);
+        g_mutex_unlock(poll_lock);
+        return -1;
+    }
+    request->budget = budget;
+    request->interval_min = (gint64)MAX(interval_min, 1) * G_USEC_PER_SEC;
+    request->interval_max = (gint64)MAX(interval_max, interval_min) * G_USEC_PER_SEC;
+
+    if (poll_keys) {
+        // The files asked first, then the other pending files of the request
+        GPtrArray* pending = g_ptr_array_new();
+        for (i = 0; i < nbfiles; ++i) {
+            if (gfal_poll_file_pending(gfal_poll_get_file(request, keys[i], NULL)))
+                g_ptr_array_add(pending, g_strdup(keys[i]));
+        }
+        GHashTableIter iter;
+        gpointer key, value;
+        g_hash_table_iter_init(&iter, request->files);
+        while (g_hash_table_iter_next(&iter, &key, &value)) {
+            gboolean asked = FALSE;
+            for (i = 0; i < nbfiles && !asked; ++i)
+                asked = (strcmp(keys[i], key) == 0);
+            if (!asked && gfal_poll_file_pending(value))
+                g_ptr_array_add(pending, g_strdup(key));
+        }
+        g_ptr_array_add(pending, NULL);
+        *poll_keys = (char**) g_ptr_array_free(pending, FALSE);
+    }
+    g_mutex_unlock(poll_lock);
+    return 1;
+}
+
+
+void gfal2_poll_end(const char* endpoint, const char* token,
+        int nbfiles, const char* const* keys, GError** statuses)
+{
+    int i;
+    gboolean progress = FALSE;
+
+    g_mutex_lock(poll_lock);
+    gint64 now = g_get_monotonic_time();
+    gfal_poll_endpoint* ep = gfal_poll_get_endpoint(endpoint);
+    gfal_poll_request* request = gfal_poll_get_request(ep, token, now);
+
+    for (i = 0; statuses && i < nbfiles; ++i) {
+        gfal_poll_file* file = gfal_poll_get_file(request, keys[i], NULL);
+        GError* status = statuses[i];
+
+        gboolean changed = !file->known ||
+            (file->status == NULL) != (status == NULL) ||
+            (file->status && status && file->status->code != status->code);
+        if (changed && status == NULL && request->submitted) {
+            // Learn how long the files of this endpoint take to be ready
+            gint64 elapsed = now - request->submitted;
+            if (ep->ready_time == 0)
+                ep->ready_time = elapsed;
+            else
+                ep->ready_time += (elapsed - ep->ready_time) / 5;
+        }
+        progress |= changed;
+
+        if (file->status)
+            g_error_free(file->status);
+        file->status = status ? g_error_copy(status) : NULL;
+        file->known = TRUE;
+    }
+
+    if (progress)
+        request->interval = request->interval_min;
+    else
+        request->interval = CLAMP(request->interval * 2, request->interval_min, request->interval_max);
+
+    gint64 delay = request->interval;
+    if (request->submitted && ep->ready_time) {
+        gint64 remaining = ep->ready_time - (now - request->submitted);
+        if (remaining / 2 > delay)
+            delay = MIN(remaining / 2, request->interval_max);
+    }
+    request->next_poll = now + delay;
+    request->in_flight = FALSE;
+    gfal2_endpoint_slot_t budget = request->budget;
+    request->budget = NULL;
+
+    g_cond_broadcast(poll_changed);
+    g_mutex_unlock(poll_lock);
+    gfal2_endpoint_slot_release(budget);
+
+    gfal2_log(G_LOG_LEVEL_DEBUG, "Next poll of %s on %s in %" G_GINT64_FORMAT " ms",
+        token, endpoint, delay / 1000);
+}
+
+
+int gfal2_poll_status(const char* endpoint, const char* token, const char* key, GError** err)
+{
+    int ret = -1;
+    GError* status = NULL;
+
+    g_mutex_lock(poll_lock);
+    gfal_poll_endpoint* ep = g_hash_table_lookup(poll_endpoints, endpoint);
+    gfal_poll_request* request = ep ? g_hash_table_lookup(ep->requests, token) : NULL;
+    gfal_poll_file* file = request ? g_hash_table_lookup(request->files, key) : NULL;
+    if (file && file->known) {
+        if (file->status)
+            status = g_error_copy(file->status);
+        else
+            ret = 0;
+    }
+    g_mutex_unlock(poll_lock);
+
+    if (ret == 0)
+        return 0;
+    if (status == NULL)
+        gfal2_set_error(&status, gfal2_get_core_quark(), EAGAIN, __func__, "No status yet for %s", key);
+    *err = status;
+    return -1;
+}
+
+
+void gfal2_poll_forget(const char* endpoint, const char* token)
+{
+    g_mutex_lock(poll_lock);
+    gfal_poll_endpoint* ep = g_hash_table_lookup(poll_endpoints, endpoint);
+    gfal_poll_request* request = ep ? g_hash_table_lookup(ep->requests, token) : NULL;
+    // A poll in flight still needs it, it will expire later
+    if (request && !request->in_flight)
+        g_hash_table_remove(ep->requests, token);
+    g_mutex_unlock(poll_lock);
+}
+
+
+int gfal2_poll_budget_acquire(gfal2_context_t context, const char* endpoint, gfal2_endpoint_slot_t* slot,
+        GError** err)
+{
+    g_return_val_err_if_fail(context && endpoint && slot, -1, err, "[gfal2_poll_budget_acquire] invalid parameters");
+    return gfal_poll_budget_wait(context, endpoint, slot, err);
+}
+
+
+void gfal2_poll_budget_release(gfal2_endpoint_slot_t slot)
+{
+    gfal2_endpoint_slot_release(slot);
+}
@@ -0,0 +1,138 @@
+/*
+ * Copyright (c) CERN 2013-2017
+ *
+ * Copyright (c) Members of the EMI Collaboration. 2010-2013
+ *  See  http://www.eu-emi.eu/partners for details on the copyright
+ *  holders.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+#ifndef GFAL_POLL_SCHEDULER_H_
+#define GFAL_POLL_SCHEDULER_H_
+
+#if !defined(__GFAL2_H_INSIDE__) && !defined(__GFAL2_BUILD__)
+#   warning "Direct inclusion of gfal2 headers is deprecated. Please, include only gfal_api.h or gfal_plugins_api.h"
+#endif
+
+#include <time.h>
+#include <glib.h>
+#include <common/gfal_common.h>
+#include <common/gfal_plugin_interface.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*!
+    \defgroup poll_group Polling of asynchronous requests
+
+    Process-wide scheduler shared by the plugins polling asynchronous requests
+    (bring online, staging...). Requests are identified by their endpoint and token,
+    and their files by an opaque key (usually the url or the path).
+
+    For each request, the scheduler keeps the last status of every file seen,
+    so the poll of one file refreshes all the pending files of the request in a single
+    status call, and the other files are then answered without contacting the endpoint.
+    Concurrent polls of the same request are coalesced into one.
+
+    A request is not polled again before its poll interval expires. The interval is reset
+    when a file changes state, and doubled otherwise. While the request is younger than
+    the time the files of its endpoint usually take to be ready, the interval is
+    stretched to half of the expected remaining time.
+
+    The number of calls in flight to a single endpoint, from all the threads of the
+    process, is limited by CORE:POLL_ENDPOINT_BUDGET. The budget is a class of calls of
+    the admission of the endpoint (see \ref gfal2_endpoint_slot_acquire), so it can be
+    overridden by POLL_ENDPOINT_BUDGET in the ENDPOINT groups.
+*/
+
+/*!
+    \addtogroup poll_group
+    @{
+*/
+
+/**
+ * @brief register the files of a request just submitted
+ *
+ * The submission time is used to learn how long the files of the endpoint take to be ready
+ */
+void gfal2_poll_register(const char* endpoint, const char* token, int nbfiles, const char* const* keys);
+
+/**
+ * @brief start a poll of some files of a request
+ *
+ * Blocks while another thread is polling the same request, and while the budget
+ * of the endpoint is exhausted.
+ * @param interval_min : minimum poll interval of the request, in seconds
+ * @param interval_max : maximum poll interval of the request, in seconds
+ * @param poll_keys : if not NULL, set to the keys to include in the status call when the request
+ *                    is due: the pending files given, plus the other pending files of the request.
+ *                    NULL terminated, to be released with g_strfreev
+ * @return 1 if the request must be polled now, and \ref gfal2_poll_end called afterwards,
+ *         0 if the last status of the files is recent enough (see \ref gfal2_poll_status),
+ *         -1 and err is set on failure (i.e. cancellation)
+ */
+int gfal2_poll_begin(gfal2_context_t context, const char* endpoint, const char* token,
+        time_t interval_min, time_t interval_max,
+        int nbfiles, const char* const* keys, char*** poll_keys, GError** err);
+
+/**
+ * @brief finish a poll started with \ref gfal2_poll_begin
+ * @param statuses : status of each file: NULL if ready, an error with the code EAGAIN if still pending,
+ *                   any other error if failed. The errors are copied.
+ *                   If statuses is NULL, the status call itself failed, and the files keep their last status
+ */
+void gfal2_poll_end(const char* endpoint, const char* token,
+        int nbfiles, const char* const* keys, GError** statuses);
+
+/**
+ * @brief get the last status of a file
+ * @return 0 if the file is ready, -1 and err is set otherwise.
+ *         The code is EAGAIN if the file is still pending, or if it was never polled
+ */
+int gfal2_poll_status(const char* endpoint, const char* token, const char* key, GError** err);
+
+/**
+ * @brief forget a request, once it is released or aborted
+ */
+void gfal2_poll_forget(const char* endpoint, const char* token);
+
+/**
+ * @brief take a slot in the budget of the endpoint, for a call that is not a poll (i.e. a submission)
+ *
+ * Blocks until a slot is free. The slot must only be held for the duration of a single call,
+ * not for a request that waits for its files to be ready
+ * @param slot : set to the slot to release, NULL if there is nothing to release
+ * @return 0 on success, -1 and err is set on failure (i.e. cancellation)
+ */
+int gfal2_poll_budget_acquire(gfal2_context_t context, const char* endpoint, gfal2_endpoint_slot_t* slot,
+        GError** err);
+
+/**
+ * @brief release a slot taken with \ref gfal2_poll_budget_acquire
+ */
+void gfal2_poll_budget_release(gfal2_endpoint_slot_t slot);
+
+/**
+    @}
+    End of the POLL group
+*/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* GFAL_POLL_SCHEDULER_H_ */
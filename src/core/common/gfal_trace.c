@@ -0,0 +1,205 @@
+/*
+ * Copyright (c) CERN 2013-2017
+ *
+ * Copyright (c) Members of the EMI Collaboration. 2010-2013
+ *  See  http://www.eu-emi.eu/partners for details on the copyright
+ *  holders.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include "gfal_trace_internal.h"
+#include "gfal_metrics_internal.h"
+#include "gfal_common.h"
+#include "gfal_error.h"
+#include <logger/gfal_logger.h>
+
+#define GFAL_TRACE_MAX_HOST 256
+#define GFAL_TRACE_BUFFER_SIZE (1024 * 1024)
+
+// The lock is only taken while a trace is being recorded
+static GMutex *trace_lock = NULL;
+static volatile gint trace_active = FALSE;
+static FILE *trace_file = NULL;
+static gint64 trace_origin = 0;
+static GHashTable *trace_hosts = NULL;
+static GHashTable *trace_operations = NULL;
+static volatile gint trace_thread_counter = 0;
+static __thread guint32 trace_thread_id = 0;
+
+
+__attribute__((constructor))
+static void gfal_trace_init()
+{
+#if  (!GLIB_CHECK_VERSION (2, 32, 0))
+    if (!g_thread_supported())
+        g_thread_init(NULL);
+#endif
+    trace_lock = g_mutex_new();
+}
+
+
+guint64 gfal_trace_path_hash(const char* url)
+{
+    const char *path = url;
+    const char *scheme_end = strstr(url, "://");
+    if (scheme_end) {
+        path = scheme_end + 3;
+        path += strcspn(path, "/?#");
+    }
+
+    guint64 hash = G_GUINT64_CONSTANT(14695981039346656037);
+    for (; *path && *path != '?' && *path != '#'; ++path) {
+        hash ^= (guchar)*path;
+        hash *= G_GUINT64_CONSTANT(1099511628211);
+    }
+    return hash;
+}
+
+
+// Id of the string, writing its definition if it is the first time it is seen. Called with the lock held.
+static guint32 gfal_trace_string_id(GHashTable *table, guint8 type, const char *str)
+{
+    gpointer id = g_hash_table_lookup(table, str);
+    if (id)
+        return (guint32)GPOINTER_TO_UINT(id);
+
+    guint32 new_id = g_hash_table_size(table) + 1;
+    guint16 length = (guint16)MIN(strlen(str), G_MAXUINT16);
+    fwrite(&type, sizeof(type), 1, trace_file);
+    fwrite(&new_id, sizeof(new_id), 1, trace_file);
+    fwrite(&length, sizeof(length), 1, trace_file);
+    fwrite(str, 1, length, trace_file);
+
+    g_hash_table_insert(table, g_strdup(str), GUINT_TO_POINTER(new_id));
+    return new_id;
+}
+
+
+gint64 gfal_trace_begin(void)
+{
+    if (!g_atomic_int_get(&trace_active))
+        return 0;
+    return g_get_monotonic_time();
+}
+
+
+void gfal_trace_record(const char* operation, const char* url, gint64 start, int errcode,
+    guint64 arg, guint64 offset)
+{
+    gint64 end = g_get_monotonic_time();
+    char host[GFAL_TRACE_MAX_HOST] = {0};
+    char scheme_host[GFAL_TRACE_MAX_HOST + 32] = {0};
+
+    if (trace_thread_id == 0)
+        trace_thread_id = (guint32)g_atomic_int_add(&trace_thread_counter, 1) + 1;
+
+    if (url) {
+        const char *scheme_end = strstr(url, "://");
+        gfal_metrics_url_host(url, host, sizeof(host));
+        if (scheme_end)
+            g_snprintf(scheme_host, sizeof(scheme_host), "%.*s://%s", (int)(scheme_end - url), url, host);
+    }
+
+    gfal_trace_record_t record;
+    memset(&record, 0, sizeof(record));
+    record.path_hash = url ? gfal_trace_path_hash(url) : 0;
+    record.arg = arg;
+    record.offset = offset;
+    record.latency = (guint32)MIN(end - start, G_MAXUINT32);
+    record.thread = trace_thread_id;
+    record.errcode = errcode;
+
+    g_mutex_lock(trace_lock);
+    if (trace_file) {
+        guint8 type = GFAL_TRACE_ENTRY_RECORD;
+        record.start = (start > trace_origin) ? (guint64)(start - trace_origin) : 0;
+        record.host = scheme_host[0] ? gfal_trace_string_id(trace_hosts, GFAL_TRACE_ENTRY_HOST, scheme_host) : 0;
+        record.operation = gfal_trace_string_id(trace_operations, GFAL_TRACE_ENTRY_OPERATION, operation);
+        fwrite(&type, sizeof(type), 1, trace_file);
+        fwrite(&record, sizeof(record), 1, trace_file);
+    }
+    g_mutex_unlock(trace_lock);
+}
+
+
+// Called with the lock held
+static void gfal_trace_close(void)
+{
+    g_atomic_int_set(&trace_active, FALSE);
+    if (trace_file) {
+        fclose(trace_file);
+        trace_file = NULL;
+    }
+    if (trace_hosts) {
+        g_hash_table_destroy(trace_hosts);
+        trace_hosts = NULL;
+    }
+    if (trace_operations) {
+        g_hash_table_destroy(trace_operations);
+        trace_operations = NULL;
+    }
+}
+
+
+int gfal2_trace_start(const char* path, GError** err)
+{
+    g_return_val_err_if_fail(path != NULL, -1, err, "[gfal2_trace_start] Invalid path");
+
+    g_mutex_lock(trace_lock);
+    gfal_trace_close();
+
+    trace_file = fopen(path, "wb");
+    if (trace_file == NULL) {
+        int errn = errno;
+        g_mutex_unlock(trace_lock);
+        gfal2_set_error(err, gfal2_get_core_quark(), errn, __func__,
+            "Could not open the trace file %s: %s", path, strerror(errn));
+        return -1;
+    }
+    setvbuf(trace_file, NULL, _IOFBF, GFAL_TRACE_BUFFER_SIZE);
+
+    gfal_trace_header_t header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, GFAL_TRACE_MAGIC, sizeof(header.magic));
+    header.version = GFAL_TRACE_VERSION;
+    header.record_size = sizeof(gfal_trace_record_t);
+    header.start_time = g_get_real_time();
+    fwrite(&header, sizeof(header), 1, trace_file);
+
+    trace_hosts = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+    trace_operations = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+    trace_origin = g_get_monotonic_time();
+    g_atomic_int_set(&trace_active, TRUE);
+    g_mutex_unlock(trace_lock);
+
+    gfal2_log(G_LOG_LEVEL_DEBUG, "Recording operations into %s", path);
+    return 0;
+}
+
+
+void gfal2_trace_stop(void)
+{
+    g_mutex_lock(trace_lock);
+    gfal_trace_close();
+    g_mutex_unlock(trace_lock);
+}
+
+
+gboolean gfal2_trace_is_enabled(void)
+{
+    return g_atomic_int_get(&trace_active);
+}
@@ -0,0 +1,83 @@
+/*
+ * Copyright (c) CERN 2013-2017
+ *
+ * Copyright (c) Members of the EMI Collaboration. 2010-2013
+ *  See  http://www.eu-emi.eu/partners for details on the copyright
+ *  holders.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+#ifndef GFAL_TRACE_H_
+#define GFAL_TRACE_H_
+
+#if !defined(__GFAL2_H_INSIDE__) && !defined(__GFAL2_BUILD__)
+#   warning "Direct inclusion of gfal2 headers is deprecated. Please, include only gfal_api.h or gfal_plugins_api.h"
+#endif
+
+#include <glib.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*!
+    \defgroup trace_group Operation traces
+
+    gfal2 can record every operation dispatched to a plugin into a compact binary trace:
+    operation, remote host, a hash of the path, size, latency, error code and calling thread.
+    File names are not written into the trace.
+
+    Traces can be replayed with the original timing and concurrency against the mock
+    plugin using gfal2-trace-replay.
+
+    Tracing can also be enabled for the whole process with CORE:TRACE_FILE.
+*/
+
+/*!
+    \addtogroup trace_group
+    @{
+*/
+
+/**
+ * @brief start recording the operations of the whole process into a trace file
+ *
+ * If a trace is already being recorded, it is closed first
+ * @param path : trace file, truncated if it exists
+ * @param err : GError error report
+ * @return 0 on success, -1 and err is set on failure
+ */
+int gfal2_trace_start(const char* path, GError** err);
+
+/**
+ * @brief stop recording, and flush and close the trace file
+ */
+void gfal2_trace_stop(void);
+
+/**
+ * @brief check if a trace is being recorded
+ */
+gboolean gfal2_trace_is_enabled(void);
+
+/**
+    @}
+    End of the TRACE group
+*/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* GFAL_TRACE_H_ */
@@ -0,0 +1,93 @@
+/*
+ * Copyright (c) CERN 2013-2017
+ *
+ * Copyright (c) Members of the EMI Collaboration. 2010-2013
+ *  See  http://www.eu-emi.eu/partners for details on the copyright
+ *  holders.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+#ifndef GFAL_TRACE_INTERNAL_H_
+#define GFAL_TRACE_INTERNAL_H_
+
+#include <glib.h>
+#include "gfal_trace.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*
+ * Trace file format, in host byte order
+ *
+ * The file starts with a gfal_trace_header_t, followed by entries. Each entry starts with
+ * one byte giving its type:
+ *  - GFAL_TRACE_ENTRY_HOST and GFAL_TRACE_ENTRY_OPERATION define a string, and are followed by
+ *    a guint32 id, a guint16 length, and the string itself, without terminating null
+ *  - GFAL_TRACE_ENTRY_RECORD is followed by a gfal_trace_record_t
+ * A string is always defined before the first record using it.
+ */
+
+#define GFAL_TRACE_MAGIC "GFAL2TRC"
+#define GFAL_TRACE_VERSION 2
+
+#define GFAL_TRACE_ENTRY_HOST       1
+#define GFAL_TRACE_ENTRY_OPERATION  2
+#define GFAL_TRACE_ENTRY_RECORD     3
+
+typedef struct {
+    char magic[8];
+    guint32 version;
+    guint32 record_size;
+    // Wall clock time at the start of the trace, in microseconds since the epoch
+    gint64 start_time;
+} gfal_trace_header_t;
+
+typedef struct {
+    // Start of the operation, in microseconds since the start of the trace
+    guint64 start;
+    // FNV-1a hash of the path, so the same file can be recognised without exposing its name
+    guint64 path_hash;
+    // Size for I/O calls, flags for open, number of files for bulk calls
+    guint64 arg;
+    // Offset of pread and pwrite, 0 otherwise
+    guint64 offset;
+    // Duration, in microseconds
+    guint32 latency;
+    // Calling thread, numbered in order of appearance
+    guint32 thread;
+    // Error code, 0 on success
+    gint32 errcode;
+    // scheme://host[:port], 0 for local paths
+    guint32 host;
+    guint32 operation;
+} gfal_trace_record_t;
+
+// Start time of an operation, 0 if no trace is being recorded
+gint64 gfal_trace_begin(void);
+
+// Write an operation into the trace
+void gfal_trace_record(const char* operation, const char* url, gint64 start, int errcode,
+    guint64 arg, guint64 offset);
+
+// FNV-1a hash of the path part of the url
+guint64 gfal_trace_path_hash(const char* url);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* GFAL_TRACE_INTERNAL_H_ */
@@ -0,0 +1,686 @@
+/*
+ * Copyright (c) CERN 2013-2017
+ *
+ * Copyright (c) Members of the EMI Collaboration. 2010-2013
+ *  See  http://www.eu-emi.eu/partners for details on the copyright
+ *  holders.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/eventfd.h>
+#endif
+
+#include <file/gfal_async_api.h>
+#include <file/gfal_async_internal.h>
+#include <file/gfal_file_api.h>
+
+#include <common/gfal_handle.h>
+#include <common/gfal_error.h>
+#include <common/gfal_config.h>
+#include <common/gfal_plugin_interface.h>
+#include <common/gfal_cancel.h>
+#include <logger/gfal_logger.h>
+
+#define GFAL2_ASYNC_DEFAULT_THREADS 16
+
+
+typedef enum {
+    GFAL2_ASYNC_STAT,
+    GFAL2_ASYNC_LSTAT,
+    GFAL2_ASYNC_ACCESS,
+    GFAL2_ASYNC_CHECKSUM,
+    GFAL2_ASYNC_UNLINK,
+    GFAL2_ASYNC_MKDIR_REC,
+    GFAL2_ASYNC_RMDIR,
+    GFAL2_ASYNC_RENAME,
+    GFAL2_ASYNC_GETXATTR,
+    GFAL2_ASYNC_BRING_ONLINE,
+    GFAL2_ASYNC_BRING_ONLINE_POLL
+} gfal2_async_type;
+
+
+typedef enum {
+    GFAL2_ASYNC_QUEUED,
+    GFAL2_ASYNC_RUNNING,
+    GFAL2_ASYNC_DONE
+} gfal2_async_state;
+
+
+struct _gfal2_async_op {
+    gfal2_context_t context;
+    gfal2_async_type type;
+    volatile gint refcount;
+
+    // arguments, strings are owned by the operation
+    char *url;
+    char *url2;
+    char *name;
+    int mode;
+    off_t offset;
+    size_t length;
+    time_t pintime;
+    time_t timeout;
+    int async;
+    void *buffer;
+    size_t buffer_size;
+
+    // completion
+    gfal2_async_callback callback;
+    void *user_data;
+
+    GMutex *lock;
+    GCond *done_cond;
+    gfal2_async_state state;
+    gboolean detached;
+    ssize_t result;
+    GError *error;
+};
+
+
+static void gfal2_async_unref(gfal2_async_op_t op)
+{
+    if (!g_atomic_int_dec_and_test(&op->refcount))
+        return;
+    g_free(op->url);
+    g_free(op->url2);
+    g_free(op->name);
+    g_clear_error(&op->error);
+    g_mutex_free(op->lock);
+    g_cond_free(op->done_cond);
+    g_free(op);
+}
+
+
+static ssize_t gfal2_async_execute(gfal2_async_op_t op, GError **err)
+{
+    gfal2_context_t context = op->context;
+
+    switch (op->type) {
+        case GFAL2_ASYNC_STAT:
+            return gfal2_stat(context, op->url, (struct stat*)op->buffer, err);
+        case GFAL2_ASYNC_LSTAT:
+            return gfal2_lstat(context, op->url, (struct stat*)op->buffer, err);
+        case GFAL2_ASYNC_ACCESS:
+            return gfal2_access(context, op->url, op->mode, err);
+        case GFAL2_ASYNC_CHECKSUM:
+            return gfal2_checksum(context, op->url, op->name, op->offset, op->length,
+                (char*)op->buffer, op->buffer_size, err);
+        case GFAL2_ASYNC_UNLINK:
+            return gfal2_unlink(context, op->url, err);
+        case GFAL2_ASYNC_MKDIR_REC:
+            return gfal2_mkdir_rec(context, op->url, (mode_t)op->mode, err);
+        case GFAL2_ASYNC_RMDIR:
+            return gfal2_rmdir(context, op->url, err);
+        case GFAL2_ASYNC_RENAME:
+            return gfal2_rename(context, op->url, op->url2, err);
+        case GFAL2_ASYNC_GETXATTR:
+            return gfal2_getxattr(context, op->url, op->name, op->buffer, op->buffer_size, err);
+        case GFAL2_ASYNC_BRING_ONLINE:
+            return gfal2_bring_online(context, op->url, op->pintime, op->timeout,
+                (char*)op->buffer, op->buffer_size, op->async, err);
+        case GFAL2_ASYNC_BRING_ONLINE_POLL:
+            return gfal2_bring_online_poll(context, op->url, op->name, err);
+    }
+
+    gfal2_set_error(err, gfal2_get_core_quark(), EINVAL, __func__,
+        "Unknown asynchronous operation type %d", op->type);
+    return -1;
+}
+
+
+static void gfal2_async_signal_fd(gfal2_context_t context)
+{
+    if (context->async_fd[1] < 0)
+        return;
+#ifdef __linux__
+    uint64_t one = 1;
+    ssize_t ret = write(context->async_fd[1], &one, sizeof(one));
+#else
+    char one = 1;
+    ssize_t ret = write(context->async_fd[1], &one, sizeof(one));
+#endif
+    (void) ret;
+}
+
+
+static void gfal2_async_complete(gfal2_async_op_t op, ssize_t result, GError *error)
+{
+    gfal2_context_t context = op->context;
+
+    g_mutex_lock(op->lock);
+    op->result = result;
+    op->error = error;
+    op->state = GFAL2_ASYNC_DONE;
+    g_cond_broadcast(op->done_cond);
+    g_mutex_unlock(op->lock);
+
+    if (op->callback) {
+        op->callback(op, op->user_data);
+        gfal2_async_unref(op);
+    }
+    else {
+        // The reference held by the executor is transferred to the completion queue
+        g_async_queue_push(context->async_completed, op);
+        gfal2_async_signal_fd(context);
+    }
+}
+
+
+// Called by the plugin once an operation started by gfal2_async_start is done
+static void gfal2_async_notify(gpointer data, int result, GError *error)
+{
+    gfal2_async_op_t op = (gfal2_async_op_t)data;
+    gfal2_context_t context = op->context;
+
+    gfal2_async_complete(op, result, error);
+
+    g_mutex_lock(context->mux_async);
+    if (--context->async_running == 0)
+        g_cond_broadcast(context->async_idle);
+    g_mutex_unlock(context->mux_async);
+}
+
+
+// Hand the operation to the asynchronous entry point of the plugin, if it has one, so the worker
+// is free as soon as the operation is sent, and the plugin completes it from its own thread.
+// Returns FALSE if the operation has to be run with the blocking call instead
+static gboolean gfal2_async_start(gfal2_async_op_t op)
+{
+    gfal2_context_t context = op->context;
+    GError *tmp_err = NULL;
+    int ret = -1;
+
+    // The blocking call reports the cancellation
+    if (op->type != GFAL2_ASYNC_STAT || gfal2_is_canceled(context))
+        return FALSE;
+
+    // Counted before, the plugin may complete the operation before returning
+    g_mutex_lock(context->mux_async);
+    ++context->async_running;
+    g_mutex_unlock(context->mux_async);
+
+    ret = gfal_plugin_stat_asyncG(context, op->url, (struct stat*)op->buffer, gfal2_async_notify, op, &tmp_err);
+    if (ret == 0)
+        return TRUE;
+
+    g_mutex_lock(context->mux_async);
+    if (--context->async_running == 0)
+        g_cond_broadcast(context->async_idle);
+    g_mutex_unlock(context->mux_async);
+
+    if (tmp_err == NULL || tmp_err->code == ENOSYS) {
+        g_clear_error(&tmp_err);
+        return FALSE;
+    }
+    gfal2_async_complete(op, -1, tmp_err);
+    return TRUE;
+}
+
+
+static void gfal2_async_worker(gpointer data, gpointer user_data)
+{
+    gfal2_async_op_t op = (gfal2_async_op_t)data;
+    GError *tmp_err = NULL;
+    ssize_t result;
+
+    g_mutex_lock(op->lock);
+    if (op->state != GFAL2_ASYNC_QUEUED) {
+        // Cancelled while waiting in the queue
+        g_mutex_unlock(op->lock);
+        gfal2_async_unref(op);
+        return;
+    }
+    op->state = GFAL2_ASYNC_RUNNING;
+    g_mutex_unlock(op->lock);
+
+    if (gfal2_async_start(op))
+        return;
+    result = gfal2_async_execute(op, &tmp_err);
+    gfal2_async_complete(op, result, tmp_err);
+}
+
+
+// Create the executor on first use, so contexts that never use the
+// asynchronous API do not spawn any thread
+static GThreadPool *gfal2_async_get_pool(gfal2_context_t context, GError **err)
+{
+    GError *tmp_err = NULL;
+
+    g_mutex_lock(context->mux_async);
+    if (context->async_pool == NULL) {
+        gint nthreads = gfal2_get_opt_integer_with_default(context, "CORE", "ASYNC_THREADS",
+            GFAL2_ASYNC_DEFAULT_THREADS);
+        if (nthreads <= 0)
+            nthreads = GFAL2_ASYNC_DEFAULT_THREADS;
+
+        context->async_completed = g_async_queue_new();
+        context->async_pool = g_thread_pool_new(gfal2_async_worker, NULL, nthreads, FALSE, &tmp_err);
+        if (context->async_pool == NULL) {
+            g_async_queue_unref(context->async_completed);
+            context->async_completed = NULL;
+        }
+        else {
+            gfal2_log(G_LOG_LEVEL_DEBUG, "Asynchronous executor started with %d threads", nthreads);
+        }
+    }
+    g_mutex_unlock(context->mux_async);
+
+    if (tmp_err) {
+        gfal2_propagate_prefixed_error(err, tmp_err, __func__);
+        return NULL;
+    }
+    return context->async_pool;
+}
+
+
+static gfal2_async_op_t gfal2_async_new(gfal2_context_t context, gfal2_async_type type, const char *url,
+    gfal2_async_callback callback, void *user_data)
+{
+    gfal2_async_op_t op = g_new0(struct _gfal2_async_op, 1);
+    op->context = context;
+    op->type = type;
+    op->url = g_strdup(url);
+    op->callback = callback;
+    op->user_data = user_data;
+    op->lock = g_mutex_new();
+    op->done_cond = g_cond_new();
+    op->state = GFAL2_ASYNC_QUEUED;
+    // One for the caller, one for the executor
+    op->refcount = 2;
+    return op;
+}
+
+
+static gfal2_async_op_t gfal2_async_submit(gfal2_async_op_t op, GError **err)
+{
+    GError *tmp_err = NULL;
+    GThreadPool *pool = gfal2_async_get_pool(op->context, &tmp_err);
+
+    if (pool) {
+        g_thread_pool_push(pool, op, &tmp_err);
+    }
+
+    if (tmp_err) {
+        op->refcount = 1;
+        gfal2_async_unref(op);
+        gfal2_propagate_prefixed_error(err, tmp_err, __func__);
+        return NULL;
+    }
+    return op;
+}
+
+
+#define GFAL2_ASYNC_CHECK_ARGS(context, url, err) \
+    if ((context) == NULL || (url) == NULL) { \
+        gfal2_set_error(err, gfal2_get_core_quark(), EFAULT, __func__, "context or/and url are incorrect arguments"); \
+        return NULL; \
+    }
+
+
+gfal2_async_op_t gfal2_async_stat(gfal2_context_t context, const char *url, struct stat *buff,
+    gfal2_async_callback callback, void *user_data, GError **err)
+{
+    GFAL2_ASYNC_CHECK_ARGS(context, url, err);
+    gfal2_async_op_t op = gfal2_async_new(context, GFAL2_ASYNC_STAT, url, callback, user_data);
+    op->buffer = buff;
+    return gfal2_async_submit(op, err);
+}
+
+
+gfal2_async_op_t gfal2_async_lstat(gfal2_context_t context, const char *url, struct stat *buff,
+    gfal2_async_callback callback, void *user_data, GError **err)
+{
+    GFAL2_ASYNC_CHECK_ARGS(context, url, err);
+    gfal2_async_op_t op = gfal2_async_new(context, GFAL2_ASYNC_LSTAT, url, callback, user_data);
+    op->buffer = buff;
+    return gfal2_async_submit(op, err);
+}
+
+
+gfal2_async_op_t gfal2_async_access(gfal2_context_t context, const char *url, int amode,
+    gfal2_async_callback callback, void *user_data, GError **err)
+{
+    GFAL2_ASYNC_CHECK_ARGS(context, url, err);
+    gfal2_async_op_t op = gfal2_async_new(context, GFAL2_ASYNC_ACCESS, url, callback, user_data);
+    op->mode = amode;
+    return gfal2_async_submit(op, err);
+}
+
+
+gfal2_async_op_t gfal2_async_checksum(gfal2_context_t context, const char *url, const char *check_type,
+    off_t start_offset, size_t data_length, char *checksum_buffer, size_t buffer_length,
+    gfal2_async_callback callback, void *user_data, GError **err)
+{
+    GFAL2_ASYNC_CHECK_ARGS(context, url, err);
+    gfal2_async_op_t op = gfal2_async_new(context, GFAL2_ASYNC_CHECKSUM, url, callback, user_data);
+    op->name = g_strdup(check_type);
+    op->offset = start_offset;
+    op->length = data_length;
+    op->buffer = checksum_buffer;
+    op->buffer_size = buffer_length;
+    return gfal2_async_submit(op, err);
+}
+
+
+gfal2_async_op_t gfal2_async_unlink(gfal2_context_t context, const char *url,
+    gfal2_async_callback callback, void *user_data, GError **err)
+{
+    GFAL2_ASYNC_CHECK_ARGS(context, url, err);
+    gfal2_async_op_t op = gfal2_async_new(context, GFAL2_ASYNC_UNLINK, url, callback, user_data);
+    return gfal2_async_submit(op, err);
+}
+
+
+gfal2_async_op_t gfal2_async_mkdir_rec(gfal2_context_t context, const char *url, mode_t mode,
+    gfal2_async_callback callback, void *user_data, GError **err)
+{
+    GFAL2_ASYNC_CHECK_ARGS(context, url, err);
+    gfal2_async_op_t op = gfal2_async_new(context, GFAL2_ASYNC_MKDIR_REC, url, callback, user_data);
+    op->mode = mode;
+    return gfal2_async_submit(op, err);
+}
+
+
+gfal2_async_op_t gfal2_async_rmdir(gfal2_context_t context, const char *url,
+    gfal2_async_callback callback, void *user_data, GError **err)
+{
+    GFAL2_ASYNC_CHECK_ARGS(context, url, err);
+    gfal2_async_op_t op = gfal2_async_new(context, GFAL2_ASYNC_RMDIR, url, callback, user_data);
+    return gfal2_async_submit(op, err);
+}
+
+
+gfal2_async_op_t gfal2_async_rename(gfal2_context_t context, const char *oldurl, const char *newurl,
+    gfal2_async_callback callback, void *user_data, GError **err)
+{
+    GFAL2_ASYNC_CHECK_ARGS(context, oldurl, err);
+    GFAL2_ASYNC_CHECK_ARGS(context, newurl, err);
+    gfal2_async_op_t op = gfal2_async_new(context, GFAL2_ASYNC_RENAME, oldurl, callback, user_data);
+    op->url2 = g_strdup(newurl);
+    return gfal2_async_submit(op, err);
+}
+
+
+gfal2_async_op_t gfal2_async_getxattr(gfal2_context_t context, const char *url, const char *name,
+    void *value, size_t size, gfal2_async_callback callback, void *user_data, GError **err)
+{
+    GFAL2_ASYNC_CHECK_ARGS(context, url, err);
+    gfal2_async_op_t op = gfal2_async_new(context, GFAL2_ASYNC_GETXATTR, url, callback, user_data);
+    op->name = g_strdup(name);
+    op->buffer = value;
+    op->buffer_size = size;
+    return gfal2_async_submit(op, err);
+}
+
+
+gfal2_async_op_t gfal2_async_bring_online(gfal2_context_t context, const char *url,
+    time_t pintime, time_t timeout, char *token, size_t tsize, int async,
+    gfal2_async_callback callback, void *user_data, GError **err)
+{
+    GFAL2_ASYNC_CHECK_ARGS(context, url, err);
+    gfal2_async_op_t op = gfal2_async_new(context, GFAL2_ASYNC_BRING_ONLINE, url, callback, user_data);
+    op->pintime = pintime;
+    op->timeout = timeout;
+    op->buffer = token;
+    op->buffer_size = tsize;
+    op->async = async;
+    return gfal2_async_submit(op, err);
+}
+
+
+gfal2_async_op_t gfal2_async_bring_online_poll(gfal2_context_t context, const char *url, const char *token,
+    gfal2_async_callback callback, void *user_data, GError **err)
+{
+    GFAL2_ASYNC_CHECK_ARGS(context, url, err);
+    gfal2_async_op_t op = gfal2_async_new(context, GFAL2_ASYNC_BRING_ONLINE_POLL, url, callback, user_data);
+    op->name = g_strdup(token);
+    return gfal2_async_submit(op, err);
+}
+
+
+gboolean gfal2_async_is_done(gfal2_async_op_t op)
+{
+    gboolean done;
+    g_return_val_if_fail(op != NULL, FALSE);
+    g_mutex_lock(op->lock);
+    done = (op->state == GFAL2_ASYNC_DONE);
+    g_mutex_unlock(op->lock);
+    return done;
+}
+
+
+gboolean gfal2_async_wait(gfal2_async_op_t op, int timeout)
+{
+    gboolean done;
+    GTimeVal deadline;
+
+    g_return_val_if_fail(op != NULL, FALSE);
+
+    g_get_current_time(&deadline);
+    g_time_val_add(&deadline, (glong)timeout * G_USEC_PER_SEC);
+
+    g_mutex_lock(op->lock);
+    while (op->state != GFAL2_ASYNC_DONE) {
+        if (timeout < 0) {
+            g_cond_wait(op->done_cond, op->lock);
+        }
+        else if (!g_cond_timed_wait(op->done_cond, op->lock, &deadline)) {
+            break;
+        }
+    }
+    done = (op->state == GFAL2_ASYNC_DONE);
+    g_mutex_unlock(op->lock);
+    return done;
+}
+
+
+ssize_t gfal2_async_get_result(gfal2_async_op_t op, GError **err)
+{
+    ssize_t result = -1;
+
+    if (op == NULL) {
+        gfal2_set_error(err, gfal2_get_core_quark(), EFAULT, __func__, "Invalid operation handle");
+        return -1;
+    }
+
+    g_mutex_lock(op->lock);
+    if (op->state != GFAL2_ASYNC_DONE) {
+        gfal2_set_error(err, gfal2_get_core_quark(), EAGAIN, __func__, "Operation not completed yet");
+    }
+    else {
+        result = op->result;
+        if (op->error && err) {
+            *err = g_error_copy(op->error);
+        }
+    }
+    g_mutex_unlock(op->lock);
+    return result;
+}
+
+
+int gfal2_async_cancel(gfal2_async_op_t op)
+{
+    gboolean cancelled = FALSE;
+
+    g_return_val_if_fail(op != NULL, -1);
+
+    g_mutex_lock(op->lock);
+    if (op->state == GFAL2_ASYNC_QUEUED) {
+        // Mark as running so the worker skips it, complete it from here
+        op->state = GFAL2_ASYNC_RUNNING;
+        cancelled = TRUE;
+    }
+    g_mutex_unlock(op->lock);
+
+    if (!cancelled)
+        return -1;
+
+    GError *tmp_err = NULL;
+    gfal2_set_error(&tmp_err, gfal2_get_core_quark(), ECANCELED, __func__, "Operation cancelled");
+    // The executor still holds its reference, it is released by the worker
+    g_atomic_int_inc(&op->refcount);
+    gfal2_async_complete(op, -1, tmp_err);
+    return 0;
+}
+
+
+void gfal2_async_free(gfal2_async_op_t op)
+{
+    if (op == NULL)
+        return;
+    g_mutex_lock(op->lock);
+    op->detached = TRUE;
+    g_mutex_unlock(op->lock);
+    gfal2_async_unref(op);
+}
+
+
+void *gfal2_async_get_user_data(gfal2_async_op_t op)
+{
+    g_return_val_if_fail(op != NULL, NULL);
+    return op->user_data;
+}
+
+
+int gfal2_async_get_fd(gfal2_context_t context, GError **err)
+{
+    GError *tmp_err = NULL;
+
+    if (context == NULL) {
+        gfal2_set_error(err, gfal2_get_core_quark(), EFAULT, __func__, "Invalid context");
+        return -1;
+    }
+    if (gfal2_async_get_pool(context, &tmp_err) == NULL) {
+        gfal2_propagate_prefixed_error(err, tmp_err, __func__);
+        return -1;
+    }
+
+    g_mutex_lock(context->mux_async);
+    if (context->async_fd[0] < 0) {
+#ifdef __linux__
+        // Semaphore semantics, so each read consumes exactly one completion
+        int fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC | EFD_SEMAPHORE);
+        if (fd >= 0) {
+            context->async_fd[0] = context->async_fd[1] = fd;
+        }
+#else
+        if (pipe(context->async_fd) == 0) {
+            fcntl(context->async_fd[0], F_SETFL, O_NONBLOCK);
+            fcntl(context->async_fd[1], F_SETFL, O_NONBLOCK);
+        }
+        else {
+            context->async_fd[0] = context->async_fd[1] = -1;
+        }
+#endif
+        if (context->async_fd[0] < 0) {
+            gfal2_set_error(&tmp_err, gfal2_get_core_quark(), errno, __func__,
+                "Could not create the completion descriptor: %s", strerror(errno));
+        }
+        else {
+            // Account for operations that completed before the descriptor existed
+            gint pending = g_async_queue_length(context->async_completed);
+            for (; pending > 0; --pending) {
+                gfal2_async_signal_fd(context);
+            }
+        }
+    }
+    g_mutex_unlock(context->mux_async);
+
+    if (tmp_err) {
+        gfal2_propagate_prefixed_error(err, tmp_err, __func__);
+        return -1;
+    }
+    return context->async_fd[0];
+}
+
+
+gfal2_async_op_t gfal2_async_next_completed(gfal2_context_t context)
+{
+    gfal2_async_op_t op;
+    gboolean detached;
+
+    g_return_val_if_fail(context != NULL, NULL);
+    if (context->async_completed == NULL)
+        return NULL;
+
+    do {
+        op = (gfal2_async_op_t)g_async_queue_try_pop(context->async_completed);
+        if (op == NULL)
+            return NULL;
+
+        if (context->async_fd[0] >= 0) {
+#ifdef __linux__
+            uint64_t count;
+            ssize_t ret = read(context->async_fd[0], &count, sizeof(count));
+#else
+            char one;
+            ssize_t ret = read(context->async_fd[0], &one, sizeof(one));
+#endif
+            (void) ret;
+        }
+
+        g_mutex_lock(op->lock);
+        detached = op->detached;
+        g_mutex_unlock(op->lock);
+
+        // Drop the executor reference, the caller keeps its own
+        // If the caller already released the handle, this frees the operation
+        gfal2_async_unref(op);
+    } while (detached);
+
+    return op;
+}
+
+
+void gfal2_async_init(gfal2_context_t context)
+{
+    context->mux_async = g_mutex_new();
+    context->async_pool = NULL;
+    context->async_completed = NULL;
+    context->async_fd[0] = context->async_fd[1] = -1;
+    context->async_running = 0;
+    context->async_idle = g_cond_new();
+}
+
+
+void gfal2_async_release(gfal2_context_t context)
+{
+    if (context->async_pool) {
+        // Let queued operations run to completion before the context goes away
+        g_thread_pool_free(context->async_pool, FALSE, TRUE);
+    }
+    // and the ones started by the plugins
+    g_mutex_lock(context->mux_async);
+    while (context->async_running > 0)
+        g_cond_wait(context->async_idle, context->mux_async);
+    g_mutex_unlock(context->mux_async);
+    if (context->async_completed) {
+        gfal2_async_op_t op;
+        while ((op = (gfal2_async_op_t)g_async_queue_try_pop(context->async_completed)) != NULL) {
+            gfal2_async_unref(op);
+        }
+        g_async_queue_unref(context->async_completed);
+    }
+    if (context->async_fd[0] >= 0) {
+        close(context->async_fd[0]);
+        if (context->async_fd[1] != context->async_fd[0])
+            close(context->async_fd[1]);
+    }
+    g_cond_free(context->async_idle);
+    g_mutex_free(context->mux_async);
+}
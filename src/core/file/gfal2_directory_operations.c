@@ -19,6 +19,8 @@
  */
 
 #include <regex.h>
+#include <stddef.h>
+#include <string.h>
 #include <file/gfal_file_api.h>
 
 #include <common/gfal_handle.h>
@@ -161,6 +163,60 @@ struct dirent *gfal2_readdirpp(gfal2_context_t context, DIR *dir,
 }
 
 
+// Fill the batch one entry at a time, for plugins without native support
+static ssize_t gfal_rw_gfalfilehandle_readdir_batch(gfal2_context_t context, gfal_file_handle fh,
+    gfal2_dir_entry_t *entries, size_t nentries, GError **err)
+{
+    GError *tmp_err = NULL;
+    size_t i;
+
+    for (i = 0; i < nentries; ++i) {
+        struct dirent *ent = gfal_rw_gfalfilehandle_readdirpp(context, fh, &entries[i].st, &tmp_err);
+        if (ent == NULL)
+            break;
+        // The dirent may be shorter than sizeof(struct dirent)
+        memcpy(&entries[i].dirent, ent, offsetof(struct dirent, d_name));
+        g_strlcpy(entries[i].dirent.d_name, ent->d_name, sizeof(entries[i].dirent.d_name));
+    }
+
+    if (tmp_err) {
+        gfal2_propagate_prefixed_error(err, tmp_err, __func__);
+        return -1;
+    }
+    return i;
+}
+
+
+ssize_t gfal2_readdir_batch(gfal2_context_t context, DIR *dir,
+    gfal2_dir_entry_t *entries, size_t nentries, GError **err)
+{
+    GError *tmp_err = NULL;
+    ssize_t res = -1;
+    GFAL2_BEGIN_SCOPE_CANCEL(context, -1, err);
+    if (dir == NULL || context == NULL || entries == NULL) {
+        g_set_error(&tmp_err, gfal2_get_core_quark(), EFAULT,
+            "file descriptor, handle or/and entries are NULL");
+    }
+    else if (nentries == 0) {
+        g_set_error(&tmp_err, gfal2_get_core_quark(), EINVAL,
+            "the number of entries must be greater than 0");
+    }
+    else {
+        const int key = GPOINTER_TO_INT(dir);
+        gfal_file_handle fh = gfal_file_handle_bind(context->fdescs, key, &tmp_err);
+        if (fh != NULL) {
+            res = gfal_plugin_readdir_batchG(context, fh, entries, nentries, &tmp_err);
+            if (tmp_err && tmp_err->code == EPROTONOSUPPORT) {
+                g_clear_error(&tmp_err);
+                res = gfal_rw_gfalfilehandle_readdir_batch(context, fh, entries, nentries, &tmp_err);
+            }
+        }
+    }
+    GFAL2_END_SCOPE_CANCEL(context);
+    G_RETURN_ERR(res, tmp_err, err);
+}
+
+
 int gfal2_closedir(gfal2_context_t handle, DIR *d, GError **err)
 {
     GError *tmp_err = NULL;
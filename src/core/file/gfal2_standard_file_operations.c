@@ -21,6 +21,7 @@
 #include <file/gfal_file_api.h>
 
 #include <common/gfal_handle.h>
+#include <common/gfal_admission.h>
 #include <common/gfal_plugin.h>
 #include <common/gfal_error.h>
 #include <common/gfal_cancel.h>
@@ -675,10 +676,12 @@ int gfal2_checksum(gfal2_context_t handle, const char *url, const char *check_ty
     GError *tmp_err = NULL;
     gfal_plugin_interface *p = gfal_find_plugin(handle, url, GFAL_PLUGIN_CHECKSUM, &tmp_err);
 
-    if (p) {
+    gfal_admission_t slot;
+    if (p && gfal_admission_enter(handle, p->getName(), url, &slot, &tmp_err) == 0) {
         res = p->checksum_calcG(gfal_get_plugin_handle(p), url, check_type, checksum_buffer, buffer_length,
             start_offset,
             data_length, &tmp_err);
+        gfal_admission_exit(slot);
     }
     GFAL2_END_SCOPE_CANCEL(handle);
 
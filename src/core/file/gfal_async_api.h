@@ -0,0 +1,221 @@
+/*
+ * Copyright (c) CERN 2013-2017
+ *
+ * Copyright (c) Members of the EMI Collaboration. 2010-2013
+ * See  http://www.eu-emi.eu/partners for details on the copyright
+ *  holders.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+#ifndef GFAL_ASYNC_API_H_
+#define GFAL_ASYNC_API_H_
+
+#if !defined(__GFAL2_H_INSIDE__) && !defined(__GFAL2_BUILD__)
+#   warning "Direct inclusion of gfal2 headers is deprecated. Please, include only gfal_api.h or gfal_plugins_api.h"
+#endif
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <glib.h>
+
+#include <common/gfal_common.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+
+/*!
+    \defgroup async_group GFAL 2.0 asynchronous file API
+
+    Convenience wrappers running the \ref file_group functions in the background.
+
+    Each gfal2_async_* call queues the operation on the thread pool of the context
+    and returns immediately an operation handle. When the plugin has an asynchronous
+    entry point for the operation (stat_asyncG, implemented by the xrootd plugin), the
+    worker thread only sends the request and is free again, the plugin completing the
+    operation from its own threads. Otherwise, the plugin is driven through its blocking
+    entry point: the operation occupies one worker thread until done, so at most
+    CORE:ASYNC_THREADS of those progress at the same time, and the others wait in the queue.
+
+    The completion is notified either by the callback given at submission time, executed from a worker thread,
+    or, if no callback is given, by pushing the operation into the completion queue of
+    the context. The completion queue can be integrated into an existing event loop
+    using the descriptor returned by \ref gfal2_async_get_fd.
+
+    Output buffers given at submission (stat structure, checksum buffer, token...)
+    belong to the caller and must remain valid until the operation completes.
+*/
+
+/*!
+    \addtogroup async_group
+    @{
+*/
+
+/**
+ * Handle of an asynchronous operation
+ */
+typedef struct _gfal2_async_op* gfal2_async_op_t;
+
+/**
+ * Completion callback
+ * Called from a worker thread once the operation is done.
+ * The handle is still owned by the caller, and must be released with \ref gfal2_async_free
+ */
+typedef void (*gfal2_async_callback)(gfal2_async_op_t op, void* user_data);
+
+/**
+ * @brief asynchronous version of \ref gfal2_stat
+ * @return an operation handle, or NULL and err is set if the operation could not be queued
+ */
+gfal2_async_op_t gfal2_async_stat(gfal2_context_t context, const char* url, struct stat* buff,
+        gfal2_async_callback callback, void* user_data, GError** err);
+
+/**
+ * @brief asynchronous version of \ref gfal2_lstat
+ */
+gfal2_async_op_t gfal2_async_lstat(gfal2_context_t context, const char* url, struct stat* buff,
+        gfal2_async_callback callback, void* user_data, GError** err);
+
+/**
+ * @brief asynchronous version of \ref gfal2_access
+ */
+gfal2_async_op_t gfal2_async_access(gfal2_context_t context, const char* url, int amode,
+        gfal2_async_callback callback, void* user_data, GError** err);
+
+/**
+ * @brief asynchronous version of \ref gfal2_checksum
+ */
+gfal2_async_op_t gfal2_async_checksum(gfal2_context_t context, const char* url, const char* check_type,
+        off_t start_offset, size_t data_length, char* checksum_buffer, size_t buffer_length,
+        gfal2_async_callback callback, void* user_data, GError** err);
+
+/**
+ * @brief asynchronous version of \ref gfal2_unlink
+ */
+gfal2_async_op_t gfal2_async_unlink(gfal2_context_t context, const char* url,
+        gfal2_async_callback callback, void* user_data, GError** err);
+
+/**
+ * @brief asynchronous version of \ref gfal2_mkdir_rec
+ */
+gfal2_async_op_t gfal2_async_mkdir_rec(gfal2_context_t context, const char* url, mode_t mode,
+        gfal2_async_callback callback, void* user_data, GError** err);
+
+/**
+ * @brief asynchronous version of \ref gfal2_rmdir
+ */
+gfal2_async_op_t gfal2_async_rmdir(gfal2_context_t context, const char* url,
+        gfal2_async_callback callback, void* user_data, GError** err);
+
+/**
+ * @brief asynchronous version of \ref gfal2_rename
+ */
+gfal2_async_op_t gfal2_async_rename(gfal2_context_t context, const char* oldurl, const char* newurl,
+        gfal2_async_callback callback, void* user_data, GError** err);
+
+/**
+ * @brief asynchronous version of \ref gfal2_getxattr
+ */
+gfal2_async_op_t gfal2_async_getxattr(gfal2_context_t context, const char* url, const char* name,
+        void* value, size_t size,
+        gfal2_async_callback callback, void* user_data, GError** err);
+
+/**
+ * @brief asynchronous version of \ref gfal2_bring_online
+ */
+gfal2_async_op_t gfal2_async_bring_online(gfal2_context_t context, const char* url,
+        time_t pintime, time_t timeout, char* token, size_t tsize, int async,
+        gfal2_async_callback callback, void* user_data, GError** err);
+
+/**
+ * @brief asynchronous version of \ref gfal2_bring_online_poll
+ */
+gfal2_async_op_t gfal2_async_bring_online_poll(gfal2_context_t context, const char* url, const char* token,
+        gfal2_async_callback callback, void* user_data, GError** err);
+
+/**
+ * @brief check if an operation is done
+ * @return TRUE if the operation has completed (successfully, with an error, or cancelled)
+ */
+gboolean gfal2_async_is_done(gfal2_async_op_t op);
+
+/**
+ * @brief wait for the completion of an operation
+ * @param op : operation handle
+ * @param timeout : maximum time to wait, in seconds. A negative value waits forever
+ * @return TRUE if the operation completed, FALSE on timeout
+ */
+gboolean gfal2_async_wait(gfal2_async_op_t op, int timeout);
+
+/**
+ * @brief get the result of a completed operation
+ *
+ * Return the value that would have been returned by the equivalent blocking call
+ * @param op : operation handle
+ * @param err : GError error report, set to a copy of the operation error
+ * @return the operation return value, -1 with err set to EAGAIN if the operation is not done yet
+ */
+ssize_t gfal2_async_get_result(gfal2_async_op_t op, GError** err);
+
+/**
+ * @brief cancel an operation
+ *
+ * An operation still waiting in the queue is completed with ECANCELED.
+ * An operation already running is not interrupted, use \ref gfal2_cancel for that.
+ * @return 0 if the operation was cancelled, -1 if it was already running or done
+ */
+int gfal2_async_cancel(gfal2_async_op_t op);
+
+/**
+ * @brief release an operation handle
+ *
+ * Can be called before completion; the operation is then detached and its result discarded
+ */
+void gfal2_async_free(gfal2_async_op_t op);
+
+/**
+ * @brief get the user data associated with the operation
+ */
+void* gfal2_async_get_user_data(gfal2_async_op_t op);
+
+/**
+ * @brief get a pollable descriptor for the completion queue
+ *
+ * The descriptor becomes readable when operations submitted without callback complete.
+ * It must not be closed by the caller.
+ * @return a file descriptor, or -1 and err is set
+ */
+int gfal2_async_get_fd(gfal2_context_t context, GError** err);
+
+/**
+ * @brief pop a completed operation from the completion queue
+ *
+ * Only operations submitted without callback are pushed in the completion queue
+ * @return a completed operation, or NULL if none is available
+ */
+gfal2_async_op_t gfal2_async_next_completed(gfal2_context_t context);
+
+/**
+    @}
+    End of the ASYNC group
+*/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* GFAL_ASYNC_API_H_ */
@@ -0,0 +1,33 @@
+/*
+ * Copyright (c) CERN 2013-2017
+ *
+ * Copyright (c) Members of the EMI Collaboration. 2010-2013
+ *  See  http://www.eu-emi.eu/partners for details on the copyright
+ *  holders.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+#ifndef GFAL_ASYNC_INTERNAL_H_
+#define GFAL_ASYNC_INTERNAL_H_
+
+#include <common/gfal_common.h>
+
+// setup the asynchronous executor fields of a new context, internal
+void gfal2_async_init(gfal2_context_t context);
+
+// wait for the pending asynchronous operations and release the executor, internal
+void gfal2_async_release(gfal2_context_t context);
+
+#endif /* GFAL_ASYNC_INTERNAL_H_ */
@@ -229,6 +229,31 @@ struct dirent* gfal2_readdir(gfal2_context_t context, DIR* d, GError ** err);
  */
 struct dirent* gfal2_readdirpp(gfal2_context_t context, DIR* d, struct stat* st, GError ** err);
 
+/**
+ * Directory entry and its meta-data, as returned by \ref gfal2_readdir_batch
+ */
+typedef struct {
+    struct dirent dirent;
+    struct stat st;
+} gfal2_dir_entry_t;
+
+/**
+ * @brief return the next directory entries, with their meta-data
+ *
+ * Same as \ref gfal2_readdirpp, but fills up to nentries entries in one call,
+ * which reduces the per-entry overhead for large listings
+ *
+ * @param context : gfal2 handle, see \ref gfal2_context_new
+ * @param d : directory handle created by \ref gfal2_opendir
+ * @param entries : array where the entries are stored
+ * @param nentries : size of entries, must be greater than 0
+ * @param err : GError error report
+ * @return the number of entries stored, 0 at the end of the listing, or -1 if error occurs.
+ *  On error, the entries read by this call are lost.
+ */
+ssize_t gfal2_readdir_batch(gfal2_context_t context, DIR* d, gfal2_dir_entry_t* entries, size_t nentries,
+        GError ** err);
+
 /**
  * @brief close a directory handle
  *
@@ -42,6 +42,9 @@
 /* main gfal2 API for file operations */
 #include <file/gfal_file_api.h>
 
+/* asynchronous file operations */
+#include <file/gfal_async_api.h>
+
 /* operation control API */
 #include <common/gfal_cancel.h>
 
@@ -54,6 +57,12 @@
 /* error helpers*/
 #include <common/gfal_error.h>
 
+/* operation metrics */
+#include <common/gfal_metrics.h>
+
+/* operation traces */
+#include <common/gfal_trace.h>
+
 #undef __GFAL2_H_INSIDE__
 
 #endif  /* GFAL2_API_H_ */
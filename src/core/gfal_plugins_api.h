@@ -26,6 +26,7 @@
 
 #include <common/gfal_plugin_interface.h>
 #include <common/gfal_file_handle.h>
+#include <common/gfal_poll_scheduler.h>
 #include <transfer/gfal_transfer_plugins.h>
 
 #undef __GFAL2_H_INSIDE__
@@ -25,17 +25,244 @@
 
 #include "gfal_logger.h"
 
+// Number of messages per thread ring, must be a power of two
+#define GFAL2_LOG_RING_SIZE 128
+// Messages longer than this are truncated in asynchronous mode, and structured messages always
+#define GFAL2_LOG_MSG_SIZE 1024
+// Upper bound for the idle wait of the delivery thread, in case a wake up is missed
+#define GFAL2_LOG_IDLE_USEC 100000
+
+#define GFAL2_LOG_MAX_SUBSYSTEMS 32
+#define GFAL2_LOG_SUBSYSTEM_LEN 32
+
 
 static GLogLevelFlags gfal2_log_level = G_LOG_LEVEL_WARNING;
 
 
+typedef struct {
+    char name[GFAL2_LOG_SUBSYSTEM_LEN];
+    volatile gint level;
+} gfal2_log_subsystem;
+
+// Entries are never removed, so readers do not need the lock
+static gfal2_log_subsystem log_subsystems[GFAL2_LOG_MAX_SUBSYSTEMS];
+static volatile gint log_subsystems_count = 0;
+static pthread_mutex_t log_subsystems_lock = PTHREAD_MUTEX_INITIALIZER;
+
+
+typedef struct {
+    GLogLevelFlags level;
+    char message[GFAL2_LOG_MSG_SIZE];
+} gfal2_log_record;
+
+// Single producer (the owner thread), single consumer (whoever holds log_drain_lock)
+typedef struct {
+    volatile guint head;
+    volatile guint tail;
+    volatile gint closed;
+    gfal2_log_record records[GFAL2_LOG_RING_SIZE];
+} gfal2_log_ring;
+
+
+static volatile gint log_async = FALSE;
+static volatile guint log_dropped = 0;
+
+static pthread_key_t log_ring_key;
+static pthread_once_t log_ring_key_once = PTHREAD_ONCE_INIT;
+static GSList *log_rings = NULL;
+static pthread_mutex_t log_rings_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t log_drain_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static pthread_t log_thread;
+static gboolean log_thread_running = FALSE;
+static volatile gint log_thread_stop = FALSE;
+static pthread_mutex_t log_wake_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t log_wake_cond = PTHREAD_COND_INITIALIZER;
+static pthread_mutex_t log_control_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// Set while the thread delivers messages, so anything logged by the handler itself
+// goes synchronously and does not re-enter the rings
+static __thread int log_delivering = 0;
+
+
+static void gfal2_log_ring_release(void *ptr)
+{
+    gfal2_log_ring *ring = (gfal2_log_ring*)ptr;
+    // The ring is freed by the consumer once drained
+    g_atomic_int_set(&ring->closed, TRUE);
+}
+
+
+static void gfal2_log_ring_key_init(void)
+{
+    pthread_key_create(&log_ring_key, gfal2_log_ring_release);
+}
+
+
+static gfal2_log_ring *gfal2_log_get_ring(void)
+{
+    pthread_once(&log_ring_key_once, gfal2_log_ring_key_init);
+
+    gfal2_log_ring *ring = pthread_getspecific(log_ring_key);
+    if (ring == NULL) {
+        ring = g_try_new0(gfal2_log_ring, 1);
+        if (ring == NULL)
+            return NULL;
+        pthread_setspecific(log_ring_key, ring);
+        pthread_mutex_lock(&log_rings_lock);
+        log_rings = g_slist_prepend(log_rings, ring);
+        pthread_mutex_unlock(&log_rings_lock);
+    }
+    return ring;
+}
+
+
+// Hand all the queued messages to the glib handlers
+// Return the number of messages delivered
+static guint gfal2_log_drain(void)
+{
+    guint delivered = 0;
+    GSList *rings, *i;
+
+    pthread_mutex_lock(&log_drain_lock);
+    log_delivering = 1;
+
+    pthread_mutex_lock(&log_rings_lock);
+    rings = g_slist_copy(log_rings);
+    pthread_mutex_unlock(&log_rings_lock);
+
+    for (i = rings; i != NULL; i = g_slist_next(i)) {
+        gfal2_log_ring *ring = (gfal2_log_ring*)i->data;
+        // Read closed before head, so a closed ring seen empty is really empty
+        gboolean closed = g_atomic_int_get(&ring->closed);
+        guint head = g_atomic_int_get((volatile gint*)&ring->head);
+        guint tail = ring->tail;
+
+        for (; tail != head; ++tail) {
+            gfal2_log_record *record = &ring->records[tail & (GFAL2_LOG_RING_SIZE - 1)];
+            g_log("GFAL2", record->level, "%s", record->message);
+            g_atomic_int_set((volatile gint*)&ring->tail, tail + 1);
+            ++delivered;
+        }
+
+        if (closed) {
+            pthread_mutex_lock(&log_rings_lock);
+            log_rings = g_slist_remove(log_rings, ring);
+            pthread_mutex_unlock(&log_rings_lock);
+            g_free(ring);
+        }
+    }
+    g_slist_free(rings);
+
+    guint dropped = g_atomic_int_get((volatile gint*)&log_dropped);
+    if (dropped) {
+        g_atomic_int_add((volatile gint*)&log_dropped, -(gint)dropped);
+        g_log("GFAL2", G_LOG_LEVEL_WARNING, "%u log messages were dropped, the log rings were full", dropped);
+    }
+
+    log_delivering = 0;
+    pthread_mutex_unlock(&log_drain_lock);
+    return delivered;
+}
+
+
+static void *gfal2_log_thread(void *unused)
+{
+    while (!g_atomic_int_get(&log_thread_stop)) {
+        if (gfal2_log_drain() == 0) {
+            struct timespec deadline;
+            clock_gettime(CLOCK_REALTIME, &deadline);
+            deadline.tv_nsec += GFAL2_LOG_IDLE_USEC * 1000;
+            if (deadline.tv_nsec >= 1000000000) {
+                deadline.tv_sec += 1;
+                deadline.tv_nsec -= 1000000000;
+            }
+            pthread_mutex_lock(&log_wake_lock);
+            if (!g_atomic_int_get(&log_thread_stop))
+                pthread_cond_timedwait(&log_wake_cond, &log_wake_lock, &deadline);
+            pthread_mutex_unlock(&log_wake_lock);
+        }
+    }
+    gfal2_log_drain();
+    return NULL;
+}
+
+
+static void gfal2_log_wake(void)
+{
+    pthread_mutex_lock(&log_wake_lock);
+    pthread_cond_signal(&log_wake_cond);
+    pthread_mutex_unlock(&log_wake_lock);
+}
+
+
+// Return the next free record of the calling thread ring, to be filled and then published with
+// gfal2_log_commit, or NULL if the message must not be queued. In that case, *drop is set
+// if the message has been dropped, otherwise it must be delivered synchronously
+static gfal2_log_record *gfal2_log_reserve(GLogLevelFlags level, gfal2_log_ring **ring, gboolean *drop)
+{
+    *drop = FALSE;
+    if (!g_atomic_int_get(&log_async) || log_delivering)
+        return NULL;
+
+    *ring = gfal2_log_get_ring();
+    if (*ring == NULL)
+        return NULL;
+
+    guint head = (*ring)->head;
+    guint tail = g_atomic_int_get((volatile gint*)&(*ring)->tail);
+
+    if (head - tail >= GFAL2_LOG_RING_SIZE) {
+        if (level > G_LOG_LEVEL_WARNING) {
+            g_atomic_int_inc((volatile gint*)&log_dropped);
+            *drop = TRUE;
+        }
+        return NULL;
+    }
+
+    gfal2_log_record *record = &(*ring)->records[head & (GFAL2_LOG_RING_SIZE - 1)];
+    record->level = level;
+    return record;
+}
+
+
+static void gfal2_log_commit(gfal2_log_ring *ring, GLogLevelFlags level)
+{
+    guint head = ring->head;
+    guint tail = g_atomic_int_get((volatile gint*)&ring->tail);
+
+    // g_atomic_int_set is a full barrier, the record is visible before the new head
+    g_atomic_int_set((volatile gint*)&ring->head, head + 1);
+
+    // Wake up the delivery thread if it may have gone idle on an empty ring
+    if (head == tail || level <= G_LOG_LEVEL_WARNING) {
+        gfal2_log_wake();
+    }
+}
+
+
+static void gfal2_log_dispatch(GLogLevelFlags level, const char *msg, va_list args)
+{
+    gfal2_log_ring *ring = NULL;
+    gboolean drop;
+    gfal2_log_record *record = gfal2_log_reserve(level, &ring, &drop);
+
+    if (record) {
+        g_vsnprintf(record->message, sizeof(record->message), msg, args);
+        gfal2_log_commit(ring, level);
+    }
+    else if (!drop) {
+        g_logv("GFAL2", level, msg, args);
+    }
+}
+
 
 void gfal2_log(GLogLevelFlags level, const char* msg, ...)
 {
     if (level <= gfal2_log_level) {
         va_list args;
         va_start(args, msg);
-        g_logv("GFAL2", level, msg, args);
+        gfal2_log_dispatch(level, msg, args);
         va_end(args);
     }
 }
@@ -44,7 +271,7 @@ void gfal2_log(GLogLevelFlags level, const char* msg, ...)
 void gfal2_logv(GLogLevelFlags level, const char* msg, va_list args)
 {
     if (level <= gfal2_log_level) {
-        g_logv("GFAL2", level, msg, args);
+        gfal2_log_dispatch(level, msg, args);
     }
 }
 
@@ -66,3 +293,160 @@ int gfal2_log_set_handler(GLogFunc func, gpointer user_data)
     return g_log_set_handler("GFAL2", G_LOG_LEVEL_MASK, func, user_data);
 }
 
+
+static gfal2_log_subsystem *gfal2_log_find_subsystem(const char *subsystem)
+{
+    gint count = g_atomic_int_get(&log_subsystems_count);
+    gint i;
+    for (i = 0; i < count; ++i) {
+        if (strncmp(log_subsystems[i].name, subsystem, GFAL2_LOG_SUBSYSTEM_LEN) == 0)
+            return &log_subsystems[i];
+    }
+    return NULL;
+}
+
+
+void gfal2_log_set_subsystem_level(const char* subsystem, GLogLevelFlags level)
+{
+    g_return_if_fail(subsystem != NULL);
+
+    pthread_mutex_lock(&log_subsystems_lock);
+    gfal2_log_subsystem *entry = gfal2_log_find_subsystem(subsystem);
+    if (entry == NULL && log_subsystems_count < GFAL2_LOG_MAX_SUBSYSTEMS) {
+        entry = &log_subsystems[log_subsystems_count];
+        g_strlcpy(entry->name, subsystem, sizeof(entry->name));
+        entry->level = level;
+        // Publish the entry only once it is filled
+        g_atomic_int_inc(&log_subsystems_count);
+    }
+    else if (entry) {
+        g_atomic_int_set(&entry->level, level);
+    }
+    pthread_mutex_unlock(&log_subsystems_lock);
+}
+
+
+gboolean gfal2_log_is_enabled(GLogLevelFlags level, const char* subsystem)
+{
+    if (subsystem) {
+        gfal2_log_subsystem *entry = gfal2_log_find_subsystem(subsystem);
+        if (entry)
+            return level <= (GLogLevelFlags)g_atomic_int_get(&entry->level);
+    }
+    return level <= gfal2_log_level;
+}
+
+
+// Append c to the message, silently truncated to its size
+static void gfal2_log_append_c(char *out, size_t size, size_t *len, char c)
+{
+    if (*len + 1 < size) {
+        out[(*len)++] = c;
+        out[*len] = '\0';
+    }
+}
+
+
+static void gfal2_log_append(char *out, size_t size, size_t *len, const char *str)
+{
+    for (; *str; ++str)
+        gfal2_log_append_c(out, size, len, *str);
+}
+
+
+// Append " key=value", the value quoted if it contains spaces or quotes
+static void gfal2_log_append_field(char *out, size_t size, size_t *len, const gfal2_log_field_t *field)
+{
+    const char *value = field->value ? field->value : "";
+    gfal2_log_append_c(out, size, len, ' ');
+    gfal2_log_append(out, size, len, field->key);
+    gfal2_log_append_c(out, size, len, '=');
+    if (*value == '\0' || strpbrk(value, " \t\"=") != NULL) {
+        gfal2_log_append_c(out, size, len, '"');
+        for (; *value; ++value) {
+            if (*value == '"' || *value == '\\')
+                gfal2_log_append_c(out, size, len, '\\');
+            gfal2_log_append_c(out, size, len, *value);
+        }
+        gfal2_log_append_c(out, size, len, '"');
+    }
+    else {
+        gfal2_log_append(out, size, len, value);
+    }
+}
+
+
+// Render "message key=value ..." into out, truncated to size
+static void gfal2_log_format_structured(char *out, size_t size,
+        const gfal2_log_field_t* fields, size_t nfields, const char *msg, va_list args)
+{
+    size_t len, i;
+    int written = g_vsnprintf(out, size, msg, args);
+    len = (written < 0) ? 0 : MIN((size_t)written, size - 1);
+    out[len] = '\0';
+    for (i = 0; i < nfields; ++i) {
+        gfal2_log_append_field(out, size, &len, &fields[i]);
+    }
+}
+
+
+void gfal2_log_structured(GLogLevelFlags level, const char* subsystem,
+        const gfal2_log_field_t* fields, size_t nfields, const char* msg, ...)
+{
+    if (!gfal2_log_is_enabled(level, subsystem))
+        return;
+
+    // Already filtered, bypass gfal2_log so the subsystem level applies.
+    // The message is rendered once, straight into the record when queued
+    gfal2_log_ring *ring = NULL;
+    gboolean drop;
+    gfal2_log_record *record = gfal2_log_reserve(level, &ring, &drop);
+    va_list args;
+
+    if (record) {
+        va_start(args, msg);
+        gfal2_log_format_structured(record->message, sizeof(record->message), fields, nfields, msg, args);
+        va_end(args);
+        gfal2_log_commit(ring, level);
+    }
+    else if (!drop) {
+        char message[GFAL2_LOG_MSG_SIZE];
+        va_start(args, msg);
+        gfal2_log_format_structured(message, sizeof(message), fields, nfields, msg, args);
+        va_end(args);
+        g_log("GFAL2", level, "%s", message);
+    }
+}
+
+
+void gfal2_log_flush(void)
+{
+    if (!log_delivering)
+        gfal2_log_drain();
+}
+
+
+void gfal2_log_set_async(gboolean async)
+{
+    pthread_mutex_lock(&log_control_lock);
+    if (async && !log_thread_running) {
+        g_atomic_int_set(&log_thread_stop, FALSE);
+        if (pthread_create(&log_thread, NULL, gfal2_log_thread, NULL) == 0) {
+            static gboolean atexit_registered = FALSE;
+            if (!atexit_registered) {
+                atexit(gfal2_log_flush);
+                atexit_registered = TRUE;
+            }
+            log_thread_running = TRUE;
+            g_atomic_int_set(&log_async, TRUE);
+        }
+    }
+    else if (!async && log_thread_running) {
+        g_atomic_int_set(&log_async, FALSE);
+        g_atomic_int_set(&log_thread_stop, TRUE);
+        gfal2_log_wake();
+        pthread_join(log_thread, NULL);
+        log_thread_running = FALSE;
+    }
+    pthread_mutex_unlock(&log_control_lock);
+}
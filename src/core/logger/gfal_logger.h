@@ -69,6 +69,52 @@ GLogLevelFlags gfal2_log_get_level(void);
  */
 int gfal2_log_set_handler(GLogFunc func, gpointer user_data);
 
+/**
+ * Key/value pair attached to a structured log message
+ */
+typedef struct {
+    const char* key;
+    const char* value;
+} gfal2_log_field_t;
+
+/**
+ * Log a message with the given level, on behalf of a subsystem (i.e. a plugin name),
+ * followed by a list of key/value fields, rendered as "message key=value ...",
+ * truncated to 1023 characters.
+ * The message is filtered with the subsystem level if one was set with
+ * \ref gfal2_log_set_subsystem_level, with the global level otherwise.
+ */
+void gfal2_log_structured(GLogLevelFlags level, const char* subsystem,
+        const gfal2_log_field_t* fields, size_t nfields, const char* msg, ...);
+
+/**
+ * Set the log level of a subsystem, overriding the global level for
+ * messages logged with \ref gfal2_log_structured
+ */
+void gfal2_log_set_subsystem_level(const char* subsystem, GLogLevelFlags level);
+
+/**
+ * Return TRUE if a message with the given level and subsystem would be logged.
+ * subsystem can be NULL.
+ * Useful to skip the preparation of expensive log messages.
+ */
+gboolean gfal2_log_is_enabled(GLogLevelFlags level, const char* subsystem);
+
+/**
+ * Enable or disable the asynchronous delivery of log messages.
+ * When enabled, messages are formatted once by the calling thread, straight into a
+ * per-thread ring buffer, and handed to the log handler by a background thread.
+ * When a ring is full, debug and info messages are dropped (and counted),
+ * while warnings and errors are delivered synchronously.
+ * Disabled by default. Can be enabled via the configuration CORE:LOG_ASYNC.
+ */
+void gfal2_log_set_async(gboolean async);
+
+/**
+ * Deliver all pending asynchronous messages to the handler before returning
+ */
+void gfal2_log_flush(void);
+
 
 #ifdef __cplusplus
 }
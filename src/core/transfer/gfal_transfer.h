@@ -87,6 +87,7 @@ extern GQuark GFAL_EVENT_TRANSFER_TYPE;   /**< Triggered to register the transfe
 extern GQuark GFAL_EVENT_IPV4;            /**< Triggered to register the transfer is done over IPv4 */
 extern GQuark GFAL_EVENT_IPV6;            /**< Triggered to register the transfer is done over IPv6 */
 extern GQuark GFAL_EVENT_EVICT;           /**< Triggered after a file eviction operation  */
+extern GQuark GFAL_EVENT_RESUME;          /**< Triggered when a transfer resumes from a partial destination */
 
 /**
  * Types for for GFAL_EVENT_TRANSFER_TYPE
@@ -233,6 +234,30 @@ gint gfalt_set_replace_existing_file(gfalt_params_t, gboolean replace, GError**
  */
 gboolean gfalt_get_replace_existing_file(gfalt_params_t,  GError** err);
 
+/**
+ * Value for \ref gfalt_set_offset_from_source: resume from the size of the partial destination
+ */
+#define GFALT_OFFSET_FROM_DESTINATION ((off_t)-1)
+
+/**
+ * Set the offset from which an interrupted transfer is resumed
+ * default : 0, the transfer starts from the beginning
+ * When set, the partial destination is kept and the copy continues at the end of it.
+ * A positive offset must match the size of the partial destination,
+ * GFALT_OFFSET_FROM_DESTINATION accepts whatever size it has.
+ * Unless CORE:COPY_RESUME_VERIFY is false, the data already written is compared
+ * with the source using a ranged checksum. If the destination can not be resumed,
+ * the transfer restarts from the beginning, and the existing destination is
+ * handled as set by \ref gfalt_set_replace_existing_file.
+ * Only honored by the streamed copies.
+ */
+gint gfalt_set_offset_from_source(gfalt_params_t params, off_t offset, GError** err);
+
+/**
+ * Get the offset from which an interrupted transfer is resumed
+ */
+off_t gfalt_get_offset_from_source(gfalt_params_t params, GError** err);
+
 /**
  * Set the strict copy mode
  * default : false
@@ -23,6 +23,7 @@
 #include <transfer/gfal_transfer_plugins.h>
 #include <transfer/gfal_transfer_internal.h>
 #include <common/gfal_cancel.h>
+#include <common/gfal_md_cache.h>
 
 static GQuark scope_copy_domain() {
     return g_quark_from_static_string("GFAL2:CORE:COPY");
@@ -32,6 +33,10 @@ static GQuark scope_copy_domain() {
 static gfal_plugin_interface* find_copy_plugin(gfal2_context_t context, gfal_url2_check operation,
         const char* src, const char* dst, void** plugin_data, GError** error)
 {
+    if (gfal_plugins_load_for_url(context, src, error) < 0 ||
+        gfal_plugins_load_for_url(context, dst, error) < 0)
+        return NULL;
+
     GList* item = g_list_first(context->plugin_opt.sorted_plugin);
     void* resu = NULL;
 
@@ -118,6 +123,7 @@ static int perform_copy(gfal2_context_t context, gfalt_params_t params, const ch
     gfal_plugin_interface* plugin = find_copy_plugin(context, GFAL_FILE_COPY, src, dst,
             &plugin_data, &tmp_err);
 
+    gfal_md_cache_write_begin(context, dst);
     if (tmp_err == NULL) {
         if (plugin == NULL) {
             if (gfalt_get_local_transfer_perm(params, NULL)) {
@@ -134,6 +140,7 @@ static int perform_copy(gfal2_context_t context, gfalt_params_t params, const ch
             res = plugin->copy_file(plugin_data, context, params, src, dst, &tmp_err);
         }
     }
+    gfal_md_cache_write_end(context, dst);
 
     gfal2_log(G_LOG_LEVEL_DEBUG, " <- Gfal::Transfer::FileCopy");
 
@@ -220,6 +227,9 @@ static int perform_bulk_copy(gfal2_context_t context, gfalt_params_t params,
     gfal_plugin_interface *plugin = find_copy_plugin(context, GFAL_BULK_COPY, srcs[0],
             dsts[0], &plugin_data, &tmp_err);
 
+    size_t i;
+    for (i = 0; i < nbfiles; ++i)
+        gfal_md_cache_write_begin(context, dsts[i]);
     if (tmp_err == NULL) {
         if (plugin == NULL) {
             res = bulk_fallback(context, params, nbfiles, srcs, dsts, checksums, op_error,
@@ -230,6 +240,8 @@ static int perform_bulk_copy(gfal2_context_t context, gfalt_params_t params,
                     op_error, file_errors);
         }
     }
+    for (i = 0; i < nbfiles; ++i)
+        gfal_md_cache_write_end(context, dsts[i]);
 
     gfal2_log(G_LOG_LEVEL_DEBUG, " <- Gfal::Transfer::BulkFileCopy");
 
@@ -22,6 +22,7 @@
 
 #include <gfal_api.h>
 #include <common/gfal_plugin_interface.h>
+#include <common/gfal_plugin.h>
 #include <checksums/checksums.h>
 #include "gfal_transfer_plugins.h"
 #include "gfal_transfer_internal.h"
@@ -132,6 +133,7 @@ struct perf_data_t {
     time_t start, last_update, now;
     size_t done;
     size_t done_since_last_update;
+    size_t skipped;
 };
 
 
@@ -143,7 +145,7 @@ static void send_performance_data(gfalt_params_t params, const char* src, const
     time_t inc_time = perf->now - perf->last_update;
 
     status.average_baudrate = (size_t)(perf->done / total_time);
-    status.bytes_transfered = (size_t)(perf->done);
+    status.bytes_transfered = (size_t)(perf->skipped + perf->done);
     status.instant_baudrate = (size_t)(perf->done_since_last_update / inc_time);
     status.transfer_time    = total_time;
 
@@ -151,8 +153,44 @@ static void send_performance_data(gfalt_params_t params, const char* src, const
 }
 
 
+struct copy_progress_t {
+    gfal2_context_t context;
+    gfalt_params_t params;
+    const char *src, *dst;
+    struct perf_data_t perf;
+    time_t timeout;
+};
+
+
+// Account the bytes copied, send the performance markers, and check for cancellation and timeout
+static int streamed_copy_progress(size_t bytes, void* user_data, GError** error)
+{
+    struct copy_progress_t* progress = (struct copy_progress_t*)user_data;
+
+    progress->perf.done += bytes;
+    progress->perf.done_since_last_update += bytes;
+
+    if (gfal2_is_canceled(progress->context)) {
+        g_set_error(error, local_copy_domain(), ECANCELED, "Transfer canceled");
+        return -1;
+    }
+
+    progress->perf.now = time(NULL);
+    if (progress->perf.now >= progress->timeout) {
+        g_set_error(error, local_copy_domain(), ETIMEDOUT, "Transfer canceled because the timeout expired");
+        return -1;
+    }
+    else if (progress->perf.now - progress->perf.last_update > 5) {
+        send_performance_data(progress->params, progress->src, progress->dst, &progress->perf);
+        progress->perf.done_since_last_update = 0;
+        progress->perf.last_update = progress->perf.now;
+    }
+    return 0;
+}
+
+
 static int streamed_copy(gfal2_context_t context, gfalt_params_t params,
-        const char* src, const char* dst, GError** error)
+        const char* src, const char* dst, off_t offset, GError** error)
 {
     GError *nested_error = NULL;
 
@@ -213,41 +251,69 @@ static int streamed_copy(gfal2_context_t context, gfalt_params_t params,
         return -1;
     }
 
-    struct perf_data_t perf_data;
-    perf_data.start = perf_data.now = perf_data.last_update = time(NULL);
-    perf_data.done = perf_data.done_since_last_update = 0;
+#ifdef O_DIRECT
+    // Direct I/O needs aligned offsets, rewrite the tail of the last block
+    if (direct_io) {
+        offset -= offset % (off_t)alignment;
+    }
+#endif
+
+    if (offset > 0) {
+        if (gfal_plugin_lseekG(context, f_src, offset, SEEK_SET, &nested_error) < 0 ||
+            gfal_plugin_lseekG(context, f_dst, offset, SEEK_SET, &nested_error) < 0) {
+            free(buffer);
+            gfal_plugin_closeG(context, f_dst, NULL);
+            gfal_plugin_closeG(context, f_src, NULL);
+            gfal2_propagate_prefixed_error_extended(error, nested_error, __func__, "Could not resume: ");
+            return -1;
+        }
+        plugin_trigger_event(params, local_copy_domain(),
+                GFAL_EVENT_NONE, GFAL_EVENT_RESUME,
+                "%lld", (long long)offset);
+    }
+
+    struct copy_progress_t progress;
+    progress.context = context;
+    progress.params = params;
+    progress.src = src;
+    progress.dst = dst;
+    progress.perf.start = progress.perf.now = progress.perf.last_update = time(NULL);
+    progress.perf.done = progress.perf.done_since_last_update = 0;
+    progress.perf.skipped = offset;
+    progress.timeout = progress.perf.start + gfalt_get_timeout(params, NULL);
 
-    const time_t timeout = perf_data.start + gfalt_get_timeout(params, NULL);
     ssize_t s_file = 1;
 
-    gfal2_log(G_LOG_LEVEL_DEBUG, "  begin local transfer %s ->  %s with buffer size %ld", src, dst, buffersize);
+    // The plugin may be able to do better than a read/write loop
+    gfal_plugin_interface* plugin = gfal_plugin_map_file_handle(context, f_src, NULL);
+    if (plugin && plugin->stream_copyG && plugin == gfal_plugin_map_file_handle(context, f_dst, NULL)) {
+        gfal2_log(G_LOG_LEVEL_DEBUG, "  begin local transfer %s ->  %s done by %s", src, dst, plugin->getName());
+        s_file = 0;
+        ssize_t copied = plugin->stream_copyG(gfal_get_plugin_handle(plugin), f_src, f_dst, buffersize,
+                streamed_copy_progress, &progress, &nested_error);
+        if (copied < 0 && nested_error == NULL) {
+            g_set_error(&nested_error, local_copy_domain(), EIO,
+                "%s failed to copy the data without reporting an error", plugin->getName());
+        }
+        else if (copied < 0 && nested_error->code == ENOSYS) {
+            gfal2_log(G_LOG_LEVEL_DEBUG, "  %s can not do the copy, fall back to the read/write loop: %s",
+                plugin->getName(), nested_error->message);
+            g_clear_error(&nested_error);
+            s_file = 1;
+        }
+    }
+
+    if (s_file > 0) {
+        gfal2_log(G_LOG_LEVEL_DEBUG, "  begin local transfer %s ->  %s with buffer size %ld", src, dst, buffersize);
+    }
 
     while (s_file > 0 && !nested_error) {
         s_file = gfal_plugin_readG(context, f_src, buffer, buffersize, &nested_error);
         if (s_file > 0) {
             gfal_plugin_writeG(context, f_dst, buffer, s_file, &nested_error);
         }
-
-        perf_data.done += s_file;
-        perf_data.done_since_last_update += s_file;
-
-        // Make sure we don't have to cancel
-        if (gfal2_is_canceled(context)) {
-            if (nested_error == NULL)
-                g_set_error(&nested_error, local_copy_domain(), ECANCELED, "Transfer canceled");
-        }
-        // Timed-out?
-        else {
-            perf_data.now = time(NULL);
-            if (perf_data.now >= timeout) {
-                if (nested_error == NULL)
-                    g_set_error(&nested_error, local_copy_domain(), ETIMEDOUT, "Transfer canceled because the timeout expired");
-            }
-            else if (perf_data.now - perf_data.last_update > 5) {
-                send_performance_data(params, src, dst, &perf_data);
-                perf_data.done_since_last_update = 0;
-                perf_data.last_update = perf_data.now;
-            }
+        if (!nested_error) {
+            streamed_copy_progress((s_file > 0) ? s_file : 0, &progress, &nested_error);
         }
     }
     free(buffer);
@@ -278,6 +344,7 @@ int perform_local_copy(gfal2_context_t context, gfalt_params_t params,
     char source_checksum[1024] = {0};
     gboolean is_strict_mode = gfalt_get_strict_copy_mode(params, NULL);
     gfalt_checksum_mode_t checksum_mode = GFALT_CHECKSUM_NONE;
+    off_t resume_offset = 0;
 
     if (!is_strict_mode) {
         checksum_mode = gfalt_get_checksum(params,
@@ -318,8 +385,15 @@ int perform_local_copy(gfal2_context_t context, gfalt_params_t params,
             return -1;
         }
 
+        // Keep the partial destination if the transfer can be resumed
+        resume_offset = gfalt_get_resume_offset(context, params, src, dst, &nested_error);
+        if (nested_error != NULL) {
+            gfal2_propagate_prefixed_error(error, nested_error, __func__);
+            return -1;
+        }
+
         // Remove if exists and overwrite is set
-        if (!is_strict_mode) {
+        if (resume_offset == 0) {
             unlink_if_exists(context, params, dst, &nested_error);
             if (nested_error != NULL) {
                 gfal2_propagate_prefixed_error(error, nested_error, __func__);
@@ -329,7 +403,7 @@ int perform_local_copy(gfal2_context_t context, gfalt_params_t params,
     }
 
     // Do the transfer
-    streamed_copy(context, params, src, dst, &nested_error);
+    streamed_copy(context, params, src, dst, resume_offset, &nested_error);
     if (nested_error != NULL) {
         gfal2_propagate_prefixed_error(error, nested_error, __func__);
         return -1;
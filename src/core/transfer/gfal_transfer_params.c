@@ -192,6 +192,13 @@ gint gfalt_set_offset_from_source(gfalt_params_t params, off_t offset, GError**
 }
 
 
+off_t gfalt_get_offset_from_source(gfalt_params_t params, GError** err)
+{
+    g_return_val_err_if_fail(params != NULL, -1, err, "[BUG] invalid params handle");
+    return params->start_offset;
+}
+
+
 static GSList* gfalt_search_callback(GSList* list, gpointer callback)
 {
     struct _gfalt_callback_entry* entry;
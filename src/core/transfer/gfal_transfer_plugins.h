@@ -64,6 +64,19 @@ int plugin_trigger_event(gfalt_params_t params, GQuark domain,
 int plugin_trigger_monitor(gfalt_params_t params, gfalt_transfer_status_t status,
         const char* src, const char* dst);
 
+/**
+ * Resolve the offset a streamed copy can resume from, as requested with
+ * \ref gfalt_set_offset_from_source
+ * @param context The gfal2 context.
+ * @param params  The transfer parameters.
+ * @param src     Source surl.
+ * @param dst     Destination surl.
+ * @return the number of bytes already present at the destination, 0 if the copy
+ *         must start from the beginning, -1 on error
+ */
+off_t gfalt_get_resume_offset(gfal2_context_t context, gfalt_params_t params,
+        const char* src, const char* dst, GError** err);
+
 /**
  * Convenience error methods for copy implementations
  */
@@ -18,10 +18,13 @@
  * limitations under the License.
  */
 
+#include <errno.h>
 #include <stdio.h>
 #include <glib.h>
 #include <time.h>
 
+#include <gfal_api.h>
+#include <checksums/checksums.h>
 #include <transfer/gfal_transfer_internal.h>
 #include <common/gfal_error.h>
 
@@ -45,6 +48,7 @@ GQuark GFAL_EVENT_TRANSFER_TYPE;
 GQuark GFAL_EVENT_IPV4;
 GQuark GFAL_EVENT_IPV6;
 GQuark GFAL_EVENT_EVICT;
+GQuark GFAL_EVENT_RESUME;
 
 
 __attribute__((constructor))
@@ -67,6 +71,7 @@ static void init_event_quarks() {
     GFAL_EVENT_IPV4 = g_quark_from_static_string("IPV4");
     GFAL_EVENT_IPV6 = g_quark_from_static_string("IPV6");
     GFAL_EVENT_EVICT = g_quark_from_static_string("EVICT");
+    GFAL_EVENT_RESUME = g_quark_from_static_string("RESUME");
 }
 
 
@@ -178,3 +183,76 @@ void gfalt_set_error(GError **err, GQuark domain, gint code, const gchar *functi
     else
         gfal2_set_error(err, domain, code, function, "%s %s", side, buffer);
 }
+
+
+off_t gfalt_get_resume_offset(gfal2_context_t context, gfalt_params_t params,
+        const char* src, const char* dst, GError** err)
+{
+    off_t requested = gfalt_get_offset_from_source(params, NULL);
+    if (requested == 0) {
+        return 0;
+    }
+
+    GError* nested_error = NULL;
+    struct stat dst_stat, src_stat;
+    if (gfal2_stat(context, dst, &dst_stat, &nested_error) != 0) {
+        if (nested_error->code == ENOENT) {
+            gfal2_log(G_LOG_LEVEL_DEBUG, "Nothing to resume, %s does not exist", dst);
+            g_error_free(nested_error);
+            return 0;
+        }
+        gfal2_propagate_prefixed_error(err, nested_error, __func__);
+        return -1;
+    }
+
+    off_t offset = dst_stat.st_size;
+    if (!S_ISREG(dst_stat.st_mode) || offset == 0) {
+        return 0;
+    }
+    if (requested > 0 && requested != offset) {
+        gfal2_log(G_LOG_LEVEL_WARNING, "Can not resume at %lld, the destination holds %lld bytes",
+                (long long)requested, (long long)offset);
+        return 0;
+    }
+
+    if (gfal2_stat(context, src, &src_stat, &nested_error) != 0) {
+        gfal2_propagate_prefixed_error(err, nested_error, __func__);
+        return -1;
+    }
+    if (offset > src_stat.st_size) {
+        gfal2_log(G_LOG_LEVEL_WARNING, "Can not resume, the destination is bigger than the source (%lld > %lld)",
+                (long long)offset, (long long)src_stat.st_size);
+        return 0;
+    }
+
+    if (gfal2_get_opt_boolean_with_default(context, "CORE", "COPY_RESUME_VERIFY", TRUE)) {
+        char checksum_type[64] = {0};
+        char user_checksum[1024] = {0};
+        char src_checksum[1024] = {0};
+        char dst_checksum[1024] = {0};
+
+        gfalt_get_checksum(params, checksum_type, sizeof(checksum_type),
+                user_checksum, sizeof(user_checksum), NULL);
+        if (checksum_type[0] == '\0') {
+            g_strlcpy(checksum_type, "ADLER32", sizeof(checksum_type));
+        }
+
+        if (gfal2_checksum(context, src, checksum_type, 0, offset,
+                    src_checksum, sizeof(src_checksum), &nested_error) != 0 ||
+            gfal2_checksum(context, dst, checksum_type, 0, offset,
+                    dst_checksum, sizeof(dst_checksum), &nested_error) != 0) {
+            gfal2_log(G_LOG_LEVEL_WARNING, "Can not verify the partial destination: %s",
+                    nested_error->message);
+            g_error_free(nested_error);
+            return 0;
+        }
+
+        if (gfal_compare_checksums(src_checksum, dst_checksum, sizeof(src_checksum)) != 0) {
+            gfal2_log(G_LOG_LEVEL_WARNING, "Can not resume, the first %lld bytes do not match (%s %s != %s)",
+                    (long long)offset, checksum_type, src_checksum, dst_checksum);
+            return 0;
+        }
+    }
+
+    return offset;
+}
@@ -19,6 +19,7 @@
  */
 
 #include <regex.h>
+#include <stddef.h>
 #include <unistd.h>
 #include <stdio.h>
 #include <string.h>
@@ -42,6 +43,8 @@
 #include <uri/gfal2_uri.h>
 #include <future/glib.h>
 
+#include "gfal_file_plugin_uring.h"
+
 typedef struct _chksum_interface{
     // init checksum handle
     void*  (*init)(void);
@@ -262,6 +265,38 @@ struct dirent *gfal_plugin_file_readdir(plugin_handle plugin_data, gfal_file_han
     return res;
 }
 
+ssize_t gfal_plugin_file_readdir_batch(plugin_handle plugin_data, gfal_file_handle fh,
+    gfal2_dir_entry_t *entries, size_t nentries, GError **err)
+{
+    DIR *dir = gfal_file_handle_get_fdesc(fh);
+    const int dir_fd = dirfd(dir);
+    size_t i = 0;
+
+    while (i < nentries) {
+        errno = 0;
+        struct dirent *res = readdir(dir);
+        if (res == NULL) {
+            if (errno) {
+                gfal_plugin_file_report_error(__func__, err);
+                return -1;
+            }
+            break;
+        }
+        // Relative to the directory, so there is no path resolution per entry
+        if (fstatat(dir_fd, res->d_name, &entries[i].st, 0) < 0) {
+            // Removed since it was listed
+            if (errno == ENOENT)
+                continue;
+            gfal_plugin_file_report_error(__func__, err);
+            return -1;
+        }
+        memcpy(&entries[i].dirent, res, offsetof(struct dirent, d_name));
+        g_strlcpy(entries[i].dirent.d_name, res->d_name, sizeof(entries[i].dirent.d_name));
+        ++i;
+    }
+    return i;
+}
+
 gfal_file_handle gfal_plugin_file_open(plugin_handle plugin_data, const char *path, int flag, mode_t mode, GError **err)
 {
     errno = 0;
@@ -585,6 +620,7 @@ gfal_plugin_interface gfal_plugin_init(gfal2_context_t handle, GError **err)
     file_plugin.rmdirG = &gfal_plugin_file_rmdir;
     file_plugin.opendirG = &gfal_plugin_file_opendir;
     file_plugin.readdirG = &gfal_plugin_file_readdir;
+    file_plugin.readdir_batchG = &gfal_plugin_file_readdir_batch;
     file_plugin.closedirG = &gfal_plugin_file_closedir;
     file_plugin.readlinkG = &gfal_plugin_file_readlink;
 
@@ -603,5 +639,11 @@ gfal_plugin_interface gfal_plugin_init(gfal2_context_t handle, GError **err)
     file_plugin.setxattrG = &gfal_plugin_file_setxattr;
     file_plugin.checksum_calcG = &gfal_plugin_filechecksum_calc;
 
+    // Streamed copies between local files through io_uring, if the kernel allows it
+    if (gfal2_get_opt_boolean_with_default(handle, "FILE PLUGIN", "IO_URING", TRUE) &&
+        gfal_plugin_file_uring_available()) {
+        file_plugin.stream_copyG = &gfal_plugin_file_stream_copy;
+    }
+
     return file_plugin;
 }
@@ -0,0 +1,417 @@
+/*
+ * Copyright (c) CERN 2013-2017
+ *
+ * Copyright (c) Members of the EMI Collaboration. 2010-2013
+ *  See  http://www.eu-emi.eu/partners for details on the copyright
+ *  holders.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+
+#include "gfal_file_plugin_uring.h"
+
+#ifdef HAVE_LIBURING
+#include <liburing.h>
+#endif
+
+GQuark gfal2_get_plugin_file_quark();
+
+
+#ifdef HAVE_LIBURING
+
+// Alignment of the buffers, offsets and lengths, as required by O_DIRECT
+#define GFAL_FILE_URING_ALIGNMENT 4096
+
+typedef enum {
+    GFAL_URING_SLOT_FREE = 0,
+    GFAL_URING_SLOT_READ,
+    GFAL_URING_SLOT_WRITE
+} gfal_uring_slot_state_t;
+
+// One buffer, going through read from the source, then write into the destination
+typedef struct {
+    char *buffer;
+    gfal_uring_slot_state_t state;
+    // Position of the chunk, relative to the start of the copy
+    off_t offset;
+    size_t length;
+    // Bytes already read, or written, of the chunk
+    size_t done;
+} gfal_uring_slot_t;
+
+typedef struct {
+    struct io_uring ring;
+    gfal_uring_slot_t *slots;
+    int nslots;
+    int inflight;
+    gboolean fixed;
+    size_t chunk_size;
+
+    int src_fd, dst_fd;
+    off_t src_start, dst_start;
+    // Bytes to copy, and next chunk to read
+    off_t size;
+    off_t next;
+    gboolean dst_direct;
+} gfal_uring_copy_t;
+
+
+gboolean gfal_plugin_file_uring_available(void)
+{
+    static gsize probed = 0;
+    static gboolean available = FALSE;
+
+    if (g_once_init_enter(&probed)) {
+        struct io_uring ring;
+        // Fails with ENOSYS on old kernels, EPERM if disabled by the administrator or a seccomp filter
+        int ret = io_uring_queue_init(2, &ring, 0);
+        if (ret == 0) {
+            io_uring_queue_exit(&ring);
+            available = TRUE;
+        }
+        gfal2_log(G_LOG_LEVEL_DEBUG, "io_uring %s for local copies",
+            available ? "available" : "not available");
+        g_once_init_leave(&probed, 1);
+    }
+    return available;
+}
+
+
+static void gfal_uring_submit_slot(gfal_uring_copy_t *copy, int index)
+{
+    gfal_uring_slot_t *slot = &copy->slots[index];
+    struct io_uring_sqe *sqe = io_uring_get_sqe(&copy->ring);
+    char *buffer = slot->buffer + slot->done;
+    size_t length = slot->length - slot->done;
+
+    // The ring has one entry per slot, so there is always room
+    if (slot->state == GFAL_URING_SLOT_READ) {
+        off_t offset = copy->src_start + slot->offset + slot->done;
+        // Ask for whole blocks, so a tail read works with O_DIRECT. The end of file cuts it
+        length = MIN((length + GFAL_FILE_URING_ALIGNMENT - 1) & ~((size_t)GFAL_FILE_URING_ALIGNMENT - 1),
+            copy->chunk_size - slot->done);
+        if (copy->fixed)
+            io_uring_prep_read_fixed(sqe, copy->src_fd, buffer, length, offset, index);
+        else
+            io_uring_prep_read(sqe, copy->src_fd, buffer, length, offset);
+    }
+    else {
+        off_t offset = copy->dst_start + slot->offset + slot->done;
+        // O_DIRECT does not allow writing the unaligned tail of the file
+        if (copy->dst_direct && (length % GFAL_FILE_URING_ALIGNMENT) != 0) {
+            fcntl(copy->dst_fd, F_SETFL, fcntl(copy->dst_fd, F_GETFL) & ~O_DIRECT);
+            copy->dst_direct = FALSE;
+        }
+        if (copy->fixed)
+            io_uring_prep_write_fixed(sqe, copy->dst_fd, buffer, length, offset, index);
+        else
+            io_uring_prep_write(sqe, copy->dst_fd, buffer, length, offset);
+    }
+    io_uring_sqe_set_data(sqe, (void*)(intptr_t)index);
+    ++copy->inflight;
+}
+
+
+// Queue reads into all the free buffers
+static void gfal_uring_fill(gfal_uring_copy_t *copy)
+{
+    int i;
+    for (i = 0; i < copy->nslots && copy->next < copy->size; ++i) {
+        gfal_uring_slot_t *slot = &copy->slots[i];
+        if (slot->state != GFAL_URING_SLOT_FREE)
+            continue;
+        slot->state = GFAL_URING_SLOT_READ;
+        slot->offset = copy->next;
+        slot->length = (size_t)MIN((off_t)copy->chunk_size, copy->size - copy->next);
+        slot->done = 0;
+        copy->next += slot->length;
+        gfal_uring_submit_slot(copy, i);
+    }
+}
+
+
+// Handle a completion. Returns the number of bytes written to the destination by this operation
+static ssize_t gfal_uring_complete(gfal_uring_copy_t *copy, int index, int res, GError **err)
+{
+    gfal_uring_slot_t *slot = &copy->slots[index];
+
+    if (res == -EINTR || res == -EAGAIN) {
+        gfal_uring_submit_slot(copy, index);
+        return 0;
+    }
+    if (res < 0) {
+        gfal2_set_error(err, gfal2_get_plugin_file_quark(), -res, __func__,
+            "Failed to %s: %s", (slot->state == GFAL_URING_SLOT_READ) ? "read the source" : "write the destination",
+            strerror(-res));
+        slot->state = GFAL_URING_SLOT_FREE;
+        return -1;
+    }
+
+    if (slot->state == GFAL_URING_SLOT_READ) {
+        slot->done = MIN(slot->done + res, slot->length);
+        if (res == 0) {
+            // The source has been truncated while copying, stop there
+            slot->length = slot->done;
+            copy->size = MIN(copy->size, slot->offset + (off_t)slot->length);
+        }
+        if (slot->done < slot->length) {
+            gfal_uring_submit_slot(copy, index);
+        }
+        else if (slot->length == 0) {
+            slot->state = GFAL_URING_SLOT_FREE;
+        }
+        else {
+            slot->state = GFAL_URING_SLOT_WRITE;
+            slot->done = 0;
+            gfal_uring_submit_slot(copy, index);
+        }
+        return 0;
+    }
+
+    slot->done += res;
+    if (slot->done < slot->length) {
+        gfal_uring_submit_slot(copy, index);
+        return 0;
+    }
+    slot->state = GFAL_URING_SLOT_FREE;
+    return slot->length;
+}
+
+
+// Marks the completions of the cancel requests, which do not belong to any slot
+#define GFAL_URING_CANCEL_DATA ((void*)(intptr_t)-1)
+
+// Cancel the operations in flight, and wait for all of them to complete,
+// so the kernel does not access the buffers anymore
+// Returns FALSE if they could not be waited for
+static gboolean gfal_uring_drain(gfal_uring_copy_t *copy)
+{
+    struct io_uring_cqe *cqe = NULL;
+    int i, ret;
+
+    for (i = 0; i < copy->nslots; ++i) {
+        if (copy->slots[i].state == GFAL_URING_SLOT_FREE)
+            continue;
+        struct io_uring_sqe *sqe = io_uring_get_sqe(&copy->ring);
+        if (sqe == NULL)
+            break;
+        io_uring_prep_cancel(sqe, (void*)(intptr_t)i, 0);
+        io_uring_sqe_set_data(sqe, GFAL_URING_CANCEL_DATA);
+    }
+
+    while (copy->inflight > 0) {
+        // Also pushes to the kernel the requests left over by a failed submission
+        ret = io_uring_submit_and_wait(&copy->ring, 1);
+        if (ret < 0 && ret != -EINTR && ret != -EAGAIN && ret != -EBUSY) {
+            ret = io_uring_wait_cqe(&copy->ring, &cqe);
+            if (ret < 0 && ret != -EINTR)
+                return FALSE;
+        }
+        while (io_uring_peek_cqe(&copy->ring, &cqe) == 0 && cqe != NULL) {
+            void *data = io_uring_cqe_get_data(cqe);
+            io_uring_cqe_seen(&copy->ring, cqe);
+            if (data != GFAL_URING_CANCEL_DATA) {
+                copy->slots[(intptr_t)data].state = GFAL_URING_SLOT_FREE;
+                --copy->inflight;
+            }
+        }
+    }
+    return TRUE;
+}
+
+
+static void gfal_uring_release(gfal_uring_copy_t *copy)
+{
+    int i;
+
+    if (copy->inflight > 0 && !gfal_uring_drain(copy)) {
+        // The kernel may still read into or write from the buffers: leak them rather than
+        // handing them back to the allocator
+        gfal2_log(G_LOG_LEVEL_WARNING,
+            "Could not wait for %d io_uring operations, leaking their buffers", copy->inflight);
+        io_uring_queue_exit(&copy->ring);
+        return;
+    }
+
+    if (copy->fixed) {
+        io_uring_unregister_buffers(&copy->ring);
+    }
+    io_uring_queue_exit(&copy->ring);
+    for (i = 0; i < copy->nslots; ++i) {
+        free(copy->slots[i].buffer);
+    }
+    g_free(copy->slots);
+}
+
+
+ssize_t gfal_plugin_file_stream_copy(plugin_handle plugin_data, gfal_file_handle src, gfal_file_handle dst,
+    size_t buffer_size, gfal_stream_copy_progress_t progress, void *user_data, GError **err)
+{
+    gfal2_context_t context = (gfal2_context_t) plugin_data;
+    GError *tmp_err = NULL;
+    gfal_uring_copy_t copy;
+    struct stat st;
+    int i;
+
+    memset(&copy, 0, sizeof(copy));
+    copy.src_fd = GPOINTER_TO_INT(gfal_file_handle_get_fdesc(src));
+    copy.dst_fd = GPOINTER_TO_INT(gfal_file_handle_get_fdesc(dst));
+
+    // Only regular files have a known size and can be read at any offset
+    if (fstat(copy.src_fd, &st) < 0 || !S_ISREG(st.st_mode)) {
+        gfal2_set_error(err, gfal2_get_plugin_file_quark(), ENOSYS, __func__,
+            "The source is not a regular file");
+        return -1;
+    }
+
+    copy.src_start = lseek(copy.src_fd, 0, SEEK_CUR);
+    copy.dst_start = lseek(copy.dst_fd, 0, SEEK_CUR);
+    if (copy.src_start < 0 || copy.dst_start < 0) {
+        gfal2_set_error(err, gfal2_get_plugin_file_quark(), ENOSYS, __func__,
+            "The source or the destination is not seekable");
+        return -1;
+    }
+
+    int src_flags = fcntl(copy.src_fd, F_GETFL);
+    int dst_flags = fcntl(copy.dst_fd, F_GETFL);
+    copy.dst_direct = (dst_flags & O_DIRECT) != 0;
+    if (((src_flags | dst_flags) & O_DIRECT) &&
+        ((copy.src_start | copy.dst_start) % GFAL_FILE_URING_ALIGNMENT) != 0) {
+        gfal2_set_error(err, gfal2_get_plugin_file_quark(), ENOSYS, __func__,
+            "Direct I/O from an unaligned offset");
+        return -1;
+    }
+
+    copy.size = MAX(st.st_size - copy.src_start, 0);
+    if (copy.size == 0) {
+        return 0;
+    }
+
+    copy.chunk_size = gfal2_get_opt_integer_with_default(context, "FILE PLUGIN", "IO_URING_CHUNK_SIZE", buffer_size);
+    copy.chunk_size = MAX(copy.chunk_size, (size_t)GFAL_FILE_URING_ALIGNMENT);
+    copy.chunk_size = (copy.chunk_size + GFAL_FILE_URING_ALIGNMENT - 1) & ~((size_t)GFAL_FILE_URING_ALIGNMENT - 1);
+    copy.nslots = gfal2_get_opt_integer_with_default(context, "FILE PLUGIN", "IO_URING_QUEUE_DEPTH", 8);
+    copy.nslots = CLAMP(copy.nslots, 1, 4096);
+    // Do not queue more than the file needs
+    copy.nslots = MIN(copy.nslots, (copy.size + copy.chunk_size - 1) / copy.chunk_size);
+
+    int ret = io_uring_queue_init(copy.nslots, &copy.ring, 0);
+    if (ret < 0) {
+        gfal2_set_error(err, gfal2_get_plugin_file_quark(), ENOSYS, __func__,
+            "Could not setup io_uring: %s", strerror(-ret));
+        return -1;
+    }
+
+    copy.slots = g_new0(gfal_uring_slot_t, copy.nslots);
+    struct iovec *iovecs = g_new0(struct iovec, copy.nslots);
+    for (i = 0; i < copy.nslots; ++i) {
+        if (posix_memalign((void**)&copy.slots[i].buffer, GFAL_FILE_URING_ALIGNMENT, copy.chunk_size) != 0) {
+            g_free(iovecs);
+            gfal_uring_release(&copy);
+            gfal2_set_error(err, gfal2_get_plugin_file_quark(), ENOMEM, __func__,
+                "Could not allocate the copy buffers");
+            return -1;
+        }
+        iovecs[i].iov_base = copy.slots[i].buffer;
+        iovecs[i].iov_len = copy.chunk_size;
+    }
+    // Registered buffers save the page mapping on each operation, but count against RLIMIT_MEMLOCK
+    copy.fixed = (io_uring_register_buffers(&copy.ring, iovecs, copy.nslots) == 0);
+    g_free(iovecs);
+
+    gfal2_log(G_LOG_LEVEL_DEBUG, "io_uring copy of %lld bytes, %d buffers of %zu bytes%s",
+        (long long)copy.size, copy.nslots, copy.chunk_size, copy.fixed ? ", registered" : "");
+
+    ssize_t total = 0;
+    gfal_uring_fill(&copy);
+
+    while (copy.inflight > 0) {
+        struct io_uring_cqe *cqe = NULL;
+
+        ret = io_uring_submit_and_wait(&copy.ring, 1);
+        if (ret == -EINTR) {
+            continue;
+        }
+        if (ret < 0) {
+            // The operations still in flight are cancelled and waited for by gfal_uring_release
+            if (tmp_err == NULL) {
+                gfal2_set_error(&tmp_err, gfal2_get_plugin_file_quark(), -ret, __func__,
+                    "Failed to wait for the I/O completion: %s", strerror(-ret));
+            }
+            break;
+        }
+
+        // Reap everything available before submitting again
+        while (io_uring_peek_cqe(&copy.ring, &cqe) == 0 && cqe != NULL) {
+            int index = (int)(intptr_t)io_uring_cqe_get_data(cqe);
+            int res = cqe->res;
+            io_uring_cqe_seen(&copy.ring, cqe);
+            --copy.inflight;
+
+            // After an error, only drain the queue
+            if (tmp_err) {
+                copy.slots[index].state = GFAL_URING_SLOT_FREE;
+                continue;
+            }
+
+            ssize_t written = gfal_uring_complete(&copy, index, res, &tmp_err);
+            if (written > 0) {
+                total += written;
+                progress(written, user_data, &tmp_err);
+            }
+        }
+
+        if (tmp_err == NULL) {
+            gfal_uring_fill(&copy);
+        }
+    }
+
+    gfal_uring_release(&copy);
+
+    if (tmp_err) {
+        gfal2_propagate_prefixed_error(err, tmp_err, __func__);
+        return -1;
+    }
+
+    // Leave the descriptors as a read/write loop would have
+    lseek(copy.src_fd, copy.src_start + total, SEEK_SET);
+    lseek(copy.dst_fd, copy.dst_start + total, SEEK_SET);
+    return total;
+}
+
+#else
+
+gboolean gfal_plugin_file_uring_available(void)
+{
+    return FALSE;
+}
+
+
+ssize_t gfal_plugin_file_stream_copy(plugin_handle plugin_data, gfal_file_handle src, gfal_file_handle dst,
+    size_t buffer_size, gfal_stream_copy_progress_t progress, void *user_data, GError **err)
+{
+    gfal2_set_error(err, gfal2_get_plugin_file_quark(), ENOSYS, __func__,
+        "gfal2 was built without io_uring support");
+    return -1;
+}
+
+#endif /* HAVE_LIBURING */
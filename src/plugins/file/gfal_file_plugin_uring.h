@@ -0,0 +1,34 @@
+/*
+ * Copyright (c) CERN 2013-2017
+ *
+ * Copyright (c) Members of the EMI Collaboration. 2010-2013
+ *  See  http://www.eu-emi.eu/partners for details on the copyright
+ *  holders.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+#ifndef GFAL_FILE_PLUGIN_URING_H_
+#define GFAL_FILE_PLUGIN_URING_H_
+
+#include <gfal_plugins_api.h>
+
+// TRUE if io_uring can be used by this process. Always FALSE if built without liburing
+gboolean gfal_plugin_file_uring_available(void);
+
+// Copy between two local files through a queue of asynchronous reads and writes
+ssize_t gfal_plugin_file_stream_copy(plugin_handle plugin_data, gfal_file_handle src, gfal_file_handle dst,
+    size_t buffer_size, gfal_stream_copy_progress_t progress, void *user_data, GError **err);
+
+#endif /* GFAL_FILE_PLUGIN_URING_H_ */
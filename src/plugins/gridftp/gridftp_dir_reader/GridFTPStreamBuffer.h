@@ -22,13 +22,15 @@
 #ifndef GRIDFTP_STREAMBUF_H
 #define GRIDFTP_STREAMBUF_H
 
+#include <cstring>
 #include <iostream>
 #include "../gridftpwrapper.h"
 
 class GridFTPStreamBuffer: public std::streambuf {
 protected:
     GridFTPStreamState* gstream;
-    char buffer[4096];
+    // One byte is always kept free, so a line can be terminated in place
+    char buffer[65536];
 
     GQuark quark;
 
@@ -53,6 +55,59 @@ public:
             return traits_type::eof();
         return *buffer;
     }
+
+    // Zero-copy access to the received data, as an alternative to std::istream
+    // Data not consumed yet
+    const char* data() const {
+        return gptr();
+    }
+
+    size_t pending() const {
+        return egptr() - gptr();
+    }
+
+    void consume(size_t n) {
+        gbump(n);
+    }
+
+    // Move the pending data to the beginning of the buffer, and append what can be read from the stream
+    // Returns the number of bytes read, 0 at the end of the stream
+    ssize_t refill() {
+        size_t npending = pending();
+        if (npending >= sizeof(buffer) - 1) {
+            throw Gfal::CoreException(quark, EOVERFLOW, "GridFTP listing line too long");
+        }
+        memmove(buffer, gptr(), npending);
+        ssize_t rsize = gridftp_read_stream(quark, gstream, buffer + npending, sizeof(buffer) - 1 - npending, false);
+        this->setg(buffer, buffer, buffer + npending + rsize);
+        return rsize;
+    }
+
+    // Get the next line, without the newline, which is replaced in place by a null terminator
+    // The line remains valid until the next call. Returns false at the end of the stream
+    bool next_line(char** line, size_t* len) {
+        size_t scanned = 0;
+        while (true) {
+            char* newline = static_cast<char*>(memchr(gptr() + scanned, '\n', pending() - scanned));
+            if (newline) {
+                *newline = '\0';
+                *line = gptr();
+                *len = newline - gptr();
+                this->setg(buffer, newline + 1, egptr());
+                return true;
+            }
+            scanned = pending();
+            if (refill() <= 0) {
+                if (pending() == 0)
+                    return false;
+                *egptr() = '\0';
+                *line = gptr();
+                *len = pending();
+                this->setg(buffer, egptr(), egptr());
+                return true;
+            }
+        }
+    }
 };
 
 #endif // GRIDFTP_STREAMBUF_H
@@ -24,9 +24,11 @@
 
 #include <dirent.h>
 #include <sys/stat.h>
+#include <vector>
 
 #include "GridFTPStreamBuffer.h"
 #include "../gridftpmodule.h"
+#include "../gridftp_mlsd_parser.h"
 #include "../gridftp_parsing.h"
 
 // Directory reader interface
@@ -54,6 +56,18 @@ public:
     };
     virtual struct dirent* readdir() = 0;
     virtual struct dirent* readdirpp(struct stat* st) = 0;
+
+    // Fill up to nentries entries, 0 at the end of the listing
+    virtual size_t readdir_batch(gfal2_dir_entry_t* entries, size_t nentries) {
+        size_t i;
+        for (i = 0; i < nentries; ++i) {
+            struct dirent* ent = readdirpp(&entries[i].st);
+            if (ent == NULL)
+                break;
+            memcpy(&entries[i].dirent, ent, sizeof(struct dirent));
+        }
+        return i;
+    }
 };
 
 // Implementation for simple list
@@ -66,12 +80,20 @@ public:
 };
 
 // Implementation for MLSD
+// Entries are parsed in batches, directly from the received buffer
 class GridFtpMlsdReader: public GridFtpDirReader {
+protected:
+    std::vector<GridFtpMlsdEntry> batch;
+    size_t batch_index;
+
+    bool fetch_batch();
+
 public:
     GridFtpMlsdReader(GridFTPModule* gsiftp, const char* path);
     ~GridFtpMlsdReader();
     struct dirent* readdir();
     struct dirent* readdirpp(struct stat* st);
+    size_t readdir_batch(gfal2_dir_entry_t* entries, size_t nentries);
 };
 
 // Implementation for STAT
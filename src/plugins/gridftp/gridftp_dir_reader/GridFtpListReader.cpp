@@ -59,48 +59,27 @@ struct dirent* GridFtpListReader::readdir()
 }
 
 
-static std::string& ltrim(std::string& str)
-{
-    size_t i = 0;
-    while (i < str.length() && isspace(str[i]))
-        ++i;
-    str = str.substr(i);
-    return str;
-}
-
-
-static std::string& rtrim(std::string& str)
-{
-    int i = str.length() - 1;
-    while (i >= 0 && isspace(str[i]))
-        --i;
-    str = str.substr(0, i + 1);
-    return str;
-}
-
-static std::string& trim(std::string& str)
-{
-    return ltrim(rtrim(str));
-}
-
-
 struct dirent* GridFtpListReader::readdirpp(struct stat* st)
 {
-    std::string line;
-    std::istream in(stream_buffer);
-    if (!std::getline(in, line))
+    // Parse the line in place, inside the stream buffer
+    char* line;
+    size_t len;
+    if (!stream_buffer->next_line(&line, &len))
         return NULL;
 
-    if (trim(line).empty())
+    while (len > 0 && isspace(line[len - 1]))
+        line[--len] = '\0';
+    while (isspace(*line)) {
+        ++line;
+        --len;
+    }
+    if (len == 0)
         return NULL;
 
-    char* unparsed = strdup(line.c_str());
-    if (parse_stat_line(unparsed, st, dbuffer.d_name, sizeof(dbuffer.d_name)) != GLOBUS_SUCCESS) {
-        free(unparsed);
+    if (parse_stat_line(line, st, dbuffer.d_name, sizeof(dbuffer.d_name)) != GLOBUS_SUCCESS) {
         throw Gfal::CoreException(GridFtpListReaderQuark, EINVAL,
                 std::string("Error parsing GridFTP line: '").append(line).append("\'"));
     }
-    free(unparsed);
 
     // Workaround for LCGUTIL-295
     // Some endpoints return the absolute path when listing an empty directory
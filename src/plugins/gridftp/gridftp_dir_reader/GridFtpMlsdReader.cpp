@@ -18,12 +18,14 @@
  * limitations under the License.
  */
 
+#include <algorithm>
+#include <cstddef>
 #include "GridFtpDirReader.h"
 
 static const GQuark GridFtpMlsdReaderQuark = g_quark_from_static_string("GridftpSimpleListReader::readdir");
 
 
-GridFtpMlsdReader::GridFtpMlsdReader(GridFTPModule* gsiftp, const char* path)
+GridFtpMlsdReader::GridFtpMlsdReader(GridFTPModule* gsiftp, const char* path): batch_index(0)
 {
     GridFTPFactory* factory = gsiftp->get_session_factory();
 
@@ -59,48 +61,45 @@ struct dirent* GridFtpMlsdReader::readdir()
 }
 
 
-static std::string& ltrim(std::string& str)
+// Parse the complete lines pending in the stream buffer, reading more if there are none
+// Returns false once the listing is over
+bool GridFtpMlsdReader::fetch_batch()
 {
-    size_t i = 0;
-    while (i < str.length() && isspace(str[i]))
-        ++i;
-    str = str.substr(i);
-    return str;
-}
-
-
-static std::string& rtrim(std::string& str)
-{
-    int i = str.length() - 1;
-    while (i >= 0 && isspace(str[i]))
-        --i;
-    str = str.substr(0, i + 1);
-    return str;
-}
+    batch.clear();
+    batch_index = 0;
+
+    bool eof = false;
+    while (true) {
+        const char* error_line = NULL;
+        size_t error_len = 0;
+        ssize_t consumed = gridftp_parse_mlsd_batch(stream_buffer->data(), stream_buffer->pending(), eof,
+                batch, &error_line, &error_len);
+        if (consumed < 0) {
+            throw Gfal::CoreException(GridFtpMlsdReaderQuark, EINVAL,
+                    std::string("Error parsing GridFTP line: '").append(error_line, error_len).append("\'"));
+        }
+        stream_buffer->consume(consumed);
+
+        if (!batch.empty() || eof)
+            break;
+        eof = (stream_buffer->refill() <= 0);
+    }
 
-static std::string& trim(std::string& str)
-{
-    return ltrim(rtrim(str));
+    return !batch.empty();
 }
 
 
 struct dirent* GridFtpMlsdReader::readdirpp(struct stat* st)
 {
-    std::string line;
-    std::istream in(stream_buffer);
-    if (!std::getline(in, line))
+    // The names point inside the stream buffer, which is only refilled once the batch is consumed
+    if (batch_index >= batch.size() && !fetch_batch())
         return NULL;
 
-    if (trim(line).empty())
-        return NULL;
-
-    char* unparsed = strdup(line.c_str());
-    if (parse_mlst_line(unparsed, st, dbuffer.d_name, sizeof(dbuffer.d_name)) != GLOBUS_SUCCESS) {
-        free(unparsed);
-        throw Gfal::CoreException(GridFtpMlsdReaderQuark, EINVAL,
-                std::string("Error parsing GridFTP line: '").append(line).append("\'"));
-    }
-    free(unparsed);
+    const GridFtpMlsdEntry& entry = batch[batch_index++];
+    size_t name_len = std::min(entry.name_len, sizeof(dbuffer.d_name) - 1);
+    memcpy(dbuffer.d_name, entry.name, name_len);
+    dbuffer.d_name[name_len] = '\0';
+    memcpy(st, &entry.st, sizeof(struct stat));
 
     if (dbuffer.d_name[0] == '\0')
         return NULL;
@@ -114,3 +113,38 @@ struct dirent* GridFtpMlsdReader::readdirpp(struct stat* st)
 
     return &dbuffer;
 }
+
+
+size_t GridFtpMlsdReader::readdir_batch(gfal2_dir_entry_t* entries, size_t nentries)
+{
+    size_t i = 0;
+    while (i < nentries) {
+        if (batch_index >= batch.size() && !fetch_batch())
+            break;
+
+        const GridFtpMlsdEntry& entry = batch[batch_index];
+        // Same as readdirpp, an empty name ends the listing, so it is returned alone
+        if (entry.name_len == 0) {
+            if (i == 0)
+                ++batch_index;
+            break;
+        }
+        ++batch_index;
+
+        struct dirent* dent = &entries[i].dirent;
+        memset(dent, 0, offsetof(struct dirent, d_name));
+        size_t name_len = std::min(entry.name_len, sizeof(dent->d_name) - 1);
+        memcpy(dent->d_name, entry.name, name_len);
+        dent->d_name[name_len] = '\0';
+        memcpy(&entries[i].st, &entry.st, sizeof(struct stat));
+
+        if (S_ISDIR(entry.st.st_mode))
+            dent->d_type = DT_DIR;
+        else if (S_ISLNK(entry.st.st_mode))
+            dent->d_type = DT_LNK;
+        else
+            dent->d_type = DT_REG;
+        ++i;
+    }
+    return i;
+}
@@ -48,24 +48,16 @@ const GQuark GFAL_GRIDFTP_DOMAIN_GSIFTP = g_quark_from_string("GSIFTP");
 /*IPv6 compatible lookup*/
 std::string lookup_host(const char *host, bool ipv6_enabled, bool *got_ipv6)
 {
-    struct addrinfo hints, *addresses = NULL;
-    int errcode;
-    char addrstr[100] = { 0 };
-    char ip4str[16] = { 0 };
-    char ip6str[46] = { 0 };
-    void *ptr = NULL;
+    gfal2_dns_address addresses[GFAL2_DNS_MAX_ADDRESSES];
+    const char *ip4str = NULL;
+    const char *ip6str = NULL;
 
     if (!host) {
         return std::string("cant.be.resolved");
     }
 
-    memset(&hints, 0, sizeof(hints));
-    hints.ai_family = PF_UNSPEC;
-    hints.ai_socktype = SOCK_STREAM;
-    hints.ai_flags |= AI_CANONNAME;
-
-    errcode = getaddrinfo(host, NULL, &hints, &addresses);
-    if (errcode != 0) {
+    int count = gfal2_resolve_dns(host, addresses, GFAL2_DNS_MAX_ADDRESSES);
+    if (count < 0) {
         return std::string("cant.be.resolved");
     }
 
@@ -73,38 +65,24 @@ std::string lookup_host(const char *host, bool ipv6_enabled, bool *got_ipv6)
         *got_ipv6 = false;
     }
 
-    struct addrinfo *i = addresses;
-    while (i) {
-        inet_ntop(i->ai_family, i->ai_addr->sa_data, addrstr, sizeof(addrstr));
-
-        switch (i->ai_family) {
-        case AF_INET:
-            ptr = &((struct sockaddr_in *) i->ai_addr)->sin_addr;
-            if (ptr) {
-                inet_ntop(i->ai_family, ptr, ip4str, sizeof(ip4str));
+    for (int i = 0; i < count; ++i) {
+        if (addresses[i].family == AF_INET6) {
+            if (!ip6str) {
+                ip6str = addresses[i].address;
             }
-            break;
-        case AF_INET6:
-            ptr = &((struct sockaddr_in6 *) i->ai_addr)->sin6_addr;
-            if (ptr) {
-                inet_ntop(i->ai_family, ptr, ip6str, sizeof(ip6str));
-                if (got_ipv6) {
-                    *got_ipv6 = true;
-                }
+            if (got_ipv6) {
+                *got_ipv6 = true;
             }
-            break;
         }
-        i = i->ai_next;
-    }
-
-    if (addresses) {
-        freeaddrinfo(addresses);
+        else if (addresses[i].family == AF_INET && !ip4str) {
+            ip4str = addresses[i].address;
+        }
     }
 
-    if (ipv6_enabled && ip6str[0]) {
+    if (ipv6_enabled && ip6str) {
         return std::string("[").append(ip6str).append("]");
     }
-    else if (ip4str[0]) {
+    else if (ip4str) {
         return std::string(ip4str);
     }
     else {
@@ -225,11 +225,13 @@ ssize_t GridFTPModule::read(gfal_file_handle handle, void* buffer, size_t count)
     globus_mutex_lock(&desc->mutex);
     try {
         if (desc->is_not_seeked() && is_read_only(desc->open_flags) && desc->stream != NULL) {
-            gfal2_log(G_LOG_LEVEL_DEBUG, " read in the GET main flow ... ");
+            const gfal2_log_field_t fields[] = {{"mode", "stream"}, {"url", gfal_file_handle_get_path(handle)}};
+            gfal2_log_structured(G_LOG_LEVEL_DEBUG, GRIDFTP_LOG_SUBSYSTEM, fields, 2, "GridFTPModule::read");
             ret = gridftp_read_stream(GFAL_GRIDFTP_SCOPE_READ, desc->stream, buffer, count, false);
         }
         else {
-            gfal2_log(G_LOG_LEVEL_DEBUG, " read with a pread ... ");
+            const gfal2_log_field_t fields[] = {{"mode", "ranged"}, {"url", gfal_file_handle_get_path(handle)}};
+            gfal2_log_structured(G_LOG_LEVEL_DEBUG, GRIDFTP_LOG_SUBSYSTEM, fields, 2, "GridFTPModule::read");
             ret = gridftp_rw_internal_pread(_handle_factory, desc, buffer, count, desc->current_offset);
         }
     }
@@ -252,11 +254,13 @@ ssize_t GridFTPModule::write(gfal_file_handle handle, const void* buffer,
     globus_mutex_lock(&desc->mutex);
     try {
         if (desc->is_not_seeked() && is_write_only(desc->open_flags) && desc->stream != NULL) {
-            gfal2_log(G_LOG_LEVEL_DEBUG, " write in the PUT main flow ... ");
+            const gfal2_log_field_t fields[] = {{"mode", "stream"}, {"url", gfal_file_handle_get_path(handle)}};
+            gfal2_log_structured(G_LOG_LEVEL_DEBUG, GRIDFTP_LOG_SUBSYSTEM, fields, 2, "GridFTPModule::write");
             ret = gridftp_write_stream(GFAL_GRIDFTP_SCOPE_WRITE, desc->stream, buffer, count, false);
         }
         else {
-            gfal2_log(G_LOG_LEVEL_DEBUG, " write with a pwrite ... ");
+            const gfal2_log_field_t fields[] = {{"mode", "ranged"}, {"url", gfal_file_handle_get_path(handle)}};
+            gfal2_log_structured(G_LOG_LEVEL_DEBUG, GRIDFTP_LOG_SUBSYSTEM, fields, 2, "GridFTPModule::write");
             ret = gridftp_rw_internal_pwrite(_handle_factory, desc, buffer, count, desc->current_offset);
         }
     }
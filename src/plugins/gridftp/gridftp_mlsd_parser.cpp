@@ -0,0 +1,257 @@
+/*
+ * Copyright (c) CERN 2013-2017
+ *
+ * Copyright (c) Members of the EMI Collaboration. 2010-2013
+ *  See  http://www.eu-emi.eu/partners for details on the copyright
+ *  holders.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cstring>
+#include <glib.h>
+
+#include "gridftp_mlsd_parser.h"
+
+
+enum MlsdFact {
+    MLSD_FACT_UNKNOWN,
+    MLSD_FACT_TYPE,
+    MLSD_FACT_SIZE,
+    MLSD_FACT_MODIFY,
+    MLSD_FACT_UNIX_MODE,
+    MLSD_FACT_UNIX_UID,
+    MLSD_FACT_UNIX_GID
+};
+
+struct MlsdFactName {
+    const char* name;
+    size_t len;
+    MlsdFact fact;
+};
+
+// Facts we care about, lower case. Fact names are case insensitive (RFC 3659)
+static const MlsdFactName mlsd_fact_table[] = {
+    {"type",      4, MLSD_FACT_TYPE},
+    {"size",      4, MLSD_FACT_SIZE},
+    {"modify",    6, MLSD_FACT_MODIFY},
+    {"unix.mode", 9, MLSD_FACT_UNIX_MODE},
+    {"unix.uid",  8, MLSD_FACT_UNIX_UID},
+    {"unix.gid",  8, MLSD_FACT_UNIX_GID},
+};
+
+
+static inline char mlsd_ascii_lower(char c)
+{
+    return (c >= 'A' && c <= 'Z') ? c + ('a' - 'A') : c;
+}
+
+
+static bool mlsd_equals_lower(const char* str, size_t len, const char* lower, size_t lower_len)
+{
+    if (len != lower_len)
+        return false;
+    for (size_t i = 0; i < len; ++i) {
+        if (mlsd_ascii_lower(str[i]) != lower[i])
+            return false;
+    }
+    return true;
+}
+
+
+static MlsdFact mlsd_lookup_fact(const char* name, size_t len)
+{
+    for (size_t i = 0; i < G_N_ELEMENTS(mlsd_fact_table); ++i) {
+        if (mlsd_equals_lower(name, len, mlsd_fact_table[i].name, mlsd_fact_table[i].len))
+            return mlsd_fact_table[i].fact;
+    }
+    return MLSD_FACT_UNKNOWN;
+}
+
+
+// Parse the leading decimal digits, 0 if there are none
+static unsigned long long mlsd_parse_decimal(const char* str, size_t len)
+{
+    unsigned long long value = 0;
+    for (size_t i = 0; i < len && g_ascii_isdigit(str[i]); ++i)
+        value = value * 10 + (str[i] - '0');
+    return value;
+}
+
+
+// Parse the leading octal digits, 0 if there are none
+static unsigned long mlsd_parse_octal(const char* str, size_t len)
+{
+    unsigned long value = 0;
+    for (size_t i = 0; i < len && str[i] >= '0' && str[i] <= '7'; ++i)
+        value = value * 8 + (str[i] - '0');
+    return value;
+}
+
+
+// Parse exactly n digits, -1 if one of them is not a digit
+static int mlsd_parse_digits(const char* str, int n)
+{
+    int value = 0;
+    for (int i = 0; i < n; ++i) {
+        if (!g_ascii_isdigit(str[i]))
+            return -1;
+        value = value * 10 + (str[i] - '0');
+    }
+    return value;
+}
+
+
+// Days since 1970-01-01 of a date of the proleptic Gregorian calendar
+static long mlsd_days_from_civil(long y, int m, int d)
+{
+    y -= m <= 2;
+    const long era = (y >= 0 ? y : y - 399) / 400;
+    const long yoe = y - era * 400;
+    const long doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    const long doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + doe - 719468;
+}
+
+
+time_t gridftp_mdtm_to_timet(const char* mdtm, size_t len)
+{
+    if (len < 14)
+        return -1;
+
+    int year = mlsd_parse_digits(mdtm, 4);
+    int month = mlsd_parse_digits(mdtm + 4, 2);
+    int day = mlsd_parse_digits(mdtm + 6, 2);
+    int hour = mlsd_parse_digits(mdtm + 8, 2);
+    int min = mlsd_parse_digits(mdtm + 10, 2);
+    int sec = mlsd_parse_digits(mdtm + 12, 2);
+
+    if (year < 0 || month < 1 || month > 12 || day < 1 || day > 31 ||
+        hour < 0 || hour > 23 || min < 0 || min > 59 || sec < 0 || sec > 60)
+        return -1;
+
+    return (time_t)mlsd_days_from_civil(year, month, day) * 86400 + hour * 3600 + min * 60 + sec;
+}
+
+
+int gridftp_parse_mlsd_entry(const char* line, size_t len, struct stat* st,
+        const char** name, size_t* name_len)
+{
+    const char* end = line + len;
+    while (line < end && g_ascii_isspace(*line))
+        ++line;
+
+    const char* space = static_cast<const char*>(memchr(line, ' ', end - line));
+    if (space == NULL)
+        return -1;
+
+    const char* name_end = end;
+    while (name_end > space + 1 && g_ascii_isspace(name_end[-1]))
+        --name_end;
+    *name = space + 1;
+    *name_len = name_end - *name;
+
+    bool is_dir = false;
+    const char* mode_s = NULL;
+    size_t mode_len = 0;
+
+    st->st_nlink = 1;
+    st->st_mode = -1;
+    st->st_size = 0;
+    st->st_mtime = -1;
+
+    // Older MLST drafts allow the last fact to miss its semicolon (e.g. ncftpd)
+    const char* fact = line;
+    while (fact < space) {
+        const char* fact_end = static_cast<const char*>(memchr(fact, ';', space - fact));
+        if (fact_end == NULL)
+            fact_end = space;
+
+        const char* equal = static_cast<const char*>(memchr(fact, '=', fact_end - fact));
+        if (equal == NULL)
+            return -1;
+
+        const char* value = equal + 1;
+        size_t value_len = fact_end - value;
+
+        switch (mlsd_lookup_fact(fact, equal - fact)) {
+            case MLSD_FACT_TYPE:
+                is_dir = mlsd_equals_lower(value, value_len, "dir", 3) ||
+                         mlsd_equals_lower(value, value_len, "cdir", 4) ||
+                         mlsd_equals_lower(value, value_len, "pdir", 4);
+                break;
+            case MLSD_FACT_SIZE:
+                st->st_size = mlsd_parse_decimal(value, value_len);
+                break;
+            case MLSD_FACT_MODIFY:
+                st->st_mtime = gridftp_mdtm_to_timet(value, value_len);
+                break;
+            case MLSD_FACT_UNIX_MODE:
+                mode_s = value;
+                mode_len = value_len;
+                break;
+            case MLSD_FACT_UNIX_UID:
+                st->st_uid = mlsd_parse_decimal(value, value_len);
+                break;
+            case MLSD_FACT_UNIX_GID:
+                st->st_gid = mlsd_parse_decimal(value, value_len);
+                break;
+            default:
+                break;
+        }
+
+        fact = fact_end + 1;
+    }
+
+    if (mode_s) {
+        st->st_mode = mlsd_parse_octal(mode_s, mode_len);
+        st->st_mode |= is_dir ? S_IFDIR : S_IFREG;
+    }
+
+    return 0;
+}
+
+
+ssize_t gridftp_parse_mlsd_batch(const char* buffer, size_t len, bool eof,
+        std::vector<GridFtpMlsdEntry>& batch, const char** error_line, size_t* error_len)
+{
+    const char* line = buffer;
+    const char* end = buffer + len;
+
+    while (line < end) {
+        const char* newline = static_cast<const char*>(memchr(line, '\n', end - line));
+        if (newline == NULL) {
+            if (!eof)
+                break;
+            newline = end;
+        }
+
+        const char* content = line;
+        while (content < newline && g_ascii_isspace(*content))
+            ++content;
+
+        if (content < newline) {
+            GridFtpMlsdEntry entry = {};
+            if (gridftp_parse_mlsd_entry(content, newline - content, &entry.st, &entry.name, &entry.name_len) < 0) {
+                *error_line = line;
+                *error_len = newline - line;
+                return -1;
+            }
+            batch.push_back(entry);
+        }
+
+        line = (newline < end) ? newline + 1 : end;
+    }
+
+    return line - buffer;
+}
@@ -0,0 +1,58 @@
+/*
+ * Copyright (c) CERN 2013-2017
+ *
+ * Copyright (c) Members of the EMI Collaboration. 2010-2013
+ *  See  http://www.eu-emi.eu/partners for details on the copyright
+ *  holders.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+#ifndef GFAL2_GRIDFTP_MLSD_PARSER_H
+#define GFAL2_GRIDFTP_MLSD_PARSER_H
+
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <time.h>
+#include <vector>
+
+// MLSD/MLST parser working directly on the received data, without copying nor modifying it.
+// It does not depend on Globus, so it can be benchmarked on its own.
+
+/// Entry parsed from a MLSD line
+/// name points inside the parsed buffer, and is not null terminated
+struct GridFtpMlsdEntry {
+    struct stat st;
+    const char* name;
+    size_t name_len;
+};
+
+/// Convert a MLSD "modify" timestamp (YYYYMMDDHHMMSS[.sss], UTC) to a time_t
+/// Returns -1 if the timestamp is malformed
+time_t gridftp_mdtm_to_timet(const char* mdtm, size_t len);
+
+/// Parse a single MLSD/MLST line of length len
+/// Leading and trailing whitespaces, including the line terminator, are ignored
+/// Returns 0 on success, -1 if the line is malformed
+int gridftp_parse_mlsd_entry(const char* line, size_t len, struct stat* st,
+        const char** name, size_t* name_len);
+
+/// Parse all the complete lines in buffer, and append them to batch. Blank lines are skipped.
+/// If eof is true, the last line does not need to be terminated by a newline.
+/// Returns the number of bytes consumed, which ends after the last complete line.
+/// If a line is malformed, returns -1, and error_line and error_len point to it.
+ssize_t gridftp_parse_mlsd_batch(const char* buffer, size_t len, bool eof,
+        std::vector<GridFtpMlsdEntry>& batch, const char** error_line, size_t* error_len);
+
+#endif //GFAL2_GRIDFTP_MLSD_PARSER_H
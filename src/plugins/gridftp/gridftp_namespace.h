@@ -61,6 +61,9 @@ struct dirent* gfal_gridftp_readdirG(plugin_handle handle, gfal_file_handle fh,
 struct dirent* gfal_gridftp_readdirppG(plugin_handle handle,
         gfal_file_handle fh, struct stat*, GError** err);
 
+ssize_t gfal_gridftp_readdir_batchG(plugin_handle handle, gfal_file_handle fh,
+        gfal2_dir_entry_t* entries, size_t nentries, GError** err);
+
 int gfal_gridftp_closedirG(plugin_handle handle, gfal_file_handle fh,
         GError** err);
 
@@ -69,7 +69,7 @@ void GridFTPModule::checksum(const char* url, const char* check_type,
     gfal2_log(G_LOG_LEVEL_DEBUG, " Checksum calculation %s for url %s",
             check_type, url);
 
-    GridFTPSessionHandler handler(_handle_factory, url);
+    GridFTPSessionHandler handler(_handle_factory, url, true);
     GridFTPRequestState req(&handler, GRIDFTP_REQUEST_FTP);
 
     if (buffer_length < 16) {
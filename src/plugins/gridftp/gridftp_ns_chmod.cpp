@@ -33,7 +33,7 @@ void GridFTPModule::chmod(const char* path, mode_t mode)
     }
     gfal2_log(G_LOG_LEVEL_DEBUG, " -> [GridFTPModule::chmod] ");
 
-    GridFTPSessionHandler handler(_handle_factory, path);
+    GridFTPSessionHandler handler(_handle_factory, path, true);
     GridFTPRequestState req(&handler);
 
     globus_result_t res = globus_ftp_client_chmod(req.handler->get_ftp_client_handle(),
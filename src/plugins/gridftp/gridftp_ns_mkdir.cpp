@@ -34,7 +34,7 @@ void GridFTPModule::mkdir(const char* path, mode_t mode)
     }
     gfal2_log(G_LOG_LEVEL_DEBUG, " -> [GridFTPModule::mkdir] ");
 
-    GridFTPSessionHandler handler(_handle_factory, path);
+    GridFTPSessionHandler handler(_handle_factory, path, true);
     GridFTPRequestState req(&handler);
 
     globus_result_t res = globus_ftp_client_mkdir(req.handler->get_ftp_client_handle(),
@@ -122,6 +122,30 @@ extern "C" struct dirent* gfal_gridftp_readdirppG(plugin_handle handle,
 }
 
 
+extern "C" ssize_t gfal_gridftp_readdir_batchG(plugin_handle handle,
+        gfal_file_handle fh, gfal2_dir_entry_t* entries, size_t nentries, GError** err)
+{
+    g_return_val_err_if_fail(handle != NULL && fh != NULL && entries != NULL, -1, err,
+            "[gfal_gridftp_readdir_batchG][gridftp] Invalid parameters");
+
+    GError * tmp_err = NULL;
+    ssize_t ret = -1;
+    gfal2_log(G_LOG_LEVEL_DEBUG, "  -> [gfal_gridftp_readdir_batchG]");
+    CPP_GERROR_TRY
+        GridFtpDirReader* reader = static_cast<GridFtpDirReader*>(gfal_file_handle_get_fdesc(fh));
+        // Not open yet, so instantiate the reader
+        if (reader == NULL) {
+            GridFTPModule* gsiftp = static_cast<GridFTPModule*>(handle);
+            reader = gfal_gridftp_readdirpp_instantiate(gsiftp, gfal_file_handle_get_path(fh));
+            gfal_file_handle_set_fdesc(fh, reader);
+        }
+        ret = reader->readdir_batch(entries, nentries);
+    CPP_GERROR_CATCH(&tmp_err);
+    gfal2_log(G_LOG_LEVEL_DEBUG, "  [gfal_gridftp_readdir_batchG] <-");
+    G_RETURN_ERR(ret, tmp_err, err);
+}
+
+
 extern "C" int gfal_gridftp_closedirG(plugin_handle handle, gfal_file_handle fh,
         GError** err)
 {
@@ -34,7 +34,7 @@ void GridFTPModule::rename(const char* src, const char* dst)
 
     gfal2_log(G_LOG_LEVEL_DEBUG, " -> [GridFTPModule::rename] ");
 
-    GridFTPSessionHandler handler(_handle_factory, src);
+    GridFTPSessionHandler handler(_handle_factory, src, true);
     GridFTPRequestState req(&handler);
 
     globus_result_t res = globus_ftp_client_move(req.handler->get_ftp_client_handle(),
@@ -35,7 +35,7 @@ void GridFTPModule::rmdir(const char* path)
     gfal2_log(G_LOG_LEVEL_DEBUG, " -> [GridFTPModule::rmdir] ");
 
     try {
-        GridFTPSessionHandler handler(_handle_factory, path);
+        GridFTPSessionHandler handler(_handle_factory, path, true);
         GridFTPRequestState req(&handler);
 
         globus_result_t res = globus_ftp_client_rmdir(
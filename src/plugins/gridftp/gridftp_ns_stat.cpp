@@ -139,7 +139,7 @@ void GridFTPModule::internal_globus_gass_stat(const char* path,
     gfal2_log(G_LOG_LEVEL_DEBUG,
               " -> [Gridftp_stat_module::globus_gass_stat] ");
 
-    GridFTPSessionHandler handler(get_session_factory(), path);
+    GridFTPSessionHandler handler(get_session_factory(), path, true);
 
     globus_ftp_client_tristate_t supported;
     globus_ftp_client_is_feature_supported(handler.get_ftp_features(),
@@ -46,7 +46,7 @@ void GridFTPModule::unlink(const char* path)
                 "Invalid arguments path");
     }
 
-    GridFTPSessionHandler handler(_handle_factory, path);
+    GridFTPSessionHandler handler(_handle_factory, path, true);
     gridftp_unlink_internal(_handle_factory->get_gfal2_context(), &handler, path);
 
 }
@@ -16,6 +16,7 @@
 
 #include "gridftp_parsing.h"
 
+#include <algorithm>
 #include <cstdio>
 #include <cstring>
 #include <glib.h>
@@ -26,256 +27,27 @@
 
 #include <gfal_api.h>
 
-
-// Adapted from http://cvs.globus.org/viewcvs.cgi/gass/copy/source/globus_gass_copy_glob.c
-static int copy_mdtm_to_timet(char * mdtm_str, int * time_out)
-{
-    char * p;
-    struct tm tm;
-    struct tm gmt_now_tm;
-    struct tm * gmt_now_tm_p;
-    time_t offset;
-    time_t gmt_now;
-    time_t now;
-    time_t file_time;
-    int rc;
-
-    p = mdtm_str;
-
-    memset(&tm, '\0', sizeof(struct tm));
-
-    /* 4 digit year */
-    rc = sscanf(p, "%04d", &tm.tm_year);
-    if (rc != 1) {
-        goto error_exit;
-    }
-    tm.tm_year -= 1900;
-    p += 4;
-
-    /* 2 digit month [01-12] */
-    rc = sscanf(p, "%02d", &tm.tm_mon);
-    if (rc != 1) {
-        goto error_exit;
-    }
-    tm.tm_mon--;
-    p += 2;
-
-    /* 2 digit day/month [01-31] */
-    rc = sscanf(p, "%02d", &tm.tm_mday);
-    if (rc != 1) {
-        goto error_exit;
-    }
-    p += 2;
-
-    /* 2 digit hour [00-23] */
-    rc = sscanf(p, "%02d", &tm.tm_hour);
-    if (rc != 1) {
-        goto error_exit;
-    }
-    p += 2;
-
-    /* 2 digit minute [00-59] */
-    rc = sscanf(p, "%02d", &tm.tm_min);
-    if (rc != 1) {
-        goto error_exit;
-    }
-    p += 2;
-
-    /* 2 digit second [00-60] */
-    rc = sscanf(p, "%02d", &tm.tm_sec);
-    if (rc != 1) {
-        goto error_exit;
-    }
-    p += 2;
-
-    file_time = mktime(&tm);
-    if (file_time == (time_t) -1) {
-        goto error_exit;
-    }
-
-    now = time(&now);
-    if (now == (time_t) -1) {
-        goto error_exit;
-    }
-
-    memset(&gmt_now_tm, '\0', sizeof(struct tm));
-    gmt_now_tm_p = globus_libc_gmtime_r(&now, &gmt_now_tm);
-    if (gmt_now_tm_p == NULL) {
-        goto error_exit;
-    }
-
-    gmt_now = mktime(&gmt_now_tm);
-    if (gmt_now == (time_t) -1) {
-        goto error_exit;
-    }
-
-    offset = now - gmt_now;
-
-    *time_out = file_time + offset;
-
-    return 0;
-
-    error_exit:
-    return -1;
-}
+#include "gridftp_mlsd_parser.h"
 
 
 globus_result_t parse_mlst_line(char *line, struct stat *stat_info, char *filename_buf, size_t filename_size)
 {
-    globus_result_t result;
-    int i;
-    char * space;
-    char * filename;
-    char * startline;
-    char * startfact;
-    char * endfact;
-    char * factval;
-
-    char * unique_id = NULL;
-    char * mode_s = NULL;
-    char * symlink_target = NULL;
-    char * modify_s = NULL;
-    char * size_s = NULL;
-    globus_gass_copy_glob_entry_t type = GLOBUS_GASS_COPY_GLOB_ENTRY_FILE;
+    const char* filename;
+    size_t filename_len;
 
-    startline = line;
-
-    space = strchr(startline, ' ');
-    if (space == GLOBUS_NULL) {
-        result = globus_error_put(
+    if (gridftp_parse_mlsd_entry(line, strlen(line), stat_info, &filename, &filename_len) < 0) {
+        return globus_error_put(
                 globus_error_construct_string(GLOBUS_GASS_COPY_MODULE,
                                               GLOBUS_NULL, "[%s]: Bad MLSD response", __func__));
-
-        goto error_invalid_mlsd;
-    }
-    *space = '\0';
-    filename = space + 1;
-    startfact = startline;
-
-    if (filename_buf) {
-        size_t len = g_strlcpy(filename_buf, filename, filename_size);
-        char* trailing = filename_buf + len;
-        do {
-            *trailing = '\0';
-            --trailing;
-        } while (trailing >= filename_buf && isspace(*trailing));
     }
 
-    while (startfact != space) {
-        endfact = strchr(startfact, ';');
-        if (endfact) {
-            *endfact = '\0';
-        }
-        else {
-            /*
-             older MLST-draft spec says ending fact can be missing
-             the final semicolon... not a problem to support this,
-             no need to die.  (ncftpd does this)
-
-             result = globus_error_put(
-             globus_error_construct_string(
-             GLOBUS_GASS_COPY_MODULE,
-             GLOBUS_NULL,
-             "[%s]: Bad MLSD response",
-             myname));
-
-             goto error_invalid_mlsd;
-             */
-
-            endfact = space - 1;
-        }
-
-        factval = strchr(startfact, '=');
-        if (!factval) {
-            result = globus_error_put(
-                    globus_error_construct_string(GLOBUS_GASS_COPY_MODULE,
-                                                  GLOBUS_NULL, "[%s]: Bad MLSD response", __func__));
-
-            goto error_invalid_mlsd;
-        }
-        *(factval++) = '\0';
-
-        for (i = 0; startfact[i] != '\0'; i++) {
-            startfact[i] = tolower(startfact[i]);
-        }
-
-        if (strcmp(startfact, "type") == 0) {
-            if ((strcasecmp(factval, "dir") == 0)
-              || (strcasecmp(factval, "pdir") == 0)
-              || (strcasecmp(factval, "cdir") == 0))  {
-                type = GLOBUS_GASS_COPY_GLOB_ENTRY_DIR;
-            }
-            else if (strcasecmp(factval, "file") == 0) {
-                type = GLOBUS_GASS_COPY_GLOB_ENTRY_FILE;
-            }
-            else {
-                type = GLOBUS_GASS_COPY_GLOB_ENTRY_OTHER;
-            }
-        }
-        if (strcmp(startfact, "unique") == 0) {
-            unique_id = factval;
-        }
-        if (strcmp(startfact, "unix.mode") == 0) {
-            mode_s = factval;
-        }
-        if (strcmp(startfact, "modify") == 0) {
-            modify_s = factval;
-        }
-        if (strcmp(startfact, "size") == 0) {
-            size_s = factval;
-        }
-        if (strcmp(startfact, "unix.slink") == 0) {
-            symlink_target = factval;
-        }
-        if (strcmp(startfact, "unix.uid") == 0) {
-            stat_info->st_uid = atoi(factval);
-        }
-        if (strcmp(startfact, "unix.gid") == 0) {
-            stat_info->st_gid = atoi(factval);
-        }
-
-
-        startfact = endfact + 1;
-    }
-
-    stat_info->st_nlink = 1;
-    stat_info->st_mode = -1;
-    stat_info->st_size = 0;
-    stat_info->st_mtime = -1;
-
-    if (mode_s) {
-        stat_info->st_mode = strtoul(mode_s, NULL, 8);
-        if (type == GLOBUS_GASS_COPY_GLOB_ENTRY_DIR) {
-            stat_info->st_mode |= S_IFDIR;
-        }
-        else {
-            stat_info->st_mode |= S_IFREG;
-        }
-    }
-
-    if (size_s) {
-        off_t size;
-        int rc;
-
-        rc = sscanf(size_s, "%ld", &size);
-        if (rc == 1) {
-            stat_info->st_size = size;
-        }
-    }
-
-    if (modify_s) {
-        int mdtm;
-
-        if (copy_mdtm_to_timet(modify_s, &mdtm) == GLOBUS_SUCCESS) {
-            stat_info->st_mtime = mdtm;
-        }
+    if (filename_buf && filename_size > 0) {
+        size_t len = std::min(filename_len, filename_size - 1);
+        memcpy(filename_buf, filename, len);
+        filename_buf[len] = '\0';
     }
 
     return GLOBUS_SUCCESS;
-
-    error_invalid_mlsd:
-
-    return result;
 }
 
 
@@ -149,6 +149,7 @@ gfal_plugin_interface gfal_plugin_init(gfal2_context_t handle, GError** err)
     ret.opendirG = &gfal_gridftp_opendirG;
     ret.readdirG = &gfal_gridftp_readdirG;
     ret.readdirppG = &gfal_gridftp_readdirppG;
+    ret.readdir_batchG = &gfal_gridftp_readdir_batchG;
     ret.closedirG = &gfal_gridftp_closedirG;
     ret.openG = &gfal_gridftp_openG;
     ret.closeG = &gfal_gridftp_closeG;
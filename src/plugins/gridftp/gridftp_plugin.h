@@ -37,12 +37,16 @@
 #define GRIDFTP_CONFIG_BLOCK_SIZE     "BLOCK_SIZE"
 #define GRIDFTP_CONFIG_NB_STREAM      "RD_NB_STREAM"
 #define GRIDFTP_CONFIG_RESOLVE_DNS    "RESOLVE_DNS"
+#define GRIDFTP_CONFIG_METADATA_CHANNELS "METADATA_CHANNELS"
 
 #define GRIDFTP_CONFIG_TRANSFER_CHECKSUM       "COPY_CHECKSUM_TYPE"
 #define GRIDFTP_CONFIG_TRANSFER_PERF_TIMEOUT   "PERF_MARKER_TIMEOUT"
 #define GRIDFTP_CONFIG_TRANSFER_SKIP_CHECKSUM  "SKIP_SOURCE_CHECKSUM"
 #define GRIDFTP_CONFIG_TRANSFER_UDT            "ENABLE_UDT"
 
+// Subsystem used for structured logging, see gfal2_log_set_subsystem_level
+#define GRIDFTP_LOG_SUBSYSTEM "gridftp"
+
 
 #ifdef __cplusplus
 extern "C" {
@@ -72,23 +72,48 @@ GassCopyAttrHandler::~GassCopyAttrHandler()
 }
 
 
-GridFTPSessionHandler::GridFTPSessionHandler(GridFTPFactory* f, const std::string &uri): factory(f)
+GridFTPSessionHandler::GridFTPSessionHandler(GridFTPFactory* f, const std::string &uri, bool metadata): factory(f)
 {
-    this->session = f->get_session(uri);
+    this->session = metadata ? f->get_metadata_session(uri) : f->get_session(uri);
 
-    GridFTPRequestState req(this);
-    globus_result_t result = globus_ftp_client_feat(&this->session->handle_ftp, (char*)uri.c_str(), &this->session->operation_attr_ftp,
-                           &this->session->ftp_features, globus_ftp_client_done_callback, &req);
-    gfal_globus_check_result(GFAL_GLOBUS_DONE_SCOPE, result);
-    req.wait(GFAL_GLOBUS_DONE_SCOPE);
+    try {
+        // A metadata channel stays on its host, so the features it got once are still valid
+        std::string host = gridftp_hostname_from_url(uri);
+        if (session->channel_key.empty() || session->features_host != host) {
+            GridFTPRequestState req(this);
+            globus_result_t result = globus_ftp_client_feat(&this->session->handle_ftp, (char*)uri.c_str(), &this->session->operation_attr_ftp,
+                                   &this->session->ftp_features, globus_ftp_client_done_callback, &req);
+            gfal_globus_check_result(GFAL_GLOBUS_DONE_SCOPE, result);
+            req.wait(GFAL_GLOBUS_DONE_SCOPE);
+            session->features_host = host;
+        }
 
-    // Enable SPAS if configured and supported
-    gboolean spasEnabled = gfal2_get_opt_boolean_with_default(f->get_gfal2_context(), GRIDFTP_CONFIG_GROUP, GRIDFTP_CONFIG_SPAS, FALSE);
-    globus_ftp_client_tristate_t spasSupported;
-    globus_ftp_client_is_feature_supported(&this->session->ftp_features, &spasSupported, GLOBUS_FTP_CLIENT_FEATURE_MLST);
+        // Enable SPAS if configured and supported
+        gboolean spasEnabled = gfal2_get_opt_boolean_with_default(f->get_gfal2_context(), GRIDFTP_CONFIG_GROUP, GRIDFTP_CONFIG_SPAS, FALSE);
+        globus_ftp_client_tristate_t spasSupported;
+        globus_ftp_client_is_feature_supported(&this->session->ftp_features, &spasSupported, GLOBUS_FTP_CLIENT_FEATURE_MLST);
 
-    if (spasEnabled && spasSupported == GLOBUS_FTP_CLIENT_TRUE) {
-        globus_ftp_client_operationattr_set_striped(&this->session->operation_attr_ftp, GLOBUS_TRUE);
+        if (spasEnabled && spasSupported == GLOBUS_FTP_CLIENT_TRUE) {
+            globus_ftp_client_operationattr_set_striped(&this->session->operation_attr_ftp, GLOBUS_TRUE);
+        }
+    }
+    catch (...) {
+        // The channel could not be prepared, do not reuse it
+        session->broken = true;
+        // The destructor will not be called, give the session back now
+        release();
+        throw;
+    }
+}
+
+
+void GridFTPSessionHandler::release()
+{
+    if (session->channel_key.empty()) {
+        factory->release_session(session);
+    }
+    else {
+        factory->release_metadata_session(session);
     }
 }
 
@@ -96,7 +121,7 @@ GridFTPSessionHandler::GridFTPSessionHandler(GridFTPFactory* f, const std::strin
 GridFTPSessionHandler::~GridFTPSessionHandler()
 {
     try {
-        factory->release_session(this->session);
+        release();
     }
     catch (const std::exception& e) {
         gfal2_log(G_LOG_LEVEL_MESSAGE,
@@ -110,7 +135,7 @@ GridFTPSessionHandler::~GridFTPSessionHandler()
 
 
 GridFTPSession::GridFTPSession(gfal2_context_t context, const std::string& baseurl):
-        baseurl(baseurl), cred_id(NULL), pasv_plugin(NULL), context(context), params(NULL)
+        baseurl(baseurl), cred_id(NULL), pasv_plugin(NULL), context(context), params(NULL), channel_slot(NULL), broken(false)
 {
     globus_result_t res;
 
@@ -432,6 +457,7 @@ GridFTPFactory::GridFTPFactory(gfal2_context_t handle): gfal2_context(handle)
         throw Gfal::CoreException(tmp_err);
     }
     size_cache = 400;
+    metadata_idle = 0;
     globus_mutex_init(&mux_cache, NULL);
 }
 
@@ -470,25 +496,30 @@ GridFTPSession* GridFTPFactory::get_recycled_handle(const std::string &baseurl)
     globus_mutex_lock(&mux_cache);
 
     GridFTPSession* session = NULL;
+    const char* lookup = "exact";
     // try to find a session explicitly associated with this handle
     std::multimap<std::string, GridFTPSession*>::iterator it = session_cache.find(baseurl);
 
     // if no session found, take a generic one
     if (it == session_cache.end()) {
-        gfal2_log(G_LOG_LEVEL_DEBUG,
-                "no session associated with this baseurl, try find generic one .... ");
+        lookup = "generic";
         it = session_cache.begin();
     }
     if (it != session_cache.end()) {
-        gfal2_log(G_LOG_LEVEL_DEBUG,"gridftp session for: %s found in  cache !", baseurl.c_str());
         session = (*it).second;
         session_cache.erase(it);
     }
     else {
-        gfal2_log(G_LOG_LEVEL_DEBUG, "no session found in cache for %s!", baseurl.c_str());
+        lookup = "miss";
     }
 
     globus_mutex_unlock(&mux_cache);
+
+    // Log outside of the cache lock
+    if (gfal2_log_is_enabled(G_LOG_LEVEL_DEBUG, GRIDFTP_LOG_SUBSYSTEM)) {
+        const gfal2_log_field_t fields[] = {{"baseurl", baseurl.c_str()}, {"lookup", lookup}};
+        gfal2_log_structured(G_LOG_LEVEL_DEBUG, GRIDFTP_LOG_SUBSYSTEM, fields, 2, "gridftp session checkout");
+    }
     return session;
 }
 
@@ -497,6 +528,14 @@ GridFTPFactory::~GridFTPFactory()
 {
     try {
         clear_cache();
+        std::map<std::string, MetadataChannels>::iterator it;
+        for (it = metadata_channels.begin(); it != metadata_channels.end(); ++it) {
+            std::list<GridFTPSession*>::iterator session;
+            for (session = it->second.idle.begin(); session != it->second.idle.end(); ++session) {
+                delete *session;
+            }
+        }
+        metadata_channels.clear();
     }
     catch (const std::exception & e) {
         gfal2_log(G_LOG_LEVEL_MESSAGE,
@@ -654,7 +693,7 @@ GridFTPSession* GridFTPFactory::get_session(const std::string &url)
 void GridFTPFactory::release_session(GridFTPSession* session)
 {
     session_reuse = gfal2_get_opt_boolean_with_default(gfal2_context, GRIDFTP_CONFIG_GROUP, GRIDFTP_CONFIG_SESSION_REUSE, FALSE);
-    if (session_reuse) {
+    if (session_reuse && !session->broken) {
         recycle_session(session);
     }
     else {
@@ -664,6 +703,100 @@ void GridFTPFactory::release_session(GridFTPSession* session)
 }
 
 
+GridFTPSession* GridFTPFactory::get_metadata_session(const std::string &url)
+{
+    int limit = gfal2_get_opt_integer_with_default(gfal2_context, GRIDFTP_CONFIG_GROUP,
+            GRIDFTP_CONFIG_METADATA_CHANNELS, 4);
+    if (limit <= 0) {
+        return get_session(url);
+    }
+
+    gchar *ucert = NULL, *ukey = NULL;
+    gchar *user = NULL, *passwd = NULL;
+    std::string baseurl = gfal_gridftp_get_credentials(gfal2_context, url, &ucert, &ukey, &user, &passwd);
+    g_free(ucert);
+    g_free(ukey);
+    g_free(user);
+    g_free(passwd);
+
+    // Channels can only be shared by callers using the same credentials
+    std::string key = gridftp_hostname_from_url(url) + " " + baseurl;
+    GridFTPSession* session = NULL;
+
+    // The callers of all the contexts wait for a channel in the queue of the endpoint
+    gfal2_endpoint_slot_t slot = NULL;
+    GError* tmp_err = NULL;
+    if (gfal2_endpoint_slot_acquire(gfal2_context, gridftp_plugin_name(), url.c_str(),
+            GRIDFTP_CONFIG_METADATA_CHANNELS, limit, -1, &slot, &tmp_err) < 0) {
+        throw Gfal::CoreException(tmp_err);
+    }
+
+    globus_mutex_lock(&mux_cache);
+    std::map<std::string, MetadataChannels>::iterator channels = metadata_channels.find(key);
+    if (channels != metadata_channels.end()) {
+        session = channels->second.idle.front();
+        channels->second.idle.pop_front();
+        --metadata_idle;
+        if (channels->second.idle.empty()) {
+            metadata_channels.erase(channels);
+        }
+    }
+    globus_mutex_unlock(&mux_cache);
+
+    if (gfal2_log_is_enabled(G_LOG_LEVEL_DEBUG, GRIDFTP_LOG_SUBSYSTEM)) {
+        const gfal2_log_field_t fields[] = {{"channel", key.c_str()}, {"lookup", session ? "idle" : "new"}};
+        gfal2_log_structured(G_LOG_LEVEL_DEBUG, GRIDFTP_LOG_SUBSYSTEM, fields, 2, "gridftp metadata channel checkout");
+    }
+
+    if (session == NULL) {
+        try {
+            session = get_session(url);
+        }
+        catch (...) {
+            gfal2_endpoint_slot_release(slot);
+            throw;
+        }
+        session->channel_key = key;
+    }
+    session->channel_slot = slot;
+    return session;
+}
+
+
+void GridFTPFactory::release_metadata_session(GridFTPSession* session)
+{
+    bool reuse = gfal2_get_opt_boolean_with_default(gfal2_context, GRIDFTP_CONFIG_GROUP, GRIDFTP_CONFIG_SESSION_REUSE, FALSE);
+    gfal2_endpoint_slot_t slot = session->channel_slot;
+    session->channel_slot = NULL;
+
+    if (reuse && !session->broken) {
+        globus_mutex_lock(&mux_cache);
+        if (metadata_idle < size_cache) {
+            metadata_channels[session->channel_key].idle.push_back(session);
+            ++metadata_idle;
+            session = NULL;
+        }
+        globus_mutex_unlock(&mux_cache);
+    }
+
+    if (session) {
+        gfal2_log(G_LOG_LEVEL_DEBUG, "destroy gridftp metadata channel for %s%s ...",
+                session->channel_key.c_str(), session->broken ? " after a failure" : "");
+        delete session;
+    }
+    gfal2_endpoint_slot_release(slot);
+}
+
+
+unsigned int GridFTPFactory::get_idle_metadata_channels()
+{
+    globus_mutex_lock(&mux_cache);
+    unsigned int idle = metadata_idle;
+    globus_mutex_unlock(&mux_cache);
+    return idle;
+}
+
+
 static
 void gfal_globus_done_callback(void* user_args,
         globus_object_t *globus_error)
@@ -744,6 +877,24 @@ void gridftp_cancel(gfal2_context_t context, void* userdata)
 }
 
 
+// Errors answered by the server, after which the channel can still be used
+static bool gridftp_error_keeps_session(int errcode)
+{
+    switch (errcode) {
+        case ENOENT:
+        case EACCES:
+        case EEXIST:
+        case ENOTDIR:
+        case EISDIR:
+        case ENOTSUP:
+        case ENOSPC:
+            return true;
+        default:
+            return false;
+    }
+}
+
+
 static int callback_cond_wait(GridFTPRequestState* req, time_t timeout)
 {
     globus_abstime_t timeout_expires;
@@ -785,11 +936,14 @@ void GridFTPRequestState::wait(GQuark scope, time_t timeout)
 
         // Wait again for the callback, ignoring timeout this time
         callback_cond_wait(this, timeout);
+        handler->session->broken = true;
 
         throw Gfal::CoreException(scope, ETIMEDOUT, "Operation timed out");
     }
 
     if (error) {
+        if (!gridftp_error_keeps_session(error->code()))
+            handler->session->broken = true;
         if (error->domain() != 0)
             throw Gfal::CoreException(scope, error->code(), error->what());
         else
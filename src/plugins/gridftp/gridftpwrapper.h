@@ -21,12 +21,13 @@
 #ifndef GRIDFTPWRAPPER_H
 #define GRIDFTPWRAPPER_H
 
-#include <gfal_api.h>
+#include <gfal_plugins_api.h>
 #include <exceptions/gfalcoreexception.hpp>
 #include <time_utils.h>
 
 #include <ctime>
 #include <algorithm>
+#include <list>
 #include <map>
 #include <memory>
 
@@ -125,6 +126,16 @@ public:
     gfal2_context_t context;
     gfalt_params_t params;
 
+    // metadata channel queue this session belongs to, empty if none
+    std::string channel_key;
+    // slot of the metadata channel while checked out, NULL if none
+    gfal2_endpoint_slot_t channel_slot;
+    // host the ftp_features were obtained from, empty if unknown
+    std::string features_host;
+    // set when an operation failed in a way that may have left the channel unusable,
+    // the session is then closed on release instead of reused
+    bool broken;
+
     // Handy option setters
     void set_gridftpv2(bool v2);
     void set_ipv6(bool ipv6);
@@ -140,7 +151,8 @@ public:
 
 class GridFTPSessionHandler {
 public:
-    GridFTPSessionHandler(GridFTPFactory* f, const std::string &uri);
+    // If metadata is true, the session is a control channel taken from the metadata queue of the host
+    GridFTPSessionHandler(GridFTPFactory* f, const std::string &uri, bool metadata = false);
     ~GridFTPSessionHandler();
 
     globus_ftp_client_handle_t* get_ftp_client_handle();
@@ -156,6 +168,8 @@ public:
 
 private:
     GridFTPFactory* factory;
+
+    void release();
 };
 
 
@@ -172,6 +186,21 @@ public:
      **/
     void release_session(GridFTPSession* h);
 
+    /** Get a control channel for a metadata operation (MLST, CKSM, DELE, MKD...)
+     *  At most METADATA_CHANNELS channels are in use per host; callers wait for a free one
+     *  in the queue of the endpoint admission, instead of opening more sessions
+     **/
+    GridFTPSession* get_metadata_session(const std::string &url);
+
+    /** Give back a channel obtained with get_metadata_session
+     *  Broken channels are closed, as the idle ones above the size of the cache
+     **/
+    void release_metadata_session(GridFTPSession* h);
+
+    /** Number of idle metadata channels, for all hosts
+     **/
+    unsigned int get_idle_metadata_channels();
+
     gfal2_context_t get_gfal2_context();
 
 private:
@@ -183,6 +212,15 @@ private:
     std::multimap<std::string, GridFTPSession*> session_cache;
     globus_mutex_t mux_cache;
 
+    // idle metadata channels of a host and credentials, protected by mux_cache
+    // The number of channels in use is limited by the admission of the endpoint
+    struct MetadataChannels {
+        std::list<GridFTPSession*> idle;
+    };
+    std::map<std::string, MetadataChannels> metadata_channels;
+    // total of idle metadata channels, bounded by size_cache
+    unsigned int metadata_idle;
+
     void recycle_session(GridFTPSession* sess);
     void clear_cache();
     GridFTPSession* get_recycled_handle(const std::string &baseurl);
@@ -25,11 +25,19 @@
 #include <unistd.h>
 #include <checksums/checksums.h>
 #include <cryptopp/base64.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <cstdio>
 #include <cstring>
 #include <list>
+#include <memory>
+#include <mutex>
 #include <sstream>
+#include <thread>
 #include "gfal_http_plugin.h"
+#include "gfal_http_copy.h"
 
 // An enumeration of the different HTTP third-party-copy strategies.
 // NOTE: we loop through strategies from beginning to end, meaning the default
@@ -206,6 +214,76 @@ bool is_http_streaming_enabled(gfal2_context_t context, const char* src, const c
     return gfal2_get_opt_boolean_with_default(context, "HTTP PLUGIN", "ENABLE_STREAM_COPY", TRUE);
 }
 
+static bool is_http_partial_put_enabled(gfal2_context_t context, const char* dst)
+{
+    int dst_partial_put = get_se_custom_opt_boolean(context, dst, "ENABLE_PARTIAL_PUT");
+
+    if (dst_partial_put > -1) {
+        return dst_partial_put;
+    }
+
+    return gfal2_get_opt_boolean_with_default(context, "HTTP PLUGIN", "ENABLE_PARTIAL_PUT", FALSE);
+}
+
+std::string gfal_http_content_range(off_t offset, off_t size)
+{
+    std::ostringstream range;
+    range << "bytes " << offset << "-" << (size - 1) << "/" << size;
+    return range.str();
+}
+
+bool gfal_http_accepts_byte_ranges(const std::string& accept_ranges)
+{
+    std::istringstream units(accept_ranges);
+    std::string unit;
+    while (std::getline(units, unit, ',')) {
+        unit.erase(0, unit.find_first_not_of(" \t"));
+        unit.erase(unit.find_last_not_of(" \t") + 1);
+        if (strcasecmp(unit.c_str(), "bytes") == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Servers ignoring Content-Range on a PUT replace the destination with the missing range only,
+// so partial PUTs are only sent to endpoints advertising byte ranges
+static bool is_http_partial_put_supported(GfalHttpPluginData* davix, const char* dst)
+{
+    Davix::DavixError* dav_err = NULL;
+    Davix::Uri uri(dst);
+    Davix::RequestParams req_params;
+    davix->get_params(&req_params, uri, GfalHttpPluginData::OP::HEAD);
+
+    Davix::HttpRequest request(davix->context, uri, &dav_err);
+    request.setRequestMethod("OPTIONS");
+    request.setParameters(req_params);
+
+    std::string accept_ranges;
+    bool supported = dav_err == NULL && request.executeRequest(&dav_err) == 0 &&
+                     request.getRequestCode() < 400 &&
+                     request.getAnswerHeader("Accept-Ranges", accept_ranges) &&
+                     gfal_http_accepts_byte_ranges(accept_ranges);
+
+    if (!supported) {
+        gfal2_log(G_LOG_LEVEL_WARNING, "Partial PUT enabled, but %s does not advertise byte ranges (%s), "
+                  "the copy will not be resumed", dst,
+                  dav_err ? dav_err->getErrMsg().c_str() : accept_ranges.c_str());
+    }
+    Davix::DavixError::clearError(&dav_err);
+    return supported;
+}
+
+bool gfal_http_copy_resumable(gfal2_context_t context, gfalt_params_t params,
+                              const char* src, const char* dst,
+                              const std::function<bool()>& partial_put_supported)
+{
+    return gfalt_get_offset_from_source(params, NULL) != 0 &&
+           is_http_streaming_enabled(context, src, dst) &&
+           is_http_partial_put_enabled(context, dst) &&
+           partial_put_supported();
+}
+
 static CopyMode get_default_copy_mode(gfal2_context_t context)
 {
     gchar* copy_mode_str = gfal2_get_opt_string_with_default(context, "HTTP PLUGIN", "DEFAULT_COPY_MODE", GFAL_TRANSFER_TYPE_PULL);
@@ -543,24 +621,494 @@ static int gfal_http_third_party_copy(gfal2_context_t context,
 }
 
 
+bool gfal_http_retry(gfal2_context_t context, int retries, std::chrono::milliseconds delay,
+                     const std::atomic<bool>& stop, const std::function<bool(int)>& call)
+{
+    // Short enough for a cancellation to be noticed right away
+    const std::chrono::milliseconds slice(100);
+
+    for (int attempt = 0; ; ++attempt) {
+        if (call(attempt)) {
+            return true;
+        }
+        if (attempt >= retries) {
+            return false;
+        }
+
+        auto wait_until = std::chrono::steady_clock::now() + delay * (1 << std::min(attempt, 5));
+        while (true) {
+            if (stop || gfal2_is_canceled(context)) {
+                return false;
+            }
+            auto now = std::chrono::steady_clock::now();
+            if (now >= wait_until) {
+                break;
+            }
+            std::this_thread::sleep_for(std::min<std::chrono::steady_clock::duration>(slice, wait_until - now));
+        }
+    }
+}
+
+
+// Read exactly "count" bytes, unless the end of the file is reached first
+static ssize_t gfal_http_read_full(gfal2_context_t context, int fd, char* buffer, size_t count,
+        off_t offset, bool positional, GError** err)
+{
+    size_t done = 0;
+    while (done < count) {
+        ssize_t ret;
+        if (positional) {
+            ret = gfal2_pread(context, fd, buffer + done, count - done, offset + done, err);
+        } else {
+            ret = gfal2_read(context, fd, buffer + done, count - done, err);
+        }
+        if (ret < 0) {
+            return -1;
+        }
+        if (ret == 0) {
+            break;
+        }
+        done += ret;
+    }
+    return done;
+}
+
+
+// Source of the parts of a parallel streamed copy.
+// When ranged, each worker opens its own descriptor and issues ranged reads.
+// Otherwise the parts are read in order from the shared descriptor,
+// and the caller must serialize the calls.
+struct HttpPartReader {
+    gfal2_context_t context;
+    const char* source;
+    int source_fd;
+    bool ranged;
+
+    HttpPartReader(gfal2_context_t context, const char* source, int source_fd, bool ranged) :
+        context(context), source(source), source_fd(source_fd), ranged(ranged)
+    {
+    }
+
+    int open(GError** err) {
+        if (!ranged) {
+            return source_fd;
+        }
+        return gfal2_open(context, source, O_RDONLY, err);
+    }
+
+    void close(int fd) {
+        if (ranged && fd >= 0) {
+            gfal2_close(context, fd, NULL);
+        }
+    }
+
+    ssize_t read(int fd, char* buffer, size_t count, off_t offset, GError** err) {
+        return gfal_http_read_full(context, fd, buffer, count, offset, ranged, err);
+    }
+};
+
+
+// Read ahead the source with concurrent ranged reads, and hand the data over
+// in order to the single PUT of the destination.
+// At most "parallelism" parts are kept in memory.
+class HttpRangedPrefetch {
+public:
+    HttpRangedPrefetch(HttpPartReader& reader, off_t size, const HttpStreamPartConfig& config) :
+        reader(reader), config(config), size(size), nparts(config.nparts(size)),
+        slots(std::max(config.parallelism, 1)), next_part(0), consumed(0), position(0),
+        stopping(false), error(NULL)
+    {
+    }
+
+    ~HttpRangedPrefetch() {
+        stop();
+        g_clear_error(&error);
+    }
+
+    void start() {
+        for (auto& slot : slots) {
+            slot.part = nparts;
+            slot.length = -1;
+        }
+        next_part = consumed = position = 0;
+        stopping = false;
+        g_clear_error(&error);
+
+        size_t nworkers = std::min(slots.size(), nparts);
+        for (size_t i = 0; i < nworkers; ++i) {
+            workers.emplace_back(&HttpRangedPrefetch::worker, this);
+        }
+    }
+
+    void stop() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        cond.notify_all();
+        for (auto& worker : workers) {
+            worker.join();
+        }
+        workers.clear();
+    }
+
+    // Copy the next bytes of the source, 0 at the end, -1 on error
+    ssize_t read(char* buffer, size_t count, GError** err) {
+        std::unique_lock<std::mutex> lock(mutex);
+        if (consumed >= nparts) {
+            return 0;
+        }
+
+        Slot& slot = slots[consumed % slots.size()];
+        cond.wait(lock, [&]() {
+            return error != NULL || (slot.part == consumed && slot.length >= 0);
+        });
+        if (error) {
+            *err = g_error_copy(error);
+            return -1;
+        }
+        lock.unlock();
+
+        // The slot is not reused until it has been consumed
+        size_t n = std::min(count, static_cast<size_t>(slot.length) - position);
+        memcpy(buffer, slot.data.data() + position, n);
+        position += n;
+
+        if (position >= static_cast<size_t>(slot.length)) {
+            lock.lock();
+            ++consumed;
+            position = 0;
+            lock.unlock();
+            cond.notify_all();
+        }
+        return n;
+    }
+
+private:
+    struct Slot {
+        std::vector<char> data;
+        size_t part;
+        ssize_t length;     // -1 while loading
+    };
+
+    HttpPartReader& reader;
+    const HttpStreamPartConfig& config;
+    off_t size;
+    size_t nparts;
+
+    std::mutex mutex;
+    std::condition_variable cond;
+    std::vector<std::thread> workers;
+    std::vector<Slot> slots;
+    size_t next_part;   // next part to be read
+    size_t consumed;    // parts already handed over
+    size_t position;    // position within the part being handed over
+    bool stopping;
+    GError* error;
+
+    void worker() {
+        GError* tmp_err = NULL;
+        int fd = reader.open(&tmp_err);
+
+        while (fd >= 0) {
+            std::unique_lock<std::mutex> lock(mutex);
+            // Part "p" reuses the slot of part "p - slots", which must have been consumed
+            cond.wait(lock, [&]() {
+                return stopping || error != NULL || next_part >= nparts ||
+                       next_part < consumed + slots.size();
+            });
+            if (stopping || error != NULL || next_part >= nparts) {
+                break;
+            }
+
+            size_t part = next_part++;
+            Slot& slot = slots[part % slots.size()];
+            slot.part = part;
+            slot.length = -1;
+            slot.data.resize(config.part_size);
+            lock.unlock();
+
+            ssize_t len = reader.read(fd, slot.data.data(), config.part_length(part, size),
+                                      config.part_offset(part), &tmp_err);
+
+            lock.lock();
+            if (len < 0) {
+                break;
+            }
+            slot.length = len;
+            lock.unlock();
+            cond.notify_all();
+        }
+
+        reader.close(fd);
+        if (tmp_err) {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (error == NULL) {
+                error = tmp_err;
+            } else {
+                g_error_free(tmp_err);
+            }
+        }
+        cond.notify_all();
+    }
+};
+
+
+// Upload the source as an S3 multipart upload, with "parallelism" parts
+// in flight. A failed part is retried on its own.
+class HttpMultipartUpload {
+public:
+    HttpMultipartUpload(gfal2_context_t context, GfalHttpPluginData* davix,
+                        const Davix::Uri& dst_uri, const Davix::RequestParams& req_params,
+                        HttpPartReader& reader, off_t size, const HttpStreamPartConfig& config) :
+        context(context), davix(davix), dst_uri(dst_uri), req_params(req_params),
+        reader(reader), config(config), size(size), nparts(config.nparts(size)),
+        etags(nparts), next_part(0), running(0), bytes_done(0), failed(false), error(NULL),
+        source_error(false)
+    {
+    }
+
+    ~HttpMultipartUpload() {
+        g_clear_error(&error);
+    }
+
+    int run(const char* src, const char* dst, gfalt_params_t params, GError** err)
+    {
+        Davix::DavFile dest(davix->context, req_params, dst_uri);
+        try {
+            upload_id = dest.initiateMultipart(&req_params);
+        } catch (Davix::DavixException& ex) {
+            gfal2_set_error(err, http_plugin_domain, davix2errno(ex.code()), __func__,
+                            "Could not initiate the multipart upload: %s (destination)", ex.what());
+            return -1;
+        }
+        gfal2_log(G_LOG_LEVEL_DEBUG, "Multipart upload %s of %zu parts of %zu bytes",
+                  upload_id.c_str(), nparts, config.part_size);
+
+        std::vector<std::thread> workers;
+        running = std::min(static_cast<size_t>(std::max(config.parallelism, 1)), nparts);
+        for (size_t i = 0; i < running; ++i) {
+            workers.emplace_back(&HttpMultipartUpload::worker, this);
+        }
+
+        // Progress is reported from this thread only
+        _gfalt_transfer_status perf;
+        memset(&perf, 0, sizeof(perf));
+        time_t start = time(NULL), last_update = start;
+        off_t last_bytes = 0;
+
+        std::unique_lock<std::mutex> lock(mutex);
+        while (running > 0) {
+            done_cond.wait_for(lock, std::chrono::seconds(1));
+
+            if (gfal2_is_canceled(context)) {
+                set_error(g_error_new(http_plugin_domain, ECANCELED, "Transfer canceled"));
+            }
+
+            time_t now = time(NULL);
+            if (now - last_update >= 5) {
+                off_t done = bytes_done;
+                perf.bytes_transfered = done;
+                perf.transfer_time = now - start;
+                perf.average_baudrate = done / perf.transfer_time;
+                perf.instant_baudrate = (done - last_bytes) / (now - last_update);
+                last_update = now;
+                last_bytes = done;
+
+                lock.unlock();
+                plugin_trigger_monitor(params, &perf, src, dst);
+                lock.lock();
+            }
+        }
+        lock.unlock();
+
+        for (auto& worker : workers) {
+            worker.join();
+        }
+
+        if (error == NULL) {
+            try {
+                dest.finalizeMultipart(&req_params, upload_id, etags);
+            } catch (Davix::DavixException& ex) {
+                set_error(g_error_new(http_plugin_domain, davix2errno(ex.code()),
+                                      "Could not complete the multipart upload: %s", ex.what()));
+            }
+        }
+
+        if (error != NULL) {
+            abort();
+            gfal2_set_error(err, http_plugin_domain, error->code, __func__, "%s (%s)",
+                            error->message, source_error ? "source" : "destination");
+            return -1;
+        }
+        return 0;
+    }
+
+private:
+    gfal2_context_t context;
+    GfalHttpPluginData* davix;
+    const Davix::Uri& dst_uri;
+    const Davix::RequestParams& req_params;
+    HttpPartReader& reader;
+    const HttpStreamPartConfig& config;
+    off_t size;
+    size_t nparts;
+
+    std::string upload_id;
+    std::vector<std::string> etags;
+
+    std::mutex read_mutex;      // serializes the sequential reads
+    std::mutex mutex;
+    std::mutex error_mutex;
+    std::condition_variable done_cond;
+    size_t next_part;
+    size_t running;
+    std::atomic<off_t> bytes_done;
+    std::atomic<bool> failed;
+    GError* error;
+    bool source_error;
+
+    // Keep the first error only
+    void set_error(GError* tmp_err, bool from_source = false) {
+        std::lock_guard<std::mutex> lock(error_mutex);
+        if (error == NULL) {
+            error = tmp_err;
+            source_error = from_source;
+            failed = true;
+        } else {
+            g_error_free(tmp_err);
+        }
+    }
+
+    bool upload_part(Davix::DavFile& dest, size_t part, const char* buffer, size_t len, GError** err)
+    {
+        int last_code = 0;
+        std::string last_error;
+
+        bool done = gfal_http_retry(context, config.retries, config.retry_delay, failed, [&](int attempt) {
+            try {
+                Davix::BufferContentProvider provider(buffer, len);
+                std::string etag = dest.uploadPart(&req_params, upload_id, part + 1, provider);
+                std::lock_guard<std::mutex> lock(mutex);
+                etags[part] = etag;
+                return true;
+            } catch (Davix::DavixException& ex) {
+                last_code = davix2errno(ex.code());
+                last_error = ex.what();
+                if (attempt < config.retries) {
+                    gfal2_log(G_LOG_LEVEL_WARNING, "Failed to upload part %zu (attempt %d/%d): %s",
+                              part + 1, attempt + 1, config.retries + 1, ex.what());
+                }
+                return false;
+            }
+        });
+
+        if (!done) {
+            if (gfal2_is_canceled(context)) {
+                gfal2_set_error(err, http_plugin_domain, ECANCELED, __func__, "Transfer canceled");
+            } else {
+                gfal2_set_error(err, http_plugin_domain, last_code, __func__,
+                                "Failed to upload part %zu: %s", part + 1, last_error.c_str());
+            }
+        }
+        return done;
+    }
+
+    void worker()
+    {
+        GError* tmp_err = NULL;
+        std::vector<char> buffer(config.part_size);
+        Davix::DavFile dest(davix->context, req_params, dst_uri);
+
+        int fd = reader.open(&tmp_err);
+        if (fd < 0) {
+            set_error(tmp_err, true);
+        }
+
+        while (fd >= 0 && !failed) {
+            size_t part;
+            ssize_t len = -1;
+            {
+                std::unique_lock<std::mutex> lock(read_mutex);
+                if (next_part >= nparts) {
+                    break;
+                }
+                part = next_part++;
+                if (!reader.ranged) {
+                    len = reader.read(fd, buffer.data(), config.part_length(part, size),
+                                      config.part_offset(part), &tmp_err);
+                }
+            }
+            if (reader.ranged) {
+                len = reader.read(fd, buffer.data(), config.part_length(part, size),
+                                  config.part_offset(part), &tmp_err);
+            }
+
+            if (len < 0) {
+                set_error(tmp_err, true);
+                break;
+            }
+            if (static_cast<size_t>(len) != config.part_length(part, size)) {
+                set_error(g_error_new(http_plugin_domain, EIO, "The source is shorter than expected"), true);
+                break;
+            }
+
+            if (!upload_part(dest, part, buffer.data(), len, &tmp_err)) {
+                set_error(tmp_err);
+                break;
+            }
+            bytes_done += len;
+        }
+
+        reader.close(fd);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            --running;
+        }
+        done_cond.notify_all();
+    }
+
+    // Discard the parts already uploaded
+    void abort()
+    {
+        Davix::DavixError* dav_err = NULL;
+        Davix::Uri uri(dst_uri);
+        uri.addQueryParam("uploadId", upload_id);
+
+        Davix::DeleteRequest request(davix->context, uri, &dav_err);
+        request.setParameters(req_params);
+        if (dav_err == NULL && request.executeRequest(&dav_err) == 0) {
+            gfal2_log(G_LOG_LEVEL_DEBUG, "Multipart upload %s aborted", upload_id.c_str());
+        } else {
+            gfal2_log(G_LOG_LEVEL_WARNING, "Could not abort the multipart upload %s: %s", upload_id.c_str(),
+                      dav_err ? dav_err->getErrMsg().c_str() : "unknown error");
+        }
+        Davix::DavixError::clearError(&dav_err);
+    }
+};
+
+
 struct HttpStreamProvider {
     const char *source, *destination;
 
     gfal2_context_t context;
     gfalt_params_t params;
     int source_fd;
+    off_t offset;
+    HttpRangedPrefetch* prefetch;
     time_t start, last_update;
     dav_ssize_t read_instant;
     _gfalt_transfer_status perf;
     GError* stream_err;
 
     HttpStreamProvider(const char *source, const char *destination,
-                       gfal2_context_t context, int source_fd, gfalt_params_t params) :
+                       gfal2_context_t context, int source_fd, off_t offset, gfalt_params_t params) :
         source(source), destination(destination),
-        context(context), params(params), source_fd(source_fd), start(time(NULL)),
+        context(context), params(params), source_fd(source_fd), offset(offset), prefetch(NULL), start(time(NULL)),
         last_update(start), read_instant(0), stream_err(NULL)
     {
         memset(&perf, 0, sizeof(perf));
+        perf.bytes_transfered = offset;
     }
 };
 
@@ -575,23 +1123,31 @@ static dav_ssize_t gfal_http_streamed_provider(void *userdata,
     time_t now = time(NULL);
 
     if (buflen == 0) {
-        data->perf.bytes_transfered = data->read_instant = 0;
+        data->perf.bytes_transfered = data->offset;
+        data->read_instant = 0;
         data->perf.average_baudrate = 0;
         data->perf.instant_baudrate = 0;
         data->start = data->last_update = now;
 
-        if (gfal2_lseek(data->context, data->source_fd, 0, SEEK_SET, &error) < 0)
+        if (data->prefetch) {
+            data->prefetch->stop();
+            data->prefetch->start();
+        }
+        else if (gfal2_lseek(data->context, data->source_fd, data->offset, SEEK_SET, &error) < 0)
             ret = -1;
     }
     else {
-        ret = gfal2_read(data->context, data->source_fd, buffer, buflen, &error);
+        if (data->prefetch)
+            ret = data->prefetch->read(static_cast<char*>(buffer), buflen, &error);
+        else
+            ret = gfal2_read(data->context, data->source_fd, buffer, buflen, &error);
         if (ret > 0)
             data->read_instant += ret;
 
         if (now - data->last_update >= 5) {
             data->perf.bytes_transfered += data->read_instant;
             data->perf.transfer_time = now - data->start;
-            data->perf.average_baudrate = data->perf.bytes_transfered / data->perf.transfer_time;
+            data->perf.average_baudrate = (data->perf.bytes_transfered - data->offset) / data->perf.transfer_time;
             data->perf.instant_baudrate = data->read_instant / (now - data->last_update);
 
             data->last_update = now;
@@ -613,7 +1169,7 @@ static int gfal_http_streamed_copy(gfal2_context_t context,
         GfalHttpPluginData* davix,
         const char* src, const char* dst,
         gfalt_checksum_mode_t checksum_mode, const char *checksum_type, const char *user_checksum,
-        gfalt_params_t params,
+        off_t offset, gfalt_params_t params,
         GError** err)
 {
     gfal2_log(G_LOG_LEVEL_MESSAGE, "Performing a HTTP streamed copy");
@@ -625,6 +1181,16 @@ static int gfal_http_streamed_copy(gfal2_context_t context,
         return -1;
     }
 
+    if (offset > 0) {
+        plugin_trigger_event(params, http_plugin_domain,
+                             GFAL_EVENT_NONE, GFAL_EVENT_RESUME,
+                             "%lld", (long long)offset);
+        if (offset >= src_stat.st_size) {
+            gfal2_log(G_LOG_LEVEL_MESSAGE, "The destination is already complete");
+            return 0;
+        }
+    }
+
     // Must reset the HTTP OPERATION_TIMEOUT to the transfer timeout
     bool reset_operation_timeout = is_http_scheme(src);
     int transfer_timeout = static_cast<int>(gfalt_get_timeout(params, NULL));
@@ -647,6 +1213,12 @@ static int gfal_http_streamed_copy(gfal2_context_t context,
         return -1;
     }
 
+    if (offset > 0 && gfal2_lseek(context, source_fd, offset, SEEK_SET, &nested_err) < 0) {
+        gfal2_close(context, source_fd, NULL);
+        gfal2_propagate_prefixed_error(err, nested_err, __func__);
+        return -1;
+    }
+
     Davix::Uri dst_uri(dst);
     Davix::RequestParams req_params;
     davix->get_params(&req_params, dst_uri, GfalHttpPluginData::OP::WRITE);
@@ -655,8 +1227,20 @@ static int gfal_http_streamed_copy(gfal2_context_t context,
     struct timespec opTimeout{transfer_timeout};
     req_params.setOperationTimeout(&opTimeout);
 
-    // Set MD5 header on the PUT
-    if (checksum_mode & GFALT_CHECKSUM_TARGET && strcasecmp(checksum_type, "md5") == 0 && user_checksum[0]) {
+    // Big files are split in parts transferred concurrently: S3 destinations
+    // get a multipart upload, HTTP sources are read with ranged GETs
+    HttpStreamPartConfig part_config(context, src_stat.st_size);
+    bool parallel = part_config.parallel(src_stat.st_size, offset);
+    bool multipart = parallel && (dst_uri.getProtocol() == "s3" || dst_uri.getProtocol() == "s3s");
+    HttpPartReader reader(context, src, source_fd, parallel && is_http_scheme(src));
+
+    // Send only the missing range
+    if (offset > 0) {
+        req_params.addHeader("Content-Range", gfal_http_content_range(offset, src_stat.st_size));
+    }
+
+    // Set MD5 header on the PUT, only valid for a complete body
+    if (offset == 0 && !multipart && checksum_mode & GFALT_CHECKSUM_TARGET && strcasecmp(checksum_type, "md5") == 0 && user_checksum[0]) {
     	req_params.addHeader("Content-MD5", user_checksum);
     }
 
@@ -675,13 +1259,30 @@ static int gfal_http_streamed_copy(gfal2_context_t context,
     else if (dst_uri.getProtocol() == "cs3" || dst_uri.getProtocol() == "cs3s")
         req_params.setProtocol(Davix::RequestProtocol::CS3);
 
+    if (multipart) {
+        gfal2_log(G_LOG_LEVEL_MESSAGE, "Using a multipart upload with %d parallel parts", part_config.parallelism);
+        HttpMultipartUpload upload(context, davix, dst_uri, req_params, reader, src_stat.st_size, part_config);
+        upload.run(src, dst, params, err);
+
+        gfal2_close(context, source_fd, NULL);
+        return *err == NULL ? 0 : -1;
+    }
+
+    std::unique_ptr<HttpRangedPrefetch> prefetch;
+    if (reader.ranged) {
+        gfal2_log(G_LOG_LEVEL_MESSAGE, "Reading the source with %d parallel ranges", part_config.parallelism);
+        prefetch.reset(new HttpRangedPrefetch(reader, src_stat.st_size, part_config));
+        prefetch->start();
+    }
+
     Davix::DavFile dest(davix->context,req_params, dst_uri );
 
-    HttpStreamProvider provider(src, dst, context, source_fd, params);
+    HttpStreamProvider provider(src, dst, context, source_fd, offset, params);
+    provider.prefetch = prefetch.get();
 
     try {
     	dest.put(&req_params, std::bind(&gfal_http_streamed_provider,&provider,
-        		  std::placeholders::_1, std::placeholders::_2), src_stat.st_size);
+        		  std::placeholders::_1, std::placeholders::_2), src_stat.st_size - offset);
 
     } catch (Davix::DavixException& ex) {
         GError* tmp_err = NULL;
@@ -812,10 +1413,23 @@ int gfal_http_copy(plugin_handle plugin_data, gfal2_context_t context,
                 GFAL_EVENT_CHECKSUM_EXIT, "");
     }
 
+    // Resuming needs a streamed copy, and a destination accepting partial PUTs.
+    // Only then is a partial destination kept after a failure
+    bool resumable = gfal_http_copy_resumable(context, params, stripped_src, stripped_dst,
+                                              [davix, dst]() { return is_http_partial_put_supported(davix, dst); });
+    off_t resume_offset = 0;
+
     // When this flag is not set, the plugin should handle overwriting,
     // parent directory creation,...
     if (!gfalt_get_strict_copy_mode(params, NULL)) {
-        if (gfal_http_copy_overwrite(plugin_data, params, dst, &nested_error) != 0 ||
+        if (resumable) {
+            resume_offset = gfalt_get_resume_offset(context, params, src, dst, &nested_error);
+            if (resume_offset < 0) {
+                gfal2_propagate_prefixed_error(err, nested_error, __func__);
+                return -1;
+            }
+        }
+        if ((resume_offset == 0 && gfal_http_copy_overwrite(plugin_data, params, dst, &nested_error) != 0) ||
             gfal_http_copy_make_parent(plugin_data, params, context, dst, &nested_error) != 0) {
             gfal2_propagate_prefixed_error(err, nested_error, __func__);
             return -1;
@@ -833,7 +1447,7 @@ int gfal_http_copy(plugin_handle plugin_data, gfal2_context_t context,
     bool only_streaming = false;
     // If source is not even http, go straight to streamed
     // or if third party copy is disabled, go straight to streamed
-    if (!is_http_scheme(src) || !is_http_3rdcopy_enabled(context, src, dst)) {
+    if (!is_http_scheme(src) || !is_http_3rdcopy_enabled(context, src, dst) || resumable) {
         copy_mode = HTTP_COPY_STREAM;
         only_streaming = true;
     }
@@ -866,7 +1480,7 @@ int gfal_http_copy(plugin_handle plugin_data, gfal2_context_t context,
             if (streaming_enabled) {
                 ret = gfal_http_streamed_copy(context, davix, src, dst,
                                               checksum_mode, checksum_type, user_checksum,
-                                              params, &nested_error);
+                                              resume_offset, params, &nested_error);
             } else if (only_streaming) {
                 gfal2_set_error(&nested_error, http_plugin_domain, EINVAL, __func__,
                                 "STREAMED DISABLED Only streamed copy possible but streaming is disabled");
@@ -884,8 +1498,10 @@ int gfal_http_copy(plugin_handle plugin_data, gfal2_context_t context,
             break;
         } else {
             gfal2_log(G_LOG_LEVEL_WARNING, "Copy failed with mode %s: %s", CopyModeStr[copy_mode], nested_error->message);
-            // Delete any potential destination file
-            gfal_http_copy_cleanup(plugin_data, dst, &nested_error);
+            // Delete any potential destination file, unless a later attempt can resume from it
+            if (!resumable) {
+                gfal_http_copy_cleanup(plugin_data, dst, &nested_error);
+            }
         }
 
         attempted_mode.emplace_back(CopyModeStr[copy_mode]);
@@ -0,0 +1,92 @@
+/*
+ * Copyright (c) CERN 2013-2015
+ *
+ * Copyright (c) Members of the EMI Collaboration. 2010-2013
+ *  See  http://www.eu-emi.eu/partners for details on the copyright
+ *  holders.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _GFAL_HTTP_COPY_H
+#define _GFAL_HTTP_COPY_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <string>
+
+#include "gfal_http_plugin.h"
+
+// Settings of the parallel streamed copies
+struct HttpStreamPartConfig {
+    int parallelism;
+    off_t threshold;
+    size_t part_size;
+    int retries;
+    std::chrono::milliseconds retry_delay;    // first wait between attempts, doubled on each retry
+
+    HttpStreamPartConfig(gfal2_context_t context, off_t size)
+    {
+        parallelism = gfal2_get_opt_integer_with_default(context, "HTTP PLUGIN", "STREAM_PARALLEL_PARTS", 4);
+        threshold = gfal2_get_opt_integer_with_default(context, "HTTP PLUGIN", "STREAM_PARALLEL_THRESHOLD", 67108864);
+        part_size = gfal2_get_opt_integer_with_default(context, "HTTP PLUGIN", "STREAM_PART_SIZE", 16777216);
+        retries = gfal2_get_opt_integer_with_default(context, "HTTP PLUGIN", "STREAM_PART_RETRIES", 3);
+        retry_delay = std::chrono::seconds(1);
+
+        // S3 constraints: parts of at least 5 MiB, and at most 10000 of them
+        const size_t min_part_size = 5 * 1024 * 1024;
+        part_size = std::max(part_size, min_part_size);
+        part_size = std::max(part_size, static_cast<size_t>(size / 10000 + 1));
+    }
+
+    // Whether a copy of "size" bytes, starting at "offset", is split in parts
+    bool parallel(off_t size, off_t offset) const {
+        return offset == 0 && parallelism > 1 && size >= threshold;
+    }
+
+    size_t nparts(off_t size) const {
+        return (size + part_size - 1) / part_size;
+    }
+
+    off_t part_offset(size_t part) const {
+        return static_cast<off_t>(part) * part_size;
+    }
+
+    size_t part_length(size_t part, off_t size) const {
+        return std::min(static_cast<off_t>(part_size), size - part_offset(part));
+    }
+};
+
+
+// Call "call" until it returns true, retrying at most "retries" times after the first attempt.
+// The waits between attempts start at "delay" and double up to 32 times "delay". They are done
+// in short slices, and end the retries as soon as the transfer is canceled or "stop" is set.
+// "call" gets the number of the attempt, starting at 0. Returns true if an attempt succeeded.
+bool gfal_http_retry(gfal2_context_t context, int retries, std::chrono::milliseconds delay,
+                     const std::atomic<bool>& stop, const std::function<bool(int)>& call);
+
+// Content-Range header of a PUT sending the bytes from "offset" to the end of a "size" bytes file
+std::string gfal_http_content_range(off_t offset, off_t size);
+
+// Whether an Accept-Ranges header value lists the "bytes" unit
+bool gfal_http_accepts_byte_ranges(const std::string& accept_ranges);
+
+// Whether a failed copy from "src" to "dst" can be resumed later, keeping the partial destination.
+// "partial_put_supported" checks the destination, it is only called when everything else allows it
+bool gfal_http_copy_resumable(gfal2_context_t context, gfalt_params_t params,
+                              const char* src, const char* dst,
+                              const std::function<bool()>& partial_put_supported);
+
+#endif //_GFAL_HTTP_COPY_H
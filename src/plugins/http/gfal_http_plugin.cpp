@@ -392,7 +392,7 @@ std::string gfal_http_discover_tape_endpoint(GfalHttpPluginData* davix, const ch
 
     if (uri.getStatus() != StatusCode::OK) {
         gfal2_set_error(err, http_plugin_domain, EINVAL, __func__, "Invalid URL: %s", url);
-        return NULL;
+        return "";
     }
 
     // Construct remote storage endpoint
@@ -14,12 +14,24 @@
  * limitations under the License.
  */
 
+#include <algorithm>
+#include <atomic>
 #include <cstring>
+#include <ctime>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <set>
 #include <sstream>
+#include <thread>
+#include <unordered_map>
+#include <vector>
 #include <json.h>
 
 #include "uri/gfal2_parsing.h"
 #include "gfal_http_plugin.h"
+#include "gfal_http_plugin_tape.h"
 
 using namespace Davix;
 
@@ -244,6 +256,407 @@ namespace tape_rest_api {
 
         return locality;
     }
+
+    // Remote storage endpoint (protocol://host[:port]) a URL belongs to
+    std::string storage_endpoint(const char* url)
+    {
+        Davix::Uri uri(url);
+        std::stringstream endpoint;
+        endpoint << uri.getProtocol() << "://" << uri.getHost();
+
+        if (uri.getPort()) {
+            endpoint << ":" << uri.getPort();
+        }
+
+        return endpoint.str();
+    }
+
+    // Path of the URL, as used to match items in Tape REST API responses
+    std::string stage_path(const char* url)
+    {
+        return collapse_slashes(Davix::Uri(url).getPath());
+    }
+
+    // Group the file indexes by storage endpoint, keeping the order in which endpoints first appear
+    std::vector<std::pair<std::string, std::vector<int>>> group_by_endpoint(int nbfiles, const char* const* urls)
+    {
+        std::vector<std::pair<std::string, std::vector<int>>> groups;
+        std::map<std::string, size_t> positions;
+
+        for (int i = 0; i < nbfiles; ++i) {
+            std::string endpoint = storage_endpoint(urls[i]);
+            auto it = positions.find(endpoint);
+
+            if (it == positions.end()) {
+                positions[endpoint] = groups.size();
+                groups.emplace_back(endpoint, std::vector<int>{i});
+            } else {
+                groups[it->second].second.push_back(i);
+            }
+        }
+
+        return groups;
+    }
+
+    // Split a (possibly composite) staging token into the individual request IDs
+    std::vector<std::string> split_request_ids(const char* token)
+    {
+        std::vector<std::string> ids;
+        std::stringstream ss(token);
+        std::string id;
+
+        while (std::getline(ss, id, REQUEST_ID_SEPARATOR)) {
+            if (!id.empty()) {
+                ids.push_back(id);
+            }
+        }
+
+        return ids;
+    }
+
+    // Run "ntasks" tasks using at most "parallelism" threads
+    void run_parallel(size_t ntasks, int parallelism, const std::function<void(size_t)>& task)
+    {
+        size_t nthreads = std::min(ntasks, static_cast<size_t>(std::max(parallelism, 1)));
+
+        if (nthreads <= 1) {
+            for (size_t i = 0; i < ntasks; ++i) {
+                task(i);
+            }
+            return;
+        }
+
+        std::atomic<size_t> next(0);
+        std::vector<std::thread> workers;
+
+        for (size_t t = 0; t < nthreads; ++t) {
+            workers.emplace_back([&]() {
+                size_t i;
+                while ((i = next++) < ntasks) {
+                    task(i);
+                }
+            });
+        }
+
+        for (auto& worker : workers) {
+            worker.join();
+        }
+    }
+
+    // Interpret one item of the "files" list of a "GET /stage/<id>" response
+    stage_file_state parse_stage_file(struct json_object* file, const std::string& path)
+    {
+        std::stringstream msg;
+
+        // Check if "error" attribute exists
+        struct json_object* file_error_text = 0;
+        if (json_object_object_get_ex(file, "error", &file_error_text)) {
+            msg << "[Tape REST API] " << json_object_get_string(file_error_text);
+            return stage_file_state{ENOMSG, msg.str()};
+        }
+
+        // Retrieve "onDisk" attribute
+        struct json_object* file_on_disk = 0;
+        if (json_object_object_get_ex(file, "onDisk", &file_on_disk)) {
+            std::string disk = json_object_get_string(file_on_disk);
+            std::transform(disk.begin(), disk.end(), disk.begin(), tolower);
+
+            if (disk == "true") {
+                return stage_file_state{0, ""};
+            }
+
+            msg << "[Tape REST API] File " << path << " is not yet on disk";
+            return stage_file_state{EAGAIN, msg.str()};
+        }
+
+        // Retrieve "state" attribute
+        struct json_object* file_state = 0;
+        if (!json_object_object_get_ex(file, "state", &file_state)) {
+            return stage_file_state{ENOMSG, "[Tape REST API] State and onDisk attributes missing"};
+        }
+
+        std::string state = json_object_get_string(file_state);
+
+        if (state == "COMPLETED") {
+            return stage_file_state{0, ""};
+        } else if (state == "STARTED" || state == "SUBMITTED") {
+            msg << "[Tape REST API] File " << path << " is not yet on disk";
+            return stage_file_state{EAGAIN, msg.str()};
+        } else if (state == "CANCELED") {
+            msg << "[Tape REST API] Staging operation cancelled. File=" << path;
+            return stage_file_state{ECANCELED, msg.str()};
+        } else if (state == "FAILED") {
+            msg << "[Tape REST API] Staging operation failed for file=" << path;
+            return stage_file_state{ENOENT, msg.str()};
+        }
+
+        msg << "[Tape REST API] Unrecognized staging status. File=" << path << " status=" << state;
+        return stage_file_state{ENOENT, msg.str()};
+    }
+
+    StageStateTable stage_table;
+
+    // Map each request ID of the token to the endpoint(s) and files it concerns.
+    // Requests not seen by this process are attributed to every endpoint of the file list.
+    std::vector<tape_call> calls_for_token(const std::vector<std::string>& ids, int nbfiles,
+                                           const char* const* urls)
+    {
+        std::vector<tape_call> calls;
+        auto groups = group_by_endpoint(nbfiles, urls);
+
+        for (const auto& id : ids) {
+            std::string endpoint;
+            std::set<std::string> paths;
+
+            if (stage_table.lookup(id, endpoint, paths)) {
+                for (const auto& group : groups) {
+                    if (group.first != endpoint) {
+                        continue;
+                    }
+
+                    tape_call call;
+                    call.id = id;
+                    call.endpoint = endpoint;
+
+                    for (int i : group.second) {
+                        if (paths.empty() || paths.count(stage_path(urls[i]))) {
+                            call.files.push_back(i);
+                        }
+                    }
+
+                    if (!call.files.empty()) {
+                        calls.push_back(call);
+                    }
+                }
+            } else {
+                for (const auto& group : groups) {
+                    tape_call call;
+                    call.id = id;
+                    call.endpoint = group.first;
+                    call.files = group.second;
+                    calls.push_back(call);
+                }
+            }
+        }
+
+        return calls;
+    }
+
+    // Resolve the Tape REST API URI and request parameters of each call.
+    // Done sequentially as it may populate the plugin endpoint and token caches.
+    void prepare_calls(GfalHttpPluginData* davix, std::vector<tape_call>& calls, const char* const* urls,
+                       const std::function<std::string(const tape_call&)>& method)
+    {
+        for (auto& call : calls) {
+            GError* tmp_err = NULL;
+            call.tape_uri = gfal_http_discover_tape_endpoint(davix, urls[call.files.front()],
+                                                             method(call).c_str(), &tmp_err);
+
+            if (tmp_err != NULL) {
+                call.err_code = tmp_err->code;
+                call.err_msg = tmp_err->message;
+                call.tape_uri.clear();
+                g_error_free(tmp_err);
+                continue;
+            }
+
+            Davix::Uri uri(call.tape_uri);
+            davix->get_params(&call.params, uri, GfalHttpPluginData::OP::TAPE);
+        }
+    }
+
+    // Execute a prepared call. Safe to run concurrently on different calls.
+    void execute_call(GfalHttpPluginData* davix, tape_call& call, bool post, int expected_code,
+                      const char* description)
+    {
+        if (call.tape_uri.empty()) {
+            return;
+        }
+
+        Davix::DavixError* reqerr = NULL;
+        Davix::Uri uri(call.tape_uri);
+        std::unique_ptr<Davix::HttpRequest> request;
+
+        if (post) {
+            request.reset(new PostRequest(davix->context, uri, &reqerr));
+            call.params.addHeader("Content-Type", "application/json");
+            request->setRequestBody(call.body);
+        } else {
+            request.reset(new GetRequest(davix->context, uri, &reqerr));
+        }
+        request->setParameters(call.params);
+
+        std::stringstream msg;
+
+        if (request->executeRequest(&reqerr)) {
+            msg << "[Tape REST API] " << description << " call failed: " << reqerr->getErrMsg();
+            call.err_code = davix2errno(reqerr->getStatus());
+            call.err_msg = msg.str();
+            Davix::DavixError::clearError(&reqerr);
+            return;
+        }
+
+        const char* answer = request->getAnswerContent();
+
+        if (request->getRequestCode() != expected_code) {
+            msg << "[Tape REST API] " << description << " call failed: HTTP "
+                << request->getRequestCode() << ": " << (answer ? answer : "");
+            call.err_code = EINVAL;
+            call.err_msg = msg.str();
+            Davix::DavixError::clearError(&reqerr);
+            return;
+        }
+
+        call.content = answer ? answer : "";
+        call.success = true;
+    }
+
+    // Parse a "GET /stage/<id>" response into a path -> state map
+    void parse_poll_response(tape_call& call)
+    {
+        if (call.content.empty()) {
+            call.success = false;
+            call.err_code = ENOMSG;
+            call.err_msg = "[Tape REST API] Response with no data";
+            return;
+        }
+
+        struct json_object* json_response = json_tokener_parse(call.content.c_str());
+
+        if (!json_response) {
+            call.success = false;
+            call.err_code = ENOMSG;
+            call.err_msg = "[Tape REST API] Malformed served response";
+            return;
+        }
+
+        // Check if "id" attribute matches
+        struct json_object* id = 0;
+        bool foundId = json_object_object_get_ex(json_response, "id", &id);
+        std::string reqid = foundId ? json_object_get_string(id) : "";
+        std::stringstream msg;
+
+        if (reqid.empty()) {
+            msg << "[Tape REST API] Request ID missing from polling response (expected id=" << call.id << ")";
+        } else if (reqid != call.id) {
+            msg << "[Tape REST API] Request ID mismatch. Expected id=" << call.id << " but received id=" << reqid;
+        }
+
+        // Check if "files" attribute exists
+        struct json_object* files = 0;
+        if (msg.tellp() == 0 && !json_object_object_get_ex(json_response, "files", &files)) {
+            msg << "[Tape REST API] Files attribute missing from server poll response";
+        }
+
+        if (msg.tellp() != 0) {
+            call.success = false;
+            call.err_code = ENOMSG;
+            call.err_msg = msg.str();
+            json_object_put(json_response);
+            return;
+        }
+
+        // Index the whole response once, instead of searching it for every file
+        const int len = json_object_array_length(files);
+        call.states.reserve(len);
+
+        for (int i = 0; i < len; ++i) {
+            auto item = json_object_array_get_idx(files, i);
+            struct json_object* item_path = 0;
+
+            if (item == NULL || !json_object_object_get_ex(item, "path", &item_path)) {
+                continue;
+            }
+
+            std::string path = collapse_slashes(json_object_get_string(item_path));
+
+            if (!path.empty()) {
+                call.states[path] = parse_stage_file(item, path);
+            }
+        }
+
+        json_object_put(json_response);
+        call.content.clear();
+    }
+
+    // Hand over the outcome of the calls to the per-file error slots.
+    // A file is considered successful if at least one of the calls concerning it succeeded.
+    int dispatch_call_errors(const std::vector<tape_call>& calls, int nbfiles, const char* const* urls,
+                             GError** errors, const char* func)
+    {
+        std::vector<bool> done(nbfiles, false);
+        std::vector<const tape_call*> failed(nbfiles, NULL);
+
+        for (const auto& call : calls) {
+            for (int i : call.files) {
+                if (call.success) {
+                    done[i] = true;
+                } else {
+                    failed[i] = &call;
+                }
+            }
+        }
+
+        int error_count = 0;
+
+        for (int i = 0; i < nbfiles; ++i) {
+            if (done[i]) {
+                continue;
+            }
+
+            error_count++;
+
+            if (failed[i] != NULL) {
+                gfal2_set_error(&errors[i], http_plugin_domain, failed[i]->err_code, func,
+                                "%s", failed[i]->err_msg.c_str());
+            } else {
+                gfal2_set_error(&errors[i], http_plugin_domain, ENOMSG, func,
+                                "[Tape REST API] No request found for file %s", stage_path(urls[i]).c_str());
+            }
+        }
+
+        return error_count;
+    }
+
+    bool poll_file_state(const std::vector<tape_call>& calls, int file, const std::string& path,
+                         stage_file_state& state)
+    {
+        const tape_call* failed = NULL;
+        const tape_call* scheduled = NULL;
+
+        for (const auto& call : calls) {
+            if (std::find(call.files.begin(), call.files.end(), file) == call.files.end()) {
+                continue;
+            }
+            if (!call.success) {
+                failed = &call;
+            } else if (stage_table.get_file(call.id, path, state)) {
+                return true;
+            } else if (!scheduled) {
+                scheduled = &call;
+            }
+        }
+
+        // Not in the table: the poll was not due yet, the entry expired, or the poll this one
+        // was coalesced with failed. The scheduler has the last status, if any, else it is still in progress
+        if (scheduled) {
+            GError* status = NULL;
+            if (gfal2_poll_status(scheduled->endpoint.c_str(), scheduled->id.c_str(), path.c_str(), &status) < 0) {
+                state = stage_file_state{status->code, status->message};
+                g_error_free(status);
+            } else {
+                state = stage_file_state{0, ""};
+            }
+            return true;
+        }
+
+        if (failed) {
+            state = stage_file_state{failed->err_code, failed->err_msg};
+        } else {
+            state = stage_file_state{ENOMSG, "[Tape REST API] Missing response item for path=" + path};
+        }
+        return false;
+    }
 }
 
 ssize_t gfal_http_getxattr_internal(plugin_handle plugin_data, const char* url, const char *key,
@@ -353,80 +766,138 @@ int gfal_http_bring_online_list_v2(plugin_handle plugin_data, int nbfiles, const
         return -1;
     }
 
-    // Find out Tape Rest API endpoint
     GfalHttpPluginData* davix = gfal_http_get_plugin_context(plugin_data);
-    std::string tapeEndpoint = gfal_http_discover_tape_endpoint(davix, urls[0], "/stage/", &tmp_err);
+    const int max_files = gfal2_get_opt_integer_with_default(davix->handle, "HTTP PLUGIN", "TAPE_STAGE_MAX_FILES", 0);
+    const int parallelism = gfal2_get_opt_integer_with_default(davix->handle, "HTTP PLUGIN", "TAPE_PARALLEL_REQUESTS", 4);
 
-    if (tmp_err != NULL) {
-        tape_rest_api::copyErrors(tmp_err, nbfiles, errors);
-        return -1;
-    }
+    // One "POST /stage/" request per storage endpoint, split in chunks of at most "max_files"
+    std::vector<tape_rest_api::tape_call> calls;
 
-    // Construct and send "POST /stage/" request
-    Davix::DavixError* reqerr = NULL;
-    Davix::Uri uri(tapeEndpoint);
-    Davix::RequestParams params;
+    for (const auto& group : tape_rest_api::group_by_endpoint(nbfiles, urls)) {
+        const std::vector<int>& files = group.second;
+        const size_t chunk = (max_files > 0) ? static_cast<size_t>(max_files) : files.size();
 
-    PostRequest request(davix->context, uri, &reqerr);
-    davix->get_params(&params, uri, GfalHttpPluginData::OP::TAPE);
-    params.addHeader("Content-Type", "application/json");
-    request.setParameters(params);
+        for (size_t start = 0; start < files.size(); start += chunk) {
+            tape_rest_api::tape_call call;
+            call.endpoint = group.first;
+            call.files.assign(files.begin() + start, files.begin() + std::min(start + chunk, files.size()));
 
-    request.setRequestBody(tape_rest_api::stage_request_body(pintime, nbfiles, urls, metadata));
+            std::vector<const char*> chunk_urls, chunk_metadata;
+            for (int i : call.files) {
+                chunk_urls.push_back(urls[i]);
+                chunk_metadata.push_back(metadata[i]);
+            }
 
-    if (request.executeRequest(&reqerr)) {
-        gfal2_set_error(&tmp_err, http_plugin_domain, davix2errno(reqerr->getStatus()), __func__,
-                        "[Tape REST API] Stage call failed: %s", reqerr->getErrMsg().c_str());
-        tape_rest_api::copyErrors(tmp_err, nbfiles, errors);
-        Davix::DavixError::clearError(&reqerr);
-        return -1;
+            call.body = tape_rest_api::stage_request_body(pintime, chunk_urls.size(), chunk_urls.data(),
+                                                          chunk_metadata.data());
+            calls.push_back(call);
+        }
     }
 
-    if (request.getRequestCode() != 201) {
-        gfal2_set_error(&tmp_err, http_plugin_domain, EINVAL, __func__,
-                        "[Tape REST API] Stage call failed: %s: %s",
-                        reqerr->getErrMsg().c_str(), request.getAnswerContent());
-        tape_rest_api::copyErrors(tmp_err, nbfiles, errors);
-        Davix::DavixError::clearError(&reqerr);
-        return -1;
+    if (calls.size() > 1) {
+        gfal2_log(G_LOG_LEVEL_DEBUG, "[Tape REST API] Staging %d files using %zu requests",
+                  nbfiles, calls.size());
     }
 
-    std::string content = std::string(request.getAnswerContent());
+    tape_rest_api::prepare_calls(davix, calls, urls,
+                                 [](const tape_rest_api::tape_call&) { return std::string("/stage/"); });
+    tape_rest_api::run_parallel(calls.size(), parallelism, [&](size_t i) {
+        tape_rest_api::tape_call& call = calls[i];
+        GError* budget_err = NULL;
+        gfal2_endpoint_slot_t budget = NULL;
+
+        // Stage submissions count against the same per-endpoint budget as the polls
+        if (gfal2_poll_budget_acquire(davix->handle, call.endpoint.c_str(), &budget, &budget_err) < 0) {
+            call.err_code = budget_err->code;
+            call.err_msg = budget_err->message;
+            g_error_free(budget_err);
+            return;
+        }
+        tape_rest_api::execute_call(davix, call, true, 201, "Stage");
+        gfal2_poll_budget_release(budget);
 
-    if (content.empty()) {
-        gfal2_set_error(&tmp_err, http_plugin_domain, ENOMSG, __func__,
-                        "[Tape REST API] Response with no data");
-        tape_rest_api::copyErrors(tmp_err, nbfiles, errors);
-        return -1;
+        if (!call.success) {
+            return;
+        }
+
+        if (call.content.empty()) {
+            call.success = false;
+            call.err_code = ENOMSG;
+            call.err_msg = "[Tape REST API] Response with no data";
+            return;
+        }
+
+        struct json_object* json_response = json_tokener_parse(call.content.c_str());
+
+        if (!json_response) {
+            call.success = false;
+            call.err_code = ENOMSG;
+            call.err_msg = "[Tape REST API] Malformed served response";
+            return;
+        }
+
+        // Check if "requestId" attribute exists
+        struct json_object* id = 0;
+        if (json_object_object_get_ex(json_response, "requestId", &id)) {
+            call.id = json_object_get_string(id);
+        } else {
+            call.success = false;
+            call.err_code = ENOMSG;
+            call.err_msg = "[Tape REST API] requestID attribute missing";
+        }
+
+        // Free the top JSON object
+        json_object_put(json_response);
+    });
+
+    // Register the accepted requests and assemble the token
+    std::stringstream reqids;
+
+    for (const auto& call : calls) {
+        if (!call.success) {
+            continue;
+        }
+
+        std::vector<std::string> paths;
+        for (int i : call.files) {
+            paths.push_back(tape_rest_api::stage_path(urls[i]));
+        }
+        tape_rest_api::stage_table.register_request(call.id, call.endpoint, paths, time(NULL));
+
+        std::vector<const char*> keys;
+        for (const auto& path : paths) {
+            keys.push_back(path.c_str());
+        }
+        gfal2_poll_register(call.endpoint.c_str(), call.id.c_str(), keys.size(), keys.data());
+
+        if (reqids.tellp() != 0) {
+            reqids << tape_rest_api::REQUEST_ID_SEPARATOR;
+        }
+        reqids << call.id;
     }
 
-    struct json_object* json_response = json_tokener_parse(content.c_str());
+    int error_count = tape_rest_api::dispatch_call_errors(calls, nbfiles, urls, errors, __func__);
 
-    if (!json_response) {
-        gfal2_set_error(&tmp_err, http_plugin_domain, ENOMSG, __func__,
-                        "[Tape REST API] Malformed served response");
-        tape_rest_api::copyErrors(tmp_err, nbfiles, errors);
+    if (error_count == nbfiles) {
         return -1;
     }
 
-    // Check if "requestId" attribute exists
-    struct json_object* id = 0;
-    bool foundId = json_object_object_get_ex(json_response, "requestId", &id);
-    if (!foundId) {
-        gfal2_set_error(&tmp_err, http_plugin_domain, ENOMSG, __func__,
-                        "[Tape REST API] requestID attribute missing");
+    const std::string reqid = reqids.str();
+
+    if (reqid.size() >= tsize) {
+        gfal2_set_error(&tmp_err, http_plugin_domain, ENOBUFS, __func__,
+                        "[Tape REST API] Request IDs do not fit in the token buffer (%zu bytes needed). "
+                        "Increase TAPE_STAGE_MAX_FILES or reduce the number of endpoints per call",
+                        reqid.size() + 1);
+        for (int i = 0; i < nbfiles; ++i) {
+            g_clear_error(&errors[i]);
+        }
         tape_rest_api::copyErrors(tmp_err, nbfiles, errors);
         return -1;
     }
 
-    std::string reqid = json_object_get_string(id);
-
-    // Copy request id to token buffer
+    // Copy request id(s) to token buffer
     g_strlcpy(token, reqid.c_str(), tsize);
-
-    // Free the top JSON object
-    json_object_put(json_response);
-
     return 0;
 }
 
@@ -445,47 +916,27 @@ int gfal_http_abort_files(plugin_handle plugin_data, int nbfiles, const char* co
         return -1;
     }
 
-    std::stringstream method;
-    method << "/stage/" << token << "/cancel";
-
-    // Find out Tape Rest API endpoint
+    // Send one "POST /stage/<id>/cancel" request per request ID and endpoint
     GfalHttpPluginData* davix = gfal_http_get_plugin_context(plugin_data);
-    std::string tapeEndpoint = gfal_http_discover_tape_endpoint(davix, urls[0], method.str().c_str(), &tmp_err);
+    const int parallelism = gfal2_get_opt_integer_with_default(davix->handle, "HTTP PLUGIN", "TAPE_PARALLEL_REQUESTS", 4);
+    auto calls = tape_rest_api::calls_for_token(tape_rest_api::split_request_ids(token), nbfiles, urls);
 
-    if (tmp_err != NULL) {
-        tape_rest_api::copyErrors(tmp_err, nbfiles, errors);
-        return -1;
-    }
-
-    // Construct and send "POST /stage/<token>/cancel" request
-    Davix::DavixError* reqerr = NULL;
-    Davix::Uri uri(tapeEndpoint);
-    Davix::RequestParams params;
-
-    PostRequest request(davix->context, uri, &reqerr);
-    davix->get_params(&params, uri, GfalHttpPluginData::OP::TAPE);
-    params.addHeader("Content-Type", "application/json");
-    request.setParameters(params);
-    request.setRequestBody(tape_rest_api::list_files_body(nbfiles, urls));
-
-    if (request.executeRequest(&reqerr)) {
-        gfal2_set_error(&tmp_err, http_plugin_domain, davix2errno(reqerr->getStatus()), __func__,
-                        "[Tape REST API] Cancel call failed: %s", reqerr->getErrMsg().c_str());
-        tape_rest_api::copyErrors(tmp_err, nbfiles, errors);
-        Davix::DavixError::clearError(&reqerr);
-        return -1;
+    for (auto& call : calls) {
+        std::vector<const char*> call_urls;
+        for (int i : call.files) {
+            call_urls.push_back(urls[i]);
+        }
+        call.body = tape_rest_api::list_files_body(call_urls.size(), call_urls.data());
     }
 
-    if (request.getRequestCode() != 200) {
-        gfal2_set_error(&tmp_err, http_plugin_domain, EINVAL, __func__,
-                        "[Tape REST API] Stage call failed: %s: %s",
-                        reqerr->getErrMsg().c_str(), request.getAnswerContent());
-        tape_rest_api::copyErrors(tmp_err, nbfiles, errors);
-        Davix::DavixError::clearError(&reqerr);
-        return -1;
-    }
+    tape_rest_api::prepare_calls(davix, calls, urls, [](const tape_rest_api::tape_call& call) {
+        return "/stage/" + call.id + "/cancel";
+    });
+    tape_rest_api::run_parallel(calls.size(), parallelism, [&](size_t i) {
+        tape_rest_api::execute_call(davix, calls[i], true, 200, "Cancel");
+    });
 
-    return 0;
+    return (tape_rest_api::dispatch_call_errors(calls, nbfiles, urls, errors, __func__) > 0) ? -1 : 0;
 }
 
 
@@ -517,175 +968,99 @@ int gfal_http_bring_online_poll_list(plugin_handle plugin_data, int nbfiles, con
         return -1;
     }
 
-    std::stringstream method;
-    method << "/stage/" << token;
-
-    // Find out Tape Rest API endpoint
     GfalHttpPluginData* davix = gfal_http_get_plugin_context(plugin_data);
-    std::string tapeEndpoint = gfal_http_discover_tape_endpoint(davix, urls[0], method.str().c_str(), &tmp_err);
-
-    if (tmp_err != NULL) {
-        tape_rest_api::copyErrors(tmp_err, nbfiles, errors);
-        return -1;
-    }
-
-    // Construct and send "GET /stage/<token>" request
-    Davix::DavixError* reqerr = NULL;
-    Davix::Uri uri(tapeEndpoint);
-    Davix::RequestParams params;
-
-    GetRequest request(davix->context, uri, &reqerr);
-    davix->get_params(&params, uri, GfalHttpPluginData::OP::TAPE);
-    request.setParameters(params);
-
-    if (request.executeRequest(&reqerr)) {
-        gfal2_set_error(&tmp_err, http_plugin_domain, davix2errno(reqerr->getStatus()), __func__,
-                        "[Tape REST API] Stage pooling call failed: %s", reqerr->getErrMsg().c_str());
-        tape_rest_api::copyErrors(tmp_err, nbfiles, errors);
-        Davix::DavixError::clearError(&reqerr);
-        return -1;
-    }
-
-    if (request.getRequestCode() != 200) {
-        gfal2_set_error(&tmp_err, http_plugin_domain, EINVAL, __func__,
-                        "[Tape REST API] Stage call failed: %s: %s)",
-                        reqerr->getErrMsg().c_str(), request.getAnswerContent());
-        tape_rest_api::copyErrors(tmp_err, nbfiles, errors);
-        Davix::DavixError::clearError(&reqerr);
-        return -1;
-    }
-
-    std::string content = std::string(request.getAnswerContent());
-
-    if (content.empty()) {
-        gfal2_set_error(&tmp_err, http_plugin_domain, ENOMSG, __func__,
-                        "[Tape REST API] Response with no data");
-        tape_rest_api::copyErrors(tmp_err, nbfiles, errors);
-        return -1;
-    }
-
-    struct json_object* json_response = json_tokener_parse(content.c_str());
-
-    if (!json_response) {
-        gfal2_set_error(&tmp_err, http_plugin_domain, ENOMSG, __func__,
-                        "[Tape REST API] Malformed served response");
-        tape_rest_api::copyErrors(tmp_err, nbfiles, errors);
-        return -1;
-    }
-
-    // Check if "id" attribute exists
-    struct json_object* id = 0;
-    bool foundId = json_object_object_get_ex(json_response, "id", &id);
-    std::string reqid = foundId ? json_object_get_string(id) : "";
-
-    // Check if "request_id" attribute matches
-    if (reqid.empty()) {
-        gfal2_set_error(&tmp_err, http_plugin_domain, ENOMSG, __func__,
-                        "[Tape REST API] Request ID missing from polling response (expected id=%s)", token);
-        tape_rest_api::copyErrors(tmp_err, nbfiles, errors);
-        return -1;
-    }
-
-    if (reqid != token) {
-        gfal2_set_error(&tmp_err, http_plugin_domain, ENOMSG, __func__,
-                        "[Tape REST API] Request ID mismatch. Expected id=%s but received id=%s", token, reqid.c_str());
-        tape_rest_api::copyErrors(tmp_err, nbfiles, errors);
-        return -1;
-    }
-
-    // Check if "files" attribute exists
-    struct json_object* files = 0;
-    bool foundFiles = json_object_object_get_ex(json_response, "files", &files);
-
-    if (!foundFiles) {
-        gfal2_set_error(&tmp_err, http_plugin_domain, ENOMSG, __func__,
-                        "[Tape REST API] Files attribute missing from server poll response");
-        tape_rest_api::copyErrors(tmp_err, nbfiles, errors);
-        return -1;
-    }
-
-    // Iterate over the "files" list
-    int online_count = 0;
-    int error_count  = 0;
-
-    for (int i = 0; i < nbfiles; ++i) {
-        std::string path = Davix::Uri(urls[i]).getPath();
-        struct json_object* file = tape_rest_api::polling_get_item_by_path(files, path);
-
-        if (file == NULL) {
-            error_count++;
-            gfal2_set_error(&errors[i], http_plugin_domain, ENOMSG, __func__,
-                            "[Tape REST API] Missing response item for path=%s", path.c_str());
-            continue;
+    const int parallelism = gfal2_get_opt_integer_with_default(davix->handle, "HTTP PLUGIN", "TAPE_PARALLEL_REQUESTS", 4);
+    const time_t backoff_min = gfal2_get_opt_integer_with_default(davix->handle, "HTTP PLUGIN", "TAPE_POLL_BACKOFF_MIN", 2);
+    const time_t backoff_max = gfal2_get_opt_integer_with_default(davix->handle, "HTTP PLUGIN", "TAPE_POLL_BACKOFF_MAX", 60);
+
+    // Only ask the server about requests the poll scheduler finds due,
+    // the rest is served from the shared state table
+    auto calls = tape_rest_api::calls_for_token(tape_rest_api::split_request_ids(token), nbfiles, urls);
+
+    tape_rest_api::prepare_calls(davix, calls, urls, [](const tape_rest_api::tape_call& call) {
+        return "/stage/" + call.id;
+    });
+
+    // Send the due "GET /stage/<id>" requests concurrently
+    tape_rest_api::run_parallel(calls.size(), parallelism, [&](size_t i) {
+        tape_rest_api::tape_call& call = calls[i];
+        GError* poll_err = NULL;
+
+        std::vector<std::string> paths;
+        std::vector<const char*> keys;
+        for (int file : call.files) {
+            paths.push_back(tape_rest_api::stage_path(urls[file]));
         }
-
-        // Check if "error" attribute exists
-        struct json_object* file_error_text = 0;
-        bool foundError = json_object_object_get_ex(file, "error", &file_error_text);
-
-        if (foundError) {
-            error_count++;
-            std::string error_text = json_object_get_string(file_error_text);
-            gfal2_set_error(&errors[i], http_plugin_domain, ENOMSG, __func__,
-                            "[Tape REST API] %s", error_text.c_str());
-            continue;
+        for (const auto& path : paths) {
+            keys.push_back(path.c_str());
         }
 
-        // Retrieve "onDisk" attribute
-        struct json_object* file_on_disk = 0;
-        bool foundOnDisk = json_object_object_get_ex(file, "onDisk", &file_on_disk);
+        int due = gfal2_poll_begin(davix->handle, call.endpoint.c_str(), call.id.c_str(),
+                                   backoff_min, backoff_max, keys.size(), keys.data(), NULL, &poll_err);
+        if (due < 0) {
+            call.err_code = poll_err->code;
+            call.err_msg = poll_err->message;
+            g_error_free(poll_err);
+            return;
+        }
+        if (due == 0) {
+            call.success = true;
+            return;
+        }
 
-        if (foundOnDisk) {
-            std::string disk = json_object_get_string(file_on_disk);
-            std::transform(disk.begin(), disk.end(), disk.begin(), tolower);
+        tape_rest_api::execute_call(davix, call, false, 200, "Stage polling");
+        if (call.success) {
+            tape_rest_api::parse_poll_response(call);
+        }
+        if (!call.success) {
+            gfal2_poll_end(call.endpoint.c_str(), call.id.c_str(), 0, NULL, NULL);
+            return;
+        }
 
-            if (disk == "true") {
-                online_count++;
-                continue;
-            } else {
-                gfal2_set_error(&errors[i], http_plugin_domain, EAGAIN, __func__,
-                                "[Tape REST API] File %s is not yet on disk", path.c_str());
-                continue;
+        // Report every file of the request, not only the ones asked
+        std::vector<std::string> polled_paths;
+        std::vector<const char*> polled_keys;
+        std::vector<GError*> statuses;
+        for (const auto& state : call.states) {
+            GError* status = NULL;
+            if (state.second.code != 0) {
+                gfal2_set_error(&status, http_plugin_domain, state.second.code, __func__,
+                                "%s", state.second.message.c_str());
             }
+            polled_paths.push_back(state.first);
+            statuses.push_back(status);
+        }
+        for (const auto& path : polled_paths) {
+            polled_keys.push_back(path.c_str());
         }
 
-        // Retrieve "state" attribute
-        struct json_object* file_state = 0;
-        bool foundState = json_object_object_get_ex(file, "state", &file_state);
-
-        if (!foundState) {
-            error_count++;
-            gfal2_set_error(&errors[i], http_plugin_domain, ENOMSG, __func__,
-                            "[Tape REST API] State and onDisk attributes missing");
-            continue;
+        // The table is updated first: concurrent polls of this request read it as soon as the poll ends
+        tape_rest_api::stage_table.update(call.id, call.endpoint, call.states, time(NULL));
+        gfal2_poll_end(call.endpoint.c_str(), call.id.c_str(), polled_keys.size(), polled_keys.data(),
+                       statuses.data());
+        for (auto status : statuses) {
+            g_clear_error(&status);
         }
+    });
 
-        std::string state = json_object_get_string(file_state);
+    // Gather the per-file status from the state table
+    int online_count = 0;
+    int error_count = 0;
 
-        if (state == "COMPLETED") {
+    for (int i = 0; i < nbfiles; ++i) {
+        tape_rest_api::stage_file_state state;
+        bool answered = tape_rest_api::poll_file_state(calls, i, tape_rest_api::stage_path(urls[i]), state);
+
+        if (state.code == 0) {
             online_count++;
-        } else if (state == "STARTED" || state == "SUBMITTED") {
-            gfal2_set_error(&errors[i], http_plugin_domain, EAGAIN, __func__,
-                            "[Tape REST API] File %s is not yet on disk", path.c_str());
-        } else if (state == "CANCELED") {
-            gfal2_set_error(&errors[i], http_plugin_domain, ECANCELED, __func__,
-                            "[Tape REST API] Staging operation cancelled. File=%s", path.c_str());
-            error_count++;
-        } else if (state == "FAILED") {
-            gfal2_set_error(&errors[i], http_plugin_domain, ENOENT, __func__,
-                            "[Tape REST API] Staging operation failed for file=%s", path.c_str());
-            error_count++;
         } else {
-            gfal2_set_error(&errors[i], http_plugin_domain, ENOENT, __func__,
-                            "[Tape REST API] Unrecognized staging status. File=%s status=%s",
-                            path.c_str(), state.c_str());
-            error_count++;
+            gfal2_set_error(&errors[i], http_plugin_domain, state.code, __func__, "%s", state.message.c_str());
+            if (!answered || state.code != EAGAIN) {
+                error_count++;
+            }
         }
     }
 
-    // Free the top JSON object
-    json_object_put(json_response);
-
     // All files are on disk: return 1
     if (online_count == nbfiles) {
         return 1;
@@ -859,46 +1234,40 @@ int gfal_http_release_file_list(plugin_handle plugin_data, int nbfiles, const ch
         return -1;
     }
 
-    GError* tmp_err = NULL;
-    std::stringstream method;
-    method << "/release/" << ((request_id && strlen(request_id) > 0) ? request_id : "gfal2-placeholder-id");
-
-    // Find out Tape REST API endpoint
+    // Send one "POST /release/<id>" request per request ID and endpoint
     GfalHttpPluginData* davix = gfal_http_get_plugin_context(plugin_data);
-    std::string tapeEndpoint = gfal_http_discover_tape_endpoint(davix, urls[0], method.str().c_str(), &tmp_err);
+    const int parallelism = gfal2_get_opt_integer_with_default(davix->handle, "HTTP PLUGIN", "TAPE_PARALLEL_REQUESTS", 4);
+    std::vector<std::string> ids;
 
-    if (tmp_err != NULL) {
-        tape_rest_api::copyErrors(tmp_err, nbfiles, errors);
-        return -1;
+    if (request_id && strlen(request_id) > 0) {
+        ids = tape_rest_api::split_request_ids(request_id);
+    } else {
+        ids.push_back("gfal2-placeholder-id");
     }
 
-    // Construct and send "POST /release" request
-    Davix::DavixError* reqerr = NULL;
-    Davix::Uri uri(tapeEndpoint);
-    Davix::RequestParams params;
-
-    PostRequest request(davix->context, uri, &reqerr);
-    davix->get_params(&params, uri, GfalHttpPluginData::OP::TAPE);
-    params.addHeader("Content-Type", "application/json");
-    request.setParameters(params);
-    request.setRequestBody(tape_rest_api::list_files_body(nbfiles, urls));
+    auto calls = tape_rest_api::calls_for_token(ids, nbfiles, urls);
 
-    if (request.executeRequest(&reqerr)) {
-        gfal2_set_error(&tmp_err, http_plugin_domain, davix2errno(reqerr->getStatus()), __func__,
-                        "[Tape REST API] Release call failed: %s", reqerr->getErrMsg().c_str());
-        tape_rest_api::copyErrors(tmp_err, nbfiles, errors);
-        Davix::DavixError::clearError(&reqerr);
-        return -1;
+    for (auto& call : calls) {
+        std::vector<const char*> call_urls;
+        for (int i : call.files) {
+            call_urls.push_back(urls[i]);
+        }
+        call.body = tape_rest_api::list_files_body(call_urls.size(), call_urls.data());
     }
 
-    if (request.getRequestCode() != 200) {
-        gfal2_set_error(&tmp_err, http_plugin_domain, EINVAL, __func__,
-                        "[Tape REST API] Release call failed: %s: %s",
-                        reqerr->getErrMsg().c_str(), request.getAnswerContent());
-        tape_rest_api::copyErrors(tmp_err, nbfiles, errors);
-        Davix::DavixError::clearError(&reqerr);
-        return -1;
+    tape_rest_api::prepare_calls(davix, calls, urls, [](const tape_rest_api::tape_call& call) {
+        return "/release/" + call.id;
+    });
+    tape_rest_api::run_parallel(calls.size(), parallelism, [&](size_t i) {
+        tape_rest_api::execute_call(davix, calls[i], true, 200, "Release");
+    });
+
+    for (const auto& call : calls) {
+        if (call.success) {
+            tape_rest_api::stage_table.forget(call.id);
+            gfal2_poll_forget(call.endpoint.c_str(), call.id.c_str());
+        }
     }
 
-    return 0;
+    return (tape_rest_api::dispatch_call_errors(calls, nbfiles, urls, errors, __func__) > 0) ? -1 : 0;
 }
@@ -0,0 +1,181 @@
+/*
+ * Copyright (c) CERN 2022
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _GFAL_HTTP_PLUGIN_TAPE_H
+#define _GFAL_HTTP_PLUGIN_TAPE_H
+
+#include <ctime>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "gfal_http_plugin.h"
+
+// Tape REST API internals shared with the unit tests
+namespace tape_rest_api {
+
+    // Request IDs of a multi-request stage operation are joined with this separator
+    const char REQUEST_ID_SEPARATOR = ',';
+
+    // Staging state of a single file, as last reported by the server
+    struct stage_file_state {
+        int code;               // 0 when on disk, EAGAIN while in progress, errno value otherwise
+        std::string message;
+    };
+
+    typedef std::unordered_map<std::string, stage_file_state> stage_file_map;
+
+    // Process-wide table of the stage requests known to this process.
+    // Polling results are kept here so that polls the scheduler finds not due,
+    // as well as polls of files already in a final state, are served without a round trip.
+    class StageStateTable {
+    public:
+        // Keep untouched entries at most this long
+        static const time_t ENTRY_TTL = 6 * 3600;
+
+        // Entries untouched for ENTRY_TTL are dropped meanwhile
+        void register_request(const std::string& id, const std::string& endpoint,
+                              const std::vector<std::string>& paths, time_t now)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            evict_expired(now);
+
+            stage_request_state& request = requests[id];
+            request.endpoint = endpoint;
+            request.paths.insert(paths.begin(), paths.end());
+            request.last_access = now;
+        }
+
+        // Endpoint and submitted paths of a request, if it was seen by this process
+        bool lookup(const std::string& id, std::string& endpoint, std::set<std::string>& paths)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            auto it = requests.find(id);
+
+            if (it == requests.end() || it->second.endpoint.empty()) {
+                return false;
+            }
+
+            endpoint = it->second.endpoint;
+            paths = it->second.paths;
+            return true;
+        }
+
+        // Store a polling result
+        void update(const std::string& id, const std::string& endpoint, stage_file_map& files, time_t now)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stage_request_state& request = requests[id];
+            request.endpoint = endpoint;
+            request.files.swap(files);
+            request.last_access = now;
+        }
+
+        bool get_file(const std::string& id, const std::string& path, stage_file_state& state)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            auto it = requests.find(id);
+
+            if (it == requests.end()) {
+                return false;
+            }
+
+            it->second.last_access = time(NULL);
+            auto file = it->second.files.find(path);
+
+            if (file == it->second.files.end()) {
+                return false;
+            }
+
+            state = file->second;
+            return true;
+        }
+
+        void forget(const std::string& id)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            requests.erase(id);
+        }
+
+    private:
+        struct stage_request_state {
+            std::string endpoint;
+            std::set<std::string> paths;
+            stage_file_map files;
+            time_t last_access = 0;
+        };
+
+        void evict_expired(time_t now)
+        {
+            for (auto it = requests.begin(); it != requests.end();) {
+                if (now - it->second.last_access > ENTRY_TTL) {
+                    it = requests.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+        }
+
+        std::mutex mutex;
+        std::map<std::string, stage_request_state> requests;
+    };
+
+    extern StageStateTable stage_table;
+
+    // One call to the Tape REST API, concerning a subset of the files
+    struct tape_call {
+        std::string id;             // request ID (empty for new stage requests)
+        std::string endpoint;       // storage endpoint
+        std::vector<int> files;     // indexes into the caller's URL list
+        std::string tape_uri;       // full Tape REST API URI, method included
+        Davix::RequestParams params;
+        std::string body;
+
+        // Outcome
+        bool success = false;
+        int err_code = 0;
+        std::string err_msg;
+        std::string content;
+        stage_file_map states;
+    };
+
+    // Remote storage endpoint (protocol://host[:port]) a URL belongs to
+    std::string storage_endpoint(const char* url);
+
+    // Path of the URL, as used to match items in Tape REST API responses
+    std::string stage_path(const char* url);
+
+    // Split a (possibly composite) staging token into the individual request IDs
+    std::vector<std::string> split_request_ids(const char* token);
+
+    // Map each request ID of the token to the endpoint(s) and files it concerns
+    std::vector<tape_call> calls_for_token(const std::vector<std::string>& ids, int nbfiles,
+                                           const char* const* urls);
+
+    // Parse a "GET /stage/<id>" response into a path -> state map
+    void parse_poll_response(tape_call& call);
+
+    // Staging state of a file after the polls of the calls concerning it: from the state table,
+    // else as last seen by the poll scheduler (EAGAIN if never seen).
+    // Returns false if none of the calls succeeded, with the error of the failed one in state
+    bool poll_file_state(const std::vector<tape_call>& calls, int file, const std::string& path,
+                         stage_file_state& state);
+}
+
+#endif //_GFAL_HTTP_PLUGIN_TAPE_H
@@ -0,0 +1,326 @@
+/*
+ * Copyright (c) CERN 2013-2017
+ *
+ * Copyright (c) Members of the EMI Collaboration. 2010-2013
+ *  See  http://www.eu-emi.eu/partners for details on the copyright
+ *  holders.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "gfal_mock_plugin.h"
+#include <string.h>
+#include <checksums/checksums.h>
+
+// Size of the blocks generated for the checksum calculation
+#define GFAL_MOCK_CHECKSUM_BLOCK (256 * 1024)
+
+
+/*
+ * The content of a file is a stream of 64 bits words, each one derived from the seed
+ * and its index with the splitmix64 mixer. Any range can be generated independently,
+ * so reads at random offsets, pread and parallel streams all see the same bytes.
+ */
+static inline guint64 gfal_mock_word(guint64 seed, guint64 index)
+{
+    guint64 z = seed + (index + 1) * G_GUINT64_CONSTANT(0x9E3779B97F4A7C15);
+    z = (z ^ (z >> 30)) * G_GUINT64_CONSTANT(0xBF58476D1CE4E5B9);
+    z = (z ^ (z >> 27)) * G_GUINT64_CONSTANT(0x94D049BB133111EB);
+    return z ^ (z >> 31);
+}
+
+
+static inline void gfal_mock_word_bytes(guint64 word, guchar *bytes)
+{
+    int i;
+    for (i = 0; i < 8; ++i) {
+        bytes[i] = (guchar)(word >> (i * 8));
+    }
+}
+
+
+guint64 gfal_plugin_mock_get_seed(const char *url)
+{
+    char arg_buffer[64] = {0};
+    gfal_plugin_mock_get_value(url, "seed", arg_buffer, sizeof(arg_buffer));
+    if (arg_buffer[0] != '\0') {
+        return (guint64)g_ascii_strtoull(arg_buffer, NULL, 10);
+    }
+
+    // FNV-1a of the path, so the knobs in the query do not change the content
+    const char *path = strstr(url, "://");
+    path = path ? path + 3 : url;
+    path += strcspn(path, "/?");
+
+    guint64 hash = G_GUINT64_CONSTANT(14695981039346656037);
+    for (; *path && *path != '?'; ++path) {
+        hash ^= (guchar)*path;
+        hash *= G_GUINT64_CONSTANT(1099511628211);
+    }
+    return hash;
+}
+
+
+void gfal_plugin_mock_fill(guint64 seed, off_t offset, void *buff, size_t count)
+{
+    guchar *out = buff;
+    guint64 index = (guint64)offset / 8;
+    size_t skip = (size_t)offset % 8;
+    guchar bytes[8];
+
+    // Unaligned head
+    if (skip && count) {
+        size_t n = MIN(8 - skip, count);
+        gfal_mock_word_bytes(gfal_mock_word(seed, index++), bytes);
+        memcpy(out, bytes + skip, n);
+        out += n;
+        count -= n;
+    }
+    // Full words
+    while (count >= 8) {
+        gfal_mock_word_bytes(gfal_mock_word(seed, index++), out);
+        out += 8;
+        count -= 8;
+    }
+    // Tail
+    if (count) {
+        gfal_mock_word_bytes(gfal_mock_word(seed, index), bytes);
+        memcpy(out, bytes, count);
+    }
+}
+
+
+gboolean gfal_plugin_mock_verify(guint64 seed, off_t offset, const void *buff, size_t count)
+{
+    guchar expected[4096];
+    const guchar *in = buff;
+
+    while (count > 0) {
+        size_t n = MIN(count, sizeof(expected));
+        gfal_plugin_mock_fill(seed, offset, expected, n);
+        if (memcmp(in, expected, n) != 0) {
+            return FALSE;
+        }
+        in += n;
+        offset += n;
+        count -= n;
+    }
+    return TRUE;
+}
+
+
+// adler32, as defined by RFC 1950
+static guint32 gfal_mock_adler32(guint32 adler, const guchar *buff, size_t count)
+{
+    guint32 a = adler & 0xFFFF, b = adler >> 16;
+    while (count > 0) {
+        // 5552 is the largest n such that the sums do not overflow before the modulo
+        size_t n = MIN(count, 5552);
+        count -= n;
+        while (n--) {
+            a += *buff++;
+            b += a;
+        }
+        a %= 65521;
+        b %= 65521;
+    }
+    return (b << 16) | a;
+}
+
+
+// crc32, IEEE 802.3 polynomial, same as zlib
+static guint32 gfal_mock_crc32(guint32 crc, const guchar *buff, size_t count)
+{
+    static guint32 table[256];
+    static gsize table_init = 0;
+
+    if (g_once_init_enter(&table_init)) {
+        guint32 i, j;
+        for (i = 0; i < 256; ++i) {
+            guint32 c = i;
+            for (j = 0; j < 8; ++j) {
+                c = (c & 1) ? (0xEDB88320 ^ (c >> 1)) : (c >> 1);
+            }
+            table[i] = c;
+        }
+        g_once_init_leave(&table_init, 1);
+    }
+
+    crc = ~crc;
+    while (count--) {
+        crc = table[(crc ^ *buff++) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+
+int gfal_plugin_mock_data_checksum(guint64 seed, off_t size, const char *check_type,
+    off_t start_offset, size_t data_length, char *checksum_buffer, size_t buffer_length, GError **err)
+{
+    enum {MOCK_ADLER32, MOCK_CRC32, MOCK_MD5} type;
+
+    if (strcasecmp(check_type, "adler32") == 0) {
+        type = MOCK_ADLER32;
+    }
+    else if (strcasecmp(check_type, "crc32") == 0) {
+        type = MOCK_CRC32;
+    }
+    else if (strcasecmp(check_type, "md5") == 0) {
+        type = MOCK_MD5;
+    }
+    else {
+        gfal_plugin_mock_report_error("Checksum type not supported", ENOTSUP, err);
+        return -1;
+    }
+
+    if (start_offset < 0 || start_offset > size) {
+        gfal_plugin_mock_report_error("Checksum range out of the file", EINVAL, err);
+        return -1;
+    }
+
+    // A length of 0 means up to the end of the file
+    off_t end = size;
+    if (data_length > 0 && (off_t)data_length < size - start_offset) {
+        end = start_offset + data_length;
+    }
+
+    guint32 sum32 = (type == MOCK_ADLER32) ? 1 : 0;
+    GFAL_MD5_CTX md5;
+    if (type == MOCK_MD5) {
+        gfal2_md5_init(&md5);
+    }
+
+    guchar *block = g_malloc(GFAL_MOCK_CHECKSUM_BLOCK);
+    off_t offset;
+    for (offset = start_offset; offset < end; offset += GFAL_MOCK_CHECKSUM_BLOCK) {
+        size_t n = (size_t)MIN(end - offset, GFAL_MOCK_CHECKSUM_BLOCK);
+        gfal_plugin_mock_fill(seed, offset, block, n);
+        switch (type) {
+            case MOCK_ADLER32:
+                sum32 = gfal_mock_adler32(sum32, block, n);
+                break;
+            case MOCK_CRC32:
+                sum32 = gfal_mock_crc32(sum32, block, n);
+                break;
+            case MOCK_MD5:
+                gfal2_md5_update(&md5, block, n);
+                break;
+        }
+    }
+    g_free(block);
+
+    if (type == MOCK_MD5) {
+        unsigned char digest[16];
+        if (buffer_length < sizeof(digest) * 2 + 1) {
+            gfal_plugin_mock_report_error("Buffer for checksum too short", ENOBUFS, err);
+            return -1;
+        }
+        gfal2_md5_final(digest, &md5);
+        gfal2_md5_to_hex_string(digest, checksum_buffer, buffer_length);
+    }
+    else if (type == MOCK_ADLER32) {
+        g_snprintf(checksum_buffer, buffer_length, "%08x", sum32);
+    }
+    else {
+        g_snprintf(checksum_buffer, buffer_length, "%u", sum32);
+    }
+    return 0;
+}
+
+
+/*
+ * Simulated per host connection limit, shared by all the contexts of the process
+ * as a real server would be
+ */
+static GMutex *connections_lock = NULL;
+static GCond *connections_released = NULL;
+static GHashTable *connections = NULL;
+
+
+__attribute__((constructor))
+static void gfal_mock_connections_init()
+{
+#if  (!GLIB_CHECK_VERSION (2, 32, 0))
+    if (!g_thread_supported())
+        g_thread_init(NULL);
+#endif
+    connections_lock = g_mutex_new();
+    connections_released = g_cond_new();
+    connections = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+}
+
+
+static void gfal_mock_url_host(const char *url, char *host, size_t host_size)
+{
+    const char *start = strstr(url, "://");
+    start = start ? start + 3 : url;
+    size_t len = strcspn(start, "/?");
+    g_strlcpy(host, start, MIN(len + 1, host_size));
+}
+
+
+int gfal_plugin_mock_connection_acquire(MockPluginData *mdata, const char *url, GError **err)
+{
+    char arg_buffer[64] = {0};
+    gfal_plugin_mock_get_value(url, "max_connections", arg_buffer, sizeof(arg_buffer));
+    long long limit = gfal_plugin_mock_get_int_from_str(arg_buffer);
+    if (limit <= 0) {
+        limit = mdata->max_connections;
+    }
+
+    char host[GFAL_URL_MAX_LEN];
+    gfal_mock_url_host(url, host, sizeof(host));
+
+    GTimeVal deadline;
+    g_get_current_time(&deadline);
+    g_time_val_add(&deadline, (glong)mdata->connection_timeout * G_USEC_PER_SEC);
+
+    // Connections are always counted, so the limit can change between calls
+    g_mutex_lock(connections_lock);
+    guint count = GPOINTER_TO_UINT(g_hash_table_lookup(connections, host));
+    while (limit > 0 && count >= limit) {
+        if (!g_cond_timed_wait(connections_released, connections_lock, &deadline)) {
+            break;
+        }
+        count = GPOINTER_TO_UINT(g_hash_table_lookup(connections, host));
+    }
+    gboolean acquired = (limit <= 0 || count < limit);
+    if (acquired) {
+        g_hash_table_insert(connections, g_strdup(host), GUINT_TO_POINTER(count + 1));
+    }
+    g_mutex_unlock(connections_lock);
+
+    if (!acquired) {
+        gfal_plugin_mock_report_error("Too many connections to the host", EAGAIN, err);
+        return -1;
+    }
+    return 0;
+}
+
+
+void gfal_plugin_mock_connection_release(const char *url)
+{
+    char host[GFAL_URL_MAX_LEN];
+    gfal_mock_url_host(url, host, sizeof(host));
+
+    g_mutex_lock(connections_lock);
+    guint count = GPOINTER_TO_UINT(g_hash_table_lookup(connections, host));
+    if (count > 1) {
+        g_hash_table_insert(connections, g_strdup(host), GUINT_TO_POINTER(count - 1));
+    }
+    else {
+        g_hash_table_remove(connections, host);
+    }
+    g_cond_broadcast(connections_released);
+    g_mutex_unlock(connections_lock);
+}
@@ -22,107 +22,201 @@
 #include <stdio.h>
 #include <string.h>
 
-#ifndef EBADFD
-#define EBADFD EBADF
-#endif
+// Granularity of the throttling: shorter waits are accumulated
+#define GFAL_MOCK_MIN_SLEEP_US 200
 
 typedef struct {
-    const char *url;
-    int fd;
+    char *url;
+    int flag;
+    guint64 seed;
     off_t size;
     off_t offset;
+    gboolean verify;
+
+    // Knobs, parsed once at open so they do not weigh on each call
+    int read_wait;
+    long long read_wait_us;
+    long long write_wait_us;
+    int read_errno;
+
+    // Bandwidth throttling, shared by all the calls on the handle
+    GMutex *lock;
+    long long bandwidth;
+    gint64 throttle_start;
+    guint64 throttle_bytes;
 } MockFile;
 
 
+static long long gfal_mock_get_int(const char *url, const char *key, long long default_value)
+{
+    char arg_buffer[64] = {0};
+    gfal_plugin_mock_get_value(url, key, arg_buffer, sizeof(arg_buffer));
+    if (arg_buffer[0] == '\0') {
+        return default_value;
+    }
+    return gfal_plugin_mock_get_int_from_str(arg_buffer);
+}
+
+
+static void gfal_mock_file_free(MockFile *mfd)
+{
+    if (mfd->lock) {
+        g_mutex_free(mfd->lock);
+    }
+    g_free(mfd->url);
+    g_free(mfd);
+}
+
+
+// Simulate the per operation latency and the bandwidth of the storage
+static void gfal_mock_file_delay(MockFile *mfd, long long wait_us, size_t count)
+{
+    gint64 delay = wait_us;
+
+    if (mfd->bandwidth > 0) {
+        gint64 now = g_get_monotonic_time();
+        g_mutex_lock(mfd->lock);
+        if (mfd->throttle_start == 0) {
+            mfd->throttle_start = now;
+        }
+        mfd->throttle_bytes += count;
+        // Time at which the bytes moved so far should be done
+        gint64 due = mfd->throttle_start +
+            (gint64)((double)mfd->throttle_bytes * G_USEC_PER_SEC / mfd->bandwidth);
+        g_mutex_unlock(mfd->lock);
+        delay = MAX(delay, due - now);
+    }
+
+    if (delay >= GFAL_MOCK_MIN_SLEEP_US) {
+        g_usleep(delay);
+    }
+}
+
+
 gfal_file_handle gfal_plugin_mock_open(plugin_handle plugin_data, const char *url, int flag, mode_t mode, GError **err)
 {
+    MockPluginData *mdata = plugin_data;
     struct stat st;
     int ret = gfal_plugin_mock_stat(plugin_data, url, &st, err);
     if (ret < 0) {
         return NULL;
     }
 
-    char arg_buffer[64] = {0};
-    gfal_plugin_mock_get_value(url, "open_errno", arg_buffer, sizeof(arg_buffer));
-    int errcode = gfal_plugin_mock_get_int_from_str(arg_buffer);
+    int errcode = gfal_mock_get_int(url, "open_errno", 0);
     if (errcode > 0) {
         gfal_plugin_mock_report_error(strerror(errcode), errcode, err);
         return NULL;
     }
 
-    MockFile *fd = g_malloc(sizeof(MockFile));
-    fd->url = url;
-    fd->size = st.st_size;
-    fd->offset = 0;
-    if (flag == O_RDONLY) {
-        fd->fd = open("/dev/urandom", O_RDONLY);
-    }
-    else if (flag == O_WRONLY) {
-        fd->fd = open("/dev/null", O_WRONLY);
-    }
-    else {
+    int accmode = flag & O_ACCMODE;
+    if (accmode != O_RDONLY && accmode != O_WRONLY) {
         gfal_plugin_mock_report_error("Mock plugin does not support read and write", ENOSYS, err);
         return NULL;
     }
 
-    if (fd->fd < 0) {
-        gfal_plugin_mock_report_error("Could not open the file!", errno, err);
+    if (gfal_plugin_mock_connection_acquire(mdata, url, err) < 0) {
         return NULL;
     }
 
+    MockFile *fd = g_new0(MockFile, 1);
+    fd->url = g_strdup(url);
+    fd->flag = accmode;
+    fd->seed = gfal_plugin_mock_get_seed(url);
+    fd->size = st.st_size;
+    fd->offset = 0;
+    fd->verify = gfal_mock_get_int(url, "verify", 0) != 0;
+    fd->read_wait = gfal_mock_get_int(url, "read_wait", 0);
+    fd->read_wait_us = gfal_mock_get_int(url, "read_wait_us", 0);
+    fd->write_wait_us = gfal_mock_get_int(url, "write_wait_us", 0);
+    fd->read_errno = gfal_mock_get_int(url, "read_errno", 0);
+    fd->bandwidth = gfal_mock_get_int(url, "bandwidth", mdata->bandwidth);
+    fd->lock = g_mutex_new();
+
     return gfal_file_handle_new2(gfal_mock_plugin_getName(), fd, NULL, url);
 }
 
 
-ssize_t gfal_plugin_mock_read(plugin_handle plugin_data, gfal_file_handle fd, void *buff, size_t count, GError **err)
+ssize_t gfal_plugin_mock_pread(plugin_handle plugin_data, gfal_file_handle fd, void *buff, size_t count,
+    off_t offset, GError **err)
 {
     MockFile *mfd = gfal_file_handle_get_fdesc(fd);
-    char arg_buffer[64] = {0};
 
-    gfal_plugin_mock_get_value(mfd->url, "read_wait", arg_buffer, sizeof(arg_buffer));
-    int wait = gfal_plugin_mock_get_int_from_str(arg_buffer);
-    if (wait > 0) {
-        sleep(wait);
+    if (mfd->flag != O_RDONLY) {
+        gfal_plugin_mock_report_error("File not open for reading", EBADF, err);
+        return -1;
+    }
+
+    if (mfd->read_wait > 0) {
+        sleep(mfd->read_wait);
     }
 
-    gfal_plugin_mock_get_value(mfd->url, "read_errno", arg_buffer, sizeof(arg_buffer));
-    int errcode = gfal_plugin_mock_get_int_from_str(arg_buffer);
-    if (errcode > 0) {
-        gfal_plugin_mock_report_error(strerror(errcode), errcode, err);
+    if (mfd->read_errno > 0) {
+        gfal_plugin_mock_report_error(strerror(mfd->read_errno), mfd->read_errno, err);
         return -1;
     }
 
-    off_t remaining = mfd->size - mfd->offset;
-    if (count > remaining) {
-        count = remaining;
+    if (offset < 0) {
+        gfal_plugin_mock_report_error("Invalid offset", EINVAL, err);
+        return -1;
+    }
+
+    if (offset >= mfd->size) {
+        count = 0;
+    }
+    else if ((off_t)count > mfd->size - offset) {
+        count = mfd->size - offset;
+    }
+
+    gfal_plugin_mock_fill(mfd->seed, offset, buff, count);
+    gfal_mock_file_delay(mfd, mfd->read_wait_us, count);
+    return count;
+}
+
+
+ssize_t gfal_plugin_mock_read(plugin_handle plugin_data, gfal_file_handle fd, void *buff, size_t count, GError **err)
+{
+    MockFile *mfd = gfal_file_handle_get_fdesc(fd);
+    ssize_t nread = gfal_plugin_mock_pread(plugin_data, fd, buff, count, mfd->offset, err);
+    if (nread > 0) {
+        mfd->offset += nread;
+    }
+    return nread;
+}
+
+
+ssize_t gfal_plugin_mock_pwrite(plugin_handle plugin_data, gfal_file_handle fd, const void *buff, size_t count,
+    off_t offset, GError **err)
+{
+    MockFile *mfd = gfal_file_handle_get_fdesc(fd);
+
+    if (mfd->flag != O_WRONLY) {
+        gfal_plugin_mock_report_error("File not open for writing", EBADF, err);
+        return -1;
     }
 
-    if (count < 0) {
-        gfal_plugin_mock_report_error("Reading passed end of file", EBADFD, err);
+    if (offset < 0) {
+        gfal_plugin_mock_report_error("Invalid offset", EINVAL, err);
         return -1;
     }
 
-    off_t nread = read(mfd->fd, buff, count);
-    if (nread < 0) {
-        gfal_plugin_mock_report_error("Failed to read file", errno, err);
+    if (mfd->verify && !gfal_plugin_mock_verify(mfd->seed, offset, buff, count)) {
+        gfal_plugin_mock_report_error("Written data does not match the expected content", EIO, err);
         return -1;
     }
 
-    mfd->offset += nread;
-    return nread;
+    gfal_mock_file_delay(mfd, mfd->write_wait_us, count);
+    return count;
 }
 
+
 ssize_t gfal_plugin_mock_write(plugin_handle plugin_data, gfal_file_handle fd, const void *buff, size_t count,
     GError **err)
 {
     MockFile *mfd = gfal_file_handle_get_fdesc(fd);
-
-    off_t nwrite = write(mfd->fd, buff, count);
-    if (nwrite < 0) {
-        gfal_plugin_mock_report_error("Failed to write file", errno, err);
+    ssize_t nwrite = gfal_plugin_mock_pwrite(plugin_data, fd, buff, count, mfd->offset, err);
+    if (nwrite > 0) {
+        mfd->offset += nwrite;
     }
-
-    mfd->offset += nwrite;
     return nwrite;
 }
 
@@ -130,8 +224,8 @@ ssize_t gfal_plugin_mock_write(plugin_handle plugin_data, gfal_file_handle fd, c
 int gfal_plugin_mock_close(plugin_handle plugin_data, gfal_file_handle fd, GError **err)
 {
     MockFile *mfd = gfal_file_handle_get_fdesc(fd);
-    close(mfd->fd);
-    g_free(mfd);
+    gfal_plugin_mock_connection_release(mfd->url);
+    gfal_mock_file_free(mfd);
     return 0;
 }
 
@@ -42,6 +42,7 @@ int gfal_plugin_mock_stat(plugin_handle plugin_data, const char *path, struct st
     if (wait_time > 0) {
         sleep(wait_time);
     }
+    gfal_plugin_mock_delay_us(path, "wait_us");
 
     // Trigger signal
     gfal_plugin_mock_get_value(path, "signal", arg_buffer, sizeof(arg_buffer));
@@ -115,6 +116,28 @@ int gfal_plugin_mock_unlink(plugin_handle plugin_data, const char *url, GError *
     return 0;
 }
 
+int gfal_plugin_mock_get_checksum(const char *url, const char *check_type,
+    off_t start_offset, size_t data_length, char *checksum_buffer, size_t buffer_length, GError **err)
+{
+    char arg_buffer[GFAL_URL_MAX_LEN] = {0};
+
+    gfal_plugin_mock_get_value(url, "checksum", arg_buffer, sizeof(arg_buffer));
+    if (strcmp(arg_buffer, "data") != 0) {
+        g_strlcpy(checksum_buffer, arg_buffer, buffer_length);
+        return 0;
+    }
+
+    if (check_type == NULL || check_type[0] == '\0') {
+        gfal_plugin_mock_report_error("A checksum type is needed to compute the checksum of the data", EINVAL, err);
+        return -1;
+    }
+
+    gfal_plugin_mock_get_value(url, "size", arg_buffer, sizeof(arg_buffer));
+    off_t size = gfal_plugin_mock_get_int_from_str(arg_buffer);
+    return gfal_plugin_mock_data_checksum(gfal_plugin_mock_get_seed(url), size, check_type,
+        start_offset, data_length, checksum_buffer, buffer_length, err);
+}
+
 int gfal_mock_checksumG(plugin_handle plugin_data, const char* url,
         const char* check_type, char * checksum_buffer, size_t buffer_length,
         off_t start_offset, size_t data_length, GError ** err)
@@ -122,6 +145,8 @@ int gfal_mock_checksumG(plugin_handle plugin_data, const char* url,
     char arg_buffer[GFAL_URL_MAX_LEN] = {0};
     int errcode = 0;
 
+    gfal_plugin_mock_delay_us(url, "wait_us");
+
     // Check errno first
     gfal_plugin_mock_get_value(url, "errno", arg_buffer, sizeof(arg_buffer));
     errcode = gfal_plugin_mock_get_int_from_str(arg_buffer);
@@ -131,10 +156,8 @@ int gfal_mock_checksumG(plugin_handle plugin_data, const char* url,
         return -1;
     }
 
-    gfal_plugin_mock_get_value(url, "checksum", arg_buffer, sizeof(arg_buffer));
-    g_strlcpy(checksum_buffer, arg_buffer, buffer_length);
-
-    return 0;
+    return gfal_plugin_mock_get_checksum(url, check_type, start_offset, data_length,
+        checksum_buffer, buffer_length, err);
 }
 
 ssize_t gfal_mock_getxattrG(plugin_handle plugin_data, const char* url, const char* key, void* buff, size_t s_buff, GError** err)
@@ -144,6 +167,8 @@ ssize_t gfal_mock_getxattrG(plugin_handle plugin_data, const char* url, const ch
     int emsg_size;
     char* emsg = NULL;
 
+    gfal_plugin_mock_delay_us(url, "wait_us");
+
     // Check errno first
     gfal_plugin_mock_get_value(url, "errno", arg_buffer, sizeof(arg_buffer));
     errcode = gfal_plugin_mock_get_int_from_str(arg_buffer);
@@ -35,6 +35,10 @@ typedef struct {
     gfal2_context_t handle;
     StatStage stat_stage;
     char enable_signals;
+    // Defaults, overridden by the query arguments
+    long long bandwidth;
+    long long max_connections;
+    int connection_timeout;
 } MockPluginData;
 
 
@@ -49,6 +53,28 @@ void gfal_plugin_mock_get_value(const char *url, const char *key, char *value, s
 
 long long gfal_plugin_mock_get_int_from_str(const char* buff);
 
+// Sleep for the number of microseconds given by the query argument key, if any
+void gfal_plugin_mock_delay_us(const char *url, const char *key);
+
+// Simulated data
+// Seed of the content of the file: the query argument seed, or a hash of the path
+guint64 gfal_plugin_mock_get_seed(const char *url);
+
+// Generate the content of the file with the given seed, in the range [offset, offset + count)
+void gfal_plugin_mock_fill(guint64 seed, off_t offset, void *buff, size_t count);
+
+// Check that buff matches the content of the file with the given seed
+gboolean gfal_plugin_mock_verify(guint64 seed, off_t offset, const void *buff, size_t count);
+
+// Checksum of a range of the generated content. A data_length of 0 means up to the end
+int gfal_plugin_mock_data_checksum(guint64 seed, off_t size, const char *check_type,
+    off_t start_offset, size_t data_length, char *checksum_buffer, size_t buffer_length, GError **err);
+
+// Take a connection slot on the host of the url, waiting if the host is at its limit
+int gfal_plugin_mock_connection_acquire(MockPluginData *mdata, const char *url, GError **err);
+
+void gfal_plugin_mock_connection_release(const char *url);
+
 // Metadata operations
 int gfal_plugin_mock_stat(plugin_handle plugin_data,
     const char *path, struct stat *buf, GError **err);
@@ -60,6 +86,10 @@ int gfal_mock_checksumG(plugin_handle plugin_data, const char* url,
     const char* check_type, char * checksum_buffer, size_t buffer_length,
     off_t start_offset, size_t data_length, GError ** err);
 
+// Checksum given by the query argument checksum or, if it is "data", calculated from the content
+int gfal_plugin_mock_get_checksum(const char *url, const char *check_type,
+    off_t start_offset, size_t data_length, char *checksum_buffer, size_t buffer_length, GError **err);
+
 ssize_t gfal_mock_getxattrG(plugin_handle plugin_data, const char* url, const char* key,
     void* buff, size_t s_buff, GError** err);
 
@@ -87,6 +117,12 @@ ssize_t gfal_plugin_mock_read(plugin_handle, gfal_file_handle fd,
 ssize_t gfal_plugin_mock_write(plugin_handle, gfal_file_handle fd,
     const void *buff, size_t count, GError **);
 
+ssize_t gfal_plugin_mock_pread(plugin_handle, gfal_file_handle fd,
+    void *buff, size_t count, off_t offset, GError **);
+
+ssize_t gfal_plugin_mock_pwrite(plugin_handle, gfal_file_handle fd,
+    const void *buff, size_t count, off_t offset, GError **);
+
 int gfal_plugin_mock_close(plugin_handle, gfal_file_handle fd, GError **);
 
 off_t gfal_plugin_mock_seek(plugin_handle, gfal_file_handle fd,
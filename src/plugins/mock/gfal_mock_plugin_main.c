@@ -113,6 +113,17 @@ long long gfal_plugin_mock_get_int_from_str(const char *buff)
 }
 
 
+void gfal_plugin_mock_delay_us(const char *url, const char *key)
+{
+    char arg_buffer[64] = {0};
+    gfal_plugin_mock_get_value(url, key, arg_buffer, sizeof(arg_buffer));
+    long long delay = gfal_plugin_mock_get_int_from_str(arg_buffer);
+    if (delay > 0) {
+        g_usleep(delay);
+    }
+}
+
+
 gboolean gfal_plugin_mock_check_url_transfer(plugin_handle handle, gfal2_context_t ctx, const char *src,
     const char *dst, gfal_url2_check type)
 {
@@ -178,6 +189,9 @@ gfal_plugin_interface gfal_plugin_init(gfal2_context_t handle, GError **err)
     MockPluginData *mdata = calloc(1, sizeof(MockPluginData));
     mdata->handle = handle;
     mdata->enable_signals = gfal2_get_opt_boolean_with_default(handle, "MOCK PLUGIN", "SIGNALS", FALSE);
+    mdata->bandwidth = gfal2_get_opt_integer_with_default(handle, "MOCK PLUGIN", "BANDWIDTH", 0);
+    mdata->max_connections = gfal2_get_opt_integer_with_default(handle, "MOCK PLUGIN", "MAX_CONNECTIONS_PER_HOST", 0);
+    mdata->connection_timeout = gfal2_get_opt_integer_with_default(handle, "MOCK PLUGIN", "CONNECTION_TIMEOUT", 60);
 
     if (mdata->enable_signals) {
         gfal_mock_seppuku_hook();
@@ -219,6 +233,8 @@ gfal_plugin_interface gfal_plugin_init(gfal2_context_t handle, GError **err)
     mock_plugin.closeG = gfal_plugin_mock_close;
     mock_plugin.readG = gfal_plugin_mock_read;
     mock_plugin.writeG = gfal_plugin_mock_write;
+    mock_plugin.preadG = gfal_plugin_mock_pread;
+    mock_plugin.pwriteG = gfal_plugin_mock_pwrite;
     mock_plugin.lseekG = gfal_plugin_mock_seek;
 
     return mock_plugin;
@@ -32,10 +32,53 @@ static gboolean gfal_plugin_mock_checksum_verify(const char *chk1, const char *c
 }
 
 
+// Granularity of the simulated transfer, for cancellation and errors
+#define GFAL_MOCK_TRANSFER_TICK_US (100 * 1000)
+
+
 static void gfal_mock_cancel_transfer(gfal2_context_t context, void *userdata)
 {
-    int *seconds = (int *) userdata;
-    *seconds = -10;
+    int *cancelled = (int *) userdata;
+    *cancelled = 1;
+}
+
+
+// Duration of the transfer, in microseconds
+static gint64 gfal_mock_transfer_duration(MockPluginData *mdata, gfal2_context_t context,
+    const char *src, const char *dst)
+{
+    char arg_buffer[GFAL_URL_MAX_LEN] = {0};
+
+    // check if the duration is specified in destination
+    gfal_plugin_mock_get_value(dst, "time", arg_buffer, sizeof(arg_buffer));
+    if (arg_buffer[0] != '\0') {
+        return (gint64)atoi(arg_buffer) * G_USEC_PER_SEC;
+    }
+
+    // or derive it from the size and the bandwidth, the slowest of both ends
+    long long bandwidth = 0;
+    gfal_plugin_mock_get_value(dst, "bandwidth", arg_buffer, sizeof(arg_buffer));
+    bandwidth = gfal_plugin_mock_get_int_from_str(arg_buffer);
+    gfal_plugin_mock_get_value(src, "bandwidth", arg_buffer, sizeof(arg_buffer));
+    long long src_bandwidth = gfal_plugin_mock_get_int_from_str(arg_buffer);
+    if (src_bandwidth > 0 && (bandwidth <= 0 || src_bandwidth < bandwidth)) {
+        bandwidth = src_bandwidth;
+    }
+    if (bandwidth <= 0) {
+        bandwidth = mdata->bandwidth;
+    }
+    if (bandwidth > 0) {
+        gfal_plugin_mock_get_value(src, "size", arg_buffer, sizeof(arg_buffer));
+        long long size = gfal_plugin_mock_get_int_from_str(arg_buffer);
+        return (gint64)((double)size * G_USEC_PER_SEC / bandwidth);
+    }
+
+    // get the range from configuration file
+    int max = gfal2_get_opt_integer_with_default(context, "MOCK PLUGIN", "MAX_TRANSFER_TIME", 100);
+    int min = gfal2_get_opt_integer_with_default(context, "MOCK PLUGIN", "MIN_TRANSFER_TIME", 10);
+    // determine the duration
+    if (max == min) return (gint64)max * G_USEC_PER_SEC;
+    return (gint64)(rand() % (max - min) + min) * G_USEC_PER_SEC;
 }
 
 
@@ -43,6 +86,7 @@ int gfal_plugin_mock_filecopy(plugin_handle plugin_data,
     gfal2_context_t context, gfalt_params_t params, const char *src,
     const char *dst, GError **err)
 {
+    MockPluginData *mdata = plugin_data;
     char checksum_type[GFAL_URL_MAX_LEN] = {0};
     char checksum_usr[GFAL_URL_MAX_LEN] = {0};
     char checksum_src[GFAL_URL_MAX_LEN] = {0};
@@ -54,78 +98,75 @@ int gfal_plugin_mock_filecopy(plugin_handle plugin_data,
 
     // validate source checksum
     if (checksum_method & GFALT_CHECKSUM_SOURCE) {
-        gfal_plugin_mock_get_value(src, "checksum", checksum_src, sizeof(checksum_src));
+        if (gfal_plugin_mock_get_checksum(src, checksum_type, 0, 0, checksum_src, sizeof(checksum_src), err) < 0) {
+            return -1;
+        }
         if (!gfal_plugin_mock_checksum_verify(checksum_usr, checksum_src)) {
             gfal_plugin_mock_report_error("User and source checksums do not match", EIO, err);
             return -1;
         }
     }
 
-    // transfer duration
-    int seconds = 0;
-
-    // check if the duration is specified in destination
-    char time_dst[GFAL_URL_MAX_LEN] = {0};
-    gfal_plugin_mock_get_value(dst, "time", time_dst, sizeof(time_dst));
-
-    if (time_dst[0] != '\0') {
-        // get the value from destination
-        seconds = atoi(time_dst);
-    }
-    else {
-        // get the range from configuration file
-        int max = gfal2_get_opt_integer_with_default(context, "MOCK PLUGIN", "MAX_TRANSFER_TIME", 100);
-        int min = gfal2_get_opt_integer_with_default(context, "MOCK PLUGIN", "MIN_TRANSFER_TIME", 10);
-        // determine the duration
-        if (max == min) seconds = max;
-        else seconds = rand() % (max - min) + min;
-    }
-
     // Trigger an error on the transfer?
     char transfer_errno_buffer[64] = {0};
     gfal_plugin_mock_get_value(dst, "transfer_errno", transfer_errno_buffer, sizeof(transfer_errno_buffer));
     int transfer_errno = gfal_plugin_mock_get_int_from_str(transfer_errno_buffer);
+    if (transfer_errno) {
+        gfal_plugin_mock_report_error(strerror(transfer_errno), transfer_errno, err);
+        return -1;
+    }
+
+    // transfer duration
+    gint64 duration = gfal_mock_transfer_duration(mdata, context, src, dst);
+
+    // both ends hold a connection during the transfer
+    if (gfal_plugin_mock_connection_acquire(mdata, src, err) < 0) {
+        return -1;
+    }
+    if (gfal_plugin_mock_connection_acquire(mdata, dst, err) < 0) {
+        gfal_plugin_mock_connection_release(src);
+        return -1;
+    }
 
     // mock transfer duration
+    int cancelled = 0;
     gfal_cancel_token_t cancel_token;
     cancel_token = gfal2_register_cancel_callback(context,
-        gfal_mock_cancel_transfer, &seconds);
+        gfal_mock_cancel_transfer, &cancelled);
 
 
     plugin_trigger_event(params, gfal2_get_plugin_mock_quark(), GFAL_EVENT_NONE,
-        GFAL_EVENT_TRANSFER_ENTER, "Mock copy start, sleep %d", seconds);
+        GFAL_EVENT_TRANSFER_ENTER, "Mock copy start, sleep %" G_GINT64_FORMAT " us", duration);
     plugin_trigger_event(params, gfal2_get_plugin_mock_quark(),
         GFAL_EVENT_NONE, GFAL_EVENT_TRANSFER_TYPE, "mock");
 
-    while (seconds > 0) {
-        sleep(1);
-        --seconds;
-
-        // Fail here
-        if (transfer_errno) {
-            gfal_plugin_mock_report_error(strerror(transfer_errno), transfer_errno, err);
-            break;
-        }
+    while (duration > 0 && !cancelled) {
+        gint64 tick = MIN(duration, GFAL_MOCK_TRANSFER_TICK_US);
+        g_usleep(tick);
+        duration -= tick;
     }
     plugin_trigger_event(params, gfal2_get_plugin_mock_quark(), GFAL_EVENT_NONE,
-        GFAL_EVENT_TRANSFER_EXIT, "Mock copy start, sleep %d", seconds);
+        GFAL_EVENT_TRANSFER_EXIT, "Mock copy start, sleep %" G_GINT64_FORMAT " us", duration);
 
     gfal2_remove_cancel_callback(context, cancel_token);
+    gfal_plugin_mock_connection_release(dst);
+    gfal_plugin_mock_connection_release(src);
 
     // Canceled?
-    if (seconds < 0) {
+    if (cancelled) {
         gfal_plugin_mock_report_error("Transfer canceled", ECANCELED, err);
         return -1;
     }
 
     // Jump over to the destination stat
-    MockPluginData *mdata = plugin_data;
     mdata->stat_stage = STAT_DESTINATION_AFTER_TRANSFER;
 
     // validate destination checksum
     if (!*err && (checksum_method & GFALT_CHECKSUM_TARGET)) {
         char checksum_dst[GFAL_URL_MAX_LEN] = {0};
-        gfal_plugin_mock_get_value(dst, "checksum", checksum_dst, sizeof(checksum_dst));
+        if (gfal_plugin_mock_get_checksum(dst, checksum_type, 0, 0, checksum_dst, sizeof(checksum_dst), err) < 0) {
+            return -1;
+        }
 
         if (checksum_method & GFALT_CHECKSUM_SOURCE) {
             if (!gfal_plugin_mock_checksum_verify(checksum_src, checksum_dst)) {
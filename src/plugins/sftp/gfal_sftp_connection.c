@@ -18,7 +18,9 @@
 #include <uri/gfal2_uri.h>
 #include <netdb.h>
 #include <arpa/inet.h>
+#include <errno.h>
 #include <pwd.h>
+#include <string.h>
 
 // libssh2_session_handshake introduced with 1.2.8
 #if LIBSSH2_VERSION_NUM < 0x010208
@@ -225,11 +227,11 @@ static int gfal_sftp_authn(gfal_sftp_context_t *data, gfal2_uri *parsed, gfal_sf
 }
 
 
-static gfal_sftp_handle_t *gfal_sftp_new_handle(gfal_sftp_context_t *data, gfal2_uri *parsed, GError **err)
+gfal_sftp_handle_t *gfal_sftp_new_handle(gfal_sftp_context_t *data, gfal2_uri *parsed, GError **err)
 {
     int rc;
 
-    gfal_sftp_handle_t *handle = g_malloc(sizeof(gfal_sftp_handle_t));
+    gfal_sftp_handle_t *handle = g_new0(gfal_sftp_handle_t, 1);
     handle->host = g_strdup(parsed->host);
     handle->port = parsed->port;
     handle->sock = gfal_sftp_socket(parsed, err);
@@ -263,116 +265,53 @@ static gfal_sftp_handle_t *gfal_sftp_new_handle(gfal_sftp_context_t *data, gfal2
     gfal2_log(G_LOG_LEVEL_DEBUG, "SFTP initialized");
 
     libssh2_session_set_blocking(handle->ssh_session, 1);
+#if LIBSSH2_VERSION_NUM >= 0x010205
+    // Without this, libssh2_keepalive_send does nothing
+    libssh2_keepalive_config(handle->ssh_session, 1,
+        gfal2_get_opt_integer_with_default(data->gfal2_context, "SFTP PLUGIN", "KEEPALIVE_INTERVAL", 30));
+#endif
 
     return handle;
 
     get_handle_failure_ssh:
     gfal_plugin_sftp_translate_error(__func__, handle, err);
     get_handle_failure:
+    if (handle->ssh_session) {
+        libssh2_session_free(handle->ssh_session);
+    }
+    if (handle->sock >= 0) {
+        close(handle->sock);
+    }
+    g_free((char*)handle->host);
     g_free(handle);
     return NULL;
 }
 
 
-static void gfal_sftp_destroy_handle(gfal_sftp_handle_t *handle, gpointer user_data)
+void gfal_sftp_destroy_handle(gfal_sftp_handle_t *handle)
 {
     close(handle->sock);
     libssh2_sftp_shutdown(handle->sftp_session);
     libssh2_session_disconnect(handle->ssh_session, "");
     libssh2_session_free(handle->ssh_session);
+    g_free((char*)handle->host);
+    g_free((char*)handle->path);
     g_free(handle);
 }
 
 
-gfal_sftp_handle_t *gfal_sftp_connect(gfal_sftp_context_t *context, const char *url, GError **err)
+gboolean gfal_sftp_handle_alive(gfal_sftp_handle_t *handle)
 {
-    gfal2_uri *parsed = gfal2_parse_uri(url, err);
-    if (!parsed) {
-        return NULL;
-    }
-
-    gfal_sftp_handle_t *handle = gfal_sftp_cache_pop(context->cache, parsed->host, parsed->port);
-    if (!handle) {
-        gfal2_log(G_LOG_LEVEL_DEBUG, "Creating new SFTP handle");
-        handle = gfal_sftp_new_handle(context, parsed, err);
-    } else {
 #if LIBSSH2_VERSION_NUM >= 0x010205
-        int seconds = 10;
-        gfal2_log(G_LOG_LEVEL_DEBUG, "Reusing SFTP handle from cache for %s:%d", handle->host, handle->port);
-        int rc = libssh2_keepalive_send(handle->ssh_session, &seconds);
-        if (rc < 0) {
-            gfal2_log(G_LOG_LEVEL_DEBUG, "Recycled SFTP handle failed to send keepalive. Discard and reconnect");
-            gfal_sftp_destroy_handle(handle, NULL);
-            handle = gfal_sftp_new_handle(context, parsed, err);
-        }
+    int seconds = 0;
+    return libssh2_keepalive_send(handle->ssh_session, &seconds) == 0;
+#else
+    return TRUE;
 #endif
-    }
-    if (handle) {
-        handle->path = g_strdup(parsed->path);
-    }
-
-    gfal2_free_uri(parsed);
-    return handle;
-}
-
-
-void gfal_sftp_release(gfal_sftp_context_t *context, gfal_sftp_handle_t *handle)
-{
-    gfal2_log(G_LOG_LEVEL_DEBUG, "Pushing SFTP handle into cache for %s:%d", handle->host, handle->port);
-    gfal_sftp_cache_push(context->cache, handle);
-}
-
-
-static void gfal_sftpdestroy_key(gpointer p)
-{
-    g_string_free((GString*)p, TRUE);
-}
-
-
-GHashTable *gfal_sftp_cache_new()
-{
-    return g_hash_table_new_full((GHashFunc) g_string_hash, (GEqualFunc) g_string_equal,
-        gfal_sftpdestroy_key, NULL);
-}
-
-
-gfal_sftp_handle_t *gfal_sftp_cache_pop(GHashTable *cache, const char *host, int port)
-{
-    GString *key = g_string_new(NULL);
-    g_string_printf(key, "%s:%d", host, port);
-    GSList *list = (GSList*)g_hash_table_lookup(cache, key);
-    if (!list) {
-        g_string_free(key, TRUE);
-        return NULL;
-    }
-    gfal_sftp_handle_t *handle = (gfal_sftp_handle_t*)list->data;
-    list = g_slist_delete_link(list, list);
-    // g_hash_table_insert acquires ownership of key
-    g_hash_table_insert(cache, key, list);
-    return handle;
-}
-
-
-void gfal_sftp_cache_push(GHashTable *cache, gfal_sftp_handle_t *handle)
-{
-    GString *key = g_string_new(NULL);
-    g_string_printf(key, "%s:%d", handle->host, handle->port);
-    GSList *list = (GSList*)g_hash_table_lookup(cache, key);
-    list = g_slist_prepend(list, handle);
-    // g_hash_table_insert acquires ownership of key
-    g_hash_table_insert(cache, key, list);
-}
-
-
-void gfal_sftp_destroy_cache_entry(gpointer key, gpointer value, gpointer user_data)
-{
-    g_slist_foreach((GSList*)value, (GFunc)gfal_sftp_destroy_handle, NULL);
-    g_slist_free((GSList*)value);
 }
 
 
-void gfal_sftp_cache_destroy(GHashTable *cache)
+gint64 gfal_sftp_monotonic_time(void)
 {
-    g_hash_table_foreach(cache, gfal_sftp_destroy_cache_entry, NULL);
-    g_hash_table_destroy(cache);
+    return g_get_monotonic_time();
 }
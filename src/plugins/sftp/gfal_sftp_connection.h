@@ -18,6 +18,10 @@
 #define GFAL_SFTP_CONNECTION_H
 
 #include "gfal_sftp_plugin.h"
+#include <uri/gfal2_uri.h>
+
+/// SSH session pool, see gfal_sftp_pool.c
+typedef struct gfal_sftp_handle_cache_s gfal_sftp_handle_cache_t;
 
 /// Wraps a connection plus a session to a remote SSH server
 struct gfal_sftp_handle_s {
@@ -27,19 +31,17 @@ struct gfal_sftp_handle_s {
     const char *host;
     int port;
     const char *path;
+    // Slot of the endpoint while the handle is in use
+    gfal2_endpoint_slot_t slot;
+    // Pool the handle goes back to
+    gfal_sftp_handle_cache_t *cache;
 };
 typedef struct gfal_sftp_handle_s gfal_sftp_handle_t;
 
-/// SSH session cache
-struct gfal_sftp_handle_cache_s {
-    GHashTable *caches;
-};
-typedef struct gfal_sftp_handle_cache_s gfal_sftp_handle_cache_t;
-
 /// Plugin internal data
 struct gfal_sftp_context_s {
     gfal2_context_t gfal2_context;
-    GHashTable *cache;
+    gfal_sftp_handle_cache_t *cache;
 };
 typedef struct gfal_sftp_context_s gfal_sftp_context_t;
 
@@ -49,34 +51,51 @@ typedef struct gfal_sftp_context_s gfal_sftp_context_t;
 /// @param[out] err This GError will be filled up with the error message and code
 void gfal_plugin_sftp_translate_error(const char *func, gfal_sftp_handle_t *handle, GError **err);
 
-/// Returns a new handle wrapping a connection to the remote endpoint
+/// Returns a handle wrapping a connection to the remote endpoint, taken from the pool
+/// if there is an idle one. If MAX_SESSIONS_PER_HOST handles are in use, waits for one to be released.
 /// @param context  The SFTP context
 /// @param url      Full URL (sftp://host:port/path) to which to connect
 /// @param[out] err Any error will be put here
 /// @return         NULL on error
 gfal_sftp_handle_t *gfal_sftp_connect(gfal_sftp_context_t *context, const char *url, GError **err);
 
-/// Releases a handle
-/// @param context      The SFTP context
+/// Same as gfal_sftp_connect, but fails with EBUSY instead of waiting when
+/// the pool is already at its limit for the remote host
+gfal_sftp_handle_t *gfal_sftp_try_connect(gfal_sftp_context_t *context, const char *url, GError **err);
+
+/// Releases a handle to the pool it was taken from
+/// @param context      The SFTP context. Not used, the handle may outlive it, see gfal_sftp_cache_destroy
 /// @param handle       The handle we are done with
 void gfal_sftp_release(gfal_sftp_context_t *context, gfal_sftp_handle_t *handle);
 
-/// Creates a new GHashTable that models a connection cache
-GHashTable *gfal_sftp_cache_new();
+/// Creates a new session pool, and starts its maintenance thread
+/// @param context  The SFTP context, used to read the configuration and to open sessions in advance
+gfal_sftp_handle_cache_t *gfal_sftp_cache_new(gfal_sftp_context_t *context);
+
+/// Same as gfal_sftp_cache_new, without the maintenance thread: gfal_sftp_cache_maintenance
+/// has to be called instead. Used by the tests.
+gfal_sftp_handle_cache_t *gfal_sftp_cache_new_manual(gfal_sftp_context_t *context);
+
+/// Stops the maintenance thread and closes the idle connections, without waiting for the handles in use.
+/// Those are closed by gfal_sftp_release, which frees the pool with the last one,
+/// so the SFTP context can be freed right after this call.
+void gfal_sftp_cache_destroy(gfal_sftp_handle_cache_t *cache);
+
+/// Sends the keepalives, closes the idle handles and opens the sessions in advance that are due.
+/// Run by the maintenance thread.
+void gfal_sftp_cache_maintenance(gfal_sftp_handle_cache_t *cache);
+
+/// Opens a new connection and SFTP session, outside of the pool
+gfal_sftp_handle_t *gfal_sftp_new_handle(gfal_sftp_context_t *context, gfal2_uri *parsed, GError **err);
 
-/// Gets a handle from the cache
-/// @param cache    An initialized cache
-/// @param host     The remote host
-/// @param port     The remote port
-/// @return         NULL if there is no cached entry
-gfal_sftp_handle_t *gfal_sftp_cache_pop(GHashTable *cache, const char *host, int port);
+/// Closes the session and the connection of a handle
+void gfal_sftp_destroy_handle(gfal_sftp_handle_t *handle);
 
-/// Puts a handle back to the cache
-/// @param handle   The handle to release
-void gfal_sftp_cache_push(GHashTable *cache, gfal_sftp_handle_t *handle);
+/// Checks with a keepalive that a handle that has been idle is still usable
+gboolean gfal_sftp_handle_alive(gfal_sftp_handle_t *handle);
 
-/// Frees memory and closes connections
-void gfal_sftp_cache_destroy(GHashTable *cache);
+/// Clock of the pool, g_get_monotonic_time
+gint64 gfal_sftp_monotonic_time(void);
 
 
 #endif // GFAL_SFTP_CONNECTION_H
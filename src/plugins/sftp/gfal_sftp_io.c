@@ -14,6 +14,8 @@
  * limitations under the License.
  */
 
+#include <pthread.h>
+#include <string.h>
 #include "gfal_sftp_plugin.h"
 #include "gfal_sftp_connection.h"
 
@@ -23,14 +25,61 @@
 #   define libssh2_sftp_seek64 libssh2_sftp_seek
 #endif
 
+// Largest payload libssh2 puts into a single SFTP read or write request
+#define GFAL_SFTP_PACKET_SIZE 30000
+
+
+/// Additional session used to stripe big reads and writes
+struct gfal_sftp_stripe_s {
+    gfal_sftp_handle_t *sftp_handle;
+    LIBSSH2_SFTP_HANDLE *file_handle;
+};
+typedef struct gfal_sftp_stripe_s gfal_sftp_stripe_t;
+
 
 struct gfal_sftp_file_s {
     gfal_sftp_handle_t *sftp_handle;
     LIBSSH2_SFTP_HANDLE *file_handle;
+    char *url;
+    int flags;
+    // Offset as seen by the caller. The remote handle is ahead while there is read-ahead data.
+    off_t offset;
+    gboolean reading;
+    gboolean eof;
+    // Read-ahead ring buffer
+    char *rbuffer;
+    size_t rsize, rstart, rfill;
+    // Read left pending by the non-blocking mode, to be retried with the same position and length
+    gboolean rpending;
+    size_t rpending_at, rpending_len;
+    // Write-behind buffer
+    char *wbuffer;
+    size_t wsize, wfill;
+    // Failure to send the buffered writes from a read or a seek, reported by the next write or close
+    GError *werror;
+    // Striping
+    size_t stripe_threshold;
+    int nstripes;
+    int nstripes_open;
+    gfal_sftp_stripe_t *stripes;
 };
 typedef struct gfal_sftp_file_s gfal_sftp_file_t;
 
 
+/// One range of a striped transfer
+struct gfal_sftp_stripe_job_s {
+    gfal_sftp_handle_t *sftp_handle;
+    LIBSSH2_SFTP_HANDLE *file_handle;
+    char *buffer;
+    off_t offset;
+    size_t count;
+    gboolean write;
+    ssize_t done;
+    GError *error;
+};
+typedef struct gfal_sftp_stripe_job_s gfal_sftp_stripe_job_t;
+
+
 static unsigned long gfal_sftp_std2ssh2_open_flags(int flag)
 {
     unsigned long ssh2_flags = 0;
@@ -56,6 +105,359 @@ static unsigned long gfal_sftp_std2ssh2_open_flags(int flag)
 }
 
 
+static void gfal_sftp_io_configure(gfal_sftp_context_t *data, gfal_sftp_file_t *fd)
+{
+    int depth = gfal2_get_opt_integer_with_default(data->gfal2_context, "SFTP PLUGIN", "PIPELINE_DEPTH", 32);
+    if (depth < 1) {
+        depth = 1;
+    }
+    fd->rsize = fd->wsize = depth * GFAL_SFTP_PACKET_SIZE;
+
+    // Striping opens additional sessions to the host, so it must be asked for
+    fd->nstripes = gfal2_get_opt_integer_with_default(data->gfal2_context, "SFTP PLUGIN", "STRIPE_SESSIONS", 1);
+    fd->stripe_threshold = gfal2_get_opt_integer_with_default(data->gfal2_context, "SFTP PLUGIN", "STRIPE_THRESHOLD",
+        4194304);
+    if (fd->nstripes < 1) {
+        fd->nstripes = 1;
+    }
+}
+
+
+// Read count bytes, or until EOF, starting at the current position of the handle.
+// libssh2 keeps requests in flight for up to four times the size of the buffer it is given, so when
+// the range is bounded (taper), the size asked for shrinks with what is left, to avoid requesting data past it.
+static ssize_t gfal_sftp_read_range(gfal_sftp_handle_t *sftp_handle, LIBSSH2_SFTP_HANDLE *file_handle,
+    char *buffer, size_t count, gboolean taper, GError **err)
+{
+    size_t done = 0;
+    while (done < count) {
+        size_t ask = count - done;
+        if (taper) {
+            ask = MIN(ask, MAX(ask / 4, GFAL_SFTP_PACKET_SIZE));
+        }
+        ssize_t rc = libssh2_sftp_read(file_handle, buffer + done, ask);
+        if (rc < 0) {
+            gfal_plugin_sftp_translate_error(__func__, sftp_handle, err);
+            return -1;
+        } else if (rc == 0) {
+            break;
+        }
+        done += rc;
+    }
+    return done;
+}
+
+
+// libssh2 sends the whole buffer as a train of write requests, and returns as soon as the first ones are
+// acknowledged. The remaining requests are still in flight, so calling again with the rest of the buffer
+// does not send the data twice.
+// See https://www.libssh2.org/libssh2_sftp_write.html
+static ssize_t gfal_sftp_write_range(gfal_sftp_handle_t *sftp_handle, LIBSSH2_SFTP_HANDLE *file_handle,
+    const char *buffer, size_t count, GError **err)
+{
+    size_t done = 0;
+    while (done < count) {
+        ssize_t rc = libssh2_sftp_write(file_handle, buffer + done, count - done);
+        if (rc < 0) {
+            gfal_plugin_sftp_translate_error(__func__, sftp_handle, err);
+            return -1;
+        } else if (rc == 0) {
+            gfal2_set_error(err, gfal2_get_plugin_sftp_quark(), EIO, __func__,
+                "Short write: %zu bytes out of %zu", done, count);
+            return -1;
+        }
+        done += rc;
+    }
+    return done;
+}
+
+
+// Move up to count bytes from the read-ahead ring into buffer
+static size_t gfal_sftp_ring_consume(gfal_sftp_file_t *fd, char *buffer, size_t count)
+{
+    size_t done = 0;
+    while (done < count && fd->rfill > 0) {
+        size_t chunk = MIN(count - done, MIN(fd->rfill, fd->rsize - fd->rstart));
+        memcpy(buffer + done, fd->rbuffer + fd->rstart, chunk);
+        fd->rstart = (fd->rstart + chunk) % fd->rsize;
+        fd->rfill -= chunk;
+        done += chunk;
+    }
+    // A pending read still expects its position in the ring
+    if (fd->rfill == 0 && !fd->rpending) {
+        fd->rstart = 0;
+    }
+    fd->offset += done;
+    return done;
+}
+
+
+// Fill the free space of the read-ahead ring.
+// The first read blocks until some data arrives. The session is then switched to non-blocking mode to
+// pick up whatever answers to the outstanding requests are already there, without waiting for the rest,
+// which remain in flight for the next call.
+// libssh2 requires a read that returned EAGAIN to be called again with the same buffer and length,
+// so its place in the ring is kept until it completes.
+static int gfal_sftp_ring_fill(gfal_sftp_file_t *fd, GError **err)
+{
+    LIBSSH2_SESSION *ssh_session = fd->sftp_handle->ssh_session;
+    int blocking = 1;
+    int ret = 0;
+
+    if (!fd->rbuffer) {
+        fd->rbuffer = g_malloc(fd->rsize);
+    }
+
+    while (fd->rfill < fd->rsize && !fd->eof) {
+        size_t tail = (fd->rstart + fd->rfill) % fd->rsize;
+        size_t free_space = (tail >= fd->rstart) ? fd->rsize - tail : fd->rstart - tail;
+        if (fd->rpending) {
+            tail = fd->rpending_at;
+            free_space = fd->rpending_len;
+        }
+
+        ssize_t rc = libssh2_sftp_read(fd->file_handle, fd->rbuffer + tail, free_space);
+        if (rc == LIBSSH2_ERROR_EAGAIN) {
+            fd->rpending = TRUE;
+            fd->rpending_at = tail;
+            fd->rpending_len = free_space;
+            break;
+        }
+        fd->rpending = FALSE;
+        if (rc < 0) {
+            gfal_plugin_sftp_translate_error(__func__, fd->sftp_handle, err);
+            ret = -1;
+            break;
+        } else if (rc == 0) {
+            fd->eof = TRUE;
+        } else {
+            fd->rfill += rc;
+        }
+
+        if (blocking) {
+            libssh2_session_set_blocking(ssh_session, 0);
+            blocking = 0;
+        }
+    }
+
+    if (!blocking) {
+        libssh2_session_set_blocking(ssh_session, 1);
+    }
+    return ret;
+}
+
+
+// Complete the pending read, if any, before the handle is used for anything else
+static int gfal_sftp_ring_settle(gfal_sftp_file_t *fd, GError **err)
+{
+    if (!fd->rpending) {
+        return 0;
+    }
+    ssize_t rc = libssh2_sftp_read(fd->file_handle, fd->rbuffer + fd->rpending_at, fd->rpending_len);
+    fd->rpending = FALSE;
+    if (rc < 0) {
+        gfal_plugin_sftp_translate_error(__func__, fd->sftp_handle, err);
+        return -1;
+    } else if (rc == 0) {
+        fd->eof = TRUE;
+    } else {
+        fd->rfill += rc;
+    }
+    return 0;
+}
+
+
+// Drop the read-ahead and the requests still in flight, and put the remote handle where the caller expects it
+static void gfal_sftp_sync_offset(gfal_sftp_file_t *fd)
+{
+    // The data is dropped anyway, and a broken session fails the next call
+    gfal_sftp_ring_settle(fd, NULL);
+    fd->rstart = fd->rfill = 0;
+    fd->eof = FALSE;
+    fd->reading = FALSE;
+    libssh2_sftp_seek64(fd->file_handle, fd->offset);
+}
+
+
+static int gfal_sftp_flush(gfal_sftp_file_t *fd, GError **err)
+{
+    if (fd->wfill == 0) {
+        return 0;
+    }
+    ssize_t rc = gfal_sftp_write_range(fd->sftp_handle, fd->file_handle, fd->wbuffer, fd->wfill, err);
+    fd->wfill = 0;
+    return rc < 0 ? -1 : 0;
+}
+
+
+// Flush on behalf of a read or a seek. The writes were already acknowledged to the caller,
+// so a failure is also kept for the next write, or the close
+static int gfal_sftp_flush_behind(gfal_sftp_file_t *fd, GError **err)
+{
+    GError *tmp_err = NULL;
+    if (gfal_sftp_flush(fd, &tmp_err) < 0) {
+        if (!fd->werror) {
+            fd->werror = g_error_copy(tmp_err);
+        }
+        g_propagate_error(err, tmp_err);
+        return -1;
+    }
+    return 0;
+}
+
+
+// Report a failure of the buffered writes not seen by the writer yet
+static int gfal_sftp_write_behind_error(gfal_sftp_file_t *fd, GError **err)
+{
+    if (!fd->werror) {
+        return 0;
+    }
+    gfal2_propagate_prefixed_error(err, fd->werror, "Failed to write buffered data: ");
+    fd->werror = NULL;
+    return -1;
+}
+
+
+// Open, if not done yet, the additional sessions used for striping.
+// Returns the number of sessions available, including the main one
+static int gfal_sftp_open_stripes(gfal_sftp_context_t *data, gfal_sftp_file_t *fd)
+{
+    if (fd->nstripes < 2) {
+        return 1;
+    }
+    if (!fd->stripes) {
+        fd->stripes = g_new0(gfal_sftp_stripe_t, fd->nstripes - 1);
+    }
+
+    // The file already exists by now, so do not create nor truncate it again
+    unsigned long ssh2_flags = gfal_sftp_std2ssh2_open_flags(fd->flags & ~(O_CREAT | O_EXCL | O_TRUNC));
+
+    while (fd->nstripes_open < fd->nstripes - 1) {
+        GError *tmp_err = NULL;
+        gfal_sftp_handle_t *sftp_handle = gfal_sftp_try_connect(data, fd->url, &tmp_err);
+        if (!sftp_handle) {
+            gfal2_log(G_LOG_LEVEL_DEBUG, "Could not open an additional SFTP session, striping over %d: %s",
+                fd->nstripes_open + 1, tmp_err->message);
+            g_error_free(tmp_err);
+            break;
+        }
+        LIBSSH2_SFTP_HANDLE *file_handle = libssh2_sftp_open(sftp_handle->sftp_session, sftp_handle->path,
+            ssh2_flags, 0);
+        if (!file_handle) {
+            gfal2_log(G_LOG_LEVEL_DEBUG, "Could not open the file on an additional SFTP session, striping over %d",
+                fd->nstripes_open + 1);
+            gfal_sftp_release(data, sftp_handle);
+            break;
+        }
+        fd->stripes[fd->nstripes_open].sftp_handle = sftp_handle;
+        fd->stripes[fd->nstripes_open].file_handle = file_handle;
+        ++fd->nstripes_open;
+    }
+
+    // Do not try again on the next call
+    fd->nstripes = fd->nstripes_open + 1;
+    return fd->nstripes;
+}
+
+
+static void gfal_sftp_close_stripes(gfal_sftp_context_t *data, gfal_sftp_file_t *fd)
+{
+    int i;
+    for (i = 0; i < fd->nstripes_open; ++i) {
+        libssh2_sftp_close(fd->stripes[i].file_handle);
+        gfal_sftp_release(data, fd->stripes[i].sftp_handle);
+    }
+    g_free(fd->stripes);
+    fd->stripes = NULL;
+    fd->nstripes_open = 0;
+}
+
+
+static void *gfal_sftp_stripe_worker(void *arg)
+{
+    gfal_sftp_stripe_job_t *job = (gfal_sftp_stripe_job_t*)arg;
+
+    libssh2_sftp_seek64(job->file_handle, job->offset);
+    if (job->write) {
+        job->done = gfal_sftp_write_range(job->sftp_handle, job->file_handle, job->buffer, job->count,
+            &job->error);
+    }
+    else {
+        job->done = gfal_sftp_read_range(job->sftp_handle, job->file_handle, job->buffer, job->count, TRUE,
+            &job->error);
+    }
+    return NULL;
+}
+
+
+// Split the transfer of count bytes at the current offset in one contiguous range per session,
+// and run them in parallel
+static ssize_t gfal_sftp_striped(gfal_sftp_file_t *fd, int nstripes, char *buffer, size_t count,
+    gboolean write, GError **err)
+{
+    gfal_sftp_stripe_job_t jobs[nstripes];
+    pthread_t threads[nstripes];
+    gboolean started[nstripes];
+    size_t part = (count + nstripes - 1) / nstripes;
+    int i;
+
+    gfal2_log(G_LOG_LEVEL_DEBUG, "Striping %s of %zu bytes over %d SFTP sessions",
+        write ? "write" : "read", count, nstripes);
+
+    for (i = 0; i < nstripes; ++i) {
+        size_t start = MIN(count, i * part);
+        jobs[i].sftp_handle = (i == 0) ? fd->sftp_handle : fd->stripes[i - 1].sftp_handle;
+        jobs[i].file_handle = (i == 0) ? fd->file_handle : fd->stripes[i - 1].file_handle;
+        jobs[i].buffer = buffer + start;
+        jobs[i].offset = fd->offset + start;
+        jobs[i].count = MIN(part, count - start);
+        jobs[i].write = write;
+        jobs[i].done = 0;
+        jobs[i].error = NULL;
+        started[i] = FALSE;
+    }
+
+    for (i = 1; i < nstripes; ++i) {
+        started[i] = (pthread_create(&threads[i], NULL, gfal_sftp_stripe_worker, &jobs[i]) == 0);
+        if (!started[i]) {
+            gfal_sftp_stripe_worker(&jobs[i]);
+        }
+    }
+    gfal_sftp_stripe_worker(&jobs[0]);
+    for (i = 1; i < nstripes; ++i) {
+        if (started[i]) {
+            pthread_join(threads[i], NULL);
+        }
+    }
+
+    // For reads, only the data up to the first short stripe (EOF) counts
+    ssize_t total = 0;
+    gboolean short_stripe = FALSE;
+    for (i = 0; i < nstripes; ++i) {
+        if (jobs[i].error) {
+            if (total >= 0) {
+                g_propagate_error(err, jobs[i].error);
+                total = -1;
+            }
+            else {
+                g_error_free(jobs[i].error);
+            }
+        }
+        else if (total >= 0 && !short_stripe) {
+            total += jobs[i].done;
+            short_stripe = ((size_t)jobs[i].done < jobs[i].count);
+        }
+    }
+
+    if (total > 0) {
+        fd->offset += total;
+    }
+    gfal_sftp_sync_offset(fd);
+    fd->eof = !write && short_stripe;
+    return total;
+}
+
+
 gfal_file_handle gfal_sftp_open(plugin_handle plugin_data, const char *url, int flag, mode_t mode, GError **err)
 {
     gfal_sftp_context_t *data = (gfal_sftp_context_t*)plugin_data;
@@ -64,13 +466,17 @@ gfal_file_handle gfal_sftp_open(plugin_handle plugin_data, const char *url, int
         return NULL;
     }
 
-    gfal_sftp_file_t *fd = g_malloc(sizeof(gfal_sftp_file_t));
+    gfal_sftp_file_t *fd = g_new0(gfal_sftp_file_t, 1);
     fd->sftp_handle = sftp_handle;
+    fd->url = g_strdup(url);
+    fd->flags = flag;
+    gfal_sftp_io_configure(data, fd);
 
     fd->file_handle = libssh2_sftp_open(sftp_handle->sftp_session, sftp_handle->path,
         gfal_sftp_std2ssh2_open_flags(flag), mode);
     if (!fd->file_handle) {
         gfal_plugin_sftp_translate_error(__func__, sftp_handle, err);
+        g_free(fd->url);
         g_free(fd);
         gfal_sftp_release(data, sftp_handle);
         return NULL;
@@ -85,47 +491,130 @@ int gfal_sftp_close(plugin_handle plugin_data, gfal_file_handle fd, GError **err
     gfal_sftp_context_t *data = (gfal_sftp_context_t*)plugin_data;
     gfal_sftp_file_t *ssh_fd = gfal_file_handle_get_fdesc(fd);
 
+    // Errors on buffered writes are reported here, if not done yet
+    int ret = gfal_sftp_write_behind_error(ssh_fd, err);
+    if (ret == 0) {
+        ret = gfal_sftp_flush(ssh_fd, err);
+    }
+
+    gfal_sftp_close_stripes(data, ssh_fd);
     libssh2_sftp_close(ssh_fd->file_handle);
     gfal_sftp_release(data, ssh_fd->sftp_handle);
+    g_free(ssh_fd->rbuffer);
+    g_free(ssh_fd->wbuffer);
+    g_free(ssh_fd->url);
     g_free(ssh_fd);
 
     gfal_file_handle_delete(fd);
-    return 0;
+    return ret;
 }
 
 
 ssize_t gfal_sftp_read(plugin_handle plugin_data, gfal_file_handle fd, void *buff, size_t count, GError **err)
 {
+    gfal_sftp_context_t *data = (gfal_sftp_context_t*)plugin_data;
     gfal_sftp_file_t *ssh_fd = gfal_file_handle_get_fdesc(fd);
-    ssize_t read = 0;
-
-    // libssh2 may need to read in chunks
     char *buffer = (char*)buff;
-    do {
-        ssize_t rc = libssh2_sftp_read(ssh_fd->file_handle, buffer + read, count - read);
+    ssize_t rc;
+
+    if (gfal_sftp_flush_behind(ssh_fd, err) < 0) {
+        return -1;
+    }
+    ssh_fd->reading = TRUE;
+
+    size_t done = gfal_sftp_ring_consume(ssh_fd, buffer, count);
+    size_t left = count - done;
+    if (left == 0 || ssh_fd->eof) {
+        return done;
+    }
+
+    // The data of the pending read comes before anything read directly
+    if (ssh_fd->rpending && (left >= ssh_fd->stripe_threshold || left >= ssh_fd->rsize)) {
+        if (gfal_sftp_ring_settle(ssh_fd, err) < 0) {
+            return -1;
+        }
+        done += gfal_sftp_ring_consume(ssh_fd, buffer + done, left);
+        left = count - done;
+        if (left == 0 || ssh_fd->eof) {
+            return done;
+        }
+    }
+
+    // Big reads go straight into the caller buffer, striped if possible
+    if (left >= ssh_fd->stripe_threshold) {
+        int nstripes = gfal_sftp_open_stripes(data, ssh_fd);
+        if (nstripes > 1) {
+            rc = gfal_sftp_striped(ssh_fd, nstripes, buffer + done, left, FALSE, err);
+            if (rc < 0) {
+                return rc;
+            }
+            return done + rc;
+        }
+    }
+    if (left >= ssh_fd->rsize) {
+        rc = gfal_sftp_read_range(ssh_fd->sftp_handle, ssh_fd->file_handle, buffer + done, left, FALSE, err);
         if (rc < 0) {
-            gfal_plugin_sftp_translate_error(__func__, ssh_fd->sftp_handle, err);
             return rc;
-        } else if (rc == 0) {
-            break;
         }
-        read += rc;
-    } while (read < count);
+        ssh_fd->offset += rc;
+        ssh_fd->eof = ((size_t)rc < left);
+        return done + rc;
+    }
 
-    return read;
+    // Small reads are served from the read-ahead
+    while (done < count && !(ssh_fd->rfill == 0 && ssh_fd->eof)) {
+        if (ssh_fd->rfill == 0 && gfal_sftp_ring_fill(ssh_fd, err) < 0) {
+            return -1;
+        }
+        done += gfal_sftp_ring_consume(ssh_fd, buffer + done, count - done);
+    }
+    return done;
 }
 
 
 ssize_t gfal_sftp_write(plugin_handle plugin_data, gfal_file_handle fd, const void *buff, size_t count, GError **err)
 {
+    gfal_sftp_context_t *data = (gfal_sftp_context_t*)plugin_data;
     gfal_sftp_file_t *ssh_fd = gfal_file_handle_get_fdesc(fd);
-    ssize_t rc = libssh2_sftp_write(ssh_fd->file_handle, buff, count);
-    if (rc < 0) {
-        gfal_plugin_sftp_translate_error(__func__, ssh_fd->sftp_handle, err);
+    ssize_t rc;
+
+    if (gfal_sftp_write_behind_error(ssh_fd, err) < 0) {
+        return -1;
+    }
+    if (ssh_fd->reading) {
+        gfal_sftp_sync_offset(ssh_fd);
+    }
+
+    if (ssh_fd->wfill + count > ssh_fd->wsize && gfal_sftp_flush(ssh_fd, err) < 0) {
+        return -1;
+    }
+
+    // Big writes are sent directly, striped if possible
+    if (count >= ssh_fd->stripe_threshold && !(ssh_fd->flags & O_APPEND)) {
+        if (gfal_sftp_flush(ssh_fd, err) < 0) {
+            return -1;
+        }
+        int nstripes = gfal_sftp_open_stripes(data, ssh_fd);
+        if (nstripes > 1) {
+            return gfal_sftp_striped(ssh_fd, nstripes, (char*)buff, count, TRUE, err);
+        }
     }
-    // normally, one would expect to return the value from libssh2_sftp_write, but as it happens it may be
-    // shorter, but still the data is cached on the pipe.
-    // See https://www.libssh2.org/libssh2_sftp_write.html
+    if (count >= ssh_fd->wsize) {
+        rc = gfal_sftp_write_range(ssh_fd->sftp_handle, ssh_fd->file_handle, buff, count, err);
+        if (rc < 0) {
+            return rc;
+        }
+        ssh_fd->offset += rc;
+        return rc;
+    }
+
+    // Small writes are accumulated, and sent together once the buffer is full
+    if (!ssh_fd->wbuffer) {
+        ssh_fd->wbuffer = g_malloc(ssh_fd->wsize);
+    }
+    memcpy(ssh_fd->wbuffer + ssh_fd->wfill, buff, count);
+    ssh_fd->wfill += count;
+    ssh_fd->offset += count;
     return count;
 }
 
@@ -136,12 +625,16 @@ off_t gfal_sftp_seek(plugin_handle plugin_data, gfal_file_handle fd, off_t offse
     off_t absolute = 0;
     LIBSSH2_SFTP_ATTRIBUTES attrs;
 
+    if (gfal_sftp_flush_behind(ssh_fd, err) < 0) {
+        return -1;
+    }
+
     switch (whence) {
         case SEEK_SET:
             absolute = offset;
             break;
         case SEEK_CUR:
-            absolute = libssh2_sftp_tell64(ssh_fd->file_handle) + offset;
+            absolute = ssh_fd->offset + offset;
             break;
         case SEEK_END:
             if (libssh2_sftp_fstat(ssh_fd->file_handle, &attrs) < 0) {
@@ -150,6 +643,17 @@ off_t gfal_sftp_seek(plugin_handle plugin_data, gfal_file_handle fd, off_t offse
             }
             absolute = attrs.filesize + offset;
     }
-    libssh2_sftp_seek64(ssh_fd->file_handle, absolute);
+
+    // Moving forward within the read-ahead keeps the requests in flight
+    if (ssh_fd->reading && absolute >= ssh_fd->offset && (size_t)(absolute - ssh_fd->offset) <= ssh_fd->rfill) {
+        size_t skip = absolute - ssh_fd->offset;
+        ssh_fd->rstart = (ssh_fd->rstart + skip) % ssh_fd->rsize;
+        ssh_fd->rfill -= skip;
+        ssh_fd->offset = absolute;
+        return absolute;
+    }
+
+    ssh_fd->offset = absolute;
+    gfal_sftp_sync_offset(ssh_fd);
     return absolute;
 }
@@ -61,8 +61,9 @@ static gboolean gfal_sftp_check_url(plugin_handle handle, const char *url, plugi
 static void gfal_plugin_sftp_delete(plugin_handle plugin_data)
 {
     gfal_sftp_context_t *data = (gfal_sftp_context_t*)plugin_data;
+    // The pool does not keep a reference to data once destroyed, even with handles still in use
     gfal_sftp_cache_destroy(data->cache);
-    free(data);
+    g_free(data);
 }
 
 
@@ -73,7 +74,7 @@ gfal_plugin_interface gfal_plugin_init(gfal2_context_t context, GError **err)
 
     gfal_sftp_context_t *data = g_malloc(sizeof(gfal_sftp_context_t));
     data->gfal2_context = context;
-    data->cache = gfal_sftp_cache_new();
+    data->cache = gfal_sftp_cache_new(data);
 
     sftp_plugin.plugin_data = data;
     sftp_plugin.plugin_delete = gfal_plugin_sftp_delete;
@@ -0,0 +1,620 @@
+/*
+ * Copyright (c) CERN 2016
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "gfal_sftp_connection.h"
+#include <uri/gfal2_uri.h>
+#include <pthread.h>
+#include <string.h>
+#include <time.h>
+
+/*
+ * Session pool
+ *
+ * Handles are kept per host:port. Each host has a bounded number of sessions (idle, in use, or being
+ * opened), and callers wait for one to be released when the limit is reached.
+ * A maintenance thread sends keepalives on idle sessions, closes the ones idle for too long or found dead,
+ * and, if enabled, opens sessions in advance for hosts used recently, so the handshake and authentication
+ * are not paid by the next caller. It only wakes up when one of these is due.
+ * Each handle knows its pool, so a handle still in use when the plugin is unloaded can be released later:
+ * it is then closed, and the pool freed with the last one.
+ */
+
+// Delay before opening sessions in advance again for a host, after a failure, in seconds
+#define GFAL_SFTP_PREWARM_RETRY 5
+
+/// Idle handle in the pool
+struct gfal_sftp_pool_entry_s {
+    gfal_sftp_handle_t *handle;
+    gint64 idle_since;
+    // Last keepalive, or idle_since
+    gint64 checked_at;
+};
+typedef struct gfal_sftp_pool_entry_s gfal_sftp_pool_entry_t;
+
+/// Sessions to one host:port
+struct gfal_sftp_host_pool_s {
+    // Idle handles, most recently released first
+    GQueue idle;
+    // Handles in use
+    int busy;
+    // Handles being opened, or checked by the maintenance thread
+    int pending;
+    // Last time a handle was requested
+    gint64 last_used;
+    // Last URL used, to open sessions in advance with the same credentials
+    char *url;
+    // No sessions are opened in advance before, after a failure
+    gint64 prewarm_retry;
+};
+typedef struct gfal_sftp_host_pool_s gfal_sftp_host_pool_t;
+
+struct gfal_sftp_handle_cache_s {
+    gfal_sftp_context_t *context;
+    GHashTable *hosts;
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    pthread_t maintenance;
+    gboolean maintenance_started;
+    gboolean stop;
+    // When the maintenance thread runs next, 0 if it waits for a change of the pool
+    gint64 next_run;
+    // Destroyed while handles were in use, freed when the last one is released
+    gboolean orphaned;
+
+    int max_per_host;
+    int prewarm;
+    gint64 idle_timeout;
+    gint64 keepalive_interval;
+    gint64 prewarm_window;
+    gint64 wait_timeout;
+};
+
+
+static char *gfal_sftp_pool_key(const char *host, int port)
+{
+    return g_strdup_printf("%s:%d", host, port);
+}
+
+
+static void gfal_sftp_host_pool_free(gpointer p)
+{
+    gfal_sftp_host_pool_t *host_pool = (gfal_sftp_host_pool_t*)p;
+    gfal_sftp_pool_entry_t *entry;
+    while ((entry = g_queue_pop_head(&host_pool->idle)) != NULL) {
+        gfal_sftp_destroy_handle(entry->handle);
+        g_free(entry);
+    }
+    g_free(host_pool->url);
+    g_free(host_pool);
+}
+
+
+static gfal_sftp_host_pool_t *gfal_sftp_host_pool_get(gfal_sftp_handle_cache_t *cache, const char *host, int port)
+{
+    char *key = gfal_sftp_pool_key(host, port);
+    gfal_sftp_host_pool_t *host_pool = g_hash_table_lookup(cache->hosts, key);
+    if (!host_pool) {
+        host_pool = g_new0(gfal_sftp_host_pool_t, 1);
+        g_queue_init(&host_pool->idle);
+        // g_hash_table_insert acquires ownership of key
+        g_hash_table_insert(cache->hosts, key, host_pool);
+    }
+    else {
+        g_free(key);
+    }
+    return host_pool;
+}
+
+
+static int gfal_sftp_host_pool_size(gfal_sftp_host_pool_t *host_pool)
+{
+    return g_queue_get_length(&host_pool->idle) + host_pool->busy + host_pool->pending;
+}
+
+
+// Wake up the maintenance thread if it would sleep past "due". Called with the lock held.
+static void gfal_sftp_cache_schedule(gfal_sftp_handle_cache_t *cache, gint64 due)
+{
+    if (cache->next_run == 0 || due < cache->next_run) {
+        cache->next_run = due;
+        pthread_cond_signal(&cache->wake);
+    }
+}
+
+
+// When an idle handle has to be checked with a keepalive, or closed
+static gint64 gfal_sftp_pool_entry_due(gfal_sftp_handle_cache_t *cache, const gfal_sftp_pool_entry_t *entry)
+{
+    gint64 due = entry->idle_since + cache->idle_timeout * G_USEC_PER_SEC;
+    if (cache->keepalive_interval > 0) {
+        due = MIN(due, entry->checked_at + cache->keepalive_interval * G_USEC_PER_SEC);
+    }
+    return due;
+}
+
+
+// Whether sessions have to be opened in advance for the host. Called with the lock held.
+static gboolean gfal_sftp_cache_needs_prewarm(gfal_sftp_handle_cache_t *cache, gfal_sftp_host_pool_t *host_pool,
+    gint64 now)
+{
+    if (cache->prewarm <= 0 || !host_pool->url ||
+        now - host_pool->last_used >= cache->prewarm_window * G_USEC_PER_SEC) {
+        return FALSE;
+    }
+    int spare = g_queue_get_length(&host_pool->idle) + host_pool->pending;
+    return spare < cache->prewarm &&
+           (cache->max_per_host <= 0 || gfal_sftp_host_pool_size(host_pool) < cache->max_per_host);
+}
+
+
+// Take an idle handle, or reserve a place to open a new one.
+// The number of handles in use is limited by the slots of the endpoint. Called with the lock held.
+static gfal_sftp_handle_t *gfal_sftp_cache_pop(gfal_sftp_host_pool_t *host_pool)
+{
+    gfal_sftp_pool_entry_t *entry = g_queue_pop_head(&host_pool->idle);
+    ++host_pool->busy;
+    if (entry) {
+        gfal_sftp_handle_t *handle = entry->handle;
+        g_free(entry);
+        return handle;
+    }
+    return NULL;
+}
+
+
+// Number of handles in use, or being opened. Called with the lock held.
+static int gfal_sftp_cache_busy(gfal_sftp_handle_cache_t *cache)
+{
+    GHashTableIter iter;
+    gpointer key, value;
+    int busy = 0;
+
+    g_hash_table_iter_init(&iter, cache->hosts);
+    while (g_hash_table_iter_next(&iter, &key, &value)) {
+        gfal_sftp_host_pool_t *host_pool = (gfal_sftp_host_pool_t*)value;
+        busy += host_pool->busy + host_pool->pending;
+    }
+    return busy;
+}
+
+
+// Whether the pool has been destroyed, and its last handle is back, so it has to be freed by the caller.
+// Called with the lock held.
+static gboolean gfal_sftp_cache_orphan_done(gfal_sftp_handle_cache_t *cache)
+{
+    return cache->orphaned && gfal_sftp_cache_busy(cache) == 0;
+}
+
+
+static void gfal_sftp_cache_free(gfal_sftp_handle_cache_t *cache)
+{
+    g_hash_table_destroy(cache->hosts);
+    pthread_cond_destroy(&cache->wake);
+    pthread_mutex_destroy(&cache->lock);
+    g_free(cache);
+}
+
+
+// Put a handle back in the pool. Called with the lock held.
+static void gfal_sftp_cache_push(gfal_sftp_handle_cache_t *cache, gfal_sftp_host_pool_t *host_pool,
+    gfal_sftp_handle_t *handle)
+{
+    gfal_sftp_pool_entry_t *entry = g_new0(gfal_sftp_pool_entry_t, 1);
+    entry->handle = handle;
+    entry->idle_since = entry->checked_at = gfal_sftp_monotonic_time();
+    g_queue_push_head(&host_pool->idle, entry);
+    gfal_sftp_cache_schedule(cache, gfal_sftp_pool_entry_due(cache, entry));
+}
+
+
+static gfal_sftp_handle_t *gfal_sftp_connect_internal(gfal_sftp_context_t *context, const char *url,
+    gboolean wait, GError **err)
+{
+    gfal_sftp_handle_cache_t *cache = context->cache;
+    gfal2_endpoint_slot_t slot = NULL;
+    GError *tmp_err = NULL;
+
+    gfal2_uri *parsed = gfal2_parse_uri(url, err);
+    if (!parsed) {
+        return NULL;
+    }
+
+    // The sessions in use to a host, from all the contexts, share the queue of the endpoint
+    if (gfal2_endpoint_slot_acquire(context->gfal2_context, gfal_sftp_plugin_get_name(), url,
+            "MAX_SESSIONS_PER_HOST", cache->max_per_host, wait ? cache->wait_timeout : 0, &slot, &tmp_err) < 0) {
+        gfal2_free_uri(parsed);
+        g_propagate_error(err, tmp_err);
+        return NULL;
+    }
+
+    pthread_mutex_lock(&cache->lock);
+    gfal_sftp_host_pool_t *host_pool = gfal_sftp_host_pool_get(cache, parsed->host, parsed->port);
+    host_pool->last_used = gfal_sftp_monotonic_time();
+    if (!host_pool->url || strcmp(host_pool->url, url) != 0) {
+        g_free(host_pool->url);
+        host_pool->url = g_strdup(url);
+    }
+    gfal_sftp_handle_t *handle = gfal_sftp_cache_pop(host_pool);
+    if (gfal_sftp_cache_needs_prewarm(cache, host_pool, host_pool->last_used)) {
+        gfal_sftp_cache_schedule(cache, MAX(host_pool->last_used, host_pool->prewarm_retry));
+    }
+    pthread_mutex_unlock(&cache->lock);
+
+    if (handle) {
+        gfal2_log(G_LOG_LEVEL_DEBUG, "Reusing SFTP handle from cache for %s:%d", handle->host, handle->port);
+        if (!gfal_sftp_handle_alive(handle)) {
+            gfal2_log(G_LOG_LEVEL_DEBUG, "Recycled SFTP handle failed to send keepalive. Discard and reconnect");
+            gfal_sftp_destroy_handle(handle);
+            handle = NULL;
+        }
+    }
+    if (!handle) {
+        gfal2_log(G_LOG_LEVEL_DEBUG, "Creating new SFTP handle");
+        handle = gfal_sftp_new_handle(context, parsed, &tmp_err);
+        if (!handle) {
+            // Give back the place reserved by gfal_sftp_cache_pop
+            pthread_mutex_lock(&cache->lock);
+            --host_pool->busy;
+            gboolean last = gfal_sftp_cache_orphan_done(cache);
+            pthread_mutex_unlock(&cache->lock);
+            if (last) {
+                gfal_sftp_cache_free(cache);
+            }
+        }
+    }
+    if (handle) {
+        handle->cache = cache;
+        handle->path = g_strdup(parsed->path);
+        handle->slot = slot;
+    }
+    else {
+        gfal2_endpoint_slot_release(slot);
+        g_propagate_error(err, tmp_err);
+    }
+
+    gfal2_free_uri(parsed);
+    return handle;
+}
+
+
+gfal_sftp_handle_t *gfal_sftp_connect(gfal_sftp_context_t *context, const char *url, GError **err)
+{
+    return gfal_sftp_connect_internal(context, url, TRUE, err);
+}
+
+
+gfal_sftp_handle_t *gfal_sftp_try_connect(gfal_sftp_context_t *context, const char *url, GError **err)
+{
+    return gfal_sftp_connect_internal(context, url, FALSE, err);
+}
+
+
+void gfal_sftp_release(gfal_sftp_context_t *context, gfal_sftp_handle_t *handle)
+{
+    // Not context->cache: the plugin may have been unloaded while the handle was in use
+    gfal_sftp_handle_cache_t *cache = handle->cache;
+
+    g_free((char*)handle->path);
+    handle->path = NULL;
+
+    gfal2_endpoint_slot_t slot = handle->slot;
+    handle->slot = NULL;
+
+    pthread_mutex_lock(&cache->lock);
+    gfal_sftp_host_pool_t *host_pool = gfal_sftp_host_pool_get(cache, handle->host, handle->port);
+    --host_pool->busy;
+    gboolean orphaned = cache->orphaned;
+    if (!orphaned) {
+        gfal2_log(G_LOG_LEVEL_DEBUG, "Pushing SFTP handle into cache for %s:%d", handle->host, handle->port);
+        gfal_sftp_cache_push(cache, host_pool, handle);
+    }
+    gboolean last = gfal_sftp_cache_orphan_done(cache);
+    pthread_mutex_unlock(&cache->lock);
+
+    if (orphaned) {
+        gfal2_log(G_LOG_LEVEL_DEBUG, "SFTP session pool destroyed, closing handle for %s:%d", handle->host, handle->port);
+        gfal_sftp_destroy_handle(handle);
+    }
+    if (last) {
+        gfal_sftp_cache_free(cache);
+    }
+    gfal2_endpoint_slot_release(slot);
+}
+
+
+// Most recently released first
+static gint gfal_sftp_pool_entry_cmp(gconstpointer a, gconstpointer b, gpointer user_data)
+{
+    const gfal_sftp_pool_entry_t *ea = (const gfal_sftp_pool_entry_t*)a;
+    const gfal_sftp_pool_entry_t *eb = (const gfal_sftp_pool_entry_t*)b;
+    if (ea->idle_since > eb->idle_since) {
+        return -1;
+    }
+    return ea->idle_since < eb->idle_since;
+}
+
+
+/// Work done by the maintenance thread outside of the lock: check an idle handle, or open a new one
+struct gfal_sftp_pool_task_s {
+    gfal_sftp_host_pool_t *host_pool;
+    gfal_sftp_pool_entry_t *entry;
+    char *url;
+};
+typedef struct gfal_sftp_pool_task_s gfal_sftp_pool_task_t;
+
+
+// Take out of the pool the idle handles that need to be closed, or checked with a keepalive.
+// Called with the lock held.
+static void gfal_sftp_cache_collect_idle(gfal_sftp_handle_cache_t *cache, gfal_sftp_host_pool_t *host_pool,
+    gint64 now, GSList **to_check, GSList **to_destroy)
+{
+    GList *i = host_pool->idle.head;
+    while (i) {
+        GList *next = i->next;
+        gfal_sftp_pool_entry_t *entry = (gfal_sftp_pool_entry_t*)i->data;
+        if (now - entry->idle_since >= cache->idle_timeout * G_USEC_PER_SEC) {
+            g_queue_delete_link(&host_pool->idle, i);
+            *to_destroy = g_slist_prepend(*to_destroy, entry->handle);
+            g_free(entry);
+        }
+        else if (cache->keepalive_interval > 0 &&
+                 now - entry->checked_at >= cache->keepalive_interval * G_USEC_PER_SEC) {
+            gfal_sftp_pool_task_t *check = g_new0(gfal_sftp_pool_task_t, 1);
+            check->host_pool = host_pool;
+            check->entry = entry;
+            g_queue_delete_link(&host_pool->idle, i);
+            ++host_pool->pending;
+            *to_check = g_slist_prepend(*to_check, check);
+        }
+        i = next;
+    }
+}
+
+
+// Reserve slots for the sessions to open in advance. Called with the lock held.
+static void gfal_sftp_cache_collect_prewarm(gfal_sftp_handle_cache_t *cache, gfal_sftp_host_pool_t *host_pool,
+    gint64 now, GSList **to_open)
+{
+    if (now < host_pool->prewarm_retry) {
+        return;
+    }
+    while (gfal_sftp_cache_needs_prewarm(cache, host_pool, now)) {
+        gfal_sftp_pool_task_t *open = g_new0(gfal_sftp_pool_task_t, 1);
+        open->host_pool = host_pool;
+        open->url = g_strdup(host_pool->url);
+        ++host_pool->pending;
+        *to_open = g_slist_prepend(*to_open, open);
+    }
+}
+
+
+// When the maintenance thread has work to do next, 0 if none until the pool changes.
+// Called with the lock held.
+static gint64 gfal_sftp_cache_next_run(gfal_sftp_handle_cache_t *cache, gint64 now)
+{
+    GHashTableIter iter;
+    gpointer key, value;
+    gint64 next = 0;
+
+    g_hash_table_iter_init(&iter, cache->hosts);
+    while (g_hash_table_iter_next(&iter, &key, &value)) {
+        gfal_sftp_host_pool_t *host_pool = (gfal_sftp_host_pool_t*)value;
+        GList *i;
+        for (i = host_pool->idle.head; i != NULL; i = i->next) {
+            gint64 due = gfal_sftp_pool_entry_due(cache, (gfal_sftp_pool_entry_t*)i->data);
+            next = next ? MIN(next, due) : due;
+        }
+        if (gfal_sftp_cache_needs_prewarm(cache, host_pool, now)) {
+            gint64 due = MAX(now, host_pool->prewarm_retry);
+            next = next ? MIN(next, due) : due;
+        }
+    }
+    return next;
+}
+
+
+void gfal_sftp_cache_maintenance(gfal_sftp_handle_cache_t *cache)
+{
+    GSList *to_check = NULL, *to_destroy = NULL, *to_open = NULL, *i;
+    GHashTableIter iter;
+    gpointer key, value;
+    gint64 now = gfal_sftp_monotonic_time();
+
+    pthread_mutex_lock(&cache->lock);
+    g_hash_table_iter_init(&iter, cache->hosts);
+    while (g_hash_table_iter_next(&iter, &key, &value)) {
+        gfal_sftp_host_pool_t *host_pool = (gfal_sftp_host_pool_t*)value;
+        gfal_sftp_cache_collect_idle(cache, host_pool, now, &to_check, &to_destroy);
+        gfal_sftp_cache_collect_prewarm(cache, host_pool, now, &to_open);
+    }
+    pthread_mutex_unlock(&cache->lock);
+
+    // Network operations are done without holding the lock
+    for (i = to_check; i != NULL; i = i->next) {
+        gfal_sftp_pool_task_t *check = (gfal_sftp_pool_task_t*)i->data;
+        gboolean alive = gfal_sftp_handle_alive(check->entry->handle);
+
+        pthread_mutex_lock(&cache->lock);
+        --check->host_pool->pending;
+        if (alive) {
+            // Keep the order and the idle time, so the eviction is not delayed by the keepalive
+            check->entry->checked_at = gfal_sftp_monotonic_time();
+            g_queue_insert_sorted(&check->host_pool->idle, check->entry, gfal_sftp_pool_entry_cmp, NULL);
+        }
+        pthread_mutex_unlock(&cache->lock);
+
+        if (!alive) {
+            gfal2_log(G_LOG_LEVEL_DEBUG, "Idle SFTP handle for %s:%d is dead, discarding",
+                check->entry->handle->host, check->entry->handle->port);
+            to_destroy = g_slist_prepend(to_destroy, check->entry->handle);
+            g_free(check->entry);
+        }
+        g_free(check);
+    }
+    g_slist_free(to_check);
+
+    for (i = to_destroy; i != NULL; i = i->next) {
+        gfal_sftp_destroy_handle((gfal_sftp_handle_t*)i->data);
+    }
+    g_slist_free(to_destroy);
+
+    for (i = to_open; i != NULL; i = i->next) {
+        gfal_sftp_pool_task_t *open = (gfal_sftp_pool_task_t*)i->data;
+        gfal_sftp_handle_t *handle = NULL;
+        GError *tmp_err = NULL;
+
+        gfal2_uri *parsed = gfal2_parse_uri(open->url, &tmp_err);
+        if (parsed) {
+            gfal2_log(G_LOG_LEVEL_DEBUG, "Opening SFTP handle in advance for %s:%d", parsed->host, parsed->port);
+            handle = gfal_sftp_new_handle(cache->context, parsed, &tmp_err);
+            gfal2_free_uri(parsed);
+        }
+        if (tmp_err) {
+            gfal2_log(G_LOG_LEVEL_DEBUG, "Could not open SFTP handle in advance: %s", tmp_err->message);
+            g_error_free(tmp_err);
+        }
+
+        pthread_mutex_lock(&cache->lock);
+        --open->host_pool->pending;
+        if (handle) {
+            gfal_sftp_cache_push(cache, open->host_pool, handle);
+        }
+        else {
+            open->host_pool->prewarm_retry = gfal_sftp_monotonic_time() + GFAL_SFTP_PREWARM_RETRY * G_USEC_PER_SEC;
+        }
+        pthread_mutex_unlock(&cache->lock);
+
+        g_free(open->url);
+        g_free(open);
+    }
+    g_slist_free(to_open);
+}
+
+
+static void *gfal_sftp_cache_maintenance_thread(void *arg)
+{
+    gfal_sftp_handle_cache_t *cache = (gfal_sftp_handle_cache_t*)arg;
+
+    pthread_mutex_lock(&cache->lock);
+    while (!cache->stop) {
+        gint64 now = gfal_sftp_monotonic_time();
+        cache->next_run = gfal_sftp_cache_next_run(cache, now);
+        if (cache->next_run == 0) {
+            pthread_cond_wait(&cache->wake, &cache->lock);
+        }
+        else if (cache->next_run > now) {
+            struct timespec deadline;
+            gint64 wait = cache->next_run - now;
+            clock_gettime(CLOCK_REALTIME, &deadline);
+            deadline.tv_sec += wait / G_USEC_PER_SEC;
+            deadline.tv_nsec += (wait % G_USEC_PER_SEC) * 1000;
+            if (deadline.tv_nsec >= 1000000000) {
+                deadline.tv_sec += 1;
+                deadline.tv_nsec -= 1000000000;
+            }
+            pthread_cond_timedwait(&cache->wake, &cache->lock, &deadline);
+        }
+        if (cache->stop) {
+            break;
+        }
+        // Woken up early, or by a change that is not due yet
+        if (cache->next_run == 0 || gfal_sftp_monotonic_time() < cache->next_run) {
+            continue;
+        }
+        pthread_mutex_unlock(&cache->lock);
+        gfal_sftp_cache_maintenance(cache);
+        pthread_mutex_lock(&cache->lock);
+    }
+    pthread_mutex_unlock(&cache->lock);
+    return NULL;
+}
+
+
+gfal_sftp_handle_cache_t *gfal_sftp_cache_new_manual(gfal_sftp_context_t *context)
+{
+    gfal2_context_t gfal2_context = context->gfal2_context;
+    gfal_sftp_handle_cache_t *cache = g_new0(gfal_sftp_handle_cache_t, 1);
+
+    cache->context = context;
+    cache->hosts = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, gfal_sftp_host_pool_free);
+    pthread_mutex_init(&cache->lock, NULL);
+    pthread_cond_init(&cache->wake, NULL);
+
+    cache->max_per_host = gfal2_get_opt_integer_with_default(gfal2_context, "SFTP PLUGIN", "MAX_SESSIONS_PER_HOST", 8);
+    cache->wait_timeout = gfal2_get_opt_integer_with_default(gfal2_context, "SFTP PLUGIN", "SESSION_WAIT_TIMEOUT", 300);
+    cache->idle_timeout = gfal2_get_opt_integer_with_default(gfal2_context, "SFTP PLUGIN", "IDLE_TIMEOUT", 300);
+    cache->keepalive_interval = gfal2_get_opt_integer_with_default(gfal2_context, "SFTP PLUGIN", "KEEPALIVE_INTERVAL", 30);
+    cache->prewarm = gfal2_get_opt_integer_with_default(gfal2_context, "SFTP PLUGIN", "PREWARM_SESSIONS", 0);
+    cache->prewarm_window = gfal2_get_opt_integer_with_default(gfal2_context, "SFTP PLUGIN", "PREWARM_WINDOW", 60);
+
+    return cache;
+}
+
+
+gfal_sftp_handle_cache_t *gfal_sftp_cache_new(gfal_sftp_context_t *context)
+{
+    gfal_sftp_handle_cache_t *cache = gfal_sftp_cache_new_manual(context);
+    cache->maintenance_started =
+        (pthread_create(&cache->maintenance, NULL, gfal_sftp_cache_maintenance_thread, cache) == 0);
+    if (!cache->maintenance_started) {
+        gfal2_log(G_LOG_LEVEL_WARNING, "Could not start the SFTP session pool maintenance thread");
+    }
+    return cache;
+}
+
+
+void gfal_sftp_cache_destroy(gfal_sftp_handle_cache_t *cache)
+{
+    GSList *to_destroy = NULL, *i;
+    GHashTableIter iter;
+    gpointer key, value;
+
+    if (cache->maintenance_started) {
+        pthread_mutex_lock(&cache->lock);
+        cache->stop = TRUE;
+        pthread_cond_signal(&cache->wake);
+        pthread_mutex_unlock(&cache->lock);
+        pthread_join(cache->maintenance, NULL);
+    }
+
+    // Handles still in use are not waited for: gfal_sftp_release closes them, and frees the pool with the last one
+    pthread_mutex_lock(&cache->lock);
+    g_hash_table_iter_init(&iter, cache->hosts);
+    while (g_hash_table_iter_next(&iter, &key, &value)) {
+        gfal_sftp_host_pool_t *host_pool = (gfal_sftp_host_pool_t*)value;
+        gfal_sftp_pool_entry_t *entry;
+        while ((entry = g_queue_pop_head(&host_pool->idle)) != NULL) {
+            to_destroy = g_slist_prepend(to_destroy, entry->handle);
+            g_free(entry);
+        }
+    }
+    int busy = gfal_sftp_cache_busy(cache);
+    cache->orphaned = (busy > 0);
+    cache->context = NULL;
+    pthread_mutex_unlock(&cache->lock);
+
+    for (i = to_destroy; i != NULL; i = i->next) {
+        gfal_sftp_destroy_handle((gfal_sftp_handle_t*)i->data);
+    }
+    g_slist_free(to_destroy);
+
+    if (busy > 0) {
+        gfal2_log(G_LOG_LEVEL_DEBUG, "%d SFTP handles still in use, they will be closed when released", busy);
+    }
+    else {
+        gfal_sftp_cache_free(cache);
+    }
+}
@@ -212,6 +212,28 @@ void gfal_srm_opt_initG(gfal_srmv2_opt *opts, gfal2_context_t handle)
 }
 
 
+gfal_srmv2_opt *gfal_srm_opt_sibling_new(gfal_srmv2_opt *opts)
+{
+    gfal_srmv2_opt *sibling = g_new0(gfal_srmv2_opt, 1);
+    gfal_checker_compile(sibling, NULL);
+    sibling->srm_proto_type = opts->srm_proto_type;
+    sibling->handle = opts->handle;
+    sibling->cache = opts->cache;
+    g_static_rec_mutex_init(&sibling->srm_context_mutex);
+    return sibling;
+}
+
+
+void gfal_srm_opt_sibling_free(gfal_srmv2_opt *sibling)
+{
+    regfree(&sibling->rexurl);
+    regfree(&sibling->rex_full);
+    g_static_rec_mutex_free(&sibling->srm_context_mutex);
+    srm_context_free(sibling->srm_context);
+    g_free(sibling);
+}
+
+
 /*
  * Init function, called before all
  * */
@@ -232,6 +254,7 @@ gfal_plugin_interface gfal_plugin_init(gfal2_context_t handle, GError **err)
     srm_plugin.opendirG = &gfal_srm_opendirG;
     srm_plugin.readdirG = &gfal_srm_readdirG;
     srm_plugin.readdirppG = &gfal_srm_readdirppG;
+    srm_plugin.readdir_batchG = &gfal_srm_readdir_batchG;
     srm_plugin.closedirG = &gfal_srm_closedirG;
     srm_plugin.getName = &gfal_srm_getName;
     srm_plugin.openG = &gfal_srm_openG;
@@ -246,6 +269,7 @@ gfal_plugin_interface gfal_plugin_init(gfal2_context_t handle, GError **err)
     srm_plugin.listxattrG = &gfal_srm_listxattrG;
     srm_plugin.checksum_calcG = &gfal_srm_checksumG;
     srm_plugin.copy_file = &srm_plugin_filecopy;
+    srm_plugin.copy_bulk = &srm_plugin_bulk_copy;
     srm_plugin.check_plugin_url_transfer = &plugin_url_check2;
     srm_plugin.bring_online = &gfal_srmv2_bring_onlineG;
     srm_plugin.bring_online_v2 = &gfal_srmv2_bring_online_v2G;
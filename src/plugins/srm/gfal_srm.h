@@ -114,6 +114,12 @@ void gfal_srm_destroyG(plugin_handle ch);
 
 void gfal_srm_opt_initG(gfal_srmv2_opt* opts, gfal2_context_t handle);
 
+// Options sharing the configuration and the cache of opts, but using their own SRM context,
+// so they can be used from another thread without waiting for the requests done with opts
+gfal_srmv2_opt* gfal_srm_opt_sibling_new(gfal_srmv2_opt* opts);
+
+void gfal_srm_opt_sibling_free(gfal_srmv2_opt* sibling);
+
 
 char* gfal_srm_construct_key(const char* url, const char* prefix, char* buff, const size_t s_buff);
 
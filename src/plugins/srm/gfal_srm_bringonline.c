@@ -44,6 +44,16 @@ static int gfal_srmv2_bring_online_internal_status_index(
 }
 
 
+// Requests are scheduled per SRM endpoint (host and port of the surl)
+static void gfal_srmv2_poll_endpoint(const char *surl, char *endpoint, size_t endpoint_size)
+{
+    const char *start = strstr(surl, "://");
+    start = start ? start + 3 : surl;
+    size_t len = strcspn(start, "/?");
+    g_strlcpy(endpoint, start, MIN(len + 1, endpoint_size));
+}
+
+
 static int gfal_srmv2_bring_online_internal(srm_context_t context, gfal_srmv2_opt *opts,
     int nbfiles, const char *const *surl, time_t pintime, time_t timeout,
     char *token, size_t tsize, int async, GError **errors)
@@ -131,6 +141,35 @@ static int gfal_srmv2_bring_online_internal(srm_context_t context, gfal_srmv2_op
 }
 
 
+// Only an asynchronous submission is a single call to the endpoint, so only that one takes
+// a slot of the endpoint budget. A synchronous request polls inside srm-ifce until it is done,
+// and holding a slot meanwhile would starve the status calls of everybody else.
+static int gfal_srmv2_bring_online_submit(srm_context_t context, gfal_srmv2_opt *opts,
+    const char *endpoint, int nbfiles, const char *const *surl, time_t pintime, time_t timeout,
+    char *token, size_t tsize, int async, GError **errors)
+{
+    int i;
+
+    if (!async)
+        return gfal_srmv2_bring_online_internal(context, opts, nbfiles, surl, pintime, timeout,
+            token, tsize, async, errors);
+
+    GError *tmp_err = NULL;
+    gfal2_endpoint_slot_t budget = NULL;
+    if (gfal2_poll_budget_acquire(opts->handle, endpoint, &budget, &tmp_err) < 0) {
+        for (i = 0; i < nbfiles; ++i) {
+            errors[i] = g_error_copy(tmp_err);
+        }
+        g_error_free(tmp_err);
+        return -1;
+    }
+    int ret = gfal_srmv2_bring_online_internal(context, opts, nbfiles, surl, pintime, timeout,
+        token, tsize, async, errors);
+    gfal2_poll_budget_release(budget);
+    return ret;
+}
+
+
 int gfal_srmv2_bring_onlineG(plugin_handle ch, const char *surl,
     time_t pintime, time_t timeout, char *token, size_t tsize,
     int async, GError **err)
@@ -142,10 +181,15 @@ int gfal_srmv2_bring_onlineG(plugin_handle ch, const char *surl,
 
     int ret = -1;
 
+    char endpoint[GFAL_URL_MAX_LEN];
+    gfal_srmv2_poll_endpoint(surl, endpoint, sizeof(endpoint));
+
     gfal_srm_easy_t easy = gfal_srm_ifce_easy_context(opts, surl, &tmp_err);
     if (easy != NULL) {
-        ret = gfal_srmv2_bring_online_internal(easy->srm_context, opts, 1, (const char *const *) &easy->path,
-            pintime, timeout, token, tsize, async, &tmp_err);
+        ret = gfal_srmv2_bring_online_submit(easy->srm_context, opts, endpoint, 1,
+            (const char *const *) &easy->path, pintime, timeout, token, tsize, async, &tmp_err);
+        if (ret == 0)
+            gfal2_poll_register(endpoint, token, 1, (const char *const *) &easy->path);
     }
     gfal_srm_ifce_easy_context_release(opts, easy);
 
@@ -173,6 +217,9 @@ int gfal_srmv2_bring_online_listG(plugin_handle ch, int nbfiles, const char *con
     GError *tmp_err = NULL;
     gfal_srmv2_opt *opts = (gfal_srmv2_opt *) ch;
 
+    char endpoint[GFAL_URL_MAX_LEN];
+    gfal_srmv2_poll_endpoint(*surls, endpoint, sizeof(endpoint));
+
     gfal_srm_easy_t easy = gfal_srm_ifce_easy_context(opts, *surls, &tmp_err);
     if (easy == NULL) {
         for (i = 0; i < nbfiles; ++i) {
@@ -187,10 +234,13 @@ int gfal_srmv2_bring_online_listG(plugin_handle ch, int nbfiles, const char *con
         decoded[i] = gfal2_srm_get_decoded_path(surls[i]);
     }
 
-    int ret = gfal_srmv2_bring_online_internal(easy->srm_context, opts, nbfiles, (const char *const *) decoded,
-        pintime, timeout, token, tsize, async, errors);
+    int ret = gfal_srmv2_bring_online_submit(easy->srm_context, opts, endpoint, nbfiles,
+        (const char *const *) decoded, pintime, timeout, token, tsize, async, errors);
     gfal_srm_ifce_easy_context_release(opts, easy);
 
+    if (ret == 0)
+        gfal2_poll_register(endpoint, token, nbfiles, (const char *const *) decoded);
+
     for (i = 0; i < nbfiles; ++i) {
         g_free(decoded[i]);
     }
@@ -244,7 +294,7 @@ static int gfal_srmv2_bring_online_poll_internal(srm_context_t context,
                     gfal2_set_error(&errors[i], gfal2_get_plugin_srm_quark(),
                         EAGAIN, __func__,
                         "still queued: %s ",
-                        output.filestatuses[i].explanation);
+                        output.filestatuses[status_index].explanation);
                     break;
                 default:
                     gfal2_set_error(&errors[i], gfal2_get_plugin_srm_quark(),
@@ -269,25 +319,83 @@ static int gfal_srmv2_bring_online_poll_internal(srm_context_t context,
 }
 
 
+// Poll through the shared scheduler: only the files that need it are sent to the endpoint,
+// together with the other pending files of the request, and the answer is taken from the scheduler
+static int gfal_srmv2_bring_online_poll_scheduled(gfal_srmv2_opt *opts, int nbfiles,
+    const char *const *surls, const char *const *keys, const char *token, GError **errors)
+{
+    GError *tmp_err = NULL;
+    char **poll_keys = NULL;
+    char endpoint[GFAL_URL_MAX_LEN];
+    int i;
+
+    gfal_srmv2_poll_endpoint(surls[0], endpoint, sizeof(endpoint));
+    const time_t interval_min = gfal2_get_opt_integer_with_default(opts->handle, srm_config_group,
+        "POLL_INTERVAL_MIN", 2);
+    const time_t interval_max = gfal2_get_opt_integer_with_default(opts->handle, srm_config_group,
+        "POLL_INTERVAL_MAX", 60);
+
+    int due = gfal2_poll_begin(opts->handle, endpoint, token, interval_min, interval_max,
+        nbfiles, keys, &poll_keys, &tmp_err);
+
+    if (due > 0) {
+        int npoll = g_strv_length(poll_keys);
+        GError *statuses[npoll];
+        int ret = -1;
+        memset(statuses, 0, sizeof(statuses));
+
+        gfal2_log(G_LOG_LEVEL_DEBUG, "Polling %d files of the bring online request %s", npoll, token);
+        gfal_srm_easy_t easy = gfal_srm_ifce_easy_context(opts, surls[0], &tmp_err);
+        if (easy != NULL) {
+            ret = gfal_srmv2_bring_online_poll_internal(easy->srm_context, npoll,
+                (const char *const *) poll_keys, token, statuses);
+            if (ret < 0)
+                tmp_err = g_error_copy(statuses[0]);
+        }
+        gfal_srm_ifce_easy_context_release(opts, easy);
+        gfal2_poll_end(endpoint, token, npoll, (const char *const *) poll_keys, ret < 0 ? NULL : statuses);
+
+        for (i = 0; i < npoll; ++i) {
+            if (statuses[i])
+                g_error_free(statuses[i]);
+        }
+        g_strfreev(poll_keys);
+    }
+
+    if (tmp_err != NULL) {
+        for (i = 0; i < nbfiles; ++i) {
+            errors[i] = g_error_copy(tmp_err);
+        }
+        g_error_free(tmp_err);
+        return -1;
+    }
+
+    int nterminal = 0;
+    for (i = 0; i < nbfiles; ++i) {
+        if (gfal2_poll_status(endpoint, token, keys[i], &errors[i]) == 0 || errors[i]->code != EAGAIN)
+            ++nterminal;
+    }
+
+    // Return will be 1 if all files are terminal
+    return nterminal == nbfiles;
+}
+
+
 int gfal_srmv2_bring_online_pollG(plugin_handle ch, const char *surl,
     const char *token, GError **err)
 {
     g_return_val_err_if_fail(ch && surl && token, EINVAL, err,
         "[gfal_srmv2_bring_online_pollG] Invalid value handle and, surl or token");
-    GError *tmp_err = NULL;
+    GError *errors[1] = {NULL};
     gfal_srmv2_opt *opts = (gfal_srmv2_opt *) ch;
 
-    int ret = -1;
-
-    gfal_srm_easy_t easy = gfal_srm_ifce_easy_context(opts, surl, &tmp_err);
-    if (easy != NULL) {
-        ret = gfal_srmv2_bring_online_poll_internal(easy->srm_context, 1, (const char *const *) &easy->path, token,
-            &tmp_err);
-    }
-    gfal_srm_ifce_easy_context_release(opts, easy);
+    char *decoded = gfal2_srm_get_decoded_path(surl);
+    int ret = gfal_srmv2_bring_online_poll_scheduled(opts, 1, &surl, (const char *const *) &decoded,
+        token, errors);
+    g_free(decoded);
 
-    if (tmp_err) {
-        gfal2_propagate_prefixed_error(err, tmp_err, __func__);
+    if (errors[0]) {
+        gfal2_propagate_prefixed_error(err, errors[0], __func__);
         return -1;
     }
 
@@ -299,26 +407,15 @@ int gfal_srmv2_bring_online_poll_listG(plugin_handle ch, int nbfiles,
     const char *const *surls, const char *token, GError **errors)
 {
     int i;
-    GError *tmp_err = NULL;
     gfal_srmv2_opt *opts = (gfal_srmv2_opt *) ch;
 
-    gfal_srm_easy_t easy = gfal_srm_ifce_easy_context(opts, *surls, &tmp_err);
-    if (easy == NULL) {
-        for (i = 0; i < nbfiles; ++i) {
-            errors[i] = g_error_copy(tmp_err);
-        }
-        g_error_free(tmp_err);
-        return -1;
-    }
-
     char *decoded[nbfiles];
     for (i = 0; i < nbfiles; ++i) {
         decoded[i] = gfal2_srm_get_decoded_path(surls[i]);
     }
 
-    int ret = gfal_srmv2_bring_online_poll_internal(easy->srm_context, nbfiles, (const char *const *) decoded,
+    int ret = gfal_srmv2_bring_online_poll_scheduled(opts, nbfiles, surls, (const char *const *) decoded,
         token, errors);
-    gfal_srm_ifce_easy_context_release(opts, easy);
 
     for (i = 0; i < nbfiles; ++i) {
         g_free(decoded[i]);
@@ -498,6 +595,12 @@ int gfal_srm2_abort_filesG(plugin_handle ch, int nbfiles, const char *const *sur
     int ret = gfal_srmv2_abort_files_internal(easy->srm_context, opts, nbfiles, (const char *const *) decoded,
         token, errors);
     gfal_srm_ifce_easy_context_release(opts, easy);
+
+    if (token) {
+        char endpoint[GFAL_URL_MAX_LEN];
+        gfal_srmv2_poll_endpoint(surls[0], endpoint, sizeof(endpoint));
+        gfal2_poll_forget(endpoint, token);
+    }
     for (i = 0; i < nbfiles; ++i) {
         g_free(decoded[i]);
     }
@@ -18,6 +18,7 @@
  * limitations under the License.
  */
 
+#include <pthread.h>
 #include <checksums/checksums.h>
 #include <uri/gfal2_uri.h>
 
@@ -26,6 +27,7 @@
 #include "gfal_srm_url_check.h"
 #include "gfal_srm_internal_layer.h"
 #include "gfal_srm_bringonline.h"
+#include "gfal_srm_copy.h"
 
 
 GQuark srm_domain()
@@ -421,30 +423,39 @@ static void srm_release_get(plugin_handle handle, const char *surl, const char *
 }
 
 
-static int srm_resolve_turls(plugin_handle handle, gfal2_context_t context,
-    gfalt_params_t params,
-    const char *source, char *turl_source, char *token_source,
-    const char *dest, char *turl_destination, char *token_destination,
-    GError **err)
+// Size of the source, 0 if it can not be determined
+// SRM sources are queried through handle, so each side of a copy can use its own SRM connection
+static off_t srm_get_source_size(plugin_handle handle, gfal2_context_t context, const char *source)
 {
     GError *tmp_err = NULL;
-    char buffer[1024];
     struct stat stat_source;
+    int ret;
     memset(&stat_source, 0, sizeof(stat_source));
-    if (gfal2_stat(context, source, &stat_source, &tmp_err) != 0) {
+    if (srm_check_url(source))
+        ret = gfal_srm_statG(handle, source, &stat_source, &tmp_err);
+    else
+        ret = gfal2_stat(context, source, &stat_source, &tmp_err);
+    if (ret != 0) {
         stat_source.st_size = 0;
         gfal2_log(G_LOG_LEVEL_DEBUG,
             "Fail to stat src SRM url %s to determine file size, try with file_size=0, error %s",
             source, tmp_err->message);
         g_clear_error(&tmp_err);
-        tmp_err = NULL;
     }
+    return stat_source.st_size;
+}
+
+//check if the source file is online in case the SRM_COPY_FAIL_NEARLINE is set
+static int srm_check_source_online(plugin_handle handle, gfal2_context_t context, const char *source,
+    GError **err)
+{
+    GError *tmp_err = NULL;
+    char buffer[1024];
 
-    //check if the source file is online in case the SRM_COPY_FAIL_NEARLINE is set
     gboolean fail_nearline = gfal2_get_opt_boolean_with_default(context, "SRM PLUGIN", "COPY_FAIL_NEARLINE", FALSE);
     if (fail_nearline && srm_check_url(source)) {
         gfal2_log(G_LOG_LEVEL_DEBUG, "Copy-fail-nearline: querying status first");
-        ssize_t ret = gfal2_getxattr(context,  source, GFAL_XATTR_STATUS, buffer, sizeof(buffer), &tmp_err);
+        ssize_t ret = gfal_srm_status_getxattrG(handle, source, GFAL_XATTR_STATUS, buffer, sizeof(buffer), &tmp_err);
         if (ret > 0 && strlen(buffer) > 0 && tmp_err == NULL) {
             if (strncmp(buffer, GFAL_XATTR_STATUS_NEARLINE, sizeof(GFAL_XATTR_STATUS_NEARLINE)) == 0) {
                 gfal2_log(G_LOG_LEVEL_DEBUG, "Copy-fail-nearline: The source file is not ONLINE");
@@ -462,6 +473,23 @@ static int srm_resolve_turls(plugin_handle handle, gfal2_context_t context,
             return -1;
         }
     }
+    return 0;
+}
+
+
+static int srm_resolve_turls(plugin_handle handle, gfal2_context_t context,
+    gfalt_params_t params,
+    const char *source, char *turl_source, char *token_source,
+    const char *dest, char *turl_destination, char *token_destination,
+    GError **err)
+{
+    GError *tmp_err = NULL;
+    off_t source_size = srm_get_source_size(handle, context, source);
+
+    if (srm_check_source_online(handle, context, source, &tmp_err) < 0) {
+        gfal2_propagate_prefixed_error(err, tmp_err, __func__);
+        return -1;
+    }
 
     srm_resolve_get_turl(handle, params, source, dest,
         turl_source, GFAL_URL_MAX_LEN,
@@ -473,7 +501,7 @@ static int srm_resolve_turls(plugin_handle handle, gfal2_context_t context,
     }
 
     srm_resolve_put_turl(handle, context, params,
-        dest, source, stat_source.st_size,
+        dest, source, source_size,
         turl_destination, GFAL_URL_MAX_LEN,
         token_destination, GFAL_URL_MAX_LEN,
         &tmp_err);
@@ -485,6 +513,153 @@ static int srm_resolve_turls(plugin_handle handle, gfal2_context_t context,
     return 0;
 }
 
+// Preparation of the destination, run concurrently with the one of the source
+typedef struct {
+    gfal_srmv2_opt *opts;
+    gfal2_context_t context;
+    gfalt_params_t params;
+    const char *source, *dest;
+    char *turl_destination, *token_destination;
+    GError *error;
+
+    // Set by the source side once the source has been validated
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    gboolean source_done;
+    gboolean source_valid;
+    off_t source_size;
+} srm_dest_prepare_t;
+
+
+static void srm_dest_prepare_source_done(srm_dest_prepare_t *prepare, gboolean valid, off_t size)
+{
+    pthread_mutex_lock(&prepare->lock);
+    prepare->source_done = TRUE;
+    prepare->source_valid = valid;
+    prepare->source_size = size;
+    pthread_cond_signal(&prepare->cond);
+    pthread_mutex_unlock(&prepare->lock);
+}
+
+// The parent directory is created right away, but the existing destination is only
+// removed, and the PUT issued, once the source is known to be valid
+static void *srm_dest_prepare_worker(void *arg)
+{
+    srm_dest_prepare_t *prepare = (srm_dest_prepare_t*) arg;
+    GError *tmp_err = NULL;
+
+    gfal2_log(G_LOG_LEVEL_DEBUG, "\t\tPUT surl -> turl resolution start ");
+
+    if (srm_plugin_create_parent_copy(prepare->opts, prepare->params, prepare->dest, &tmp_err) < 0) {
+        gfalt_propagate_prefixed_error(&prepare->error, tmp_err, __func__,
+            GFALT_ERROR_DESTINATION, GFALT_ERROR_PARENT);
+        return NULL;
+    }
+
+    pthread_mutex_lock(&prepare->lock);
+    while (!prepare->source_done)
+        pthread_cond_wait(&prepare->cond, &prepare->lock);
+    pthread_mutex_unlock(&prepare->lock);
+
+    if (!prepare->source_valid) {
+        gfal2_log(G_LOG_LEVEL_DEBUG, "\t\tSource not valid, PUT not issued");
+        return NULL;
+    }
+
+    if (srm_plugin_delete_existing_copy(prepare->opts, prepare->params, prepare->dest, &tmp_err) < 0) {
+        gfalt_propagate_prefixed_error(&prepare->error, tmp_err, __func__,
+            GFALT_ERROR_DESTINATION, GFALT_ERROR_OVERWRITE);
+        return NULL;
+    }
+
+    if (gfal_srm_put_rd3_turl(prepare->opts, prepare->params, prepare->dest, prepare->source,
+            prepare->source_size,
+            prepare->turl_destination, GFAL_URL_MAX_LEN,
+            prepare->token_destination, GFAL_URL_MAX_LEN,
+            &tmp_err) < 0) {
+        gfalt_propagate_prefixed_error(&prepare->error, tmp_err, __func__,
+            GFALT_ERROR_DESTINATION, "SRM_PUT_TURL");
+        return NULL;
+    }
+
+    gfal2_log(G_LOG_LEVEL_DEBUG, "\t\tPUT surl -> turl resolution ended : %s -> %s (%s)",
+        prepare->dest, prepare->turl_destination, prepare->token_destination);
+    plugin_trigger_event(prepare->params, gfal2_get_plugin_srm_quark(),
+        GFAL_EVENT_DESTINATION, gfal2_get_srm_put_quark(),
+        "Got TURL %s => %s", prepare->dest, prepare->turl_destination);
+    return NULL;
+}
+
+// Validate the source and resolve both turls, preparing the source and the destination concurrently
+// The destination uses its own SRM context, so both sides can talk to their endpoint at the same time
+static int srm_prepare_copy_parallel(plugin_handle handle, gfal2_context_t context,
+    gfalt_params_t params, gfalt_checksum_mode_t checksum_mode,
+    const char *checksum_algorithm, const char *checksum_user,
+    char *checksum_source, size_t checksum_source_size,
+    const char *source, char *turl_source, char *token_source,
+    const char *dest, char *turl_destination, char *token_destination,
+    GError **err)
+{
+    GError *tmp_err = NULL;
+    srm_dest_prepare_t prepare;
+    pthread_t thread;
+
+    memset(&prepare, 0, sizeof(prepare));
+    prepare.opts = gfal_srm_opt_sibling_new((gfal_srmv2_opt*) handle);
+    prepare.context = context;
+    prepare.params = params;
+    prepare.source = source;
+    prepare.dest = dest;
+    prepare.turl_destination = turl_destination;
+    prepare.token_destination = token_destination;
+    pthread_mutex_init(&prepare.lock, NULL);
+    pthread_cond_init(&prepare.cond, NULL);
+
+    gboolean started = (pthread_create(&thread, NULL, srm_dest_prepare_worker, &prepare) == 0);
+    if (!started)
+        gfal2_log(G_LOG_LEVEL_DEBUG, "Could not start the destination preparation thread, run it after the source");
+
+    off_t source_size = srm_get_source_size(handle, context, source);
+    int ret = 0;
+    if (checksum_mode) {
+        ret = srm_validate_source_checksum(handle, context, params, source,
+            checksum_mode, checksum_algorithm, checksum_user,
+            checksum_source, checksum_source_size, &tmp_err);
+    }
+    if (ret == 0)
+        ret = srm_check_source_online(handle, context, source, &tmp_err);
+
+    srm_dest_prepare_source_done(&prepare, ret == 0, source_size);
+
+    if (ret == 0) {
+        srm_resolve_get_turl(handle, params, source, dest,
+            turl_source, GFAL_URL_MAX_LEN,
+            token_source, GFAL_URL_MAX_LEN,
+            &tmp_err);
+    }
+
+    if (started)
+        pthread_join(thread, NULL);
+    else
+        srm_dest_prepare_worker(&prepare);
+
+    gfal_srm_opt_sibling_free(prepare.opts);
+    pthread_mutex_destroy(&prepare.lock);
+    pthread_cond_destroy(&prepare.cond);
+
+    // An error on the source is the cause of the failure, the destination is rolled back anyway
+    if (tmp_err != NULL) {
+        g_clear_error(&prepare.error);
+        gfal2_propagate_prefixed_error(err, tmp_err, __func__);
+        return -1;
+    }
+    if (prepare.error != NULL) {
+        gfal2_propagate_prefixed_error(err, prepare.error, __func__);
+        return -1;
+    }
+    return 0;
+}
+
 
 static int srm_do_transfer(plugin_handle handle, gfal2_context_t context,
     gfalt_params_t params,
@@ -595,25 +770,39 @@ int srm_plugin_filecopy(plugin_handle handle, gfal2_context_t context,
     if (nested_error != NULL)
         goto copy_finalize;
 
-    // Source checksum validation
-    if (checksum_mode) {
-        srm_validate_source_checksum(handle, context, params, source,
-            checksum_mode,
-            checksum_algorithm, checksum_user,
+    if (srm_check_url(dest) &&
+        gfal2_get_opt_boolean_with_default(context, srm_config_group, "COPY_PARALLEL_PREPARE", TRUE)) {
+        // Validate the source and get its turl, while the destination is prepared
+        srm_prepare_copy_parallel(handle, context, params,
+            checksum_mode, checksum_algorithm, checksum_user,
             checksum_source, sizeof(checksum_source),
+            source, turl_source, token_source,
+            dest, turl_destination, token_destination,
             &nested_error);
-
         if (nested_error != NULL)
             goto copy_finalize;
     }
+    else {
+        // Source checksum validation
+        if (checksum_mode) {
+            srm_validate_source_checksum(handle, context, params, source,
+                checksum_mode,
+                checksum_algorithm, checksum_user,
+                checksum_source, sizeof(checksum_source),
+                &nested_error);
+
+            if (nested_error != NULL)
+                goto copy_finalize;
+        }
 
-    // Resolve turls
-    srm_resolve_turls(handle, context, params,
-        source, turl_source, token_source,
-        dest, turl_destination, token_destination,
-        &nested_error);
-    if (nested_error != NULL)
-        goto copy_finalize;
+        // Resolve turls
+        srm_resolve_turls(handle, context, params,
+            source, turl_source, token_source,
+            dest, turl_destination, token_destination,
+            &nested_error);
+        if (nested_error != NULL)
+            goto copy_finalize;
+    }
 
     plugin_trigger_event(params, srm_domain(), GFAL_EVENT_NONE,
         GFAL_EVENT_PREPARE_EXIT, "");
@@ -651,3 +840,563 @@ int srm_plugin_filecopy(plugin_handle handle, gfal2_context_t context,
         *err = NULL;
     return (*err == NULL) ? 0 : -1;
 }
+
+
+// One file of a bulk copy
+typedef struct {
+    const char *source, *dest;
+    char checksum_algorithm[64];
+    char checksum_user[GFAL_URL_MAX_LEN];
+    char checksum_source[GFAL_URL_MAX_LEN];
+    size_t source_size;
+    char turl_source[GFAL_URL_MAX_LEN];
+    char turl_destination[GFAL_URL_MAX_LEN];
+    // The file has a turl from the GET or PUT request, and must be released or put done
+    gboolean in_get, in_put;
+    gboolean transferred;
+    GError *error;
+} srm_bulk_file_t;
+
+// Length of the scheme and authority of the url, 0 if there is none
+static size_t srm_endpoint_len(const char *url)
+{
+    const char *sep = strstr(url, "://");
+    if (sep == NULL)
+        return 0;
+    const char *path = strchr(sep + 3, '/');
+    return path ? (size_t)(path - url) : strlen(url);
+}
+
+
+size_t srm_bulk_group(size_t nbfiles, const char *const *srcs, const char *const *dsts,
+    size_t max_chunk, size_t *order, size_t *chunks)
+{
+    GHashTable *buckets_by_endpoint = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+    GPtrArray *buckets = g_ptr_array_new();
+    size_t i, j, n_order = 0, n_chunks = 0;
+
+    if (max_chunk < 1)
+        max_chunk = 1;
+
+    // Buckets are kept in the order of their first file, and the files in submission order
+    for (i = 0; i < nbfiles; ++i) {
+        size_t src_len = srm_endpoint_len(srcs[i]);
+        size_t dst_len = srm_endpoint_len(dsts[i]);
+        GArray *bucket = NULL;
+
+        // Urls without an authority are never grouped
+        if (src_len > 0 && dst_len > 0) {
+            char *key = g_strdup_printf("%.*s %.*s", (int)src_len, srcs[i], (int)dst_len, dsts[i]);
+            bucket = g_hash_table_lookup(buckets_by_endpoint, key);
+            if (bucket == NULL) {
+                bucket = g_array_new(FALSE, FALSE, sizeof(size_t));
+                g_hash_table_insert(buckets_by_endpoint, key, bucket);
+                g_ptr_array_add(buckets, bucket);
+            }
+            else {
+                g_free(key);
+            }
+        }
+        else {
+            bucket = g_array_new(FALSE, FALSE, sizeof(size_t));
+            g_ptr_array_add(buckets, bucket);
+        }
+        g_array_append_val(bucket, i);
+    }
+
+    for (i = 0; i < buckets->len; ++i) {
+        GArray *bucket = g_ptr_array_index(buckets, i);
+        for (j = 0; j < bucket->len; ++j) {
+            if (j % max_chunk == 0)
+                chunks[n_chunks++] = MIN(max_chunk, bucket->len - j);
+            order[n_order++] = g_array_index(bucket, size_t, j);
+        }
+        g_array_free(bucket, TRUE);
+    }
+
+    g_ptr_array_free(buckets, TRUE);
+    g_hash_table_destroy(buckets_by_endpoint);
+    return n_chunks;
+}
+
+// Split the user checksum "algorithm:value" of each file
+static void srm_bulk_set_checksum(srm_bulk_file_t *file, const char *default_algorithm,
+    const char *default_checksum, const char *checksum)
+{
+    g_strlcpy(file->checksum_algorithm, default_algorithm, sizeof(file->checksum_algorithm));
+    g_strlcpy(file->checksum_user, default_checksum, sizeof(file->checksum_user));
+    if (checksum == NULL || checksum[0] == '\0')
+        return;
+
+    const char *colon = strchr(checksum, ':');
+    if (colon == NULL) {
+        g_strlcpy(file->checksum_user, checksum, sizeof(file->checksum_user));
+    }
+    else {
+        size_t algorithm_len = MIN((size_t)(colon - checksum) + 1, sizeof(file->checksum_algorithm));
+        g_strlcpy(file->checksum_algorithm, checksum, algorithm_len);
+        g_strlcpy(file->checksum_user, colon + 1, sizeof(file->checksum_user));
+    }
+}
+
+
+static void srm_bulk_resolve_get(plugin_handle handle, gfalt_params_t params,
+    srm_bulk_file_t **files, int nbfiles, char *token, size_t token_size)
+{
+    GError *tmp_err = NULL;
+    gfal_srm_result *resu = NULL;
+    const char *surls[nbfiles];
+    int i;
+
+    for (i = 0; i < nbfiles; ++i) {
+        surls[i] = files[i]->source;
+    }
+
+    gfal2_log(G_LOG_LEVEL_DEBUG, "\t\tGET surl -> turl resolution start for %d files", nbfiles);
+    int n_results = gfal_srm_get_rd3_turls(handle, params, nbfiles, surls, files[0]->dest, &resu, &tmp_err);
+
+    for (i = 0; i < nbfiles; ++i) {
+        GError *file_error = NULL;
+        if (n_results < 0) {
+            file_error = g_error_copy(tmp_err);
+        }
+        else if (i >= n_results) {
+            gfal2_set_error(&file_error, gfal2_get_plugin_srm_quark(), EBADMSG, __func__,
+                "No status returned for %s", files[i]->source);
+        }
+        else if (resu[i].err_code != 0) {
+            gfal2_set_error(&file_error, gfal2_get_plugin_srm_quark(), resu[i].err_code, __func__,
+                "error on the turl %s request : %s ", resu[i].turl, resu[i].err_str);
+        }
+        else {
+            g_strlcpy(files[i]->turl_source, resu[i].turl, sizeof(files[i]->turl_source));
+            files[i]->in_get = TRUE;
+            plugin_trigger_event(params, gfal2_get_plugin_srm_quark(),
+                GFAL_EVENT_SOURCE, gfal2_get_srm_get_quark(),
+                "Got TURL %s => %s", files[i]->source, files[i]->turl_source);
+        }
+        if (file_error)
+            gfalt_propagate_prefixed_error(&files[i]->error, file_error, __func__,
+                GFALT_ERROR_SOURCE, "SRM_GET_TURL");
+    }
+    if (n_results > 0 && resu[0].reqtoken)
+        g_strlcpy(token, resu[0].reqtoken, token_size);
+
+    gfal_srm_result_list_free(resu, n_results);
+    g_clear_error(&tmp_err);
+}
+
+
+static void srm_bulk_resolve_put(plugin_handle handle, gfalt_params_t params,
+    srm_bulk_file_t **files, int nbfiles, char *token, size_t token_size)
+{
+    GError *tmp_err = NULL;
+    gfal_srm_result *resu = NULL;
+    const char *surls[nbfiles];
+    size_t sizes[nbfiles];
+    int i;
+
+    for (i = 0; i < nbfiles; ++i) {
+        surls[i] = files[i]->dest;
+        sizes[i] = files[i]->source_size;
+    }
+
+    gfal2_log(G_LOG_LEVEL_DEBUG, "\t\tPUT surl -> turl resolution start for %d files", nbfiles);
+    int n_results = gfal_srm_put_rd3_turls(handle, params, nbfiles, surls, sizes, files[0]->source,
+        &resu, &tmp_err);
+
+    for (i = 0; i < nbfiles; ++i) {
+        GError *file_error = NULL;
+        if (n_results < 0) {
+            file_error = g_error_copy(tmp_err);
+        }
+        else if (i >= n_results) {
+            gfal2_set_error(&file_error, gfal2_get_plugin_srm_quark(), EBADMSG, __func__,
+                "No status returned for %s", files[i]->dest);
+        }
+        else if (resu[i].err_code != 0) {
+            gfal2_set_error(&file_error, gfal2_get_plugin_srm_quark(), resu[i].err_code, __func__,
+                "error on the turl %s request : %s ", resu[i].turl, resu[i].err_str);
+        }
+        else {
+            g_strlcpy(files[i]->turl_destination, resu[i].turl, sizeof(files[i]->turl_destination));
+            files[i]->in_put = TRUE;
+            plugin_trigger_event(params, gfal2_get_plugin_srm_quark(),
+                GFAL_EVENT_DESTINATION, gfal2_get_srm_put_quark(),
+                "Got TURL %s => %s", files[i]->dest, files[i]->turl_destination);
+        }
+        if (file_error)
+            gfalt_propagate_prefixed_error(&files[i]->error, file_error, __func__,
+                GFALT_ERROR_DESTINATION, "SRM_PUT_TURL");
+    }
+    if (n_results > 0 && resu[0].reqtoken)
+        g_strlcpy(token, resu[0].reqtoken, token_size);
+
+    gfal_srm_result_list_free(resu, n_results);
+    g_clear_error(&tmp_err);
+}
+
+// Transfer the turls of the files still valid, with the bulk copy of the underlying protocol
+static void srm_bulk_transfer(gfal2_context_t context, gfalt_params_t params,
+    srm_bulk_file_t **files, int nbfiles, gboolean srm_destination)
+{
+    GError *op_error = NULL;
+    GError **file_errors = NULL;
+    const char *turl_sources[nbfiles];
+    const char *turl_destinations[nbfiles];
+    srm_bulk_file_t *pending[nbfiles];
+    int n_pending = 0;
+    int i;
+
+    for (i = 0; i < nbfiles; ++i) {
+        if (files[i]->error == NULL) {
+            pending[n_pending] = files[i];
+            turl_sources[n_pending] = files[i]->turl_source;
+            turl_destinations[n_pending] = files[i]->turl_destination;
+            ++n_pending;
+        }
+    }
+    if (n_pending == 0)
+        return;
+
+    gfalt_params_t params_turl = gfalt_params_handle_copy(params, NULL);
+    // checksum check done here!
+    gfalt_set_checksum(params_turl, GFALT_CHECKSUM_NONE, NULL, NULL, NULL);
+    if (srm_destination) {
+        gfalt_set_replace_existing_file(params_turl, FALSE, NULL);
+        gfalt_set_strict_copy_mode(params_turl, TRUE, NULL);
+    }
+
+    gfalt_copy_bulk(context, params_turl, n_pending, turl_sources, turl_destinations, NULL,
+        &op_error, &file_errors);
+    gfalt_params_handle_delete(params_turl, NULL);
+
+    for (i = 0; i < n_pending; ++i) {
+        // We assume the underlying copy tagged properly
+        if (file_errors && file_errors[i]) {
+            pending[i]->error = file_errors[i];
+        }
+        else if (op_error) {
+            pending[i]->error = g_error_copy(op_error);
+        }
+        else {
+            pending[i]->transferred = TRUE;
+        }
+    }
+    g_free(file_errors);
+    g_clear_error(&op_error);
+}
+
+
+static void srm_bulk_putdone(plugin_handle handle, gfalt_params_t params,
+    srm_bulk_file_t **files, int nbfiles, const char *token)
+{
+    const char *surls[nbfiles];
+    srm_bulk_file_t *done[nbfiles];
+    GError *errors[nbfiles];
+    int n_done = 0;
+    int i;
+
+    for (i = 0; i < nbfiles; ++i) {
+        if (files[i]->transferred && files[i]->in_put) {
+            done[n_done] = files[i];
+            surls[n_done] = files[i]->dest;
+            errors[n_done] = NULL;
+            ++n_done;
+        }
+    }
+    if (n_done == 0)
+        return;
+
+    plugin_trigger_event(params, srm_domain(), GFAL_EVENT_DESTINATION,
+        GFAL_EVENT_CLOSE_ENTER, "%d files", n_done);
+
+    gfal_srm_putdone_list((gfal_srmv2_opt*)handle, n_done, surls, token, errors);
+    for (i = 0; i < n_done; ++i) {
+        if (errors[i]) {
+            gfalt_propagate_prefixed_error(&done[i]->error, errors[i], __func__,
+                GFALT_ERROR_DESTINATION, "SRM_PUTDONE");
+        }
+        done[i]->in_put = FALSE;
+    }
+
+    plugin_trigger_event(params, srm_domain(), GFAL_EVENT_DESTINATION,
+        GFAL_EVENT_CLOSE_EXIT, "%d files", n_done);
+}
+
+// Same as srm_rollback_put, with one abort for all the files of the PUT request
+static void srm_bulk_rollback_put(plugin_handle handle, gfal2_context_t context,
+    srm_bulk_file_t **files, int nbfiles, const char *token)
+{
+    const char *surls[nbfiles];
+    GError *errors[nbfiles];
+    int n_abort = 0;
+    int i;
+
+    for (i = 0; i < nbfiles; ++i) {
+        srm_bulk_file_t *file = files[i];
+        if (file->error == NULL || file->error->code == EEXIST)
+            continue;
+
+        if (file->transferred || !srm_check_url(file->dest)) {
+            GError *unlink_error = NULL;
+            gfal2_unlink(context, file->dest, &unlink_error);
+            g_clear_error(&unlink_error);
+        }
+        else if (file->in_put && token[0] != '\0') {
+            surls[n_abort] = file->dest;
+            errors[n_abort] = NULL;
+            ++n_abort;
+        }
+    }
+    if (n_abort == 0)
+        return;
+
+    gfal2_log(G_LOG_LEVEL_MESSAGE, "Rolling back PUT of %d files", n_abort);
+    gfal_srm2_abort_filesG(handle, n_abort, surls, token, errors);
+    for (i = 0; i < n_abort; ++i) {
+        if (errors[i]) {
+            gfal2_log(G_LOG_LEVEL_WARNING, "Got an error when canceling the PUT of %s: %s",
+                surls[i], errors[i]->message);
+            g_error_free(errors[i]);
+        }
+        // Some endpoints may not remove the file after an abort (i.e. Castor)
+        srm_force_unlink(handle, context, surls[i], NULL);
+    }
+}
+
+
+static void srm_bulk_release_get(plugin_handle handle, srm_bulk_file_t **files, int nbfiles,
+    const char *token)
+{
+    const char *surls[nbfiles];
+    GError *errors[nbfiles];
+    int n_release = 0;
+    int i;
+
+    if (token[0] == '\0')
+        return;
+
+    for (i = 0; i < nbfiles; ++i) {
+        if (files[i]->in_get) {
+            surls[n_release] = files[i]->source;
+            errors[n_release] = NULL;
+            ++n_release;
+        }
+    }
+    if (n_release == 0)
+        return;
+
+    gfal_srmv2_release_file_listG(handle, n_release, surls, token, errors);
+    for (i = 0; i < n_release; ++i) {
+        if (errors[i]) {
+            gfal2_log(G_LOG_LEVEL_WARNING, "Got an error when releasing the source file %s: %s",
+                surls[i], errors[i]->message);
+            g_error_free(errors[i]);
+        }
+    }
+}
+
+// Per file validation of the sources and preparation of the destinations of a chunk,
+// shared by several workers, each with its own SRM connection
+typedef struct {
+    gfal_srmv2_opt *opts;
+    gfal2_context_t context;
+    gfalt_params_t params;
+    gfalt_checksum_mode_t checksum_mode;
+    gboolean srm_destination;
+    srm_bulk_file_t **files;
+    int nbfiles;
+    volatile gint next;
+} srm_bulk_prepare_t;
+
+
+static void srm_bulk_prepare_files(srm_bulk_prepare_t *prepare, plugin_handle handle)
+{
+    int i;
+    while ((i = g_atomic_int_add(&prepare->next, 1)) < prepare->nbfiles) {
+        srm_bulk_file_t *file = prepare->files[i];
+        file->source_size = srm_get_source_size(handle, prepare->context, file->source);
+        if (prepare->checksum_mode) {
+            srm_validate_source_checksum(handle, prepare->context, prepare->params, file->source,
+                prepare->checksum_mode, file->checksum_algorithm, file->checksum_user,
+                file->checksum_source, sizeof(file->checksum_source),
+                &file->error);
+        }
+        if (file->error == NULL)
+            srm_check_source_online(handle, prepare->context, file->source, &file->error);
+        if (file->error == NULL && prepare->srm_destination)
+            srm_plugin_prepare_dest_put(handle, prepare->context, prepare->params, file->dest, &file->error);
+    }
+}
+
+
+static void *srm_bulk_prepare_worker(void *arg)
+{
+    srm_bulk_prepare_t *prepare = (srm_bulk_prepare_t*) arg;
+    gfal_srmv2_opt *sibling = gfal_srm_opt_sibling_new(prepare->opts);
+    srm_bulk_prepare_files(prepare, sibling);
+    gfal_srm_opt_sibling_free(sibling);
+    return NULL;
+}
+
+// Copy a group of files sharing the same source and destination endpoints
+static void srm_bulk_copy_chunk(plugin_handle handle, gfal2_context_t context,
+    gfalt_params_t params, gfalt_checksum_mode_t checksum_mode,
+    srm_bulk_file_t **files, int nbfiles)
+{
+    char token_source[GFAL_URL_MAX_LEN] = {0};
+    char token_destination[GFAL_URL_MAX_LEN] = {0};
+    srm_bulk_file_t *pending[nbfiles];
+    int n_pending;
+    int i;
+    const gboolean srm_source = srm_check_url(files[0]->source);
+    const gboolean srm_destination = srm_check_url(files[0]->dest);
+
+    castor_gridftp_session_hack(handle, context, files[0]->source, files[0]->dest);
+
+    plugin_trigger_event(params, srm_domain(), GFAL_EVENT_NONE,
+        GFAL_EVENT_PREPARE_ENTER, "%d files", nbfiles);
+
+    // Source validation and destination preparation are per file, so they are spread
+    // over several connections. The calling thread takes part with the main one
+    srm_bulk_prepare_t prepare = {(gfal_srmv2_opt*) handle, context, params, checksum_mode,
+        srm_destination, files, nbfiles, 0};
+    int n_workers = gfal2_get_opt_integer_with_default(context, srm_config_group, "COPY_BULK_PREPARE_THREADS", 8);
+    n_workers = CLAMP(n_workers, 1, nbfiles) - 1;
+    pthread_t workers[n_workers > 0 ? n_workers : 1];
+    int n_started = 0;
+    for (i = 0; i < n_workers; ++i) {
+        if (pthread_create(&workers[n_started], NULL, srm_bulk_prepare_worker, &prepare) == 0)
+            ++n_started;
+    }
+    srm_bulk_prepare_files(&prepare, handle);
+    for (i = 0; i < n_started; ++i) {
+        pthread_join(workers[i], NULL);
+    }
+
+    // One GET request for all the valid sources
+    n_pending = 0;
+    for (i = 0; i < nbfiles; ++i) {
+        if (files[i]->error == NULL) {
+            if (srm_source)
+                pending[n_pending++] = files[i];
+            else
+                g_strlcpy(files[i]->turl_source, files[i]->source, sizeof(files[i]->turl_source));
+        }
+    }
+    if (n_pending > 0)
+        srm_bulk_resolve_get(handle, params, pending, n_pending, token_source, sizeof(token_source));
+
+    // One PUT request for all the files with a source turl
+    n_pending = 0;
+    for (i = 0; i < nbfiles; ++i) {
+        if (files[i]->error == NULL) {
+            if (srm_destination)
+                pending[n_pending++] = files[i];
+            else
+                g_strlcpy(files[i]->turl_destination, files[i]->dest, sizeof(files[i]->turl_destination));
+        }
+    }
+    if (n_pending > 0)
+        srm_bulk_resolve_put(handle, params, pending, n_pending, token_destination, sizeof(token_destination));
+
+    plugin_trigger_event(params, srm_domain(), GFAL_EVENT_NONE,
+        GFAL_EVENT_PREPARE_EXIT, "%d files", nbfiles);
+
+    GError *cancel_error = NULL;
+    if (gfal_srm_check_cancel(context, &cancel_error)) {
+        for (i = 0; i < nbfiles; ++i) {
+            if (files[i]->error == NULL)
+                files[i]->error = g_error_copy(cancel_error);
+        }
+        g_error_free(cancel_error);
+    }
+
+    srm_bulk_transfer(context, params, files, nbfiles, srm_destination);
+
+    if (srm_destination)
+        srm_bulk_putdone(handle, params, files, nbfiles, token_destination);
+
+    if (checksum_mode & GFALT_CHECKSUM_TARGET) {
+        for (i = 0; i < nbfiles; ++i) {
+            srm_bulk_file_t *file = files[i];
+            if (file->transferred && file->error == NULL) {
+                srm_validate_destination_checksum(handle, context, params, file->dest,
+                    file->checksum_algorithm, file->checksum_user, file->checksum_source,
+                    &file->error);
+            }
+        }
+    }
+
+    srm_bulk_rollback_put(handle, context, files, nbfiles, token_destination);
+    srm_bulk_release_get(handle, files, nbfiles, token_source);
+}
+
+
+int srm_plugin_bulk_copy(plugin_handle handle, gfal2_context_t context, gfalt_params_t params,
+    size_t nbfiles, const char *const *srcs, const char *const *dsts, const char *const *checksums,
+    GError **op_error, GError ***file_errors)
+{
+    GError *tmp_err = NULL;
+    char checksum_algorithm[64] = {0};
+    char checksum_user[GFAL_URL_MAX_LEN] = {0};
+    gfalt_checksum_mode_t checksum_mode;
+    size_t i, j;
+    int ret = 0;
+
+    srm_get_checksum_config(context, params,
+        &checksum_mode,
+        checksum_algorithm, sizeof(checksum_algorithm),
+        checksum_user, sizeof(checksum_user),
+        &tmp_err);
+    if (tmp_err != NULL) {
+        gfal2_propagate_prefixed_error(op_error, tmp_err, __func__);
+        return -1;
+    }
+
+    size_t max_chunk = gfal2_get_opt_integer_with_default(context, srm_config_group, "COPY_BULK_SIZE", 100);
+    if (max_chunk < 1)
+        max_chunk = 1;
+
+    srm_bulk_file_t *files = g_new0(srm_bulk_file_t, nbfiles);
+    srm_bulk_file_t **chunk = g_new0(srm_bulk_file_t*, max_chunk);
+    size_t *order = g_new0(size_t, nbfiles);
+    size_t *chunks = g_new0(size_t, nbfiles);
+    *file_errors = g_new0(GError*, nbfiles);
+
+    for (i = 0; i < nbfiles; ++i) {
+        files[i].source = srcs[i];
+        files[i].dest = dsts[i];
+        srm_bulk_set_checksum(&files[i], checksum_algorithm, checksum_user,
+            checksums ? checksums[i] : NULL);
+    }
+
+    // Each SRM request goes to a single endpoint, and is limited in size by the servers
+    size_t n_chunks = srm_bulk_group(nbfiles, srcs, dsts, max_chunk, order, chunks);
+    size_t *next = order;
+    for (i = 0; i < n_chunks; ++i) {
+        for (j = 0; j < chunks[i]; ++j) {
+            chunk[j] = &files[next[j]];
+        }
+        gfal2_log(G_LOG_LEVEL_DEBUG, "SRM bulk copy of %zu files, from %s to %s",
+            chunks[i], srcs[next[0]], dsts[next[0]]);
+        srm_bulk_copy_chunk(handle, context, params, checksum_mode, chunk, chunks[i]);
+        next += chunks[i];
+    }
+
+    for (i = 0; i < nbfiles; ++i) {
+        if (files[i].error) {
+            gfal2_log(G_LOG_LEVEL_WARNING, "Transfer of %s failed with: %s", files[i].source,
+                files[i].error->message);
+            (*file_errors)[i] = files[i].error;
+            ret -= 1;
+        }
+    }
+
+    g_free(chunks);
+    g_free(order);
+    g_free(chunk);
+    g_free(files);
+    return ret;
+}
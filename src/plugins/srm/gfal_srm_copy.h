@@ -37,4 +37,23 @@ int srm_plugin_filecopy(plugin_handle handle, gfal2_context_t context,
     gfalt_params_t params,
     const char *src, const char *dst, GError **err);
 
+/**
+ * srm implementation of the plugin bulk copy
+ * The files are grouped by source and destination endpoint, and each group is
+ * resolved with a single multi-file PrepareToGet and PrepareToPut request
+ */
+int srm_plugin_bulk_copy(plugin_handle handle, gfal2_context_t context, gfalt_params_t params,
+    size_t nbfiles, const char *const *srcs, const char *const *dsts, const char *const *checksums,
+    GError **op_error, GError ***file_errors);
+
+/**
+ * Group the files of a bulk copy by source and destination endpoint
+ * The indexes of the files are written into order, the files of each group contiguous
+ * and in submission order. Each group is split in chunks of at most max_chunk files,
+ * whose sizes are written into chunks. Both arrays must hold nbfiles entries.
+ * @return the number of chunks
+ */
+size_t srm_bulk_group(size_t nbfiles, const char *const *srcs, const char *const *dsts,
+    size_t max_chunk, size_t *order, size_t *chunks);
+
 #endif
@@ -387,6 +387,118 @@ int gfal_srm_put_rd3_turl(plugin_handle ch, gfalt_params_t p, const char *surl,
 }
 
 
+// Multi-file GET or PUT, all the surls must belong to the same endpoint
+// Return the number of results, or -1 if the request failed as a whole
+static int gfal_srm_mTURLS_list_internal(gfal_srmv2_opt *opts, gfal_srm_params_t params,
+    srm_req_type req_type, int nbfiles, const char *const *surls, const size_t *file_sizes,
+    gfal_srm_result **resu, GError **err)
+{
+    GError *tmp_err = NULL;
+    int ret = -1;
+    int i;
+
+    gfal_srm_easy_t easy = gfal_srm_ifce_easy_context(opts, surls[0], &tmp_err);
+    if (easy != NULL) {
+        char *decoded[nbfiles];
+        for (i = 0; i < nbfiles; ++i) {
+            decoded[i] = gfal2_srm_get_decoded_path(surls[i]);
+        }
+
+        if (req_type == SRM_GET) {
+            struct srm_preparetoget_input preparetoget_input;
+            preparetoget_input.desiredpintime = 0;
+            preparetoget_input.nbfiles = nbfiles;
+            preparetoget_input.protocols = gfal_srm_params_get_protocols(params);
+            preparetoget_input.spacetokendesc = gfal_srm_params_get_spacetoken(params);
+            preparetoget_input.surls = decoded;
+            ret = gfal_srmv2_get_global(opts, params, easy->srm_context, &preparetoget_input, resu, &tmp_err);
+        }
+        else {
+            SRM_LONG64 filesizes[nbfiles];
+            for (i = 0; i < nbfiles; ++i) {
+                filesizes[i] = file_sizes ? file_sizes[i] : 0;
+            }
+
+            struct srm_preparetoput_input preparetoput_input;
+            preparetoput_input.desiredpintime = 0;
+            preparetoput_input.nbfiles = nbfiles;
+            preparetoput_input.protocols = gfal_srm_params_get_protocols(params);
+            preparetoput_input.spacetokendesc = gfal_srm_params_get_spacetoken(params);
+            preparetoput_input.surls = decoded;
+            preparetoput_input.filesizes = filesizes;
+            ret = gfal_srmv2_put_global(opts, params, easy->srm_context, &preparetoput_input, resu, &tmp_err);
+        }
+
+        for (i = 0; i < nbfiles; ++i) {
+            g_free(decoded[i]);
+        }
+    }
+    gfal_srm_ifce_easy_context_release(opts, easy);
+
+    if (ret >= 0 && validate_turls(ret, resu, params, &tmp_err)) {
+        ret = -1;
+    }
+    if (ret < 0) {
+        gfal2_propagate_prefixed_error(err, tmp_err, __func__);
+    }
+    return ret;
+}
+
+
+int gfal_srm_get_rd3_turls(plugin_handle ch, gfalt_params_t p, int nbfiles, const char *const *surls,
+    const char *other_surl, gfal_srm_result **resu, GError **err)
+{
+    gfal_srmv2_opt *opts = (gfal_srmv2_opt *) ch;
+    GError *tmp_err = NULL;
+    int ret = -1;
+
+    gfal_srm_params_t params = gfal_srm_params_new(opts);
+    if (params != NULL) {
+        gfal_srm_params_set_spacetoken(params, gfalt_get_src_spacetoken(p, NULL));
+        char **sup_protocols = srm_get_3rdparty_turls_sup_protocol(opts->handle);
+        reorder_rd3_sup_protocols(sup_protocols, other_surl);
+        gfal_srm_params_set_protocols(params, sup_protocols);
+
+        ret = gfal_srm_mTURLS_list_internal(opts, params, SRM_GET, nbfiles, surls, NULL, resu, &tmp_err);
+        gfal_srm_params_free(params);
+    }
+    G_RETURN_ERR(ret, tmp_err, err);
+}
+
+
+int gfal_srm_put_rd3_turls(plugin_handle ch, gfalt_params_t p, int nbfiles, const char *const *surls,
+    const size_t *file_sizes, const char *other_surl, gfal_srm_result **resu, GError **err)
+{
+    gfal_srmv2_opt *opts = (gfal_srmv2_opt *) ch;
+    GError *tmp_err = NULL;
+    int ret = -1;
+
+    gfal_srm_params_t params = gfal_srm_params_new(opts);
+    if (params != NULL) {
+        gfal_srm_params_set_spacetoken(params, gfalt_get_dst_spacetoken(p, NULL));
+        char **sup_protocols = srm_get_3rdparty_turls_sup_protocol(opts->handle);
+        reorder_rd3_sup_protocols(sup_protocols, other_surl);
+        gfal_srm_params_set_protocols(params, sup_protocols);
+
+        ret = gfal_srm_mTURLS_list_internal(opts, params, SRM_PUT, nbfiles, surls, file_sizes, resu, &tmp_err);
+        gfal_srm_params_free(params);
+    }
+    G_RETURN_ERR(ret, tmp_err, err);
+}
+
+
+void gfal_srm_result_list_free(gfal_srm_result *resu, int n)
+{
+    int i;
+    if (resu == NULL)
+        return;
+    for (i = 0; i < n; ++i) {
+        g_free(resu[i].reqtoken);
+    }
+    free(resu);
+}
+
+
 //  simple wrapper to putTURLs for the gfal_module layer
 int gfal_srm_putTURLS_plugin(plugin_handle ch, const char *surl, char *buff_turl, int size_turl, char **reqtoken,
     GError **err)
@@ -526,6 +638,67 @@ int gfal_srm_putdone(gfal_srmv2_opt *opts, const char *surl, const char *token,
 }
 
 
+int gfal_srm_putdone_list(gfal_srmv2_opt *opts, int nbfiles, const char *const *surls, const char *token,
+    GError **errors)
+{
+    GError *tmp_err = NULL;
+    struct srm_putdone_input putdone_input;
+    struct srmv2_filestatus *statuses = NULL;
+    int ret = -1;
+    int i;
+
+    gfal_srm_easy_t easy = gfal_srm_ifce_easy_context(opts, surls[0], &tmp_err);
+    if (easy != NULL) {
+        char *decoded[nbfiles];
+        for (i = 0; i < nbfiles; ++i) {
+            decoded[i] = gfal2_srm_get_decoded_path(surls[i]);
+        }
+
+        putdone_input.nbfiles = nbfiles;
+        putdone_input.reqtoken = (char *) token;
+        putdone_input.surls = decoded;
+
+        gfal2_log(G_LOG_LEVEL_DEBUG, "    [gfal_srm_putdone_list] start srm put done on %d files", nbfiles);
+        ret = gfal_srm_external_call.srm_put_done(easy->srm_context, &putdone_input, &statuses);
+        if (ret < 0) {
+            gfal2_set_error(&tmp_err, gfal2_get_plugin_srm_quark(), errno, __func__,
+                "call to srm_ifce error: %s", easy->srm_context->errbuf);
+        }
+        else {
+            int n_statuses = ret;
+            ret = 0;
+            for (i = 0; i < nbfiles; ++i) {
+                if (i >= n_statuses) {
+                    gfal2_set_error(&errors[i], gfal2_get_plugin_srm_quark(), EBADMSG, __func__,
+                        "No status returned for %s while putdone", surls[i]);
+                    ret -= 1;
+                }
+                else if (statuses[i].status != 0) {
+                    gfal2_set_error(&errors[i], gfal2_get_plugin_srm_quark(), statuses[i].status, __func__,
+                        "Error on the surl %s while putdone : %s", surls[i], statuses[i].explanation);
+                    ret -= 1;
+                }
+            }
+            gfal_srm_external_call.srm_srmv2_filestatus_delete(statuses, n_statuses);
+        }
+
+        for (i = 0; i < nbfiles; ++i) {
+            g_free(decoded[i]);
+        }
+    }
+    gfal_srm_ifce_easy_context_release(opts, easy);
+
+    if (tmp_err) {
+        for (i = 0; i < nbfiles; ++i) {
+            errors[i] = g_error_copy(tmp_err);
+        }
+        g_error_free(tmp_err);
+        ret = -1;
+    }
+    return ret;
+}
+
+
 static int srmv2_abort_request_internal(srm_context_t context, const char *surl,
     const char *req_token, GError **err)
 {
@@ -30,6 +30,17 @@ int gfal_srm_get_rd3_turl(plugin_handle ch, gfalt_params_t params,
     char *reqtoken, size_t size_reqtoken,
     GError **err);
 
+// Multi-file versions for bulk copies. All the surls must belong to the same endpoint
+// resu receives one result per file, to be released with gfal_srm_result_list_free
+// Return the number of results, or -1 if the request failed as a whole
+int gfal_srm_get_rd3_turls(plugin_handle ch, gfalt_params_t params, int nbfiles, const char *const *surls,
+    const char *other_surl, gfal_srm_result **resu, GError **err);
+
+int gfal_srm_put_rd3_turls(plugin_handle ch, gfalt_params_t params, int nbfiles, const char *const *surls,
+    const size_t *file_sizes, const char *other_surl, gfal_srm_result **resu, GError **err);
+
+void gfal_srm_result_list_free(gfal_srm_result *resu, int n);
+
 int gfal_srm_getTURL_checksum(plugin_handle ch, const char *surl,
     char *buff_turl, int size_turl, GError **err);
 
@@ -142,6 +142,11 @@ int gfal_srm_putTURLS_plugin(plugin_handle ch, const char *surl, char *buff_turl
 
 int gfal_srm_putdone(gfal_srmv2_opt *opts, const char *surl, const char *token, GError **err);
 
+// PutDone of several files of the same PUT request. errors receives one entry per file
+// Return 0 on success, or the opposite of the number of failed files
+int gfal_srm_putdone_list(gfal_srmv2_opt *opts, int nbfiles, const char *const *surls, const char *token,
+    GError **errors);
+
 void gfal_srm_report_error(char *errbuff, GError **err);
 
 gfal_srm_easy_t gfal_srm_ifce_easy_context(gfal_srmv2_opt *opts,
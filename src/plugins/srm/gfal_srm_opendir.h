@@ -58,3 +58,6 @@ int gfal_srm_closedirG(plugin_handle handle, gfal_file_handle fh, GError **err);
 struct dirent *gfal_srm_readdirG(plugin_handle handle, gfal_file_handle fh, GError **err);
 
 struct dirent *gfal_srm_readdirppG(plugin_handle ch, gfal_file_handle fh, struct stat *st, GError **err);
+
+ssize_t gfal_srm_readdir_batchG(plugin_handle ch, gfal_file_handle fh,
+    gfal2_dir_entry_t *entries, size_t nentries, GError **err);
@@ -155,6 +155,23 @@ static int gfal_srm_readdir_internal(plugin_handle ch,
 }
 
 
+/**
+ * If chunk listing, and the index passed the last entry in the buffer,
+ * release, and prepare next bulk
+ * Returns 1 if the chunk was released
+ */
+static int gfal_srm_readdir_end_of_chunk(gfal_srm_opendir_handle oh)
+{
+    if (oh->is_chunked_listing && oh->response_index >= oh->chunk_size) {
+        oh->chunk_offset += oh->chunk_size;
+        gfal_srm_external_call.srm_srmv2_mdfilestatus_delete(oh->srm_file_statuses, 1);
+        oh->srm_file_statuses = NULL;
+        return 1;
+    }
+    return 0;
+}
+
+
 /**
  * Wraps the SRM request.
  * Request each chunks, then iterates through the responses as readdir is called
@@ -189,13 +206,7 @@ static struct dirent *gfal_srm_readdir_pipeline(plugin_handle ch,
         st, &tmp_err);
     oh->response_index++;
 
-    // If chunk listing, and the index passed the last entry in the buffer,
-    // release, and prepare next bulk
-    if (oh->is_chunked_listing && oh->response_index >= oh->chunk_size) {
-        oh->chunk_offset += oh->chunk_size;
-        gfal_srm_external_call.srm_srmv2_mdfilestatus_delete(oh->srm_file_statuses, 1);
-        oh->srm_file_statuses = NULL;
-    }
+    gfal_srm_readdir_end_of_chunk(oh);
 
     return ret;
 }
@@ -256,3 +267,43 @@ struct dirent *gfal_srm_readdirppG(plugin_handle ch,
     }
     return ret;
 }
+
+
+/**
+ * Read + Stat of several entries
+ * The first entry may need a new chunk to be requested, the others are converted
+ * straight from the chunk already in memory
+ */
+ssize_t gfal_srm_readdir_batchG(plugin_handle ch, gfal_file_handle fh,
+    gfal2_dir_entry_t *entries, size_t nentries, GError **err)
+{
+    g_return_val_err_if_fail(ch && fh && entries, -1, err, "[gfal_srm_readdir_batchG] Invalid args");
+    GError *tmp_err = NULL;
+    gfal_srm_opendir_handle oh = (gfal_srm_opendir_handle)gfal_file_handle_get_fdesc(fh);
+
+    struct dirent *first = gfal_srm_readdirppG(ch, fh, &entries[0].st, &tmp_err);
+    if (first == NULL) {
+        if (tmp_err) {
+            gfal2_propagate_prefixed_error(err, tmp_err, __func__);
+            return -1;
+        }
+        return 0;
+    }
+    memcpy(&entries[0].dirent, first, sizeof(struct dirent));
+
+    size_t i = 1;
+    while (i < nentries && oh->srm_file_statuses != NULL &&
+           oh->response_index < oh->srm_file_statuses->nbsubpaths) {
+        memset(&entries[i].dirent, 0, sizeof(struct dirent));
+        gfal_srm_readdir_convert_result(ch, oh->surl,
+            &oh->srm_file_statuses->subpaths[oh->response_index], &entries[i].dirent,
+            &entries[i].st, &tmp_err);
+        oh->response_index++;
+        i++;
+        // The next chunk is left to the next call
+        if (gfal_srm_readdir_end_of_chunk(oh))
+            break;
+    }
+
+    return i;
+}
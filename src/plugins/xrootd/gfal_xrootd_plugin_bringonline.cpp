@@ -18,13 +18,226 @@
 #include "gfal_xrootd_plugin_interface.h"
 #include "gfal_xrootd_plugin_utils.h"
 
+#include <functional>
 #include <memory>
 #include <set>
+#include <map>
+#include <mutex>
+#include <condition_variable>
+#include <sstream>
 #include <algorithm>
 #include <json.h>
 #include <XrdCl/XrdClFileSystem.hh>
 #include <XrdSys/XrdSysPthread.hh>
 
+// Waits for a set of asynchronous requests to complete
+class AsyncCountdown {
+public:
+    explicit AsyncCountdown(size_t count): remaining(count) {}
+
+    void Done()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        --remaining;
+        cv.notify_all();
+    }
+
+    void Wait()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        cv.wait(lock, [this]() { return remaining == 0; });
+    }
+
+private:
+    std::mutex mutex;
+    std::condition_variable cv;
+    size_t remaining;
+};
+
+
+// Keeps the status and the response body of an asynchronous Prepare or Query
+class BufferResponseHandler: public XrdCl::ResponseHandler {
+public:
+    explicit BufferResponseHandler(AsyncCountdown& countdown): countdown(countdown) {}
+
+    void HandleResponse(XrdCl::XRootDStatus* st, XrdCl::AnyObject* response)
+    {
+        status = *st;
+        if (response) {
+            XrdCl::Buffer* buffer = 0;
+            response->Get(buffer);
+            if (buffer && buffer->GetBuffer()) {
+                content.assign(buffer->GetBuffer(), buffer->GetSize());
+            }
+        }
+        delete st;
+        delete response;
+        countdown.Done();
+    }
+
+    // To be called if the request could not be sent, so the handler will never be called
+    void Failed(const XrdCl::XRootDStatus& st)
+    {
+        status = st;
+        countdown.Done();
+    }
+
+    XrdCl::XRootDStatus status;
+    std::string content;
+
+private:
+    AsyncCountdown& countdown;
+};
+
+
+// Files of a bulk request that belong to the same endpoint
+struct EndpointBatch {
+    std::string host;               // host[:port], as used in composite tokens
+    std::string reqid;              // request ID for this endpoint (polling, abort)
+    XrdCl::URL endpoint;
+    std::vector<int> files;         // indexes into the caller's URL list
+    std::vector<std::string> paths; // same order as "files"
+    std::unique_ptr<XrdCl::FileSystem> fs;
+    std::unique_ptr<BufferResponseHandler> handler;
+};
+
+
+// Group the URLs by endpoint, keeping the order in which the endpoints first appear
+static std::vector<EndpointBatch> partition_by_endpoint(gfal2_context_t context,
+    int nbfiles, const char* const* urls)
+{
+    std::vector<EndpointBatch> batches;
+    std::map<std::string, size_t> positions;
+
+    for (int i = 0; i < nbfiles; ++i) {
+        XrdCl::URL url(prepare_url(context, urls[i]));
+        std::stringstream host;
+        host << url.GetHostName() << ":" << url.GetPort();
+
+        auto it = positions.find(host.str());
+        if (it == positions.end()) {
+            positions[host.str()] = batches.size();
+            batches.emplace_back();
+            batches.back().host = host.str();
+            batches.back().endpoint = url;
+            batches.back().endpoint.SetPath(std::string());
+            it = positions.find(host.str());
+        }
+
+        std::string path = url.GetPath();
+        EndpointBatch& batch = batches[it->second];
+        batch.files.push_back(i);
+        batch.paths.push_back(path);
+    }
+
+    return batches;
+}
+
+
+// Assign the request ID of each endpoint from the (possibly composite) token
+// Return false if the token does not mention one of the endpoints
+static bool assign_request_ids(std::vector<EndpointBatch>& batches, const char* token)
+{
+    std::string strtoken(token ? token : "");
+    bool complete = true;
+
+    for (auto& batch : batches) {
+        batch.reqid = xrootd_token_request_id(strtoken, batch.host);
+        if (batch.reqid.empty()) {
+            complete = false;
+        }
+    }
+    return complete;
+}
+
+
+// Send one request per batch and wait for all of them
+// "send" must issue the asynchronous call using the given handler
+static void dispatch_batches(std::vector<EndpointBatch>& batches,
+    const std::function<XrdCl::XRootDStatus(EndpointBatch&, BufferResponseHandler*)>& send)
+{
+    AsyncCountdown countdown(batches.size());
+
+    for (auto& batch : batches) {
+        batch.fs.reset(new XrdCl::FileSystem(batch.endpoint));
+        batch.handler.reset(new BufferResponseHandler(countdown));
+
+        XrdCl::XRootDStatus st = send(batch, batch.handler.get());
+        if (!st.IsOK()) {
+            batch.handler->Failed(st);
+        }
+    }
+
+    countdown.Wait();
+}
+
+
+// Set the same error for all the files of a batch
+static void set_batch_error(const EndpointBatch& batch, GError* tmp_err, GError** err)
+{
+    for (int i : batch.files) {
+        err[i] = g_error_copy(tmp_err);
+    }
+}
+
+
+// Final polling results (online, or permanent failure) for files already seen by this process,
+// so repeated polls only query files still in progress.
+class PollResultCache {
+public:
+    // Entries are dropped in bulk past this size. Enough for the files of the
+    // bulk requests polled at the same time by a process, at a few MB at most
+    static const size_t MAX_ENTRIES = 20000;
+
+    // Return true if a final result is known. If the result was an error, "err" is set.
+    bool Get(const std::string& reqid, const std::string& path, GError** err)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = results.find(Key(reqid, path));
+        if (it == results.end()) {
+            return false;
+        }
+        if (it->second.code != 0) {
+            gfal2_set_error(err, xrootd_domain, it->second.code, __func__, "%s", it->second.message.c_str());
+        }
+        return true;
+    }
+
+    void Put(const std::string& reqid, const std::string& path, int code, const std::string& message)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (results.size() >= MAX_ENTRIES) {
+            results.clear();
+        }
+        results[Key(reqid, path)] = Result{code, message};
+    }
+
+    void Forget(const std::string& reqid)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = results.lower_bound(Key(reqid, ""));
+        while (it != results.end() && it->first.compare(0, reqid.size() + 1, reqid + '\n') == 0) {
+            it = results.erase(it);
+        }
+    }
+
+private:
+    struct Result {
+        int code;
+        std::string message;
+    };
+
+    static std::string Key(const std::string& reqid, const std::string& path)
+    {
+        return reqid + '\n' + path;
+    }
+
+    std::mutex mutex;
+    std::map<std::string, Result> results;
+};
+
+static PollResultCache poll_result_cache;
+
 
 int gfal_xrootd_bring_online_list(plugin_handle plugin_data,
     int nbfiles, const char* const* urls, time_t pintime, time_t timeout, char* token, size_t tsize,
@@ -35,39 +248,63 @@ int gfal_xrootd_bring_online_list(plugin_handle plugin_data,
     }
 
     gfal2_context_t context = (gfal2_context_t)plugin_data;
+    std::vector<EndpointBatch> batches = partition_by_endpoint(context, nbfiles, urls);
 
-    XrdCl::URL endpoint(prepare_url(context, urls[0]));
-    endpoint.SetPath(std::string());
-    XrdCl::FileSystem fs(endpoint);
+    // One asynchronous Prepare per endpoint, all of them in flight at once
+    dispatch_batches(batches, [timeout](EndpointBatch& batch, BufferResponseHandler* handler) {
+        return batch.fs->Prepare(batch.paths, XrdCl::PrepareFlags::Flags::Stage, 0, handler, timeout);
+    });
 
-    std::vector<std::string> fileList;
-    for (int i = 0; i < nbfiles; ++i) {
-        XrdCl::URL file(prepare_url(context, urls[i]));
-        fileList.emplace_back(file.GetPath());
+    std::vector<std::pair<std::string, std::string>> reqids;
+    int failed = 0;
+
+    for (auto& batch : batches) {
+        const XrdCl::XRootDStatus& st = batch.handler->status;
+        GError *tmp_err = NULL;
+
+        if (!st.IsOK()) {
+            gfal2_set_error(&tmp_err, xrootd_domain, xrootd_status_to_posix_errno(st), __func__,
+                            "Bringonline request failed. One or more files failed with: %s", st.ToString().c_str());
+        } else {
+            // The response may or may not be null terminated
+            std::string& content = batch.handler->content;
+            content = content.substr(0, content.find('\0'));
+            if (content.empty()) {
+                gfal2_log(G_LOG_LEVEL_DEBUG, "Empty response from the server %s", batch.host.c_str());
+                gfal2_set_error(&tmp_err, xrootd_domain, ENOMSG, __func__,
+                                "Empty response from the server %s", batch.host.c_str());
+            }
+        }
+
+        if (tmp_err) {
+            set_batch_error(batch, tmp_err, err);
+            g_error_free(tmp_err);
+            failed += batch.files.size();
+            reqids.emplace_back(batch.host, std::string());
+            continue;
+        }
+
+        reqids.emplace_back(batch.host, batch.handler->content);
     }
 
-    XrdCl::Buffer *responsePtr = 0;
-    XrdCl::Status st = fs.Prepare(fileList, XrdCl::PrepareFlags::Flags::Stage, 0, responsePtr, timeout);
+    if (failed == nbfiles) {
+        return -1;
+    }
 
-    if (!st.IsOK()) {
+    const std::string strtoken = xrootd_compose_token(reqids);
+    if (strtoken.size() >= tsize) {
         GError *tmp_err = NULL;
-        gfal2_set_error(&tmp_err, xrootd_domain, xrootd_status_to_posix_errno(st), __func__,
-                        "Bringonline request failed. One or more files failed with: %s", st.ToString().c_str());
+        gfal2_set_error(&tmp_err, xrootd_domain, ENOBUFS, __func__,
+                        "The request IDs of the %zu endpoints do not fit in the token buffer", batches.size());
         for (int i = 0; i < nbfiles; ++i) {
+            g_clear_error(&err[i]);
             err[i] = g_error_copy(tmp_err);
         }
         g_error_free(tmp_err);
-        delete responsePtr;
         return -1;
     }
-    if (responsePtr && responsePtr->GetBuffer()) {
-        copy_to_cstring(token, tsize, responsePtr->GetBuffer(), responsePtr->GetSize());
-    } else {
-        gfal2_log(G_LOG_LEVEL_DEBUG, "Empty response from the server");
-        delete responsePtr;
-        return -1;
-    }
-    delete responsePtr;
+
+    copy_to_cstring(token, tsize, strtoken.c_str(), strtoken.size());
     return 0;
 }
 
@@ -80,207 +317,278 @@ int gfal_xrootd_bring_online_list_v2(plugin_handle plugin_data,
 }
 
 
-int gfal_xrootd_bring_online_poll_list(plugin_handle plugin_data,
-    int nbfiles, const char* const* urls, const char* token, GError** err)
+// Interpret one entry of a query prepare response
+// Return 1 if the file is online, 0 if it is still being brought online (EAGAIN is set),
+// -1 on error
+static int evaluate_prepare_response(struct json_object *arrobj, const std::string& path,
+    const std::string& reqid, GError** err)
 {
-    if (nbfiles <= 0) {
-        return 1;
+    // get the error_text attribute
+    // Note: if it exists, this text should be appened to all other error messages
+    struct json_object *arrobj_error_text = 0;
+    json_object_object_get_ex( arrobj, "error_text", &arrobj_error_text );
+    std::string error_text;
+
+    if( !arrobj_error_text )
+    {
+      gfal2_set_error( err, xrootd_domain, ENOMSG, __func__, "Error attribute missing." );
+      return -1;
+    } else {
+      error_text = json_object_get_string( arrobj_error_text );
     }
-    gfal2_context_t context = (gfal2_context_t)plugin_data;
 
-    XrdCl::URL endpoint(prepare_url(context, urls[0]));
-    endpoint.SetPath(std::string());
-    XrdCl::FileSystem fs(endpoint);
+    // get the path_exists attribute
+    // Note: CTA changed from "exists" to "path_exists".
+    //       Keep a fallback to "exists" for the time being.
+    struct json_object *arrobj_exists = 0;
+    json_object_object_get_ex( arrobj, "path_exists", &arrobj_exists );
+    bool path_exists = json_obj_to_bool(arrobj_exists);
+    if( !path_exists )
+    {
+      // Try "exists" fallback
+      json_object_object_get_ex( arrobj, "exists", &arrobj_exists );
+      bool exists = json_obj_to_bool(arrobj_exists);
+      if ( !exists )
+      {
+        gfal2_xrootd_poll_set_error( err, ENOENT, __func__, error_text.c_str(),
+                                     "File does not exist: %s", path.c_str() );
+        return -1;
+      }
+    }
 
-    std::set<std::string> paths;
-    std::string strarg = token;
-    for( int i = 0; i < nbfiles; ++i )
+    // get the online attribute
+    struct json_object *arrobj_online = 0;
+    json_object_object_get_ex( arrobj, "online", &arrobj_online );
+    bool online = json_obj_to_bool(arrobj_online);
+    if( online )
+      return 1;
+
+    // get the requested attribute
+    struct json_object *arrobj_requested = 0;
+    json_object_object_get_ex( arrobj, "requested", &arrobj_requested );
+    bool requested = json_obj_to_bool(arrobj_requested);
+    if( !requested )
     {
-      strarg += '\n';
-      XrdCl::URL url( prepare_url( context, urls[i] ) );
-      std::string path = url.GetPath();
-      // collapse redundant slashes
-      collapse_slashes( path );
-      strarg += path;
-      paths.insert( path );
+      gfal2_xrootd_poll_set_error( err, ENOMSG, __func__, error_text.c_str(),
+                                  "File is not being brought online: %s", path.c_str() );
+      return -1;
+    }
+
+    // get the has_reqid attribute
+    struct json_object *arrobj_has_reqid = 0;
+    json_object_object_get_ex( arrobj, "has_reqid", &arrobj_has_reqid );
+    bool has_reqid = json_obj_to_bool(arrobj_has_reqid);
+    if( !has_reqid )
+    {
+      gfal2_xrootd_poll_set_error( err, ENOMSG, __func__, error_text.c_str(),
+                                   "File (%s) is not included in the bring online request: %s",
+                                   path.c_str(), reqid.c_str() );
+      return -1;
+    }
+
+    // get the req_time attribute
+    struct json_object *arrobj_req_time = 0;
+    json_object_object_get_ex( arrobj, "req_time", &arrobj_req_time );
+    std::string req_time = arrobj_req_time ? json_object_get_string( arrobj_req_time ) : "";
+    if( !req_time.empty() )
+      gfal2_log( G_LOG_LEVEL_DEBUG, "File (%s) has been requested at: %s",
+                 path.c_str(), req_time.c_str() );
+    else
+    {
+      gfal2_xrootd_poll_set_error( err, ENOMSG, __func__, error_text.c_str(),
+                                   "Bring-online timestamp missing." );
+      return -1;
+    }
+
+    if( !error_text.empty() )
+    {
+      gfal2_set_error( err, xrootd_domain, ENOMSG, __func__, "%s", error_text.c_str() );
+      return -1;
     }
 
-    XrdCl::Buffer  arg; arg.FromString( strarg );
-    XrdCl::Buffer *resp = 0;
+    // if there is no error but the file is not online set EAGAIN
+    gfal2_set_error( err, xrootd_domain, EAGAIN, __func__,
+                     "File (%s) is not yet online.", path.c_str() );
+    return 0;
+}
 
-    gfal2_log( G_LOG_LEVEL_DEBUG, "Issuing query prepare." );
-    XrdCl::XRootDStatus st = fs.Query( XrdCl::QueryCode::Prepare, arg, resp );
+
+// Parse the query prepare response of one endpoint, setting the result of each of its files
+// Final results are remembered, so later polls do not query those files again
+static void parse_query_prepare(const EndpointBatch& batch, GError** err, int& onlinecnt, int& errorcnt)
+{
+    const XrdCl::XRootDStatus& st = batch.handler->status;
 
     if( !st.IsOK() )
     {
       gfal2_log( G_LOG_LEVEL_WARNING, "Query prepare failed: %s", st.ToString().c_str() );
-      for( int i = 0; i < nbfiles; ++i )
+      for( int i : batch.files )
         gfal2_set_error(&err[i], xrootd_domain, xrootd_status_to_posix_errno(st, true),
                         __func__, "%s", st.ToString().c_str() );
-      return -1;
+      errorcnt += batch.files.size();
+      return;
     }
 
-    std::string jsonresp = resp->ToString();
-    delete resp;
-
-    struct json_object *parsed_json = json_tokener_parse( jsonresp.c_str() );
+    struct json_object *parsed_json = json_tokener_parse( batch.handler->content.c_str() );
     if( !parsed_json )
     {
-      for( int i = 0; i < nbfiles; ++i )
+      for( int i : batch.files )
         gfal2_set_error( &err[i], xrootd_domain, ENOMSG, __func__, "Failed to parse JSON object in the server response." );
-      return -1;
+      errorcnt += batch.files.size();
+      return;
     }
 
-    struct json_object *request_id;
+    struct json_object *request_id = 0;
     json_object_object_get_ex( parsed_json, "request_id", &request_id );
     std::string reqid = request_id ? json_object_get_string( request_id ) : "";
-    if( reqid.empty() || reqid != token )
+    if( reqid.empty() || reqid != batch.reqid )
     {
-      for( int i = 0; i < nbfiles; ++i )
+      for( int i : batch.files )
         gfal2_set_error( &err[i], xrootd_domain, ENOMSG, __func__, "%s", "Request ID mismatch." );
-      return -1;
+      errorcnt += batch.files.size();
+      json_object_put(parsed_json);
+      return;
     }
 
-    int onlinecnt = 0;
-    int errorcnt  = 0;
-
     // now iterate over the file list
     struct json_object *responses = 0;
     json_object_object_get_ex( parsed_json, "responses", &responses );
-    int size = responses ? json_object_array_length( responses ) : 0;
-    if( size != nbfiles )
+    size_t size = responses ? json_object_array_length( responses ) : 0;
+    if( size != batch.files.size() )
     {
-      for( int i = 0; i < nbfiles; ++i )
+      for( int i : batch.files )
         gfal2_set_error( &err[i], xrootd_domain, ENOMSG, __func__,
                          "Number of files in the request does not match!" );
-      return -1;
+      errorcnt += batch.files.size();
+      json_object_put(parsed_json);
+      return;
     }
 
-    for( int i = 0; i < size; ++i )
-    {
-      // get the i-th object in the array
-      struct json_object *arrobj = json_object_array_get_idx( responses, i );
-      if( !arrobj )
-      {
-        ++errorcnt;
-        gfal2_set_error(&err[i], xrootd_domain, ENOMSG, __func__, "Failed to parse \"responses\" array." );
-        continue;
-      }
-
-      // get the error_text attribute
-      // Note: if it exists, this text should be appened to all other error messages
-      struct json_object *arrobj_error_text = 0;
-      json_object_object_get_ex( arrobj, "error_text", &arrobj_error_text );
-      std::string error_text;
-
-      if( !arrobj_error_text )
-      {
-        ++errorcnt;
-        gfal2_set_error( &err[i], xrootd_domain, ENOMSG, __func__, "Error attribute missing." );
-        continue;
-      } else {
-        error_text = json_object_get_string( arrobj_error_text );
-      }
+    // responses are matched by path, the server is not required to keep the order
+    std::multimap<std::string, int> pending;
+    for( size_t k = 0; k < batch.files.size(); ++k )
+      pending.emplace( batch.paths[k], batch.files[k] );
 
-      // get the path attribute
+    for( size_t k = 0; k < size; ++k )
+    {
+      struct json_object *arrobj = json_object_array_get_idx( responses, k );
       struct json_object *arrobj_path = 0;
-      json_object_object_get_ex( arrobj, "path", &arrobj_path );
+      if( arrobj )
+        json_object_object_get_ex( arrobj, "path", &arrobj_path );
       std::string path = arrobj_path ? json_object_get_string( arrobj_path ) : "";
       // collapse redundant slashes
       collapse_slashes( path );
-      if( path.empty() || !paths.count( path ) )
-      { // it's not our file, this is an error
-        ++errorcnt;
-        gfal2_xrootd_poll_set_error( &err[i], ENOMSG, __func__, error_text.c_str(),
-                                     "Wrong path: %s", path.c_str() );
+
+      auto range = pending.equal_range( path );
+      if( range.first == range.second )
+      {
+        gfal2_log( G_LOG_LEVEL_DEBUG, "Unexpected path in query prepare response: %s", path.c_str() );
         continue;
       }
 
-      // get the path_exists attribute
-      // Note: CTA changed from "exists" to "path_exists".
-      //       Keep a fallback to "exists" for the time being.
-      struct json_object *arrobj_exists = 0;
-      json_object_object_get_ex( arrobj, "path_exists", &arrobj_exists );
-      bool path_exists = json_obj_to_bool(arrobj_exists);
-      if( !path_exists )
+      GError *tmp_err = NULL;
+      int ret = evaluate_prepare_response( arrobj, path, reqid, &tmp_err );
+
+      if( ret == 1 )
+        poll_result_cache.Put( reqid, path, 0, "" );
+      else if( ret < 0 )
+        poll_result_cache.Put( reqid, path, tmp_err->code, tmp_err->message );
+
+      for( auto it = range.first; it != range.second; ++it )
       {
-        // Try "exists" fallback
-        json_object_object_get_ex( arrobj, "exists", &arrobj_exists );
-        bool exists = json_obj_to_bool(arrobj_exists);
-        if ( !exists )
-        {
+        if( ret == 1 )
+          ++onlinecnt;
+        else
+          err[it->second] = g_error_copy( tmp_err );
+        if( ret < 0 )
           ++errorcnt;
-          gfal2_xrootd_poll_set_error( &err[i], ENOENT, __func__, error_text.c_str(),
-                                       "File does not exist: %s", path.c_str() );
-          continue;
-        }
       }
+      pending.erase( range.first, range.second );
+      g_clear_error( &tmp_err );
+    }
 
-      // get the online attribute
-      struct json_object *arrobj_online = 0;
-      json_object_object_get_ex( arrobj, "online", &arrobj_online );
-      bool online = json_obj_to_bool(arrobj_online);
-      if( online )
-      {
-        ++onlinecnt;
-        continue;
-      }
+    // files the server did not talk about
+    for( const auto& file : pending )
+    {
+      ++errorcnt;
+      gfal2_xrootd_poll_set_error( &err[file.second], ENOMSG, __func__, NULL,
+                                   "Wrong path: %s", file.first.c_str() );
+    }
 
-      // get the requested attribute
-      struct json_object *arrobj_requested = 0;
-      json_object_object_get_ex( arrobj, "requested", &arrobj_requested );
-      bool requested = json_obj_to_bool(arrobj_requested);
-      if( !requested )
-      {
-        ++errorcnt;
-        gfal2_xrootd_poll_set_error( &err[i], ENOMSG, __func__, error_text.c_str(),
-                                    "File is not being brought online: %s", path.c_str() );
-        continue;
-      }
+    // Free the top JSON object
+    json_object_put(parsed_json);
+}
 
-      // get the has_reqid attribute
-      struct json_object *arrobj_has_reqid = 0;
-      json_object_object_get_ex( arrobj, "has_reqid", &arrobj_has_reqid );
-      bool has_reqid = json_obj_to_bool(arrobj_has_reqid);
-      if( !has_reqid )
-      {
-        ++errorcnt;
-        gfal2_xrootd_poll_set_error( &err[i], ENOMSG, __func__, error_text.c_str(),
-                                     "File (%s) is not included in the bring online request: %s",
-                                     path.c_str(), token );
-        continue;
-      }
 
-      // get the req_time attribute
-      struct json_object *arrobj_req_time = 0;
-      json_object_object_get_ex( arrobj, "req_time", &arrobj_req_time );
-      std::string req_time = arrobj_req_time ? json_object_get_string( arrobj_req_time ) : "";
-      if( !req_time.empty() )
-        gfal2_log( G_LOG_LEVEL_DEBUG, "File (%s) has been requested at: %s",
-                   path.c_str(), req_time.c_str() );
-      else
-      {
-        ++errorcnt;
-        gfal2_xrootd_poll_set_error( &err[i], ENOMSG, __func__, error_text.c_str(),
-                                     "Bring-online timestamp missing." );
-        continue;
-      }
+int gfal_xrootd_bring_online_poll_list(plugin_handle plugin_data,
+    int nbfiles, const char* const* urls, const char* token, GError** err)
+{
+    if (nbfiles <= 0) {
+        return 1;
+    }
+    gfal2_context_t context = (gfal2_context_t)plugin_data;
+
+    std::vector<EndpointBatch> batches = partition_by_endpoint(context, nbfiles, urls);
+    assign_request_ids(batches, token);
+
+    int onlinecnt = 0;
+    int errorcnt  = 0;
+
+    // Only query the files whose final state is not known yet
+    std::vector<EndpointBatch> queries;
+    for( auto& batch : batches )
+    {
+      EndpointBatch query;
+      query.host = batch.host;
+      query.reqid = batch.reqid;
+      query.endpoint = batch.endpoint;
 
-      if( !error_text.empty() )
+      for( size_t k = 0; k < batch.files.size(); ++k )
       {
-        ++errorcnt;
-        gfal2_set_error( &err[i], xrootd_domain, ENOMSG, __func__, "%s", error_text.c_str() );
-        continue;
+        int i = batch.files[k];
+        std::string path = batch.paths[k];
+        // collapse redundant slashes
+        collapse_slashes( path );
+
+        if( batch.reqid.empty() )
+        {
+          ++errorcnt;
+          gfal2_set_error( &err[i], xrootd_domain, ENOMSG, __func__,
+                           "No request ID for endpoint %s in token %s", batch.host.c_str(), token );
+        }
+        else if( poll_result_cache.Get( batch.reqid, path, &err[i] ) )
+        {
+          if( err[i] )
+            ++errorcnt;
+          else
+            ++onlinecnt;
+        }
+        else
+        {
+          query.files.push_back( i );
+          query.paths.push_back( path );
+        }
       }
 
-      // if there is no error but the file is not online set EAGAIN
-      if( !online )
-        gfal2_set_error( &err[i], xrootd_domain, EAGAIN, __func__,
-                         "File (%s) is not yet online.", path.c_str() );
+      if( !query.files.empty() )
+        queries.push_back( std::move( query ) );
     }
 
-    // Free the top JSON object
-    json_object_put(parsed_json);
+    const uint16_t op_timeout = xrootd_operation_timeout( context );
+    gfal2_log( G_LOG_LEVEL_DEBUG, "Issuing query prepare to %zu endpoint(s).", queries.size() );
+    dispatch_batches( queries, [op_timeout](EndpointBatch& batch, BufferResponseHandler* handler) {
+      std::string strarg = batch.reqid;
+      for( const auto& path : batch.paths )
+      {
+        strarg += '\n';
+        strarg += path;
+      }
+      XrdCl::Buffer arg; arg.FromString( strarg );
+      return batch.fs->Query( XrdCl::QueryCode::Prepare, arg, handler, op_timeout );
+    });
+
+    for( const auto& query : queries )
+      parse_query_prepare( query, err, onlinecnt, errorcnt );
 
     // if all files are online return 1
     if( onlinecnt == nbfiles ) return 1;
@@ -300,33 +608,29 @@ int gfal_xrootd_release_file_list(plugin_handle plugin_data,
     int nbfiles, const char* const* urls, const char* token, GError** err)
 {
     gfal2_context_t context = (gfal2_context_t)plugin_data;
-
-    XrdCl::URL endpoint(prepare_url(context, urls[0]));
-    endpoint.SetPath(std::string());
-    XrdCl::FileSystem fs(endpoint);
-
-    std::vector<std::string> fileList;
-    for(int i = 0; i < nbfiles; ++i) {
-      XrdCl::URL file(prepare_url(context, urls[i]));
-      fileList.emplace_back(file.GetPath());
-    }
-
-    XrdCl::Buffer *responsePtr = 0;
-    XrdCl::Status st = fs.Prepare(fileList, XrdCl::PrepareFlags::Flags::Evict, 0, responsePtr, 30);
-
-    if (!st.IsOK()) {
-        GError *tmp_err = NULL;
-        gfal2_set_error(&tmp_err, xrootd_domain, xrootd_status_to_posix_errno(st),
-                        __func__, "%s", st.ToString().c_str());
-        for (int i = 0; i < nbfiles; ++i) {
-            err[i] = g_error_copy(tmp_err);
+    std::vector<EndpointBatch> batches = partition_by_endpoint(context, nbfiles, urls);
+    assign_request_ids(batches, token);
+
+    const uint16_t op_timeout = xrootd_operation_timeout(context);
+    dispatch_batches(batches, [op_timeout](EndpointBatch& batch, BufferResponseHandler* handler) {
+        return batch.fs->Prepare(batch.paths, XrdCl::PrepareFlags::Flags::Evict, 0, handler, op_timeout);
+    });
+
+    int ret = 0;
+    for (auto& batch : batches) {
+        const XrdCl::XRootDStatus& st = batch.handler->status;
+        if (!st.IsOK()) {
+            GError *tmp_err = NULL;
+            gfal2_set_error(&tmp_err, xrootd_domain, xrootd_status_to_posix_errno(st),
+                            __func__, "%s", st.ToString().c_str());
+            set_batch_error(batch, tmp_err, err);
+            g_error_free(tmp_err);
+            ret = -1;
+        } else if (!batch.reqid.empty()) {
+            poll_result_cache.Forget(batch.reqid);
         }
-        g_error_free(tmp_err);
-        delete responsePtr;
-        return -1;
     }
-    delete responsePtr;
-    return 0;
+    return ret;
 }
 
 
@@ -383,31 +687,30 @@ int gfal_xrootd_abort_files(plugin_handle plugin_data,
     }
     gfal2_context_t context = (gfal2_context_t)plugin_data;
 
-    XrdCl::URL endpoint(prepare_url(context, urls[0]));
-    endpoint.SetPath(std::string());
-    XrdCl::FileSystem fs(endpoint);
-
-    std::vector<std::string> fileList;
-    fileList.emplace_back(token);
-    for (int i = 0; i < nbfiles; ++i) {
-        XrdCl::URL file(prepare_url(context, urls[i]));
-        fileList.emplace_back(file.GetPath());
-    }
-
-    XrdCl::Buffer *reponsePtr = 0;
-    XrdCl::Status st = fs.Prepare(fileList, XrdCl::PrepareFlags::Flags::Cancel, 0, reponsePtr);
-    std::unique_ptr<XrdCl::Buffer> response(reponsePtr);
-
-    if (!st.IsOK()) {
-        GError *tmp_err = NULL;
-        gfal2_set_error(&tmp_err, xrootd_domain, xrootd_status_to_posix_errno(st),
-                        __func__, "%s", st.ToString().c_str());
-        for (int i = 0; i < nbfiles; ++i) {
-            err[i] = g_error_copy(tmp_err);
+    std::vector<EndpointBatch> batches = partition_by_endpoint(context, nbfiles, urls);
+    assign_request_ids(batches, token);
+
+    const uint16_t op_timeout = xrootd_operation_timeout(context);
+    dispatch_batches(batches, [op_timeout](EndpointBatch& batch, BufferResponseHandler* handler) {
+        std::vector<std::string> fileList;
+        fileList.emplace_back(batch.reqid);
+        fileList.insert(fileList.end(), batch.paths.begin(), batch.paths.end());
+        return batch.fs->Prepare(fileList, XrdCl::PrepareFlags::Flags::Cancel, 0, handler, op_timeout);
+    });
+
+    int ret = 0;
+    for (auto& batch : batches) {
+        const XrdCl::XRootDStatus& st = batch.handler->status;
+        if (!st.IsOK()) {
+            GError *tmp_err = NULL;
+            gfal2_set_error(&tmp_err, xrootd_domain, xrootd_status_to_posix_errno(st),
+                            __func__, "%s", st.ToString().c_str());
+            set_batch_error(batch, tmp_err, err);
+            g_error_free(tmp_err);
+            ret = -1;
+        } else {
+            poll_result_cache.Forget(batch.reqid);
         }
-        g_error_free(tmp_err);
-        return -1;
     }
-    return 0;
+    return ret;
 }
-
@@ -66,6 +66,22 @@ void set_xrootd_log_level()
 }
 
 
+static void StatInfo2Stat(const XrdCl::StatInfo* stinfo, struct stat* st)
+{
+    st->st_size = stinfo->GetSize();
+    st->st_mtime = stinfo->GetModTime();
+    st->st_mode = 0;
+    if (stinfo->TestFlags(XrdCl::StatInfo::IsDir))
+        st->st_mode |= S_IFDIR;
+    if (stinfo->TestFlags(XrdCl::StatInfo::IsReadable))
+        st->st_mode |= (S_IRUSR | S_IRGRP | S_IROTH);
+    if (stinfo->TestFlags(XrdCl::StatInfo::IsWritable))
+        st->st_mode |= (S_IWUSR | S_IWGRP | S_IWOTH);
+    if (stinfo->TestFlags(XrdCl::StatInfo::XBitSet))
+        st->st_mode |= (S_IXUSR | S_IXGRP | S_IXOTH);
+}
+
+
 int gfal_xrootd_statG(plugin_handle handle, const char* path, struct stat* buff,
         GError ** err)
 {
@@ -82,6 +98,67 @@ int gfal_xrootd_statG(plugin_handle handle, const char* path, struct stat* buff,
 }
 
 
+// Stat sent with XrdCl, deletes itself once the answer has been given to gfal2
+class StatResponseHandler: public XrdCl::ResponseHandler {
+public:
+    StatResponseHandler(const XrdCl::URL& url, struct stat* buff,
+        gfal_plugin_async_notify_t notify, gpointer notify_data):
+        fs(url), buff(buff), notify(notify), notify_data(notify_data)
+    {
+    }
+
+    void HandleResponse(XrdCl::XRootDStatus* status, XrdCl::AnyObject* response)
+    {
+        XrdCl::StatInfo* info = NULL;
+        GError* error = NULL;
+        int ret = 0;
+
+        if (status->IsOK() && response) {
+            response->Get(info);
+        }
+        if (info) {
+            reset_stat(*buff);
+            StatInfo2Stat(info, buff);
+        }
+        else {
+            int errcode = status->IsOK() ? EIO : xrootd_status_to_posix_errno(*status);
+            gfal2_xrootd_set_error(&error, errcode, __func__, "Failed to stat file (%s)", status->ToString().c_str());
+            ret = -1;
+        }
+        delete status;
+        delete response;
+
+        notify(notify_data, ret, error);
+        delete this;
+    }
+
+    XrdCl::FileSystem fs;
+
+private:
+    struct stat* buff;
+    gfal_plugin_async_notify_t notify;
+    gpointer notify_data;
+};
+
+
+int gfal_xrootd_stat_asyncG(plugin_handle handle, const char* path, struct stat* buff,
+        gfal_plugin_async_notify_t notify, gpointer notify_data, GError ** err)
+{
+    gfal2_context_t context = (gfal2_context_t) handle;
+    XrdCl::URL parsed(prepare_url(context, path));
+
+    StatResponseHandler* handler = new StatResponseHandler(parsed, buff, notify, notify_data);
+    XrdCl::XRootDStatus status = handler->fs.Stat(parsed.GetPath(), handler, xrootd_operation_timeout(context));
+    if (!status.IsOK()) {
+        delete handler;
+        gfal2_xrootd_set_error(err, xrootd_status_to_posix_errno(status), __func__,
+            "Failed to stat file (%s)", status.ToString().c_str());
+        return -1;
+    }
+    return 0;
+}
+
+
 gfal_file_handle gfal_xrootd_openG(plugin_handle handle, const char *path,
         int flag, mode_t mode, GError ** err)
 {
@@ -370,46 +447,28 @@ public:
         cv.notify_all();
     }
 
-    void StatInfo2Stat(const XrdCl::StatInfo* stinfo, struct stat* st)
-    {
-        st->st_size = stinfo->GetSize();
-        st->st_mtime = stinfo->GetModTime();
-        st->st_mode = 0;
-        if (stinfo->TestFlags(XrdCl::StatInfo::IsDir))
-            st->st_mode |= S_IFDIR;
-        if (stinfo->TestFlags(XrdCl::StatInfo::IsReadable))
-            st->st_mode |= (S_IRUSR | S_IRGRP | S_IROTH);
-        if (stinfo->TestFlags(XrdCl::StatInfo::IsWritable))
-            st->st_mode |= (S_IWUSR | S_IWGRP | S_IWOTH);
-        if (stinfo->TestFlags(XrdCl::StatInfo::XBitSet))
-            st->st_mode |= (S_IXUSR | S_IXGRP | S_IXOTH);
-    }
-
-    struct dirent* Get(struct stat* st = NULL)
+    // Wait for the listing, false if it did not arrive in time
+    bool Wait()
     {
         if (!done) {
             std::unique_lock<std::mutex> lock(mutex);
             cv.wait_for(lock, std::chrono::seconds(60));
-            if (!done) {
-                return NULL;
-            }
         }
+        return done;
+    }
 
-        if (entries.empty())
-            return NULL;
-
-        XrdCl::DirectoryList::ListEntry* entry = entries.front();
-        entries.pop_front();
-
+    // Fill the dirent, and the stat if not NULL, of a listed entry
+    bool Convert(XrdCl::DirectoryList::ListEntry* entry, struct dirent* dent, struct stat* st)
+    {
         XrdCl::StatInfo* stinfo = entry->GetStatInfo();
 
-        g_strlcpy(dbuffer.d_name, entry->GetName().c_str(), sizeof(dbuffer.d_name));
-        dbuffer.d_reclen = strnlen(dbuffer.d_name, sizeof(dbuffer.d_reclen));
+        g_strlcpy(dent->d_name, entry->GetName().c_str(), sizeof(dent->d_name));
+        dent->d_reclen = strnlen(dent->d_name, sizeof(dent->d_reclen));
 
         if (stinfo && stinfo->TestFlags(XrdCl::StatInfo::IsDir))
-            dbuffer.d_type = DT_DIR;
+            dent->d_type = DT_DIR;
         else
-            dbuffer.d_type = DT_REG;
+            dent->d_type = DT_REG;
 
         if (st != NULL) {
             if (stinfo != NULL) {
@@ -418,20 +477,53 @@ public:
             else {
 
                 stinfo = new XrdCl::StatInfo();
-                std::string fullPath = url.GetPath() + "/" + dbuffer.d_name;
+                std::string fullPath = url.GetPath() + "/" + dent->d_name;
                 XrdCl::XRootDStatus status = this->fs.Stat(fullPath, stinfo);
                 if (!status.IsOK()) {
                     errcode = status.code;
                     errstr = status.ToString();
-                    return NULL;
+                    delete stinfo;
+                    return false;
                 }
                 StatInfo2Stat(stinfo, st);
                 delete stinfo;
             }
         }
+        return true;
+    }
+
+    struct dirent* Get(struct stat* st = NULL)
+    {
+        if (!Wait() || entries.empty())
+            return NULL;
+
+        XrdCl::DirectoryList::ListEntry* entry = entries.front();
+        entries.pop_front();
 
+        bool converted = Convert(entry, &dbuffer, st);
         delete entry;
-        return &dbuffer;
+        return converted ? &dbuffer : NULL;
+    }
+
+    // Fill up to n entries straight from the received listing
+    // Returns the number of entries filled, or -1 on error
+    ssize_t GetBatch(gfal2_dir_entry_t* out, size_t n)
+    {
+        if (!Wait())
+            return 0;
+
+        size_t i;
+        for (i = 0; i < n && !entries.empty(); ++i) {
+            XrdCl::DirectoryList::ListEntry* entry = entries.front();
+            entries.pop_front();
+
+            memset(&out[i], 0, sizeof(out[i]));
+            bool converted = Convert(entry, &out[i].dirent, &out[i].st);
+            delete entry;
+            if (!converted)
+                return -1;
+        }
+        return i;
     }
 };
 
@@ -502,6 +594,25 @@ struct dirent* gfal_xrootd_readdirppG(plugin_handle plugin_data,
 }
 
 
+ssize_t gfal_xrootd_readdir_batchG(plugin_handle plugin_data,
+        gfal_file_handle dir_desc, gfal2_dir_entry_t* entries, size_t nentries, GError** err)
+{
+    DirListHandler* handler = (DirListHandler*)(gfal_file_handle_get_fdesc(dir_desc));
+    if (!handler) {
+        gfal2_xrootd_set_error(err, errno, __func__, "Bad dir handle");
+        return -1;
+    }
+    // The whole listing is received at once, so the batch is filled from it
+    ssize_t count = handler->GetBatch(entries, nentries);
+    if (count <= 0 && handler->errcode != 0) {
+        gfal2_xrootd_set_error(err, handler->errcode, __func__, "Failed reading directory: %s",
+                handler->errstr.c_str());
+        return -1;
+    }
+    return count;
+}
+
+
 int gfal_xrootd_closedirG(plugin_handle plugin_data, gfal_file_handle dir_desc,
         GError** err)
 {
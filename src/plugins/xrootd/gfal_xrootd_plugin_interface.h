@@ -34,6 +34,9 @@ extern "C" {
 
 int gfal_xrootd_statG(plugin_handle handle, const char* name, struct stat* buff, GError ** err);
 
+int gfal_xrootd_stat_asyncG(plugin_handle handle, const char* name, struct stat* buff,
+        gfal_plugin_async_notify_t notify, gpointer notify_data, GError ** err);
+
 gfal_file_handle gfal_xrootd_openG(plugin_handle handle, const char *path, int flag, mode_t mode, GError ** err);
 
 ssize_t gfal_xrootd_readG(plugin_handle handle, gfal_file_handle fd, void *buff, size_t count, GError ** err);
@@ -62,6 +65,9 @@ struct dirent* gfal_xrootd_readdirG(plugin_handle plugin_data, gfal_file_handle
 
 struct dirent* gfal_xrootd_readdirppG(plugin_handle plugin_data, gfal_file_handle dir_desc, struct stat* st, GError** err);
 
+ssize_t gfal_xrootd_readdir_batchG(plugin_handle plugin_data, gfal_file_handle dir_desc,
+        gfal2_dir_entry_t* entries, size_t nentries, GError** err);
+
 int gfal_xrootd_closedirG(plugin_handle plugin_data, gfal_file_handle dir_desc, GError** err);
 
 int gfal_xrootd_checksumG(plugin_handle data, const char* url, const char* check_type,
@@ -52,6 +52,7 @@ gfal_plugin_interface gfal_plugin_init(gfal2_context_t handle, GError** err)
 
     xrootd_plugin.statG = &gfal_xrootd_statG;
     xrootd_plugin.lstatG = &gfal_xrootd_statG;
+    xrootd_plugin.stat_asyncG = &gfal_xrootd_stat_asyncG;
 
     xrootd_plugin.preadG = NULL; // &gfal_xrootd_preadG;
     xrootd_plugin.pwriteG = NULL; // &gfal_xrootd_pwriteG;
@@ -66,6 +67,7 @@ gfal_plugin_interface gfal_plugin_init(gfal2_context_t handle, GError** err)
     xrootd_plugin.opendirG = &gfal_xrootd_opendirG;
     xrootd_plugin.readdirG = &gfal_xrootd_readdirG;
     xrootd_plugin.readdirppG = &gfal_xrootd_readdirppG;
+    xrootd_plugin.readdir_batchG = &gfal_xrootd_readdir_batchG;
     xrootd_plugin.closedirG = &gfal_xrootd_closedirG;
 
     xrootd_plugin.getxattrG = &gfal_xrootd_getxattrG;
@@ -330,6 +330,15 @@ static int map_status_code_to_errno(int code)
 }
 
 
+uint16_t xrootd_operation_timeout(gfal2_context_t context)
+{
+    int global_timeout = gfal2_get_opt_integer_with_default(context, CORE_CONFIG_GROUP,
+        CORE_CONFIG_NAMESPACE_TIMEOUT, 300);
+    int timeout = gfal2_get_opt_integer_with_default(context, "XROOTD PLUGIN", "OPERATION_TIMEOUT", global_timeout);
+    return static_cast<uint16_t>(std::max(0, std::min(timeout, 65535)));
+}
+
+
 int xrootd_status_to_posix_errno(const XrdCl::XRootDStatus& status, bool query_prepare)
 {
     int ret;
@@ -407,3 +416,54 @@ void copy_to_cstring(char* dest, size_t dest_size, const char* source, size_t so
         dest[dest_size - 1] = '\0';
     }
 }
+
+
+// When files span several endpoints, the token holds one "<host>|<request id>" entry
+// per endpoint, separated by commas. Single endpoint tokens are the plain request ID.
+#define XROOTD_TOKEN_ENTRY_SEPARATOR ','
+#define XROOTD_TOKEN_HOST_SEPARATOR  '|'
+
+
+std::string xrootd_compose_token(const std::vector<std::pair<std::string, std::string>>& reqids)
+{
+    if (reqids.size() == 1) {
+        return reqids.front().second;
+    }
+
+    // Endpoints that did not accept the request have no entry
+    std::string token;
+    for (const auto& reqid : reqids) {
+        if (reqid.second.empty()) {
+            continue;
+        }
+        if (!token.empty()) {
+            token += XROOTD_TOKEN_ENTRY_SEPARATOR;
+        }
+        token += reqid.first;
+        token += XROOTD_TOKEN_HOST_SEPARATOR;
+        token += reqid.second;
+    }
+    return token;
+}
+
+
+std::string xrootd_token_request_id(const std::string& token, const std::string& host)
+{
+    if (token.find(XROOTD_TOKEN_HOST_SEPARATOR) == std::string::npos) {
+        return token;
+    }
+
+    size_t start = 0;
+    while (start <= token.size()) {
+        size_t end = token.find(XROOTD_TOKEN_ENTRY_SEPARATOR, start);
+        if (end == std::string::npos) {
+            end = token.size();
+        }
+        size_t sep = token.find(XROOTD_TOKEN_HOST_SEPARATOR, start);
+        if (sep < end && token.compare(start, sep - start, host) == 0) {
+            return token.substr(sep + 1, end - sep - 1);
+        }
+        start = end + 1;
+    }
+    return std::string();
+}
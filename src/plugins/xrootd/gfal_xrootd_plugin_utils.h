@@ -26,6 +26,8 @@
 #include <gfal_api.h>
 #include <json.h>
 #include <string>
+#include <utility>
+#include <vector>
 #include <sys/stat.h>
 
 extern GQuark xrootd_domain;
@@ -50,6 +52,9 @@ bool json_obj_to_bool(struct json_object *boolobj);
 /// Collapse multiple consecutive slashes into a single one
 void collapse_slashes(std::string& path);
 
+/// Timeout for the calls that are not bounded by the caller
+uint16_t xrootd_operation_timeout(gfal2_context_t context);
+
 /// Map an xrootd status code to a posix errno
 /// @note for a query prepare, mask network errors as ECOMM
 int xrootd_status_to_posix_errno(const XrdCl::XRootDStatus& status, bool query_prepare = false);
@@ -64,4 +69,14 @@ void gfal2_xrootd_poll_set_error(GError **err, int errcode, const char *func, co
 /// Copy contents of source buffer to dest buffer and always terminate dest buffer with null terminator
 void copy_to_cstring(char* dest, size_t dest_size, const char* source, size_t source_size);
 
+/// Compose a staging token from the request ID returned by each endpoint (host:port)
+/// A single endpoint gives the plain request ID, several give "<host>|<request id>" entries separated by commas.
+/// Endpoints with an empty request ID are left out
+std::string xrootd_compose_token(const std::vector<std::pair<std::string, std::string>>& reqids);
+
+/// Return the request ID of the endpoint "host" (host:port) from a token built by xrootd_compose_token,
+/// or an empty string if the token does not mention it.
+/// A plain request ID applies to every endpoint
+std::string xrootd_token_request_id(const std::string& token, const std::string& host);
+
 #endif /* GFAL_XROOTD_PLUGIN_UTILS_H_ */
@@ -0,0 +1,514 @@
+/*
+ * Copyright (c) CERN 2013-2017
+ *
+ * Copyright (c) Members of the EMI Collaboration. 2010-2013
+ *  See  http://www.eu-emi.eu/partners for details on the copyright
+ *  holders.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Replay a trace recorded with CORE:TRACE_FILE, or gfal2_trace_start, against the mock plugin.
+ *
+ * Each thread of the trace is replayed by its own thread, issuing the operations at the same
+ * offsets from the start of the trace. Latencies, sizes and error codes recorded in the trace
+ * are passed to the mock plugin as query arguments, so the remote side behaves as in the trace,
+ * and the time spent in the core can be measured at production scale.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <gfal_api.h>
+#include <common/gfal_trace_internal.h>
+
+// Size given to the mock files opened for reading, so reads do not hit the end of file
+#define REPLAY_FILE_SIZE "1099511627776"
+#define REPLAY_URL_MAX 1024
+
+
+typedef struct {
+    gfal_trace_record_t record;
+    // For open, average latency of the reads and writes done on the file
+    guint64 read_wait;
+    guint64 write_wait;
+} replay_op_t;
+
+
+typedef struct {
+    gfal2_context_t context;
+    GPtrArray *hosts;
+    GPtrArray *operations;
+    GArray *ops;
+    double speed;
+    gint64 origin;
+    gboolean verbose;
+
+    volatile gint replayed;
+    volatile gint skipped;
+    volatile gint mismatches;
+    // Skipped operations, by operation id, 0 for the unknown ones
+    volatile gint *skipped_by_operation;
+} replay_t;
+
+
+typedef struct {
+    replay_t *replay;
+    guint32 thread;
+    GArray *ops;
+    GHashTable *files;
+    GHashTable *dirs;
+    char *buffer;
+    size_t buffer_size;
+    pthread_t tid;
+} replay_thread_t;
+
+
+static const char *replay_string(GPtrArray *table, guint32 id, const char *def)
+{
+    if (id == 0 || id > table->len || g_ptr_array_index(table, id - 1) == NULL)
+        return def;
+    return (const char*)g_ptr_array_index(table, id - 1);
+}
+
+
+static int replay_load(const char *path, replay_t *replay)
+{
+    FILE *fd = fopen(path, "rb");
+    if (fd == NULL) {
+        fprintf(stderr, "Could not open %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+
+    gfal_trace_header_t header;
+    if (fread(&header, sizeof(header), 1, fd) != 1 ||
+        memcmp(header.magic, GFAL_TRACE_MAGIC, sizeof(header.magic)) != 0) {
+        fprintf(stderr, "%s is not a gfal2 trace\n", path);
+        fclose(fd);
+        return -1;
+    }
+    if (header.version != GFAL_TRACE_VERSION || header.record_size != sizeof(gfal_trace_record_t)) {
+        fprintf(stderr, "Unsupported trace version %u\n", header.version);
+        fclose(fd);
+        return -1;
+    }
+
+    guint8 type;
+    while (fread(&type, sizeof(type), 1, fd) == 1) {
+        if (type == GFAL_TRACE_ENTRY_RECORD) {
+            replay_op_t op;
+            memset(&op, 0, sizeof(op));
+            if (fread(&op.record, sizeof(op.record), 1, fd) != 1)
+                break;
+            g_array_append_val(replay->ops, op);
+        }
+        else if (type == GFAL_TRACE_ENTRY_HOST || type == GFAL_TRACE_ENTRY_OPERATION) {
+            guint32 id;
+            guint16 length;
+            if (fread(&id, sizeof(id), 1, fd) != 1 || fread(&length, sizeof(length), 1, fd) != 1)
+                break;
+            GPtrArray *table = (type == GFAL_TRACE_ENTRY_HOST) ? replay->hosts : replay->operations;
+            // Ids are given in sequence
+            if (id == 0 || id > table->len + 1) {
+                fprintf(stderr, "Corrupted trace, unexpected string id %u\n", id);
+                break;
+            }
+            char *str = g_malloc0(length + 1);
+            if (fread(str, 1, length, fd) != length) {
+                g_free(str);
+                break;
+            }
+            if (table->len < id)
+                g_ptr_array_set_size(table, id);
+            g_free(g_ptr_array_index(table, id - 1));
+            g_ptr_array_index(table, id - 1) = str;
+        }
+        else {
+            fprintf(stderr, "Corrupted trace, unknown entry type %d\n", type);
+            break;
+        }
+    }
+
+    fclose(fd);
+    return 0;
+}
+
+
+static gint replay_compare_start(gconstpointer a, gconstpointer b)
+{
+    const replay_op_t *oa = (const replay_op_t*)a;
+    const replay_op_t *ob = (const replay_op_t*)b;
+    if (oa->record.start < ob->record.start)
+        return -1;
+    return oa->record.start > ob->record.start;
+}
+
+
+static gboolean replay_is_op(replay_t *replay, const replay_op_t *op, const char *name)
+{
+    return strcmp(replay_string(replay->operations, op->record.operation, ""), name) == 0;
+}
+
+
+// For each open, compute the average latency of the reads and writes done on that file
+// until it is closed, so the mock plugin can reproduce them
+static void replay_prepare_thread(replay_t *replay, replay_thread_t *thread)
+{
+    guint i, j;
+    g_array_sort(thread->ops, replay_compare_start);
+
+    for (i = 0; i < thread->ops->len; ++i) {
+        replay_op_t *open = &g_array_index(thread->ops, replay_op_t, i);
+        if (!replay_is_op(replay, open, "open"))
+            continue;
+
+        guint64 read_sum = 0, read_count = 0, write_sum = 0, write_count = 0;
+        for (j = i + 1; j < thread->ops->len; ++j) {
+            replay_op_t *op = &g_array_index(thread->ops, replay_op_t, j);
+            if (op->record.path_hash != open->record.path_hash)
+                continue;
+            if (replay_is_op(replay, op, "close"))
+                break;
+            if (replay_is_op(replay, op, "read") || replay_is_op(replay, op, "pread")) {
+                read_sum += op->record.latency;
+                ++read_count;
+            }
+            else if (replay_is_op(replay, op, "write") || replay_is_op(replay, op, "pwrite")) {
+                write_sum += op->record.latency;
+                ++write_count;
+            }
+        }
+        open->read_wait = read_count ? read_sum / read_count : 0;
+        open->write_wait = write_count ? write_sum / write_count : 0;
+    }
+}
+
+
+static void replay_build_url(replay_t *replay, const replay_op_t *op, char *url, size_t url_size)
+{
+    const char *scheme_host = replay_string(replay->hosts, op->record.host, "file://localhost");
+    const char *host = strstr(scheme_host, "://");
+    host = host ? host + 3 : scheme_host;
+
+    int len = snprintf(url, url_size,
+        "mock://%s/trace/%016" G_GINT64_MODIFIER "x?wait_us=%u&errno=%d&size=%s&list=entry:0644:1&checksum=1&%s=%s",
+        host[0] ? host : "localhost", op->record.path_hash, op->record.latency, op->record.errcode,
+        REPLAY_FILE_SIZE, GFAL_XATTR_STATUS, GFAL_XATTR_STATUS_ONLINE);
+    if (op->read_wait || op->write_wait)
+        snprintf(url + len, url_size - len, "&read_wait_us=%" G_GUINT64_FORMAT "&write_wait_us=%" G_GUINT64_FORMAT,
+            op->read_wait, op->write_wait);
+}
+
+
+static gint64 *replay_key(guint64 path_hash)
+{
+    gint64 *key = g_new(gint64, 1);
+    *key = (gint64)path_hash;
+    return key;
+}
+
+
+static char *replay_buffer(replay_thread_t *thread, size_t size)
+{
+    if (size > thread->buffer_size) {
+        g_free(thread->buffer);
+        thread->buffer = g_malloc0(size);
+        thread->buffer_size = size;
+    }
+    return thread->buffer;
+}
+
+
+// Returns the error code of the operation, or -1 if the operation is not supported
+static int replay_run_op(replay_thread_t *thread, const replay_op_t *op)
+{
+    replay_t *replay = thread->replay;
+    gfal2_context_t context = replay->context;
+    const char *name = replay_string(replay->operations, op->record.operation, "");
+    char url[REPLAY_URL_MAX];
+    char checksum[64];
+    char xattr[64];
+    struct stat st;
+    GError *error = NULL;
+    guint64 key = op->record.path_hash;
+    gpointer value;
+
+    replay_build_url(replay, op, url, sizeof(url));
+
+    if (strcmp(name, "stat") == 0 || strcmp(name, "lstat") == 0 || strcmp(name, "access") == 0) {
+        gfal2_stat(context, url, &st, &error);
+    }
+    else if (strcmp(name, "unlink") == 0) {
+        gfal2_unlink(context, url, &error);
+    }
+    else if (strcmp(name, "getxattr") == 0) {
+        gfal2_getxattr(context, url, GFAL_XATTR_STATUS, xattr, sizeof(xattr), &error);
+    }
+    else if (strcmp(name, "checksum") == 0) {
+        gfal2_checksum(context, url, "ADLER32", 0, 0, checksum, sizeof(checksum), &error);
+    }
+    else if (strcmp(name, "open") == 0) {
+        int flags = ((op->record.arg & O_ACCMODE) == O_RDONLY) ? O_RDONLY : O_WRONLY;
+        int fd = gfal2_open(context, url, flags, &error);
+        if (fd >= 0)
+            g_hash_table_insert(thread->files, replay_key(key), GINT_TO_POINTER(fd));
+    }
+    else if (strcmp(name, "read") == 0 || strcmp(name, "pread") == 0 ||
+             strcmp(name, "write") == 0 || strcmp(name, "pwrite") == 0) {
+        if (!g_hash_table_lookup_extended(thread->files, &key, NULL, &value))
+            return -1;
+        char *buffer = replay_buffer(thread, op->record.arg);
+        if (name[0] == 'r')
+            gfal2_read(context, GPOINTER_TO_INT(value), buffer, op->record.arg, &error);
+        else if (name[0] == 'w')
+            gfal2_write(context, GPOINTER_TO_INT(value), buffer, op->record.arg, &error);
+        else if (name[1] == 'r')
+            gfal2_pread(context, GPOINTER_TO_INT(value), buffer, op->record.arg, op->record.offset, &error);
+        else
+            gfal2_pwrite(context, GPOINTER_TO_INT(value), buffer, op->record.arg, op->record.offset, &error);
+    }
+    else if (strcmp(name, "close") == 0) {
+        if (!g_hash_table_lookup_extended(thread->files, &key, NULL, &value))
+            return -1;
+        gfal2_close(context, GPOINTER_TO_INT(value), &error);
+        g_hash_table_remove(thread->files, &key);
+    }
+    else if (strcmp(name, "opendir") == 0) {
+        DIR *dir = gfal2_opendir(context, url, &error);
+        if (dir)
+            g_hash_table_insert(thread->dirs, replay_key(key), dir);
+    }
+    else if (strcmp(name, "readdir") == 0 || strcmp(name, "readdirpp") == 0) {
+        DIR *dir = g_hash_table_lookup(thread->dirs, &key);
+        if (!dir)
+            return -1;
+        gfal2_readdir(context, dir, &error);
+    }
+    else if (strcmp(name, "readdir_batch") == 0) {
+        DIR *dir = g_hash_table_lookup(thread->dirs, &key);
+        if (!dir || op->record.arg == 0)
+            return -1;
+        gfal2_dir_entry_t *entries = g_new(gfal2_dir_entry_t, op->record.arg);
+        gfal2_readdir_batch(context, dir, entries, op->record.arg, &error);
+        g_free(entries);
+    }
+    else if (strcmp(name, "closedir") == 0) {
+        DIR *dir = g_hash_table_lookup(thread->dirs, &key);
+        if (!dir)
+            return -1;
+        gfal2_closedir(context, dir, &error);
+        g_hash_table_remove(thread->dirs, &key);
+    }
+    else {
+        return -1;
+    }
+
+    int errcode = 0;
+    if (error) {
+        errcode = error->code;
+        if (replay->verbose)
+            fprintf(stderr, "%s %s: %s\n", name, url, error->message);
+        g_error_free(error);
+    }
+    return errcode;
+}
+
+
+static void *replay_thread_run(void *arg)
+{
+    replay_thread_t *thread = (replay_thread_t*)arg;
+    replay_t *replay = thread->replay;
+    guint i;
+
+    for (i = 0; i < thread->ops->len; ++i) {
+        const replay_op_t *op = &g_array_index(thread->ops, replay_op_t, i);
+
+        if (replay->speed > 0) {
+            gint64 target = replay->origin + (gint64)(op->record.start / replay->speed);
+            gint64 now = g_get_monotonic_time();
+            if (target > now)
+                g_usleep(target - now);
+        }
+
+        int errcode = replay_run_op(thread, op);
+        if (errcode < 0) {
+            guint32 operation = (op->record.operation <= replay->operations->len) ? op->record.operation : 0;
+            g_atomic_int_inc(&replay->skipped);
+            g_atomic_int_inc(&replay->skipped_by_operation[operation]);
+            continue;
+        }
+        g_atomic_int_inc(&replay->replayed);
+        // The mock plugin only reproduces failures of the operations taking the URL
+        if ((errcode != 0) != (op->record.errcode != 0))
+            g_atomic_int_inc(&replay->mismatches);
+    }
+    return NULL;
+}
+
+
+static void replay_print_metrics(void)
+{
+    guint i;
+    gfal2_metrics_snapshot_t snapshot = gfal2_metrics_snapshot();
+
+    printf("%-24s %10s %8s %12s %12s %12s\n", "operation", "count", "errors", "p50 (us)", "p99 (us)", "max (us)");
+    for (i = 0; i < gfal2_metrics_snapshot_length(snapshot); ++i) {
+        const gfal2_metric_t *metric = gfal2_metrics_snapshot_get(snapshot, i);
+        printf("%-24s %10" G_GUINT64_FORMAT " %8" G_GUINT64_FORMAT " %12" G_GUINT64_FORMAT
+            " %12" G_GUINT64_FORMAT " %12" G_GUINT64_FORMAT "\n",
+            metric->operation, metric->count, metric->errors,
+            metric->p50_usec, metric->p99_usec, metric->max_usec);
+    }
+    gfal2_metrics_snapshot_free(snapshot);
+}
+
+
+// Operations not supported by the replay, or done on a file or directory whose opening
+// is not in the trace, as when the trace started after it
+static void replay_print_skipped(replay_t *replay)
+{
+    guint i;
+    for (i = 0; i <= replay->operations->len; ++i) {
+        gint count = replay->skipped_by_operation[i];
+        if (count > 0) {
+            printf("\tskipped %-24s %10d\n",
+                i ? replay_string(replay->operations, i, "unknown") : "unknown", count);
+        }
+    }
+}
+
+
+static void usage(const char *self)
+{
+    fprintf(stderr, "Usage: %s [-s speed] [-v] trace\n", self);
+    fprintf(stderr, "\t-s speed\tReplay speed factor, 2 replays twice as fast. 0 ignores the original timing\n");
+    fprintf(stderr, "\t-v\t\tPrint the errors\n");
+}
+
+
+int main(int argc, char **argv)
+{
+    replay_t replay;
+    GError *error = NULL;
+    int opt;
+    guint i;
+
+    memset(&replay, 0, sizeof(replay));
+    replay.speed = 1;
+
+    while ((opt = getopt(argc, argv, "s:vh")) != -1) {
+        switch (opt) {
+            case 's':
+                replay.speed = atof(optarg);
+                break;
+            case 'v':
+                replay.verbose = TRUE;
+                break;
+            default:
+                usage(argv[0]);
+                return 1;
+        }
+    }
+    if (optind != argc - 1) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    replay.hosts = g_ptr_array_new_with_free_func(g_free);
+    replay.operations = g_ptr_array_new_with_free_func(g_free);
+    replay.ops = g_array_new(FALSE, FALSE, sizeof(replay_op_t));
+    if (replay_load(argv[optind], &replay) < 0)
+        return 1;
+    replay.skipped_by_operation = g_new0(gint, replay.operations->len + 1);
+
+    // One replay thread per thread of the trace
+    GHashTable *threads = g_hash_table_new(g_direct_hash, g_direct_equal);
+    GPtrArray *thread_list = g_ptr_array_new();
+    guint64 duration = 0;
+    for (i = 0; i < replay.ops->len; ++i) {
+        replay_op_t *op = &g_array_index(replay.ops, replay_op_t, i);
+        replay_thread_t *thread = g_hash_table_lookup(threads, GUINT_TO_POINTER(op->record.thread));
+        if (thread == NULL) {
+            thread = g_new0(replay_thread_t, 1);
+            thread->replay = &replay;
+            thread->thread = op->record.thread;
+            thread->ops = g_array_new(FALSE, FALSE, sizeof(replay_op_t));
+            thread->files = g_hash_table_new_full(g_int64_hash, g_int64_equal, g_free, NULL);
+            thread->dirs = g_hash_table_new_full(g_int64_hash, g_int64_equal, g_free, NULL);
+            g_hash_table_insert(threads, GUINT_TO_POINTER(op->record.thread), thread);
+            g_ptr_array_add(thread_list, thread);
+        }
+        g_array_append_val(thread->ops, *op);
+        duration = MAX(duration, op->record.start + op->record.latency);
+    }
+    for (i = 0; i < thread_list->len; ++i)
+        replay_prepare_thread(&replay, g_ptr_array_index(thread_list, i));
+
+    printf("Loaded %u operations from %u threads, spanning %.3f seconds\n",
+        replay.ops->len, thread_list->len, duration / 1e6);
+
+    replay.context = gfal2_context_new(&error);
+    if (replay.context == NULL) {
+        fprintf(stderr, "Could not create the gfal2 context: %s\n", error->message);
+        g_error_free(error);
+        return 1;
+    }
+    // Do not trace the replay itself
+    gfal2_trace_stop();
+    // Every operation of the trace must reach the mock plugin
+    gfal2_set_opt_integer(replay.context, "CORE", "METADATA_CACHE_TTL", 0, NULL);
+    gfal2_metrics_set_enabled(TRUE);
+    gfal2_metrics_reset();
+
+    replay.origin = g_get_monotonic_time();
+    for (i = 0; i < thread_list->len; ++i) {
+        replay_thread_t *thread = g_ptr_array_index(thread_list, i);
+        if (pthread_create(&thread->tid, NULL, replay_thread_run, thread) != 0) {
+            fprintf(stderr, "Could not start a replay thread\n");
+            return 1;
+        }
+    }
+    for (i = 0; i < thread_list->len; ++i) {
+        replay_thread_t *thread = g_ptr_array_index(thread_list, i);
+        pthread_join(thread->tid, NULL);
+    }
+    gint64 elapsed = g_get_monotonic_time() - replay.origin;
+
+    printf("Replayed %d operations in %.3f seconds, %d skipped, %d with a different outcome\n",
+        replay.replayed, elapsed / 1e6, replay.skipped, replay.mismatches);
+    replay_print_skipped(&replay);
+    replay_print_metrics();
+
+    for (i = 0; i < thread_list->len; ++i) {
+        replay_thread_t *thread = g_ptr_array_index(thread_list, i);
+        g_array_free(thread->ops, TRUE);
+        g_hash_table_destroy(thread->files);
+        g_hash_table_destroy(thread->dirs);
+        g_free(thread->buffer);
+        g_free(thread);
+    }
+    g_ptr_array_free(thread_list, TRUE);
+    g_hash_table_destroy(threads);
+    g_array_free(replay.ops, TRUE);
+    g_ptr_array_free(replay.hosts, TRUE);
+    g_ptr_array_free(replay.operations, TRUE);
+    g_free((gpointer)replay.skipped_by_operation);
+    gfal2_context_free(replay.context);
+
+    return replay.mismatches ? 2 : 0;
+}
@@ -30,11 +30,24 @@
 
 pthread_mutex_t m_mds =PTHREAD_MUTEX_INITIALIZER;
 
+// Process-wide cache of the resolutions, keyed by BDII, cache file and host
+static pthread_mutex_t m_resolution = PTHREAD_MUTEX_INITIALIZER;
+static GHashTable* resolution_cache = NULL;
+
+typedef struct {
+    gint64 expires;                 // monotonic time, in usec
+    int n_endpoints;                // -1 for a failed resolution
+    gfal_mds_endpoint* endpoints;
+    GError* error;
+} gfal_mds_resolution;
+
 const char* bdii_env_var        = "LCG_GFAL_INFOSYS";
 const char* bdii_config_var     = "LCG_GFAL_INFOSYS";
 const char* bdii_config_group   = "BDII";
 const char* bdii_config_enable  = "ENABLED";
 const char* bdii_config_timeout = "TIMEOUT";
+const char* bdii_config_cache_ttl = "RESOLVE_CACHE_TTL";
+const char* bdii_config_negative_ttl = "RESOLVE_NEGATIVE_TTL";
 
 gboolean gfal_get_nobdiiG(gfal2_context_t handle)
 {
@@ -123,7 +136,128 @@ int gfal_mds_isifce_wrapper(const char* base_url, gfal_mds_endpoint* endpoints,
 
 #endif
 
- int gfal_mds_resolve_srm_endpoint(gfal2_context_t handle, const char* base_url,
+static void gfal_mds_resolution_free(gpointer data)
+{
+    gfal_mds_resolution* resolution = (gfal_mds_resolution*)data;
+    g_free(resolution->endpoints);
+    if (resolution->error)
+        g_error_free(resolution->error);
+    g_free(resolution);
+}
+
+/*
+ * key of the resolution of base_url
+ * The same host may resolve differently with another BDII or cache file
+ */
+static gchar* gfal_mds_resolution_key(gfal2_context_t handle, const char* base_url)
+{
+    gchar* infosys = g_strdup(g_getenv(bdii_env_var));
+    if (infosys == NULL)
+        infosys = gfal2_get_opt_string(handle, bdii_config_group, bdii_config_var, NULL);
+    gchar* cache_file = NULL;
+#ifndef MDS_WITHOUT_CACHE
+    cache_file = gfal2_get_opt_string(handle, bdii_config_group, bdii_cache_file, NULL);
+#endif
+
+    gchar* key = g_strdup_printf("%s|%s|%s", infosys ? infosys : "",
+            cache_file ? cache_file : "", base_url);
+
+    g_free(infosys);
+    g_free(cache_file);
+    return key;
+}
+
+/*
+ * look for a still valid resolution under key
+ * @return TRUE if found, with the result copied into endpoints and err
+ */
+static gboolean gfal_mds_resolution_lookup(const char* key, gfal_mds_endpoint* endpoints,
+        size_t s_endpoint, int* result, GError** err)
+{
+    gboolean found = FALSE;
+
+    pthread_mutex_lock(&m_resolution);
+    if (resolution_cache) {
+        gfal_mds_resolution* resolution = g_hash_table_lookup(resolution_cache, key);
+        if (resolution && resolution->expires > g_get_monotonic_time()) {
+            if (resolution->n_endpoints < 0) {
+                *result = -1;
+                g_propagate_error(err, g_error_copy(resolution->error));
+            }
+            else {
+                *result = MIN((size_t)resolution->n_endpoints, s_endpoint);
+                memcpy(endpoints, resolution->endpoints, *result * sizeof(gfal_mds_endpoint));
+            }
+            found = TRUE;
+        }
+        else if (resolution) {
+            g_hash_table_remove(resolution_cache, key);
+        }
+    }
+    pthread_mutex_unlock(&m_resolution);
+
+    return found;
+}
+
+/*
+ * remember the resolution of base_url under key
+ * Unknown hosts are kept for BDII:RESOLVE_NEGATIVE_TTL seconds, the others for BDII:RESOLVE_CACHE_TTL
+ */
+static void gfal_mds_resolution_store(gfal2_context_t handle, const char* key, const char* base_url,
+        const gfal_mds_endpoint* endpoints, int n_endpoints, const GError* error)
+{
+    gint64 ttl;
+    if (n_endpoints <= 0)
+        ttl = gfal2_get_opt_integer_with_default(handle, bdii_config_group, bdii_config_negative_ttl, 60);
+    else
+        ttl = gfal2_get_opt_integer_with_default(handle, bdii_config_group, bdii_config_cache_ttl, 300);
+    if (ttl <= 0)
+        return;
+
+    gfal_mds_resolution* resolution = g_new0(gfal_mds_resolution, 1);
+    resolution->expires = g_get_monotonic_time() + ttl * G_USEC_PER_SEC;
+    resolution->n_endpoints = n_endpoints;
+    if (n_endpoints > 0) {
+        resolution->endpoints = g_new(gfal_mds_endpoint, n_endpoints);
+        memcpy(resolution->endpoints, endpoints, n_endpoints * sizeof(gfal_mds_endpoint));
+    }
+    if (n_endpoints < 0 && error)
+        resolution->error = g_error_copy(error);
+    else if (n_endpoints < 0)
+        resolution->error = g_error_new(gfal2_get_core_quark(), ENXIO, "Could not resolve %s", base_url);
+
+    pthread_mutex_lock(&m_resolution);
+    if (resolution_cache == NULL)
+        resolution_cache = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, gfal_mds_resolution_free);
+    g_hash_table_replace(resolution_cache, g_strdup(key), resolution);
+    pthread_mutex_unlock(&m_resolution);
+}
+
+
+void gfal_mds_resolution_cache_clear(void)
+{
+    pthread_mutex_lock(&m_resolution);
+    if (resolution_cache)
+        g_hash_table_remove_all(resolution_cache);
+    pthread_mutex_unlock(&m_resolution);
+}
+
+
+/*
+ * Only complete results, and the hosts the BDII does not know, can be cached.
+ * Unreachable BDII or bad configuration must be retried on the next call.
+ */
+static gboolean gfal_mds_resolution_cacheable(int result, size_t s_endpoint, const GError* error)
+{
+    if (result > 0)
+        return (size_t)result < s_endpoint;
+    if (result == 0)
+        return TRUE;
+    return error != NULL && error->code == ENXIO;
+}
+
+
+static int gfal_mds_resolve_srm_endpoint_uncached(gfal2_context_t handle, const char* base_url,
          gfal_mds_endpoint* endpoints, size_t s_endpoint, GError** err)
  {
 #ifndef MDS_WITHOUT_CACHE
@@ -154,6 +288,25 @@ int gfal_mds_isifce_wrapper(const char* base_url, gfal_mds_endpoint* endpoints,
  }
 
 
+int gfal_mds_resolve_srm_endpoint(gfal2_context_t handle, const char* base_url,
+        gfal_mds_endpoint* endpoints, size_t s_endpoint, GError** err)
+{
+    int result = 0;
+    gchar* key = gfal_mds_resolution_key(handle, base_url);
+    if (gfal_mds_resolution_lookup(key, endpoints, s_endpoint, &result, err)) {
+        gfal2_log(G_LOG_LEVEL_DEBUG, "%s resolution found in memory", base_url);
+        g_free(key);
+        return result;
+    }
 
+    GError* tmp_err = NULL;
+    result = gfal_mds_resolve_srm_endpoint_uncached(handle, base_url, endpoints, s_endpoint, &tmp_err);
+    if (gfal_mds_resolution_cacheable(result, s_endpoint, tmp_err))
+        gfal_mds_resolution_store(handle, key, base_url, endpoints, result, tmp_err);
+    g_free(key);
 
+    if (tmp_err)
+        g_propagate_error(err, tmp_err);
+    return result;
+}
 
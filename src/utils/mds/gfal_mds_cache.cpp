@@ -18,16 +18,55 @@
  * limitations under the License.
  */
 
+#include <algorithm>
 #include <cstring>
 #include <errno.h>
 #include <fcntl.h>
+#include <mutex>
 #include <pugixml.hpp>
 #include <string>
+#include <sys/stat.h>
+#include <unordered_map>
+#include <vector>
 #include "gfal_mds_internal.h"
 
 
 const char* bdii_cache_file = "CACHE_FILE";
 
+// Endpoints of the cache file, indexed by host.
+// The file is parsed again only when it changes.
+struct MdsCacheIndex {
+    std::string path;
+    dev_t dev;
+    ino_t ino;
+    time_t mtime;
+    off_t size;
+    std::unordered_map<std::string, std::vector<gfal_mds_endpoint>> endpoints;
+
+    MdsCacheIndex(): dev(0), ino(0), mtime(0), size(0) {}
+
+    bool is_current(const std::string& file, const struct stat& st) const {
+        return path == file && dev == st.st_dev && ino == st.st_ino &&
+               mtime == st.st_mtime && size == st.st_size;
+    }
+};
+
+static std::mutex mds_cache_mutex;
+static MdsCacheIndex mds_cache_index;
+
+
+// Lowercase host part of an url or host[:port]
+static std::string gfal_mds_cache_host_key(const char* url)
+{
+    const char* host = strstr(url, "://");
+    if (host) host += 3;
+    else host = url;
+
+    std::string key(host, strcspn(host, ":/"));
+    std::transform(key.begin(), key.end(), key.begin(), ::tolower);
+    return key;
+}
+
 static mds_type_endpoint gfal_mds_cache_type(const std::string& type,
                                 const std::string &version)
 {
@@ -47,24 +86,49 @@ static mds_type_endpoint gfal_mds_cache_type(const std::string& type,
     }
 }
 
-static void gfal_mds_cache_insert(gfal_mds_endpoint* endpoints, size_t s_endpoints,
-                                  size_t index, const pugi::xml_node& entry)
+static void gfal_mds_cache_insert(MdsCacheIndex& index, const pugi::xml_node& entry)
 {
-    if (index > s_endpoints)
-        return;
-
-    std::string endpoint = entry.child("endpoint").last_child().value();
-    std::string type     = entry.child("type").last_child().value();
-    std::string version  = entry.child("version").last_child().value();
+    std::string endpoint = entry.child("endpoint").child_value();
+    std::string type     = entry.child("type").child_value();
+    std::string version  = entry.child("version").child_value();
 
     mds_type_endpoint typeEnum = gfal_mds_cache_type(type, version);
 
     if (!endpoint.empty() && typeEnum != UnknownEndpointType) {
-        g_strlcpy(endpoints[index].url, endpoint.c_str(), sizeof(endpoints[index].url));
-        endpoints[index].type = typeEnum;
+        gfal_mds_endpoint item;
+        g_strlcpy(item.url, endpoint.c_str(), sizeof(item.url));
+        item.type = typeEnum;
+        index.endpoints[gfal_mds_cache_host_key(item.url)].push_back(item);
     }
 }
 
+// Parse the cache file into the index, must be called with the lock held
+static bool gfal_mds_cache_load(MdsCacheIndex& index, const std::string& file, const struct stat& st)
+{
+    pugi::xml_document cache;
+    pugi::xml_parse_result loadResult = cache.load_file(file.c_str());
+
+    if (loadResult.status != pugi::status_ok) {
+        gfal2_log(G_LOG_LEVEL_DEBUG, "Could not load BDII CACHE_FILE: %s",
+                loadResult.description());
+        return false;
+    }
+
+    index.endpoints.clear();
+    for (pugi::xml_node entry = cache.child("entry"); entry; entry = entry.next_sibling("entry")) {
+        gfal_mds_cache_insert(index, entry);
+    }
+
+    index.path = file;
+    index.dev = st.st_dev;
+    index.ino = st.st_ino;
+    index.mtime = st.st_mtime;
+    index.size = st.st_size;
+
+    gfal2_log(G_LOG_LEVEL_DEBUG, "BDII CACHE_FILE loaded with %zu hosts", index.endpoints.size());
+    return true;
+}
+
 int gfal_mds_cache_resolve_endpoint(gfal2_context_t handle, const char* host,
                                     gfal_mds_endpoint* endpoints, size_t s_endpoints,
                                     GError** err)
@@ -75,41 +139,41 @@ int gfal_mds_cache_resolve_endpoint(gfal2_context_t handle, const char* host,
         return 0;
 
     gfal2_log(G_LOG_LEVEL_DEBUG, "BDII CACHE_FILE set to %s", cache_file);
+    std::string file(cache_file);
+    g_free(cache_file);
 
-    // Open the file, but do not fail if it can not be open
+    // Do not fail if the file can not be open
     // (A cache may not be present!)
-    pugi::xml_document cache;
-    pugi::xml_parse_result loadResult = cache.load_file(cache_file);
+    struct stat st;
+    if (stat(file.c_str(), &st) != 0) {
+        gfal2_log(G_LOG_LEVEL_DEBUG, "Could not load BDII CACHE_FILE: %s", strerror(errno));
+        return 0;
+    }
 
-    g_free(cache_file);
+    std::lock_guard<std::mutex> lock(mds_cache_mutex);
 
-    if (loadResult.status != pugi::status_ok) {
-        gfal2_log(G_LOG_LEVEL_DEBUG, "Could not load BDII CACHE_FILE: %s",
-                loadResult.description());
+    if (!mds_cache_index.is_current(file, st) && !gfal_mds_cache_load(mds_cache_index, file, st)) {
+        mds_cache_index = MdsCacheIndex();
         return 0;
     }
 
-    // Iterate. Get all endpoints and check if the contain the requested host
-    size_t hostLen = strlen(host);
+    auto entries = mds_cache_index.endpoints.find(gfal_mds_cache_host_key(host));
+    if (entries == mds_cache_index.endpoints.end()) {
+        return 0;
+    }
 
-    pugi::xpath_node_set allEndpoints = cache.document_element().select_nodes("/entry/endpoint");
-    pugi::xpath_node_set::const_iterator i;
+    // Keep only the endpoints matching the requested host, port included
+    size_t hostLen = strlen(host);
     size_t endpointIndex = 0;
-    for (i = allEndpoints.begin();
-         i != allEndpoints.end() && endpointIndex < s_endpoints;
+    for (auto i = entries->second.begin();
+         i != entries->second.end() && endpointIndex < s_endpoints;
          ++i) {
-        const char* endpoint = i->node().child_value();
-        const char* hostname = strstr(endpoint, "://");
+        const char* hostname = strstr(i->url, "://");
         if (hostname) hostname += 3;
-        else hostname = endpoint;
+        else hostname = i->url;
 
         if (strncasecmp(hostname, host, hostLen) == 0) {
-            std::string xpathQuery("/entry[endpoint='");
-            xpathQuery += endpoint;
-            xpathQuery += "']";
-
-            pugi::xpath_node entry = cache.document_element().select_single_node(xpathQuery.c_str());
-            gfal_mds_cache_insert(endpoints, s_endpoints, endpointIndex++, entry.node());
+            endpoints[endpointIndex++] = *i;
         }
     }
 
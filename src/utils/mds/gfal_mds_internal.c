@@ -44,6 +44,10 @@ static const char* SRM_PREFIX_NAME="SRM";
 
 static pthread_mutex_t mux_init_lap = PTHREAD_MUTEX_INITIALIZER;
 
+// Idle bound connections, keyed by uri
+static pthread_mutex_t mux_ldap_pool = PTHREAD_MUTEX_INITIALIZER;
+static GHashTable* ldap_pool = NULL;
+
 
 LDAP *gfal_mds_ldap_connect(gfal2_context_t context, const char *uri, GError **err)
 {
@@ -283,6 +287,72 @@ void gfal_mds_ldap_disconnect(LDAP *ld)
 	gfal_mds_ldap.ldap_unbind_ext_s(ld, NULL, NULL);
 }
 
+/*
+ * get an idle connection to uri from the pool
+ * @return a bound connection, or NULL if none is available
+ */
+static LDAP *gfal_mds_ldap_acquire(const char *uri)
+{
+	LDAP *ld = NULL;
+
+	pthread_mutex_lock(&mux_ldap_pool);
+	if (ldap_pool) {
+		GSList *idle = g_hash_table_lookup(ldap_pool, uri);
+		if (idle) {
+			ld = (LDAP *) idle->data;
+			g_hash_table_insert(ldap_pool, g_strdup(uri), g_slist_delete_link(idle, idle));
+		}
+	}
+	pthread_mutex_unlock(&mux_ldap_pool);
+
+	if (ld)
+		gfal2_log(G_LOG_LEVEL_DEBUG, "  Reuse connection to the bdii %s", uri);
+	return ld;
+}
+
+
+void gfal_mds_ldap_release(gfal2_context_t context, const char *uri, LDAP *ld)
+{
+	guint max_idle = gfal2_get_opt_integer_with_default(context, bdii_config_group, "CONNECTION_POOL_SIZE", 4);
+
+	pthread_mutex_lock(&mux_ldap_pool);
+	if (ldap_pool == NULL) {
+		ldap_pool = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+		// Unbind the idle connections at exit
+		atexit(gfal_mds_ldap_pool_clear);
+	}
+
+	GSList *idle = g_hash_table_lookup(ldap_pool, uri);
+	if (g_slist_length(idle) < max_idle) {
+		g_hash_table_insert(ldap_pool, g_strdup(uri), g_slist_prepend(idle, ld));
+		ld = NULL;
+	}
+	pthread_mutex_unlock(&mux_ldap_pool);
+
+	if (ld)
+		gfal_mds_ldap_disconnect(ld);
+}
+
+
+static void gfal_mds_ldap_pool_clear_entry(gpointer key, gpointer value, gpointer user_data)
+{
+	GSList *i;
+	for (i = (GSList *) value; i != NULL; i = g_slist_next(i))
+		gfal_mds_ldap_disconnect((LDAP *) i->data);
+	g_slist_free((GSList *) value);
+}
+
+
+void gfal_mds_ldap_pool_clear(void)
+{
+	pthread_mutex_lock(&mux_ldap_pool);
+	if (ldap_pool) {
+		g_hash_table_foreach(ldap_pool, gfal_mds_ldap_pool_clear_entry, NULL);
+		g_hash_table_remove_all(ldap_pool);
+	}
+	pthread_mutex_unlock(&mux_ldap_pool);
+}
+
 /*
  * resolve the SRM endpoint associated with a given base_url with the bdii
  * @param base_url : basic url to resolve
@@ -300,15 +370,30 @@ int gfal_mds_bdii_get_srm_endpoint(gfal2_context_t context, const char *base_url
 	LDAP *ld;
 	gfal2_log(G_LOG_LEVEL_DEBUG, " gfal_mds_bdii_get_srm_endpoint ->");
 	if (gfal_mds_get_ldapuri(context, uri, GFAL_URL_MAX_LEN, &tmp_err) >= 0) {
-		if ((ld = gfal_mds_ldap_connect(context, uri, &tmp_err)) != NULL) {
+		// A pooled connection may have been closed by the server, so retry once with a new one
+		ld = gfal_mds_ldap_acquire(uri);
+		gboolean pooled = (ld != NULL);
+		if (ld == NULL)
+			ld = gfal_mds_ldap_connect(context, uri, &tmp_err);
+
+		while (ld != NULL) {
 			LDAPMessage *res;
 			char buff_filter[GFAL_URL_MAX_LEN];
 			snprintf(buff_filter, GFAL_URL_MAX_LEN, srm_endpoint_filter, base_url, base_url); // construct the request
 			if (gfal_mds_ldap_search(ld, sbasedn, buff_filter, tabattr, &res, &tmp_err) >= 0) {
 				ret = gfal_mds_get_srm_types_endpoint(ld, res, endpoints, s_endpoint, &tmp_err);
 				gfal_mds_ldap.ldap_msgfree(res);
+				gfal_mds_ldap_release(context, uri, ld);
+				break;
 			}
+
 			gfal_mds_ldap_disconnect(ld);
+			ld = NULL;
+			if (pooled) {
+				g_clear_error(&tmp_err);
+				pooled = FALSE;
+				ld = gfal_mds_ldap_connect(context, uri, &tmp_err);
+			}
 		}
 	}
 
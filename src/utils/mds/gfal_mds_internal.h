@@ -38,7 +38,18 @@ int gfal_mds_get_srm_types_endpoint(LDAP* ld, LDAPMessage *result, gfal_mds_endp
 
 int gfal_mds_bdii_get_srm_endpoint(gfal2_context_t handle, const char* base_url, gfal_mds_endpoint* endpoints, size_t s_endpoint, GError** err);
 
+// Return a bound connection to the pool, to be reused by the next query
+void gfal_mds_ldap_release(gfal2_context_t context, const char* uri, LDAP* ld);
+
+// Drop the pooled connections, also done at exit
+void gfal_mds_ldap_pool_clear(void);
+
+// Forget the resolutions kept in memory
+void gfal_mds_resolution_cache_clear(void);
+
 #ifndef MDS_WITHOUT_CACHE
+extern const char* bdii_cache_file;
+
 /** Tries to resolve the available endpoints from a cache file
  *  compatible with FTS3 bdii cache format
  *  @return The number of entries found, -1 on error.
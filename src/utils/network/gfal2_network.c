@@ -15,12 +15,47 @@
  */
 
 #include <time.h>
+#include <string.h>
+#include <pthread.h>
 #include <netdb.h>
 #include <arpa/inet.h>
 
 #include "gfal2_network.h"
 #include "gfal_plugins_api.h"
 #include <uri/gfal2_uri.h>
+#include <common/gfal_metrics_internal.h>
+
+
+typedef struct {
+    gint64 expires;                 // monotonic time, in usec
+    gint64 refresh_after;           // after this, a background refresh is started
+    gboolean refreshing;
+    int count;                      // -1 if the resolution failed
+    gfal2_dns_address* addresses;
+} gfal2_dns_entry;
+
+typedef struct {
+    gint64 expires;
+    char* hostname;                 // NULL if there is no reverse entry
+} gfal2_dns_reverse_entry;
+
+static pthread_mutex_t dns_cache_lock = PTHREAD_MUTEX_INITIALIZER;
+static GHashTable* dns_cache = NULL;
+static GHashTable* dns_reverse_cache = NULL;
+static int dns_cache_ttl = 60;
+static int dns_negative_ttl = 10;
+
+// Hosts to refresh in the background, served by a single worker
+static pthread_once_t dns_refresh_once = PTHREAD_ONCE_INIT;
+static pthread_cond_t dns_refresh_cond = PTHREAD_COND_INITIALIZER;
+static GQueue dns_refresh_queue = G_QUEUE_INIT;
+static gboolean dns_refresh_started = FALSE;
+
+struct gfal2_dns_resolver gfal2_dns_resolver_call = {
+    getaddrinfo,
+    freeaddrinfo,
+    getnameinfo
+};
 
 char* resolve_dns_helper(const char* host_uri, const char* msg)
 {
@@ -47,71 +82,328 @@ char* resolve_dns_helper(const char* host_uri, const char* msg)
     return resolved_str;
 }
 
-char* gfal2_resolve_dns_to_hostname(const char* dnshost)
+void gfal2_dns_cache_set_ttl(int ttl, int negative_ttl)
+{
+    pthread_mutex_lock(&dns_cache_lock);
+    dns_cache_ttl = ttl;
+    dns_negative_ttl = negative_ttl;
+    pthread_mutex_unlock(&dns_cache_lock);
+}
+
+
+void gfal2_dns_cache_clear(void)
+{
+    pthread_mutex_lock(&dns_cache_lock);
+    if (dns_cache) {
+        g_hash_table_remove_all(dns_cache);
+        g_hash_table_remove_all(dns_reverse_cache);
+    }
+    pthread_mutex_unlock(&dns_cache_lock);
+}
+
+
+static void gfal2_dns_entry_free(gpointer data)
+{
+    gfal2_dns_entry* entry = (gfal2_dns_entry*) data;
+    g_free(entry->addresses);
+    g_free(entry);
+}
+
+
+static void gfal2_dns_reverse_entry_free(gpointer data)
+{
+    gfal2_dns_reverse_entry* entry = (gfal2_dns_reverse_entry*) data;
+    g_free(entry->hostname);
+    g_free(entry);
+}
+
+
+// Must be called with the lock held
+static void gfal2_dns_cache_init(void)
+{
+    if (dns_cache == NULL) {
+        dns_cache = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, gfal2_dns_entry_free);
+        dns_reverse_cache = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, gfal2_dns_reverse_entry_free);
+    }
+}
+
+
+// Append the address of ai, unless it is already there
+static int gfal2_dns_append(const struct addrinfo* ai, gfal2_dns_address* addresses, int count)
 {
-    struct addrinfo hints;
-    struct addrinfo* addresses = NULL;
-    struct addrinfo* addrP = NULL;
-    GString* log_str = g_string_sized_new(512);
-    char addrstr[INET6_ADDRSTRLEN * 2];
-    char hostname[256];
-    void* ptr = NULL;
-    int count = 0;
+    gfal2_dns_address address;
+    const void* ptr;
+    int i;
+
+    if (ai->ai_family == AF_INET6)
+        ptr = &((struct sockaddr_in6 *) ai->ai_addr)->sin6_addr;
+    else if (ai->ai_family == AF_INET)
+        ptr = &((struct sockaddr_in *) ai->ai_addr)->sin_addr;
+    else
+        return count;
+
+    address.family = ai->ai_family;
+    if (inet_ntop(ai->ai_family, ptr, address.address, sizeof(address.address)) == NULL)
+        return count;
+
+    for (i = 0; i < count; ++i) {
+        if (addresses[i].family == address.family && strcmp(addresses[i].address, address.address) == 0)
+            return count;
+    }
+    addresses[count] = address;
+    return count + 1;
+}
+
+
+// Query both families at once, and interleave the answers starting with IPv6
+// The resolver of the system already sends the A and AAAA queries in parallel
+static int gfal2_dns_query(const char* host, gfal2_dns_address** addresses)
+{
+    struct addrinfo hints, *result = NULL;
+    const struct addrinfo* ai;
+    gfal2_dns_address v6[GFAL2_DNS_MAX_ADDRESSES], v4[GFAL2_DNS_MAX_ADDRESSES];
+    int n6 = 0, n4 = 0, i6 = 0, i4 = 0, count = 0;
 
     memset(&hints, 0, sizeof(hints));
     hints.ai_family = AF_UNSPEC;
     hints.ai_socktype = SOCK_STREAM;
-    hints.ai_flags |= AI_CANONNAME;
 
-    int rc = getaddrinfo(dnshost, NULL, &hints, &addresses);
+    if (gfal2_dns_resolver_call.getaddrinfo(host, NULL, &hints, &result) != 0) {
+        *addresses = NULL;
+        return -1;
+    }
 
-    if (rc || !addresses) {
-        if (addresses) {
-            freeaddrinfo(addresses);
-        }
+    for (ai = result; ai != NULL; ai = ai->ai_next) {
+        if (ai->ai_family == AF_INET6 && n6 < GFAL2_DNS_MAX_ADDRESSES)
+            n6 = gfal2_dns_append(ai, v6, n6);
+        else if (ai->ai_family == AF_INET && n4 < GFAL2_DNS_MAX_ADDRESSES)
+            n4 = gfal2_dns_append(ai, v4, n4);
+    }
+    gfal2_dns_resolver_call.freeaddrinfo(result);
 
-        gfal2_log(G_LOG_LEVEL_WARNING, "Could not resolve DNS alias: %s", dnshost);
-        return NULL;
+    if (n6 + n4 == 0) {
+        *addresses = NULL;
+        return -1;
+    }
+
+    *addresses = g_new0(gfal2_dns_address, GFAL2_DNS_MAX_ADDRESSES);
+    while ((i6 < n6 || i4 < n4) && count < GFAL2_DNS_MAX_ADDRESSES) {
+        if (i6 < n6)
+            (*addresses)[count++] = v6[i6++];
+        if (i4 < n4 && count < GFAL2_DNS_MAX_ADDRESSES)
+            (*addresses)[count++] = v4[i4++];
+    }
+    return count;
+}
+
+
+/*
+ * Resolve host, and store the result in the cache
+ * A failed background refresh keeps the previous entry until it expires
+ * Returns the number of addresses copied into addresses
+ */
+static int gfal2_dns_resolve(const char* host, gfal2_dns_address* addresses, int max_addresses,
+    gboolean background)
+{
+    gint64 metrics_start = gfal_metrics_start();
+    gfal2_dns_address* resolved = NULL;
+    int count = gfal2_dns_query(host, &resolved);
+
+    if (metrics_start) {
+        char url[GFAL_URL_MAX_LEN];
+        g_snprintf(url, sizeof(url), "dns://%s", host);
+        gfal_metrics_record("dns", "resolve", url, metrics_start, count < 0);
     }
 
-    // Count and log all resolved addresses
-    for (addrP = addresses; addrP != NULL; addrP = addrP->ai_next) {
-        inet_ntop(addrP->ai_family, addrP->ai_addr->sa_data, addrstr, sizeof(addrstr));
-
-        switch (addrP->ai_family) {
-            case AF_INET:
-                ptr = &((struct sockaddr_in *) addrP->ai_addr)->sin_addr;
-                if (ptr) {
-                    inet_ntop(addrP->ai_family, ptr, addrstr, sizeof(addrstr));
-                }
-                break;
-            case AF_INET6:
-                ptr = &((struct sockaddr_in6 *) addrP->ai_addr)->sin6_addr;
-                if (ptr) {
-                    inet_ntop(addrP->ai_family, ptr, addrstr, sizeof(addrstr));
-                }
-                break;
+    int result = MIN(count, max_addresses);
+    if (result > 0)
+        memcpy(addresses, resolved, result * sizeof(gfal2_dns_address));
+
+    pthread_mutex_lock(&dns_cache_lock);
+    gfal2_dns_cache_init();
+
+    int ttl = (count < 0) ? dns_negative_ttl : dns_cache_ttl;
+    gint64 now = g_get_monotonic_time();
+
+    if (count < 0 && background) {
+        gfal2_dns_entry* previous = g_hash_table_lookup(dns_cache, host);
+        if (previous)
+            previous->refreshing = FALSE;
+        g_free(resolved);
+    }
+    else if (ttl > 0) {
+        gfal2_dns_entry* entry = g_new0(gfal2_dns_entry, 1);
+        entry->expires = now + (gint64)ttl * G_USEC_PER_SEC;
+        entry->refresh_after = now + (gint64)ttl * G_USEC_PER_SEC * 3 / 4;
+        entry->count = count;
+        entry->addresses = resolved;
+        g_hash_table_replace(dns_cache, g_strdup(host), entry);
+    }
+    else {
+        g_hash_table_remove(dns_cache, host);
+        g_free(resolved);
+    }
+    pthread_mutex_unlock(&dns_cache_lock);
+
+    return result;
+}
+
+
+static void* gfal2_dns_refresh_run(void* data)
+{
+    while (TRUE) {
+        pthread_mutex_lock(&dns_cache_lock);
+        while (g_queue_is_empty(&dns_refresh_queue))
+            pthread_cond_wait(&dns_refresh_cond, &dns_cache_lock);
+        char* host = g_queue_pop_head(&dns_refresh_queue);
+        pthread_mutex_unlock(&dns_cache_lock);
+
+        gfal2_dns_resolve(host, NULL, 0, TRUE);
+        g_free(host);
+    }
+    return NULL;
+}
+
+
+static void gfal2_dns_refresh_start(void)
+{
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, gfal2_dns_refresh_run, NULL) == 0) {
+        pthread_detach(thread);
+        dns_refresh_started = TRUE;
+    }
+}
+
+
+int gfal2_resolve_dns(const char* host, gfal2_dns_address* addresses, int max_addresses)
+{
+    gboolean found = FALSE, refresh = FALSE;
+    int count = -1;
+
+    pthread_mutex_lock(&dns_cache_lock);
+    gfal2_dns_entry* entry = dns_cache ? g_hash_table_lookup(dns_cache, host) : NULL;
+    gint64 now = g_get_monotonic_time();
+    if (entry && entry->expires > now) {
+        found = TRUE;
+        count = MIN(entry->count, max_addresses);
+        if (count > 0)
+            memcpy(addresses, entry->addresses, count * sizeof(gfal2_dns_address));
+        // Refresh popular entries before they expire
+        refresh = (entry->count >= 0 && now > entry->refresh_after && !entry->refreshing);
+    }
+    pthread_mutex_unlock(&dns_cache_lock);
+
+    if (refresh) {
+        pthread_once(&dns_refresh_once, gfal2_dns_refresh_start);
+        pthread_mutex_lock(&dns_cache_lock);
+        // Without the worker, the entry just expires
+        entry = g_hash_table_lookup(dns_cache, host);
+        if (dns_refresh_started && entry && !entry->refreshing) {
+            entry->refreshing = TRUE;
+            g_queue_push_tail(&dns_refresh_queue, g_strdup(host));
+            pthread_cond_signal(&dns_refresh_cond);
         }
+        pthread_mutex_unlock(&dns_cache_lock);
+    }
 
-        getnameinfo(addrP->ai_addr, addrP->ai_addrlen, hostname, sizeof(hostname), NULL, 0, NI_NAMEREQD);
-        g_string_append_printf(log_str, "%s[%s] ", hostname, addrstr);
-        count++;
+    if (found)
+        return count;
+    return gfal2_dns_resolve(host, addresses, max_addresses, FALSE);
+}
+
+
+// Reverse resolution of an address, cached as the forward resolutions
+static gboolean gfal2_dns_reverse(const gfal2_dns_address* address, char* hostname, size_t s_hostname)
+{
+    gboolean found = FALSE, resolved = FALSE;
+
+    pthread_mutex_lock(&dns_cache_lock);
+    gfal2_dns_reverse_entry* entry = dns_reverse_cache ? g_hash_table_lookup(dns_reverse_cache, address->address) : NULL;
+    if (entry && entry->expires > g_get_monotonic_time()) {
+        found = TRUE;
+        if (entry->hostname) {
+            g_strlcpy(hostname, entry->hostname, s_hostname);
+            resolved = TRUE;
+        }
     }
+    pthread_mutex_unlock(&dns_cache_lock);
 
-    gfal2_log(G_LOG_LEVEL_DEBUG, "Resolved DNS alias %s into: %s", dnshost, log_str->str);
-    g_string_free(log_str, TRUE);
+    if (found)
+        return resolved;
 
-    // Select at random an address between [0, count)
-    srand(time(NULL));
-    int selected = rand() % count;
+    struct sockaddr_storage storage;
+    socklen_t len;
+    memset(&storage, 0, sizeof(storage));
+    if (address->family == AF_INET6) {
+        struct sockaddr_in6* sin6 = (struct sockaddr_in6*) &storage;
+        sin6->sin6_family = AF_INET6;
+        inet_pton(AF_INET6, address->address, &sin6->sin6_addr);
+        len = sizeof(*sin6);
+    }
+    else {
+        struct sockaddr_in* sin = (struct sockaddr_in*) &storage;
+        sin->sin_family = AF_INET;
+        inet_pton(AF_INET, address->address, &sin->sin_addr);
+        len = sizeof(*sin);
+    }
+
+    resolved = (gfal2_dns_resolver_call.getnameinfo((struct sockaddr*) &storage, len,
+        hostname, s_hostname, NULL, 0, NI_NAMEREQD) == 0);
 
-    for (addrP = addresses; addrP != NULL; addrP = addrP->ai_next) {
-        if (selected-- == 0) {
-            getnameinfo(addrP->ai_addr, addrP->ai_addrlen, hostname, sizeof(hostname), NULL, 0, NI_NAMEREQD);
-            break;
+    pthread_mutex_lock(&dns_cache_lock);
+    int ttl = resolved ? dns_cache_ttl : dns_negative_ttl;
+    if (ttl > 0) {
+        gfal2_dns_cache_init();
+        entry = g_new0(gfal2_dns_reverse_entry, 1);
+        entry->expires = g_get_monotonic_time() + (gint64)ttl * G_USEC_PER_SEC;
+        entry->hostname = resolved ? g_strdup(hostname) : NULL;
+        g_hash_table_replace(dns_reverse_cache, g_strdup(address->address), entry);
+    }
+    pthread_mutex_unlock(&dns_cache_lock);
+
+    return resolved;
+}
+
+
+char* gfal2_resolve_dns_to_hostname(const char* dnshost)
+{
+    gfal2_dns_address addresses[GFAL2_DNS_MAX_ADDRESSES];
+    char hostname[NI_MAXHOST];
+    char* host;
+    int i;
+
+    // IPv6 literals come bracketed from the urls
+    size_t len = strlen(dnshost);
+    if (len > 2 && dnshost[0] == '[' && dnshost[len - 1] == ']')
+        host = g_strndup(dnshost + 1, len - 2);
+    else
+        host = g_strdup(dnshost);
+
+    int count = gfal2_resolve_dns(host, addresses, GFAL2_DNS_MAX_ADDRESSES);
+    g_free(host);
+    if (count <= 0) {
+        gfal2_log(G_LOG_LEVEL_WARNING, "Could not resolve DNS alias: %s", dnshost);
+        return NULL;
+    }
+
+    if (gfal2_log_is_enabled(G_LOG_LEVEL_DEBUG, NULL)) {
+        GString* log_str = g_string_sized_new(512);
+        for (i = 0; i < count; ++i) {
+            g_string_append_printf(log_str, "[%s] ", addresses[i].address);
         }
+        gfal2_log(G_LOG_LEVEL_DEBUG, "Resolved DNS alias %s into: %s", dnshost, log_str->str);
+        g_string_free(log_str, TRUE);
     }
 
-    freeaddrinfo(addresses);
+    // Select at random an address between [0, count)
+    int selected = g_random_int_range(0, count);
+
+    if (gfal2_dns_reverse(&addresses[selected], hostname, sizeof(hostname)))
+        return strdup(hostname);
+    // Without a reverse entry, the address itself, ready to be put back in a url
+    if (addresses[selected].family == AF_INET6)
+        g_snprintf(hostname, sizeof(hostname), "[%s]", addresses[selected].address);
+    else
+        g_strlcpy(hostname, addresses[selected].address, sizeof(hostname));
     return strdup(hostname);
 }
@@ -17,6 +17,8 @@
 #pragma once
 
 #include <glib.h>
+#include <arpa/inet.h>
+#include <netdb.h>
 
 #ifdef __cplusplus
 extern "C"
@@ -31,9 +33,57 @@ char* resolve_dns_helper(const char* host_uri, const char* msg);
 
 /*
  * Given a DNS alias, resolve the list of underlying addresses and select one at random.
+ * Returns its host name, or the address itself if it has no reverse entry
+ * (bracketed if IPv6, so it can be used in a url)
  */
 char* gfal2_resolve_dns_to_hostname(const char* dnshost);
 
+/*
+ * Maximum number of addresses kept for a host
+ */
+#define GFAL2_DNS_MAX_ADDRESSES 32
+
+/*
+ * A resolved address, in numeric form
+ */
+typedef struct {
+    int family;
+    char address[INET6_ADDRSTRLEN];
+} gfal2_dns_address;
+
+/*
+ * Resolve the addresses of a host, using the process-wide DNS cache.
+ * IPv6 and IPv4 are queried together, and the addresses are ordered as in RFC 8305:
+ * both families interleaved, starting with IPv6.
+ * Entries about to expire are refreshed in the background by a single worker thread.
+ * Returns the number of addresses copied into addresses, or -1 if the host can not be resolved.
+ */
+int gfal2_resolve_dns(const char* host, gfal2_dns_address* addresses, int max_addresses);
+
+/*
+ * Set for how many seconds resolutions are cached, and failed resolutions for negative_ttl.
+ * 0 disables the cache.
+ */
+void gfal2_dns_cache_set_ttl(int ttl, int negative_ttl);
+
+/*
+ * Forget all the cached resolutions
+ */
+void gfal2_dns_cache_clear(void);
+
+/*
+ * Functions of the system resolver, replaced by the unit tests
+ */
+struct gfal2_dns_resolver {
+    int (*getaddrinfo)(const char* node, const char* service, const struct addrinfo* hints,
+        struct addrinfo** res);
+    void (*freeaddrinfo)(struct addrinfo* res);
+    int (*getnameinfo)(const struct sockaddr* addr, socklen_t addrlen, char* host, socklen_t hostlen,
+        char* serv, socklen_t servlen, int flags);
+};
+
+extern struct gfal2_dns_resolver gfal2_dns_resolver_call;
+
 #ifdef __cplusplus
 }
 #endif
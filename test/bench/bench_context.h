@@ -0,0 +1,75 @@
+/*
+ * Copyright (c) CERN 2017
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+#ifndef GFAL2_BENCH_CONTEXT_H_
+#define GFAL2_BENCH_CONTEXT_H_
+
+#include <gfal_api.h>
+#define __GFAL2_H_INSIDE__
+#include <common/gfal_plugin.h>
+#undef __GFAL2_H_INSIDE__
+#include <benchmark/benchmark.h>
+
+#include <string>
+
+
+// Give a new context to each run of the benchmark, which is skipped if the context can not be created
+// Benchmarks doing some work before their loop must return if state.error_occurred()
+class ContextFixture: public benchmark::Fixture {
+public:
+    gfal2_context_t context;
+
+    ContextFixture(): context(NULL)
+    {
+    }
+
+    using benchmark::Fixture::SetUp;
+    using benchmark::Fixture::TearDown;
+
+    void SetUp(benchmark::State& state)
+    {
+        GError *error = NULL;
+        context = gfal2_context_new(&error);
+        if (context == NULL) {
+            state.SkipWithError(error->message);
+            g_error_free(error);
+        }
+    }
+
+    void TearDown(benchmark::State& state)
+    {
+        if (context != NULL)
+            gfal2_context_free(context);
+        context = NULL;
+    }
+
+protected:
+    // Skip the benchmark if no plugin handles url, i.e. GFAL_PLUGIN_DIR does not point to the built plugins
+    void RequirePlugin(benchmark::State& state, const char *url, const char *name)
+    {
+        GError *error = NULL;
+        if (context == NULL)
+            return;
+        if (gfal_find_plugin(context, url, GFAL_PLUGIN_STAT, &error) == NULL) {
+            std::string message = std::string(name) + " plugin not found, check GFAL_PLUGIN_DIR";
+            state.SkipWithError(message.c_str());
+            g_clear_error(&error);
+        }
+    }
+};
+
+#endif // GFAL2_BENCH_CONTEXT_H_
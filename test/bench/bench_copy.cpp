@@ -0,0 +1,99 @@
+/*
+ * Copyright (c) CERN 2017
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gfal_api.h>
+#include <benchmark/benchmark.h>
+#include "bench_context.h"
+
+extern "C" {
+#include <transfer/gfal_transfer_internal.h>
+}
+
+#include <string>
+
+
+// The copies run against the mock plugin, so they measure the copy engine without any
+// storage behind: the source content is generated on the fly, and checked by the destination
+class MockContextFixture: public ContextFixture {
+public:
+    using ContextFixture::SetUp;
+
+    void SetUp(benchmark::State& state)
+    {
+        ContextFixture::SetUp(state);
+        RequirePlugin(state, "mock://bench.example.com/", "mock");
+    }
+};
+
+
+// Streamed copy of state.range(0) bytes, done by the core copy engine
+// The mock plugin would do a third party copy between two mock urls, so the streamed copy is called directly
+BENCHMARK_DEFINE_F(MockContextFixture, BM_StreamedCopy)(benchmark::State& state)
+{
+    if (state.error_occurred()) {
+        return;
+    }
+
+    std::string src = "mock://bench.example.com/src?seed=1&size=" + std::to_string(state.range(0));
+    std::string dst = "mock://bench.example.com/dst?seed=1&verify=1";
+
+    // No stat nor removal of the destination
+    gfalt_params_t params = gfalt_params_handle_new(NULL);
+    gfalt_set_strict_copy_mode(params, TRUE, NULL);
+
+    for (auto _ : state) {
+        GError *error = NULL;
+        if (perform_local_copy(context, params, src.c_str(), dst.c_str(), &error) < 0) {
+            state.SkipWithError(error->message);
+            g_error_free(error);
+            break;
+        }
+    }
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+
+    gfalt_params_handle_delete(params, NULL);
+}
+BENCHMARK_REGISTER_F(MockContextFixture, BM_StreamedCopy)->Arg(1 << 20)->Arg(64 << 20)->Unit(benchmark::kMillisecond);
+
+
+// Instant third party copy, with the checksums of both ends validated
+// This is the overhead of gfalt_copy_file around the plugin copy
+BENCHMARK_DEFINE_F(MockContextFixture, BM_ThirdPartyCopy)(benchmark::State& state)
+{
+    if (state.error_occurred()) {
+        return;
+    }
+
+    std::string size = std::to_string(state.range(0));
+    std::string src = "mock://bench.example.com/src?seed=1&checksum=data&size=" + size;
+    std::string dst = "mock://bench.example.com/dst?seed=1&checksum=data&time=0&size=" + size;
+
+    gfalt_params_t params = gfalt_params_handle_new(NULL);
+    gfalt_set_replace_existing_file(params, TRUE, NULL);
+    gfalt_set_checksum(params, GFALT_CHECKSUM_BOTH, "ADLER32", NULL, NULL);
+
+    for (auto _ : state) {
+        GError *error = NULL;
+        if (gfalt_copy_file(context, params, src.c_str(), dst.c_str(), &error) < 0) {
+            state.SkipWithError(error->message);
+            g_error_free(error);
+            break;
+        }
+    }
+
+    gfalt_params_handle_delete(params, NULL);
+}
+BENCHMARK_REGISTER_F(MockContextFixture, BM_ThirdPartyCopy)->Arg(0)->Arg(1 << 20)->Unit(benchmark::kMicrosecond);
@@ -0,0 +1,152 @@
+/*
+ * Copyright (c) CERN 2013-2017
+ *
+ * Copyright (c) Members of the EMI Collaboration. 2010-2013
+ *  See  http://www.eu-emi.eu/partners for details on the copyright
+ *  holders.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gfal_api.h>
+#include <gfal_plugins_api.h>
+#define __GFAL2_H_INSIDE__
+#include <common/gfal_file_handler_container.h>
+#undef __GFAL2_H_INSIDE__
+#include <benchmark/benchmark.h>
+#include "bench_context.h"
+
+#include <string>
+#include <vector>
+
+
+static const char *bench_plugin_get_name(void)
+{
+    return "BENCH PLUGIN";
+}
+
+
+// The plugin data is the scheme handled by the plugin
+static gboolean bench_plugin_url(plugin_handle plugin_data, const char *url,
+    plugin_mode operation, GError **err)
+{
+    const char *scheme = (const char*)plugin_data;
+    return strncmp(url, scheme, strlen(scheme)) == 0;
+}
+
+
+// Cost of finding the plugin for an url, with state.range(0) plugins registered
+BENCHMARK_DEFINE_F(ContextFixture, BM_FindPlugin)(benchmark::State& state)
+{
+    if (state.error_occurred()) {
+        return;
+    }
+
+    GError *error = NULL;
+    std::vector<std::string> schemes;
+    for (int i = 0; i < state.range(0); ++i) {
+        schemes.push_back("bench" + std::to_string(i) + "://");
+    }
+    for (size_t i = 0; i < schemes.size(); ++i) {
+        gfal_plugin_interface plugin;
+        memset(&plugin, 0, sizeof(plugin));
+        plugin.plugin_data = (plugin_handle)schemes[i].c_str();
+        plugin.getName = bench_plugin_get_name;
+        plugin.check_plugin_url = bench_plugin_url;
+        if (gfal2_register_plugin(context, &plugin, NULL) < 0) {
+            state.SkipWithError("plugin table full");
+            return;
+        }
+    }
+
+    // The last one registered is the worst case
+    std::string url = schemes.back() + "host/path/to/file";
+    for (auto _ : state) {
+        gfal_plugin_interface *plugin = gfal_find_plugin(context, url.c_str(), GFAL_PLUGIN_STAT, &error);
+        benchmark::DoNotOptimize(plugin);
+    }
+}
+BENCHMARK_REGISTER_F(ContextFixture, BM_FindPlugin)->Arg(1)->Arg(4)->Arg(8);
+
+
+BENCHMARK_DEFINE_F(ContextFixture, BM_ConfigGetInteger)(benchmark::State& state)
+{
+    for (auto _ : state) {
+        gint value = gfal2_get_opt_integer_with_default(context, "CORE", "CHECKSUM_TIMEOUT", 1800);
+        benchmark::DoNotOptimize(value);
+    }
+}
+BENCHMARK_REGISTER_F(ContextFixture, BM_ConfigGetInteger);
+
+
+BENCHMARK_DEFINE_F(ContextFixture, BM_ConfigGetString)(benchmark::State& state)
+{
+    if (state.error_occurred()) {
+        return;
+    }
+
+    gfal2_set_opt_string(context, "BENCH", "KEY", "value", NULL);
+    for (auto _ : state) {
+        gchar *value = gfal2_get_opt_string_with_default(context, "BENCH", "KEY", "default");
+        g_free(value);
+    }
+}
+BENCHMARK_REGISTER_F(ContextFixture, BM_ConfigGetString);
+
+
+// Lookup of the credential for an url, with state.range(0) prefixes configured
+BENCHMARK_DEFINE_F(ContextFixture, BM_CredGet)(benchmark::State& state)
+{
+    if (state.error_occurred()) {
+        return;
+    }
+
+    for (int i = 0; i < state.range(0); ++i) {
+        char prefix[128], token[64];
+        snprintf(prefix, sizeof(prefix), "https://host-%d.example.com/path/", i);
+        snprintf(token, sizeof(token), "token-%d", i);
+        gfal2_cred_t *cred = gfal2_cred_new("BEARER", token);
+        gfal2_cred_set(context, prefix, cred, NULL);
+        gfal2_cred_free(cred);
+    }
+
+    for (auto _ : state) {
+        const char *baseurl = NULL;
+        char *value = gfal2_cred_get(context, "BEARER", "https://host-0.example.com/path/to/file",
+            &baseurl, NULL);
+        g_free(value);
+    }
+}
+BENCHMARK_REGISTER_F(ContextFixture, BM_CredGet)->Arg(1)->Arg(16)->Arg(256);
+
+
+// Open, lookup and close of a descriptor, with state.range(0) descriptors already open
+static void BM_DescriptorTable(benchmark::State& state)
+{
+    gfal_file_handle_container container = gfal_file_descriptor_handle_create(NULL);
+    int dummy;
+
+    for (int i = 0; i < state.range(0); ++i) {
+        gfal_add_new_file_desc(container, &dummy, NULL);
+    }
+
+    for (auto _ : state) {
+        int fd = gfal_add_new_file_desc(container, &dummy, NULL);
+        gfal_file_handle handle = gfal_file_handle_bind(container, fd, NULL);
+        benchmark::DoNotOptimize(handle);
+        gfal_remove_file_desc(container, fd, NULL);
+    }
+
+    gfal_file_descriptor_handle_destroy(container);
+}
+BENCHMARK(BM_DescriptorTable)->Arg(0)->Arg(1024);
@@ -0,0 +1,106 @@
+/*
+ * Copyright (c) CERN 2013-2017
+ *
+ * Copyright (c) Members of the EMI Collaboration. 2010-2013
+ *  See  http://www.eu-emi.eu/partners for details on the copyright
+ *  holders.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gfal_api.h>
+#include <benchmark/benchmark.h>
+#include "bench_context.h"
+
+#include <stdio.h>
+#include <unistd.h>
+#include <string>
+#include <vector>
+
+
+// Context with the file plugin loaded, the benchmark is skipped if it is not available
+class FileContextFixture: public ContextFixture {
+public:
+    using ContextFixture::SetUp;
+
+    void SetUp(benchmark::State& state)
+    {
+        ContextFixture::SetUp(state);
+        RequirePlugin(state, "file:///", "file");
+    }
+};
+
+
+// Create a temporary file with the given size, and return its url
+static std::string bench_file_create(size_t size)
+{
+    char path[] = "/tmp/gfal2_bench_XXXXXX";
+    int fd = mkstemp(path);
+    if (fd < 0) {
+        return std::string();
+    }
+
+    std::vector<char> block(1 << 20, 'x');
+    while (size > 0) {
+        size_t n = std::min(size, block.size());
+        if (write(fd, block.data(), n) != (ssize_t)n) {
+            break;
+        }
+        size -= n;
+    }
+    close(fd);
+    return std::string("file://") + path;
+}
+
+
+static const char *bench_checksum_types[] = {"ADLER32", "CRC32", "MD5"};
+
+
+// Every checksum type, with a small and a large file
+static void bench_checksum_args(benchmark::internal::Benchmark *b)
+{
+    for (size_t i = 0; i < G_N_ELEMENTS(bench_checksum_types); ++i) {
+        b->Args({(int64_t)i, 1 << 20});
+        b->Args({(int64_t)i, 64 << 20});
+    }
+}
+
+
+// Checksum of a local file, of type state.range(0) and size state.range(1)
+BENCHMARK_DEFINE_F(FileContextFixture, BM_FileChecksum)(benchmark::State& state)
+{
+    if (state.error_occurred()) {
+        return;
+    }
+
+    const char *type = bench_checksum_types[state.range(0)];
+    state.SetLabel(type);
+
+    std::string url = bench_file_create(state.range(1));
+    char checksum[64];
+
+    for (auto _ : state) {
+        GError *error = NULL;
+        if (gfal2_checksum(context, url.c_str(), type, 0, 0, checksum, sizeof(checksum), &error) < 0) {
+            state.SkipWithError(error->message);
+            g_error_free(error);
+            break;
+        }
+    }
+    state.SetBytesProcessed(state.iterations() * state.range(1));
+
+    unlink(url.c_str() + 7);
+}
+BENCHMARK_REGISTER_F(FileContextFixture, BM_FileChecksum)
+    ->Apply(bench_checksum_args)
+    ->Unit(benchmark::kMillisecond);
@@ -0,0 +1,300 @@
+/*
+ * Copyright (c) CERN 2013-2017
+ *
+ * Copyright (c) Members of the EMI Collaboration. 2010-2013
+ *  See  http://www.eu-emi.eu/partners for details on the copyright
+ *  holders.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <glib.h>
+#include <plugins/gridftp/gridftp_mlsd_parser.h>
+#include <benchmark/benchmark.h>
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <algorithm>
+#include <sstream>
+#include <string>
+#include <vector>
+
+
+// MLSD output recorded from a Globus GridFTP server, listing a directory of a storage element
+static const char *mlsd_recorded[] = {
+    "Type=cdir;Modify=20170321094405;Size=4096;Perm=cfmpel;UNIX.mode=0775;UNIX.owner=dteam001;UNIX.uid=20101;UNIX.group=dteam;UNIX.gid=2010;Unique=fd01-4060042; .\r\n",
+    "Type=pdir;Modify=20170118152211;Size=4096;Perm=el;UNIX.mode=0755;UNIX.owner=root;UNIX.uid=0;UNIX.group=root;UNIX.gid=0;Unique=fd01-2; ..\r\n",
+    "Type=dir;Modify=20170320181530;Size=4096;Perm=cfmpel;UNIX.mode=0775;UNIX.owner=dteam001;UNIX.uid=20101;UNIX.group=dteam;UNIX.gid=2010;Unique=fd01-4060107; run2017A\r\n",
+    "Type=file;Modify=20170321093012;Size=2147483648;Perm=adfrw;UNIX.mode=0644;UNIX.owner=dteam001;UNIX.uid=20101;UNIX.group=dteam;UNIX.gid=2010;Unique=fd01-4060113; AOD.10934187._000001.pool.root.1\r\n",
+    "Type=file;Modify=20170321093108;Size=2094311942;Perm=adfrw;UNIX.mode=0644;UNIX.owner=dteam001;UNIX.uid=20101;UNIX.group=dteam;UNIX.gid=2010;Unique=fd01-4060114; AOD.10934187._000002.pool.root.1\r\n",
+    "Type=file;Modify=20170321093305;Size=1048576;Perm=adfrw;UNIX.mode=0600;UNIX.owner=dteam002;UNIX.uid=20102;UNIX.group=dteam;UNIX.gid=2010;Unique=fd01-4060131; log.10934187._000001.job.log.tgz.1\r\n",
+    "Type=OS.unix=slink:/dpm/example.com/home/dteam/data;Modify=20170210120000;Size=32;Perm=adfrw;UNIX.mode=0777;UNIX.owner=dteam001;UNIX.uid=20101;UNIX.group=dteam;UNIX.gid=2010;Unique=fd01-4060140;UNIX.slink=/dpm/example.com/home/dteam/data; latest\r\n",
+    "Type=file;Modify=20170321094405;Size=0;Perm=adfrw;UNIX.mode=0644;UNIX.owner=dteam001;UNIX.uid=20101;UNIX.group=dteam;UNIX.gid=2010;Unique=fd01-4060152; file with spaces.txt\r\n",
+};
+
+
+// Build a listing of nentries lines, based on the recorded output with unique names
+static std::string mlsd_build_listing(size_t nentries)
+{
+    std::string listing;
+    char suffix[32];
+    for (size_t i = 0; i < nentries; ++i) {
+        std::string line(mlsd_recorded[i % G_N_ELEMENTS(mlsd_recorded)]);
+        snprintf(suffix, sizeof(suffix), ".%zu", i);
+        line.insert(line.size() - 2, suffix);
+        listing.append(line);
+    }
+    return listing;
+}
+
+
+static void BM_MlsdParseLine(benchmark::State& state)
+{
+    const char *line = mlsd_recorded[state.range(0)];
+    size_t len = strlen(line);
+    struct stat st;
+    const char *name;
+    size_t name_len;
+
+    for (auto _ : state) {
+        int ret = gridftp_parse_mlsd_entry(line, len, &st, &name, &name_len);
+        benchmark::DoNotOptimize(ret);
+        benchmark::DoNotOptimize(st);
+    }
+}
+BENCHMARK(BM_MlsdParseLine)->DenseRange(0, G_N_ELEMENTS(mlsd_recorded) - 1);
+
+
+// Parse a whole listing as the MLSD reader does: one batch per 64 KiB chunk received
+static void BM_MlsdParseListing(benchmark::State& state)
+{
+    const std::string listing = mlsd_build_listing(state.range(0));
+    const size_t chunk = 65535;
+    std::vector<GridFtpMlsdEntry> batch;
+    const char *error_line;
+    size_t error_len;
+
+    for (auto _ : state) {
+        size_t offset = 0;
+        size_t received = 0;
+        while (offset < listing.size()) {
+            received = std::min(received + chunk, listing.size());
+            bool eof = (received == listing.size());
+            batch.clear();
+            ssize_t consumed = gridftp_parse_mlsd_batch(listing.data() + offset, received - offset, eof,
+                    batch, &error_line, &error_len);
+            if (consumed < 0) {
+                state.SkipWithError("Failed to parse the listing");
+                return;
+            }
+            offset += consumed;
+            benchmark::DoNotOptimize(batch.data());
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+    state.SetBytesProcessed(state.iterations() * listing.size());
+}
+BENCHMARK(BM_MlsdParseListing)->Arg(1000)->Arg(100000);
+
+
+static void BM_MdtmToTime(benchmark::State& state)
+{
+    for (auto _ : state) {
+        time_t t = gridftp_mdtm_to_timet("20170321093012.123", 18);
+        benchmark::DoNotOptimize(t);
+    }
+}
+BENCHMARK(BM_MdtmToTime);
+
+
+// Baseline: the parser used before gridftp_mlsd_parser.cpp, without its Globus error reporting.
+// Each line was read with std::getline, trimmed, copied with strdup and split in place.
+static int legacy_mdtm_to_timet(char *mdtm_str, int *time_out)
+{
+    char *p = mdtm_str;
+    struct tm tm, gmt_now_tm;
+    time_t now, gmt_now, file_time;
+
+    memset(&tm, '\0', sizeof(struct tm));
+    if (sscanf(p, "%04d", &tm.tm_year) != 1)
+        return -1;
+    tm.tm_year -= 1900;
+    p += 4;
+    if (sscanf(p, "%02d", &tm.tm_mon) != 1)
+        return -1;
+    tm.tm_mon--;
+    p += 2;
+    if (sscanf(p, "%02d", &tm.tm_mday) != 1)
+        return -1;
+    p += 2;
+    if (sscanf(p, "%02d", &tm.tm_hour) != 1)
+        return -1;
+    p += 2;
+    if (sscanf(p, "%02d", &tm.tm_min) != 1)
+        return -1;
+    p += 2;
+    if (sscanf(p, "%02d", &tm.tm_sec) != 1)
+        return -1;
+
+    file_time = mktime(&tm);
+    if (file_time == (time_t) -1)
+        return -1;
+    now = time(&now);
+    memset(&gmt_now_tm, '\0', sizeof(struct tm));
+    if (gmtime_r(&now, &gmt_now_tm) == NULL)
+        return -1;
+    gmt_now = mktime(&gmt_now_tm);
+    if (gmt_now == (time_t) -1)
+        return -1;
+
+    *time_out = file_time + (now - gmt_now);
+    return 0;
+}
+
+
+static int legacy_parse_mlst_line(char *line, struct stat *stat_info, char *filename_buf, size_t filename_size)
+{
+    char *mode_s = NULL, *modify_s = NULL, *size_s = NULL;
+    bool is_dir = false;
+
+    char *space = strchr(line, ' ');
+    if (space == NULL)
+        return -1;
+    *space = '\0';
+    char *filename = space + 1;
+    char *startfact = line;
+
+    size_t len = g_strlcpy(filename_buf, filename, filename_size);
+    char *trailing = filename_buf + len;
+    do {
+        *trailing = '\0';
+        --trailing;
+    } while (trailing >= filename_buf && isspace(*trailing));
+
+    while (startfact != space) {
+        char *endfact = strchr(startfact, ';');
+        if (endfact)
+            *endfact = '\0';
+        else
+            endfact = space - 1;
+
+        char *factval = strchr(startfact, '=');
+        if (!factval)
+            return -1;
+        *(factval++) = '\0';
+
+        for (int i = 0; startfact[i] != '\0'; i++)
+            startfact[i] = tolower(startfact[i]);
+
+        if (strcmp(startfact, "type") == 0) {
+            is_dir = strcasecmp(factval, "dir") == 0 || strcasecmp(factval, "pdir") == 0 ||
+                     strcasecmp(factval, "cdir") == 0;
+        }
+        if (strcmp(startfact, "unix.mode") == 0)
+            mode_s = factval;
+        if (strcmp(startfact, "modify") == 0)
+            modify_s = factval;
+        if (strcmp(startfact, "size") == 0)
+            size_s = factval;
+        if (strcmp(startfact, "unix.uid") == 0)
+            stat_info->st_uid = atoi(factval);
+        if (strcmp(startfact, "unix.gid") == 0)
+            stat_info->st_gid = atoi(factval);
+
+        startfact = endfact + 1;
+    }
+
+    stat_info->st_nlink = 1;
+    stat_info->st_mode = -1;
+    stat_info->st_size = 0;
+    stat_info->st_mtime = -1;
+
+    if (mode_s) {
+        stat_info->st_mode = strtoul(mode_s, NULL, 8);
+        stat_info->st_mode |= is_dir ? S_IFDIR : S_IFREG;
+    }
+    if (size_s) {
+        long size;
+        if (sscanf(size_s, "%ld", &size) == 1)
+            stat_info->st_size = size;
+    }
+    if (modify_s) {
+        int mdtm;
+        if (legacy_mdtm_to_timet(modify_s, &mdtm) == 0)
+            stat_info->st_mtime = mdtm;
+    }
+    return 0;
+}
+
+
+static std::string& legacy_trim(std::string& str)
+{
+    size_t i = 0;
+    while (i < str.length() && isspace(str[i]))
+        ++i;
+    str = str.substr(i);
+    int j = str.length() - 1;
+    while (j >= 0 && isspace(str[j]))
+        --j;
+    str = str.substr(0, j + 1);
+    return str;
+}
+
+
+static void BM_MlsdParseLineLegacy(benchmark::State& state)
+{
+    const std::string recorded(mlsd_recorded[state.range(0)]);
+    struct stat st;
+    char name[256];
+
+    for (auto _ : state) {
+        std::string line(recorded);
+        char *unparsed = strdup(legacy_trim(line).c_str());
+        int ret = legacy_parse_mlst_line(unparsed, &st, name, sizeof(name));
+        free(unparsed);
+        benchmark::DoNotOptimize(ret);
+        benchmark::DoNotOptimize(st);
+    }
+}
+BENCHMARK(BM_MlsdParseLineLegacy)->DenseRange(0, G_N_ELEMENTS(mlsd_recorded) - 1);
+
+
+static void BM_MlsdParseListingLegacy(benchmark::State& state)
+{
+    const std::string listing = mlsd_build_listing(state.range(0));
+    struct stat st;
+    char name[256];
+
+    for (auto _ : state) {
+        std::istringstream in(listing);
+        std::string line;
+        while (std::getline(in, line)) {
+            if (legacy_trim(line).empty())
+                continue;
+            char *unparsed = strdup(line.c_str());
+            int ret = legacy_parse_mlst_line(unparsed, &st, name, sizeof(name));
+            free(unparsed);
+            if (ret < 0) {
+                state.SkipWithError("Failed to parse the listing");
+                return;
+            }
+            benchmark::DoNotOptimize(st);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+    state.SetBytesProcessed(state.iterations() * listing.size());
+}
+BENCHMARK(BM_MlsdParseListingLegacy)->Arg(1000)->Arg(100000);
@@ -0,0 +1,127 @@
+/*
+ * Copyright (c) CERN 2013-2017
+ *
+ * Copyright (c) Members of the EMI Collaboration. 2010-2013
+ *  See  http://www.eu-emi.eu/partners for details on the copyright
+ *  holders.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gfal_api.h>
+#include <benchmark/benchmark.h>
+#include "bench_context.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <string>
+
+
+// Point GFAL_CONFIG_DIR to a configuration with only CORE:PLUGIN_LAZY_LOADING set,
+// so both modes can be compared from the same run. The plugins run with their defaults.
+class LazyLoadingConfig {
+public:
+    LazyLoadingConfig(bool lazy): previous(NULL)
+    {
+        char tmpl[] = "/tmp/gfal2_bench_config_XXXXXX";
+        dir = mkdtemp(tmpl);
+        file = dir + "/bench.conf";
+        FILE *fd = fopen(file.c_str(), "w");
+        fprintf(fd, "[CORE]\nPLUGIN_LAZY_LOADING=%s\n", lazy ? "true" : "false");
+        fclose(fd);
+
+        const char *env = getenv("GFAL_CONFIG_DIR");
+        if (env)
+            previous = strdup(env);
+        setenv("GFAL_CONFIG_DIR", dir.c_str(), 1);
+    }
+
+    ~LazyLoadingConfig()
+    {
+        if (previous)
+            setenv("GFAL_CONFIG_DIR", previous, 1);
+        else
+            unsetenv("GFAL_CONFIG_DIR");
+        free(previous);
+        unlink(file.c_str());
+        rmdir(dir.c_str());
+    }
+
+private:
+    std::string dir, file;
+    char *previous;
+};
+
+
+// Cost of creating and releasing a context, with state.range(0) the lazy loading
+static void BM_ContextNew(benchmark::State& state)
+{
+    LazyLoadingConfig config(state.range(0));
+
+    for (auto _ : state) {
+        GError *error = NULL;
+        gfal2_context_t context = gfal2_context_new(&error);
+        if (context == NULL) {
+            state.SkipWithError(error->message);
+            g_error_free(error);
+            break;
+        }
+        gfal2_context_free(context);
+    }
+}
+BENCHMARK(BM_ContextNew)->ArgName("lazy")->Arg(0)->Arg(1)->Unit(benchmark::kMicrosecond);
+
+
+// Same, plus a first stat on a file:// url, as a short lived command would do
+static void BM_ContextFirstStat(benchmark::State& state)
+{
+    LazyLoadingConfig config(state.range(0));
+
+    for (auto _ : state) {
+        GError *error = NULL;
+        gfal2_context_t context = gfal2_context_new(&error);
+        if (context == NULL) {
+            state.SkipWithError(error->message);
+            g_error_free(error);
+            break;
+        }
+        struct stat st;
+        if (gfal2_stat(context, "file:///", &st, &error) < 0) {
+            state.SkipWithError("file plugin not found, check GFAL_PLUGIN_DIR");
+            g_error_free(error);
+            gfal2_context_free(context);
+            break;
+        }
+        gfal2_context_free(context);
+    }
+}
+BENCHMARK(BM_ContextFirstStat)->ArgName("lazy")->Arg(0)->Arg(1)->Unit(benchmark::kMicrosecond);
+
+
+// Cost of cloning a context, to compare with BM_ContextNew
+BENCHMARK_DEFINE_F(ContextFixture, BM_ContextClone)(benchmark::State& state)
+{
+    for (auto _ : state) {
+        GError *error = NULL;
+        gfal2_context_t clone = gfal2_context_clone(context, &error);
+        if (clone == NULL) {
+            state.SkipWithError(error->message);
+            g_error_free(error);
+            break;
+        }
+        gfal2_context_free(clone);
+    }
+}
+BENCHMARK_REGISTER_F(ContextFixture, BM_ContextClone)->Unit(benchmark::kMicrosecond);
@@ -0,0 +1,167 @@
+/*
+ * Copyright (c) CERN 2017
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "gfal_fake_plugin.h"
+
+
+gfal_fake_plugin_calls_t gfal_fake_plugin_calls = {0, 0, 0};
+
+
+static const char *gfal_fake_plugin_get_name(void)
+{
+    return GFAL_FAKE_PLUGIN_NAME;
+}
+
+
+static gboolean gfal_fake_plugin_url(plugin_handle plugin_data, const char *url,
+    plugin_mode operation, GError **err)
+{
+    return strncmp(url, "fake://", 7) == 0;
+}
+
+
+int gfal_fake_plugin_stat(plugin_handle plugin_data, const char *url, struct stat *buf, GError **err)
+{
+    gint calls = g_atomic_int_add(&gfal_fake_plugin_calls.stat, 1) + 1;
+    if (strstr(url, "missing")) {
+        gfal2_set_error(err, g_quark_from_static_string("fake"), ENOENT, __func__, "Not found");
+        return -1;
+    }
+    memset(buf, 0, sizeof(*buf));
+    buf->st_mode = S_IFREG | 0644;
+    buf->st_size = calls;
+    return 0;
+}
+
+
+static int gfal_fake_plugin_access(plugin_handle plugin_data, const char *url, int mode, GError **err)
+{
+    g_atomic_int_inc(&gfal_fake_plugin_calls.access);
+    return 0;
+}
+
+
+static ssize_t gfal_fake_plugin_getxattr(plugin_handle plugin_data, const char *url, const char *key,
+    void *buff, size_t s_buff, GError **err)
+{
+    const char *value = "ONLINE";
+    g_atomic_int_inc(&gfal_fake_plugin_calls.getxattr);
+    if (s_buff > 0)
+        g_strlcpy((char*)buff, value, s_buff);
+    return strlen(value);
+}
+
+
+static int gfal_fake_plugin_unlink(plugin_handle plugin_data, const char *url, GError **err)
+{
+    return 0;
+}
+
+
+static int gfal_fake_plugin_rename(plugin_handle plugin_data, const char *oldurl, const char *newurl,
+    GError **err)
+{
+    return 0;
+}
+
+
+// State of a listing, kept by its handle
+typedef struct {
+    int listed;
+    struct dirent entry;
+} gfal_fake_plugin_dir_t;
+
+
+static gfal_file_handle gfal_fake_plugin_opendir(plugin_handle plugin_data, const char *url, GError **err)
+{
+    return gfal_file_handle_new2(GFAL_FAKE_PLUGIN_NAME, g_new0(gfal_fake_plugin_dir_t, 1), NULL, url);
+}
+
+
+static struct dirent *gfal_fake_plugin_readdirpp(plugin_handle plugin_data, gfal_file_handle fh,
+    struct stat *st, GError **err)
+{
+    gfal_fake_plugin_dir_t *dir = (gfal_fake_plugin_dir_t*)gfal_file_handle_get_fdesc(fh);
+    if (dir->listed >= 2)
+        return NULL;
+    ++dir->listed;
+
+    snprintf(dir->entry.d_name, sizeof(dir->entry.d_name), "file%d", dir->listed);
+    memset(st, 0, sizeof(*st));
+    st->st_mode = S_IFREG | 0644;
+    st->st_size = 100 + dir->listed;
+    return &dir->entry;
+}
+
+
+static int gfal_fake_plugin_closedir(plugin_handle plugin_data, gfal_file_handle fh, GError **err)
+{
+    g_free(gfal_file_handle_get_fdesc(fh));
+    gfal_file_handle_delete(fh);
+    return 0;
+}
+
+
+static gfal_file_handle gfal_fake_plugin_open(plugin_handle plugin_data, const char *url, int flag,
+    mode_t mode, GError **err)
+{
+    return gfal_file_handle_new2(GFAL_FAKE_PLUGIN_NAME, NULL, NULL, url);
+}
+
+
+static ssize_t gfal_fake_plugin_pread(plugin_handle plugin_data, gfal_file_handle fd, void *buff,
+    size_t count, off_t offset, GError **err)
+{
+    return count;
+}
+
+
+static int gfal_fake_plugin_close(plugin_handle plugin_data, gfal_file_handle fd, GError **err)
+{
+    gfal_file_handle_delete(fd);
+    return 0;
+}
+
+
+void gfal_fake_plugin_interface(gfal_plugin_interface *plugin)
+{
+    memset(plugin, 0, sizeof(*plugin));
+    plugin->getName = gfal_fake_plugin_get_name;
+    plugin->check_plugin_url = gfal_fake_plugin_url;
+    plugin->statG = gfal_fake_plugin_stat;
+    plugin->accessG = gfal_fake_plugin_access;
+    plugin->getxattrG = gfal_fake_plugin_getxattr;
+    plugin->unlinkG = gfal_fake_plugin_unlink;
+    plugin->renameG = gfal_fake_plugin_rename;
+    plugin->opendirG = gfal_fake_plugin_opendir;
+    plugin->readdirppG = gfal_fake_plugin_readdirpp;
+    plugin->closedirG = gfal_fake_plugin_closedir;
+    plugin->openG = gfal_fake_plugin_open;
+    plugin->preadG = gfal_fake_plugin_pread;
+    plugin->closeG = gfal_fake_plugin_close;
+}
+
+
+void gfal_fake_plugin_reset_calls(void)
+{
+    g_atomic_int_set(&gfal_fake_plugin_calls.stat, 0);
+    g_atomic_int_set(&gfal_fake_plugin_calls.access, 0);
+    g_atomic_int_set(&gfal_fake_plugin_calls.getxattr, 0);
+}
@@ -0,0 +1,67 @@
+/*
+ * Copyright (c) CERN 2017
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+#ifndef GFAL_FAKE_PLUGIN_H
+#define GFAL_FAKE_PLUGIN_H
+
+#include <gfal_api.h>
+#include <gfal_plugins_api.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define GFAL_FAKE_PLUGIN_NAME "FAKE PLUGIN"
+
+/**
+ * Calls received by the fake plugin, updated atomically
+ */
+typedef struct {
+    gint stat;
+    gint access;
+    gint getxattr;
+} gfal_fake_plugin_calls_t;
+
+extern gfal_fake_plugin_calls_t gfal_fake_plugin_calls;
+
+/**
+ * Fill plugin with the fake plugin, which handles the fake:// urls without any storage behind:
+ *  - stat fails with ENOENT if the url contains "missing", otherwise it returns a regular file
+ *    whose size is the number of stat calls so far, so a cached answer can be told apart
+ *  - access, unlink and rename succeed
+ *  - getxattr returns "ONLINE" for every attribute
+ *  - a directory lists file1 and file2, of size 101 and 102
+ *  - open succeeds, and pread returns as many bytes as asked
+ * Tests can override any entry before registering the plugin with gfal2_register_plugin
+ */
+void gfal_fake_plugin_interface(gfal_plugin_interface *plugin);
+
+/**
+ * Set all the call counters back to 0
+ */
+void gfal_fake_plugin_reset_calls(void);
+
+/**
+ * Stat of the fake plugin, for overrides calling it
+ */
+int gfal_fake_plugin_stat(plugin_handle plugin_data, const char *url, struct stat *buf, GError **err);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* GFAL_FAKE_PLUGIN_H */
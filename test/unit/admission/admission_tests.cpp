@@ -0,0 +1,338 @@
+/*
+ * Copyright (c) CERN 2013-2017
+ *
+ * Copyright (c) Members of the EMI Collaboration. 2010-2013
+ *  See  http://www.eu-emi.eu/partners for details on the copyright
+ *  holders.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gfal_api.h>
+#include <gfal_plugins_api.h>
+#include <gtest/gtest.h>
+#include <common/gfal_fake_plugin.h>
+#include <pthread.h>
+#include <vector>
+
+
+static gint calls_in_flight = 0;
+static gint max_in_flight = 0;
+static gint blocked = 0;
+static gfal2_context_t nested_context = NULL;
+
+
+static int admit_plugin_mkdir(plugin_handle plugin_data, const char *url, mode_t mode,
+    gboolean rec_flag, GError **err)
+{
+    gint current = g_atomic_int_add(&calls_in_flight, 1) + 1;
+    gint max;
+    do {
+        max = g_atomic_int_get(&max_in_flight);
+    } while (current > max && !g_atomic_int_compare_and_exchange(&max_in_flight, max, current));
+
+    g_usleep(20000);
+    while (strstr(url, "/block") && g_atomic_int_get(&blocked))
+        g_usleep(10000);
+
+    g_atomic_int_add(&calls_in_flight, -1);
+    return 0;
+}
+
+
+// Calls back into gfal2 for the same endpoint
+static int admit_plugin_chmod(plugin_handle plugin_data, const char *url, mode_t mode, GError **err)
+{
+    struct stat st;
+    return gfal2_stat(nested_context, url, &st, err);
+}
+
+
+class AdmissionTest: public testing::Test {
+public:
+    gfal2_context_t context;
+
+    AdmissionTest() {
+        context = NewContext();
+        calls_in_flight = max_in_flight = blocked = 0;
+    }
+
+    virtual ~AdmissionTest() {
+        gfal2_context_free(context);
+    }
+
+    gfal2_context_t NewContext() {
+        GError *tmp_err = NULL;
+        gfal_plugin_interface plugin;
+        gfal_fake_plugin_interface(&plugin);
+        plugin.mkdirpG = admit_plugin_mkdir;
+        plugin.chmodG = admit_plugin_chmod;
+
+        gfal2_context_t ctx = gfal2_context_new(&tmp_err);
+        EXPECT_TRUE(ctx != NULL);
+        EXPECT_EQ(0, gfal2_register_plugin(ctx, &plugin, &tmp_err));
+        return ctx;
+    }
+};
+
+
+struct MkdirArgs {
+    gfal2_context_t context;
+    const char* url;
+    int ret;
+    int errcode;
+};
+
+
+static void* mkdir_thread(void* data)
+{
+    MkdirArgs* args = static_cast<MkdirArgs*>(data);
+    GError* error = NULL;
+    args->ret = gfal2_mkdir(args->context, args->url, 0755, &error);
+    args->errcode = error ? error->code : 0;
+    g_clear_error(&error);
+    return NULL;
+}
+
+
+static guint64 queue_wait_count(const char* host)
+{
+    guint64 count = 0;
+    gfal2_metrics_snapshot_t snapshot = gfal2_metrics_snapshot();
+    for (guint i = 0; i < gfal2_metrics_snapshot_length(snapshot); ++i) {
+        const gfal2_metric_t* metric = gfal2_metrics_snapshot_get(snapshot, i);
+        if (strcmp(metric->operation, "queue_wait") == 0 && strcmp(metric->host, host) == 0)
+            count += metric->count;
+    }
+    gfal2_metrics_snapshot_free(snapshot);
+    return count;
+}
+
+
+TEST_F(AdmissionTest, Unlimited)
+{
+    GError* error = NULL;
+    ASSERT_EQ(0, gfal2_mkdir(context, "fake://unlimited.cern.ch/dir", 0755, &error));
+    // Calls to endpoints without limits do not go through the queue
+    EXPECT_EQ(0, queue_wait_count("unlimited.cern.ch"));
+}
+
+
+TEST_F(AdmissionTest, MaxConcurrency)
+{
+    const int nthreads = 8;
+    pthread_t threads[nthreads];
+    MkdirArgs args[nthreads];
+
+    gfal2_metrics_set_enabled(TRUE);
+
+    // The group without port applies to every port of the host
+    gfal2_set_opt_integer(context, "ENDPOINT:CONCURRENCY.CERN.CH", "MAX_CONCURRENCY", 2, NULL);
+
+    for (int i = 0; i < nthreads; ++i) {
+        args[i].context = context;
+        args[i].url = "fake://concurrency.cern.ch:1094/dir";
+        pthread_create(&threads[i], NULL, mkdir_thread, &args[i]);
+    }
+    for (int i = 0; i < nthreads; ++i) {
+        pthread_join(threads[i], NULL);
+        EXPECT_EQ(0, args[i].ret);
+    }
+
+    EXPECT_LE(max_in_flight, 2);
+    EXPECT_EQ(nthreads, queue_wait_count("concurrency.cern.ch:1094"));
+}
+
+
+TEST_F(AdmissionTest, Rate)
+{
+    GError* error = NULL;
+    gfal2_set_opt_integer(context, "ENDPOINT:RATE.CERN.CH", "RATE", 20, NULL);
+    gfal2_set_opt_integer(context, "ENDPOINT:RATE.CERN.CH", "BURST", 1, NULL);
+
+    gint64 start = g_get_monotonic_time();
+    for (int i = 0; i < 5; ++i)
+        ASSERT_EQ(0, gfal2_mkdir(context, "fake://rate.cern.ch/dir", 0755, &error));
+    gint64 elapsed = g_get_monotonic_time() - start;
+
+    // One call every 50ms after the first one
+    EXPECT_GE(elapsed, 180000);
+}
+
+
+TEST_F(AdmissionTest, Nested)
+{
+    GError* error = NULL;
+    nested_context = context;
+    gfal2_set_opt_integer(context, "ENDPOINT:NESTED.CERN.CH", "MAX_CONCURRENCY", 1, NULL);
+
+    // The stat made by the plugin while it holds the only slot must not wait for it
+    EXPECT_EQ(0, gfal2_chmod(context, "fake://nested.cern.ch/file", 0644, &error));
+    EXPECT_EQ(NULL, error);
+    nested_context = NULL;
+}
+
+
+static void* cancel_after_delay(void* data)
+{
+    g_usleep(200000);
+    gfal2_cancel((gfal2_context_t) data);
+    return NULL;
+}
+
+
+TEST_F(AdmissionTest, Cancel)
+{
+    pthread_t holder, canceller;
+    MkdirArgs hold_args = {context, "fake://cancel.cern.ch/block", -1, 0};
+    GError* error = NULL;
+
+    gfal2_set_opt_integer(context, "ENDPOINT:CANCEL.CERN.CH", "MAX_CONCURRENCY", 1, NULL);
+    blocked = 1;
+    pthread_create(&holder, NULL, mkdir_thread, &hold_args);
+    while (g_atomic_int_get(&calls_in_flight) == 0)
+        g_usleep(1000);
+
+    // The only slot is taken: the call waits until cancelled
+    gfal2_context_t waiting = NewContext();
+    gfal2_set_opt_integer(waiting, "ENDPOINT:CANCEL.CERN.CH", "MAX_CONCURRENCY", 1, NULL);
+    pthread_create(&canceller, NULL, cancel_after_delay, waiting);
+    EXPECT_EQ(-1, gfal2_mkdir(waiting, "fake://cancel.cern.ch/dir", 0755, &error));
+    ASSERT_NE((void*)NULL, error);
+    EXPECT_EQ(ECANCELED, error->code);
+    g_clear_error(&error);
+    pthread_join(canceller, NULL);
+
+    g_atomic_int_set(&blocked, 0);
+    pthread_join(holder, NULL);
+    EXPECT_EQ(0, hold_args.ret);
+
+    // The slot is available again
+    EXPECT_EQ(0, gfal2_mkdir(waiting, "fake://cancel.cern.ch/dir", 0755, &error));
+    gfal2_context_free(waiting);
+}
+
+
+// Run nthreads concurrent mkdir to url with context, and return the maximum of calls in flight
+static int concurrent_mkdir(gfal2_context_t context, const char* url, int nthreads)
+{
+    std::vector<pthread_t> threads(nthreads);
+    std::vector<MkdirArgs> args(nthreads);
+
+    max_in_flight = 0;
+    for (int i = 0; i < nthreads; ++i) {
+        args[i].context = context;
+        args[i].url = url;
+        pthread_create(&threads[i], NULL, mkdir_thread, &args[i]);
+    }
+    for (int i = 0; i < nthreads; ++i) {
+        pthread_join(threads[i], NULL);
+        EXPECT_EQ(0, args[i].ret);
+    }
+    return max_in_flight;
+}
+
+
+TEST_F(AdmissionTest, PerContextLimits)
+{
+    gfal2_set_opt_integer(context, "ENDPOINT:PERCONTEXT.CERN.CH", "MAX_CONCURRENCY", 1, NULL);
+    EXPECT_EQ(1, concurrent_mkdir(context, "fake://percontext.cern.ch/dir", 4));
+
+    // Another context of the process asks for more: the first one does not hold it back
+    gfal2_context_t loose = NewContext();
+    gfal2_set_opt_integer(loose, "ENDPOINT:PERCONTEXT.CERN.CH", "MAX_CONCURRENCY", 4, NULL);
+    int max = concurrent_mkdir(loose, "fake://percontext.cern.ch/dir", 8);
+    EXPECT_GT(max, 1);
+    EXPECT_LE(max, 4);
+    gfal2_context_free(loose);
+
+    // And it still gets its own limit
+    EXPECT_EQ(1, concurrent_mkdir(context, "fake://percontext.cern.ch/dir", 4));
+}
+
+
+TEST_F(AdmissionTest, ChangedLimits)
+{
+    gfal2_set_opt_integer(context, "ENDPOINT:CHANGED.CERN.CH", "MAX_CONCURRENCY", 1, NULL);
+    EXPECT_EQ(1, concurrent_mkdir(context, "fake://changed.cern.ch/dir", 4));
+
+    // A limit raised later applies to the next calls
+    gfal2_set_opt_integer(context, "ENDPOINT:CHANGED.CERN.CH", "MAX_CONCURRENCY", 3, NULL);
+    int max = concurrent_mkdir(context, "fake://changed.cern.ch/dir", 8);
+    EXPECT_GT(max, 1);
+    EXPECT_LE(max, 3);
+
+    // As does a limit lowered, or removed
+    gfal2_set_opt_integer(context, "ENDPOINT:CHANGED.CERN.CH", "MAX_CONCURRENCY", 2, NULL);
+    EXPECT_LE(concurrent_mkdir(context, "fake://changed.cern.ch/dir", 8), 2);
+    gfal2_remove_opt(context, "ENDPOINT:CHANGED.CERN.CH", "MAX_CONCURRENCY", NULL);
+    EXPECT_GT(concurrent_mkdir(context, "fake://changed.cern.ch/dir", 8), 3);
+
+    // Same for the rate: 20 calls per second, then unlimited
+    GError* error = NULL;
+    gfal2_set_opt_integer(context, "ENDPOINT:CHANGED.CERN.CH", "RATE", 20, NULL);
+    gfal2_set_opt_integer(context, "ENDPOINT:CHANGED.CERN.CH", "BURST", 1, NULL);
+    gint64 start = g_get_monotonic_time();
+    for (int i = 0; i < 3; ++i)
+        ASSERT_EQ(0, gfal2_mkdir(context, "fake://changed.cern.ch/dir", 0755, &error));
+    EXPECT_GE(g_get_monotonic_time() - start, 90000);
+
+    gfal2_set_opt_integer(context, "ENDPOINT:CHANGED.CERN.CH", "RATE", 0, NULL);
+    start = g_get_monotonic_time();
+    for (int i = 0; i < 3; ++i)
+        ASSERT_EQ(0, gfal2_mkdir(context, "fake://changed.cern.ch/dir", 0755, &error));
+    // Only the time spent by the plugin
+    EXPECT_LT(g_get_monotonic_time() - start, 90000);
+}
+
+
+TEST_F(AdmissionTest, UnlinkListFallback)
+{
+    const char* urls[] = {"fake://fallback.cern.ch/a", "fake://fallback.cern.ch/b", "fake://fallback.cern.ch/c"};
+    GError* errors[3] = {NULL, NULL, NULL};
+
+    gfal2_metrics_set_enabled(TRUE);
+    gfal2_set_opt_integer(context, "ENDPOINT:FALLBACK.CERN.CH", "MAX_CONCURRENCY", 1, NULL);
+
+    // The plugin has no bulk unlink: every file goes through the queue on its own
+    EXPECT_EQ(0, gfal2_unlink_list(context, 3, urls, errors));
+    for (int i = 0; i < 3; ++i)
+        EXPECT_EQ(NULL, errors[i]);
+    EXPECT_EQ(3, queue_wait_count("fallback.cern.ch"));
+}
+
+
+TEST_F(AdmissionTest, EndpointSlots)
+{
+    GError* error = NULL;
+    gfal2_endpoint_slot_t first = NULL, second = NULL;
+
+    // Classes are limited on their own, and not limited at all with a 0 limit
+    EXPECT_EQ(0, gfal2_endpoint_slot_acquire(context, "test", "fake://slots.cern.ch/", "SESSIONS", 0, 0, &first, &error));
+    EXPECT_EQ(NULL, first);
+
+    ASSERT_EQ(0, gfal2_endpoint_slot_acquire(context, "test", "fake://slots.cern.ch/", "SESSIONS", 1, 0, &first, &error));
+    ASSERT_NE((void*)NULL, first);
+    // The same thread does not get a second slot for free
+    EXPECT_EQ(-1, gfal2_endpoint_slot_acquire(context, "test", "fake://slots.cern.ch/", "SESSIONS", 1, 1, &second, &error));
+    ASSERT_NE((void*)NULL, error);
+    EXPECT_EQ(EBUSY, error->code);
+    g_clear_error(&error);
+
+    // The calls to the endpoint are not affected
+    EXPECT_EQ(0, gfal2_mkdir(context, "fake://slots.cern.ch/dir", 0755, &error));
+
+    gfal2_endpoint_slot_release(first);
+    EXPECT_EQ(0, gfal2_endpoint_slot_acquire(context, "test", "slots.cern.ch", "SESSIONS", 1, 0, &second, &error));
+    gfal2_endpoint_slot_release(second);
+}
@@ -0,0 +1,245 @@
+/*
+ * Copyright (c) CERN 2013-2017
+ *
+ * Copyright (c) Members of the EMI Collaboration. 2010-2013
+ *  See  http://www.eu-emi.eu/partners for details on the copyright
+ *  holders.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gfal_api.h>
+#include <gfal_plugins_api.h>
+#include <gtest/gtest.h>
+#include <poll.h>
+#include <string.h>
+#include <common/gfal_fake_plugin.h>
+
+// No plugin handles this protocol, so all operations fail with EPROTONOSUPPORT
+#define ASYNC_TEST_URL "unsupported://host/path"
+
+
+static void async_test_callback(gfal2_async_op_t op, void* user_data)
+{
+    int* counter = (int*)user_data;
+    g_atomic_int_inc(counter);
+}
+
+
+TEST(gfalAsync, testWait)
+{
+    GError* tmp_err = NULL;
+    gfal2_context_t c = gfal2_context_new(&tmp_err);
+    ASSERT_TRUE(c != NULL);
+
+    struct stat st;
+    gfal2_async_op_t op = gfal2_async_stat(c, ASYNC_TEST_URL, &st, NULL, NULL, &tmp_err);
+    ASSERT_TRUE(op != NULL);
+    ASSERT_TRUE(gfal2_async_wait(op, -1));
+    ASSERT_TRUE(gfal2_async_is_done(op));
+
+    ssize_t ret = gfal2_async_get_result(op, &tmp_err);
+    ASSERT_EQ(-1, ret);
+    ASSERT_TRUE(tmp_err != NULL);
+    ASSERT_EQ(EPROTONOSUPPORT, tmp_err->code);
+    g_clear_error(&tmp_err);
+
+    // Releasing the handle before popping it must not leak nor crash
+    gfal2_async_free(op);
+    ASSERT_TRUE(gfal2_async_next_completed(c) == NULL);
+
+    gfal2_context_free(c);
+}
+
+
+TEST(gfalAsync, testCallback)
+{
+    GError* tmp_err = NULL;
+    gfal2_context_t c = gfal2_context_new(&tmp_err);
+    ASSERT_TRUE(c != NULL);
+
+    int counter = 0;
+    const int nops = 32;
+    gfal2_async_op_t ops[nops];
+
+    for (int i = 0; i < nops; ++i) {
+        ops[i] = gfal2_async_unlink(c, ASYNC_TEST_URL, async_test_callback, &counter, &tmp_err);
+        ASSERT_TRUE(ops[i] != NULL);
+        ASSERT_EQ(&counter, gfal2_async_get_user_data(ops[i]));
+    }
+    for (int i = 0; i < nops; ++i) {
+        ASSERT_TRUE(gfal2_async_wait(ops[i], 10));
+        gfal2_async_free(ops[i]);
+    }
+
+    gfal2_context_free(c);
+    ASSERT_EQ(nops, counter);
+}
+
+
+TEST(gfalAsync, testCompletionFd)
+{
+    GError* tmp_err = NULL;
+    gfal2_context_t c = gfal2_context_new(&tmp_err);
+    ASSERT_TRUE(c != NULL);
+
+    int fd = gfal2_async_get_fd(c, &tmp_err);
+    ASSERT_GE(fd, 0);
+
+    gfal2_async_op_t op = gfal2_async_access(c, ASYNC_TEST_URL, F_OK, NULL, NULL, &tmp_err);
+    ASSERT_TRUE(op != NULL);
+
+    struct pollfd pfd;
+    pfd.fd = fd;
+    pfd.events = POLLIN;
+    ASSERT_EQ(1, poll(&pfd, 1, 10000));
+
+    gfal2_async_op_t completed = gfal2_async_next_completed(c);
+    ASSERT_EQ(op, completed);
+    ASSERT_TRUE(gfal2_async_is_done(completed));
+    gfal2_async_free(completed);
+
+    // Nothing else pending, the descriptor must not be readable anymore
+    ASSERT_EQ(0, poll(&pfd, 1, 0));
+    ASSERT_TRUE(gfal2_async_next_completed(c) == NULL);
+
+    gfal2_context_free(c);
+}
+
+
+TEST(gfalAsync, testInvalidArguments)
+{
+    GError* tmp_err = NULL;
+    gfal2_context_t c = gfal2_context_new(&tmp_err);
+    ASSERT_TRUE(c != NULL);
+
+    gfal2_async_op_t op = gfal2_async_stat(c, NULL, NULL, NULL, NULL, &tmp_err);
+    ASSERT_TRUE(op == NULL);
+    ASSERT_TRUE(tmp_err != NULL);
+    ASSERT_EQ(EFAULT, tmp_err->code);
+    g_clear_error(&tmp_err);
+
+    gfal2_context_free(c);
+}
+
+
+// Stat started through stat_asyncG, answered when the test says so
+struct AsyncTestStat {
+    struct stat* buf;
+    gfal_plugin_async_notify_t notify;
+    gpointer notify_data;
+};
+
+static GAsyncQueue* async_test_started = NULL;
+
+
+static int async_test_stat_async(plugin_handle plugin_data, const char* url, struct stat* buf,
+    gfal_plugin_async_notify_t notify, gpointer notify_data, GError** err)
+{
+    if (strstr(url, "blocking")) {
+        gfal2_set_error(err, g_quark_from_static_string("test"), ENOSYS, __func__, "Use statG");
+        return -1;
+    }
+    AsyncTestStat* started = new AsyncTestStat;
+    started->buf = buf;
+    started->notify = notify;
+    started->notify_data = notify_data;
+    g_async_queue_push(async_test_started, started);
+    return 0;
+}
+
+
+static gfal2_context_t async_test_plugin_context()
+{
+    GError* tmp_err = NULL;
+    gfal2_context_t c = gfal2_context_new(&tmp_err);
+    if (c == NULL)
+        return NULL;
+    // A single worker, that must not wait for the stats it started
+    gfal2_set_opt_integer(c, "CORE", "ASYNC_THREADS", 1, NULL);
+
+    gfal_plugin_interface ifce;
+    gfal_fake_plugin_interface(&ifce);
+    ifce.stat_asyncG = async_test_stat_async;
+    gfal2_register_plugin(c, &ifce, &tmp_err);
+    g_clear_error(&tmp_err);
+
+    if (async_test_started == NULL)
+        async_test_started = g_async_queue_new();
+    return c;
+}
+
+
+TEST(gfalAsync, testPluginAsyncStat)
+{
+    GError* tmp_err = NULL;
+    gfal2_context_t c = async_test_plugin_context();
+    ASSERT_TRUE(c != NULL);
+
+    const int nops = 8;
+    struct stat st[nops];
+    gfal2_async_op_t ops[nops];
+    for (int i = 0; i < nops; ++i) {
+        char url[64];
+        snprintf(url, sizeof(url), "fake://host/file%d", i);
+        ops[i] = gfal2_async_stat(c, url, &st[i], NULL, NULL, &tmp_err);
+        ASSERT_TRUE(ops[i] != NULL);
+    }
+
+    AsyncTestStat* started[nops];
+    for (int i = 0; i < nops; ++i) {
+        GTimeVal deadline;
+        g_get_current_time(&deadline);
+        g_time_val_add(&deadline, 10 * G_USEC_PER_SEC);
+        started[i] = (AsyncTestStat*)g_async_queue_timed_pop(async_test_started, &deadline);
+        ASSERT_TRUE(started[i] != NULL);
+    }
+    for (int i = 0; i < nops; ++i) {
+        ASSERT_FALSE(gfal2_async_is_done(ops[i]));
+    }
+
+    // Answered from another thread than the worker
+    for (int i = 0; i < nops; ++i) {
+        memset(started[i]->buf, 0, sizeof(struct stat));
+        started[i]->buf->st_size = 42;
+        started[i]->notify(started[i]->notify_data, 0, NULL);
+        delete started[i];
+    }
+    for (int i = 0; i < nops; ++i) {
+        ASSERT_TRUE(gfal2_async_wait(ops[i], 10));
+        ASSERT_EQ(0, gfal2_async_get_result(ops[i], &tmp_err));
+        ASSERT_EQ(42, st[i].st_size);
+        gfal2_async_free(ops[i]);
+    }
+
+    gfal2_context_free(c);
+}
+
+
+TEST(gfalAsync, testPluginAsyncStatFallback)
+{
+    GError* tmp_err = NULL;
+    gfal2_context_t c = async_test_plugin_context();
+    ASSERT_TRUE(c != NULL);
+    gfal_fake_plugin_reset_calls();
+
+    struct stat st;
+    gfal2_async_op_t op = gfal2_async_stat(c, "fake://host/blocking", &st, NULL, NULL, &tmp_err);
+    ASSERT_TRUE(op != NULL);
+    ASSERT_TRUE(gfal2_async_wait(op, 10));
+    ASSERT_EQ(0, gfal2_async_get_result(op, &tmp_err));
+    ASSERT_EQ(1, g_atomic_int_get(&gfal_fake_plugin_calls.stat));
+    gfal2_async_free(op);
+
+    gfal2_context_free(c);
+}
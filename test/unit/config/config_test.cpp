@@ -22,6 +22,9 @@
 #include <gtest/gtest.h>
 #include <common/gfal_gtest_asserts.h>
 #include <utils/exceptions/gerror_to_cpp.h>
+#include <atomic>
+#include <thread>
+#include <vector>
 
 
 class ConfigFixture: public testing::Test {
@@ -119,4 +122,122 @@ TEST_F(ConfigFixture, KeyList)
     EXPECT_EQ(NULL, keys[2]);
 
     g_strfreev(keys);
-}
\ No newline at end of file
+}
+
+TEST_F(ConfigFixture, Clone)
+{
+    GError *error = NULL;
+    int ret = 0;
+
+    ret = gfal2_set_opt_string(context, "GROUP1", "KEY1", "base", &error);
+    EXPECT_PRED_FORMAT2(AssertGfalSuccess, ret, error);
+    ret = gfal2_add_client_info(context, "TEST", "VALUE", &error);
+    EXPECT_PRED_FORMAT2(AssertGfalSuccess, ret, error);
+
+    gfal2_context_t clone = gfal2_context_clone(context, &error);
+    ASSERT_NE((void*)NULL, clone);
+
+    gchar *value = gfal2_get_opt_string(clone, "GROUP1", "KEY1", &error);
+    EXPECT_STREQ("base", value);
+    g_free(value);
+
+    const char *info;
+    ret = gfal2_get_client_info_value(clone, "TEST", &info, &error);
+    EXPECT_PRED_FORMAT2(AssertGfalSuccess, ret, error);
+    EXPECT_STREQ("VALUE", info);
+
+    // Changes on either side are not seen by the other
+    ret = gfal2_set_opt_string(clone, "GROUP1", "KEY1", "clone", &error);
+    EXPECT_PRED_FORMAT2(AssertGfalSuccess, ret, error);
+    ret = gfal2_set_opt_integer(context, "GROUP1", "KEY2", 42, &error);
+    EXPECT_PRED_FORMAT2(AssertGfalSuccess, ret, error);
+
+    value = gfal2_get_opt_string(context, "GROUP1", "KEY1", &error);
+    EXPECT_STREQ("base", value);
+    g_free(value);
+    value = gfal2_get_opt_string(clone, "GROUP1", "KEY1", &error);
+    EXPECT_STREQ("clone", value);
+    g_free(value);
+    EXPECT_EQ(0, gfal2_get_opt_integer_with_default(clone, "GROUP1", "KEY2", 0));
+
+    // Credentials are copied, not shared
+    gfal2_cred_t *cred = gfal2_cred_new(GFAL_CRED_BEARER, "token");
+    ret = gfal2_cred_set(clone, "https://host", cred, &error);
+    EXPECT_PRED_FORMAT2(AssertGfalSuccess, ret, error);
+    gfal2_cred_free(cred);
+    char *token = gfal2_cred_get(context, GFAL_CRED_BEARER, "https://host/path", NULL, &error);
+    EXPECT_STRNE("token", token);
+    g_free(token);
+    g_clear_error(&error);
+
+    // The clone can outlive its base
+    gfal2_context_t clone2 = gfal2_context_clone(clone, &error);
+    ASSERT_NE((void*)NULL, clone2);
+    gfal2_context_free(clone);
+    value = gfal2_get_opt_string(clone2, "GROUP1", "KEY1", &error);
+    EXPECT_STREQ("clone", value);
+    g_free(value);
+    gfal2_context_free(clone2);
+}
+
+
+TEST_F(ConfigFixture, ConcurrentClones)
+{
+    GError *error = NULL;
+    int ret = gfal2_set_opt_integer(context, "GROUP1", "KEY1", -1, &error);
+    EXPECT_PRED_FORMAT2(AssertGfalSuccess, ret, error);
+
+    // Each thread clones the base, then changes its clone and clones it again, while others do the same
+    std::vector<std::thread> threads;
+    std::atomic<int> failures(0);
+    for (int t = 0; t < 8; ++t) {
+        threads.emplace_back([this, t, &failures]() {
+            for (int i = 0; i < 20; ++i) {
+                gfal2_context_t clone = gfal2_context_clone(context, NULL);
+                gfal2_context_t clone2 = gfal2_context_clone(clone, NULL);
+                gfal2_set_opt_integer(clone, "GROUP1", "KEY1", t * 100 + i, NULL);
+                if (gfal2_get_opt_integer_with_default(clone, "GROUP1", "KEY1", 0) != t * 100 + i ||
+                    gfal2_get_opt_integer_with_default(clone2, "GROUP1", "KEY1", 0) != -1) {
+                    ++failures;
+                }
+                gfal2_context_free(clone);
+                gfal2_context_free(clone2);
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    EXPECT_EQ(0, failures);
+    EXPECT_EQ(-1, gfal2_get_opt_integer_with_default(context, "GROUP1", "KEY1", 0));
+}
+
+
+TEST_F(ConfigFixture, CloneWhileChanging)
+{
+    GError *error = NULL;
+    int ret = gfal2_set_opt_integer(context, "GROUP1", "KEY1", -1, &error);
+    EXPECT_PRED_FORMAT2(AssertGfalSuccess, ret, error);
+
+    // A context is cloned while it moves from the shared configuration to its private copy
+    for (int i = 0; i < 200; ++i) {
+        gfal2_context_t shared = gfal2_context_clone(context, NULL);
+        gfal2_context_t clone = NULL;
+        std::thread cloner([shared, &clone]() {
+            clone = gfal2_context_clone(shared, NULL);
+        });
+        gfal2_set_opt_integer(shared, "GROUP1", "KEY1", i, NULL);
+        cloner.join();
+
+        ASSERT_NE((void*)NULL, clone);
+        int value = gfal2_get_opt_integer_with_default(clone, "GROUP1", "KEY1", 0);
+        EXPECT_TRUE(value == -1 || value == i) << value;
+        EXPECT_EQ(i, gfal2_get_opt_integer_with_default(shared, "GROUP1", "KEY1", 0));
+
+        // Each of them releases the configuration it really holds
+        gfal2_context_free(shared);
+        gfal2_context_free(clone);
+    }
+    EXPECT_EQ(-1, gfal2_get_opt_integer_with_default(context, "GROUP1", "KEY1", 0));
+}
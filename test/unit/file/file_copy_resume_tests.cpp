@@ -0,0 +1,221 @@
+/*
+ * Copyright (c) CERN 2017
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gfal_api.h>
+#include <gfal_plugins_api.h>
+#include <gtest/gtest.h>
+#include <common/gfal_gtest_asserts.h>
+#include <transfer/gfal_transfer.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+// The plugin is a module, so it is built into the test and registered by hand
+extern "C" {
+gfal_plugin_interface gfal_plugin_init(gfal2_context_t handle, GError **err);
+}
+
+
+static void collect_resume_events(const gfalt_event_t e, gpointer user_data)
+{
+    if (e->stage == GFAL_EVENT_RESUME) {
+        static_cast<std::vector<std::string>*>(user_data)->push_back(e->description);
+    }
+}
+
+
+class FileCopyResumeTest: public testing::Test {
+public:
+    gfal2_context_t context;
+    gfalt_params_t params;
+    char dir[64];
+    std::string src_path, dst_path;
+    std::vector<char> content;
+    std::vector<std::string> resumed;
+
+    void SetUp() {
+        GError* error = NULL;
+        context = gfal2_context_new(&error);
+        ASSERT_PRED_FORMAT2(AssertGfalSuccess, context ? 0 : -1, error);
+        params = gfalt_params_handle_new(NULL);
+        gfalt_set_replace_existing_file(params, TRUE, NULL);
+        gfalt_set_offset_from_source(params, GFALT_OFFSET_FROM_DESTINATION, NULL);
+        gfalt_add_event_callback(params, collect_resume_events, &resumed, NULL, NULL);
+
+        // Not in /tmp, since tmpfs does not support O_DIRECT
+        g_strlcpy(dir, "copy_resume_XXXXXX", sizeof(dir));
+        ASSERT_TRUE(mkdtemp(dir) != NULL);
+        src_path = std::string(dir) + "/src";
+        dst_path = std::string(dir) + "/dst";
+
+        content.resize(100000);
+        for (size_t i = 0; i < content.size(); ++i)
+            content[i] = static_cast<char>((i * 131) ^ (i >> 9));
+        Write(src_path, content);
+    }
+
+    void TearDown() {
+        unlink(src_path.c_str());
+        unlink(dst_path.c_str());
+        rmdir(dir);
+        gfalt_params_handle_delete(params, NULL);
+        gfal2_context_free(context);
+    }
+
+    void RegisterPlugin(bool io_uring) {
+        GError* error = NULL;
+        gfal2_set_opt_boolean(context, "FILE PLUGIN", "IO_URING", io_uring, NULL);
+        gfal_plugin_interface plugin = gfal_plugin_init(context, &error);
+        ASSERT_PRED_FORMAT2(AssertGfalSuccess, 0, error);
+        ASSERT_EQ(0, gfal2_register_plugin(context, &plugin, &error));
+    }
+
+    void Write(const std::string& path, const std::vector<char>& data) {
+        std::ofstream out(path.c_str(), std::ios::binary | std::ios::trunc);
+        out.write(data.data(), data.size());
+    }
+
+    std::vector<char> Read(const std::string& path) {
+        std::ifstream in(path.c_str(), std::ios::binary);
+        return std::vector<char>(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+
+    // Leave the first "size" bytes of the source as destination, with "corrupt" flipped bytes
+    void WritePartial(size_t size, size_t corrupt = 0) {
+        std::vector<char> partial(content.begin(), content.begin() + size);
+        for (size_t i = 0; i < corrupt; ++i)
+            partial[i] = ~partial[i];
+        Write(dst_path, partial);
+    }
+
+    int Copy(GError** error) {
+        return gfalt_copy_file(context, params, ("file://" + src_path).c_str(),
+                ("file://" + dst_path).c_str(), error);
+    }
+};
+
+
+TEST_F(FileCopyResumeTest, ResumeFromDestination)
+{
+    RegisterPlugin(false);
+    WritePartial(40000);
+
+    GError* error = NULL;
+    int ret = Copy(&error);
+    ASSERT_PRED_FORMAT2(AssertGfalSuccess, ret, error);
+
+    ASSERT_EQ(1u, resumed.size());
+    EXPECT_EQ("40000", resumed[0]);
+    EXPECT_TRUE(content == Read(dst_path));
+}
+
+
+TEST_F(FileCopyResumeTest, ResumeThroughPluginCopy)
+{
+    // The plugin copy starts from the current offset of both files
+    RegisterPlugin(true);
+    WritePartial(12345);
+
+    GError* error = NULL;
+    int ret = Copy(&error);
+    ASSERT_PRED_FORMAT2(AssertGfalSuccess, ret, error);
+
+    ASSERT_EQ(1u, resumed.size());
+    EXPECT_EQ("12345", resumed[0]);
+    EXPECT_TRUE(content == Read(dst_path));
+}
+
+
+TEST_F(FileCopyResumeTest, ExplicitOffset)
+{
+    RegisterPlugin(false);
+    WritePartial(40000);
+
+    // Not the size of the destination, start over
+    gfalt_set_offset_from_source(params, 1000, NULL);
+    GError* error = NULL;
+    int ret = Copy(&error);
+    ASSERT_PRED_FORMAT2(AssertGfalSuccess, ret, error);
+    EXPECT_TRUE(resumed.empty());
+    EXPECT_TRUE(content == Read(dst_path));
+
+    WritePartial(40000);
+    gfalt_set_offset_from_source(params, 40000, NULL);
+    ret = Copy(&error);
+    ASSERT_PRED_FORMAT2(AssertGfalSuccess, ret, error);
+    ASSERT_EQ(1u, resumed.size());
+    EXPECT_EQ("40000", resumed[0]);
+    EXPECT_TRUE(content == Read(dst_path));
+}
+
+
+TEST_F(FileCopyResumeTest, MismatchRestarts)
+{
+    RegisterPlugin(false);
+    WritePartial(40000, 10);
+
+    GError* error = NULL;
+    int ret = Copy(&error);
+    ASSERT_PRED_FORMAT2(AssertGfalSuccess, ret, error);
+    EXPECT_TRUE(resumed.empty());
+    EXPECT_TRUE(content == Read(dst_path));
+}
+
+
+TEST_F(FileCopyResumeTest, NotRequested)
+{
+    RegisterPlugin(false);
+    WritePartial(40000);
+
+    gfalt_set_offset_from_source(params, 0, NULL);
+    GError* error = NULL;
+    int ret = Copy(&error);
+    ASSERT_PRED_FORMAT2(AssertGfalSuccess, ret, error);
+    EXPECT_TRUE(resumed.empty());
+    EXPECT_TRUE(content == Read(dst_path));
+}
+
+
+TEST_F(FileCopyResumeTest, DirectIoAlignment)
+{
+    int fd = open(src_path.c_str(), O_RDONLY | O_DIRECT);
+    if (fd < 0) {
+        std::cout << "O_DIRECT not supported by the filesystem, skipped" << std::endl;
+        return;
+    }
+    close(fd);
+
+    RegisterPlugin(false);
+    gfal2_set_opt_boolean(context, "CORE", "COPY_DIRECT_IO", TRUE, NULL);
+    gfal2_set_opt_integer(context, "CORE", "COPY_BUFFER_ALIGNMENT", 4096, NULL);
+    gfal2_set_opt_integer(context, "CORE", "COPY_BUFFERSIZE", 4096, NULL);
+    // Direct I/O reads and writes whole blocks, so the source is a multiple of them
+    content.resize(40960);
+    Write(src_path, content);
+    WritePartial(10000);
+
+    // Resumed from the start of the block holding the end of the partial destination
+    GError* error = NULL;
+    int ret = Copy(&error);
+    ASSERT_PRED_FORMAT2(AssertGfalSuccess, ret, error);
+    ASSERT_EQ(1u, resumed.size());
+    EXPECT_EQ("8192", resumed[0]);
+    EXPECT_TRUE(content == Read(dst_path));
+}
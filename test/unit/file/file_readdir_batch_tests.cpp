@@ -0,0 +1,182 @@
+/*
+ * Copyright (c) CERN 2017
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gfal_api.h>
+#include <gfal_plugins_api.h>
+#include <gtest/gtest.h>
+#include <common/gfal_gtest_asserts.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <map>
+#include <string>
+#include <vector>
+
+// The plugin is a module, so its entry points are built into the test
+extern "C" {
+gfal_file_handle gfal_plugin_file_opendir(plugin_handle plugin_data, const char *path, GError **err);
+int gfal_plugin_file_closedir(plugin_handle plugin_data, gfal_file_handle fh, GError** err);
+ssize_t gfal_plugin_file_readdir_batch(plugin_handle plugin_data, gfal_file_handle fh,
+    gfal2_dir_entry_t *entries, size_t nentries, GError **err);
+}
+
+
+class FileReaddirBatchTest: public testing::Test {
+public:
+    char dir[64];
+    std::string url;
+    std::map<std::string, off_t> files;
+
+    void SetUp() {
+        g_strlcpy(dir, "/tmp/readdir_batch_XXXXXX", sizeof(dir));
+        ASSERT_TRUE(mkdtemp(dir) != NULL);
+        url = std::string("file://") + dir;
+
+        for (int i = 0; i < 10; ++i) {
+            std::string name = "file" + std::to_string(i);
+            AddFile(name, i * 100);
+        }
+        ASSERT_EQ(0, mkdir((std::string(dir) + "/subdir").c_str(), 0755));
+    }
+
+    void TearDown() {
+        for (auto i = files.begin(); i != files.end(); ++i) {
+            unlink((std::string(dir) + "/" + i->first).c_str());
+        }
+        rmdir((std::string(dir) + "/subdir").c_str());
+        rmdir(dir);
+    }
+
+    void AddFile(const std::string& name, off_t size) {
+        std::string path = std::string(dir) + "/" + name;
+        int fd = open(path.c_str(), O_CREAT | O_WRONLY | O_TRUNC, 0644);
+        ASSERT_GE(fd, 0);
+        ASSERT_EQ(0, ftruncate(fd, size));
+        close(fd);
+        files[name] = size;
+    }
+
+    // List the whole directory with batches of nentries
+    std::map<std::string, struct stat> List(size_t nentries, size_t* calls) {
+        std::map<std::string, struct stat> listed;
+        std::vector<gfal2_dir_entry_t> entries(nentries);
+        GError* error = NULL;
+
+        gfal_file_handle fh = gfal_plugin_file_opendir(NULL, url.c_str(), &error);
+        EXPECT_PRED_FORMAT2(AssertGfalSuccess, fh ? 0 : -1, error);
+        if (!fh)
+            return listed;
+
+        ssize_t count;
+        *calls = 0;
+        while ((count = gfal_plugin_file_readdir_batch(NULL, fh, entries.data(), nentries, &error)) > 0) {
+            EXPECT_LE((size_t)count, nentries);
+            for (ssize_t i = 0; i < count; ++i) {
+                listed[entries[i].dirent.d_name] = entries[i].st;
+            }
+            ++(*calls);
+        }
+        EXPECT_PRED_FORMAT2(AssertGfalSuccess, count, error);
+        g_clear_error(&error);
+
+        gfal_plugin_file_closedir(NULL, fh, NULL);
+        return listed;
+    }
+};
+
+
+TEST_F(FileReaddirBatchTest, ListWithStat)
+{
+    size_t calls = 0;
+    std::map<std::string, struct stat> listed = List(4, &calls);
+
+    // 10 files, subdir, . and ..
+    ASSERT_EQ(13u, listed.size());
+    ASSERT_EQ(4u, calls);
+
+    for (auto i = files.begin(); i != files.end(); ++i) {
+        ASSERT_TRUE(listed.count(i->first)) << i->first;
+        ASSERT_TRUE(S_ISREG(listed[i->first].st_mode));
+        ASSERT_EQ(i->second, listed[i->first].st_size);
+    }
+    ASSERT_TRUE(S_ISDIR(listed["subdir"].st_mode));
+    ASSERT_TRUE(S_ISDIR(listed["."].st_mode));
+}
+
+
+TEST_F(FileReaddirBatchTest, BatchLargerThanListing)
+{
+    size_t calls = 0;
+    std::map<std::string, struct stat> listed = List(100, &calls);
+    ASSERT_EQ(13u, listed.size());
+    ASSERT_EQ(1u, calls);
+}
+
+
+TEST_F(FileReaddirBatchTest, SingleEntryBatches)
+{
+    size_t calls = 0;
+    std::map<std::string, struct stat> listed = List(1, &calls);
+    ASSERT_EQ(13u, listed.size());
+    ASSERT_EQ(13u, calls);
+}
+
+
+TEST_F(FileReaddirBatchTest, RemovedWhileListing)
+{
+    std::vector<gfal2_dir_entry_t> entries(20);
+    GError* error = NULL;
+
+    gfal_file_handle fh = gfal_plugin_file_opendir(NULL, url.c_str(), &error);
+    ASSERT_PRED_FORMAT2(AssertGfalSuccess, fh ? 0 : -1, error);
+
+    // Entries removed after the directory is read, before they are stat'ed, are skipped
+    ssize_t count = gfal_plugin_file_readdir_batch(NULL, fh, entries.data(), 1, &error);
+    ASSERT_EQ(1, count);
+    for (int i = 0; i < 10; ++i) {
+        std::string name = "file" + std::to_string(i);
+        if (name != entries[0].dirent.d_name) {
+            unlink((std::string(dir) + "/" + name).c_str());
+        }
+    }
+
+    size_t total = 1;
+    while ((count = gfal_plugin_file_readdir_batch(NULL, fh, entries.data(), entries.size(), &error)) > 0) {
+        for (ssize_t i = 0; i < count; ++i) {
+            struct stat st;
+            ASSERT_EQ(0, stat((std::string(dir) + "/" + entries[i].dirent.d_name).c_str(), &st))
+                << entries[i].dirent.d_name;
+        }
+        total += count;
+    }
+    ASSERT_PRED_FORMAT2(AssertGfalSuccess, count, error);
+    ASSERT_LE(total, 13u);
+
+    gfal_plugin_file_closedir(NULL, fh, NULL);
+}
+
+
+TEST_F(FileReaddirBatchTest, EmptyDirectory)
+{
+    size_t calls = 0;
+    std::string saved_url = url;
+    url = std::string("file://") + dir + "/subdir";
+    std::map<std::string, struct stat> listed = List(8, &calls);
+    url = saved_url;
+
+    ASSERT_EQ(2u, listed.size());
+    ASSERT_TRUE(listed.count("."));
+    ASSERT_TRUE(listed.count(".."));
+}
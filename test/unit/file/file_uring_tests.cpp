@@ -0,0 +1,246 @@
+/*
+ * Copyright (c) CERN 2013-2017
+ *
+ * Copyright (c) Members of the EMI Collaboration. 2010-2013
+ *  See  http://www.eu-emi.eu/partners for details on the copyright
+ *  holders.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gfal_api.h>
+#include <gfal_plugins_api.h>
+#include <gtest/gtest.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <vector>
+
+extern "C" {
+#include <plugins/file/gfal_file_plugin_uring.h>
+
+GQuark gfal2_get_plugin_file_quark()
+{
+    return g_quark_from_static_string("FileUringTest");
+}
+}
+
+
+static int count_progress(size_t bytes, void* user_data, GError** err)
+{
+    *static_cast<size_t*>(user_data) += bytes;
+    return 0;
+}
+
+
+class FileUringTest: public testing::Test {
+public:
+    gfal2_context_t context;
+    char dir[64];
+    std::string src_path, dst_path;
+
+    void SetUp() {
+        context = gfal2_context_new(NULL);
+        // Not in /tmp, since tmpfs does not support O_DIRECT
+        g_strlcpy(dir, "uring_test_XXXXXX", sizeof(dir));
+        ASSERT_TRUE(mkdtemp(dir) != NULL);
+        src_path = std::string(dir) + "/src";
+        dst_path = std::string(dir) + "/dst";
+        // Several chunks and queue entries for small files
+        gfal2_set_opt_integer(context, "FILE PLUGIN", "IO_URING_CHUNK_SIZE", 4096, NULL);
+        gfal2_set_opt_integer(context, "FILE PLUGIN", "IO_URING_QUEUE_DEPTH", 4, NULL);
+    }
+
+    void TearDown() {
+        unlink(src_path.c_str());
+        unlink(dst_path.c_str());
+        rmdir(dir);
+        gfal2_context_free(context);
+    }
+
+    std::vector<char> WriteSource(size_t size) {
+        std::vector<char> content(size);
+        for (size_t i = 0; i < size; ++i)
+            content[i] = static_cast<char>((i * 131) ^ (i >> 9));
+        int fd = open(src_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        EXPECT_EQ((ssize_t)size, write(fd, content.data(), size));
+        close(fd);
+        return content;
+    }
+
+    std::vector<char> ReadDestination() {
+        std::vector<char> content;
+        char buffer[4096];
+        ssize_t n;
+        int fd = open(dst_path.c_str(), O_RDONLY);
+        while ((n = read(fd, buffer, sizeof(buffer))) > 0)
+            content.insert(content.end(), buffer, buffer + n);
+        close(fd);
+        return content;
+    }
+
+    // Copy src into dst from offset, with the given extra open flags
+    // Returns FALSE if the filesystem refuses the flags
+    bool Copy(off_t offset, int flags, size_t expected) {
+        GError* error = NULL;
+        size_t progress = 0;
+
+        int src_fd = open(src_path.c_str(), O_RDONLY | flags);
+        int dst_fd = open(dst_path.c_str(), O_WRONLY | O_CREAT | flags, 0644);
+        if (src_fd < 0 || dst_fd < 0) {
+            EXPECT_EQ(EINVAL, errno);
+            if (src_fd >= 0) close(src_fd);
+            if (dst_fd >= 0) close(dst_fd);
+            return false;
+        }
+        EXPECT_EQ(offset, lseek(src_fd, offset, SEEK_SET));
+        EXPECT_EQ(offset, lseek(dst_fd, offset, SEEK_SET));
+
+        gfal_file_handle src = gfal_file_handle_new2("test", GINT_TO_POINTER(src_fd), NULL, src_path.c_str());
+        gfal_file_handle dst = gfal_file_handle_new2("test", GINT_TO_POINTER(dst_fd), NULL, dst_path.c_str());
+
+        ssize_t copied = gfal_plugin_file_stream_copy(context, src, dst, 8192, count_progress, &progress, &error);
+        EXPECT_EQ(NULL, error) << (error ? error->message : "");
+        EXPECT_EQ((ssize_t)expected, copied);
+        EXPECT_EQ(expected, progress);
+        // The descriptors are left as a read/write loop would
+        EXPECT_EQ(offset + (off_t)expected, lseek(src_fd, 0, SEEK_CUR));
+        EXPECT_EQ(offset + (off_t)expected, lseek(dst_fd, 0, SEEK_CUR));
+
+        g_clear_error(&error);
+        gfal_file_handle_delete(src);
+        gfal_file_handle_delete(dst);
+        close(src_fd);
+        close(dst_fd);
+        return true;
+    }
+};
+
+
+#define SKIP_WITHOUT_URING() \
+    if (!gfal_plugin_file_uring_available()) { \
+        std::cout << "io_uring not available, skipped" << std::endl; \
+        return; \
+    }
+
+
+TEST_F(FileUringTest, Unavailable)
+{
+    if (gfal_plugin_file_uring_available())
+        return;
+    GError* error = NULL;
+    size_t progress = 0;
+    WriteSource(100);
+    int src_fd = open(src_path.c_str(), O_RDONLY);
+    int dst_fd = open(dst_path.c_str(), O_WRONLY | O_CREAT, 0644);
+    gfal_file_handle src = gfal_file_handle_new2("test", GINT_TO_POINTER(src_fd), NULL, src_path.c_str());
+    gfal_file_handle dst = gfal_file_handle_new2("test", GINT_TO_POINTER(dst_fd), NULL, dst_path.c_str());
+
+    // The core falls back to the read/write loop on ENOSYS
+    EXPECT_EQ(-1, gfal_plugin_file_stream_copy(context, src, dst, 8192, count_progress, &progress, &error));
+    ASSERT_TRUE(error != NULL);
+    EXPECT_EQ(ENOSYS, error->code);
+    g_clear_error(&error);
+
+    gfal_file_handle_delete(src);
+    gfal_file_handle_delete(dst);
+    close(src_fd);
+    close(dst_fd);
+}
+
+
+TEST_F(FileUringTest, Aligned)
+{
+    SKIP_WITHOUT_URING();
+    std::vector<char> content = WriteSource(16 * 4096);
+    ASSERT_TRUE(Copy(0, 0, content.size()));
+    EXPECT_TRUE(content == ReadDestination());
+}
+
+
+TEST_F(FileUringTest, UnalignedTail)
+{
+    SKIP_WITHOUT_URING();
+    std::vector<char> content = WriteSource(5 * 4096 + 123);
+    ASSERT_TRUE(Copy(0, 0, content.size()));
+    EXPECT_TRUE(content == ReadDestination());
+}
+
+
+TEST_F(FileUringTest, Empty)
+{
+    SKIP_WITHOUT_URING();
+    WriteSource(0);
+    ASSERT_TRUE(Copy(0, 0, 0));
+    EXPECT_EQ(0u, ReadDestination().size());
+}
+
+
+TEST_F(FileUringTest, DirectIO)
+{
+    SKIP_WITHOUT_URING();
+    std::vector<char> content = WriteSource(7 * 4096 + 1000);
+    if (!Copy(0, O_DIRECT, content.size())) {
+        std::cout << "O_DIRECT not supported by the filesystem, skipped" << std::endl;
+        return;
+    }
+    // The unaligned tail is written without O_DIRECT
+    EXPECT_TRUE(content == ReadDestination());
+}
+
+
+TEST_F(FileUringTest, ResumeOffset)
+{
+    SKIP_WITHOUT_URING();
+    const off_t offset = 2 * 4096 + 10;
+    std::vector<char> content = WriteSource(6 * 4096 + 77);
+
+    // The destination already holds the first part of the file
+    int fd = open(dst_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    ASSERT_EQ(offset, write(fd, content.data(), offset));
+    close(fd);
+
+    ASSERT_TRUE(Copy(offset, 0, content.size() - offset));
+    EXPECT_TRUE(content == ReadDestination());
+}
+
+
+TEST_F(FileUringTest, DirectIOUnalignedOffset)
+{
+    SKIP_WITHOUT_URING();
+    GError* error = NULL;
+    size_t progress = 0;
+    WriteSource(4 * 4096);
+
+    int src_fd = open(src_path.c_str(), O_RDONLY | O_DIRECT);
+    int dst_fd = open(dst_path.c_str(), O_WRONLY | O_CREAT | O_DIRECT, 0644);
+    if (src_fd < 0 || dst_fd < 0) {
+        if (src_fd >= 0) close(src_fd);
+        if (dst_fd >= 0) close(dst_fd);
+        return;
+    }
+    lseek(src_fd, 100, SEEK_SET);
+    lseek(dst_fd, 100, SEEK_SET);
+    gfal_file_handle src = gfal_file_handle_new2("test", GINT_TO_POINTER(src_fd), NULL, src_path.c_str());
+    gfal_file_handle dst = gfal_file_handle_new2("test", GINT_TO_POINTER(dst_fd), NULL, dst_path.c_str());
+
+    // Left to the read/write loop of the core
+    EXPECT_EQ(-1, gfal_plugin_file_stream_copy(context, src, dst, 8192, count_progress, &progress, &error));
+    ASSERT_TRUE(error != NULL);
+    EXPECT_EQ(ENOSYS, error->code);
+    g_clear_error(&error);
+
+    gfal_file_handle_delete(src);
+    gfal_file_handle_delete(dst);
+    close(src_fd);
+    close(dst_fd);
+}
@@ -18,10 +18,13 @@
  * limitations under the License.
  */
 
+#include <unistd.h>
+
 #include <gfal_api.h>
 #include <gfal_plugins_api.h>
 #include <utils/uri/gfal2_uri.h>
 #include <gtest/gtest.h>
+#include <string>
 
 
 TEST(gfalGlobal, testVerbose)
@@ -32,6 +35,92 @@ TEST(gfalGlobal, testVerbose)
 }
 
 
+static void test_log_handler(const gchar *log_domain, GLogLevelFlags log_level,
+    const gchar *message, gpointer user_data)
+{
+    GPtrArray *messages = (GPtrArray*)user_data;
+    g_ptr_array_add(messages, g_strdup(message));
+}
+
+
+TEST(gfalGlobal, testStructuredLog)
+{
+    GPtrArray *messages = g_ptr_array_new_with_free_func(g_free);
+    guint handler = gfal2_log_set_handler(test_log_handler, messages);
+
+    gfal2_log_set_level(G_LOG_LEVEL_WARNING);
+    gfal2_log_set_subsystem_level("testsubsystem", G_LOG_LEVEL_DEBUG);
+    ASSERT_TRUE(gfal2_log_is_enabled(G_LOG_LEVEL_DEBUG, "testsubsystem"));
+    ASSERT_FALSE(gfal2_log_is_enabled(G_LOG_LEVEL_DEBUG, NULL));
+
+    const gfal2_log_field_t fields[] = {{"op", "stat"}, {"url", "gsiftp://host/a b"}};
+    gfal2_log_structured(G_LOG_LEVEL_DEBUG, "testsubsystem", fields, 2, "done in %d ms", 5);
+    gfal2_log_structured(G_LOG_LEVEL_DEBUG, "othersubsystem", fields, 2, "filtered");
+
+    ASSERT_EQ(1u, messages->len);
+    ASSERT_STREQ("done in 5 ms op=stat url=\"gsiftp://host/a b\"", (char*)g_ptr_array_index(messages, 0));
+
+    g_log_remove_handler("GFAL2", handler);
+    g_ptr_array_free(messages, TRUE);
+}
+
+
+TEST(gfalGlobal, testAsyncLog)
+{
+    GPtrArray *messages = g_ptr_array_new_with_free_func(g_free);
+    guint handler = gfal2_log_set_handler(test_log_handler, messages);
+
+    gfal2_log_set_level(G_LOG_LEVEL_DEBUG);
+    gfal2_log_set_async(TRUE);
+    for (int i = 0; i < 10; ++i) {
+        gfal2_log(G_LOG_LEVEL_DEBUG, "async message %d", i);
+    }
+    gfal2_log_flush();
+    gfal2_log_set_async(FALSE);
+    gfal2_log_set_level(G_LOG_LEVEL_WARNING);
+
+    ASSERT_EQ(10u, messages->len);
+    for (int i = 0; i < 10; ++i) {
+        char expected[64];
+        snprintf(expected, sizeof(expected), "async message %d", i);
+        ASSERT_STREQ(expected, (char*)g_ptr_array_index(messages, i));
+    }
+
+    g_log_remove_handler("GFAL2", handler);
+    g_ptr_array_free(messages, TRUE);
+}
+
+
+TEST(gfalGlobal, testAsyncStructuredLog)
+{
+    GPtrArray *messages = g_ptr_array_new_with_free_func(g_free);
+    guint handler = gfal2_log_set_handler(test_log_handler, messages);
+
+    gfal2_log_set_subsystem_level("asyncsubsystem", G_LOG_LEVEL_DEBUG);
+    gfal2_log_set_async(TRUE);
+
+    const gfal2_log_field_t fields[] = {{"op", "stat"}, {"empty", NULL}, {"quote", "a\"b"}};
+    gfal2_log_structured(G_LOG_LEVEL_DEBUG, "asyncsubsystem", fields, 3, "done in %d ms", 5);
+
+    // Truncated, without splitting the record
+    std::string long_value(2048, 'x');
+    const gfal2_log_field_t long_field[] = {{"long", long_value.c_str()}};
+    gfal2_log_structured(G_LOG_LEVEL_DEBUG, "asyncsubsystem", long_field, 1, "long");
+
+    gfal2_log_flush();
+    gfal2_log_set_async(FALSE);
+
+    ASSERT_EQ(2u, messages->len);
+    ASSERT_STREQ("done in 5 ms op=stat empty=\"\" quote=\"a\\\"b\"", (char*)g_ptr_array_index(messages, 0));
+    std::string truncated((char*)g_ptr_array_index(messages, 1));
+    ASSERT_EQ(1023u, truncated.size());
+    ASSERT_EQ(0u, truncated.find("long long="));
+
+    g_log_remove_handler("GFAL2", handler);
+    g_ptr_array_free(messages, TRUE);
+}
+
+
 TEST(gfalGlobal, testLoad)
 {
     GError *tmp_err = NULL;
@@ -100,3 +189,89 @@ TEST(gfalGlobal, registerPlugin)
 
     gfal2_context_free(c);
 }
+
+
+static int count_messages(GPtrArray *messages, const char *needle)
+{
+    int count = 0;
+    for (guint i = 0; i < messages->len; ++i) {
+        count += (strstr((char*)g_ptr_array_index(messages, i), needle) != NULL);
+    }
+    return count;
+}
+
+
+// A plugin with a manifest must not be touched until one of its schemes is used
+// The library is not a valid one, so each attempt to load it is logged
+TEST(gfalGlobal, lazyPlugin)
+{
+    char plugin_dir[] = "/tmp/gfal2_lazy_plugin_XXXXXX";
+    ASSERT_NE((char*)NULL, g_mkdtemp(plugin_dir));
+
+    gchar *library = g_build_filename(plugin_dir, "libgfal_plugin_lazy.so", NULL);
+    gchar *manifest = g_build_filename(plugin_dir, "libgfal_plugin_lazy.manifest", NULL);
+    ASSERT_TRUE(g_file_set_contents(library, "not a library", -1, NULL));
+    ASSERT_TRUE(g_file_set_contents(manifest, "[PLUGIN]\nNAME=lazy\nSCHEMES=lazy;lazys\n", -1, NULL));
+
+    gchar *previous_dir = g_strdup(g_getenv("GFAL_PLUGIN_DIR"));
+    g_setenv("GFAL_PLUGIN_DIR", plugin_dir, TRUE);
+
+    GPtrArray *messages = g_ptr_array_new_with_free_func(g_free);
+    guint handler = gfal2_log_set_handler(test_log_handler, messages);
+    gfal2_log_set_level(G_LOG_LEVEL_WARNING);
+
+    GError *tmp_err = NULL;
+    gfal2_context_t c = gfal2_context_new(&tmp_err);
+    ASSERT_NE((void *) NULL, c);
+    ASSERT_EQ(0, count_messages(messages, "libgfal_plugin_lazy.so"));
+
+    // Other schemes do not trigger the load
+    gfal_plugin_interface test_plugin;
+    memset(&test_plugin, 0, sizeof(test_plugin));
+    test_plugin.getName = test_plugin_get_name;
+    test_plugin.check_plugin_url = test_plugin_url;
+    test_plugin.statG = test_plugin_stat;
+    ASSERT_EQ(0, gfal2_register_plugin(c, &test_plugin, &tmp_err));
+
+    struct stat st;
+    ASSERT_EQ(0, gfal2_stat(c, "test://blah", &st, &tmp_err));
+    ASSERT_EQ(0, count_messages(messages, "libgfal_plugin_lazy.so"));
+
+    // Neither do urls nobody claims, nor paths without a scheme
+    ASSERT_EQ(-1, gfal2_stat(c, "unknown://host/path", &st, &tmp_err));
+    ASSERT_NE((GError*)NULL, tmp_err);
+    ASSERT_EQ(EPROTONOSUPPORT, tmp_err->code);
+    g_clear_error(&tmp_err);
+    ASSERT_EQ(-1, gfal2_stat(c, "/some/path", &st, &tmp_err));
+    ASSERT_NE((GError*)NULL, tmp_err);
+    ASSERT_EQ(EPROTONOSUPPORT, tmp_err->code);
+    g_clear_error(&tmp_err);
+    ASSERT_EQ(0, count_messages(messages, "libgfal_plugin_lazy.so"));
+
+    // Its own scheme does, only once
+    ASSERT_EQ(-1, gfal2_stat(c, "lazys://host/path", &st, &tmp_err));
+    ASSERT_NE((GError*)NULL, tmp_err);
+    ASSERT_EQ(EPROTONOSUPPORT, tmp_err->code);
+    g_clear_error(&tmp_err);
+    ASSERT_EQ(1, count_messages(messages, "libgfal_plugin_lazy.so"));
+
+    ASSERT_EQ(-1, gfal2_stat(c, "lazy://host/path", &st, &tmp_err));
+    g_clear_error(&tmp_err);
+    ASSERT_EQ(1, count_messages(messages, "libgfal_plugin_lazy.so"));
+
+    gfal2_context_free(c);
+    g_log_remove_handler("GFAL2", handler);
+    g_ptr_array_free(messages, TRUE);
+
+    if (previous_dir)
+        g_setenv("GFAL_PLUGIN_DIR", previous_dir, TRUE);
+    else
+        g_unsetenv("GFAL_PLUGIN_DIR");
+    g_free(previous_dir);
+
+    unlink(library);
+    unlink(manifest);
+    rmdir(plugin_dir);
+    g_free(library);
+    g_free(manifest);
+}
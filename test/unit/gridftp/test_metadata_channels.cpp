@@ -0,0 +1,174 @@
+/*
+ * Copyright (c) CERN 2017
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gfal_api.h>
+#include <gtest/gtest.h>
+#include <exceptions/gfalcoreexception.hpp>
+#include <pthread.h>
+
+#include "plugins/gridftp/gridftp_plugin.h"
+#include "plugins/gridftp/gridftpmodule.h"
+#include "plugins/gridftp/gridftpwrapper.h"
+
+// The admission of the endpoints is shared by the whole process,
+// so each test uses its own host
+
+
+struct CheckoutArgs {
+    GridFTPFactory* factory;
+    const char* url;
+    GridFTPSession* session;
+    int errcode;
+    gint finished;
+};
+
+
+static void* checkout_thread(void* data)
+{
+    CheckoutArgs* args = (CheckoutArgs*)data;
+    try {
+        args->session = args->factory->get_metadata_session(args->url);
+    }
+    catch (const Gfal::CoreException& e) {
+        args->errcode = e.code();
+    }
+    g_atomic_int_set(&args->finished, 1);
+    return NULL;
+}
+
+
+class MetadataChannelsTest: public testing::Test {
+public:
+    MetadataChannelsTest() {
+        context = gfal2_context_new(NULL);
+        gfal2_set_opt_boolean(context, GRIDFTP_CONFIG_GROUP, GRIDFTP_CONFIG_SESSION_REUSE, TRUE, NULL);
+        gfal2_set_opt_integer(context, GRIDFTP_CONFIG_GROUP, GRIDFTP_CONFIG_METADATA_CHANNELS, 1, NULL);
+        gfal2_set_opt_integer(context, GRIDFTP_CONFIG_GROUP, GRIDFTP_CONFIG_OP_TIMEOUT, 30, NULL);
+        factory = new GridFTPFactory(context);
+        module = new GridFTPModule(factory);
+    }
+
+    virtual ~MetadataChannelsTest() {
+        delete module;
+        gfal2_context_free(context);
+    }
+
+protected:
+    gfal2_context_t context;
+    GridFTPFactory* factory;
+    GridFTPModule* module;
+
+    void start_checkout(pthread_t* thread, CheckoutArgs* args, const char* url) {
+        args->factory = factory;
+        args->url = url;
+        args->session = NULL;
+        args->errcode = 0;
+        args->finished = 0;
+        pthread_create(thread, NULL, checkout_thread, args);
+    }
+};
+
+
+TEST_F(MetadataChannelsTest, ReuseWithinLimit)
+{
+    const char* url = "gsiftp://reuse.cern.ch/path";
+    gfal2_set_opt_integer(context, GRIDFTP_CONFIG_GROUP, GRIDFTP_CONFIG_METADATA_CHANNELS, 2, NULL);
+
+    GridFTPSession* first = factory->get_metadata_session(url);
+    GridFTPSession* second = factory->get_metadata_session(url);
+    EXPECT_NE(first, second);
+
+    factory->release_metadata_session(first);
+    EXPECT_EQ(1u, factory->get_idle_metadata_channels());
+
+    // The idle channel is given to the next caller
+    GridFTPSession* third = factory->get_metadata_session(url);
+    EXPECT_EQ(first, third);
+    EXPECT_EQ(0u, factory->get_idle_metadata_channels());
+
+    factory->release_metadata_session(second);
+    factory->release_metadata_session(third);
+    EXPECT_EQ(2u, factory->get_idle_metadata_channels());
+}
+
+
+TEST_F(MetadataChannelsTest, WaitBeyondLimit)
+{
+    const char* url = "gsiftp://wait.cern.ch/path";
+    GridFTPSession* first = factory->get_metadata_session(url);
+
+    pthread_t thread;
+    CheckoutArgs args;
+    start_checkout(&thread, &args, url);
+
+    g_usleep(200000);
+    EXPECT_EQ(0, g_atomic_int_get(&args.finished));
+
+    // Gets the channel given back
+    factory->release_metadata_session(first);
+    pthread_join(thread, NULL);
+    EXPECT_EQ(0, args.errcode);
+    EXPECT_EQ(first, args.session);
+
+    factory->release_metadata_session(args.session);
+}
+
+
+TEST_F(MetadataChannelsTest, CancelWhileWaiting)
+{
+    const char* url = "gsiftp://cancel.cern.ch/path";
+    GridFTPSession* first = factory->get_metadata_session(url);
+
+    pthread_t thread;
+    CheckoutArgs args;
+    start_checkout(&thread, &args, url);
+
+    // The waiter may not be queued yet the first time
+    for (int i = 0; i < 500 && !g_atomic_int_get(&args.finished); ++i) {
+        g_usleep(10000);
+        gfal2_cancel(context);
+    }
+    pthread_join(thread, NULL);
+    EXPECT_EQ(ECANCELED, args.errcode);
+    EXPECT_EQ(NULL, args.session);
+
+    // The cancelled caller did not keep a place in the queue
+    factory->release_metadata_session(first);
+    GridFTPSession* second = factory->get_metadata_session(url);
+    EXPECT_EQ(first, second);
+    factory->release_metadata_session(second);
+}
+
+
+TEST_F(MetadataChannelsTest, ReturnedWhenFeatFails)
+{
+    // Nothing listens on the port 1, so FEAT fails
+    const char* url = "gsiftp://localhost:1/path";
+
+    EXPECT_THROW(GridFTPSessionHandler handler(factory, url, true), Gfal::CoreException);
+
+    // The broken channel is closed instead of kept idle
+    EXPECT_EQ(0u, factory->get_idle_metadata_channels());
+
+    // and its slot is free
+    GError* error = NULL;
+    gfal2_endpoint_slot_t slot = NULL;
+    EXPECT_EQ(0, gfal2_endpoint_slot_acquire(context, gridftp_plugin_name(), url,
+        GRIDFTP_CONFIG_METADATA_CHANNELS, 1, 0, &slot, &error));
+    EXPECT_EQ(NULL, error);
+    g_clear_error(&error);
+    gfal2_endpoint_slot_release(slot);
+}
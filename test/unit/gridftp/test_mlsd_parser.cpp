@@ -0,0 +1,252 @@
+/*
+ * Copyright (c) CERN 2017
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <plugins/gridftp/gridftp_mlsd_parser.h>
+#include <cstring>
+#include <string>
+
+
+static std::string entry_name(const GridFtpMlsdEntry& entry)
+{
+    return std::string(entry.name, entry.name_len);
+}
+
+
+TEST(GridFtpMlsdParser, MdtmToTimet)
+{
+    ASSERT_EQ(0, gridftp_mdtm_to_timet("19700101000000", 14));
+    ASSERT_EQ(1490088612, gridftp_mdtm_to_timet("20170321093012", 14));
+    // Fractions of a second are ignored
+    ASSERT_EQ(1490088612, gridftp_mdtm_to_timet("20170321093012.123", 18));
+    // Leap day and leap second
+    ASSERT_EQ(951868800, gridftp_mdtm_to_timet("20000229235960", 14));
+    ASSERT_EQ(4107542400, gridftp_mdtm_to_timet("21000301000000", 14));
+    // Same result whatever the local time zone, the timestamp is UTC
+    const char* tz = getenv("TZ");
+    std::string saved_tz(tz ? tz : "");
+    setenv("TZ", "Europe/Zurich", 1);
+    tzset();
+    ASSERT_EQ(1490088612, gridftp_mdtm_to_timet("20170321093012", 14));
+    if (tz)
+        setenv("TZ", saved_tz.c_str(), 1);
+    else
+        unsetenv("TZ");
+    tzset();
+}
+
+
+TEST(GridFtpMlsdParser, MdtmToTimetMalformed)
+{
+    ASSERT_EQ(-1, gridftp_mdtm_to_timet("2017032109301", 13));
+    ASSERT_EQ(-1, gridftp_mdtm_to_timet("2017032109301x", 14));
+    ASSERT_EQ(-1, gridftp_mdtm_to_timet("20171321093012", 14));
+    ASSERT_EQ(-1, gridftp_mdtm_to_timet("20170300093012", 14));
+    ASSERT_EQ(-1, gridftp_mdtm_to_timet("20170321243012", 14));
+    ASSERT_EQ(-1, gridftp_mdtm_to_timet("20170321096012", 14));
+    // The length is honoured, even if the string goes on
+    ASSERT_EQ(-1, gridftp_mdtm_to_timet("20170321093012", 8));
+}
+
+
+TEST(GridFtpMlsdParser, Entry)
+{
+    const char* line = "Type=file;Modify=20170321093012;Size=2147483648;UNIX.mode=0644;"
+            "UNIX.uid=20101;UNIX.gid=2010;Unique=fd01-4060113; AOD.pool.root.1\r\n";
+    struct stat st;
+    memset(&st, 0, sizeof(st));
+    const char* name;
+    size_t name_len;
+
+    ASSERT_EQ(0, gridftp_parse_mlsd_entry(line, strlen(line), &st, &name, &name_len));
+    ASSERT_EQ("AOD.pool.root.1", std::string(name, name_len));
+    ASSERT_EQ(2147483648, st.st_size);
+    ASSERT_EQ(1490088612, st.st_mtime);
+    ASSERT_EQ(S_IFREG | 0644, st.st_mode);
+    ASSERT_EQ(20101u, st.st_uid);
+    ASSERT_EQ(2010u, st.st_gid);
+    ASSERT_EQ(1u, st.st_nlink);
+}
+
+
+TEST(GridFtpMlsdParser, EntryDirectory)
+{
+    const char* line = "type=DIR;unix.MODE=0775;modify=20170321093012; run2017A";
+    struct stat st;
+    const char* name;
+    size_t name_len;
+
+    ASSERT_EQ(0, gridftp_parse_mlsd_entry(line, strlen(line), &st, &name, &name_len));
+    ASSERT_EQ("run2017A", std::string(name, name_len));
+    ASSERT_EQ(S_IFDIR | 0775, st.st_mode);
+}
+
+
+TEST(GridFtpMlsdParser, EntryNameWithSpaces)
+{
+    const char* line = "Type=file;Size=10;UNIX.mode=0644;  file with  spaces.txt \r\n";
+    struct stat st;
+    const char* name;
+    size_t name_len;
+
+    // Only the first space separates the facts from the name, the trailing ones are dropped
+    ASSERT_EQ(0, gridftp_parse_mlsd_entry(line, strlen(line), &st, &name, &name_len));
+    ASSERT_EQ(" file with  spaces.txt", std::string(name, name_len));
+    ASSERT_EQ(10, st.st_size);
+}
+
+
+TEST(GridFtpMlsdParser, EntryMissingTrailingSemicolon)
+{
+    // Older MLST drafts, as ncftpd
+    const char* line = "Type=file;Size=10;UNIX.mode=0600 name";
+    struct stat st;
+    const char* name;
+    size_t name_len;
+
+    ASSERT_EQ(0, gridftp_parse_mlsd_entry(line, strlen(line), &st, &name, &name_len));
+    ASSERT_EQ("name", std::string(name, name_len));
+    ASSERT_EQ(10, st.st_size);
+    ASSERT_EQ(S_IFREG | 0600, st.st_mode);
+}
+
+
+TEST(GridFtpMlsdParser, EntryWithoutMode)
+{
+    const char* line = "Type=file;Size=10; name";
+    struct stat st;
+    const char* name;
+    size_t name_len;
+
+    ASSERT_EQ(0, gridftp_parse_mlsd_entry(line, strlen(line), &st, &name, &name_len));
+    ASSERT_EQ((mode_t)-1, st.st_mode);
+    ASSERT_EQ(-1, st.st_mtime);
+}
+
+
+TEST(GridFtpMlsdParser, EntryMalformed)
+{
+    struct stat st;
+    const char* name;
+    size_t name_len;
+
+    const char* no_space = "Type=file;Size=10;";
+    ASSERT_EQ(-1, gridftp_parse_mlsd_entry(no_space, strlen(no_space), &st, &name, &name_len));
+
+    const char* no_equal = "Type=file;Size; name";
+    ASSERT_EQ(-1, gridftp_parse_mlsd_entry(no_equal, strlen(no_equal), &st, &name, &name_len));
+}
+
+
+TEST(GridFtpMlsdParser, BatchCrLf)
+{
+    const std::string listing =
+            "Type=cdir;UNIX.mode=0775; .\r\n"
+            "\r\n"
+            "Type=file;Size=1;UNIX.mode=0644; a\r\n"
+            "Type=file;Size=2;UNIX.mode=0644; b\n";
+    std::vector<GridFtpMlsdEntry> batch;
+    const char* error_line = NULL;
+    size_t error_len = 0;
+
+    ssize_t consumed = gridftp_parse_mlsd_batch(listing.data(), listing.size(), false,
+            batch, &error_line, &error_len);
+    ASSERT_EQ((ssize_t)listing.size(), consumed);
+    ASSERT_EQ(3u, batch.size());
+    ASSERT_EQ(".", entry_name(batch[0]));
+    ASSERT_EQ("a", entry_name(batch[1]));
+    ASSERT_EQ(1, batch[1].st.st_size);
+    ASSERT_EQ("b", entry_name(batch[2]));
+    ASSERT_EQ(2, batch[2].st.st_size);
+}
+
+
+TEST(GridFtpMlsdParser, BatchUnsetFactsAreZero)
+{
+    const std::string listing = "Type=file; name\r\n";
+    std::vector<GridFtpMlsdEntry> batch;
+    const char* error_line = NULL;
+    size_t error_len = 0;
+
+    ASSERT_EQ((ssize_t)listing.size(), gridftp_parse_mlsd_batch(listing.data(), listing.size(), true,
+            batch, &error_line, &error_len));
+    ASSERT_EQ(1u, batch.size());
+    ASSERT_EQ(0u, batch[0].st.st_uid);
+    ASSERT_EQ(0u, batch[0].st.st_gid);
+    ASSERT_EQ(0, batch[0].st.st_atime);
+}
+
+
+TEST(GridFtpMlsdParser, BatchSplitAcrossRefills)
+{
+    const std::string listing =
+            "Type=file;Size=1;UNIX.mode=0644; first\r\n"
+            "Type=file;Size=2;UNIX.mode=0644; second name\r\n"
+            "Type=file;Size=3;UNIX.mode=0644; third";
+    std::vector<GridFtpMlsdEntry> batch;
+    const char* error_line = NULL;
+    size_t error_len = 0;
+
+    // Every possible cut, as the data could be received
+    for (size_t cut = 0; cut <= listing.size(); ++cut) {
+        SCOPED_TRACE(cut);
+        batch.clear();
+
+        ssize_t consumed = gridftp_parse_mlsd_batch(listing.data(), cut, false,
+                batch, &error_line, &error_len);
+        ASSERT_GE(consumed, 0);
+        // Only complete lines are consumed
+        ASSERT_TRUE(consumed == 0 || listing[consumed - 1] == '\n');
+
+        // The rest, with the pending part of the split line, once the end is received
+        ssize_t rest = gridftp_parse_mlsd_batch(listing.data() + consumed, listing.size() - consumed, true,
+                batch, &error_line, &error_len);
+        ASSERT_EQ((ssize_t)(listing.size() - consumed), rest);
+
+        ASSERT_EQ(3u, batch.size());
+        ASSERT_EQ("first", entry_name(batch[0]));
+        ASSERT_EQ("second name", entry_name(batch[1]));
+        ASSERT_EQ("third", entry_name(batch[2]));
+        ASSERT_EQ(3, batch[2].st.st_size);
+    }
+}
+
+
+TEST(GridFtpMlsdParser, BatchUnterminatedWithoutEof)
+{
+    const std::string listing = "Type=file;Size=1; first\r\nType=file;Size=2; seco";
+    std::vector<GridFtpMlsdEntry> batch;
+    const char* error_line = NULL;
+    size_t error_len = 0;
+
+    ssize_t consumed = gridftp_parse_mlsd_batch(listing.data(), listing.size(), false,
+            batch, &error_line, &error_len);
+    ASSERT_EQ((ssize_t)listing.find('\n') + 1, consumed);
+    ASSERT_EQ(1u, batch.size());
+}
+
+
+TEST(GridFtpMlsdParser, BatchError)
+{
+    const std::string listing = "Type=file;Size=1; first\r\nmalformed\r\nType=file; third\r\n";
+    std::vector<GridFtpMlsdEntry> batch;
+    const char* error_line = NULL;
+    size_t error_len = 0;
+
+    ASSERT_EQ(-1, gridftp_parse_mlsd_batch(listing.data(), listing.size(), true,
+            batch, &error_line, &error_len));
+    ASSERT_EQ("malformed\r", std::string(error_line, error_len));
+}
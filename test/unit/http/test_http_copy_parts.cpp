@@ -0,0 +1,163 @@
+/*
+ * Copyright (c) CERN 2021
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gfal_api.h>
+#include <gtest/gtest.h>
+#include <utils/exceptions/gerror_to_cpp.h>
+#include <thread>
+
+#include "plugins/http/gfal_http_copy.h"
+
+#define MiB (1024 * 1024)
+
+
+class HttpCopyPartsTest: public testing::Test {
+public:
+    HttpCopyPartsTest() {
+        GError *error = NULL;
+        context = gfal2_context_new(&error);
+        Gfal::gerror_to_cpp(&error);
+    }
+
+    virtual ~HttpCopyPartsTest() {
+        gfal2_context_free(context);
+    }
+
+protected:
+    gfal2_context_t context;
+
+    void set_opt(const char* key, int value) {
+        gfal2_set_opt_integer(context, "HTTP PLUGIN", key, value, NULL);
+    }
+};
+
+
+TEST_F(HttpCopyPartsTest, PartSplitting)
+{
+    set_opt("STREAM_PART_SIZE", 16 * MiB);
+    const off_t size = 100 * MiB;
+    HttpStreamPartConfig config(context, size);
+
+    EXPECT_EQ(16u * MiB, config.part_size);
+    ASSERT_EQ(7u, config.nparts(size));
+    EXPECT_EQ(0, config.part_offset(0));
+    EXPECT_EQ(16 * MiB, config.part_length(0, size));
+    EXPECT_EQ(96 * MiB, config.part_offset(6));
+    EXPECT_EQ(4u * MiB, config.part_length(6, size));
+
+    // Exact multiple of the part size
+    EXPECT_EQ(4u, config.nparts(64 * MiB));
+    EXPECT_EQ(16u * MiB, config.part_length(3, 64 * MiB));
+}
+
+
+TEST_F(HttpCopyPartsTest, PartSizeLimits)
+{
+    // Parts of at least 5 MiB
+    set_opt("STREAM_PART_SIZE", 1 * MiB);
+    HttpStreamPartConfig small(context, 100 * MiB);
+    EXPECT_EQ(5u * MiB, small.part_size);
+    EXPECT_EQ(20u, small.nparts(100 * MiB));
+
+    // At most 10000 parts
+    set_opt("STREAM_PART_SIZE", 5 * MiB);
+    const off_t size = 100000LL * MiB;
+    HttpStreamPartConfig big(context, size);
+    EXPECT_GT(big.part_size, 5u * MiB);
+    EXPECT_LE(big.nparts(size), 10000u);
+    EXPECT_EQ(static_cast<size_t>(size - big.part_offset(big.nparts(size) - 1)),
+              big.part_length(big.nparts(size) - 1, size));
+}
+
+
+TEST_F(HttpCopyPartsTest, Threshold)
+{
+    set_opt("STREAM_PARALLEL_THRESHOLD", 64 * MiB);
+    set_opt("STREAM_PARALLEL_PARTS", 4);
+    HttpStreamPartConfig config(context, 64 * MiB);
+
+    EXPECT_FALSE(config.parallel(64 * MiB - 1, 0));
+    EXPECT_TRUE(config.parallel(64 * MiB, 0));
+    EXPECT_TRUE(config.parallel(1024 * MiB, 0));
+    // Resumed copies send a single range
+    EXPECT_FALSE(config.parallel(1024 * MiB, 10));
+
+    set_opt("STREAM_PARALLEL_PARTS", 1);
+    HttpStreamPartConfig disabled(context, 1024 * MiB);
+    EXPECT_FALSE(disabled.parallel(1024 * MiB, 0));
+}
+
+
+TEST_F(HttpCopyPartsTest, RetryAccounting)
+{
+    std::atomic<bool> stop(false);
+    std::vector<int> attempts;
+
+    // Succeeds on the third attempt
+    EXPECT_TRUE(gfal_http_retry(context, 3, std::chrono::milliseconds(1), stop, [&](int attempt) {
+        attempts.push_back(attempt);
+        return attempt == 2;
+    }));
+    EXPECT_EQ(std::vector<int>({0, 1, 2}), attempts);
+
+    // Gives up after the first attempt and the retries
+    attempts.clear();
+    EXPECT_FALSE(gfal_http_retry(context, 2, std::chrono::milliseconds(1), stop, [&](int attempt) {
+        attempts.push_back(attempt);
+        return false;
+    }));
+    EXPECT_EQ(std::vector<int>({0, 1, 2}), attempts);
+
+    // No retries
+    attempts.clear();
+    EXPECT_FALSE(gfal_http_retry(context, 0, std::chrono::milliseconds(1), stop, [&](int attempt) {
+        attempts.push_back(attempt);
+        return false;
+    }));
+    EXPECT_EQ(std::vector<int>({0}), attempts);
+
+    // Another part failed meanwhile
+    attempts.clear();
+    stop = true;
+    EXPECT_FALSE(gfal_http_retry(context, 3, std::chrono::milliseconds(1), stop, [&](int attempt) {
+        attempts.push_back(attempt);
+        return false;
+    }));
+    EXPECT_EQ(std::vector<int>({0}), attempts);
+}
+
+
+TEST_F(HttpCopyPartsTest, RetryCanceled)
+{
+    std::atomic<bool> stop(false);
+    int attempts = 0;
+
+    std::thread canceler([this]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        gfal2_cancel(context);
+    });
+
+    // The backoff would be 30 seconds, the cancellation ends it
+    auto start = std::chrono::steady_clock::now();
+    EXPECT_FALSE(gfal_http_retry(context, 3, std::chrono::seconds(30), stop, [&](int) {
+        ++attempts;
+        return false;
+    }));
+    canceler.join();
+
+    EXPECT_EQ(1, attempts);
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(5));
+}
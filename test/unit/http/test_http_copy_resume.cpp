@@ -0,0 +1,117 @@
+/*
+ * Copyright (c) CERN 2021
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gfal_api.h>
+#include <gtest/gtest.h>
+#include <utils/exceptions/gerror_to_cpp.h>
+
+#include "plugins/http/gfal_http_copy.h"
+
+
+class HttpCopyResumeTest: public testing::Test {
+public:
+    HttpCopyResumeTest(): probes(0) {
+        GError *error = NULL;
+        context = gfal2_context_new(&error);
+        Gfal::gerror_to_cpp(&error);
+        params = gfalt_params_handle_new(&error);
+        Gfal::gerror_to_cpp(&error);
+
+        gfal2_set_opt_boolean(context, "HTTP PLUGIN", "ENABLE_STREAM_COPY", TRUE, NULL);
+        gfal2_set_opt_boolean(context, "HTTP PLUGIN", "ENABLE_PARTIAL_PUT", TRUE, NULL);
+        gfalt_set_offset_from_source(params, GFALT_OFFSET_FROM_DESTINATION, NULL);
+    }
+
+    virtual ~HttpCopyResumeTest() {
+        gfalt_params_handle_delete(params, NULL);
+        gfal2_context_free(context);
+    }
+
+protected:
+    gfal2_context_t context;
+    gfalt_params_t params;
+    int probes;
+
+    bool resumable(bool supported, const char* dst = "https://dst.example.com/file") {
+        return gfal_http_copy_resumable(context, params, "https://src.example.com/file", dst,
+                                        [this, supported]() { ++probes; return supported; });
+    }
+};
+
+
+TEST(HttpCopyResume, ContentRange)
+{
+    EXPECT_EQ("bytes 100-999/1000", gfal_http_content_range(100, 1000));
+    EXPECT_EQ("bytes 999-999/1000", gfal_http_content_range(999, 1000));
+    EXPECT_EQ("bytes 4294967296-8589934591/8589934592",
+              gfal_http_content_range(4294967296LL, 8589934592LL));
+}
+
+
+TEST(HttpCopyResume, AcceptRanges)
+{
+    EXPECT_TRUE(gfal_http_accepts_byte_ranges("bytes"));
+    EXPECT_TRUE(gfal_http_accepts_byte_ranges("Bytes"));
+    EXPECT_TRUE(gfal_http_accepts_byte_ranges("lines, bytes "));
+    EXPECT_FALSE(gfal_http_accepts_byte_ranges("none"));
+    EXPECT_FALSE(gfal_http_accepts_byte_ranges(""));
+    EXPECT_FALSE(gfal_http_accepts_byte_ranges("bytesx"));
+}
+
+
+TEST_F(HttpCopyResumeTest, Resumable)
+{
+    EXPECT_TRUE(resumable(true));
+    EXPECT_EQ(1, probes);
+}
+
+
+TEST_F(HttpCopyResumeTest, RangedPutNotSupported)
+{
+    // Enabled, but the destination does not accept it: the partial destination is not kept
+    EXPECT_FALSE(resumable(false));
+    EXPECT_EQ(1, probes);
+}
+
+
+TEST_F(HttpCopyResumeTest, NotRequested)
+{
+    gfalt_set_offset_from_source(params, 0, NULL);
+    EXPECT_FALSE(resumable(true));
+    EXPECT_EQ(0, probes);
+}
+
+
+TEST_F(HttpCopyResumeTest, PartialPutDisabled)
+{
+    gfal2_set_opt_boolean(context, "HTTP PLUGIN", "ENABLE_PARTIAL_PUT", FALSE, NULL);
+    EXPECT_FALSE(resumable(true));
+    EXPECT_EQ(0, probes);
+
+    // Enabled for a given storage only
+    gfal2_set_opt_boolean(context, "HTTP:DST.EXAMPLE.COM", "ENABLE_PARTIAL_PUT", TRUE, NULL);
+    EXPECT_TRUE(resumable(true));
+    EXPECT_FALSE(resumable(true, "https://other.example.com/file"));
+    EXPECT_EQ(1, probes);
+}
+
+
+TEST_F(HttpCopyResumeTest, StreamingDisabled)
+{
+    gfal2_set_opt_boolean(context, "HTTP PLUGIN", "ENABLE_STREAM_COPY", FALSE, NULL);
+    EXPECT_FALSE(resumable(true));
+    EXPECT_EQ(0, probes);
+}
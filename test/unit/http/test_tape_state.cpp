@@ -0,0 +1,229 @@
+/*
+ * Copyright (c) CERN 2022
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gfal_api.h>
+#include <gfal_plugins_api.h>
+#include <gtest/gtest.h>
+
+#include "plugins/http/gfal_http_plugin_tape.h"
+
+using namespace tape_rest_api;
+
+
+TEST(TapeStateTest, SplitRequestIds)
+{
+    std::vector<std::string> expected = {"a1", "b2", "c3"};
+    EXPECT_EQ(expected, split_request_ids("a1,b2,,c3,"));
+
+    expected = {"single"};
+    EXPECT_EQ(expected, split_request_ids("single"));
+
+    EXPECT_TRUE(split_request_ids("").empty());
+}
+
+
+TEST(TapeStateTest, CallsForToken)
+{
+    const char* urls[] = {
+        "https://tape-a.cern.ch/data/x",
+        "https://tape-a.cern.ch/data/y",
+        "https://tape-b.cern.ch/data/z",
+    };
+    const std::string endpoint_a = storage_endpoint(urls[0]);
+    const std::string endpoint_b = storage_endpoint(urls[2]);
+    ASSERT_NE(endpoint_a, endpoint_b);
+
+    // Known requests only concern their endpoint and the paths they were submitted with
+    stage_table.register_request("known-id", endpoint_a, {stage_path(urls[0])}, time(NULL));
+
+    auto calls = calls_for_token(split_request_ids("known-id,unknown-id"), 3, urls);
+    ASSERT_EQ(3u, calls.size());
+
+    EXPECT_EQ("known-id", calls[0].id);
+    EXPECT_EQ(endpoint_a, calls[0].endpoint);
+    EXPECT_EQ(std::vector<int>({0}), calls[0].files);
+
+    // Unknown requests are sent to every endpoint of the list
+    EXPECT_EQ("unknown-id", calls[1].id);
+    EXPECT_EQ(endpoint_a, calls[1].endpoint);
+    EXPECT_EQ(std::vector<int>({0, 1}), calls[1].files);
+
+    EXPECT_EQ("unknown-id", calls[2].id);
+    EXPECT_EQ(endpoint_b, calls[2].endpoint);
+    EXPECT_EQ(std::vector<int>({2}), calls[2].files);
+
+    stage_table.forget("known-id");
+}
+
+
+TEST(TapeStateTest, ParsePollResponse)
+{
+    tape_call call;
+    call.id = "poll-id";
+    call.endpoint = "https://tape-a.cern.ch";
+    call.success = true;
+    call.content = "{\"id\": \"poll-id\", \"files\": ["
+        "{\"path\": \"//data//x\", \"state\": \"COMPLETED\"},"
+        "{\"path\": \"/data/y\", \"onDisk\": false},"
+        "{\"path\": \"/data/z\", \"error\": \"Tape not available\"},"
+        "{\"path\": \"/data/w\", \"state\": \"FAILED\"},"
+        "{\"state\": \"COMPLETED\"}"
+        "]}";
+
+    parse_poll_response(call);
+    ASSERT_TRUE(call.success) << call.err_msg;
+    ASSERT_EQ(4u, call.states.size());
+    EXPECT_EQ(0, call.states["/data/x"].code);
+    EXPECT_EQ(EAGAIN, call.states["/data/y"].code);
+    EXPECT_EQ(ENOMSG, call.states["/data/z"].code);
+    EXPECT_EQ(ENOENT, call.states["/data/w"].code);
+
+    // The results are then served from the table
+    stage_table.update(call.id, call.endpoint, call.states, time(NULL));
+    stage_file_state state;
+    ASSERT_TRUE(stage_table.get_file("poll-id", "/data/x", state));
+    EXPECT_EQ(0, state.code);
+    ASSERT_TRUE(stage_table.get_file("poll-id", "/data/y", state));
+    EXPECT_EQ(EAGAIN, state.code);
+    EXPECT_FALSE(stage_table.get_file("poll-id", "/data/other", state));
+    EXPECT_FALSE(stage_table.get_file("other-id", "/data/x", state));
+
+    stage_table.forget("poll-id");
+    EXPECT_FALSE(stage_table.get_file("poll-id", "/data/x", state));
+}
+
+
+TEST(TapeStateTest, ParsePollResponseErrors)
+{
+    tape_call call;
+    call.id = "poll-id";
+
+    call.success = true;
+    call.content = "{\"id\": \"other-id\", \"files\": []}";
+    parse_poll_response(call);
+    EXPECT_FALSE(call.success);
+    EXPECT_EQ(ENOMSG, call.err_code);
+
+    call.success = true;
+    call.content = "{\"id\": \"poll-id\"}";
+    parse_poll_response(call);
+    EXPECT_FALSE(call.success);
+    EXPECT_EQ(ENOMSG, call.err_code);
+
+    call.success = true;
+    call.content = "not json";
+    parse_poll_response(call);
+    EXPECT_FALSE(call.success);
+    EXPECT_EQ(ENOMSG, call.err_code);
+
+    call.success = true;
+    call.content.clear();
+    parse_poll_response(call);
+    EXPECT_FALSE(call.success);
+    EXPECT_EQ(ENOMSG, call.err_code);
+}
+
+
+TEST(TapeStateTest, EntryExpiration)
+{
+    StageStateTable table;
+    std::string endpoint;
+    std::set<std::string> paths;
+    const time_t start = 1000000;
+
+    table.register_request("old-id", "https://tape-a.cern.ch", {"/data/x"}, start);
+    ASSERT_TRUE(table.lookup("old-id", endpoint, paths));
+    EXPECT_EQ("https://tape-a.cern.ch", endpoint);
+    EXPECT_EQ(std::set<std::string>({"/data/x"}), paths);
+
+    // Expired entries are dropped when the next request is registered
+    table.register_request("new-id", "https://tape-a.cern.ch", {"/data/y"}, start + StageStateTable::ENTRY_TTL);
+    EXPECT_TRUE(table.lookup("old-id", endpoint, paths));
+
+    table.register_request("newer-id", "https://tape-a.cern.ch", {"/data/z"}, start + StageStateTable::ENTRY_TTL + 1);
+    EXPECT_FALSE(table.lookup("old-id", endpoint, paths));
+    EXPECT_TRUE(table.lookup("new-id", endpoint, paths));
+    EXPECT_TRUE(table.lookup("newer-id", endpoint, paths));
+}
+
+
+TEST(TapeStateTest, PollNotDue)
+{
+    GError* error = NULL;
+    const char* keys[] = {"/data/ready", "/data/queued"};
+    gfal2_context_t context = gfal2_context_new(&error);
+    ASSERT_TRUE(context != NULL);
+
+    // The scheduler found the poll not due: the call succeeded without any answer in the table
+    tape_call call;
+    call.id = "not-due-id";
+    call.endpoint = "https://tape-a.cern.ch";
+    call.files = {0, 1};
+    call.success = true;
+    std::vector<tape_call> calls = {call};
+
+    // Never seen by the scheduler either: still in progress, not a failure
+    stage_file_state state;
+    EXPECT_TRUE(poll_file_state(calls, 0, "/data/ready", state));
+    EXPECT_EQ(EAGAIN, state.code);
+
+    // Polled by another thread, whose answer is no longer in the table: the scheduler has it
+    ASSERT_EQ(1, gfal2_poll_begin(context, call.endpoint.c_str(), call.id.c_str(), 60, 60, 2, keys, NULL, &error));
+    GError* statuses[2] = {NULL, NULL};
+    gfal2_set_error(&statuses[1], g_quark_from_static_string("tape"), EAGAIN, __func__, "queued");
+    gfal2_poll_end(call.endpoint.c_str(), call.id.c_str(), 2, keys, statuses);
+    g_clear_error(&statuses[1]);
+    ASSERT_EQ(0, gfal2_poll_begin(context, call.endpoint.c_str(), call.id.c_str(), 60, 60, 2, keys, NULL, &error));
+
+    EXPECT_TRUE(poll_file_state(calls, 0, "/data/ready", state));
+    EXPECT_EQ(0, state.code);
+    EXPECT_TRUE(poll_file_state(calls, 1, "/data/queued", state));
+    EXPECT_EQ(EAGAIN, state.code);
+
+    // The table is preferred when it has the file
+    stage_file_map files;
+    files["/data/queued"] = stage_file_state{ENOENT, "failed"};
+    stage_table.update(call.id, call.endpoint, files, time(NULL));
+    EXPECT_TRUE(poll_file_state(calls, 1, "/data/queued", state));
+    EXPECT_EQ(ENOENT, state.code);
+
+    stage_table.forget(call.id);
+    gfal2_poll_forget(call.endpoint.c_str(), call.id.c_str());
+    gfal2_context_free(context);
+}
+
+
+TEST(TapeStateTest, PollFailed)
+{
+    tape_call call;
+    call.id = "failed-id";
+    call.endpoint = "https://tape-a.cern.ch";
+    call.files = {0};
+    call.success = false;
+    call.err_code = ECOMM;
+    call.err_msg = "Stage polling call failed";
+    std::vector<tape_call> calls = {call};
+
+    // The error of the call is reported
+    stage_file_state state;
+    EXPECT_FALSE(poll_file_state(calls, 0, "/data/x", state));
+    EXPECT_EQ(ECOMM, state.code);
+    EXPECT_EQ("Stage polling call failed", state.message);
+
+    // No call concerns the file
+    EXPECT_FALSE(poll_file_state(calls, 1, "/data/y", state));
+    EXPECT_EQ(ENOMSG, state.code);
+}
@@ -0,0 +1,211 @@
+/*
+ * Copyright (c) CERN 2013-2017
+ *
+ * Copyright (c) Members of the EMI Collaboration. 2010-2013
+ *  See  http://www.eu-emi.eu/partners for details on the copyright
+ *  holders.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gfal_api.h>
+#include <gfal_plugins_api.h>
+#include <gtest/gtest.h>
+#include <common/gfal_fake_plugin.h>
+
+
+// Used by the plugin to change the namespace while a stat is in progress
+static gfal2_context_t racing_context = NULL;
+
+
+static int mdcache_plugin_stat(plugin_handle plugin_data, const char *url, struct stat *buf, GError **err)
+{
+    if (strstr(url, "race") && racing_context) {
+        GError *tmp_err = NULL;
+        gfal2_unlink(racing_context, url, &tmp_err);
+        g_clear_error(&tmp_err);
+    }
+    return gfal_fake_plugin_stat(plugin_data, url, buf, err);
+}
+
+
+class MetadataCacheTest: public testing::Test {
+public:
+    gfal2_context_t context;
+
+    void SetUp() {
+        GError *tmp_err = NULL;
+        context = gfal2_context_new(&tmp_err);
+        ASSERT_TRUE(context != NULL);
+
+        gfal_plugin_interface plugin;
+        gfal_fake_plugin_interface(&plugin);
+        plugin.statG = mdcache_plugin_stat;
+        ASSERT_EQ(0, gfal2_register_plugin(context, &plugin, &tmp_err));
+
+        gfal2_set_opt_integer(context, "CORE", "METADATA_CACHE_TTL", 60, NULL);
+        gfal_fake_plugin_reset_calls();
+    }
+
+    void TearDown() {
+        gfal2_context_free(context);
+    }
+};
+
+
+TEST_F(MetadataCacheTest, testDisabled)
+{
+    struct stat st;
+    GError *tmp_err = NULL;
+
+    gfal2_set_opt_integer(context, "CORE", "METADATA_CACHE_TTL", 0, NULL);
+    ASSERT_EQ(0, gfal2_stat(context, "fake://host/path", &st, &tmp_err));
+    ASSERT_EQ(0, gfal2_stat(context, "fake://host/path", &st, &tmp_err));
+    ASSERT_EQ(2, gfal_fake_plugin_calls.stat);
+}
+
+
+TEST_F(MetadataCacheTest, testStat)
+{
+    struct stat st;
+    GError *tmp_err = NULL;
+
+    ASSERT_EQ(0, gfal2_stat(context, "fake://host/path", &st, &tmp_err));
+    ASSERT_EQ(1, st.st_size);
+    ASSERT_EQ(0, gfal2_stat(context, "fake://host/path", &st, &tmp_err));
+    ASSERT_EQ(0, gfal2_stat(context, "fake://host/path/", &st, &tmp_err));
+    ASSERT_EQ(1, st.st_size);
+    ASSERT_EQ(1, gfal_fake_plugin_calls.stat);
+
+    // Errors are not cached
+    ASSERT_EQ(-1, gfal2_stat(context, "fake://host/missing", &st, &tmp_err));
+    g_clear_error(&tmp_err);
+    ASSERT_EQ(-1, gfal2_stat(context, "fake://host/missing", &st, &tmp_err));
+    g_clear_error(&tmp_err);
+    ASSERT_EQ(3, gfal_fake_plugin_calls.stat);
+}
+
+
+TEST_F(MetadataCacheTest, testAccessAndXattr)
+{
+    GError *tmp_err = NULL;
+    char value[64];
+
+    ASSERT_EQ(0, gfal2_access(context, "fake://host/path", R_OK, &tmp_err));
+    ASSERT_EQ(0, gfal2_access(context, "fake://host/path", R_OK, &tmp_err));
+    ASSERT_EQ(1, gfal_fake_plugin_calls.access);
+    ASSERT_EQ(0, gfal2_access(context, "fake://host/path", W_OK, &tmp_err));
+    ASSERT_EQ(2, gfal_fake_plugin_calls.access);
+
+    ASSERT_EQ(6, gfal2_getxattr(context, "fake://host/path", "user.guid", value, sizeof(value), &tmp_err));
+    memset(value, 'x', sizeof(value));
+    ASSERT_EQ(6, gfal2_getxattr(context, "fake://host/path", "user.guid", value, sizeof(value), &tmp_err));
+    ASSERT_STREQ("ONLINE", value);
+    ASSERT_EQ(6, gfal2_getxattr(context, "fake://host/path", "user.guid", NULL, 0, &tmp_err));
+    ASSERT_EQ(1, gfal_fake_plugin_calls.getxattr);
+}
+
+
+TEST_F(MetadataCacheTest, testLiveXattr)
+{
+    GError *tmp_err = NULL;
+    char value[64];
+
+    // The locality of a file changes without gfal2 knowing
+    ASSERT_EQ(6, gfal2_getxattr(context, "fake://host/path", "user.status", value, sizeof(value), &tmp_err));
+    ASSERT_EQ(6, gfal2_getxattr(context, "fake://host/path", "user.status", value, sizeof(value), &tmp_err));
+    ASSERT_EQ(2, gfal_fake_plugin_calls.getxattr);
+
+    ASSERT_EQ(6, gfal2_getxattr(context, "fake://host/path", "spacetoken", value, sizeof(value), &tmp_err));
+    ASSERT_EQ(6, gfal2_getxattr(context, "fake://host/path", "spacetoken", value, sizeof(value), &tmp_err));
+    ASSERT_EQ(4, gfal_fake_plugin_calls.getxattr);
+}
+
+
+// A stat that started before an invalidation must not be stored after it
+TEST_F(MetadataCacheTest, testInvalidatedDuringStat)
+{
+    struct stat st;
+    GError *tmp_err = NULL;
+
+    racing_context = context;
+    ASSERT_EQ(0, gfal2_stat(context, "fake://host/race", &st, &tmp_err));
+    racing_context = NULL;
+
+    ASSERT_EQ(0, gfal2_stat(context, "fake://host/race", &st, &tmp_err));
+    ASSERT_EQ(2, gfal_fake_plugin_calls.stat);
+    // The second one was not raced with
+    ASSERT_EQ(0, gfal2_stat(context, "fake://host/race", &st, &tmp_err));
+    ASSERT_EQ(2, gfal_fake_plugin_calls.stat);
+}
+
+
+TEST_F(MetadataCacheTest, testInvalidation)
+{
+    struct stat st;
+    GError *tmp_err = NULL;
+
+    ASSERT_EQ(0, gfal2_stat(context, "fake://host/dir", &st, &tmp_err));
+    ASSERT_EQ(0, gfal2_stat(context, "fake://host/dir/file", &st, &tmp_err));
+    ASSERT_EQ(0, gfal2_stat(context, "fake://host/other", &st, &tmp_err));
+    ASSERT_EQ(3, gfal_fake_plugin_calls.stat);
+
+    // The file and its parent are dropped, not the sibling
+    ASSERT_EQ(0, gfal2_unlink(context, "fake://host/dir/file", &tmp_err));
+    ASSERT_EQ(0, gfal2_stat(context, "fake://host/dir/file", &st, &tmp_err));
+    ASSERT_EQ(0, gfal2_stat(context, "fake://host/dir", &st, &tmp_err));
+    ASSERT_EQ(0, gfal2_stat(context, "fake://host/other", &st, &tmp_err));
+    ASSERT_EQ(5, gfal_fake_plugin_calls.stat);
+
+    // Renaming a directory drops its content
+    ASSERT_EQ(0, gfal2_rename(context, "fake://host/dir", "fake://host/dir2", &tmp_err));
+    ASSERT_EQ(0, gfal2_stat(context, "fake://host/dir/file", &st, &tmp_err));
+    ASSERT_EQ(6, gfal_fake_plugin_calls.stat);
+}
+
+
+TEST_F(MetadataCacheTest, testReaddirpp)
+{
+    struct stat st;
+    GError *tmp_err = NULL;
+
+    DIR *dir = gfal2_opendir(context, "fake://host/dir/", &tmp_err);
+    ASSERT_TRUE(dir != NULL);
+    while (gfal2_readdirpp(context, dir, &st, &tmp_err) != NULL);
+    ASSERT_TRUE(tmp_err == NULL);
+    ASSERT_EQ(0, gfal2_closedir(context, dir, &tmp_err));
+
+    ASSERT_EQ(0, gfal2_stat(context, "fake://host/dir/file1", &st, &tmp_err));
+    ASSERT_EQ(101, st.st_size);
+    ASSERT_EQ(0, gfal2_stat(context, "fake://host/dir/file2", &st, &tmp_err));
+    ASSERT_EQ(102, st.st_size);
+    ASSERT_EQ(0, gfal_fake_plugin_calls.stat);
+}
+
+
+// The entries go into the path of the directory, not after its query
+TEST_F(MetadataCacheTest, testReaddirppQuery)
+{
+    struct stat st;
+    GError *tmp_err = NULL;
+
+    DIR *dir = gfal2_opendir(context, "fake://host/dir?authz=token", &tmp_err);
+    ASSERT_TRUE(dir != NULL);
+    while (gfal2_readdirpp(context, dir, &st, &tmp_err) != NULL);
+    ASSERT_TRUE(tmp_err == NULL);
+    ASSERT_EQ(0, gfal2_closedir(context, dir, &tmp_err));
+
+    ASSERT_EQ(0, gfal2_stat(context, "fake://host/dir/file1?authz=token", &st, &tmp_err));
+    ASSERT_EQ(101, st.st_size);
+    ASSERT_EQ(0, gfal_fake_plugin_calls.stat);
+}
@@ -19,7 +19,12 @@
  */
 
 #include <utils/mds/gfal_mds_internal.h>
+extern "C" {
+#include <utils/mds/gfal_mds_ldap_internal_layer.h>
+}
 #include <gtest/gtest.h>
+#include <cerrno>
+#include <cstring>
 #include <fstream>
 
 
@@ -86,3 +91,220 @@ TEST_F(MdsTestFixture, test_cache_found)
     ASSERT_EQ(endpoints[0].type, SRMv2);
     ASSERT_STREQ(endpoints[0].url, "httpg://test.domain.com:8442/srm/managerv2");
 }
+
+
+TEST_F(MdsTestFixture, test_cache_reload)
+{
+    gfal_mds_endpoint endpoints[5];
+    GError* err = NULL;
+    int ret = gfal_mds_cache_resolve_endpoint(context, "test.domain.com", endpoints, 5, &err);
+    ASSERT_EQ(ret, 1);
+
+    // A new version of the file must be picked up
+    std::ofstream cache(MDS_CACHE_FILE, std::ios_base::out | std::ios_base::trunc);
+    cache
+        << "<?xml version=\"1.0\"?>" << std::endl
+        << "<entry>" << std::endl
+        << "    <endpoint>httpg://other.domain.com:8443/srm/managerv2</endpoint>" << std::endl
+        << "    <sitename>TEST-PROD</sitename>" << std::endl
+        << "    <type>SRM</type>" << std::endl
+        << "    <version>2.2.0</version>" << std::endl
+        << "</entry>" << std::endl;
+    cache.close();
+
+    ret = gfal_mds_cache_resolve_endpoint(context, "test.domain.com", endpoints, 5, &err);
+    ASSERT_EQ(err, (void*)NULL);
+    ASSERT_EQ(ret, 0);
+
+    ret = gfal_mds_cache_resolve_endpoint(context, "other.domain.com:8443", endpoints, 5, &err);
+    ASSERT_EQ(err, (void*)NULL);
+    ASSERT_EQ(ret, 1);
+    ASSERT_STREQ(endpoints[0].url, "httpg://other.domain.com:8443/srm/managerv2");
+}
+
+
+TEST_F(MdsTestFixture, test_resolution_cache)
+{
+    gfal_mds_endpoint endpoints[5];
+    GError* err = NULL;
+    gfal_mds_resolution_cache_clear();
+
+    int ret = gfal_mds_resolve_srm_endpoint(context, "test.domain.com", endpoints, 5, &err);
+    ASSERT_EQ(err, (void*)NULL);
+    ASSERT_EQ(ret, 1);
+
+    // Served from memory even if the cache file goes away
+    unlink(MDS_CACHE_FILE);
+    memset(endpoints, 0, sizeof(endpoints));
+    ret = gfal_mds_resolve_srm_endpoint(context, "test.domain.com", endpoints, 5, &err);
+    ASSERT_EQ(err, (void*)NULL);
+    ASSERT_EQ(ret, 1);
+    ASSERT_STREQ(endpoints[0].url, "httpg://test.domain.com:8442/srm/managerv2");
+
+    gfal_mds_resolution_cache_clear();
+}
+
+
+TEST_F(MdsTestFixture, test_resolution_cache_file_in_key)
+{
+    gfal_mds_endpoint endpoints[5];
+    GError* err = NULL;
+    gfal_mds_resolution_cache_clear();
+
+    int ret = gfal_mds_resolve_srm_endpoint(context, "test.domain.com", endpoints, 5, &err);
+    ASSERT_EQ(err, (void*)NULL);
+    ASSERT_EQ(ret, 1);
+
+    // Another cache file must not be served the resolution done with the first one
+    const char* other_cache = "/tmp/mds_cache_other.xml";
+    std::ofstream cache(other_cache, std::ios_base::out | std::ios_base::trunc);
+    cache
+        << "<?xml version=\"1.0\"?>" << std::endl
+        << "<entry>" << std::endl
+        << "    <endpoint>httpg://test.domain.com:8446/srm/managerv2</endpoint>" << std::endl
+        << "    <sitename>TEST-PROD</sitename>" << std::endl
+        << "    <type>SRM</type>" << std::endl
+        << "    <version>2.2.0</version>" << std::endl
+        << "</entry>" << std::endl;
+    cache.close();
+    gfal2_set_opt_string(context, "BDII", "CACHE_FILE", other_cache, NULL);
+
+    ret = gfal_mds_resolve_srm_endpoint(context, "test.domain.com", endpoints, 5, &err);
+    ASSERT_EQ(err, (void*)NULL);
+    ASSERT_EQ(ret, 1);
+    ASSERT_STREQ(endpoints[0].url, "httpg://test.domain.com:8446/srm/managerv2");
+
+    unlink(other_cache);
+    gfal_mds_resolution_cache_clear();
+}
+
+// Fake BDII, either unreachable or without any entry
+static int fake_bdii_connects = 0;
+static bool fake_bdii_down = false;
+static LDAP* const fake_bdii_handle = reinterpret_cast<LDAP*>(0x1);
+static LDAPMessage* const fake_bdii_result = reinterpret_cast<LDAPMessage*>(0x2);
+
+static int fake_ldap_initialize(LDAP **ldp, const char *)
+{
+    ++fake_bdii_connects;
+    if (fake_bdii_down)
+        return LDAP_SERVER_DOWN;
+    *ldp = fake_bdii_handle;
+    return LDAP_SUCCESS;
+}
+
+static int fake_ldap_set_option(LDAP *, int, const void *)
+{
+    return LDAP_OPT_SUCCESS;
+}
+
+static int fake_ldap_sasl_bind_s(LDAP *, const char *, const char *, struct berval *,
+    LDAPControl **, LDAPControl **, struct berval **)
+{
+    return LDAP_SUCCESS;
+}
+
+static int fake_ldap_search_ext_s(LDAP *, LDAP_CONST char *, int, LDAP_CONST char *, char **, int,
+    LDAPControl **, LDAPControl **, struct timeval *, int, LDAPMessage **res)
+{
+    *res = fake_bdii_result;
+    return LDAP_SUCCESS;
+}
+
+static int fake_ldap_count_entries(LDAP *, LDAPMessage *)
+{
+    return 0;
+}
+
+static int fake_ldap_msgfree(LDAPMessage *)
+{
+    return 0;
+}
+
+static int fake_ldap_unbind_ext_s(LDAP *, LDAPControl **, LDAPControl **)
+{
+    return LDAP_SUCCESS;
+}
+
+
+class MdsBdiiTestFixture : public MdsTestFixture {
+protected:
+    struct _gfal_mds_ldap saved_ldap;
+
+public:
+    MdsBdiiTestFixture() {
+        saved_ldap = gfal_mds_ldap;
+        gfal_mds_ldap.ldap_initialize = fake_ldap_initialize;
+        gfal_mds_ldap.ldap_set_option = fake_ldap_set_option;
+        gfal_mds_ldap.ldap_sasl_bind_s = fake_ldap_sasl_bind_s;
+        gfal_mds_ldap.ldap_search_ext_s = fake_ldap_search_ext_s;
+        gfal_mds_ldap.ldap_count_entries = fake_ldap_count_entries;
+        gfal_mds_ldap.ldap_msgfree = fake_ldap_msgfree;
+        gfal_mds_ldap.ldap_unbind_ext_s = fake_ldap_unbind_ext_s;
+        fake_bdii_connects = 0;
+        fake_bdii_down = false;
+
+        g_unsetenv("LCG_GFAL_INFOSYS");
+        gfal2_set_opt_string(context, "BDII", "LCG_GFAL_INFOSYS", "bdii.example.com:2170", NULL);
+        gfal_mds_resolution_cache_clear();
+    }
+
+    ~MdsBdiiTestFixture() {
+        // The fake connections must not reach the real libldap
+        gfal_mds_ldap_pool_clear();
+        gfal_mds_ldap = saved_ldap;
+        gfal_mds_resolution_cache_clear();
+    }
+};
+
+
+TEST_F(MdsBdiiTestFixture, test_resolution_bdii_down_not_cached)
+{
+    gfal_mds_endpoint endpoints[5];
+    GError* err = NULL;
+    fake_bdii_down = true;
+
+    int ret = gfal_mds_resolve_srm_endpoint(context, "unknown.domain.com", endpoints, 5, &err);
+    ASSERT_EQ(ret, -1);
+    ASSERT_NE(err, (void*)NULL);
+    ASSERT_EQ(err->code, ECOMM);
+    g_clear_error(&err);
+
+    // The BDII is asked again
+    ret = gfal_mds_resolve_srm_endpoint(context, "unknown.domain.com", endpoints, 5, &err);
+    ASSERT_EQ(ret, -1);
+    ASSERT_EQ(err->code, ECOMM);
+    g_clear_error(&err);
+    ASSERT_EQ(fake_bdii_connects, 2);
+}
+
+
+TEST_F(MdsBdiiTestFixture, test_resolution_unknown_host_cached)
+{
+    gfal_mds_endpoint endpoints[5];
+    GError* err = NULL;
+
+    int ret = gfal_mds_resolve_srm_endpoint(context, "unknown.domain.com", endpoints, 5, &err);
+    ASSERT_EQ(ret, -1);
+    ASSERT_NE(err, (void*)NULL);
+    ASSERT_EQ(err->code, ENXIO);
+    g_clear_error(&err);
+    ASSERT_EQ(fake_bdii_connects, 1);
+
+    // Served from memory, the BDII is not contacted
+    fake_bdii_down = true;
+    ret = gfal_mds_resolve_srm_endpoint(context, "unknown.domain.com", endpoints, 5, &err);
+    ASSERT_EQ(ret, -1);
+    ASSERT_NE(err, (void*)NULL);
+    ASSERT_EQ(err->code, ENXIO);
+    g_clear_error(&err);
+    ASSERT_EQ(fake_bdii_connects, 1);
+
+    // But another BDII is
+    gfal2_set_opt_string(context, "BDII", "LCG_GFAL_INFOSYS", "other-bdii.example.com:2170", NULL);
+    ret = gfal_mds_resolve_srm_endpoint(context, "unknown.domain.com", endpoints, 5, &err);
+    ASSERT_EQ(ret, -1);
+    ASSERT_EQ(err->code, ECOMM);
+    g_clear_error(&err);
+    ASSERT_EQ(fake_bdii_connects, 2);
+}
@@ -0,0 +1,197 @@
+/*
+ * Copyright (c) CERN 2013-2017
+ *
+ * Copyright (c) Members of the EMI Collaboration. 2010-2013
+ *  See  http://www.eu-emi.eu/partners for details on the copyright
+ *  holders.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gfal_api.h>
+#include <gfal_plugins_api.h>
+#include <gtest/gtest.h>
+#include <common/gfal_fake_plugin.h>
+#include <pthread.h>
+
+
+// Slow enough for the durations to be measured
+static int metrics_plugin_stat(plugin_handle plugin_data, const char *url, struct stat *buf, GError **err)
+{
+    g_usleep(1000);
+    return gfal_fake_plugin_stat(plugin_data, url, buf, err);
+}
+
+
+static const gfal2_metric_t *find_metric(gfal2_metrics_snapshot_t snapshot, const char *op, const char *host)
+{
+    for (guint i = 0; i < gfal2_metrics_snapshot_length(snapshot); ++i) {
+        const gfal2_metric_t *metric = gfal2_metrics_snapshot_get(snapshot, i);
+        if (strcmp(metric->plugin, GFAL_FAKE_PLUGIN_NAME) == 0 && strcmp(metric->operation, op) == 0 &&
+            strcmp(metric->host, host) == 0) {
+            return metric;
+        }
+    }
+    return NULL;
+}
+
+
+class MetricsTest: public testing::Test {
+public:
+    gfal2_context_t context;
+
+    void SetUp() {
+        GError *tmp_err = NULL;
+        context = gfal2_context_new(&tmp_err);
+        ASSERT_TRUE(context != NULL);
+
+        gfal_plugin_interface plugin;
+        gfal_fake_plugin_interface(&plugin);
+        plugin.statG = metrics_plugin_stat;
+        ASSERT_EQ(0, gfal2_register_plugin(context, &plugin, &tmp_err));
+
+        gfal2_metrics_set_enabled(TRUE);
+        gfal2_metrics_reset();
+    }
+
+    void TearDown() {
+        gfal2_metrics_set_enabled(FALSE);
+        gfal2_context_free(context);
+    }
+};
+
+
+TEST_F(MetricsTest, testCountersPerHost)
+{
+    struct stat st;
+    GError *tmp_err = NULL;
+
+    for (int i = 0; i < 10; ++i) {
+        ASSERT_EQ(0, gfal2_stat(context, "fake://user@host-a:1094/path", &st, &tmp_err));
+    }
+    ASSERT_EQ(0, gfal2_stat(context, "fake://host-b/path", &st, &tmp_err));
+    ASSERT_EQ(-1, gfal2_stat(context, "fake://host-b/missing", &st, &tmp_err));
+    g_clear_error(&tmp_err);
+
+    gfal2_metrics_snapshot_t snapshot = gfal2_metrics_snapshot();
+
+    const gfal2_metric_t *host_a = find_metric(snapshot, "stat", "host-a:1094");
+    ASSERT_TRUE(host_a != NULL);
+    ASSERT_EQ(10u, host_a->count);
+    ASSERT_EQ(0u, host_a->errors);
+    ASSERT_GE(host_a->max_usec, 1000u);
+    ASSERT_LE(host_a->p50_usec, host_a->p99_usec);
+    ASSERT_LE(host_a->p99_usec, host_a->max_usec);
+    ASSERT_GE(host_a->sum_usec, 10000u);
+
+    const gfal2_metric_t *host_b = find_metric(snapshot, "stat", "host-b");
+    ASSERT_TRUE(host_b != NULL);
+    ASSERT_EQ(2u, host_b->count);
+    ASSERT_EQ(1u, host_b->errors);
+
+    gfal2_metrics_snapshot_free(snapshot);
+}
+
+
+TEST_F(MetricsTest, testDisabled)
+{
+    struct stat st;
+    GError *tmp_err = NULL;
+
+    gfal2_metrics_set_enabled(FALSE);
+    ASSERT_EQ(0, gfal2_stat(context, "fake://host-c/path", &st, &tmp_err));
+
+    gfal2_metrics_snapshot_t snapshot = gfal2_metrics_snapshot();
+    ASSERT_TRUE(find_metric(snapshot, "stat", "host-c") == NULL);
+    gfal2_metrics_snapshot_free(snapshot);
+}
+
+
+TEST_F(MetricsTest, testPrometheus)
+{
+    struct stat st;
+    GError *tmp_err = NULL;
+
+    ASSERT_EQ(0, gfal2_stat(context, "fake://host-d/path", &st, &tmp_err));
+
+    gfal2_metrics_snapshot_t snapshot = gfal2_metrics_snapshot();
+    char *text = gfal2_metrics_to_prometheus(snapshot);
+    ASSERT_TRUE(text != NULL);
+
+    EXPECT_TRUE(strstr(text, "# TYPE gfal2_operation_duration_seconds summary") != NULL);
+    EXPECT_TRUE(strstr(text,
+        "gfal2_operation_duration_seconds_count{plugin=\"" GFAL_FAKE_PLUGIN_NAME "\",operation=\"stat\",host=\"host-d\"} 1\n") != NULL);
+    EXPECT_TRUE(strstr(text,
+        "gfal2_operation_errors_total{plugin=\"" GFAL_FAKE_PLUGIN_NAME "\",operation=\"stat\",host=\"host-d\"} 0\n") != NULL);
+
+    g_free(text);
+    gfal2_metrics_snapshot_free(snapshot);
+}
+
+
+static void *stat_thread(void *ptr)
+{
+    gfal2_context_t context = (gfal2_context_t)ptr;
+    struct stat st;
+    GError *tmp_err = NULL;
+    for (int i = 0; i < 5; ++i) {
+        gfal2_stat(context, "fake://host-e/path", &st, &tmp_err);
+    }
+    gfal2_stat(context, "fake://host-e/missing", &st, &tmp_err);
+    g_clear_error(&tmp_err);
+    return NULL;
+}
+
+
+// Each thread records into its own shard, merged by the snapshot,
+// and what a thread recorded remains once it has exited
+TEST_F(MetricsTest, testThreads)
+{
+    const int nthreads = 4;
+    pthread_t threads[nthreads];
+
+    for (int i = 0; i < nthreads; ++i) {
+        ASSERT_EQ(0, pthread_create(&threads[i], NULL, stat_thread, context));
+    }
+    for (int i = 0; i < nthreads; ++i) {
+        pthread_join(threads[i], NULL);
+    }
+
+    gfal2_metrics_snapshot_t snapshot = gfal2_metrics_snapshot();
+    const gfal2_metric_t *metric = find_metric(snapshot, "stat", "host-e");
+    ASSERT_TRUE(metric != NULL);
+    EXPECT_EQ(6u * nthreads, metric->count);
+    EXPECT_EQ((guint64)nthreads, metric->errors);
+    EXPECT_GE(metric->sum_usec, 5000u * nthreads);
+    gfal2_metrics_snapshot_free(snapshot);
+
+    // The shards of the threads gone are reused
+    pthread_t thread;
+    ASSERT_EQ(0, pthread_create(&thread, NULL, stat_thread, context));
+    pthread_join(thread, NULL);
+
+    snapshot = gfal2_metrics_snapshot();
+    metric = find_metric(snapshot, "stat", "host-e");
+    ASSERT_TRUE(metric != NULL);
+    EXPECT_EQ(6u * (nthreads + 1), metric->count);
+    gfal2_metrics_snapshot_free(snapshot);
+
+    // And cleared by a reset
+    gfal2_metrics_reset();
+    snapshot = gfal2_metrics_snapshot();
+    metric = find_metric(snapshot, "stat", "host-e");
+    ASSERT_TRUE(metric != NULL);
+    EXPECT_EQ(0u, metric->count);
+    EXPECT_EQ(0u, metric->errors);
+    gfal2_metrics_snapshot_free(snapshot);
+}
@@ -0,0 +1,322 @@
+/*
+ * Copyright (c) CERN 2016
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gfal_api.h>
+#include <gtest/gtest.h>
+#include <common/gfal_gtest_asserts.h>
+#include <transfer/gfal_transfer.h>
+#include <errno.h>
+#include <pthread.h>
+#include <string>
+#include <vector>
+
+extern "C" {
+#include "plugins/mock/gfal_mock_plugin.h"
+#include "utils/checksums/checksums.h"
+}
+
+// Straightforward implementations, to check the block by block ones of the plugin
+static guint32 reference_adler32(const std::vector<unsigned char>& data)
+{
+    guint32 a = 1, b = 0;
+    for (size_t i = 0; i < data.size(); ++i) {
+        a = (a + data[i]) % 65521;
+        b = (b + a) % 65521;
+    }
+    return (b << 16) | a;
+}
+
+
+static guint32 reference_crc32(const std::vector<unsigned char>& data)
+{
+    guint32 crc = 0xFFFFFFFF;
+    for (size_t i = 0; i < data.size(); ++i) {
+        crc ^= data[i];
+        for (int j = 0; j < 8; ++j) {
+            crc = (crc & 1) ? (0xEDB88320 ^ (crc >> 1)) : (crc >> 1);
+        }
+    }
+    return ~crc;
+}
+
+
+static std::string reference_md5(const std::vector<unsigned char>& data)
+{
+    GFAL_MD5_CTX ctx;
+    unsigned char digest[16];
+    char hex[33];
+    gfal2_md5_init(&ctx);
+    gfal2_md5_update(&ctx, data.data(), data.size());
+    gfal2_md5_final(digest, &ctx);
+    gfal2_md5_to_hex_string(digest, hex, sizeof(hex));
+    return hex;
+}
+
+
+static std::vector<unsigned char> mock_content(guint64 seed, off_t offset, size_t count)
+{
+    std::vector<unsigned char> data(count);
+    gfal_plugin_mock_fill(seed, offset, data.data(), count);
+    return data;
+}
+
+
+static std::string mock_checksum(guint64 seed, off_t size, const char* type,
+    off_t offset, size_t length)
+{
+    char buffer[64] = {0};
+    GError* error = NULL;
+    int ret = gfal_plugin_mock_data_checksum(seed, size, type, offset, length,
+        buffer, sizeof(buffer), &error);
+    EXPECT_PRED_FORMAT2(AssertGfalSuccess, ret, error);
+    g_clear_error(&error);
+    return buffer;
+}
+
+
+TEST(MockChecksum, ReferenceVectors)
+{
+    std::string check("123456789");
+    std::vector<unsigned char> data(check.begin(), check.end());
+    ASSERT_EQ(0x091E01DEu, reference_adler32(data));
+    ASSERT_EQ(0xCBF43926u, reference_crc32(data));
+}
+
+
+TEST(MockChecksum, WholeFile)
+{
+    // Larger than a generation block, and not a multiple of a word
+    const guint64 seed = 42;
+    const off_t size = 600 * 1024 + 3;
+    std::vector<unsigned char> data = mock_content(seed, 0, size);
+
+    char expected[64];
+    g_snprintf(expected, sizeof(expected), "%08x", reference_adler32(data));
+    ASSERT_EQ(expected, mock_checksum(seed, size, "adler32", 0, 0));
+    ASSERT_EQ(expected, mock_checksum(seed, size, "ADLER32", 0, 0));
+
+    g_snprintf(expected, sizeof(expected), "%u", reference_crc32(data));
+    ASSERT_EQ(expected, mock_checksum(seed, size, "crc32", 0, 0));
+
+    ASSERT_EQ(reference_md5(data), mock_checksum(seed, size, "md5", 0, 0));
+}
+
+
+TEST(MockChecksum, Range)
+{
+    const guint64 seed = 7;
+    const off_t size = 300 * 1024;
+    char expected[64];
+
+    // Unaligned range inside the file
+    std::vector<unsigned char> data = mock_content(seed, 1001, 200 * 1024);
+    g_snprintf(expected, sizeof(expected), "%08x", reference_adler32(data));
+    ASSERT_EQ(expected, mock_checksum(seed, size, "adler32", 1001, 200 * 1024));
+
+    // A length past the end stops at the end
+    data = mock_content(seed, 5, size - 5);
+    g_snprintf(expected, sizeof(expected), "%08x", reference_adler32(data));
+    ASSERT_EQ(expected, mock_checksum(seed, size, "adler32", 5, size));
+
+    // Empty range
+    ASSERT_EQ("00000001", mock_checksum(seed, size, "adler32", size, 0));
+}
+
+
+TEST(MockChecksum, Errors)
+{
+    char buffer[64] = {0};
+    GError* error = NULL;
+
+    int ret = gfal_plugin_mock_data_checksum(1, 100, "sha1", 0, 0, buffer, sizeof(buffer), &error);
+    ASSERT_PRED_FORMAT3(AssertGfalErrno, ret, error, ENOTSUP);
+    g_clear_error(&error);
+
+    ret = gfal_plugin_mock_data_checksum(1, 100, "adler32", 101, 0, buffer, sizeof(buffer), &error);
+    ASSERT_PRED_FORMAT3(AssertGfalErrno, ret, error, EINVAL);
+    g_clear_error(&error);
+
+    ret = gfal_plugin_mock_data_checksum(1, 100, "md5", 0, 0, buffer, 16, &error);
+    ASSERT_PRED_FORMAT3(AssertGfalErrno, ret, error, ENOBUFS);
+    g_clear_error(&error);
+
+    // The type is never guessed
+    ret = gfal_plugin_mock_get_checksum("mock://host/path?size=100&checksum=data", "",
+        0, 0, buffer, sizeof(buffer), &error);
+    ASSERT_PRED_FORMAT3(AssertGfalErrno, ret, error, EINVAL);
+    g_clear_error(&error);
+}
+
+
+static MockPluginData mock_data(long long max_connections, int connection_timeout)
+{
+    MockPluginData mdata;
+    memset(&mdata, 0, sizeof(mdata));
+    mdata.max_connections = max_connections;
+    mdata.connection_timeout = connection_timeout;
+    return mdata;
+}
+
+
+TEST(MockConnections, Limit)
+{
+    MockPluginData mdata = mock_data(0, 0);
+    const char* url = "mock://limit.example.com/path?max_connections=2";
+    GError* error = NULL;
+
+    ASSERT_EQ(0, gfal_plugin_mock_connection_acquire(&mdata, url, &error));
+    ASSERT_EQ(0, gfal_plugin_mock_connection_acquire(&mdata, url, &error));
+
+    // Host full, no time to wait
+    int ret = gfal_plugin_mock_connection_acquire(&mdata, url, &error);
+    ASSERT_PRED_FORMAT3(AssertGfalErrno, ret, error, EAGAIN);
+    g_clear_error(&error);
+
+    // Other hosts are counted apart
+    ASSERT_EQ(0, gfal_plugin_mock_connection_acquire(&mdata,
+        "mock://other.example.com/path?max_connections=2", &error));
+    gfal_plugin_mock_connection_release("mock://other.example.com/path");
+
+    gfal_plugin_mock_connection_release(url);
+    ASSERT_EQ(0, gfal_plugin_mock_connection_acquire(&mdata, url, &error));
+
+    gfal_plugin_mock_connection_release(url);
+    gfal_plugin_mock_connection_release(url);
+}
+
+
+TEST(MockConnections, DefaultLimit)
+{
+    MockPluginData mdata = mock_data(1, 0);
+    const char* url = "mock://default.example.com/path";
+    GError* error = NULL;
+
+    ASSERT_EQ(0, gfal_plugin_mock_connection_acquire(&mdata, url, &error));
+    int ret = gfal_plugin_mock_connection_acquire(&mdata, url, &error);
+    ASSERT_PRED_FORMAT3(AssertGfalErrno, ret, error, EAGAIN);
+    g_clear_error(&error);
+    gfal_plugin_mock_connection_release(url);
+
+    // No limit
+    mdata.max_connections = 0;
+    for (int i = 0; i < 10; ++i) {
+        ASSERT_EQ(0, gfal_plugin_mock_connection_acquire(&mdata, url, &error));
+    }
+    for (int i = 0; i < 10; ++i) {
+        gfal_plugin_mock_connection_release(url);
+    }
+}
+
+
+static void* release_later(void* url)
+{
+    g_usleep(100000);
+    gfal_plugin_mock_connection_release(static_cast<const char*>(url));
+    return NULL;
+}
+
+
+TEST(MockConnections, WaitForRelease)
+{
+    MockPluginData mdata = mock_data(1, 10);
+    const char* url = "mock://wait.example.com/path";
+    GError* error = NULL;
+
+    ASSERT_EQ(0, gfal_plugin_mock_connection_acquire(&mdata, url, &error));
+
+    pthread_t releaser;
+    pthread_create(&releaser, NULL, release_later, const_cast<char*>(url));
+    int ret = gfal_plugin_mock_connection_acquire(&mdata, url, &error);
+    pthread_join(releaser, NULL);
+    ASSERT_PRED_FORMAT2(AssertGfalSuccess, ret, error);
+
+    gfal_plugin_mock_connection_release(url);
+}
+
+
+class MockCopyTest : public testing::Test {
+protected:
+    gfal2_context_t context;
+    gfalt_params_t params;
+    MockPluginData mdata;
+
+public:
+    MockCopyTest() {
+        GError* error = NULL;
+        context = gfal2_context_new(&error);
+        params = gfalt_params_handle_new(&error);
+        mdata = mock_data(0, 0);
+        mdata.handle = context;
+    }
+
+    ~MockCopyTest() {
+        gfalt_params_handle_delete(params, NULL);
+        gfal2_context_free(context);
+    }
+};
+
+
+TEST_F(MockCopyTest, TransferErrnoFailsUpFront)
+{
+    GError* error = NULL;
+    gint64 start = g_get_monotonic_time();
+
+    int ret = gfal_plugin_mock_filecopy(&mdata, context, params,
+        "mock://copy.example.com/src?size=100&max_connections=1",
+        "mock://copy.example.com/dst?time=10&transfer_errno=5", &error);
+    ASSERT_PRED_FORMAT3(AssertGfalErrno, ret, error, EIO);
+    g_clear_error(&error);
+    ASSERT_LT(g_get_monotonic_time() - start, G_USEC_PER_SEC);
+
+    // Even an instant copy fails
+    ret = gfal_plugin_mock_filecopy(&mdata, context, params,
+        "mock://copy.example.com/src?size=100",
+        "mock://copy.example.com/dst?time=0&transfer_errno=28", &error);
+    ASSERT_PRED_FORMAT3(AssertGfalErrno, ret, error, ENOSPC);
+    g_clear_error(&error);
+
+    // No connection is left behind
+    ret = gfal_plugin_mock_connection_acquire(&mdata,
+        "mock://copy.example.com/src?max_connections=1", &error);
+    ASSERT_PRED_FORMAT2(AssertGfalSuccess, ret, error);
+    gfal_plugin_mock_connection_release("mock://copy.example.com/src");
+}
+
+
+TEST_F(MockCopyTest, ChecksumTypeRequired)
+{
+    GError* error = NULL;
+    gfalt_set_checksum(params, GFALT_CHECKSUM_BOTH, NULL, NULL, NULL);
+
+    int ret = gfal_plugin_mock_filecopy(&mdata, context, params,
+        "mock://copy.example.com/src?size=100&checksum=data",
+        "mock://copy.example.com/dst?time=0&checksum=data&size=100", &error);
+    ASSERT_PRED_FORMAT3(AssertGfalErrno, ret, error, EINVAL);
+    g_clear_error(&error);
+
+    // A literal checksum does not need it
+    ret = gfal_plugin_mock_filecopy(&mdata, context, params,
+        "mock://copy.example.com/src?size=100&checksum=abcd",
+        "mock://copy.example.com/dst?time=0&checksum=abcd&size=100", &error);
+    ASSERT_PRED_FORMAT2(AssertGfalSuccess, ret, error);
+
+    // With a type, the data checksums of both ends match
+    gfalt_set_checksum(params, GFALT_CHECKSUM_BOTH, "adler32", NULL, NULL);
+    ret = gfal_plugin_mock_filecopy(&mdata, context, params,
+        "mock://copy.example.com/src?size=100&checksum=data&seed=3",
+        "mock://copy.example.com/dst?time=0&checksum=data&size=100&seed=3", &error);
+    ASSERT_PRED_FORMAT2(AssertGfalSuccess, ret, error);
+}
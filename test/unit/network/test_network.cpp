@@ -0,0 +1,215 @@
+/*
+ * Copyright (c) CERN 2013-2017
+ *
+ * Copyright (c) Members of the EMI Collaboration. 2010-2013
+ *  See  http://www.eu-emi.eu/partners for details on the copyright
+ *  holders.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <network/gfal2_network.h>
+#include <string.h>
+#include <stdlib.h>
+#include <errno.h>
+
+
+// Fake resolver: the answers are those of the system, in the order of a resolver
+// returning IPv4 first, so the tests do not depend on the network nor on /etc/hosts
+static int lookups = 0;
+
+static struct addrinfo* fake_addrinfo(int family, const char* address, struct addrinfo* next)
+{
+    struct addrinfo* ai = (struct addrinfo*) calloc(1, sizeof(struct addrinfo));
+    ai->ai_family = family;
+    ai->ai_socktype = SOCK_STREAM;
+    ai->ai_next = next;
+    if (family == AF_INET6) {
+        struct sockaddr_in6* sin6 = (struct sockaddr_in6*) calloc(1, sizeof(struct sockaddr_in6));
+        sin6->sin6_family = AF_INET6;
+        inet_pton(AF_INET6, address, &sin6->sin6_addr);
+        ai->ai_addr = (struct sockaddr*) sin6;
+        ai->ai_addrlen = sizeof(*sin6);
+    }
+    else {
+        struct sockaddr_in* sin = (struct sockaddr_in*) calloc(1, sizeof(struct sockaddr_in));
+        sin->sin_family = AF_INET;
+        inet_pton(AF_INET, address, &sin->sin_addr);
+        ai->ai_addr = (struct sockaddr*) sin;
+        ai->ai_addrlen = sizeof(*sin);
+    }
+    return ai;
+}
+
+
+static int fake_getaddrinfo(const char* node, const char* service, const struct addrinfo* hints,
+    struct addrinfo** res)
+{
+    struct in6_addr addr6;
+    struct in_addr addr4;
+
+    ++lookups;
+    *res = NULL;
+    if (strcmp(node, "dualstack.cern.ch") == 0) {
+        *res = fake_addrinfo(AF_INET6, "2001:db8::2", NULL);
+        *res = fake_addrinfo(AF_INET6, "2001:db8::1", *res);
+        *res = fake_addrinfo(AF_INET, "192.0.2.3", *res);
+        *res = fake_addrinfo(AF_INET, "192.0.2.2", *res);
+        *res = fake_addrinfo(AF_INET, "192.0.2.1", *res);
+    }
+    else if (strcmp(node, "v6only.cern.ch") == 0) {
+        *res = fake_addrinfo(AF_INET6, "2001:db8::1", NULL);
+    }
+    else if (inet_pton(AF_INET6, node, &addr6) == 1) {
+        *res = fake_addrinfo(AF_INET6, node, NULL);
+    }
+    else if (inet_pton(AF_INET, node, &addr4) == 1) {
+        *res = fake_addrinfo(AF_INET, node, NULL);
+    }
+    return *res ? 0 : EAI_NONAME;
+}
+
+
+static void fake_freeaddrinfo(struct addrinfo* res)
+{
+    while (res) {
+        struct addrinfo* next = res->ai_next;
+        free(res->ai_addr);
+        free(res);
+        res = next;
+    }
+}
+
+
+// Only the IPv4 addresses have a reverse entry
+static int fake_getnameinfo(const struct sockaddr* addr, socklen_t addrlen, char* host, socklen_t hostlen,
+    char* serv, socklen_t servlen, int flags)
+{
+    if (addr->sa_family != AF_INET)
+        return EAI_NONAME;
+    snprintf(host, hostlen, "node.cern.ch");
+    return 0;
+}
+
+
+class NetworkTest: public testing::Test {
+public:
+    struct gfal2_dns_resolver system_resolver;
+
+    void SetUp() {
+        system_resolver = gfal2_dns_resolver_call;
+        gfal2_dns_resolver_call.getaddrinfo = fake_getaddrinfo;
+        gfal2_dns_resolver_call.freeaddrinfo = fake_freeaddrinfo;
+        gfal2_dns_resolver_call.getnameinfo = fake_getnameinfo;
+        gfal2_dns_cache_set_ttl(60, 10);
+        gfal2_dns_cache_clear();
+        lookups = 0;
+    }
+
+    void TearDown() {
+        gfal2_dns_cache_clear();
+        gfal2_dns_resolver_call = system_resolver;
+    }
+};
+
+
+TEST_F(NetworkTest, resolveCached)
+{
+    gfal2_dns_address addresses[GFAL2_DNS_MAX_ADDRESSES];
+
+    int count = gfal2_resolve_dns("dualstack.cern.ch", addresses, GFAL2_DNS_MAX_ADDRESSES);
+    ASSERT_EQ(5, count);
+    EXPECT_EQ(1, lookups);
+
+    // Served from the cache
+    gfal2_dns_address cached[GFAL2_DNS_MAX_ADDRESSES];
+    ASSERT_EQ(count, gfal2_resolve_dns("dualstack.cern.ch", cached, GFAL2_DNS_MAX_ADDRESSES));
+    for (int i = 0; i < count; ++i) {
+        ASSERT_STREQ(addresses[i].address, cached[i].address);
+    }
+    EXPECT_EQ(1, lookups);
+
+    // Only as many as asked for
+    ASSERT_EQ(2, gfal2_resolve_dns("dualstack.cern.ch", cached, 2));
+}
+
+
+TEST_F(NetworkTest, resolveNumeric)
+{
+    gfal2_dns_address addresses[GFAL2_DNS_MAX_ADDRESSES];
+
+    ASSERT_EQ(1, gfal2_resolve_dns("127.0.0.1", addresses, GFAL2_DNS_MAX_ADDRESSES));
+    ASSERT_EQ(AF_INET, addresses[0].family);
+    ASSERT_STREQ("127.0.0.1", addresses[0].address);
+
+    ASSERT_EQ(1, gfal2_resolve_dns("::1", addresses, GFAL2_DNS_MAX_ADDRESSES));
+    ASSERT_EQ(AF_INET6, addresses[0].family);
+    ASSERT_STREQ("::1", addresses[0].address);
+}
+
+
+TEST_F(NetworkTest, resolveOrder)
+{
+    gfal2_dns_address addresses[GFAL2_DNS_MAX_ADDRESSES];
+
+    // The resolver answers IPv4 first: IPv6 must come first anyway, then the families interleaved
+    ASSERT_EQ(5, gfal2_resolve_dns("dualstack.cern.ch", addresses, GFAL2_DNS_MAX_ADDRESSES));
+    const char* expected[] = {"2001:db8::1", "192.0.2.1", "2001:db8::2", "192.0.2.2", "192.0.2.3"};
+    const int families[] = {AF_INET6, AF_INET, AF_INET6, AF_INET, AF_INET};
+    for (int i = 0; i < 5; ++i) {
+        EXPECT_EQ(families[i], addresses[i].family) << i;
+        EXPECT_STREQ(expected[i], addresses[i].address) << i;
+    }
+}
+
+
+TEST_F(NetworkTest, resolveFailure)
+{
+    gfal2_dns_address addresses[GFAL2_DNS_MAX_ADDRESSES];
+
+    ASSERT_EQ(-1, gfal2_resolve_dns("does-not-exist.invalid", addresses, GFAL2_DNS_MAX_ADDRESSES));
+    // Negative entry
+    ASSERT_EQ(-1, gfal2_resolve_dns("does-not-exist.invalid", addresses, GFAL2_DNS_MAX_ADDRESSES));
+    EXPECT_EQ(1, lookups);
+}
+
+
+TEST_F(NetworkTest, resolveToHostname)
+{
+    // No reverse entry: the IPv6 address is bracketed, so it can go back into a url
+    char* resolved = gfal2_resolve_dns_to_hostname("v6only.cern.ch");
+    ASSERT_STREQ("[2001:db8::1]", resolved);
+    free(resolved);
+
+    // Bracketed literals, as found in the urls, are resolved too
+    resolved = gfal2_resolve_dns_to_hostname("[2001:db8::1]");
+    ASSERT_STREQ("[2001:db8::1]", resolved);
+    free(resolved);
+
+    resolved = gfal2_resolve_dns_to_hostname("192.0.2.1");
+    ASSERT_STREQ("node.cern.ch", resolved);
+    free(resolved);
+}
+
+
+TEST_F(NetworkTest, resolveUrl)
+{
+    char* resolved = resolve_dns_helper("gsiftp://v6only.cern.ch:2811/path/file", "Resolving");
+    ASSERT_STREQ("gsiftp://[2001:db8::1]:2811/path/file", resolved);
+    g_free(resolved);
+
+    resolved = resolve_dns_helper("gsiftp://[2001:db8::1]:2811/path/file", "Resolving");
+    ASSERT_STREQ("gsiftp://[2001:db8::1]:2811/path/file", resolved);
+    g_free(resolved);
+}
@@ -0,0 +1,200 @@
+/*
+ * Copyright (c) CERN 2013-2017
+ *
+ * Copyright (c) Members of the EMI Collaboration. 2010-2013
+ *  See  http://www.eu-emi.eu/partners for details on the copyright
+ *  holders.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gfal_api.h>
+#include <gfal_plugins_api.h>
+#include <gtest/gtest.h>
+#include <pthread.h>
+#include <vector>
+
+
+class PollSchedulerTest: public testing::Test {
+public:
+    gfal2_context_t context;
+
+    PollSchedulerTest() {
+        context = gfal2_context_new(NULL);
+    }
+
+    virtual ~PollSchedulerTest() {
+        gfal2_context_free(context);
+    }
+
+    // Ends a poll reporting the first file ready, and the others still pending
+    void end_poll(const char* endpoint, const char* token, char** keys) {
+        int n = g_strv_length(keys);
+        std::vector<GError*> statuses(n, (GError*)NULL);
+        for (int i = 0; i < n; ++i) {
+            if (i > 0)
+                gfal2_set_error(&statuses[i], g_quark_from_static_string("poll"), EAGAIN, __func__, "queued");
+        }
+        gfal2_poll_end(endpoint, token, n, keys, statuses.data());
+        for (int i = 0; i < n; ++i)
+            g_clear_error(&statuses[i]);
+    }
+};
+
+
+TEST_F(PollSchedulerTest, CoalesceFiles)
+{
+    GError* error = NULL;
+    char** poll_keys = NULL;
+    const char* files[] = {"/a", "/b", "/c"};
+
+    gfal2_poll_register("coalesce.cern.ch", "token", 3, files);
+
+    // A poll of one file includes the other pending files of the request
+    ASSERT_EQ(1, gfal2_poll_begin(context, "coalesce.cern.ch", "token", 60, 60, 1, files + 1, &poll_keys, &error));
+    ASSERT_EQ(NULL, error);
+    ASSERT_EQ(3, g_strv_length(poll_keys));
+    EXPECT_STREQ("/b", poll_keys[0]);
+    end_poll("coalesce.cern.ch", "token", poll_keys);
+
+    // The status of the other files comes from the last poll
+    EXPECT_EQ(0, gfal2_poll_begin(context, "coalesce.cern.ch", "token", 60, 60, 3, files, NULL, &error));
+    int ready = 0, pending = 0;
+    for (int i = 0; i < 3; ++i) {
+        if (gfal2_poll_status("coalesce.cern.ch", "token", poll_keys[i], &error) == 0) {
+            ++ready;
+        }
+        else {
+            EXPECT_EQ(EAGAIN, error->code);
+            g_clear_error(&error);
+            ++pending;
+        }
+    }
+    EXPECT_EQ(1, ready);
+    EXPECT_EQ(2, pending);
+    g_strfreev(poll_keys);
+}
+
+
+TEST_F(PollSchedulerTest, NewFileIsDue)
+{
+    GError* error = NULL;
+    char** poll_keys = NULL;
+    const char* first[] = {"/a"};
+    const char* second[] = {"/b"};
+
+    ASSERT_EQ(1, gfal2_poll_begin(context, "new.cern.ch", "token", 60, 60, 1, first, &poll_keys, &error));
+    end_poll("new.cern.ch", "token", poll_keys);
+    g_strfreev(poll_keys);
+
+    // Ready files are never polled again
+    EXPECT_EQ(0, gfal2_poll_begin(context, "new.cern.ch", "token", 60, 60, 1, first, NULL, &error));
+    EXPECT_EQ(0, gfal2_poll_status("new.cern.ch", "token", "/a", &error));
+
+    EXPECT_EQ(1, gfal2_poll_begin(context, "new.cern.ch", "token", 60, 60, 1, second, NULL, &error));
+    gfal2_poll_end("new.cern.ch", "token", 0, NULL, NULL);
+
+    // The status call failed, so the file has no status yet
+    EXPECT_EQ(-1, gfal2_poll_status("new.cern.ch", "token", "/b", &error));
+    ASSERT_NE((void*)NULL, error);
+    EXPECT_EQ(EAGAIN, error->code);
+    g_clear_error(&error);
+}
+
+
+TEST_F(PollSchedulerTest, Interval)
+{
+    GError* error = NULL;
+    char** poll_keys = NULL;
+    const char* files[] = {"/a", "/b"};
+
+    ASSERT_EQ(1, gfal2_poll_begin(context, "interval.cern.ch", "token", 1, 1, 2, files, &poll_keys, &error));
+    end_poll("interval.cern.ch", "token", poll_keys);
+    g_strfreev(poll_keys);
+
+    EXPECT_EQ(0, gfal2_poll_begin(context, "interval.cern.ch", "token", 1, 1, 2, files, NULL, &error));
+    g_usleep(1100000);
+    EXPECT_EQ(1, gfal2_poll_begin(context, "interval.cern.ch", "token", 1, 1, 2, files, &poll_keys, &error));
+    // Only the pending file is polled
+    ASSERT_EQ(1, g_strv_length(poll_keys));
+    EXPECT_STREQ("/b", poll_keys[0]);
+    gfal2_poll_end("interval.cern.ch", "token", 0, NULL, NULL);
+    g_strfreev(poll_keys);
+
+    gfal2_poll_forget("interval.cern.ch", "token");
+    EXPECT_EQ(1, gfal2_poll_begin(context, "interval.cern.ch", "token", 1, 1, 2, files, NULL, &error));
+    gfal2_poll_end("interval.cern.ch", "token", 0, NULL, NULL);
+}
+
+
+static void* cancel_after_delay(void* data)
+{
+    g_usleep(200000);
+    gfal2_cancel((gfal2_context_t) data);
+    return NULL;
+}
+
+
+TEST_F(PollSchedulerTest, Budget)
+{
+    GError* error = NULL;
+    gfal2_endpoint_slot_t slot = NULL, other = NULL, extra = NULL;
+    pthread_t canceller;
+
+    gfal2_set_opt_integer(context, CORE_CONFIG_GROUP, "POLL_ENDPOINT_BUDGET", 1, NULL);
+
+    ASSERT_EQ(0, gfal2_poll_budget_acquire(context, "budget.cern.ch", &slot, &error));
+    ASSERT_NE((void*)NULL, slot);
+    // Other endpoints have their own budget
+    ASSERT_EQ(0, gfal2_poll_budget_acquire(context, "other.cern.ch", &other, &error));
+    gfal2_poll_budget_release(other);
+
+    // The budget is exhausted: the call waits until cancelled
+    pthread_create(&canceller, NULL, cancel_after_delay, context);
+    EXPECT_EQ(-1, gfal2_poll_budget_acquire(context, "budget.cern.ch", &extra, &error));
+    ASSERT_NE((void*)NULL, error);
+    EXPECT_EQ(ECANCELED, error->code);
+    g_clear_error(&error);
+    pthread_join(canceller, NULL);
+
+    gfal2_poll_budget_release(slot);
+    gfal2_context_free(context);
+    context = gfal2_context_new(NULL);
+    gfal2_set_opt_integer(context, CORE_CONFIG_GROUP, "POLL_ENDPOINT_BUDGET", 1, NULL);
+    EXPECT_EQ(0, gfal2_poll_budget_acquire(context, "budget.cern.ch", &slot, &error));
+    gfal2_poll_budget_release(slot);
+}
+
+
+TEST_F(PollSchedulerTest, BudgetPerEndpoint)
+{
+    GError* error = NULL;
+    gfal2_endpoint_slot_t slot = NULL, extra = NULL;
+
+    // The budget is shared with the admission of the endpoint, which can override it
+    gfal2_set_opt_integer(context, "ENDPOINT:OVERRIDE.CERN.CH", "POLL_ENDPOINT_BUDGET", 1, NULL);
+
+    // A full url and a bare host:port are the same endpoint
+    ASSERT_EQ(0, gfal2_poll_budget_acquire(context, "https://override.cern.ch:443/api", &slot, &error));
+    ASSERT_NE((void*)NULL, slot);
+    EXPECT_EQ(-1, gfal2_endpoint_slot_acquire(context, "test", "override.cern.ch:443",
+        "POLL_ENDPOINT_BUDGET", 16, 0, &extra, &error));
+    ASSERT_NE((void*)NULL, error);
+    EXPECT_EQ(EBUSY, error->code);
+    g_clear_error(&error);
+
+    gfal2_poll_budget_release(slot);
+    EXPECT_EQ(0, gfal2_endpoint_slot_acquire(context, "test", "override.cern.ch:443",
+        "POLL_ENDPOINT_BUDGET", 16, 0, &extra, &error));
+    gfal2_endpoint_slot_release(extra);
+}
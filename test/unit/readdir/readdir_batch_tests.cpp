@@ -0,0 +1,207 @@
+/*
+ * Copyright (c) CERN 2013-2017
+ *
+ * Copyright (c) Members of the EMI Collaboration. 2010-2013
+ *  See  http://www.eu-emi.eu/partners for details on the copyright
+ *  holders.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gfal_api.h>
+#include <gfal_plugins_api.h>
+#include <gtest/gtest.h>
+
+#define BATCH_PLUGIN_NAME "BATCH PLUGIN"
+#define BATCH_DIR_SIZE 5
+
+
+static int readdirpp_calls = 0;
+static int readdir_batch_calls = 0;
+static int dir_entries = 0;
+
+
+static const char *batch_plugin_get_name(void)
+{
+    return BATCH_PLUGIN_NAME;
+}
+
+
+static gboolean batch_plugin_url(plugin_handle plugin_data, const char *url,
+    plugin_mode operation, GError **err)
+{
+    return strncmp(url, "batch://", 8) == 0;
+}
+
+
+static gfal_file_handle batch_plugin_opendir(plugin_handle plugin_data, const char *url, GError **err)
+{
+    dir_entries = 0;
+    return gfal_file_handle_new2(BATCH_PLUGIN_NAME, NULL, NULL, url);
+}
+
+
+static void batch_plugin_entry(struct dirent *entry, struct stat *st)
+{
+    ++dir_entries;
+    memset(entry, 0, sizeof(*entry));
+    snprintf(entry->d_name, sizeof(entry->d_name), "file%d", dir_entries);
+    memset(st, 0, sizeof(*st));
+    st->st_mode = S_IFREG | 0644;
+    st->st_size = 100 + dir_entries;
+}
+
+
+static struct dirent *batch_plugin_readdirpp(plugin_handle plugin_data, gfal_file_handle fh,
+    struct stat *st, GError **err)
+{
+    static struct dirent entry;
+    ++readdirpp_calls;
+    if (strstr(gfal_file_handle_get_path(fh), "broken") && dir_entries == 1) {
+        gfal2_set_error(err, g_quark_from_static_string("batch"), EIO, __func__, "Broken listing");
+        return NULL;
+    }
+    if (dir_entries >= BATCH_DIR_SIZE)
+        return NULL;
+    batch_plugin_entry(&entry, st);
+    return &entry;
+}
+
+
+static ssize_t batch_plugin_readdir_batch(plugin_handle plugin_data, gfal_file_handle fh,
+    gfal2_dir_entry_t *entries, size_t nentries, GError **err)
+{
+    size_t i;
+    ++readdir_batch_calls;
+    for (i = 0; i < nentries && dir_entries < BATCH_DIR_SIZE; ++i)
+        batch_plugin_entry(&entries[i].dirent, &entries[i].st);
+    return i;
+}
+
+
+static int batch_plugin_closedir(plugin_handle plugin_data, gfal_file_handle fh, GError **err)
+{
+    gfal_file_handle_delete(fh);
+    return 0;
+}
+
+
+class ReaddirBatchTest: public testing::Test {
+public:
+    gfal2_context_t context;
+    gfal_plugin_interface plugin;
+
+    void SetUp() {
+        context = NULL;
+        memset(&plugin, 0, sizeof(plugin));
+        plugin.getName = batch_plugin_get_name;
+        plugin.check_plugin_url = batch_plugin_url;
+        plugin.opendirG = batch_plugin_opendir;
+        plugin.readdirppG = batch_plugin_readdirpp;
+        plugin.closedirG = batch_plugin_closedir;
+        readdirpp_calls = readdir_batch_calls = 0;
+    }
+
+    void Register() {
+        GError *tmp_err = NULL;
+        context = gfal2_context_new(&tmp_err);
+        ASSERT_TRUE(context != NULL);
+        ASSERT_EQ(0, gfal2_register_plugin(context, &plugin, &tmp_err));
+    }
+
+    void TearDown() {
+        if (context)
+            gfal2_context_free(context);
+    }
+
+    // List the whole directory, two entries at a time
+    void ListAll() {
+        GError *tmp_err = NULL;
+        gfal2_dir_entry_t entries[2];
+
+        DIR *dir = gfal2_opendir(context, "batch://host/dir", &tmp_err);
+        ASSERT_TRUE(dir != NULL);
+
+        int total = 0;
+        ssize_t n;
+        while ((n = gfal2_readdir_batch(context, dir, entries, 2, &tmp_err)) > 0) {
+            for (ssize_t i = 0; i < n; ++i) {
+                ++total;
+                char expected[32];
+                snprintf(expected, sizeof(expected), "file%d", total);
+                ASSERT_STREQ(expected, entries[i].dirent.d_name);
+                ASSERT_EQ(100 + total, entries[i].st.st_size);
+            }
+        }
+        ASSERT_EQ(0, n);
+        ASSERT_TRUE(tmp_err == NULL);
+        ASSERT_EQ(BATCH_DIR_SIZE, total);
+        ASSERT_EQ(0, gfal2_closedir(context, dir, &tmp_err));
+    }
+};
+
+
+TEST_F(ReaddirBatchTest, testNative)
+{
+    plugin.readdir_batchG = batch_plugin_readdir_batch;
+    Register();
+    ListAll();
+    ASSERT_EQ(0, readdirpp_calls);
+    ASSERT_EQ(4, readdir_batch_calls);
+}
+
+
+TEST_F(ReaddirBatchTest, testFallback)
+{
+    Register();
+    ListAll();
+    // One call per entry, plus the end of the listing seen by the last two batches
+    ASSERT_EQ(BATCH_DIR_SIZE + 2, readdirpp_calls);
+}
+
+
+TEST_F(ReaddirBatchTest, testFallbackError)
+{
+    GError *tmp_err = NULL;
+    gfal2_dir_entry_t entries[2];
+
+    Register();
+    DIR *dir = gfal2_opendir(context, "batch://host/broken", &tmp_err);
+    ASSERT_TRUE(dir != NULL);
+    ASSERT_EQ(-1, gfal2_readdir_batch(context, dir, entries, 2, &tmp_err));
+    ASSERT_TRUE(tmp_err != NULL);
+    ASSERT_EQ(EIO, tmp_err->code);
+    g_clear_error(&tmp_err);
+    ASSERT_EQ(0, gfal2_closedir(context, dir, &tmp_err));
+}
+
+
+TEST_F(ReaddirBatchTest, testInvalid)
+{
+    GError *tmp_err = NULL;
+    gfal2_dir_entry_t entries[1];
+
+    Register();
+    DIR *dir = gfal2_opendir(context, "batch://host/dir", &tmp_err);
+    ASSERT_TRUE(dir != NULL);
+
+    ASSERT_EQ(-1, gfal2_readdir_batch(context, dir, entries, 0, &tmp_err));
+    ASSERT_EQ(EINVAL, tmp_err->code);
+    g_clear_error(&tmp_err);
+
+    ASSERT_EQ(-1, gfal2_readdir_batch(context, dir, NULL, 1, &tmp_err));
+    ASSERT_EQ(EFAULT, tmp_err->code);
+    g_clear_error(&tmp_err);
+
+    ASSERT_EQ(0, gfal2_closedir(context, dir, &tmp_err));
+}
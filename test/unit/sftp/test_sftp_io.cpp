@@ -0,0 +1,387 @@
+/*
+ * Copyright (c) CERN 2016
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gfal_api.h>
+#include <gtest/gtest.h>
+#include <common/gfal_gtest_asserts.h>
+#include <utils/exceptions/gerror_to_cpp.h>
+#include <fcntl.h>
+#include <string>
+#include <gfal_plugins_api.h>
+
+#include <libssh2.h>
+#include <libssh2_sftp.h>
+
+extern "C" {
+#include "plugins/sftp/gfal_sftp_plugin.h"
+#include "plugins/sftp/gfal_sftp_connection.h"
+}
+
+// The IO layer is tested against an in-memory file, served by fake libssh2 and connection calls.
+// Non-blocking reads alternate between EAGAIN and data, which is how the requests still in flight
+// look to the read-ahead.
+
+struct _LIBSSH2_SESSION {
+    int blocking;
+};
+
+struct _LIBSSH2_SFTP {
+    int unused;
+};
+
+struct _LIBSSH2_SFTP_HANDLE {
+    size_t offset;
+    bool pending;
+    char *pending_buffer;
+    size_t pending_len;
+    bool eagain_next;
+};
+
+// Largest answer to a read, so the read-ahead needs several of them
+static const size_t fake_chunk = 7000;
+
+static LIBSSH2_SESSION fake_session;
+static LIBSSH2_SFTP fake_sftp;
+static std::string fake_file;
+static bool fake_fail_writes = false;
+static int fake_eagain_count = 0;
+static int fake_retry_mismatches = 0;
+static int fake_connect_attempts = 0;
+
+
+static ssize_t fake_serve(LIBSSH2_SFTP_HANDLE *handle, char *buffer, size_t len)
+{
+    if (handle->offset >= fake_file.size()) {
+        return 0;
+    }
+    size_t n = std::min(std::min(len, fake_chunk), fake_file.size() - handle->offset);
+    fake_file.copy(buffer, n, handle->offset);
+    handle->offset += n;
+    return n;
+}
+
+
+ssize_t libssh2_sftp_read(LIBSSH2_SFTP_HANDLE *handle, char *buffer, size_t buffer_maxlen)
+{
+    if (handle->pending) {
+        // libssh2 requires the same buffer and length until the read completes
+        if (buffer != handle->pending_buffer || buffer_maxlen != handle->pending_len) {
+            ++fake_retry_mismatches;
+        }
+        handle->pending = false;
+        return fake_serve(handle, buffer, buffer_maxlen);
+    }
+    if (!fake_session.blocking) {
+        handle->eagain_next = !handle->eagain_next;
+        if (handle->eagain_next) {
+            handle->pending = true;
+            handle->pending_buffer = buffer;
+            handle->pending_len = buffer_maxlen;
+            ++fake_eagain_count;
+            return LIBSSH2_ERROR_EAGAIN;
+        }
+    }
+    return fake_serve(handle, buffer, buffer_maxlen);
+}
+
+
+ssize_t libssh2_sftp_write(LIBSSH2_SFTP_HANDLE *handle, const char *buffer, size_t count)
+{
+    if (fake_fail_writes) {
+        return LIBSSH2_ERROR_SFTP_PROTOCOL;
+    }
+    size_t n = std::min(count, fake_chunk);
+    if (fake_file.size() < handle->offset + n) {
+        fake_file.resize(handle->offset + n);
+    }
+    fake_file.replace(handle->offset, n, buffer, n);
+    handle->offset += n;
+    return n;
+}
+
+
+void libssh2_sftp_seek64(LIBSSH2_SFTP_HANDLE *handle, libssh2_uint64_t offset)
+{
+    handle->offset = offset;
+    handle->pending = false;
+}
+
+
+LIBSSH2_SFTP_HANDLE *libssh2_sftp_open_ex(LIBSSH2_SFTP *sftp, const char *filename, unsigned int filename_len,
+    unsigned long flags, long mode, int open_type)
+{
+    if (flags & LIBSSH2_FXF_TRUNC) {
+        fake_file.clear();
+    }
+    return new LIBSSH2_SFTP_HANDLE();
+}
+
+
+int libssh2_sftp_close_handle(LIBSSH2_SFTP_HANDLE *handle)
+{
+    delete handle;
+    return 0;
+}
+
+
+int libssh2_sftp_fstat_ex(LIBSSH2_SFTP_HANDLE *handle, LIBSSH2_SFTP_ATTRIBUTES *attrs, int setstat)
+{
+    attrs->filesize = fake_file.size();
+    return 0;
+}
+
+
+void libssh2_session_set_blocking(LIBSSH2_SESSION *session, int blocking)
+{
+    session->blocking = blocking;
+}
+
+
+GQuark gfal2_get_plugin_sftp_quark()
+{
+    return g_quark_from_static_string("FakeSFTP");
+}
+
+
+const char *gfal_sftp_plugin_get_name()
+{
+    return "FakeSFTP";
+}
+
+
+void gfal_plugin_sftp_translate_error(const char *func, gfal_sftp_handle_t *handle, GError **err)
+{
+    gfal2_set_error(err, gfal2_get_plugin_sftp_quark(), EIO, func, "Fake SFTP failure");
+}
+
+
+gfal_sftp_handle_t *gfal_sftp_connect(gfal_sftp_context_t *context, const char *url, GError **err)
+{
+    gfal_sftp_handle_t *handle = g_new0(gfal_sftp_handle_t, 1);
+    handle->ssh_session = &fake_session;
+    handle->sftp_session = &fake_sftp;
+    handle->path = "/file";
+    return handle;
+}
+
+
+gfal_sftp_handle_t *gfal_sftp_try_connect(gfal_sftp_context_t *context, const char *url, GError **err)
+{
+    ++fake_connect_attempts;
+    gfal2_set_error(err, gfal2_get_plugin_sftp_quark(), EBUSY, __func__, "No spare session");
+    return NULL;
+}
+
+
+void gfal_sftp_release(gfal_sftp_context_t *context, gfal_sftp_handle_t *handle)
+{
+    g_free(handle);
+}
+
+
+class SftpIoTest: public testing::Test {
+public:
+    SftpIoTest() {
+        GError *error = NULL;
+        data.gfal2_context = gfal2_context_new(&error);
+        Gfal::gerror_to_cpp(&error);
+        data.cache = NULL;
+        // One packet of read-ahead and write-behind
+        gfal2_set_opt_integer(data.gfal2_context, "SFTP PLUGIN", "PIPELINE_DEPTH", 1, NULL);
+        gfal2_set_opt_integer(data.gfal2_context, "SFTP PLUGIN", "STRIPE_THRESHOLD", 100000, NULL);
+    }
+
+    virtual ~SftpIoTest() {
+        gfal2_context_free(data.gfal2_context);
+    }
+
+    virtual void SetUp() {
+        fake_session.blocking = 1;
+        fake_file.clear();
+        for (size_t i = 0; i < 250000; ++i) {
+            fake_file.push_back((char)(i * 31 % 251));
+        }
+        fake_fail_writes = false;
+        fake_eagain_count = 0;
+        fake_retry_mismatches = 0;
+        fake_connect_attempts = 0;
+    }
+
+protected:
+    gfal_sftp_context_t data;
+
+    gfal_file_handle open(int flags) {
+        GError *error = NULL;
+        gfal_file_handle fd = gfal_sftp_open(&data, "sftp://host/file", flags, 0644, &error);
+        EXPECT_PRED_FORMAT2(AssertGfalSuccess, fd != NULL ? 0 : -1, error);
+        return fd;
+    }
+};
+
+
+TEST_F(SftpIoTest, SmallReadsRetryPendingRead)
+{
+    const std::string expected = fake_file;
+    gfal_file_handle fd = open(O_RDONLY);
+    ASSERT_TRUE(fd != NULL);
+
+    GError *error = NULL;
+    std::string got;
+    char buffer[1000];
+    ssize_t ret;
+    while ((ret = gfal_sftp_read(&data, fd, buffer, sizeof(buffer), &error)) > 0) {
+        got.append(buffer, ret);
+    }
+    ASSERT_PRED_FORMAT2(AssertGfalSuccess, ret, error);
+
+    EXPECT_EQ(expected, got);
+    EXPECT_GT(fake_eagain_count, 0);
+    EXPECT_EQ(0, fake_retry_mismatches);
+
+    ret = gfal_sftp_close(&data, fd, &error);
+    EXPECT_PRED_FORMAT2(AssertGfalSuccess, ret, error);
+}
+
+
+TEST_F(SftpIoTest, DirectReadAfterPendingRead)
+{
+    const std::string expected = fake_file;
+    gfal_file_handle fd = open(O_RDONLY);
+    ASSERT_TRUE(fd != NULL);
+
+    GError *error = NULL;
+    std::string got;
+    // A small read leaves a read pending, the next one is bigger than the read-ahead
+    static char buffer[80000];
+    ssize_t ret = gfal_sftp_read(&data, fd, buffer, 100, &error);
+    ASSERT_PRED_FORMAT2(AssertGfalSuccess, ret, error);
+    got.append(buffer, ret);
+    while ((ret = gfal_sftp_read(&data, fd, buffer, sizeof(buffer), &error)) > 0) {
+        got.append(buffer, ret);
+    }
+    ASSERT_PRED_FORMAT2(AssertGfalSuccess, ret, error);
+
+    EXPECT_EQ(expected, got);
+    EXPECT_EQ(0, fake_retry_mismatches);
+
+    ret = gfal_sftp_close(&data, fd, &error);
+    EXPECT_PRED_FORMAT2(AssertGfalSuccess, ret, error);
+}
+
+
+TEST_F(SftpIoTest, SeekWithPendingRead)
+{
+    gfal_file_handle fd = open(O_RDONLY);
+    ASSERT_TRUE(fd != NULL);
+
+    GError *error = NULL;
+    char buffer[1000];
+    ssize_t ret = gfal_sftp_read(&data, fd, buffer, sizeof(buffer), &error);
+    ASSERT_PRED_FORMAT2(AssertGfalSuccess, ret, error);
+
+    off_t off = gfal_sftp_seek(&data, fd, 123456, SEEK_SET, &error);
+    ASSERT_PRED_FORMAT2(AssertGfalSuccess, off, error);
+    ASSERT_EQ(123456, off);
+
+    ret = gfal_sftp_read(&data, fd, buffer, sizeof(buffer), &error);
+    ASSERT_PRED_FORMAT2(AssertGfalSuccess, ret, error);
+    ASSERT_EQ(sizeof(buffer), (size_t)ret);
+    EXPECT_EQ(fake_file.substr(123456, sizeof(buffer)), std::string(buffer, ret));
+    EXPECT_EQ(0, fake_retry_mismatches);
+
+    ret = gfal_sftp_close(&data, fd, &error);
+    EXPECT_PRED_FORMAT2(AssertGfalSuccess, ret, error);
+}
+
+
+TEST_F(SftpIoTest, WriteBehindErrorOnNextWrite)
+{
+    gfal_file_handle fd = open(O_WRONLY | O_CREAT | O_TRUNC);
+    ASSERT_TRUE(fd != NULL);
+
+    GError *error = NULL;
+    char buffer[100] = {0};
+    ssize_t ret = gfal_sftp_write(&data, fd, buffer, sizeof(buffer), &error);
+    ASSERT_PRED_FORMAT2(AssertGfalSuccess, ret, error);
+
+    // The buffered data is sent, and fails, on the seek
+    fake_fail_writes = true;
+    off_t off = gfal_sftp_seek(&data, fd, 0, SEEK_CUR, &error);
+    EXPECT_PRED_FORMAT3(AssertGfalErrno, off, error, EIO);
+    g_clear_error(&error);
+
+    // The writer hears about it too, once
+    ret = gfal_sftp_write(&data, fd, buffer, sizeof(buffer), &error);
+    EXPECT_PRED_FORMAT3(AssertGfalErrno, ret, error, EIO);
+    g_clear_error(&error);
+
+    fake_fail_writes = false;
+    ret = gfal_sftp_write(&data, fd, buffer, sizeof(buffer), &error);
+    EXPECT_PRED_FORMAT2(AssertGfalSuccess, ret, error);
+
+    ret = gfal_sftp_close(&data, fd, &error);
+    EXPECT_PRED_FORMAT2(AssertGfalSuccess, ret, error);
+}
+
+
+TEST_F(SftpIoTest, WriteBehindErrorOnClose)
+{
+    gfal_file_handle fd = open(O_RDWR | O_CREAT | O_TRUNC);
+    ASSERT_TRUE(fd != NULL);
+
+    GError *error = NULL;
+    char buffer[100] = {0};
+    ssize_t ret = gfal_sftp_write(&data, fd, buffer, sizeof(buffer), &error);
+    ASSERT_PRED_FORMAT2(AssertGfalSuccess, ret, error);
+
+    // The buffered data is sent, and fails, on the read
+    fake_fail_writes = true;
+    ret = gfal_sftp_read(&data, fd, buffer, sizeof(buffer), &error);
+    EXPECT_PRED_FORMAT3(AssertGfalErrno, ret, error, EIO);
+    g_clear_error(&error);
+
+    fake_fail_writes = false;
+    ret = gfal_sftp_close(&data, fd, &error);
+    EXPECT_PRED_FORMAT3(AssertGfalErrno, ret, error, EIO);
+    g_clear_error(&error);
+}
+
+
+TEST_F(SftpIoTest, StripingIsOptIn)
+{
+    static char buffer[150000];
+    GError *error = NULL;
+
+    gfal_file_handle fd = open(O_RDONLY);
+    ASSERT_TRUE(fd != NULL);
+    ssize_t ret = gfal_sftp_read(&data, fd, buffer, sizeof(buffer), &error);
+    ASSERT_PRED_FORMAT2(AssertGfalSuccess, ret, error);
+    EXPECT_EQ(sizeof(buffer), (size_t)ret);
+    EXPECT_EQ(0, fake_connect_attempts);
+    ret = gfal_sftp_close(&data, fd, &error);
+    EXPECT_PRED_FORMAT2(AssertGfalSuccess, ret, error);
+
+    // When asked for, the additional sessions are tried, and the read falls back to the main one
+    gfal2_set_opt_integer(data.gfal2_context, "SFTP PLUGIN", "STRIPE_SESSIONS", 3, NULL);
+    fd = open(O_RDONLY);
+    ASSERT_TRUE(fd != NULL);
+    ret = gfal_sftp_read(&data, fd, buffer, sizeof(buffer), &error);
+    ASSERT_PRED_FORMAT2(AssertGfalSuccess, ret, error);
+    EXPECT_EQ(fake_file.substr(0, sizeof(buffer)), std::string(buffer, ret));
+    EXPECT_EQ(1, fake_connect_attempts);
+    ret = gfal_sftp_close(&data, fd, &error);
+    EXPECT_PRED_FORMAT2(AssertGfalSuccess, ret, error);
+}
@@ -0,0 +1,292 @@
+/*
+ * Copyright (c) CERN 2016
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gfal_api.h>
+#include <gtest/gtest.h>
+#include <common/gfal_gtest_asserts.h>
+#include <utils/exceptions/gerror_to_cpp.h>
+#include <atomic>
+#include <unistd.h>
+
+extern "C" {
+#include "plugins/sftp/gfal_sftp_plugin.h"
+#include "plugins/sftp/gfal_sftp_connection.h"
+}
+
+// The session pool is tested with fake handles, which only count how they are used,
+// and a clock that only moves when the test says so.
+
+static std::atomic<gint64> fake_now(0);
+static std::atomic<int> fake_opened(0);
+static std::atomic<int> fake_closed(0);
+static std::atomic<int> fake_keepalives(0);
+static std::atomic<bool> fake_alive(true);
+
+
+gfal_sftp_handle_t *gfal_sftp_new_handle(gfal_sftp_context_t *context, gfal2_uri *parsed, GError **err)
+{
+    gfal_sftp_handle_t *handle = g_new0(gfal_sftp_handle_t, 1);
+    handle->host = g_strdup(parsed->host);
+    handle->port = parsed->port;
+    ++fake_opened;
+    return handle;
+}
+
+
+void gfal_sftp_destroy_handle(gfal_sftp_handle_t *handle)
+{
+    ++fake_closed;
+    g_free((char*)handle->host);
+    g_free((char*)handle->path);
+    g_free(handle);
+}
+
+
+gboolean gfal_sftp_handle_alive(gfal_sftp_handle_t *handle)
+{
+    ++fake_keepalives;
+    return fake_alive;
+}
+
+
+gint64 gfal_sftp_monotonic_time(void)
+{
+    return fake_now;
+}
+
+
+const char *gfal_sftp_plugin_get_name()
+{
+    return "FakeSFTP";
+}
+
+
+// Wait for the maintenance thread to get a counter to the expected value
+static int wait_for(std::atomic<int> &counter, int expected)
+{
+    for (int i = 0; i < 1000 && counter != expected; ++i) {
+        usleep(10000);
+    }
+    return counter;
+}
+
+
+class SftpPoolTest: public testing::Test {
+public:
+    SftpPoolTest() {
+        GError *error = NULL;
+        data.gfal2_context = gfal2_context_new(&error);
+        Gfal::gerror_to_cpp(&error);
+        data.cache = NULL;
+        gfal2_set_opt_integer(data.gfal2_context, "SFTP PLUGIN", "MAX_SESSIONS_PER_HOST", 2, NULL);
+        gfal2_set_opt_integer(data.gfal2_context, "SFTP PLUGIN", "IDLE_TIMEOUT", 60, NULL);
+        gfal2_set_opt_integer(data.gfal2_context, "SFTP PLUGIN", "KEEPALIVE_INTERVAL", 10, NULL);
+        gfal2_set_opt_integer(data.gfal2_context, "SFTP PLUGIN", "PREWARM_SESSIONS", 0, NULL);
+    }
+
+    virtual ~SftpPoolTest() {
+        if (data.cache) {
+            gfal_sftp_cache_destroy(data.cache);
+        }
+        gfal2_context_free(data.gfal2_context);
+    }
+
+    virtual void SetUp() {
+        fake_now = 1000 * G_USEC_PER_SEC;
+        fake_opened = 0;
+        fake_closed = 0;
+        fake_keepalives = 0;
+        fake_alive = true;
+    }
+
+protected:
+    gfal_sftp_context_t data;
+
+    gfal_sftp_handle_t *connect(const char *url) {
+        GError *error = NULL;
+        gfal_sftp_handle_t *handle = gfal_sftp_connect(&data, url, &error);
+        EXPECT_PRED_FORMAT2(AssertGfalSuccess, handle != NULL ? 0 : -1, error);
+        return handle;
+    }
+
+    void advance(int seconds) {
+        fake_now += seconds * G_USEC_PER_SEC;
+    }
+};
+
+
+TEST_F(SftpPoolTest, PerHostLimit)
+{
+    data.cache = gfal_sftp_cache_new_manual(&data);
+
+    gfal_sftp_handle_t *first = connect("sftp://limit.cern.ch/file");
+    gfal_sftp_handle_t *second = connect("sftp://limit.cern.ch/file");
+    ASSERT_TRUE(first != NULL && second != NULL);
+
+    GError *error = NULL;
+    gfal_sftp_handle_t *third = gfal_sftp_try_connect(&data, "sftp://limit.cern.ch/file", &error);
+    EXPECT_PRED_FORMAT3(AssertGfalErrno, third != NULL ? 0 : -1, error, EBUSY);
+    g_clear_error(&error);
+
+    // Other hosts are not affected
+    gfal_sftp_handle_t *other = connect("sftp://other.cern.ch/file");
+    ASSERT_TRUE(other != NULL);
+    gfal_sftp_release(&data, other);
+
+    // A released handle is given to the next caller
+    gfal_sftp_release(&data, first);
+    third = gfal_sftp_try_connect(&data, "sftp://limit.cern.ch/file", &error);
+    ASSERT_PRED_FORMAT2(AssertGfalSuccess, third != NULL ? 0 : -1, error);
+    EXPECT_EQ(first, third);
+    EXPECT_EQ(3, fake_opened);
+
+    gfal_sftp_release(&data, second);
+    gfal_sftp_release(&data, third);
+}
+
+
+TEST_F(SftpPoolTest, IdleEviction)
+{
+    gfal2_set_opt_integer(data.gfal2_context, "SFTP PLUGIN", "KEEPALIVE_INTERVAL", 0, NULL);
+    data.cache = gfal_sftp_cache_new_manual(&data);
+
+    gfal_sftp_handle_t *handle = connect("sftp://idle.cern.ch/file");
+    ASSERT_TRUE(handle != NULL);
+    gfal_sftp_release(&data, handle);
+
+    advance(59);
+    gfal_sftp_cache_maintenance(data.cache);
+    EXPECT_EQ(0, fake_closed);
+
+    advance(1);
+    gfal_sftp_cache_maintenance(data.cache);
+    EXPECT_EQ(1, fake_closed);
+    EXPECT_EQ(0, fake_keepalives);
+
+    handle = connect("sftp://idle.cern.ch/file");
+    ASSERT_TRUE(handle != NULL);
+    EXPECT_EQ(2, fake_opened);
+    gfal_sftp_release(&data, handle);
+}
+
+
+TEST_F(SftpPoolTest, Keepalive)
+{
+    data.cache = gfal_sftp_cache_new_manual(&data);
+
+    gfal_sftp_handle_t *handle = connect("sftp://keepalive.cern.ch/file");
+    ASSERT_TRUE(handle != NULL);
+    gfal_sftp_release(&data, handle);
+
+    advance(5);
+    gfal_sftp_cache_maintenance(data.cache);
+    EXPECT_EQ(0, fake_keepalives);
+
+    advance(5);
+    gfal_sftp_cache_maintenance(data.cache);
+    EXPECT_EQ(1, fake_keepalives);
+    EXPECT_EQ(0, fake_closed);
+
+    // The keepalive does not reset the idle time
+    advance(50);
+    gfal_sftp_cache_maintenance(data.cache);
+    EXPECT_EQ(1, fake_closed);
+
+    handle = connect("sftp://keepalive.cern.ch/file");
+    ASSERT_TRUE(handle != NULL);
+    gfal_sftp_release(&data, handle);
+
+    // A dead handle is closed on its next keepalive
+    fake_alive = false;
+    advance(10);
+    gfal_sftp_cache_maintenance(data.cache);
+    EXPECT_EQ(2, fake_keepalives);
+    EXPECT_EQ(2, fake_closed);
+
+    handle = connect("sftp://keepalive.cern.ch/file");
+    ASSERT_TRUE(handle != NULL);
+    EXPECT_EQ(3, fake_opened);
+    gfal_sftp_release(&data, handle);
+}
+
+
+TEST_F(SftpPoolTest, Prewarm)
+{
+    gfal2_set_opt_integer(data.gfal2_context, "SFTP PLUGIN", "MAX_SESSIONS_PER_HOST", 4, NULL);
+    gfal2_set_opt_integer(data.gfal2_context, "SFTP PLUGIN", "PREWARM_SESSIONS", 2, NULL);
+    gfal2_set_opt_integer(data.gfal2_context, "SFTP PLUGIN", "PREWARM_WINDOW", 60, NULL);
+    data.cache = gfal_sftp_cache_new_manual(&data);
+
+    gfal_sftp_handle_t *first = connect("sftp://prewarm.cern.ch/file");
+    ASSERT_TRUE(first != NULL);
+    EXPECT_EQ(1, fake_opened);
+    gfal_sftp_cache_maintenance(data.cache);
+    EXPECT_EQ(3, fake_opened);
+
+    // Callers take the sessions opened in advance
+    gfal_sftp_handle_t *second = connect("sftp://prewarm.cern.ch/file");
+    gfal_sftp_handle_t *third = connect("sftp://prewarm.cern.ch/file");
+    ASSERT_TRUE(second != NULL && third != NULL);
+    EXPECT_EQ(3, fake_opened);
+
+    // Never above the limit of the host
+    gfal_sftp_cache_maintenance(data.cache);
+    EXPECT_EQ(4, fake_opened);
+    gfal_sftp_cache_maintenance(data.cache);
+    EXPECT_EQ(4, fake_opened);
+
+    gfal_sftp_release(&data, first);
+    gfal_sftp_release(&data, second);
+    gfal_sftp_release(&data, third);
+
+    // Not for hosts unused for longer than the window
+    advance(61);
+    gfal_sftp_cache_maintenance(data.cache);
+    EXPECT_EQ(4, fake_opened);
+    EXPECT_EQ(4, fake_closed);
+}
+
+
+TEST_F(SftpPoolTest, PrewarmInBackground)
+{
+    gfal2_set_opt_integer(data.gfal2_context, "SFTP PLUGIN", "MAX_SESSIONS_PER_HOST", 4, NULL);
+    gfal2_set_opt_integer(data.gfal2_context, "SFTP PLUGIN", "PREWARM_SESSIONS", 2, NULL);
+    data.cache = gfal_sftp_cache_new(&data);
+
+    gfal_sftp_handle_t *handle = connect("sftp://background.cern.ch/file");
+    ASSERT_TRUE(handle != NULL);
+    EXPECT_EQ(3, wait_for(fake_opened, 3));
+    gfal_sftp_release(&data, handle);
+}
+
+
+TEST_F(SftpPoolTest, DestroyWithHandleInUse)
+{
+    data.cache = gfal_sftp_cache_new(&data);
+
+    gfal_sftp_handle_t *in_use = connect("sftp://destroy.cern.ch/file");
+    gfal_sftp_handle_t *idle = connect("sftp://destroy.cern.ch/file");
+    ASSERT_TRUE(in_use != NULL && idle != NULL);
+    gfal_sftp_release(&data, idle);
+
+    // Does not wait for the handle in use, which is closed when released
+    gfal_sftp_cache_destroy(data.cache);
+    data.cache = NULL;
+    EXPECT_EQ(1, fake_closed);
+
+    gfal_sftp_release(NULL, in_use);
+    EXPECT_EQ(2, fake_closed);
+}
@@ -0,0 +1,123 @@
+/*
+ * Copyright (c) CERN 2013-2017
+ *
+ * Copyright (c) Members of the EMI Collaboration. 2010-2013
+ *  See  http://www.eu-emi.eu/partners for details on the copyright
+ *  holders.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <vector>
+
+#include <gfal_plugins_api.h>
+
+extern "C" {
+#include <gfal_srm.h>
+#include <gfal_srm_copy.h>
+}
+
+
+class SrmBulkGroupTest: public testing::Test {
+public:
+    std::vector<size_t> order, chunks;
+
+    size_t Group(const std::vector<const char*>& srcs, const std::vector<const char*>& dsts, size_t max_chunk) {
+        order.assign(srcs.size(), (size_t)-1);
+        chunks.assign(srcs.size(), 0);
+        size_t n_chunks = srm_bulk_group(srcs.size(), srcs.data(), dsts.data(), max_chunk,
+            order.data(), chunks.data());
+        chunks.resize(n_chunks);
+        return n_chunks;
+    }
+};
+
+
+TEST_F(SrmBulkGroupTest, SameEndpoints)
+{
+    std::vector<const char*> srcs = {
+        "srm://se-a.cern.ch:8446/path/1", "srm://se-a.cern.ch:8446/path/2", "srm://se-a.cern.ch:8446/path/3"
+    };
+    std::vector<const char*> dsts = {
+        "srm://se-b.cern.ch/path/1", "srm://se-b.cern.ch/path/2", "srm://se-b.cern.ch/path/3"
+    };
+
+    ASSERT_EQ(1u, Group(srcs, dsts, 100));
+    EXPECT_EQ(3u, chunks[0]);
+    EXPECT_EQ(std::vector<size_t>({0, 1, 2}), order);
+}
+
+// Files of the same endpoints are grouped even if they are not consecutive
+TEST_F(SrmBulkGroupTest, Interleaved)
+{
+    std::vector<const char*> srcs = {
+        "srm://se-a.cern.ch/1", "srm://se-c.cern.ch/2", "srm://se-a.cern.ch/3",
+        "srm://se-c.cern.ch/4", "srm://se-a.cern.ch/5"
+    };
+    std::vector<const char*> dsts = {
+        "srm://se-b.cern.ch/1", "srm://se-b.cern.ch/2", "srm://se-b.cern.ch/3",
+        "srm://se-b.cern.ch/4", "srm://se-b.cern.ch/5"
+    };
+
+    ASSERT_EQ(2u, Group(srcs, dsts, 100));
+    EXPECT_EQ(3u, chunks[0]);
+    EXPECT_EQ(2u, chunks[1]);
+    EXPECT_EQ(std::vector<size_t>({0, 2, 4, 1, 3}), order);
+}
+
+// Both the source and the destination endpoints define the group
+TEST_F(SrmBulkGroupTest, DestinationEndpoint)
+{
+    std::vector<const char*> srcs = {
+        "srm://se-a.cern.ch/1", "srm://se-a.cern.ch/2", "srm://se-a.cern.ch/3", "srm://se-a.cern.ch/4"
+    };
+    std::vector<const char*> dsts = {
+        "srm://se-b.cern.ch/1", "srm://se-b.cern.ch:8443/2", "srm://se-b.cern.ch/3", "gsiftp://se-b.cern.ch/4"
+    };
+
+    ASSERT_EQ(3u, Group(srcs, dsts, 100));
+    EXPECT_EQ(std::vector<size_t>({2, 1, 1}), chunks);
+    EXPECT_EQ(std::vector<size_t>({0, 2, 1, 3}), order);
+}
+
+// Groups larger than the maximum are split, keeping the submission order
+TEST_F(SrmBulkGroupTest, Chunks)
+{
+    std::vector<const char*> srcs, dsts;
+    for (int i = 0; i < 7; ++i) {
+        srcs.push_back((i % 2) ? "srm://se-c.cern.ch/file" : "srm://se-a.cern.ch/file");
+        dsts.push_back("srm://se-b.cern.ch/file");
+    }
+
+    ASSERT_EQ(4u, Group(srcs, dsts, 2));
+    EXPECT_EQ(std::vector<size_t>({2, 2, 2, 1}), chunks);
+    EXPECT_EQ(std::vector<size_t>({0, 2, 4, 6, 1, 3, 5}), order);
+}
+
+// Urls without an authority are copied one by one
+TEST_F(SrmBulkGroupTest, NoAuthority)
+{
+    std::vector<const char*> srcs = {"/tmp/a", "/tmp/b", "srm://se-a.cern.ch/c"};
+    std::vector<const char*> dsts = {"srm://se-b.cern.ch/a", "srm://se-b.cern.ch/b", "srm://se-b.cern.ch/c"};
+
+    ASSERT_EQ(3u, Group(srcs, dsts, 100));
+    EXPECT_EQ(std::vector<size_t>({1, 1, 1}), chunks);
+    EXPECT_EQ(std::vector<size_t>({0, 1, 2}), order);
+}
+
+TEST_F(SrmBulkGroupTest, Empty)
+{
+    std::vector<const char*> srcs, dsts;
+    EXPECT_EQ(0u, Group(srcs, dsts, 100));
+}
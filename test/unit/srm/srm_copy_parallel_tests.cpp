@@ -0,0 +1,348 @@
+/*
+ * Copyright (c) CERN 2017
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <common/gfal_gtest_asserts.h>
+#include <transfer/gfal_transfer.h>
+#include <errno.h>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <gfal_plugins_api.h>
+
+extern "C" {
+#include <gfal_srm.h>
+#include <gfal_srm_copy.h>
+#include <gfal_srm_internal_layer.h>
+
+// The plugin is a module, so it is built into the test
+gfal_plugin_interface gfal_plugin_init(gfal2_context_t handle, GError **err);
+}
+
+static const char* source_surl = "srm://se-src.example.com:8446/srm/managerv2?SFN=/data/file";
+static const char* dest_surl = "srm://se-dst.example.com:8446/srm/managerv2?SFN=/data/file";
+
+// srm-ifce replies, and the calls it got from both sides of the copy
+static struct {
+    std::mutex lock;
+    off_t source_size;
+    const char* source_checksum;
+    int get_status, put_status;
+    std::vector<std::string> calls;
+} srm_mock;
+
+
+// srm-ifce gets the decoded surls, so the calls are recorded by side of the copy
+static std::string srm_mock_side(const char *surl)
+{
+    return strstr(surl, "se-src") ? "source" : "destination";
+}
+
+
+static void srm_mock_record(const std::string& call)
+{
+    std::lock_guard<std::mutex> guard(srm_mock.lock);
+    srm_mock.calls.push_back(call);
+}
+
+
+static int srm_mock_ls(struct srm_context *context, struct srm_ls_input *input,
+    struct srm_ls_output *output)
+{
+    srm_mock_record("LS " + srm_mock_side(input->surls[0]));
+    memset(output, 0, sizeof(*output));
+    output->statuses = (struct srmv2_mdfilestatus*) calloc(1, sizeof(struct srmv2_mdfilestatus));
+    output->statuses->surl = strdup(input->surls[0]);
+    output->statuses->stat.st_mode = S_IFREG | 0644;
+    output->statuses->stat.st_size = srm_mock.source_size;
+    output->statuses->checksumtype = strdup("ADLER32");
+    output->statuses->checksum = strdup(srm_mock.source_checksum);
+    return 1;
+}
+
+
+static void srm_mock_prepare(const char *surl, int status, const char *turl, const char *token,
+    char **out_token, struct srmv2_pinfilestatus **out_statuses)
+{
+    *out_token = strdup(token);
+    *out_statuses = (struct srmv2_pinfilestatus*) calloc(1, sizeof(struct srmv2_pinfilestatus));
+    (*out_statuses)->surl = strdup(surl);
+    (*out_statuses)->status = status;
+    if (status == 0)
+        (*out_statuses)->turl = strdup(turl);
+    else
+        (*out_statuses)->explanation = strdup(strerror(status));
+}
+
+
+static int srm_mock_prepare_to_get(struct srm_context *context, struct srm_preparetoget_input *input,
+    struct srm_preparetoget_output *output)
+{
+    srm_mock_record("GET " + srm_mock_side(input->surls[0]));
+    memset(output, 0, sizeof(*output));
+    srm_mock_prepare(input->surls[0], srm_mock.get_status, "gsiftp://se-src.example.com/data/file",
+        "get-token", &output->token, &output->filestatuses);
+    return 1;
+}
+
+
+static int srm_mock_prepare_to_put(struct srm_context *context, struct srm_preparetoput_input *input,
+    struct srm_preparetoput_output *output)
+{
+    srm_mock_record("PUT " + srm_mock_side(input->surls[0]) + " " + std::to_string(input->filesizes[0]));
+    memset(output, 0, sizeof(*output));
+    srm_mock_prepare(input->surls[0], srm_mock.put_status, "gsiftp://se-dst.example.com/data/file",
+        "put-token", &output->token, &output->filestatuses);
+    return 1;
+}
+
+
+static int srm_mock_abort_request(struct srm_context *context, char *reqtoken)
+{
+    srm_mock_record(std::string("ABORT ") + reqtoken);
+    return 0;
+}
+
+
+static int srm_mock_release_files(struct srm_context *context, struct srm_releasefiles_input *input,
+    struct srmv2_filestatus **statuses)
+{
+    srm_mock_record(std::string("RELEASE ") + input->reqtoken);
+    *statuses = (struct srmv2_filestatus*) calloc(input->nbfiles, sizeof(struct srmv2_filestatus));
+    return input->nbfiles;
+}
+
+
+static int srm_mock_rm(struct srm_context *context, struct srm_rm_input *input,
+    struct srm_rm_output *output)
+{
+    srm_mock_record("RM " + srm_mock_side(input->surls[0]));
+    memset(output, 0, sizeof(*output));
+    output->statuses = (struct srmv2_filestatus*) calloc(input->nbfiles, sizeof(struct srmv2_filestatus));
+    return input->nbfiles;
+}
+
+
+static int srm_mock_xping(struct srm_context *context, struct srm_xping_output *output)
+{
+    memset(output, 0, sizeof(*output));
+    return 0;
+}
+
+
+static void srm_mock_filestatus_delete(struct srmv2_filestatus *statuses, int n)
+{
+    for (int i = 0; statuses && i < n; ++i) {
+        free(statuses[i].surl);
+        free(statuses[i].turl);
+        free(statuses[i].explanation);
+    }
+    free(statuses);
+}
+
+
+static void srm_mock_pinfilestatus_delete(struct srmv2_pinfilestatus *statuses, int n)
+{
+    for (int i = 0; statuses && i < n; ++i) {
+        free(statuses[i].surl);
+        free(statuses[i].turl);
+        free(statuses[i].explanation);
+    }
+    free(statuses);
+}
+
+
+static void srm_mock_mdfilestatus_delete(struct srmv2_mdfilestatus *statuses, int n)
+{
+    for (int i = 0; statuses && i < n; ++i) {
+        free(statuses[i].surl);
+        free(statuses[i].explanation);
+        free(statuses[i].checksumtype);
+        free(statuses[i].checksum);
+    }
+    free(statuses);
+}
+
+
+static void srm_mock_returnstatus_delete(struct srm2__TReturnStatus *status)
+{
+}
+
+
+class SrmCopyParallelTest: public testing::Test {
+public:
+    gfal2_context_t context;
+    gfalt_params_t params;
+    gfal_plugin_interface srm_plugin;
+    struct _gfal_srm_external_call saved_external_call;
+
+    void SetUp() {
+        GError* error = NULL;
+        memset(&srm_plugin, 0, sizeof(srm_plugin));
+        saved_external_call = gfal_srm_external_call;
+        context = gfal2_context_new(&error);
+        ASSERT_PRED_FORMAT2(AssertGfalSuccess, context ? 0 : -1, error);
+
+        const char* protocols[] = {"gsiftp"};
+        gfal2_set_opt_string_list(context, "SRM PLUGIN", "TURL_3RD_PARTY_PROTOCOLS", protocols, 1, NULL);
+        gfal2_set_opt_string(context, "SRM PLUGIN", "COPY_CHECKSUM_TYPE", "ADLER32", NULL);
+        gfal2_set_opt_boolean(context, "SRM PLUGIN", "COPY_PARALLEL_PREPARE", TRUE, NULL);
+        gfal2_set_opt_boolean(context, "SRM PLUGIN", "COPY_FAIL_NEARLINE", FALSE, NULL);
+
+        params = gfalt_params_handle_new(NULL);
+        srm_plugin = gfal_plugin_init(context, &error);
+        ASSERT_PRED_FORMAT2(AssertGfalSuccess, 0, error);
+
+        srm_mock.source_size = 1024;
+        srm_mock.source_checksum = "0a0b0c0d";
+        srm_mock.get_status = 0;
+        srm_mock.put_status = 0;
+        srm_mock.calls.clear();
+
+        gfal_srm_external_call.srm_ls = srm_mock_ls;
+        gfal_srm_external_call.srm_rm = srm_mock_rm;
+        gfal_srm_external_call.srm_prepare_to_get = srm_mock_prepare_to_get;
+        gfal_srm_external_call.srm_prepare_to_put = srm_mock_prepare_to_put;
+        gfal_srm_external_call.srm_abort_request = srm_mock_abort_request;
+        gfal_srm_external_call.srm_release_files = srm_mock_release_files;
+        gfal_srm_external_call.srm_xping = srm_mock_xping;
+        gfal_srm_external_call.srm_srmv2_filestatus_delete = srm_mock_filestatus_delete;
+        gfal_srm_external_call.srm_srmv2_pinfilestatus_delete = srm_mock_pinfilestatus_delete;
+        gfal_srm_external_call.srm_srmv2_mdfilestatus_delete = srm_mock_mdfilestatus_delete;
+        gfal_srm_external_call.srm_srm2__TReturnStatus_delete = srm_mock_returnstatus_delete;
+    }
+
+    void TearDown() {
+        gfal_srm_external_call = saved_external_call;
+        if (srm_plugin.plugin_delete)
+            srm_plugin.plugin_delete(srm_plugin.plugin_data);
+        gfalt_params_handle_delete(params, NULL);
+        gfal2_context_free(context);
+    }
+
+    int Copy(GError** error) {
+        return srm_plugin_filecopy(srm_plugin.plugin_data, context, params, source_surl, dest_surl, error);
+    }
+
+    bool Called(const std::string& call) {
+        return std::find(srm_mock.calls.begin(), srm_mock.calls.end(), call) != srm_mock.calls.end();
+    }
+
+    bool CalledWithPrefix(const std::string& prefix) {
+        for (auto i = srm_mock.calls.begin(); i != srm_mock.calls.end(); ++i) {
+            if (i->compare(0, prefix.size(), prefix) == 0)
+                return true;
+        }
+        return false;
+    }
+};
+
+
+// The destination got its turl, so its PUT is aborted and the file removed
+TEST_F(SrmCopyParallelTest, SourceGetFails)
+{
+    GError* error = NULL;
+    srm_mock.get_status = EACCES;
+
+    int ret = Copy(&error);
+    ASSERT_PRED_FORMAT3(AssertGfalErrno, ret, error, EACCES);
+    g_clear_error(&error);
+
+    ASSERT_TRUE(Called("GET source"));
+    // The size of the source, stat'ed on the other side, is still given to the PUT
+    ASSERT_TRUE(Called("PUT destination 1024"));
+    ASSERT_TRUE(Called("ABORT put-token"));
+    ASSERT_TRUE(Called("RM destination"));
+    ASSERT_FALSE(CalledWithPrefix("RELEASE"));
+}
+
+
+// The source got its turl, so it is released, and there is nothing to abort on the destination
+TEST_F(SrmCopyParallelTest, DestinationPutFails)
+{
+    GError* error = NULL;
+    srm_mock.put_status = ENOSPC;
+
+    int ret = Copy(&error);
+    ASSERT_PRED_FORMAT3(AssertGfalErrno, ret, error, ENOSPC);
+    g_clear_error(&error);
+
+    ASSERT_TRUE(Called("GET source"));
+    ASSERT_TRUE(Called("PUT destination 1024"));
+    ASSERT_TRUE(Called("RELEASE get-token"));
+    ASSERT_FALSE(CalledWithPrefix("ABORT"));
+    ASSERT_FALSE(CalledWithPrefix("RM"));
+}
+
+
+// Both sides fail, the error of the source is the one reported, and nothing is left to roll back
+TEST_F(SrmCopyParallelTest, BothFail)
+{
+    GError* error = NULL;
+    srm_mock.get_status = ENOENT;
+    srm_mock.put_status = ENOSPC;
+
+    int ret = Copy(&error);
+    ASSERT_PRED_FORMAT3(AssertGfalErrno, ret, error, ENOENT);
+    g_clear_error(&error);
+
+    ASSERT_FALSE(CalledWithPrefix("ABORT"));
+    ASSERT_FALSE(CalledWithPrefix("RELEASE"));
+    ASSERT_FALSE(CalledWithPrefix("RM"));
+}
+
+
+// The destination side is stopped before touching the existing file, or issuing the PUT
+TEST_F(SrmCopyParallelTest, InvalidSource)
+{
+    GError* error = NULL;
+    gfalt_set_replace_existing_file(params, TRUE, NULL);
+    gfalt_set_checksum(params, GFALT_CHECKSUM_SOURCE, "ADLER32", "ffffffff", NULL);
+
+    int ret = Copy(&error);
+    ASSERT_PRED_FORMAT3(AssertGfalErrno, ret, error, EIO);
+    g_clear_error(&error);
+
+    ASSERT_FALSE(CalledWithPrefix("GET"));
+    ASSERT_FALSE(CalledWithPrefix("PUT"));
+    ASSERT_FALSE(CalledWithPrefix("RM"));
+    ASSERT_FALSE(CalledWithPrefix("ABORT"));
+}
+
+
+// Same scenario with a valid source, the existing destination is replaced before the PUT
+TEST_F(SrmCopyParallelTest, ReplaceBeforePut)
+{
+    GError* error = NULL;
+    gfalt_set_replace_existing_file(params, TRUE, NULL);
+    gfalt_set_checksum(params, GFALT_CHECKSUM_SOURCE, "ADLER32", "0a0b0c0d", NULL);
+    srm_mock.get_status = EACCES;
+
+    int ret = Copy(&error);
+    ASSERT_PRED_FORMAT3(AssertGfalErrno, ret, error, EACCES);
+    g_clear_error(&error);
+
+    auto first_rm = std::find(srm_mock.calls.begin(), srm_mock.calls.end(), "RM destination");
+    auto put_call = std::find(srm_mock.calls.begin(), srm_mock.calls.end(), "PUT destination 1024");
+    ASSERT_TRUE(first_rm != srm_mock.calls.end());
+    ASSERT_TRUE(put_call != srm_mock.calls.end());
+    ASSERT_TRUE(first_rm < put_call);
+    ASSERT_TRUE(Called("ABORT put-token"));
+}
@@ -0,0 +1,212 @@
+/*
+ * Copyright (c) CERN 2013-2017
+ *
+ * Copyright (c) Members of the EMI Collaboration. 2010-2013
+ *  See  http://www.eu-emi.eu/partners for details on the copyright
+ *  holders.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <gfal_api.h>
+#include <gfal_plugins_api.h>
+#include <gtest/gtest.h>
+#include <core/common/gfal_trace_internal.h>
+#include <common/gfal_fake_plugin.h>
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <map>
+#include <string>
+#include <vector>
+
+
+struct TraceContent {
+    gfal_trace_header_t header;
+    std::map<guint32, std::string> hosts;
+    std::map<guint32, std::string> operations;
+    std::vector<gfal_trace_record_t> records;
+};
+
+
+static bool load_trace(const char *path, TraceContent &content)
+{
+    FILE *fd = fopen(path, "rb");
+    if (!fd)
+        return false;
+
+    bool ok = (fread(&content.header, sizeof(content.header), 1, fd) == 1);
+    guint8 type;
+    while (ok && fread(&type, sizeof(type), 1, fd) == 1) {
+        if (type == GFAL_TRACE_ENTRY_RECORD) {
+            gfal_trace_record_t record;
+            ok = (fread(&record, sizeof(record), 1, fd) == 1);
+            content.records.push_back(record);
+        }
+        else {
+            guint32 id;
+            guint16 length;
+            ok = (fread(&id, sizeof(id), 1, fd) == 1) && (fread(&length, sizeof(length), 1, fd) == 1);
+            std::string str(length, '\0');
+            ok = ok && (fread(&str[0], 1, length, fd) == length);
+            if (type == GFAL_TRACE_ENTRY_HOST)
+                content.hosts[id] = str;
+            else
+                content.operations[id] = str;
+        }
+    }
+    fclose(fd);
+    return ok;
+}
+
+
+class TraceTest: public testing::Test {
+public:
+    gfal2_context_t context;
+    char trace_path[64];
+
+    void SetUp() {
+        GError *tmp_err = NULL;
+        context = gfal2_context_new(&tmp_err);
+        ASSERT_TRUE(context != NULL);
+
+        gfal_plugin_interface plugin;
+        gfal_fake_plugin_interface(&plugin);
+        ASSERT_EQ(0, gfal2_register_plugin(context, &plugin, &tmp_err));
+
+        g_strlcpy(trace_path, "/tmp/gfal2_trace_XXXXXX", sizeof(trace_path));
+        int fd = mkstemp(trace_path);
+        ASSERT_GE(fd, 0);
+        close(fd);
+    }
+
+    void TearDown() {
+        gfal2_trace_stop();
+        gfal2_context_free(context);
+        unlink(trace_path);
+    }
+};
+
+
+TEST_F(TraceTest, testRecord)
+{
+    struct stat st;
+    GError *tmp_err = NULL;
+
+    ASSERT_EQ(0, gfal2_trace_start(trace_path, &tmp_err));
+    ASSERT_TRUE(gfal2_trace_is_enabled());
+
+    ASSERT_EQ(0, gfal2_stat(context, "fake://user@host-a:1094/path?query=1", &st, &tmp_err));
+    ASSERT_EQ(-1, gfal2_stat(context, "fake://host-b/missing", &st, &tmp_err));
+    g_clear_error(&tmp_err);
+
+    gfal2_trace_stop();
+    ASSERT_FALSE(gfal2_trace_is_enabled());
+
+    TraceContent content;
+    ASSERT_TRUE(load_trace(trace_path, content));
+
+    EXPECT_EQ(0, memcmp(content.header.magic, GFAL_TRACE_MAGIC, sizeof(content.header.magic)));
+    EXPECT_EQ(GFAL_TRACE_VERSION, content.header.version);
+    EXPECT_EQ(sizeof(gfal_trace_record_t), content.header.record_size);
+
+    ASSERT_EQ(2u, content.records.size());
+
+    const gfal_trace_record_t &first = content.records[0];
+    EXPECT_EQ("stat", content.operations[first.operation]);
+    EXPECT_EQ("fake://host-a:1094", content.hosts[first.host]);
+    EXPECT_EQ(0, first.errcode);
+    EXPECT_EQ(gfal_trace_path_hash("fake://host-c/path"), first.path_hash);
+
+    const gfal_trace_record_t &second = content.records[1];
+    EXPECT_EQ(first.operation, second.operation);
+    EXPECT_EQ("fake://host-b", content.hosts[second.host]);
+    EXPECT_EQ(ENOENT, second.errcode);
+    EXPECT_GE(second.start, first.start);
+    EXPECT_EQ(first.thread, second.thread);
+}
+
+
+TEST_F(TraceTest, testPreadOffset)
+{
+    GError *tmp_err = NULL;
+    char buffer[16];
+
+    ASSERT_EQ(0, gfal2_trace_start(trace_path, &tmp_err));
+    int fd = gfal2_open(context, "fake://host-a/file", O_RDONLY, &tmp_err);
+    ASSERT_GE(fd, 0);
+    ASSERT_EQ(16, gfal2_pread(context, fd, buffer, sizeof(buffer), 5000000000LL, &tmp_err));
+    ASSERT_EQ(0, gfal2_close(context, fd, &tmp_err));
+    gfal2_trace_stop();
+
+    TraceContent content;
+    ASSERT_TRUE(load_trace(trace_path, content));
+    ASSERT_EQ(3u, content.records.size());
+
+    EXPECT_EQ("open", content.operations[content.records[0].operation]);
+    EXPECT_EQ(0u, content.records[0].offset);
+    EXPECT_EQ("pread", content.operations[content.records[1].operation]);
+    EXPECT_EQ(16u, content.records[1].arg);
+    EXPECT_EQ(5000000000ULL, content.records[1].offset);
+}
+
+
+TEST_F(TraceTest, testManyHosts)
+{
+    struct stat st;
+    GError *tmp_err = NULL;
+    const int nhosts = 70000;
+
+    // More hosts than a 16 bits id can tell apart
+    ASSERT_EQ(0, gfal2_trace_start(trace_path, &tmp_err));
+    for (int i = 0; i < nhosts; ++i) {
+        std::string url = "fake://host-" + std::to_string(i) + "/path";
+        ASSERT_EQ(0, gfal2_stat(context, url.c_str(), &st, &tmp_err));
+    }
+    gfal2_trace_stop();
+
+    TraceContent content;
+    ASSERT_TRUE(load_trace(trace_path, content));
+    ASSERT_EQ((size_t)nhosts, content.records.size());
+    ASSERT_EQ((size_t)nhosts, content.hosts.size());
+    EXPECT_EQ("fake://host-69999", content.hosts[content.records[nhosts - 1].host]);
+    EXPECT_EQ((guint32)nhosts, content.records[nhosts - 1].host);
+}
+
+
+TEST_F(TraceTest, testNotRecording)
+{
+    struct stat st;
+    GError *tmp_err = NULL;
+
+    ASSERT_EQ(0, gfal2_trace_start(trace_path, &tmp_err));
+    gfal2_trace_stop();
+    ASSERT_EQ(0, gfal2_stat(context, "fake://host-a/path", &st, &tmp_err));
+
+    TraceContent content;
+    ASSERT_TRUE(load_trace(trace_path, content));
+    EXPECT_EQ(0u, content.records.size());
+}
+
+
+TEST_F(TraceTest, testInvalidPath)
+{
+    GError *tmp_err = NULL;
+    ASSERT_EQ(-1, gfal2_trace_start("/nonexistent/directory/trace", &tmp_err));
+    ASSERT_TRUE(tmp_err != NULL);
+    EXPECT_EQ(ENOENT, tmp_err->code);
+    g_clear_error(&tmp_err);
+    EXPECT_FALSE(gfal2_trace_is_enabled());
+}
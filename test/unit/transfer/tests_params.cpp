@@ -77,3 +77,22 @@ TEST(gfalTransfer, testlocaltransfer){
     ASSERT_TRUE( res == FALSE && ret == FALSE && tmp_err==NULL);
     gfalt_params_handle_delete(p,NULL);
 }
+
+TEST(gfalTransfer, testoffset){
+    GError * tmp_err=NULL;
+    gfalt_params_t p = gfalt_params_handle_new(&tmp_err);
+    ASSERT_TRUE( p != NULL && tmp_err==NULL);
+    ASSERT_EQ(0, gfalt_get_offset_from_source(p, &tmp_err));
+    ASSERT_TRUE(tmp_err==NULL);
+
+    gfalt_set_offset_from_source(p, 1024, &tmp_err);
+    ASSERT_EQ(1024, gfalt_get_offset_from_source(p, &tmp_err));
+    gfalt_set_offset_from_source(p, GFALT_OFFSET_FROM_DESTINATION, &tmp_err);
+    ASSERT_EQ(GFALT_OFFSET_FROM_DESTINATION, gfalt_get_offset_from_source(p, &tmp_err));
+
+    gfalt_params_t p2 = gfalt_params_handle_copy(p, &tmp_err);
+    ASSERT_EQ(GFALT_OFFSET_FROM_DESTINATION, gfalt_get_offset_from_source(p2, &tmp_err));
+    ASSERT_TRUE(tmp_err==NULL);
+    gfalt_params_handle_delete(p2,NULL);
+    gfalt_params_handle_delete(p,NULL);
+}
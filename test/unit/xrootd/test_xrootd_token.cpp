@@ -0,0 +1,65 @@
+/*
+ * Copyright (c) CERN 2017
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "plugins/xrootd/gfal_xrootd_plugin_utils.h"
+
+
+TEST(XrootdTokenTest, SingleEndpoint)
+{
+    std::string token = xrootd_compose_token({{"eosctapublic.cern.ch:1094", "a1b2-c3d4"}});
+    EXPECT_EQ("a1b2-c3d4", token);
+    EXPECT_EQ("a1b2-c3d4", xrootd_token_request_id(token, "eosctapublic.cern.ch:1094"));
+}
+
+
+TEST(XrootdTokenTest, MultipleEndpoints)
+{
+    std::string token = xrootd_compose_token({
+        {"eosctapublic.cern.ch:1094", "a1b2"},
+        {"eosctaatlas.cern.ch:1094", "c3d4"},
+        {"eosctacms.cern.ch:1095", "e5f6"},
+    });
+    EXPECT_EQ("eosctapublic.cern.ch:1094|a1b2,eosctaatlas.cern.ch:1094|c3d4,eosctacms.cern.ch:1095|e5f6", token);
+
+    EXPECT_EQ("a1b2", xrootd_token_request_id(token, "eosctapublic.cern.ch:1094"));
+    EXPECT_EQ("c3d4", xrootd_token_request_id(token, "eosctaatlas.cern.ch:1094"));
+    EXPECT_EQ("e5f6", xrootd_token_request_id(token, "eosctacms.cern.ch:1095"));
+    EXPECT_EQ("", xrootd_token_request_id(token, "eosctacms.cern.ch:1094"));
+    EXPECT_EQ("", xrootd_token_request_id(token, "eosctacms.cern.ch"));
+}
+
+
+TEST(XrootdTokenTest, FailedEndpointsLeftOut)
+{
+    std::string token = xrootd_compose_token({
+        {"eosctapublic.cern.ch:1094", ""},
+        {"eosctaatlas.cern.ch:1094", "c3d4"},
+    });
+    EXPECT_EQ("eosctaatlas.cern.ch:1094|c3d4", token);
+    EXPECT_EQ("c3d4", xrootd_token_request_id(token, "eosctaatlas.cern.ch:1094"));
+    EXPECT_EQ("", xrootd_token_request_id(token, "eosctapublic.cern.ch:1094"));
+}
+
+
+TEST(XrootdTokenTest, LegacyToken)
+{
+    // Tokens from single endpoint requests, and older versions, apply to every endpoint
+    EXPECT_EQ("a1b2-c3d4", xrootd_token_request_id("a1b2-c3d4", "eosctapublic.cern.ch:1094"));
+    EXPECT_EQ("a1b2-c3d4", xrootd_token_request_id("a1b2-c3d4", "eosctaatlas.cern.ch:1094"));
+    EXPECT_EQ("", xrootd_token_request_id("", "eosctapublic.cern.ch:1094"));
+}